@@ -15,6 +15,7 @@
 
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "iothub_client_ll.h"
 
 #ifdef __cplusplus
 #include <cstddef>
@@ -48,6 +49,20 @@ DEFINE_ENUM(BLOB_RESULT, BLOB_RESULT_VALUES)
 */
 MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadFromSasUri,const char*, SASURI, const unsigned char*, source, size_t, size, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse)
 
+/**
+* @brief	Synchronously uploads to blob storage a file that is read block by block through a callback
+*
+* @param	SASURI	        The URI to use to upload data
+* @param	source		    The size of the file, the callback reading it and the optional checkpoint of blocks already uploaded
+* @param    parallelism     How many blocks can be uploaded at the same time, each on its own connection (1 uploads them one after another)
+* @param    blockRetries    How many times the upload of a block is retried when the connection fails or storage answers 408, 429 or 5xx
+* @param    httpStatus      A pointer to an out argument receiving the HTTP status (available only when the return value is BLOB_OK)
+* @param    httpResponse    A BUFFER_HANDLE that receives the HTTP response from the server (available only when the return value is BLOB_OK)
+*
+* @return	A @c BLOB_RESULT. BLOB_OK means the blob has been uploaded successfully. Any other value indicates an error
+*/
+MOCKABLE_FUNCTION(, BLOB_RESULT, Blob_UploadMultipleBlocksFromSasUri, const char*, SASURI, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE*, source, size_t, parallelism, size_t, blockRetries, unsigned int*, httpStatus, BUFFER_HANDLE, httpResponse)
+
 #ifdef __cplusplus
 }
 #endif
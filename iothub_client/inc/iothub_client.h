@@ -116,6 +116,26 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_SendEventAsync, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
 
+    /**
+    * @brief	Asynchronous call to send the message specified by @p eventMessageHandle
+    * 			without making a copy of it. Upon success the client takes ownership of
+    * 			@p eventMessageHandle and destroys it when it is no longer needed; the
+    * 			caller shall not use the handle afterwards. If the call fails the caller
+    * 			keeps ownership of the message.
+    *
+    * @param	iotHubClientHandle		   	The handle created by a call to the create function.
+    * @param	eventMessageHandle		   	The handle to an IoT Hub message.
+    * @param	eventConfirmationCallback  	The callback specified by the device for receiving
+    * 										confirmation of the delivery of the IoT Hub message.
+    * 										The user can specify a @c NULL value here to
+    * 										indicate that no callback is required.
+    * @param	userContextCallback			User specified context that will be provided to the
+    * 										callback. This can be @c NULL.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_SendEventAsync_Move, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
+
     /**
     * @brief	This function returns the current sending status for IoTHubClient.
     *
@@ -130,6 +150,19 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetSendStatus, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
 
+    /**
+    * @brief	This function returns the number of events that were accepted by
+    * 			::IoTHubClient_SendEventAsync and have not been confirmed yet.
+    * 			Producers can use it to throttle when the transport cannot keep up.
+    *
+    * @param	iotHubClientHandle		The handle created by a call to the create function.
+    * @param	queueSize				The number of pending events is populated at the
+    * 									address pointed at by this parameter.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetSendQueueSize, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, size_t*, queueSize);
+
     /**
     * @brief	Sets up the message callback to be invoked when IoT Hub issues a
     * 			message to the device. This is a blocking call.
@@ -210,6 +243,20 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetLastMessageReceiveTime, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, time_t*, lastMessageReceiveTime);
 
+    /**
+    * @brief	This function returns how many times the worker thread of the client woke up
+    * 			and how many times it called ::IoTHubClient_LL_DoWork. A client that expects nothing
+    * 			from the transport only wakes up for its message timeouts and when it is given work,
+    * 			otherwise it wakes up at least once per idle wait period (see OPTION_WORKER_IDLE_WAIT_TIME).
+    *
+    * @param	iotHubClientHandle				The handle created by a call to the create function.
+    * @param	wakeupCount						Out parameter containing the number of worker thread wakeups.
+    * @param	doWorkCount						Out parameter containing the number of calls to ::IoTHubClient_LL_DoWork.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_GetWorkerStatistics, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, size_t*, wakeupCount, size_t*, doWorkCount);
+
     /**
     * @brief	This API sets a runtime option identified by parameter @p optionName
     * 			to a value pointed to by @p value. @p optionName and the data type
@@ -340,6 +387,20 @@ extern "C"
     * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_UploadToBlobAsync, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, const char*, destinationFileName, const unsigned char*, source, size_t, size, IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK, iotHubClientFileUploadCallback, void*, context);
+
+    /**
+    * @brief	IoTHubClient_UploadMultipleBlocksToBlobAsync streams a file to Azure Blob Storage without holding it in memory.
+    *
+    * @param	iotHubClientHandle	                The handle created by a call to the IoTHubClient_Create function.
+    * @param	destinationFileName	                The name of the file to be created in Azure Blob Storage.
+    * @param	source                              The size of the file, the callback reading it and the optional checkpoint.
+    *                                               The structure is copied, what it points to needs to stay valid until the file upload callback is called.
+    * @param    iotHubClientFileUploadCallback      A callback to be invoked when the file upload operation has finished.
+    * @param    context                             A user-provided context to be passed to the file upload callback.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_UploadMultipleBlocksToBlobAsync, IOTHUB_CLIENT_HANDLE, iotHubClientHandle, const char*, destinationFileName, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE*, source, IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK, iotHubClientFileUploadCallback, void*, context);
 #endif
 #ifdef __cplusplus
 }
@@ -230,6 +230,35 @@ extern "C"
         PDLIST_ENTRY waitingToSend;
     };
 
+#ifndef DONT_USE_UPLOADTOBLOB
+    /** @brief	Size of the blocks a streamed file upload is split into. */
+#define IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE (4 * 1024 * 1024)
+
+    /** @brief	Number of bytes of the checkpoint bitmap needed to upload @p size bytes (one bit per block). */
+#define IOTHUB_CLIENT_FILE_UPLOAD_CHECKPOINT_SIZE(size) ((size_t)((((uint64_t)(size) + IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE - 1) / IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE + 7) / 8))
+
+    /** @brief	Fills @p buffer with the @p size bytes found at @p offset in the file being uploaded. Returns 0 on success.
+    *			It is never called concurrently and the offsets it is asked for only ever grow. */
+    typedef int(*IOTHUB_CLIENT_FILE_UPLOAD_READ_CALLBACK)(void* context, uint64_t offset, unsigned char* buffer, size_t size);
+
+    /** @brief	Called, never concurrently, every time Azure Storage has accepted block @p blockId; the checkpoint already has its bit set. */
+    typedef void(*IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_CALLBACK)(void* context, unsigned int blockId);
+
+    /** @brief	This struct describes a file that is streamed to Azure Storage instead of being held in memory. */
+    typedef struct IOTHUB_CLIENT_FILE_UPLOAD_SOURCE_TAG
+    {
+        uint64_t size;
+        IOTHUB_CLIENT_FILE_UPLOAD_READ_CALLBACK readCallback;
+        void* readContext;
+        /** @brief	Optional bitmap of IOTHUB_CLIENT_FILE_UPLOAD_CHECKPOINT_SIZE(size) bytes, bit n (checkpoint[n / 8] & (1 << (n % 8)))
+        *			set meaning block n was accepted by a previous attempt to upload the same file under the same name and is not sent again.
+        *			Bits are set as blocks are accepted, so persisting it lets an interrupted upload resume. */
+        unsigned char* checkpoint;
+        IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_CALLBACK blockCallback;
+        void* blockCallbackContext;
+    } IOTHUB_CLIENT_FILE_UPLOAD_SOURCE;
+#endif /*DONT_USE_UPLOADTOBLOB*/
+
 
     /**
     * @brief	Creates a IoT Hub client for communication with an existing
@@ -306,6 +335,29 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SendEventAsync, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
 
+    /**
+    * @brief	Asynchronous call to send the message specified by @p eventMessageHandle
+    * 			without making a copy of it.
+    *
+    * 			Unlike ::IoTHubClient_LL_SendEventAsync the message is not cloned: upon
+    * 			success the client takes ownership of @p eventMessageHandle and destroys it
+    * 			once the message has been confirmed (or has timed out). The caller shall
+    * 			not use or destroy the handle after a successful call. If the call fails the
+    * 			caller keeps ownership of the message.
+    *
+    * @param	iotHubClientHandle		   	The handle created by a call to the create function.
+    * @param	eventMessageHandle		   	The handle to an IoT Hub message.
+    * @param	eventConfirmationCallback  	The callback specified by the device for receiving
+    * 										confirmation of the delivery of the IoT Hub message.
+    * 										The user can specify a @c NULL value here to
+    * 										indicate that no callback is required.
+    * @param	userContextCallback			User specified context that will be provided to the
+    * 										callback. This can be @c NULL.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SendEventAsync_Move, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_MESSAGE_HANDLE, eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, eventConfirmationCallback, void*, userContextCallback);
+
     /**
     * @brief	This function returns the current sending status for IoTHubClient.
     *
@@ -320,6 +372,20 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetSendStatus, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_STATUS*, iotHubClientStatus);
 
+    /**
+    * @brief	This function returns the number of events that were accepted by
+    * 			::IoTHubClient_LL_SendEventAsync and whose confirmation callback has
+    * 			not been called yet. Producers can use it to throttle when the
+    * 			transport cannot keep up.
+    *
+    * @param	iotHubClientHandle		The handle created by a call to the create function.
+    * @param	queueSize				The number of pending events is populated at the
+    * 									address pointed at by this parameter.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetSendQueueSize, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, size_t*, queueSize);
+
     /**
     * @brief	Sets up the message callback to be invoked when IoT Hub issues a
     * 			message to the device. This is a blocking call.
@@ -544,6 +610,19 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_UploadToBlob, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, const unsigned char*, source, size_t, size);
 
+    /**
+    * @brief	This API streams to Azure Storage the file described by @p source under the blob name devicename/@p destinationFileName.
+    *           The file is read one block at a time and up to "blob_upload_parallelism" blocks are uploaded at once, each
+    *           over its own connection, so memory stays bounded regardless of the size of the file.
+    *
+    * @param	iotHubClientHandle	    The handle created by a call to the create function.
+    * @param	destinationFileName     name of the file.
+    * @param	source                  the size of the file, the callback reading it and the optional checkpoint. It is not copied.
+    *
+    * @return	IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_UploadMultipleBlocksToBlob, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, const char*, destinationFileName, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE*, source);
+
 #endif /*DONT_USE_UPLOADTOBLOB*/
 
 #ifdef __cplusplus
@@ -4,6 +4,8 @@
 #ifndef IOTHUB_CLIENT_OPTIONS_H
 #define IOTHUB_CLIENT_OPTIONS_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -16,6 +18,12 @@ extern "C"
         const char* password;
     } IOTHUB_PROXY_OPTIONS;
 
+    typedef struct IOTHUB_COMPRESSION_DICTIONARY_TAG
+    {
+        const unsigned char* bytes;
+        size_t size;
+    } IOTHUB_COMPRESSION_DICTIONARY;
+
     static const char* OPTION_LOG_TRACE = "logtrace";
     static const char* OPTION_X509_CERT = "x509certificate";
     static const char* OPTION_X509_PRIVATE_KEY = "x509privatekey";
@@ -32,6 +40,26 @@ extern "C"
     static const char* OPTION_MIN_POLLING_TIME = "MinimumPollingTime";
     static const char* OPTION_BATCHING = "Batching";
 
+    static const char* OPTION_WORKER_IDLE_WAIT_TIME = "worker_idle_wait_time";
+    static const char* OPTION_CALLBACK_DISPATCH_THREAD = "callback_dispatch_thread";
+
+    static const char* OPTION_MAX_IN_FLIGHT_MESSAGES = "max_in_flight_messages";
+    static const char* OPTION_MAX_PUBLISH_PER_DOWORK = "max_publish_per_dowork";
+
+    static const char* OPTION_REPORTED_STATE_COALESCING_INTERVAL = "reported_state_coalescing_interval";
+
+    static const char* OPTION_OUTBOUND_STORE_PATH = "outbound_store_path";
+    static const char* OPTION_OUTBOUND_STORE_SEGMENT_SIZE = "outbound_store_segment_size";
+    static const char* OPTION_OUTBOUND_STORE_WINDOW = "outbound_store_window";
+
+    static const char* OPTION_MESSAGE_POOL_SIZE = "message_pool_size";
+
+    static const char* OPTION_COMPRESSION_THRESHOLD = "compression_threshold";
+    static const char* OPTION_COMPRESSION_DICTIONARY = "compression_dictionary";
+
+    static const char* OPTION_BLOB_UPLOAD_PARALLELISM = "blob_upload_parallelism";
+    static const char* OPTION_BLOB_UPLOAD_BLOCK_RETRIES = "blob_upload_block_retries";
+
 #ifdef __cplusplus
 }
 #endif
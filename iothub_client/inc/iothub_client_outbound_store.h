@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_OUTBOUND_STORE_H
+#define IOTHUB_CLIENT_OUTBOUND_STORE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE     (1024 * 1024)
+
+struct OUTBOUND_STORE_INSTANCE_TAG;
+typedef struct OUTBOUND_STORE_INSTANCE_TAG* OUTBOUND_STORE_HANDLE;
+
+typedef void(*OUTBOUND_STORE_ON_RECORD)(void* context, uint64_t sequence, const unsigned char* data, size_t size);
+
+MOCKABLE_FUNCTION(, OUTBOUND_STORE_HANDLE, outbound_store_open, const char*, path, size_t, segment_size);
+MOCKABLE_FUNCTION(, int, outbound_store_replay, OUTBOUND_STORE_HANDLE, handle, OUTBOUND_STORE_ON_RECORD, on_record, void*, context);
+MOCKABLE_FUNCTION(, int, outbound_store_read, OUTBOUND_STORE_HANDLE, handle, uint64_t*, sequence, size_t, max_count, OUTBOUND_STORE_ON_RECORD, on_record, void*, context);
+MOCKABLE_FUNCTION(, int, outbound_store_append, OUTBOUND_STORE_HANDLE, handle, const unsigned char*, data, size_t, size, uint64_t*, sequence);
+MOCKABLE_FUNCTION(, int, outbound_store_commit, OUTBOUND_STORE_HANDLE, handle);
+MOCKABLE_FUNCTION(, int, outbound_store_release, OUTBOUND_STORE_HANDLE, handle, uint64_t, sequence);
+MOCKABLE_FUNCTION(, int, outbound_store_compact, OUTBOUND_STORE_HANDLE, handle);
+MOCKABLE_FUNCTION(, size_t, outbound_store_get_pending_count, OUTBOUND_STORE_HANDLE, handle);
+MOCKABLE_FUNCTION(, void, outbound_store_close, OUTBOUND_STORE_HANDLE, handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_OUTBOUND_STORE_H */
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_H
+#define IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PAYLOAD_COMPRESSOR_DEFAULT_THRESHOLD    256
+#define PAYLOAD_COMPRESSOR_CONTENT_ENCODING     "deflate"
+
+struct PAYLOAD_COMPRESSOR_INSTANCE_TAG;
+typedef struct PAYLOAD_COMPRESSOR_INSTANCE_TAG* PAYLOAD_COMPRESSOR_HANDLE;
+
+MOCKABLE_FUNCTION(, PAYLOAD_COMPRESSOR_HANDLE, payload_compressor_create, const unsigned char*, dictionary, size_t, dictionary_size);
+MOCKABLE_FUNCTION(, int, payload_compressor_deflate, PAYLOAD_COMPRESSOR_HANDLE, handle, const unsigned char*, source, size_t, size, const unsigned char**, compressed, size_t*, compressed_size);
+MOCKABLE_FUNCTION(, void, payload_compressor_destroy, PAYLOAD_COMPRESSOR_HANDLE, handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_H */
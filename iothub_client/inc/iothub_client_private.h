@@ -32,6 +32,9 @@ extern "C"
 #define API_VERSION "?api-version=2016-11-14"
 #define REJECT_QUERY_PARAMETER "&reject"
 
+/*returned by IoTHubClient_LL_GetWorkWaitTime when IoTHubClient_LL_DoWork has nothing to do until it is given more work*/
+#define IOTHUB_CLIENT_LL_NO_WORK_DEADLINE ((tickcounter_ms_t)-1)
+
 typedef bool(*IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC_EX)(MESSAGE_CALLBACK_INFO* messageData, void* userContextCallback);
 
 MOCKABLE_FUNCTION(, void, IoTHubClient_LL_SendComplete, IOTHUB_CLIENT_LL_HANDLE, handle, PDLIST_ENTRY, completed, IOTHUB_CLIENT_CONFIRMATION_RESULT, result);
@@ -42,6 +45,7 @@ MOCKABLE_FUNCTION(, int, IoTHubClient_LL_DeviceMethodComplete, IOTHUB_CLIENT_LL_
 MOCKABLE_FUNCTION(, void, IoTHubClient_LL_ConnectionStatusCallBack, IOTHUB_CLIENT_LL_HANDLE, handle, IOTHUB_CLIENT_CONNECTION_STATUS, status, IOTHUB_CLIENT_CONNECTION_STATUS_REASON, reason);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SetMessageCallbackEx, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC_EX, messageCallback, void*, userContextCallback);
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_SendMessageDisposition, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, MESSAGE_CALLBACK_INFO*, messageData, IOTHUBMESSAGE_DISPOSITION_RESULT, disposition);
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_LL_GetWorkWaitTime, IOTHUB_CLIENT_LL_HANDLE, iotHubClientHandle, tickcounter_ms_t, transportPollMs, tickcounter_ms_t*, waitMs);
 
 typedef struct IOTHUB_MESSAGE_LIST_TAG
 {
@@ -50,6 +54,7 @@ typedef struct IOTHUB_MESSAGE_LIST_TAG
     void* context; 
     DLIST_ENTRY entry;
     tickcounter_ms_t ms_timesOutAfter; /* a value of "0" means "no timeout", if the IOTHUBCLIENT_LL's handle tickcounter > msTimesOutAfer then the message shall timeout*/
+    uint64_t outboundStoreSequence; /* a value of "0" means the message is not kept in the outbound store */
 }IOTHUB_MESSAGE_LIST;
 
 typedef struct IOTHUB_DEVICE_TWIN_TAG
@@ -60,6 +65,7 @@ typedef struct IOTHUB_DEVICE_TWIN_TAG
     CONSTBUFFER_HANDLE report_data_handle;
     void* context;
     DLIST_ENTRY entry;
+    struct IOTHUB_DEVICE_TWIN_TAG* coalesced_items; /* for a coalesced patch, the original items merged into it, chained through their own coalesced_items. NULL otherwise */
 } IOTHUB_DEVICE_TWIN;
 
 union IOTHUB_IDENTITY_INFO_TAG
@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef IOTHUB_CLIENT_SLAB_POOL_H
+#define IOTHUB_CLIENT_SLAB_POOL_H
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+struct SLAB_POOL_INSTANCE_TAG;
+typedef struct SLAB_POOL_INSTANCE_TAG* SLAB_POOL_HANDLE;
+
+MOCKABLE_FUNCTION(, SLAB_POOL_HANDLE, slab_pool_create, size_t, item_size, size_t, capacity);
+MOCKABLE_FUNCTION(, void*, slab_pool_alloc, SLAB_POOL_HANDLE, handle);
+MOCKABLE_FUNCTION(, void, slab_pool_free, SLAB_POOL_HANDLE, handle, void*, item);
+MOCKABLE_FUNCTION(, size_t, slab_pool_get_heap_allocation_count, SLAB_POOL_HANDLE, handle);
+MOCKABLE_FUNCTION(, void, slab_pool_destroy, SLAB_POOL_HANDLE, handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_SLAB_POOL_H */
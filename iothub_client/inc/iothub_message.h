@@ -44,6 +44,17 @@ DEFINE_ENUM(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_CONTENT_TYPE_VALUES);
 
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* IOTHUB_MESSAGE_HANDLE;
 
+/** @brief  A bounded set of messages that ::IoTHubMessage_CloneFromPool
+  *         reuses, together with their content storage and properties map.
+  */
+typedef struct IOTHUB_MESSAGE_POOL_TAG* IOTHUB_MESSAGE_POOL_HANDLE;
+
+/** @brief  Function called when a message created by
+  *         ::IoTHubMessage_CreateFromByteArrayNoCopy is destroyed, giving the
+  *         caller owned buffer back to its owner.
+  */
+typedef void(*IOTHUB_MESSAGE_RELEASE_CALLBACK)(const unsigned char* byteArray, size_t size, void* context);
+
 /**
  * @brief   Creates a new IoT hub message from a byte array. The type of the
  *          message will be set to @c IOTHUBMESSAGE_BYTEARRAY.
@@ -56,6 +67,25 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* IOTHUB_MESSAGE_HANDLE;
  */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromByteArray, const unsigned char*, byteArray, size_t, size);
 
+/**
+ * @brief   Creates a new IoT hub message that references a caller owned byte
+ *          array instead of copying it. The type of the message will be set
+ *          to @c IOTHUBMESSAGE_BYTEARRAY.
+ *
+ *          The byte array shall stay valid and unchanged until @p releaseCallback
+ *          is called, which happens when the message is destroyed.
+ *
+ * @param   byteArray       The byte array referenced by the message.
+ * @param   size            The size of the byte array.
+ * @param   releaseCallback Function called when the message no longer needs
+ *                          @p byteArray. This can be @c NULL.
+ * @param   releaseContext  User specified context passed to @p releaseCallback.
+ *
+ * @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+ *          created or @c NULL in case an error occurs.
+ */
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromByteArrayNoCopy, const unsigned char*, byteArray, size_t, size, IOTHUB_MESSAGE_RELEASE_CALLBACK, releaseCallback, void*, releaseContext);
+
 /**
  * @brief   Creates a new IoT hub message from a null terminated string.  The
  *          type of the message will be set to @c IOTHUBMESSAGE_STRING.
@@ -79,6 +109,46 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CreateFromString, const
  */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_Clone, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
 
+/**
+* @brief   Creates a pool of @p capacity messages for ::IoTHubMessage_CloneFromPool.
+*          The pool is not thread safe and all its messages must be destroyed
+*          before the pool is.
+*
+* @param   capacity Number of messages of the pool.
+*
+* @return  A valid @c IOTHUB_MESSAGE_POOL_HANDLE or @c NULL in case an error occurs.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_POOL_HANDLE, IoTHubMessage_CreatePool, size_t, capacity);
+
+/**
+* @brief   Same as ::IoTHubMessage_Clone, but the clone is a message of @p pool
+*          that still has the content storage, properties map and id strings
+*          of its previous use, so that cloning events of the same shape does
+*          not allocate. ::IoTHubMessage_Destroy gives the clone back to the
+*          pool. When all the messages of the pool are in use the clone is
+*          made by ::IoTHubMessage_Clone.
+*
+* @param   pool                The pool the clone is taken from.
+* @param   iotHubMessageHandle Handle to the message that is to be cloned.
+*
+* @return  A valid @c IOTHUB_MESSAGE_HANDLE if the message was successfully
+*          cloned or @c NULL in case an error occurs.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_CloneFromPool, IOTHUB_MESSAGE_POOL_HANDLE, pool, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
+
+/**
+* @brief   Returns how many times ::IoTHubMessage_CloneFromPool had to allocate
+*          memory (or update a value of a properties map) since the pool was
+*          created. It stays the same while the pool fits the steady state of
+*          the application.
+*/
+MOCKABLE_FUNCTION(, size_t, IoTHubMessage_GetPoolHeapAllocationCount, IOTHUB_MESSAGE_POOL_HANDLE, pool);
+
+/**
+* @brief   Frees the pool and the storage kept by its messages.
+*/
+MOCKABLE_FUNCTION(, void, IoTHubMessage_DestroyPool, IOTHUB_MESSAGE_POOL_HANDLE, pool);
+
 /**
  * @brief   Fetches a pointer and size for the data associated with the IoT
  *          hub message handle. If the content type of the message is not
@@ -96,6 +166,22 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_HANDLE, IoTHubMessage_Clone, IOTHUB_MESSAGE_H
  */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetByteArray, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const unsigned char**, buffer, size_t*, size);
 
+/**
+* @brief   Replaces the content of the message with a copy of @p byteArray.
+*          The previous content (string, byte array or caller owned byte
+*          array) is released and the content type of the message becomes
+*          @c IOTHUBMESSAGE_BYTEARRAY. Properties, message id and
+*          correlation id are kept.
+*
+* @param   iotHubMessageHandle Handle to the message.
+* @param   byteArray Pointer to the new content.
+* @param   size Number of bytes in @p byteArray.
+*
+* @return  Returns IOTHUB_MESSAGE_OK if the content was replaced or an error
+*          code otherwise, in which case the message is left unchanged.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetByteArray, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const unsigned char*, byteArray, size_t, size);
+
 /**
  * @brief   Returns the null terminated string stored in the message.
  *          If the content type of the message is not @c IOTHUBMESSAGE_STRING
@@ -123,10 +209,30 @@ MOCKABLE_FUNCTION(, IOTHUBMESSAGE_CONTENT_TYPE, IoTHubMessage_GetContentType, IO
  *
  * @param   iotHubMessageHandle Handle to the message.
  *
- * @return  A @c MAP_HANDLE pointing to the properties map for this message.
+ * @return  A @c MAP_HANDLE pointing to the properties map for this message,
+ *          or @c NULL if the handle is @c NULL or the deferred properties of
+ *          the message (see IoTHubMessage_SetDeferredProperties) could not
+ *          be added to the map.
  */
 MOCKABLE_FUNCTION(, MAP_HANDLE, IoTHubMessage_Properties, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle);
 
+/**
+* @brief   Hands the message a "name=value&name=value" property list whose
+*          parsing is postponed until the properties map is first read
+*          (IoTHubMessage_Properties or IoTHubMessage_Clone). Used by
+*          transports so that messages whose properties are never looked at
+*          do not pay for building the map.
+*
+* @param   iotHubMessageHandle Handle to the message.
+* @param   properties Pointer to the property list, it does not need to be
+*          zero terminated.
+* @param   length Number of characters in @p properties.
+*
+* @return  Returns IOTHUB_MESSAGE_OK if the property list was stored
+*          or an error code otherwise.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetDeferredProperties, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const char*, properties, size_t, length);
+
 /**
 * @brief   Gets the MessageId from the IOTHUB_MESSAGE_HANDLE.
 *
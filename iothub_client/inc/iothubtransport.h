@@ -5,6 +5,7 @@
 #define IOTHUB_TRANSPORT_H
 
 typedef struct TRANSPORT_HANDLE_DATA_TAG* TRANSPORT_HANDLE;
+typedef struct TRANSPORT_POOL_HANDLE_DATA_TAG* TRANSPORT_POOL_HANDLE;
 
 
 #include "azure_c_shared_utility/lock.h"
@@ -32,6 +33,16 @@ extern "C"
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubTransport_StartWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_HANDLE, clientHandle);
     MOCKABLE_FUNCTION(, bool, IoTHubTransport_SignalEndWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_HANDLE, clientHandle);
     MOCKABLE_FUNCTION(, void, IoTHubTransport_JoinWorkerThread, TRANSPORT_HANDLE, transportHandle, IOTHUB_CLIENT_HANDLE, clientHandle);
+    /*wakes up the thread calling DoWork for this transport, the caller holds the transport lock*/
+    MOCKABLE_FUNCTION(, void, IoTHubTransport_SignalWorkerThread, TRANSPORT_HANDLE, transportHandle);
+
+    /*a transport pool spreads devices over several shared connections (devicesPerConnection devices each) and services
+    them from workerThreadCount threads. Pass the handle returned by IoTHubTransport_GetPooledTransport to
+    IoTHubClient_CreateWithTransport and give it back with IoTHubTransport_Destroy once the client is destroyed (or could not be
+    created); the connections themselves are destroyed by IoTHubTransport_DestroyPool, after all their clients*/
+    MOCKABLE_FUNCTION(, TRANSPORT_POOL_HANDLE, IoTHubTransport_CreatePool, IOTHUB_CLIENT_TRANSPORT_PROVIDER, protocol, const char*, iotHubName, const char*, iotHubSuffix, size_t, devicesPerConnection, size_t, workerThreadCount);
+    MOCKABLE_FUNCTION(, TRANSPORT_HANDLE, IoTHubTransport_GetPooledTransport, TRANSPORT_POOL_HANDLE, transportPoolHandle);
+    MOCKABLE_FUNCTION(, void, IoTHubTransport_DestroyPool, TRANSPORT_POOL_HANDLE, transportPoolHandle);
 
 #ifdef __cplusplus
 }
@@ -17,6 +17,9 @@ extern "C"
 
 static const char* MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS = "event_send_timeout_secs";
 static const char* MESSENGER_OPTION_SAVED_OPTIONS = "saved_messenger_options";
+static const char* MESSENGER_OPTION_BATCHING = "batching";
+static const char* MESSENGER_OPTION_MAX_EVENTS_PER_BATCH = "max_events_per_batch";
+static const char* MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES = "max_batch_size_in_bytes";
 
 typedef struct MESSENGER_INSTANCE* MESSENGER_HANDLE;
 
@@ -3,15 +3,24 @@
 
 #include <stdlib.h>
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
 #include "blob.h"
 
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
 
 /*a block has 4MB*/
 #define BLOCK_SIZE (4*1024*1024)
 
+/*https://msdn.microsoft.com/en-us/library/azure/dd135726.aspx: a block blob can include a maximum of 50,000 blocks*/
+#define MAX_BLOCK_COUNT 50000
+
+/*a failed Put Block waits 1s, 2s, 3s... before being retried*/
+#define BLOCK_RETRY_DELAY_MS 1000
+
 BLOB_RESULT Blob_UploadFromSasUri(const char* SASURI, const unsigned char* source, size_t size, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
 {
     BLOB_RESULT result;
@@ -358,3 +367,484 @@ BLOB_RESULT Blob_UploadFromSasUri(const char* SASURI, const unsigned char* sourc
     }
     return result;
 }
+
+/*state shared by all the threads uploading the blocks of one Blob_UploadMultipleBlocksFromSasUri call*/
+typedef struct BLOB_UPLOAD_CONTEXT_TAG
+{
+    const char* hostname;
+    const char* relativePath;
+    const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source;
+    unsigned int blockCount;
+    size_t blockRetries;
+    LOCK_HANDLE lock; /*NULL when the calling thread uploads all the blocks*/
+    unsigned int nextBlockId;
+    int isStopped; /*set by the first block that fails, result, httpStatus and httpResponse then describe that failure*/
+    BLOB_RESULT result;
+    unsigned int* httpStatus;
+    BUFFER_HANDLE httpResponse;
+} BLOB_UPLOAD_CONTEXT;
+
+static void lockContext(BLOB_UPLOAD_CONTEXT* context)
+{
+    if ((context->lock != NULL) && (Lock(context->lock) != LOCK_OK))
+    {
+        LogError("unable to Lock - trying anyway");
+    }
+}
+
+static void unlockContext(BLOB_UPLOAD_CONTEXT* context)
+{
+    if ((context->lock != NULL) && (Unlock(context->lock) != LOCK_OK))
+    {
+        LogError("unable to Unlock");
+    }
+}
+
+static STRING_HANDLE createBlockId(unsigned int blockId)
+{
+    STRING_HANDLE result;
+    /*Codes_SRS_BLOB_01_007: [ The ID of a block shall be the BASE64 encoding of its zero based index printed on 6 digits (000000... 049999). ]*/
+    char temp[7];
+    if (sprintf(temp, "%06u", blockId) != 6)
+    {
+        LogError("failed to sprintf");
+        result = NULL;
+    }
+    else if ((result = Base64_Encode_Bytes((const unsigned char*)temp, 6)) == NULL)
+    {
+        LogError("unable to Base64_Encode_Bytes");
+    }
+    return result;
+}
+
+static int isRetryableStatus(unsigned int httpStatus)
+{
+    return (httpStatus == 408) || (httpStatus == 429) || (httpStatus >= 500);
+}
+
+/*picks the next block not in the checkpoint and reads it into a new buffer, under the lock so reads never overlap and only move forward*/
+/*returns 0 when there is a block to upload, non-zero when there is nothing left to do or reading failed (recorded in context)*/
+static int readNextBlock(BLOB_UPLOAD_CONTEXT* context, unsigned int* blockId, BUFFER_HANDLE* content)
+{
+    int result;
+    const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source = context->source;
+
+    lockContext(context);
+
+    /*Codes_SRS_BLOB_01_008: [ Blocks whose bit is set in the checkpoint shall not be read nor uploaded. ]*/
+    while ((context->nextBlockId < context->blockCount) &&
+        (source->checkpoint != NULL) &&
+        ((source->checkpoint[context->nextBlockId / 8] & (1 << (context->nextBlockId % 8))) != 0))
+    {
+        context->nextBlockId++;
+    }
+
+    if (context->isStopped || (context->nextBlockId == context->blockCount))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t offset = (uint64_t)context->nextBlockId * IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE;
+        size_t blockSize = ((source->size - offset) > IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE) ? IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE : (size_t)(source->size - offset);
+
+        *blockId = context->nextBlockId++;
+
+        if ((*content = BUFFER_new()) == NULL)
+        {
+            /*Codes_SRS_BLOB_01_014: [ If any other operation fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+            LogError("unable to BUFFER_new");
+            result = __FAILURE__;
+        }
+        else if (BUFFER_pre_build(*content, blockSize) != 0)
+        {
+            /*Codes_SRS_BLOB_01_014: [ If any other operation fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+            LogError("unable to BUFFER_pre_build %zu bytes", blockSize);
+            BUFFER_delete(*content);
+            result = __FAILURE__;
+        }
+        /*Codes_SRS_BLOB_01_009: [ Blob_UploadMultipleBlocksFromSasUri shall read every block through readCallback, one block at a time and in increasing offset order. ]*/
+        else if (source->readCallback(source->readContext, offset, BUFFER_u_char(*content), blockSize) != 0)
+        {
+            /*Codes_SRS_BLOB_01_010: [ If readCallback fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+            LogError("unable to read block %u", *blockId);
+            BUFFER_delete(*content);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (result != 0)
+        {
+            context->isStopped = 1;
+            context->result = BLOB_ERROR;
+        }
+    }
+
+    unlockContext(context);
+    return result;
+}
+
+static BLOB_RESULT putBlock(BLOB_UPLOAD_CONTEXT* context, HTTPAPIEX_HANDLE httpApiExHandle, unsigned int blockId, BUFFER_HANDLE content, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+{
+    BLOB_RESULT result;
+    STRING_HANDLE blockIdString = createBlockId(blockId);
+    if (blockIdString == NULL)
+    {
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_BLOB_01_011: [ Every block shall be uploaded by a PUT request to base relativePath + "&comp=block&blockid=" + the block ID. ]*/
+        STRING_HANDLE blockRelativePath = STRING_construct(context->relativePath);
+        if (blockRelativePath == NULL)
+        {
+            LogError("unable to STRING_construct");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            if (!(
+                (STRING_concat(blockRelativePath, "&comp=block&blockid=") == 0) &&
+                (STRING_concat_with_STRING(blockRelativePath, blockIdString) == 0)
+                ))
+            {
+                LogError("unable to STRING concatenate");
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                size_t attempt = 0;
+                while (1)
+                {
+                    HTTPAPIEX_RESULT httpResult = HTTPAPIEX_ExecuteRequest(httpApiExHandle, HTTPAPI_REQUEST_PUT, STRING_c_str(blockRelativePath), NULL, content, httpStatus, NULL, httpResponse);
+                    if ((httpResult == HTTPAPIEX_OK) && (*httpStatus < 300))
+                    {
+                        result = BLOB_OK;
+                        break;
+                    }
+                    /*Codes_SRS_BLOB_01_012: [ If the request fails or storage answers 408, 429 or 5xx, the block shall be uploaded again, at most blockRetries more times, waiting a second longer before every retry. ]*/
+                    else if ((attempt < context->blockRetries) &&
+                        ((httpResult != HTTPAPIEX_OK) || isRetryableStatus(*httpStatus)))
+                    {
+                        attempt++;
+                        LogError("upload of block %u failed (%d, HTTP status %u), retry %zu of %zu", blockId, (int)httpResult, (httpResult == HTTPAPIEX_OK) ? *httpStatus : 0, attempt, context->blockRetries);
+                        ThreadAPI_Sleep((unsigned int)(BLOCK_RETRY_DELAY_MS * attempt));
+                    }
+                    else if (httpResult != HTTPAPIEX_OK)
+                    {
+                        /*Codes_SRS_BLOB_01_013: [ If a block still cannot be uploaded, Blob_UploadMultipleBlocksFromSasUri shall stop uploading and return BLOB_HTTP_ERROR when the request failed, or BLOB_OK with the HTTP status and response of storage otherwise. ]*/
+                        LogError("unable to HTTPAPIEX_ExecuteRequest");
+                        result = BLOB_HTTP_ERROR;
+                        break;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_BLOB_01_013: [ If a block still cannot be uploaded, Blob_UploadMultipleBlocksFromSasUri shall stop uploading and return BLOB_HTTP_ERROR when the request failed, or BLOB_OK with the HTTP status and response of storage otherwise. ]*/
+                        LogError("HTTP status from storage does not indicate success (%u)", *httpStatus);
+                        result = BLOB_OK;
+                        break;
+                    }
+                }
+            }
+            STRING_delete(blockRelativePath);
+        }
+        STRING_delete(blockIdString);
+    }
+    return result;
+}
+
+static void uploadBlocks(BLOB_UPLOAD_CONTEXT* context, HTTPAPIEX_HANDLE httpApiExHandle)
+{
+    BUFFER_HANDLE blockResponse = BUFFER_new();
+    if (blockResponse == NULL)
+    {
+        LogError("unable to BUFFER_new");
+        lockContext(context);
+        if (!context->isStopped)
+        {
+            context->isStopped = 1;
+            context->result = BLOB_ERROR;
+        }
+        unlockContext(context);
+    }
+    else
+    {
+        unsigned int blockId;
+        BUFFER_HANDLE content;
+        while (readNextBlock(context, &blockId, &content) == 0)
+        {
+            unsigned int blockStatus = 0;
+            BLOB_RESULT blockResult = putBlock(context, httpApiExHandle, blockId, content, &blockStatus, blockResponse);
+            BUFFER_delete(content);
+
+            lockContext(context);
+            if ((blockResult == BLOB_OK) && (blockStatus < 300))
+            {
+                /*Codes_SRS_BLOB_01_015: [ Once storage has accepted a block its bit shall be set in the checkpoint and blockCallback, if any, shall be called with its ID, never concurrently. ]*/
+                if (context->source->checkpoint != NULL)
+                {
+                    context->source->checkpoint[blockId / 8] |= (unsigned char)(1 << (blockId % 8));
+                }
+                if (context->source->blockCallback != NULL)
+                {
+                    context->source->blockCallback(context->source->blockCallbackContext, blockId);
+                }
+            }
+            else if (!context->isStopped)
+            {
+                context->isStopped = 1;
+                context->result = blockResult;
+                if (blockResult == BLOB_OK)
+                {
+                    *context->httpStatus = blockStatus;
+                    if ((context->httpResponse != NULL) &&
+                        (BUFFER_length(blockResponse) > 0) &&
+                        (BUFFER_build(context->httpResponse, BUFFER_u_char(blockResponse), BUFFER_length(blockResponse)) != 0))
+                    {
+                        LogError("unable to BUFFER_build");
+                    }
+                }
+            }
+            unlockContext(context);
+        }
+        BUFFER_delete(blockResponse);
+    }
+}
+
+static int uploadBlocksThread(void* data)
+{
+    BLOB_UPLOAD_CONTEXT* context = (BLOB_UPLOAD_CONTEXT*)data;
+    /*Codes_SRS_BLOB_01_006: [ Every additional thread shall upload blocks over its own HTTPAPIEX_HANDLE to the hostname. ]*/
+    HTTPAPIEX_HANDLE httpApiExHandle = HTTPAPIEX_Create(context->hostname);
+    if (httpApiExHandle == NULL)
+    {
+        /*the other threads keep going, this one just does not help*/
+        LogError("unable to create a HTTPAPIEX_HANDLE");
+    }
+    else
+    {
+        uploadBlocks(context, httpApiExHandle);
+        HTTPAPIEX_Destroy(httpApiExHandle);
+    }
+    return 0;
+}
+
+static BLOB_RESULT putBlockList(BLOB_UPLOAD_CONTEXT* context, HTTPAPIEX_HANDLE httpApiExHandle)
+{
+    BLOB_RESULT result;
+    /*Codes_SRS_BLOB_01_016: [ After all the blocks have been accepted Blob_UploadMultipleBlocksFromSasUri shall PUT to base relativePath + "&comp=blocklist" the XML list of all the block IDs, in order, passing httpStatus and httpResponse. ]*/
+    STRING_HANDLE xml = STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>");
+    if (xml == NULL)
+    {
+        LogError("failed to STRING_construct");
+        result = BLOB_ERROR;
+    }
+    else
+    {
+        unsigned int blockId;
+        result = BLOB_OK;
+        for (blockId = 0; (blockId < context->blockCount) && (result == BLOB_OK); blockId++)
+        {
+            STRING_HANDLE blockIdString = createBlockId(blockId);
+            if (blockIdString == NULL)
+            {
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                if (!(
+                    (STRING_concat(xml, "<Latest>") == 0) &&
+                    (STRING_concat_with_STRING(xml, blockIdString) == 0) &&
+                    (STRING_concat(xml, "</Latest>") == 0)
+                    ))
+                {
+                    LogError("unable to STRING_concat");
+                    result = BLOB_ERROR;
+                }
+                STRING_delete(blockIdString);
+            }
+        }
+
+        if (result != BLOB_OK)
+        {
+            /*already logged*/
+        }
+        else if (STRING_concat(xml, "</BlockList>") != 0)
+        {
+            LogError("failed to STRING_concat");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            STRING_HANDLE blockListRelativePath = STRING_construct(context->relativePath);
+            if (blockListRelativePath == NULL)
+            {
+                LogError("failed to STRING_construct");
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                if (STRING_concat(blockListRelativePath, "&comp=blocklist") != 0)
+                {
+                    LogError("failed to STRING_concat");
+                    result = BLOB_ERROR;
+                }
+                else
+                {
+                    const char* s = STRING_c_str(xml);
+                    BUFFER_HANDLE xmlAsBuffer = BUFFER_create((const unsigned char*)s, strlen(s));
+                    if (xmlAsBuffer == NULL)
+                    {
+                        LogError("failed to BUFFER_create");
+                        result = BLOB_ERROR;
+                    }
+                    else
+                    {
+                        if (HTTPAPIEX_ExecuteRequest(httpApiExHandle, HTTPAPI_REQUEST_PUT, STRING_c_str(blockListRelativePath), NULL, xmlAsBuffer, context->httpStatus, NULL, context->httpResponse) != HTTPAPIEX_OK)
+                        {
+                            /*Codes_SRS_BLOB_01_017: [ If the block list request fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_HTTP_ERROR. ]*/
+                            LogError("unable to HTTPAPIEX_ExecuteRequest");
+                            result = BLOB_HTTP_ERROR;
+                        }
+                        else
+                        {
+                            /*Codes_SRS_BLOB_01_018: [ Otherwise Blob_UploadMultipleBlocksFromSasUri shall succeed and return BLOB_OK. ]*/
+                            result = BLOB_OK;
+                        }
+                        BUFFER_delete(xmlAsBuffer);
+                    }
+                }
+                STRING_delete(blockListRelativePath);
+            }
+        }
+        STRING_delete(xml);
+    }
+    return result;
+}
+
+BLOB_RESULT Blob_UploadMultipleBlocksFromSasUri(const char* SASURI, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source, size_t parallelism, size_t blockRetries, unsigned int* httpStatus, BUFFER_HANDLE httpResponse)
+{
+    BLOB_RESULT result;
+    const char* hostnameBegin;
+    const char* hostnameEnd;
+    /*Codes_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    if ((SASURI == NULL) || (source == NULL) || (httpStatus == NULL) || (parallelism == 0) ||
+        ((source->readCallback == NULL) && (source->size > 0)))
+    {
+        LogError("invalid arg const char* SASURI=%p, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source=%p, size_t parallelism=%zu, unsigned int* httpStatus=%p", SASURI, source, parallelism, httpStatus);
+        result = BLOB_INVALID_ARG;
+    }
+    /*Codes_SRS_BLOB_01_002: [ If the size of source is bigger than 50000*4*1024*1024 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    else if (source->size > (uint64_t)MAX_BLOCK_COUNT * IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE)
+    {
+        LogError("size too big (%llu)", (unsigned long long)source->size);
+        result = BLOB_INVALID_ARG;
+    }
+    /*Codes_SRS_BLOB_01_003: [ If the hostname cannot be determined from SASURI then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+    else if (((hostnameBegin = strstr(SASURI, "://")) == NULL) ||
+        ((hostnameEnd = strchr(hostnameBegin + 3, '/')) == NULL))
+    {
+        LogError("hostname cannot be determined");
+        result = BLOB_INVALID_ARG;
+    }
+    else
+    {
+        size_t hostnameSize;
+        char* hostname;
+        hostnameBegin += 3; /*have to skip 3 characters which are "://"*/
+        hostnameSize = hostnameEnd - hostnameBegin;
+        if ((hostname = (char*)malloc(hostnameSize + 1)) == NULL)
+        {
+            /*Codes_SRS_BLOB_01_014: [ If any other operation fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+            LogError("oom - out of memory");
+            result = BLOB_ERROR;
+        }
+        else
+        {
+            HTTPAPIEX_HANDLE httpApiExHandle;
+            (void)memcpy(hostname, hostnameBegin, hostnameSize);
+            hostname[hostnameSize] = '\0';
+
+            /*Codes_SRS_BLOB_01_004: [ Blob_UploadMultipleBlocksFromSasUri shall create an HTTPAPIEX_HANDLE to the hostname, used by the calling thread for its blocks and for the block list. ]*/
+            if ((httpApiExHandle = HTTPAPIEX_Create(hostname)) == NULL)
+            {
+                /*Codes_SRS_BLOB_01_014: [ If any other operation fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+                LogError("unable to create a HTTPAPIEX_HANDLE");
+                result = BLOB_ERROR;
+            }
+            else
+            {
+                BLOB_UPLOAD_CONTEXT context;
+                size_t threadCount = 0;
+                THREAD_HANDLE* threads = NULL;
+
+                context.hostname = hostname;
+                context.relativePath = hostnameEnd;
+                context.source = source;
+                context.blockCount = (unsigned int)((source->size + IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE - 1) / IOTHUB_CLIENT_FILE_UPLOAD_BLOCK_SIZE);
+                context.blockRetries = blockRetries;
+                context.lock = NULL;
+                context.nextBlockId = 0;
+                context.isStopped = 0;
+                context.result = BLOB_OK;
+                context.httpStatus = httpStatus;
+                context.httpResponse = httpResponse;
+
+                /*Codes_SRS_BLOB_01_005: [ When parallelism and the number of blocks are both bigger than 1, Blob_UploadMultipleBlocksFromSasUri shall start up to parallelism - 1 threads that upload blocks alongside the calling thread. ]*/
+                /*not being able to start them only makes the upload slower, so those failures are not errors*/
+                if ((parallelism > 1) && (context.blockCount > 1))
+                {
+                    size_t wantedThreads = ((parallelism < context.blockCount) ? parallelism : context.blockCount) - 1;
+                    if ((context.lock = Lock_Init()) == NULL)
+                    {
+                        LogError("unable to Lock_Init, uploading blocks one at a time");
+                    }
+                    else if ((threads = (THREAD_HANDLE*)malloc(wantedThreads * sizeof(THREAD_HANDLE))) == NULL)
+                    {
+                        LogError("unable to malloc, uploading blocks one at a time");
+                    }
+                    else
+                    {
+                        while ((threadCount < wantedThreads) &&
+                            (ThreadAPI_Create(&threads[threadCount], uploadBlocksThread, &context) == THREADAPI_OK))
+                        {
+                            threadCount++;
+                        }
+                    }
+                }
+
+                uploadBlocks(&context, httpApiExHandle);
+
+                while (threadCount > 0)
+                {
+                    int notUsed;
+                    threadCount--;
+                    if (ThreadAPI_Join(threads[threadCount], &notUsed) != THREADAPI_OK)
+                    {
+                        LogError("unable to ThreadAPI_Join");
+                    }
+                }
+                free(threads);
+                if (context.lock != NULL)
+                {
+                    (void)Lock_Deinit(context.lock);
+                }
+
+                if (context.isStopped)
+                {
+                    result = context.result;
+                }
+                else
+                {
+                    result = putBlockList(&context, httpApiExHandle);
+                }
+                HTTPAPIEX_Destroy(httpApiExHandle);
+            }
+            free(hostname);
+        }
+    }
+    return result;
+}
@@ -7,57 +7,28 @@
 
 #include <signal.h>
 #include <stddef.h>
+#include <string.h>
+#include <limits.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iothub_client.h"
 #include "iothub_client_ll.h"
 #include "iothub_client_private.h"
+#include "iothub_client_options.h"
 #include "iothubtransport.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 
-struct IOTHUB_QUEUE_CONTEXT_TAG;
+#define WORKER_DEFAULT_IDLE_WAIT_MS 10
 
-typedef struct IOTHUB_CLIENT_INSTANCE_TAG
-{
-    IOTHUB_CLIENT_LL_HANDLE IoTHubClientLLHandle;
-    TRANSPORT_HANDLE TransportHandle;
-    THREAD_HANDLE ThreadHandle;
-    LOCK_HANDLE LockHandle;
-    sig_atomic_t StopThread;
-#ifndef DONT_USE_UPLOADTOBLOB
-    SINGLYLINKEDLIST_HANDLE savedDataToBeCleaned; /*list containing UPLOADTOBLOB_SAVED_DATA*/
-#endif
-    int created_with_transport_handle;
-    VECTOR_HANDLE saved_user_callback_list;
-    IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback;
-    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK event_confirm_callback;
-    IOTHUB_CLIENT_REPORTED_STATE_CALLBACK reported_state_callback;
-    IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connection_status_callback;
-    IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK device_method_callback;
-    IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback;
-    struct IOTHUB_QUEUE_CONTEXT_TAG* devicetwin_user_context;
-    struct IOTHUB_QUEUE_CONTEXT_TAG* connection_status_user_context;
-    struct IOTHUB_QUEUE_CONTEXT_TAG* message_user_context;
-} IOTHUB_CLIENT_INSTANCE;
+/*number of user callbacks that can be queued without allocating, must be a power of 2*/
+#define USER_CALLBACK_RING_SIZE 32
 
-#ifndef DONT_USE_UPLOADTOBLOB
-typedef struct UPLOADTOBLOB_SAVED_DATA_TAG
-{
-    unsigned char* source;
-    size_t size;
-    char* destinationFileName;
-    IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK iotHubClientFileUploadCallback;
-    void* context;
-    THREAD_HANDLE uploadingThreadHandle;
-    IOTHUB_CLIENT_HANDLE iotHubClientHandle;
-    LOCK_HANDLE lockGarbage;
-    int canBeGarbageCollected; /*flag indicating that the UPLOADTOBLOB_SAVED_DATA structure can be freed because the thread deadling with it finished*/
-}UPLOADTOBLOB_SAVED_DATA;
-#endif
+struct IOTHUB_QUEUE_CONTEXT_TAG;
 
 #define USER_CALLBACK_TYPE_VALUES   \
     CALLBACK_TYPE_DEVICE_TWIN,      \
@@ -73,7 +44,6 @@ DEFINE_ENUM_STRINGS(USER_CALLBACK_TYPE, USER_CALLBACK_TYPE_VALUES)
 typedef struct DEVICE_TWIN_CALLBACK_INFO_TAG
 {
     DEVICE_TWIN_UPDATE_STATE update_state;
-    unsigned char* payLoad;
     size_t size;
 } DEVICE_TWIN_CALLBACK_INFO;
 
@@ -95,8 +65,7 @@ typedef struct CONNECTION_STATUS_CALLBACK_INFO_TAG
 
 typedef struct METHOD_CALLBACK_INFO_TAG
 {
-    STRING_HANDLE method_name;
-    BUFFER_HANDLE payload;
+    size_t payload_size;
     METHOD_HANDLE method_id;
 } METHOD_CALLBACK_INFO;
 
@@ -104,6 +73,8 @@ typedef struct USER_CALLBACK_INFO_TAG
 {
     USER_CALLBACK_TYPE type;
     void* userContextCallback;
+    unsigned char* data; /*the device twin payload or the method name followed by the method payload*/
+    size_t data_size; /*bytes allocated at data, kept across uses of a ring slot*/
     union IOTHUB_CALLBACK
     {
         DEVICE_TWIN_CALLBACK_INFO dev_twin_cb_info;
@@ -115,6 +86,69 @@ typedef struct USER_CALLBACK_INFO_TAG
     } iothub_callback;
 } USER_CALLBACK_INFO;
 
+/*the callbacks a consumer took from the ring (slots [begin, end)) and from the overflow list*/
+typedef struct USER_CALLBACK_BATCH_TAG
+{
+    size_t begin;
+    size_t end;
+    VECTOR_HANDLE overflow;
+} USER_CALLBACK_BATCH;
+
+typedef struct IOTHUB_CLIENT_INSTANCE_TAG
+{
+    IOTHUB_CLIENT_LL_HANDLE IoTHubClientLLHandle;
+    TRANSPORT_HANDLE TransportHandle;
+    THREAD_HANDLE ThreadHandle;
+    LOCK_HANDLE LockHandle;
+    sig_atomic_t StopThread;
+    COND_HANDLE WorkCondition; /*signaled whenever the worker thread has something to do, only used when the transport is not shared*/
+    int WorkSignaled;
+    unsigned int WorkerIdleWaitMs;
+    size_t WakeupCount;
+    size_t DoWorkCount;
+#ifndef DONT_USE_UPLOADTOBLOB
+    SINGLYLINKEDLIST_HANDLE savedDataToBeCleaned; /*list containing UPLOADTOBLOB_SAVED_DATA*/
+#endif
+    int created_with_transport_handle;
+    THREAD_HANDLE DispatchThreadHandle;
+    COND_HANDLE DispatchCondition; /*signaled whenever a user callback is queued, only used when user callbacks have their own thread*/
+    bool UseDispatchThread;
+    /*user callbacks are produced by IoTHubClient_LL calls, always with LockHandle held. They go to the ring while it has room and
+    nothing waits in saved_user_callback_list, so that callbacks are dispatched in the order they were produced*/
+    USER_CALLBACK_INFO callback_ring[USER_CALLBACK_RING_SIZE];
+    size_t callback_produced;
+    size_t callback_consumed;
+    size_t callback_overflow_count;
+    size_t callback_queued_count;
+    VECTOR_HANDLE saved_user_callback_list;
+    IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK event_confirm_callback;
+    IOTHUB_CLIENT_REPORTED_STATE_CALLBACK reported_state_callback;
+    IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connection_status_callback;
+    IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK device_method_callback;
+    IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback;
+    struct IOTHUB_QUEUE_CONTEXT_TAG* devicetwin_user_context;
+    struct IOTHUB_QUEUE_CONTEXT_TAG* connection_status_user_context;
+    struct IOTHUB_QUEUE_CONTEXT_TAG* message_user_context;
+} IOTHUB_CLIENT_INSTANCE;
+
+#ifndef DONT_USE_UPLOADTOBLOB
+typedef struct UPLOADTOBLOB_SAVED_DATA_TAG
+{
+    unsigned char* source;
+    size_t size;
+    int isMultipleBlocks; /*when set, blockSource describes what to upload instead of source and size*/
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE blockSource;
+    char* destinationFileName;
+    IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK iotHubClientFileUploadCallback;
+    void* context;
+    THREAD_HANDLE uploadingThreadHandle;
+    IOTHUB_CLIENT_HANDLE iotHubClientHandle;
+    LOCK_HANDLE lockGarbage;
+    int canBeGarbageCollected; /*flag indicating that the UPLOADTOBLOB_SAVED_DATA structure can be freed because the thread deadling with it finished*/
+}UPLOADTOBLOB_SAVED_DATA;
+#endif
+
 typedef struct IOTHUB_QUEUE_CONTEXT_TAG
 {
     IOTHUB_CLIENT_INSTANCE* iotHubClientHandle;
@@ -173,6 +207,115 @@ static void garbageCollectorImpl(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
 }
 #endif
 
+/*this function shall be called with the lock held*/
+static void signal_dispatch_thread(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    if (iotHubClientInstance->DispatchCondition != NULL)
+    {
+        if (Condition_Post(iotHubClientInstance->DispatchCondition) != COND_OK)
+        {
+            LogError("Condition_Post failed");
+        }
+    }
+}
+
+/*copies first and second back to back at queued_cb->data, only allocating when the storage already there is too small*/
+static int store_user_callback_data(USER_CALLBACK_INFO* queued_cb, const unsigned char* first, size_t first_size, const unsigned char* second, size_t second_size)
+{
+    int result;
+    size_t needed_size = first_size + second_size;
+    if (needed_size > queued_cb->data_size)
+    {
+        unsigned char* data = (unsigned char*)realloc(queued_cb->data, needed_size);
+        if (data == NULL)
+        {
+            LogError("failure allocating %lu bytes for the user callback data", (unsigned long)needed_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            queued_cb->data = data;
+            queued_cb->data_size = needed_size;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        if (first_size > 0)
+        {
+            (void)memcpy(queued_cb->data, first, first_size);
+        }
+        if (second_size > 0)
+        {
+            (void)memcpy(queued_cb->data + first_size, second, second_size);
+        }
+    }
+    return result;
+}
+
+/*this function shall be called with the lock held*/
+static int queue_user_callback(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, const USER_CALLBACK_INFO* callback_info, const unsigned char* first, size_t first_size, const unsigned char* second, size_t second_size)
+{
+    int result;
+    USER_CALLBACK_INFO overflow_cb;
+    USER_CALLBACK_INFO* queued_cb;
+    /*Codes_SRS_IOTHUBCLIENT_01_064: [ User callbacks shall be queued in a ring of USER_CALLBACK_RING_SIZE preallocated slots whose data storage is reused. ]*/
+    /*Codes_SRS_IOTHUBCLIENT_01_065: [ If the ring is full, or if callbacks are already waiting in the overflow list, the callback shall be added to the overflow list. ]*/
+    bool use_ring = (iotHubClientInstance->callback_overflow_count == 0) &&
+        ((iotHubClientInstance->callback_produced - iotHubClientInstance->callback_consumed) < USER_CALLBACK_RING_SIZE);
+
+    if (use_ring)
+    {
+        queued_cb = &iotHubClientInstance->callback_ring[iotHubClientInstance->callback_produced & (USER_CALLBACK_RING_SIZE - 1)];
+    }
+    else
+    {
+        overflow_cb.data = NULL;
+        overflow_cb.data_size = 0;
+        queued_cb = &overflow_cb;
+    }
+    queued_cb->type = callback_info->type;
+    queued_cb->userContextCallback = callback_info->userContextCallback;
+    queued_cb->iothub_callback = callback_info->iothub_callback;
+
+    if (store_user_callback_data(queued_cb, first, first_size, second, second_size) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (use_ring)
+    {
+        iotHubClientInstance->callback_produced++;
+        result = 0;
+    }
+    else if (VECTOR_push_back(iotHubClientInstance->saved_user_callback_list, &overflow_cb, 1) != 0)
+    {
+        LogError("user callback overflow vector push failed.");
+        if (overflow_cb.data != NULL)
+        {
+            free(overflow_cb.data);
+        }
+        result = __FAILURE__;
+    }
+    else
+    {
+        iotHubClientInstance->callback_overflow_count++;
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        iotHubClientInstance->callback_queued_count++;
+        /*Codes_SRS_IOTHUBCLIENT_01_066: [ Queueing a user callback shall wake up the callback dispatch thread (if any) by calling Condition_Post. ]*/
+        signal_dispatch_thread(iotHubClientInstance);
+    }
+    return result;
+}
+
 static bool iothub_ll_message_callback(MESSAGE_CALLBACK_INFO* messageData, void* userContextCallback)
 {
     bool result;
@@ -188,13 +331,13 @@ static bool iothub_ll_message_callback(MESSAGE_CALLBACK_INFO* messageData, void*
         queue_cb_info.type = CALLBACK_TYPE_MESSAGE;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.message_cb_info = messageData;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) == 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, NULL, 0, NULL, 0) == 0)
         {
             result = true;
         }
         else
         {
-            LogError("message callback vector push failed.");
+            LogError("message callback queueing failed.");
             result = false;
         }
     }
@@ -213,25 +356,17 @@ static int iothub_ll_inbound_device_method_callback(const char* method_name, con
         queue_cb_info.type = CALLBACK_TYPE_DEVICE_METHOD;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.method_cb_info.method_id = method_id;
-        if ( (queue_cb_info.iothub_callback.method_cb_info.method_name = STRING_construct(method_name)) == NULL)
-        {
-            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_003: [ If a failure is encountered IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK shall return a non-NULL value. ]*/
-            LogError("Failure: STRING_construct");
-            result = __FAILURE__;
-        }
-        else if ((queue_cb_info.iothub_callback.method_cb_info.payload = BUFFER_create(payload, size)) == NULL)
+        queue_cb_info.iothub_callback.method_cb_info.payload_size = size;
+        if (method_name == NULL)
         {
-            STRING_delete(queue_cb_info.iothub_callback.method_cb_info.method_name);
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_003: [ If a failure is encountered IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK shall return a non-NULL value. ]*/
-            LogError("Failure: BUFFER_create");
+            LogError("Invalid parameter: method_name NULL");
             result = __FAILURE__;
         }
-        else if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        else if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, (const unsigned char*)method_name, strlen(method_name) + 1, payload, size) != 0)
         {
-            STRING_delete(queue_cb_info.iothub_callback.method_cb_info.method_name);
-            BUFFER_delete(queue_cb_info.iothub_callback.method_cb_info.payload);
             /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_003: [ If a failure is encountered IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK shall return a non-NULL value. ]*/
-            LogError("connection status callback vector push failed.");
+            LogError("device method callback queueing failed.");
             result = __FAILURE__;
         }
         else
@@ -260,9 +395,9 @@ static void iothub_ll_connection_status_callback(IOTHUB_CLIENT_CONNECTION_STATUS
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.connection_status_cb_info.status_reason = reason;
         queue_cb_info.iothub_callback.connection_status_cb_info.connection_status = result;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, NULL, 0, NULL, 0) != 0)
         {
-            LogError("connection status callback vector push failed.");
+            LogError("connection status callback queueing failed.");
         }
     }
 }
@@ -276,9 +411,9 @@ static void iothub_ll_event_confirm_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT r
         queue_cb_info.type = CALLBACK_TYPE_EVENT_CONFIRM;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.event_confirm_cb_info.confirm_result = result;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, NULL, 0, NULL, 0) != 0)
         {
-            LogError("event confirm callback vector push failed.");
+            LogError("event confirm callback queueing failed.");
         }
         free(queue_context);
     }
@@ -293,9 +428,9 @@ static void iothub_ll_reported_state_callback(int status_code, void* userContext
         queue_cb_info.type = CALLBACK_TYPE_REPORTED_STATE;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.reported_state_cb_info.status_code = status_code;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, NULL, 0, NULL, 0) != 0)
         {
-            LogError("reported state callback vector push failed.");
+            LogError("reported state callback queueing failed.");
         }
         free(queue_context);
     }
@@ -306,145 +441,250 @@ static void iothub_ll_device_twin_callback(DEVICE_TWIN_UPDATE_STATE update_state
     IOTHUB_QUEUE_CONTEXT* queue_context = (IOTHUB_QUEUE_CONTEXT*)userContextCallback;
     if (queue_context != NULL)
     {
-        int push_to_vector;
-
         USER_CALLBACK_INFO queue_cb_info;
+        size_t payload_size = (payLoad == NULL) ? 0 : size;
         queue_cb_info.type = CALLBACK_TYPE_DEVICE_TWIN;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.dev_twin_cb_info.update_state = update_state;
-        if (payLoad == NULL)
+        queue_cb_info.iothub_callback.dev_twin_cb_info.size = payload_size;
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, payLoad, payload_size, NULL, 0) != 0)
         {
-            queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad = NULL;
-            queue_cb_info.iothub_callback.dev_twin_cb_info.size = 0;
-            push_to_vector = 0;
+            LogError("device twin callback queueing failed.");
         }
-        else
-        {
-            queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad = (unsigned char*)malloc(size);
-            if (queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad == NULL)
+    }
+    else
+    {
+        LogError("device twin callback userContextCallback NULL");
+    }
+}
+
+/*this function shall be called with the lock held*/
+static void take_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_BATCH* call_backs)
+{
+    call_backs->begin = iotHubClientInstance->callback_consumed;
+    call_backs->end = iotHubClientInstance->callback_produced;
+    if (iotHubClientInstance->callback_overflow_count == 0)
+    {
+        call_backs->overflow = NULL;
+    }
+    else if ((call_backs->overflow = VECTOR_move(iotHubClientInstance->saved_user_callback_list)) == NULL)
+    {
+        /*the callbacks stay in the overflow list and are taken on the next pass*/
+        LogError("VECTOR_move failed");
+    }
+    else
+    {
+        iotHubClientInstance->callback_overflow_count = 0;
+    }
+}
+
+/*this function shall be called with the lock held, it gives the ring slots of dispatched callbacks back to the producer*/
+static void release_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_BATCH* call_backs)
+{
+    iotHubClientInstance->callback_consumed += call_backs->end - call_backs->begin;
+    call_backs->begin = call_backs->end;
+}
+
+static void dispatch_user_callback(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_INFO* queued_cb)
+{
+    switch (queued_cb->type)
+    {
+        case CALLBACK_TYPE_DEVICE_TWIN:
+            if (iotHubClientInstance->desired_state_callback)
             {
-                LogError("failure allocating payload in device twin callback.");
-                queue_cb_info.iothub_callback.dev_twin_cb_info.size = 0;
-                push_to_vector = __FAILURE__;
+                const unsigned char* payLoad = (queued_cb->iothub_callback.dev_twin_cb_info.size == 0) ? NULL : queued_cb->data;
+                iotHubClientInstance->desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
             }
-            else
+            break;
+        case CALLBACK_TYPE_EVENT_CONFIRM:
+            if (iotHubClientInstance->event_confirm_callback)
             {
-                (void)memcpy(queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad, payLoad, size);
-                queue_cb_info.iothub_callback.dev_twin_cb_info.size = size;
-                push_to_vector = 0;
+                iotHubClientInstance->event_confirm_callback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
             }
-        }
-        if (push_to_vector == 0)
+            break;
+        case CALLBACK_TYPE_REPORTED_STATE:
+            if (iotHubClientInstance->reported_state_callback)
+            {
+                iotHubClientInstance->reported_state_callback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_CONNECTION_STATUS:
+            if (iotHubClientInstance->connection_status_callback)
+            {
+                iotHubClientInstance->connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_DEVICE_METHOD:
+            if (iotHubClientInstance->device_method_callback)
+            {
+                const char* method_name = (const char*)queued_cb->data;
+                size_t payload_len = queued_cb->iothub_callback.method_cb_info.payload_size;
+                const unsigned char* payload = (payload_len == 0) ? NULL : queued_cb->data + strlen(method_name) + 1;
+                iotHubClientInstance->device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
+            }
+            break;
+        case CALLBACK_TYPE_MESSAGE:
+            if (iotHubClientInstance->message_callback)
+            {
+                IOTHUBMESSAGE_DISPOSITION_RESULT disposition = iotHubClientInstance->message_callback(queued_cb->iothub_callback.message_cb_info->messageHandle, queued_cb->userContextCallback);
+                IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
+
+                if (Lock(handle->LockHandle) == LOCK_OK)
+                {
+                    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendMessageDisposition(handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_cb_info, disposition);
+                    if (result != IOTHUB_CLIENT_OK)
+                    {
+                        LogError("IoTHubClient_LL_Send_Message_Disposition failed");
+                    }
+                    (void)Unlock(handle->LockHandle);
+                }
+                else
+                {
+                    LogError("Lock failed");
+                }
+            }
+            break;
+        default:
+            LogError("Invalid callback type '%s'", ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
+            break;
+    }
+}
+
+/*this function is called without the lock, the ring slots in call_backs are not touched by the producer until they are released*/
+static size_t dispatch_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_BATCH* call_backs)
+{
+    size_t callbacks_length = call_backs->end - call_backs->begin;
+    size_t index;
+
+    /*Codes_SRS_IOTHUBCLIENT_01_067: [ User callbacks shall be dispatched in the order they were queued, the ones in the ring first and then the ones in the overflow list. ]*/
+    for (index = call_backs->begin; index != call_backs->end; index++)
+    {
+        dispatch_user_callback(iotHubClientInstance, &iotHubClientInstance->callback_ring[index & (USER_CALLBACK_RING_SIZE - 1)]);
+    }
+
+    if (call_backs->overflow != NULL)
+    {
+        size_t overflow_length = VECTOR_size(call_backs->overflow);
+        for (index = 0; index < overflow_length; index++)
         {
-            if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+            USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)VECTOR_element(call_backs->overflow, index);
+            if (queued_cb == NULL)
             {
-                if (queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad != NULL)
+                LogError("VECTOR_element at index %zd is NULL.", index);
+            }
+            else
+            {
+                dispatch_user_callback(iotHubClientInstance, queued_cb);
+                if (queued_cb->data != NULL)
                 {
-                    free(queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad);
+                    free(queued_cb->data);
                 }
-                LogError("device twin callback userContextCallback vector push failed.");
             }
         }
+        VECTOR_destroy(call_backs->overflow);
+        call_backs->overflow = NULL;
+        callbacks_length += overflow_length;
     }
-    else
+    return callbacks_length;
+}
+
+/*called by IoTHubClient_Destroy for the callbacks nobody dispatched*/
+static void discard_user_callback(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, USER_CALLBACK_INFO* queued_cb)
+{
+    /*the event confirmations are still owed to the user, the other callbacks go away with the client*/
+    if ((queued_cb->type == CALLBACK_TYPE_EVENT_CONFIRM) && (iotHubClientInstance->event_confirm_callback != NULL))
     {
-        LogError("device twin callback userContextCallback NULL");
+        iotHubClientInstance->event_confirm_callback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
     }
 }
 
-static void dispatch_user_callbacks(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, VECTOR_HANDLE call_backs)
+/*this function shall be called with the lock held*/
+static void signal_worker_thread(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
 {
-    size_t callbacks_length = VECTOR_size(call_backs);
-    size_t index;
-    for (index = 0; index < callbacks_length; index++)
+    iotHubClientInstance->WorkSignaled = 1;
+    if (iotHubClientInstance->TransportHandle != NULL)
     {
-        USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)VECTOR_element(call_backs, index);
-        if (queued_cb == NULL)
+        /*Codes_SRS_IOTHUBCLIENT_01_084: [ If the transport connection is shared, waking up the worker thread shall be done by calling IoTHubTransport_SignalWorkerThread. ]*/
+        IoTHubTransport_SignalWorkerThread(iotHubClientInstance->TransportHandle);
+    }
+    else if (iotHubClientInstance->WorkCondition != NULL)
+    {
+        if (Condition_Post(iotHubClientInstance->WorkCondition) != COND_OK)
         {
-            LogError("VECTOR_element at index %zd is NULL.", index);
+            LogError("Condition_Post failed");
         }
-        else
-        {
-            switch (queued_cb->type)
-            {
-                case CALLBACK_TYPE_DEVICE_TWIN:
-                    if (iotHubClientInstance->desired_state_callback)
-                    {
-                        iotHubClientInstance->desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, queued_cb->iothub_callback.dev_twin_cb_info.payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
-                    }
-                    if (queued_cb->iothub_callback.dev_twin_cb_info.payLoad)
-                    {
-                        free(queued_cb->iothub_callback.dev_twin_cb_info.payLoad);
-                    }
-                    break;
-                case CALLBACK_TYPE_EVENT_CONFIRM:
-                    if (iotHubClientInstance->event_confirm_callback)
-                    {
-                        iotHubClientInstance->event_confirm_callback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_REPORTED_STATE:
-                    if (iotHubClientInstance->reported_state_callback)
-                    {
-                        iotHubClientInstance->reported_state_callback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_CONNECTION_STATUS:
-                    if (iotHubClientInstance->connection_status_callback)
-                    {
-                        iotHubClientInstance->connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
-                    }
-                    break;
-                case CALLBACK_TYPE_DEVICE_METHOD:
-                    if (iotHubClientInstance->device_method_callback)
-                    {
-                        const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
-                        const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
-                        size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
-                        iotHubClientInstance->device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
+    }
+}
 
-                        BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
-                        STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
-                    }
-                    break;
-                case CALLBACK_TYPE_MESSAGE:
-                    if (iotHubClientInstance->message_callback)
-                    {
-                        IOTHUBMESSAGE_DISPOSITION_RESULT disposition = iotHubClientInstance->message_callback(queued_cb->iothub_callback.message_cb_info->messageHandle, queued_cb->userContextCallback);
-                        IOTHUB_CLIENT_HANDLE handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
+/*this function shall be called with the lock held, it returns the wait to give to Condition_Wait (0 waits until the worker is signaled) or -1 when the worker shall not wait at all*/
+static int get_worker_wait_time(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, size_t last_callback_count)
+{
+    int result;
+    tickcounter_ms_t wait_ms;
 
-                        if (Lock(handle->LockHandle) == LOCK_OK)
-                        {
-                            IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendMessageDisposition(handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_cb_info, disposition);
-                            if (result != IOTHUB_CLIENT_OK)
-                            {
-                                LogError("IoTHubClient_LL_Send_Message_Disposition failed");
-                            }
-                            (void)Unlock(handle->LockHandle);
-                        }
-                        else
-                        {
-                            LogError("Lock failed");
-                        }
-                    }
-                    break;
-                default:
-                    LogError("Invalid callback type '%s'", ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
-                    break;
-            }
+    /*a pass that produced user callbacks may have left more received data for the transport, so the next pass starts right away*/
+    if (last_callback_count > 0)
+    {
+        result = -1;
+    }
+    else if (IoTHubClient_LL_GetWorkWaitTime(iotHubClientInstance->IoTHubClientLLHandle, iotHubClientInstance->WorkerIdleWaitMs, &wait_ms) != IOTHUB_CLIENT_OK)
+    {
+        LogError("unable to get the wait time of the LL client, using the idle wait time");
+        result = (int)iotHubClientInstance->WorkerIdleWaitMs;
+    }
+    else if (wait_ms == IOTHUB_CLIENT_LL_NO_WORK_DEADLINE)
+    {
+#ifndef DONT_USE_UPLOADTOBLOB
+        /*finished uploads are only joined by the worker*/
+        if (singlylinkedlist_get_head_item(iotHubClientInstance->savedDataToBeCleaned) != NULL)
+        {
+            result = (int)iotHubClientInstance->WorkerIdleWaitMs;
+        }
+        else
+#endif
+        {
+            result = 0;
         }
     }
-    VECTOR_destroy(call_backs);
+    else if (wait_ms == 0)
+    {
+        result = -1;
+    }
+    else
+    {
+        result = (wait_ms > INT_MAX) ? INT_MAX : (int)wait_ms;
+    }
+    return result;
 }
 
 static int ScheduleWork_Thread(void* threadArgument)
 {
     IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)threadArgument;
+    size_t last_callback_count = 0;
+    USER_CALLBACK_BATCH call_backs;
+    call_backs.begin = 0;
+    call_backs.end = 0;
+    call_backs.overflow = NULL;
 
     while (1)
     {
         if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
         {
+            release_user_callbacks(iotHubClientInstance, &call_backs);
+
+            /*Codes_SRS_IOTHUBCLIENT_01_037: [ The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every time it is signaled that there is work to be done or when the wait period expires. ]*/
+            /*Codes_SRS_IOTHUBCLIENT_01_044: [ The wait period shall be the one given by IoTHubClient_LL_GetWorkWaitTime with the idle wait period as the transport poll period. The thread shall not wait when the last pass produced user callbacks or when that wait is 0, and shall wait until it is signaled when IoTHubClient_LL_GetWorkWaitTime returns IOTHUB_CLIENT_LL_NO_WORK_DEADLINE. ]*/
+            if (!iotHubClientInstance->StopThread && !iotHubClientInstance->WorkSignaled)
+            {
+                int wait_time = get_worker_wait_time(iotHubClientInstance, last_callback_count);
+                if (wait_time >= 0)
+                {
+                    (void)Condition_Wait(iotHubClientInstance->WorkCondition, iotHubClientInstance->LockHandle, wait_time);
+                }
+            }
+            iotHubClientInstance->WorkSignaled = 0;
+            iotHubClientInstance->WakeupCount++;
+
             /*Codes_SRS_IOTHUBCLIENT_01_038: [ The thread shall exit when IoTHubClient_Destroy is called. ]*/
             if (iotHubClientInstance->StopThread)
             {
@@ -453,53 +693,151 @@ static int ScheduleWork_Thread(void* threadArgument)
             }
             else
             {
-                /* Codes_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every 1 ms.] */
+                size_t queued_count = iotHubClientInstance->callback_queued_count;
+
                 /* Codes_SRS_IOTHUBCLIENT_01_039: [All calls to IoTHubClient_LL_DoWork shall be protected by the lock created in IotHubClient_Create.] */
                 IoTHubClient_LL_DoWork(iotHubClientInstance->IoTHubClientLLHandle);
+                iotHubClientInstance->DoWorkCount++;
 
 #ifndef DONT_USE_UPLOADTOBLOB
                 garbageCollectorImpl(iotHubClientInstance);
 #endif
-                VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
-                (void)Unlock(iotHubClientInstance->LockHandle);
-                if (call_backs == NULL)
+                if (iotHubClientInstance->UseDispatchThread)
                 {
-                    LogError("VECTOR_move failed");
+                    /*the callbacks belong to the dispatch thread, they still count as traffic*/
+                    last_callback_count = iotHubClientInstance->callback_queued_count - queued_count;
+                    (void)Unlock(iotHubClientInstance->LockHandle);
                 }
                 else
                 {
-                    dispatch_user_callbacks(iotHubClientInstance, call_backs);
+                    take_user_callbacks(iotHubClientInstance, &call_backs);
+                    (void)Unlock(iotHubClientInstance->LockHandle);
+                    last_callback_count = dispatch_user_callbacks(iotHubClientInstance, &call_backs);
                 }
             }
         }
         else
         {
             /*Codes_SRS_IOTHUBCLIENT_01_040: [If acquiring the lock fails, IoTHubClient_LL_DoWork shall not be called.]*/
-            /*no code, shall retry*/
+            /*shall retry*/
+            (void)ThreadAPI_Sleep(1);
         }
-        (void)ThreadAPI_Sleep(1);
     }
 
     return 0;
 }
 
+static int CallbackDispatch_Thread(void* threadArgument)
+{
+    IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)threadArgument;
+    USER_CALLBACK_BATCH call_backs;
+    call_backs.begin = 0;
+    call_backs.end = 0;
+    call_backs.overflow = NULL;
+
+    while (1)
+    {
+        if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
+        {
+            release_user_callbacks(iotHubClientInstance, &call_backs);
+
+            /*Codes_SRS_IOTHUBCLIENT_01_070: [ The callback dispatch thread shall wait on its condition until a user callback is queued, then dispatch the queued callbacks without holding the lock. ]*/
+            if (!iotHubClientInstance->StopThread &&
+                (iotHubClientInstance->callback_produced == iotHubClientInstance->callback_consumed) &&
+                (iotHubClientInstance->callback_overflow_count == 0))
+            {
+                (void)Condition_Wait(iotHubClientInstance->DispatchCondition, iotHubClientInstance->LockHandle, 0);
+            }
+
+            /*Codes_SRS_IOTHUBCLIENT_01_071: [ The callback dispatch thread shall exit when IoTHubClient_Destroy is called. ]*/
+            if (iotHubClientInstance->StopThread)
+            {
+                (void)Unlock(iotHubClientInstance->LockHandle);
+                break;
+            }
+            else
+            {
+                take_user_callbacks(iotHubClientInstance, &call_backs);
+                (void)Unlock(iotHubClientInstance->LockHandle);
+                (void)dispatch_user_callbacks(iotHubClientInstance, &call_backs);
+            }
+        }
+        else
+        {
+            /*shall retry*/
+            (void)ThreadAPI_Sleep(1);
+        }
+    }
+
+    return 0;
+}
+
+/*this function shall be called with the lock held*/
+static IOTHUB_CLIENT_RESULT StartDispatchThreadIfNeeded(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if ((!iotHubClientInstance->UseDispatchThread) || (iotHubClientInstance->DispatchThreadHandle != NULL))
+    {
+        result = IOTHUB_CLIENT_OK;
+    }
+    /*Codes_SRS_IOTHUBCLIENT_01_069: [ Before starting the callback dispatch thread a condition shall be created by calling Condition_Init. ]*/
+    else if ((iotHubClientInstance->DispatchCondition == NULL) &&
+        ((iotHubClientInstance->DispatchCondition = Condition_Init()) == NULL))
+    {
+        LogError("Condition_Init failed");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        iotHubClientInstance->StopThread = 0;
+        /*Codes_SRS_IOTHUBCLIENT_01_068: [ If OPTION_CALLBACK_DISPATCH_THREAD was set to true, the callback dispatch thread shall be started by calling ThreadAPI_Create before the worker thread is started. ]*/
+        if (ThreadAPI_Create(&iotHubClientInstance->DispatchThreadHandle, CallbackDispatch_Thread, iotHubClientInstance) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Create failed");
+            iotHubClientInstance->DispatchThreadHandle = NULL;
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+    return result;
+}
+
 static IOTHUB_CLIENT_RESULT StartWorkerThreadIfNeeded(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance)
 {
     IOTHUB_CLIENT_RESULT result;
-    if (iotHubClientInstance->TransportHandle == NULL)
+    if (StartDispatchThreadIfNeeded(iotHubClientInstance) != IOTHUB_CLIENT_OK)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (iotHubClientInstance->TransportHandle == NULL)
     {
         if (iotHubClientInstance->ThreadHandle == NULL)
         {
             iotHubClientInstance->StopThread = 0;
-            if (ThreadAPI_Create(&iotHubClientInstance->ThreadHandle, ScheduleWork_Thread, iotHubClientInstance) != THREADAPI_OK)
+            /*Codes_SRS_IOTHUBCLIENT_01_043: [ Before starting the worker thread a condition shall be created by calling Condition_Init. The worker thread waits on it between calls to IoTHubClient_LL_DoWork. ]*/
+            if ((iotHubClientInstance->WorkCondition == NULL) &&
+                ((iotHubClientInstance->WorkCondition = Condition_Init()) == NULL))
             {
-                LogError("ThreadAPI_Create failed");
-                iotHubClientInstance->ThreadHandle = NULL;
+                LogError("Condition_Init failed");
                 result = IOTHUB_CLIENT_ERROR;
             }
             else
             {
-                result = IOTHUB_CLIENT_OK;
+                /*the first pass of the thread does not wait*/
+                iotHubClientInstance->WorkSignaled = 1;
+                if (ThreadAPI_Create(&iotHubClientInstance->ThreadHandle, ScheduleWork_Thread, iotHubClientInstance) != THREADAPI_OK)
+                {
+                    LogError("ThreadAPI_Create failed");
+                    iotHubClientInstance->ThreadHandle = NULL;
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
             }
         }
         else
@@ -648,6 +986,19 @@ static IOTHUB_CLIENT_INSTANCE* create_iothub_instance(const IOTHUB_CLIENT_CONFIG
                 else
                 {
                     result->ThreadHandle = NULL;
+                    result->WorkCondition = NULL;
+                    result->DispatchThreadHandle = NULL;
+                    result->DispatchCondition = NULL;
+                    result->UseDispatchThread = false;
+                    (void)memset(result->callback_ring, 0, sizeof(result->callback_ring));
+                    result->callback_produced = 0;
+                    result->callback_consumed = 0;
+                    result->callback_overflow_count = 0;
+                    result->callback_queued_count = 0;
+                    result->WorkSignaled = 0;
+                    result->WorkerIdleWaitMs = WORKER_DEFAULT_IDLE_WAIT_MS;
+                    result->WakeupCount = 0;
+                    result->DoWorkCount = 0;
                     result->desired_state_callback = NULL;
                     result->event_confirm_callback = NULL;
                     result->reported_state_callback = NULL;
@@ -724,7 +1075,8 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
     if (iotHubClientHandle != NULL)
     {
         bool okToJoin;
-        size_t vector_size;       
+        size_t vector_size;
+        size_t index;
 
         IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
 
@@ -745,6 +1097,8 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
         if (iotHubClientInstance->ThreadHandle != NULL)
         {
             iotHubClientInstance->StopThread = 1;
+            /*Codes_SRS_IOTHUBCLIENT_01_045: [ IoTHubClient_Destroy shall wake up the worker thread by calling Condition_Post. ]*/
+            signal_worker_thread(iotHubClientInstance);
             okToJoin = true;
         }
         else
@@ -752,6 +1106,13 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             okToJoin = false;
         }
 
+        if (iotHubClientInstance->DispatchThreadHandle != NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_072: [ IoTHubClient_Destroy shall signal the callback dispatch thread (if any) to end by calling Condition_Post. ]*/
+            iotHubClientInstance->StopThread = 1;
+            signal_dispatch_thread(iotHubClientInstance);
+        }
+
         if (iotHubClientInstance->TransportHandle != NULL)
         {
             /*Codes_SRS_IOTHUBCLIENT_01_007: [ The thread created as part of executing IoTHubClient_SendEventAsync or IoTHubClient_SetNotificationMessageCallback shall be joined. ]*/
@@ -793,36 +1154,56 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
             }
         }
 
+        if (iotHubClientInstance->DispatchThreadHandle != NULL)
+        {
+            int res;
+            /*Codes_SRS_IOTHUBCLIENT_01_073: [ IoTHubClient_Destroy shall join the callback dispatch thread. ]*/
+            if (ThreadAPI_Join(iotHubClientInstance->DispatchThreadHandle, &res) != THREADAPI_OK)
+            {
+                LogError("ThreadAPI_Join failed");
+            }
+        }
+
+        /*Codes_SRS_IOTHUBCLIENT_01_074: [ IoTHubClient_Destroy shall call the event confirmation callback of every event confirmation that was queued and not dispatched. ]*/
+        for (index = iotHubClientInstance->callback_consumed; index != iotHubClientInstance->callback_produced; index++)
+        {
+            discard_user_callback(iotHubClientInstance, &iotHubClientInstance->callback_ring[index & (USER_CALLBACK_RING_SIZE - 1)]);
+        }
+
         vector_size = VECTOR_size(iotHubClientInstance->saved_user_callback_list);
-        size_t index = 0;
         for (index = 0; index < vector_size; index++)
         {
             USER_CALLBACK_INFO* queue_cb_info = (USER_CALLBACK_INFO*)VECTOR_element(iotHubClientInstance->saved_user_callback_list, index);
             if (queue_cb_info != NULL)
             {
-                if (queue_cb_info->type == CALLBACK_TYPE_DEVICE_METHOD)
-                {
-                    STRING_delete(queue_cb_info->iothub_callback.method_cb_info.method_name);
-                    BUFFER_delete(queue_cb_info->iothub_callback.method_cb_info.payload);
-                }
-                else if (queue_cb_info->type == CALLBACK_TYPE_DEVICE_TWIN)
-                {
-                    if (queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad != NULL)
-                    {
-                        free(queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad);
-                    }
-                }
-                else if (queue_cb_info->type == CALLBACK_TYPE_EVENT_CONFIRM)
+                discard_user_callback(iotHubClientInstance, queue_cb_info);
+                if (queue_cb_info->data != NULL)
                 {
-                    if (iotHubClientInstance->event_confirm_callback)
-                    {
-                        iotHubClientInstance->event_confirm_callback(queue_cb_info->iothub_callback.event_confirm_cb_info.confirm_result, queue_cb_info->userContextCallback);
-                    }
+                    free(queue_cb_info->data);
                 }
             }
         }
         VECTOR_destroy(iotHubClientInstance->saved_user_callback_list);
 
+        for (index = 0; index < USER_CALLBACK_RING_SIZE; index++)
+        {
+            if (iotHubClientInstance->callback_ring[index].data != NULL)
+            {
+                free(iotHubClientInstance->callback_ring[index].data);
+            }
+        }
+
+        if (iotHubClientInstance->WorkCondition != NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_046: [ IoTHubClient_Destroy shall free the condition created when the worker thread was started by calling Condition_Deinit. ]*/
+            Condition_Deinit(iotHubClientInstance->WorkCondition);
+        }
+
+        if (iotHubClientInstance->DispatchCondition != NULL)
+        {
+            Condition_Deinit(iotHubClientInstance->DispatchCondition);
+        }
+
         if (iotHubClientInstance->TransportHandle == NULL)
         {
             /* Codes_SRS_IOTHUBCLIENT_01_032: [If the lock was allocated in IoTHubClient_Create, it shall be also freed..] */
@@ -844,7 +1225,24 @@ void IoTHubClient_Destroy(IOTHUB_CLIENT_HANDLE iotHubClientHandle)
     }
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+static IOTHUB_CLIENT_RESULT send_event_to_ll(IOTHUB_CLIENT_LL_HANDLE iotHubClientLLHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool take_ownership)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (take_ownership)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_01_057: [ IoTHubClient_SendEventAsync_Move shall call IoTHubClient_LL_SendEventAsync_Move instead of IoTHubClient_LL_SendEventAsync. ]*/
+        result = IoTHubClient_LL_SendEventAsync_Move(iotHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+    else
+    {
+        result = IoTHubClient_LL_SendEventAsync(iotHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+    }
+
+    return result;
+}
+
+static IOTHUB_CLIENT_RESULT send_event_async(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool take_ownership)
 {
     IOTHUB_CLIENT_RESULT result;
 
@@ -882,7 +1280,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
             {
                 if (iotHubClientInstance->created_with_transport_handle != 0 || eventConfirmationCallback == NULL)
                 {
-                    result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback);
+                    result = send_event_to_ll(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, take_ownership);
                 }
                 else
                 {
@@ -899,7 +1297,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
                         queue_context->userContextCallback = userContextCallback;
                         /* Codes_SRS_IOTHUBCLIENT_01_012: [IoTHubClient_SendEventAsync shall call IoTHubClient_LL_SendEventAsync, while passing the IoTHubClient_LL handle created by IoTHubClient_Create and the parameters eventMessageHandle, eventConfirmationCallback and userContextCallback.] */
                         /* Codes_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
-                        result = IoTHubClient_LL_SendEventAsync(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context);
+                        result = send_event_to_ll(iotHubClientInstance->IoTHubClientLLHandle, eventMessageHandle, iothub_ll_event_confirm_callback, queue_context, take_ownership);
                         if (result != IOTHUB_CLIENT_OK)
                         {
                             LogError("IoTHubClient_LL_SendEventAsync failed");
@@ -909,6 +1307,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
                 }
             }
 
+            if (result == IOTHUB_CLIENT_OK)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_01_047: [ If IoTHubClient_LL_SendEventAsync succeeds, IoTHubClient_SendEventAsync shall wake up the worker thread by calling Condition_Post. ]*/
+                signal_worker_thread(iotHubClientInstance);
+            }
+
             /* Codes_SRS_IOTHUBCLIENT_01_025: [IoTHubClient_SendEventAsync shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
@@ -917,6 +1321,18 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClie
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, false);
+}
+
+/*Codes_SRS_IOTHUBCLIENT_01_058: [ IoTHubClient_SendEventAsync_Move shall behave as IoTHubClient_SendEventAsync, except that on success the ownership of eventMessageHandle is transferred to the client. ]*/
+/*Codes_SRS_IOTHUBCLIENT_01_059: [ If IoTHubClient_SendEventAsync_Move fails, the caller shall keep the ownership of eventMessageHandle. ]*/
+IOTHUB_CLIENT_RESULT IoTHubClient_SendEventAsync_Move(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, true);
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -952,6 +1368,39 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetSendStatus(IOTHUB_CLIENT_HANDLE iotHubClien
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_GetSendQueueSize(IOTHUB_CLIENT_HANDLE iotHubClientHandle, size_t* queueSize)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_01_060: [ If iotHubClientHandle is NULL, IoTHubClient_GetSendQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /*Codes_SRS_IOTHUBCLIENT_01_061: [ IoTHubClient_GetSendQueueSize shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_062: [ If acquiring the lock fails, IoTHubClient_GetSendQueueSize shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_063: [ IoTHubClient_GetSendQueueSize shall return the result of calling IoTHubClient_LL_GetSendQueueSize with the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter queueSize. ]*/
+            result = IoTHubClient_LL_GetSendQueueSize(iotHubClientInstance->IoTHubClientLLHandle, queueSize);
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetMessageCallback(IOTHUB_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1025,6 +1474,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetMessageCallback(IOTHUB_CLIENT_HANDLE iotHub
                         }
                     }
                 }
+
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_085: [ If setting the message callback succeeds, IoTHubClient_SetMessageCallback shall wake up the worker thread by calling Condition_Post. ]*/
+                    signal_worker_thread(iotHubClientInstance);
+                }
             }
 
             /* Codes_SRS_IOTHUBCLIENT_01_027: [IoTHubClient_SetMessageCallback shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
@@ -1231,6 +1686,41 @@ IOTHUB_CLIENT_RESULT IoTHubClient_GetLastMessageReceiveTime(IOTHUB_CLIENT_HANDLE
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_GetWorkerStatistics(IOTHUB_CLIENT_HANDLE iotHubClientHandle, size_t* wakeupCount, size_t* doWorkCount)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    /*Codes_SRS_IOTHUBCLIENT_01_053: [ If iotHubClientHandle, wakeupCount or doWorkCount is NULL, IoTHubClient_GetWorkerStatistics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if ((iotHubClientHandle == NULL) || (wakeupCount == NULL) || (doWorkCount == NULL))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("invalid arg (NULL)");
+    }
+    else
+    {
+        IOTHUB_CLIENT_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle;
+
+        /*Codes_SRS_IOTHUBCLIENT_01_054: [ IoTHubClient_GetWorkerStatistics shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_055: [ If acquiring the lock fails, IoTHubClient_GetWorkerStatistics shall return IOTHUB_CLIENT_ERROR. ]*/
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_056: [ IoTHubClient_GetWorkerStatistics shall return in wakeupCount the number of times the worker thread woke up and in doWorkCount the number of times it called IoTHubClient_LL_DoWork. ]*/
+            *wakeupCount = iotHubClientInstance->WakeupCount;
+            *doWorkCount = iotHubClientInstance->DoWorkCount;
+            result = IOTHUB_CLIENT_OK;
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1259,11 +1749,47 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetOption(IOTHUB_CLIENT_HANDLE iotHubClientHan
         }
         else
         {
-            /*Codes_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
-            result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value);
-            if (result != IOTHUB_CLIENT_OK)
+            if (strcmp(optionName, OPTION_WORKER_IDLE_WAIT_TIME) == 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_01_050: [ If optionName is OPTION_WORKER_IDLE_WAIT_TIME then value shall be interpreted as a pointer to an unsigned int holding the number of milliseconds the worker thread waits between two calls to IoTHubClient_LL_DoWork while something is expected from the transport. ]*/
+                unsigned int idle_wait_ms = *(const unsigned int*)value;
+                if ((idle_wait_ms == 0) || (idle_wait_ms > INT_MAX))
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_051: [ If the idle wait time is 0 or greater than INT_MAX then IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+                    result = IOTHUB_CLIENT_INVALID_ARG;
+                    LogError("invalid value for %s: %u", OPTION_WORKER_IDLE_WAIT_TIME, idle_wait_ms);
+                }
+                else
+                {
+                    iotHubClientInstance->WorkerIdleWaitMs = idle_wait_ms;
+                    /*Codes_SRS_IOTHUBCLIENT_01_052: [ IoTHubClient_SetOption shall wake up the worker thread so the new idle wait time is applied immediately. ]*/
+                    signal_worker_thread(iotHubClientInstance);
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else if (strcmp(optionName, OPTION_CALLBACK_DISPATCH_THREAD) == 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_01_075: [ If optionName is OPTION_CALLBACK_DISPATCH_THREAD then value shall be interpreted as a pointer to a bool; when true, user callbacks shall be called from a dedicated thread instead of the thread calling IoTHubClient_LL_DoWork. ]*/
+                if ((iotHubClientInstance->ThreadHandle != NULL) || (iotHubClientInstance->DispatchThreadHandle != NULL))
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_076: [ If the worker thread or the callback dispatch thread is already running, IoTHubClient_SetOption shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("%s cannot be changed once the client threads are running", OPTION_CALLBACK_DISPATCH_THREAD);
+                }
+                else
+                {
+                    iotHubClientInstance->UseDispatchThread = *(const bool*)value;
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else
             {
-                LogError("IoTHubClient_LL_SetOption failed");
+                /*Codes_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
+                result = IoTHubClient_LL_SetOption(iotHubClientInstance->IoTHubClientLLHandle, optionName, value);
+                if (result != IOTHUB_CLIENT_OK)
+                {
+                    LogError("IoTHubClient_LL_SetOption failed");
+                }
             }
 
             (void)Unlock(iotHubClientInstance->LockHandle);
@@ -1341,6 +1867,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetDeviceTwinCallback(IOTHUB_CLIENT_HANDLE iot
                         }
                     }
                 }
+
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_086: [ If IoTHubClient_LL_SetDeviceTwinCallback succeeds, IoTHubClient_SetDeviceTwinCallback shall wake up the worker thread by calling Condition_Post. ]*/
+                    signal_worker_thread(iotHubClientInstance);
+                }
             }
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
@@ -1414,6 +1946,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SendReportedState(IOTHUB_CLIENT_HANDLE iotHubC
                     }
                 }
             }
+
+            if (result == IOTHUB_CLIENT_OK)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_01_048: [ If IoTHubClient_LL_SendReportedState succeeds, IoTHubClient_SendReportedState shall wake up the worker thread by calling Condition_Post. ]*/
+                signal_worker_thread(iotHubClientInstance);
+            }
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
     }
@@ -1459,6 +1997,11 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetDeviceMethodCallback(IOTHUB_CLIENT_HANDLE i
                 {
                     LogError("IoTHubClient_LL_SetDeviceMethodCallback failed");
                 }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_087: [ If IoTHubClient_LL_SetDeviceMethodCallback succeeds, IoTHubClient_SetDeviceMethodCallback shall wake up the worker thread by calling Condition_Post. ]*/
+                    signal_worker_thread(iotHubClientInstance);
+                }
             }
 
             (void)Unlock(iotHubClientInstance->LockHandle);
@@ -1530,6 +2073,12 @@ IOTHUB_CLIENT_RESULT IoTHubClient_SetDeviceMethodCallback_Ex(IOTHUB_CLIENT_HANDL
                         }
                     }
                 }
+
+                if (result == IOTHUB_CLIENT_OK)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_01_088: [ If IoTHubClient_LL_SetDeviceMethodCallback_Ex succeeds, IoTHubClient_SetDeviceMethodCallback_Ex shall wake up the worker thread by calling Condition_Post. ]*/
+                    signal_worker_thread(iotHubClientInstance);
+                }
             }
 
             (void)Unlock(iotHubClientInstance->LockHandle);
@@ -1566,6 +2115,11 @@ IOTHUB_CLIENT_RESULT IoTHubClient_DeviceMethodResponse(IOTHUB_CLIENT_HANDLE iotH
             {
                 LogError("IoTHubClient_LL_DeviceMethodResponse failed");
             }
+            else
+            {
+                /*Codes_SRS_IOTHUBCLIENT_01_049: [ If IoTHubClient_LL_DeviceMethodResponse succeeds, IoTHubClient_DeviceMethodResponse shall wake up the worker thread by calling Condition_Post. ]*/
+                signal_worker_thread(iotHubClientInstance);
+            }
             (void)Unlock(iotHubClientInstance->LockHandle);
         }
     }
@@ -1579,10 +2133,21 @@ static int uploadingThread(void *data)
 
     /*it so happens that IoTHubClient_LL_UploadToBlob is thread-safe because there's no saved state in the handle and there are no globals, so no need to protect it*/
     /*not having it protected means multiple simultaneous uploads can happen*/
-    /*Codes_SRS_IOTHUBCLIENT_02_054: [ The thread shall call IoTHubClient_LL_UploadToBlob passing the information packed in the structure. ]*/
-    if (IoTHubClient_LL_UploadToBlob(savedData->iotHubClientHandle->IoTHubClientLLHandle, savedData->destinationFileName, savedData->source, savedData->size) != IOTHUB_CLIENT_OK)
+    IOTHUB_CLIENT_RESULT uploadResult;
+    if (savedData->isMultipleBlocks)
     {
-        LogError("unable to IoTHubClient_LL_UploadToBlob");
+        /*Codes_SRS_IOTHUBCLIENT_01_083: [ The thread shall call IoTHubClient_LL_UploadMultipleBlocksToBlob passing the information packed in the structure. ]*/
+        uploadResult = IoTHubClient_LL_UploadMultipleBlocksToBlob(savedData->iotHubClientHandle->IoTHubClientLLHandle, savedData->destinationFileName, &savedData->blockSource);
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_02_054: [ The thread shall call IoTHubClient_LL_UploadToBlob passing the information packed in the structure. ]*/
+        uploadResult = IoTHubClient_LL_UploadToBlob(savedData->iotHubClientHandle->IoTHubClientLLHandle, savedData->destinationFileName, savedData->source, savedData->size);
+    }
+
+    if (uploadResult != IOTHUB_CLIENT_OK)
+    {
+        LogError("unable to upload to blob");
         /*call the callback*/
         if (savedData->iotHubClientFileUploadCallback != NULL)
         {
@@ -1619,6 +2184,79 @@ static int uploadingThread(void *data)
 #endif
 
 #ifndef DONT_USE_UPLOADTOBLOB
+/*takes ownership of savedData: starts the thread uploading it or frees it*/
+static IOTHUB_CLIENT_RESULT startUploadingThread(IOTHUB_CLIENT_INSTANCE* iotHubClientInstance, UPLOADTOBLOB_SAVED_DATA* savedData)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK) /*locking because the next statement is changing blobThreadsToBeJoined*/
+    {
+        LogError("unable to lock");
+        free(savedData->source);
+        free(savedData->destinationFileName);
+        free(savedData);
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        if ((result = StartWorkerThreadIfNeeded(iotHubClientInstance)) != IOTHUB_CLIENT_OK)
+        {
+            free(savedData->source);
+            free(savedData->destinationFileName);
+            free(savedData);
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not start worker thread");
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBCLIENT_02_058: [ IoTHubClient_UploadToBlobAsync shall add the structure to the list of structures that need to be cleaned once file upload finishes. ]*/
+            LIST_ITEM_HANDLE item = singlylinkedlist_add(iotHubClientInstance->savedDataToBeCleaned, savedData);
+            if (item == NULL)
+            {
+                LogError("unable to singlylinkedlist_add");
+                free(savedData->source);
+                free(savedData->destinationFileName);
+                free(savedData);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                savedData->iotHubClientHandle = iotHubClientInstance;
+                savedData->canBeGarbageCollected = 0;
+                if ((savedData->lockGarbage = Lock_Init()) == NULL)
+                {
+                    (void)singlylinkedlist_remove(iotHubClientInstance->savedDataToBeCleaned, item);
+                    free(savedData->source);
+                    free(savedData->destinationFileName);
+                    free(savedData);
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("unable to Lock_Init");
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_02_052: [ IoTHubClient_UploadToBlobAsync shall spawn a thread passing the structure build in SRS IOTHUBCLIENT 02 051 as thread data.]*/
+                    if (ThreadAPI_Create(&savedData->uploadingThreadHandle, uploadingThread, savedData) != THREADAPI_OK)
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_02_053: [ If copying to the structure or spawning the thread fails, then IoTHubClient_UploadToBlobAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                        LogError("unablet to ThreadAPI_Create");
+                        (void)Lock_Deinit(savedData->lockGarbage);
+                        (void)singlylinkedlist_remove(iotHubClientInstance->savedDataToBeCleaned, item);
+                        free(savedData->source);
+                        free(savedData->destinationFileName);
+                        free(savedData);
+                        result = IOTHUB_CLIENT_ERROR;
+                    }
+                    else
+                    {
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                }
+            }
+        }
+        (void)Unlock(iotHubClientInstance->LockHandle);
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_UploadToBlobAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* destinationFileName, const unsigned char* source, size_t size, IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK iotHubClientFileUploadCallback, void* context)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1663,6 +2301,7 @@ IOTHUB_CLIENT_RESULT IoTHubClient_UploadToBlobAsync(IOTHUB_CLIENT_HANDLE iotHubC
             else
             {
                 savedData->size = size;
+                savedData->isMultipleBlocks = 0;
                 int sourceCloned;
                 if (size == 0)
                 {
@@ -1698,76 +2337,60 @@ IOTHUB_CLIENT_RESULT IoTHubClient_UploadToBlobAsync(IOTHUB_CLIENT_HANDLE iotHubC
                     savedData->context = context;
                     (void)memcpy(savedData->source, source, size);
 
-                    if (Lock(iotHubClientHandleData->LockHandle) != LOCK_OK) /*locking because the next statement is changing blobThreadsToBeJoined*/
-                    {
-                        LogError("unable to lock");
-                        free(savedData->source);
-                        free(savedData->destinationFileName);
-                        free(savedData);
-                        result = IOTHUB_CLIENT_ERROR;
-                    }
-                    else
-                    {
-                        if ((result = StartWorkerThreadIfNeeded(iotHubClientHandleData)) != IOTHUB_CLIENT_OK)
-                        {
-                            free(savedData->source);
-                            free(savedData->destinationFileName);
-                            free(savedData);
-                            result = IOTHUB_CLIENT_ERROR;
-                            LogError("Could not start worker thread");
-                        }
-                        else
-                        {
-                            /*Codes_SRS_IOTHUBCLIENT_02_058: [ IoTHubClient_UploadToBlobAsync shall add the structure to the list of structures that need to be cleaned once file upload finishes. ]*/
-                            LIST_ITEM_HANDLE item = singlylinkedlist_add(iotHubClientHandleData->savedDataToBeCleaned, savedData);
-                            if (item == NULL)
-                            {
-                                LogError("unable to singlylinkedlist_add");
-                                free(savedData->source);
-                                free(savedData->destinationFileName);
-                                free(savedData);
-                                result = IOTHUB_CLIENT_ERROR;
-                            }
-                            else
-                            {
-                                savedData->iotHubClientHandle = iotHubClientHandle;
-                                savedData->canBeGarbageCollected = 0;
-                                if ((savedData->lockGarbage = Lock_Init()) == NULL)
-                                {
-                                    (void)singlylinkedlist_remove(iotHubClientHandleData->savedDataToBeCleaned, item);
-                                    free(savedData->source);
-                                    free(savedData->destinationFileName);
-                                    free(savedData);
-                                    result = IOTHUB_CLIENT_ERROR;
-                                    LogError("unable to Lock_Init");
-                                }
-                                else
-                                {
-                                    /*Codes_SRS_IOTHUBCLIENT_02_052: [ IoTHubClient_UploadToBlobAsync shall spawn a thread passing the structure build in SRS IOTHUBCLIENT 02 051 as thread data.]*/
-                                    if (ThreadAPI_Create(&savedData->uploadingThreadHandle, uploadingThread, savedData) != THREADAPI_OK)
-                                    {
-                                        /*Codes_SRS_IOTHUBCLIENT_02_053: [ If copying to the structure or spawning the thread fails, then IoTHubClient_UploadToBlobAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                        LogError("unablet to ThreadAPI_Create");
-                                        (void)Lock_Deinit(savedData->lockGarbage);
-                                        (void)singlylinkedlist_remove(iotHubClientHandleData->savedDataToBeCleaned, item);
-                                        free(savedData->source);
-                                        free(savedData->destinationFileName);
-                                        free(savedData);
-                                        result = IOTHUB_CLIENT_ERROR;
-                                    }
-                                    else
-                                    {
-                                        result = IOTHUB_CLIENT_OK;
-                                    }
-                                }
-                            }
-                        }
-                        (void)Unlock(iotHubClientHandleData->LockHandle);
-                    }
+                    result = startUploadingThread(iotHubClientHandleData, savedData);
                 }
             }
         }
     }
     return result;
 }
+
+IOTHUB_CLIENT_RESULT IoTHubClient_UploadMultipleBlocksToBlobAsync(IOTHUB_CLIENT_HANDLE iotHubClientHandle, const char* destinationFileName, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source, IOTHUB_CLIENT_FILE_UPLOAD_CALLBACK iotHubClientFileUploadCallback, void* context)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_01_080: [ If iotHubClientHandle, destinationFileName or source is NULL then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (
+        (iotHubClientHandle == NULL) ||
+        (destinationFileName == NULL) ||
+        (source == NULL)
+        )
+    {
+        LogError("invalid parameters IOTHUB_CLIENT_HANDLE iotHubClientHandle = %p , const char* destinationFileName = %s, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source = %p",
+            iotHubClientHandle,
+            destinationFileName,
+            source
+        );
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_01_081: [ IoTHubClient_UploadMultipleBlocksToBlobAsync shall copy destinationFileName, the content of source (not the data it points to), iotHubClientFileUploadCallback and context into a structure and spawn a thread uploading it, the same way IoTHubClient_UploadToBlobAsync does. ]*/
+        UPLOADTOBLOB_SAVED_DATA *savedData = (UPLOADTOBLOB_SAVED_DATA *)malloc(sizeof(UPLOADTOBLOB_SAVED_DATA));
+        if (savedData == NULL)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_082: [ If copying to the structure or spawning the thread fails, then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            LogError("unable to malloc - oom");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else if (mallocAndStrcpy_s((char**)&savedData->destinationFileName, destinationFileName) != 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_01_082: [ If copying to the structure or spawning the thread fails, then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+            LogError("unable to mallocAndStrcpy_s");
+            free(savedData);
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            savedData->source = NULL;
+            savedData->size = 0;
+            savedData->isMultipleBlocks = 1;
+            savedData->blockSource = *source;
+            savedData->iotHubClientFileUploadCallback = iotHubClientFileUploadCallback;
+            savedData->context = context;
+
+            result = startUploadingThread((IOTHUB_CLIENT_INSTANCE*)iotHubClientHandle, savedData);
+        }
+    }
+    return result;
+}
 #endif /*DONT_USE_UPLOADTOBLOB*/
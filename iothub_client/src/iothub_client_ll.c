@@ -14,15 +14,24 @@
 #include "iothub_client_ll.h"
 #include "iothub_transport_ll.h"
 #include "iothub_client_private.h"
+#include "iothub_client_options.h"
+#include "iothub_client_outbound_store.h"
+#include "iothub_client_slab_pool.h"
 #include "iothub_client_version.h"
+#include "parson.h"
 #include <stdint.h>
 
 #ifndef DONT_USE_UPLOADTOBLOB
 #include "iothub_client_ll_uploadtoblob.h"
 #endif
 
+#ifdef USE_COMPRESSION
+#include "iothub_client_payload_compressor.h"
+#endif
+
 #define LOG_ERROR_RESULT LogError("result = %s", ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
 #define INDEFINITE_TIME ((time_t)(-1))
+#define DEFAULT_OUTBOUND_STORE_WINDOW 128
 
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
 DEFINE_ENUM_STRINGS(IOTHUB_CLIENT_CONFIRMATION_RESULT, IOTHUB_CLIENT_CONFIRMATION_RESULT_VALUES);
@@ -58,6 +67,9 @@ typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
     time_t lastMessageReceiveTime;
     TICK_COUNTER_HANDLE tickCounter; /*shared tickcounter used to track message timeouts in waitingToSend list*/
     tickcounter_ms_t currentMessageTimeout;
+    size_t pendingEventCount; /*number of events accepted by SendEventAsync that have not been completed yet*/
+    tickcounter_ms_t latestMessageTimeout; /*largest ms_timesOutAfter handed out so far, 0 if no message was ever given a timeout*/
+    bool messageTimeoutsOrdered; /*true while the ms_timesOutAfter values in waitingToSend are non-decreasing from head to tail*/
     uint64_t current_device_twin_timeout;
     IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK deviceTwinCallback;
     void* deviceTwinContextCallback;
@@ -71,6 +83,25 @@ typedef struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
 #endif
     uint32_t data_msg_id;
     bool complete_twin_update_encountered;
+    tickcounter_ms_t reportedStateCoalescingInterval; /*0 means every reported state is published as it was given*/
+    tickcounter_ms_t lastReportedStateFlush;
+    OUTBOUND_STORE_HANDLE outboundStore; /*NULL unless OPTION_OUTBOUND_STORE_PATH was set*/
+    size_t outboundStoreSegmentSize;
+    size_t outboundStoreWindow; /*most events of outboundStore held in memory, the others are read back as these complete*/
+    size_t outboundStoreLoadedCount; /*events of outboundStore held in memory, queued or handed to the transport*/
+    DLIST_ENTRY outboundStoreSpilled; /*records of the events of this instance that are only on disk, in the order they were sent*/
+    bool outboundStoreHasBacklog; /*some events of outboundStore are only on disk*/
+    uint64_t outboundStoreCursor; /*sequence of the next record to read from outboundStore*/
+    uint64_t outboundStoreFirstSequence; /*sequence of the first event appended by this instance, the ones before were left by a previous instance*/
+    size_t outboundStoreReadCount;
+    unsigned char* outboundStoreBuffer; /*reused to serialize the events written to outboundStore*/
+    size_t outboundStoreBufferSize;
+    SLAB_POOL_HANDLE messagePool; /*NULL unless OPTION_MESSAGE_POOL_SIZE was set, then the IOTHUB_MESSAGE_LIST records come from it*/
+    IOTHUB_MESSAGE_POOL_HANDLE clonePool; /*set with messagePool, the events given to IoTHubClient_LL_SendEventAsync are cloned from it*/
+#ifdef USE_COMPRESSION
+    PAYLOAD_COMPRESSOR_HANDLE payloadCompressor; /*NULL unless OPTION_COMPRESSION_THRESHOLD or OPTION_COMPRESSION_DICTIONARY was set*/
+    size_t compressionThreshold;
+#endif
 }IOTHUB_CLIENT_LL_HANDLE_DATA;
 
 static const char HOSTNAME_TOKEN[] = "HostName";
@@ -81,8 +112,42 @@ static const char DEVICEKEY_TOKEN[] = "SharedAccessKey";
 static const char DEVICESAS_TOKEN[] = "SharedAccessSignature";
 static const char PROTOCOL_GATEWAY_HOST[] = "GatewayHostName";
 
+static IOTHUB_MESSAGE_LIST* allocate_message_list_entry(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    IOTHUB_MESSAGE_LIST* result;
+    if (handleData->messagePool != NULL)
+    {
+        result = (IOTHUB_MESSAGE_LIST*)slab_pool_alloc(handleData->messagePool);
+    }
+    else
+    {
+        result = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    }
+    return result;
+}
+
+static void free_message_list_entry(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    if (handleData->messagePool != NULL)
+    {
+        slab_pool_free(handleData->messagePool, entry);
+    }
+    else
+    {
+        free(entry);
+    }
+}
+
 static void device_twin_data_destroy(IOTHUB_DEVICE_TWIN* client_item)
 {
+    IOTHUB_DEVICE_TWIN* coalesced_item = client_item->coalesced_items;
+    while (coalesced_item != NULL)
+    {
+        IOTHUB_DEVICE_TWIN* next_item = coalesced_item->coalesced_items;
+        CONSTBUFFER_Destroy(coalesced_item->report_data_handle);
+        free(coalesced_item);
+        coalesced_item = next_item;
+    }
     CONSTBUFFER_Destroy(client_item->report_data_handle);
     free(client_item);
 }
@@ -125,6 +190,7 @@ static IOTHUB_DEVICE_TWIN* dev_twin_data_create(IOTHUB_CLIENT_LL_HANDLE_DATA* ha
             result->ms_timesOutAfter = 0;
             result->context = userContextCallback;
             result->reported_state_callback = reportedStateCallback;
+            result->coalesced_items = NULL;
         }
     }
     else
@@ -480,6 +546,7 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_Create(const IOTHUB_CLIENT_CONFIG* confi
                     /*Codes_SRS_IOTHUBCLIENT_LL_02_004: [Otherwise IoTHubClient_LL_Create shall initialize a new DLIST (further called "waitingToSend") containing records with fields of the following types: IOTHUB_MESSAGE_HANDLE, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, void*.]*/
                     IOTHUBTRANSPORT_CONFIG lowerLayerConfig;
                     DList_InitializeListHead(&(handleData->waitingToSend));
+                    DList_InitializeListHead(&(handleData->outboundStoreSpilled));
                     DList_InitializeListHead(&(handleData->iot_msg_queue));
                     DList_InitializeListHead(&(handleData->iot_ack_queue));
                     setTransportProtocol(handleData, (TRANSPORT_PROVIDER*)config->protocol());
@@ -540,7 +607,27 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_Create(const IOTHUB_CLIENT_CONFIG* confi
                             handleData->isSharedTransport = false;
                             /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                             handleData->currentMessageTimeout = 0;
+                            handleData->pendingEventCount = 0;
+                            handleData->latestMessageTimeout = 0;
+                            handleData->messageTimeoutsOrdered = true;
                             handleData->current_device_twin_timeout = 0;
+                            handleData->reportedStateCoalescingInterval = 0;
+                            handleData->lastReportedStateFlush = 0;
+                            handleData->outboundStore = NULL;
+                            handleData->outboundStoreSegmentSize = OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE;
+                            handleData->outboundStoreWindow = DEFAULT_OUTBOUND_STORE_WINDOW;
+                            handleData->outboundStoreLoadedCount = 0;
+                            handleData->outboundStoreHasBacklog = false;
+                            handleData->outboundStoreCursor = 0;
+                            handleData->outboundStoreFirstSequence = 0;
+                            handleData->outboundStoreBuffer = NULL;
+                            handleData->outboundStoreBufferSize = 0;
+                            handleData->messagePool = NULL;
+                            handleData->clonePool = NULL;
+#ifdef USE_COMPRESSION
+                            handleData->payloadCompressor = NULL;
+                            handleData->compressionThreshold = PAYLOAD_COMPRESSOR_DEFAULT_THRESHOLD;
+#endif
                             result = handleData;
                             /*Codes_SRS_IOTHUBCLIENT_LL_25_124: [ `IoTHubClient_LL_Create` shall set the default retry policy as Exponential backoff with jitter and if succeed and return a `non-NULL` handle. ]*/
                             if (IoTHubClient_LL_SetRetryPolicy(handleData, IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0) != IOTHUB_CLIENT_OK)
@@ -654,6 +741,7 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateWithTransport(const IOTHUB_CLIENT_
                         {
                             /*Codes_SRS_IOTHUBCLIENT_LL_17_004: [IoTHubClient_LL_CreateWithTransport shall initialize a new DLIST (further called "waitingToSend") containing records with fields of the following types: IOTHUB_MESSAGE_HANDLE, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, void*.]*/
                             DList_InitializeListHead(&(handleData->waitingToSend));
+                            DList_InitializeListHead(&(handleData->outboundStoreSpilled));
                             DList_InitializeListHead(&(handleData->iot_msg_queue));
                             DList_InitializeListHead(&(handleData->iot_ack_queue));
                             handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
@@ -693,7 +781,27 @@ IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateWithTransport(const IOTHUB_CLIENT_
                                 handleData->isSharedTransport = true;
                                 /*Codes_SRS_IOTHUBCLIENT_LL_02_042: [ By default, messages shall not timeout. ]*/
                                 handleData->currentMessageTimeout = 0;
+                                handleData->pendingEventCount = 0;
+                                handleData->latestMessageTimeout = 0;
+                                handleData->messageTimeoutsOrdered = true;
                                 handleData->current_device_twin_timeout = 0;
+                                handleData->reportedStateCoalescingInterval = 0;
+                                handleData->lastReportedStateFlush = 0;
+                                handleData->outboundStore = NULL;
+                                handleData->outboundStoreSegmentSize = OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE;
+                                handleData->outboundStoreWindow = DEFAULT_OUTBOUND_STORE_WINDOW;
+                                handleData->outboundStoreLoadedCount = 0;
+                                handleData->outboundStoreHasBacklog = false;
+                                handleData->outboundStoreCursor = 0;
+                                handleData->outboundStoreFirstSequence = 0;
+                                handleData->outboundStoreBuffer = NULL;
+                                handleData->outboundStoreBufferSize = 0;
+                                handleData->messagePool = NULL;
+                                handleData->clonePool = NULL;
+#ifdef USE_COMPRESSION
+                                handleData->payloadCompressor = NULL;
+                                handleData->compressionThreshold = PAYLOAD_COMPRESSOR_DEFAULT_THRESHOLD;
+#endif
                                 result = handleData;
                                 /*Codes_SRS_IOTHUBCLIENT_LL_25_125: [ `IoTHubClient_LL_CreateWithTransport` shall set the default retry policy as Exponential backoff with jitter and if succeed and return a `non-NULL` handle. ]*/
                                 if (IoTHubClient_LL_SetRetryPolicy(handleData, IOTHUB_CLIENT_RETRY_EXPONENTIAL_BACKOFF_WITH_JITTER, 0) != IOTHUB_CLIENT_OK)
@@ -740,7 +848,20 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
                 temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
             }
             IoTHubMessage_Destroy(temp->messageHandle);
-            free(temp);
+            free_message_list_entry(handleData, temp);
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_044: [ IoTHubClient_LL_Destroy shall complete the events that are only in the outbound store with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, they stay in the outbound store. ]*/
+        if (handleData->outboundStore != NULL)
+        {
+            while ((unsend = DList_RemoveHeadList(&(handleData->outboundStoreSpilled))) != &(handleData->outboundStoreSpilled))
+            {
+                IOTHUB_MESSAGE_LIST* temp = containingRecord(unsend, IOTHUB_MESSAGE_LIST, entry);
+                if (temp->callback != NULL)
+                {
+                    temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
+                }
+                free_message_list_entry(handleData, temp);
+            }
         }
 
         /* Codes_SRS_IOTHUBCLIENT_LL_07_007: [ IoTHubClient_LL_Destroy shall iterate the device twin queues and destroy any remaining items. ] */
@@ -755,11 +876,34 @@ void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
             device_twin_data_destroy(temp);
         }
 
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_019: [ IoTHubClient_LL_Destroy shall close the outbound store, the events it holds that were not released are sent by the next instance that opens it. ]*/
+        if (handleData->outboundStore != NULL)
+        {
+            outbound_store_close(handleData->outboundStore);
+        }
+        if (handleData->outboundStoreBuffer != NULL)
+        {
+            free(handleData->outboundStoreBuffer);
+        }
+#ifdef USE_COMPRESSION
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_032: [ IoTHubClient_LL_Destroy shall destroy the payload compressor. ]*/
+        if (handleData->payloadCompressor != NULL)
+        {
+            payload_compressor_destroy(handleData->payloadCompressor);
+        }
+#endif
+
         /*Codes_SRS_IOTHUBCLIENT_LL_17_011: [IoTHubClient_LL_Destroy  shall free the resources allocated by IoTHubClient (if any).] */
         tickcounter_destroy(handleData->tickCounter);
 #ifndef DONT_USE_UPLOADTOBLOB
         IoTHubClient_LL_UploadToBlob_Destroy(handleData->uploadToBlobHandle);
 #endif
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_026: [ IoTHubClient_LL_Destroy shall destroy the message pool after all the events have been completed. ]*/
+        if (handleData->messagePool != NULL)
+        {
+            slab_pool_destroy(handleData->messagePool);
+            IoTHubMessage_DestroyPool(handleData->clonePool);
+        }
         free(handleData);
     }
 }
@@ -786,261 +930,1105 @@ static int attach_ms_timesOutAfter(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOT
         else
         {
             newEntry->ms_timesOutAfter += handleData->currentMessageTimeout;
+            /*a smaller timeout set with IoTHubClient_LL_SetOption can make a message expire before the ones queued ahead of it*/
+            if (newEntry->ms_timesOutAfter < handleData->latestMessageTimeout)
+            {
+                handleData->messageTimeoutsOrdered = false;
+            }
+            else
+            {
+                handleData->latestMessageTimeout = newEntry->ms_timesOutAfter;
+            }
             result = 0;
         }
     }
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+/*an event in the outbound store is: content type (1) | body | message id | correlation id | property count (4) | name, value...
+where every field is a 4 byte little endian size followed by that many bytes. The strings keep their '\0' so they can be
+used in place when the event is read back, an absent id has a size of 0*/
+#define OUTBOUND_EVENT_SIZE_LENGTH  4
+
+static size_t get_outbound_string_size(const char* value)
 {
-    IOTHUB_CLIENT_RESULT result;
-    /*Codes_SRS_IOTHUBCLIENT_LL_02_011: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle or eventMessageHandle is NULL.]*/
-    if (
-        (iotHubClientHandle == NULL) ||
-        (eventMessageHandle == NULL) ||
-        /*Codes_SRS_IOTHUBCLIENT_LL_02_012: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter eventConfirmationCallback is NULL and userContextCallback is not NULL.] */
-        ((eventConfirmationCallback == NULL) && (userContextCallback != NULL))
-        )
+    return OUTBOUND_EVENT_SIZE_LENGTH + ((value == NULL) ? 0 : strlen(value) + 1);
+}
+
+static unsigned char* put_outbound_size(unsigned char* destination, size_t size)
+{
+    destination[0] = (unsigned char)(size & 0xFF);
+    destination[1] = (unsigned char)((size >> 8) & 0xFF);
+    destination[2] = (unsigned char)((size >> 16) & 0xFF);
+    destination[3] = (unsigned char)((size >> 24) & 0xFF);
+    return destination + OUTBOUND_EVENT_SIZE_LENGTH;
+}
+
+static unsigned char* put_outbound_field(unsigned char* destination, const void* source, size_t size)
+{
+    destination = put_outbound_size(destination, size);
+    if (size > 0)
     {
-        result = IOTHUB_CLIENT_INVALID_ARG;
-        LOG_ERROR_RESULT;
+        (void)memcpy(destination, source, size);
+    }
+    return destination + size;
+}
+
+static unsigned char* put_outbound_string(unsigned char* destination, const char* value)
+{
+    return put_outbound_field(destination, value, (value == NULL) ? 0 : strlen(value) + 1);
+}
+
+/*returns NULL when the size does not fit in what is left of the event*/
+static const unsigned char* get_outbound_size(const unsigned char* source, const unsigned char* end, size_t* size)
+{
+    const unsigned char* result;
+    if (end - source < OUTBOUND_EVENT_SIZE_LENGTH)
+    {
+        result = NULL;
     }
     else
     {
-        IOTHUB_MESSAGE_LIST *newEntry = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
-        if (newEntry == NULL)
-        {
-            result = IOTHUB_CLIENT_ERROR;
-            LOG_ERROR_RESULT;
-        }
-        else
-        {
-            IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-
-            if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
-            {
-                result = IOTHUB_CLIENT_ERROR;
-                LOG_ERROR_RESULT;
-                free(newEntry);
-            }
-            else
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                if ((newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle)) == NULL)
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
-                    result = IOTHUB_CLIENT_ERROR;
-                    free(newEntry);
-                    LOG_ERROR_RESULT;
-                }
-                else
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
-                    newEntry->callback = eventConfirmationCallback;
-                    newEntry->context = userContextCallback;
-                    DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
-                    result = IOTHUB_CLIENT_OK;
-                }
-            }
-        }
+        *size = (size_t)source[0] | ((size_t)source[1] << 8) | ((size_t)source[2] << 16) | ((size_t)source[3] << 24);
+        result = source + OUTBOUND_EVENT_SIZE_LENGTH;
     }
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
+/*returns NULL when the field does not fit in what is left of the event*/
+static const unsigned char* get_outbound_field(const unsigned char* source, const unsigned char* end, const unsigned char** value, size_t* size)
 {
-    IOTHUB_CLIENT_RESULT result;
-    if (iotHubClientHandle == NULL)
+    const unsigned char* result = get_outbound_size(source, end, size);
+    if ((result == NULL) || ((size_t)(end - result) < *size))
     {
-        /*Codes_SRS_IOTHUBCLIENT_LL_02_016: [IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.] */
-        LogError("Invalid argument - iotHubClientHandle is NULL");
-        result = IOTHUB_CLIENT_INVALID_ARG;
+        result = NULL;
     }
     else
     {
-        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-        if (messageCallback == NULL)
+        *value = result;
+        result += *size;
+    }
+    return result;
+}
+
+/*same as get_outbound_field, for a '\0' terminated string. An absent string is returned as NULL*/
+static const unsigned char* get_outbound_string(const unsigned char* source, const unsigned char* end, const char** value)
+{
+    const unsigned char* field = NULL;
+    size_t size;
+    const unsigned char* result = get_outbound_field(source, end, &field, &size);
+    if (result != NULL)
+    {
+        if (size == 0)
         {
-            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_NONE)
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_010: [If parameter messageCallback is NULL and the _SetMessageCallback had not been called to subscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("not currently set to accept or process incoming messages.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_ASYNC)
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_010: [If parameter messageCallback is NULL and the _SetMessageCallback had not been called to subscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallbackEx function.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_02_019: [If parameter messageCallback is NULL then IoTHubClient_LL_SetMessageCallback shall call the underlying layer's _Unsubscribe function and return IOTHUB_CLIENT_OK.] */
-                handleData->IoTHubTransport_Unsubscribe(handleData->deviceHandle);
-                handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
-                handleData->messageCallback.callbackSync = NULL;
-                handleData->messageCallback.callbackAsync = NULL;
-                handleData->messageCallback.messageUserContextCallback = NULL;
-                result = IOTHUB_CLIENT_OK;
-            }
+            *value = NULL;
+        }
+        else if (field[size - 1] != '\0')
+        {
+            result = NULL;
         }
         else
         {
-            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_ASYNC)
-            {
-                /* Codes_SRS_IOTHUBCLIENT_LL_10_011: [If parameter messageCallback is non-NULL and the _SetMessageCallbackEx had been used to susbscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallbackEx function before subscribing with MessageCallback.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else
-            {
-                if (handleData->IoTHubTransport_Subscribe(handleData->deviceHandle) == 0)
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_017: [If parameter messageCallback is non-NULL then IoTHubClient_LL_SetMessageCallback shall call the underlying layer's _Subscribe function.]*/
-                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_SYNC;
-                    handleData->messageCallback.callbackSync = messageCallback;
-                    handleData->messageCallback.messageUserContextCallback = userContextCallback;
-                    result = IOTHUB_CLIENT_OK;
-                }
-                else
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_02_018: [If the underlying layer's _Subscribe function fails, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR. Otherwise IoTHubClient_LL_SetMessageCallback shall succeed and return IOTHUB_CLIENT_OK.]*/
-                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
-                    handleData->messageCallback.callbackSync = NULL;
-                    handleData->messageCallback.callbackAsync = NULL;
-                    handleData->messageCallback.messageUserContextCallback = NULL;
-                    result = IOTHUB_CLIENT_ERROR;
-                }
-            }
+            *value = (const char*)field;
         }
     }
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallbackEx(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC_EX messageCallback, void* userContextCallback)
+/*serializes the event in handleData->outboundStoreBuffer*/
+static int serialize_outbound_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE messageHandle, size_t* size)
 {
-    IOTHUB_CLIENT_RESULT result;
-    if (iotHubClientHandle == NULL)
+    int result;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(messageHandle);
+    const unsigned char* body = NULL;
+    size_t bodySize = 0;
+    const char* const* keys;
+    const char* const* values;
+    size_t propertyCount;
+
+    if (contentType == IOTHUBMESSAGE_STRING)
     {
-        /*Codes_SRS_IOTHUBCLIENT_LL_10_021: [IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.]*/
-        LogError("Invalid argument - iotHubClientHandle is NULL");
-        result = IOTHUB_CLIENT_INVALID_ARG;
+        body = (const unsigned char*)IoTHubMessage_GetString(messageHandle);
+        bodySize = (body == NULL) ? 0 : strlen((const char*)body) + 1;
+    }
+
+    if (((contentType != IOTHUBMESSAGE_BYTEARRAY) && (contentType != IOTHUBMESSAGE_STRING)) ||
+        ((contentType == IOTHUBMESSAGE_BYTEARRAY) && (IoTHubMessage_GetByteArray(messageHandle, &body, &bodySize) != IOTHUB_MESSAGE_OK)) ||
+        (Map_GetInternals(IoTHubMessage_Properties(messageHandle), &keys, &values, &propertyCount) != MAP_OK))
+    {
+        LogError("unable to read the event to write it to the outbound store");
+        result = __FAILURE__;
     }
     else
     {
-        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-        if (messageCallback == NULL)
+        const char* messageId = IoTHubMessage_GetMessageId(messageHandle);
+        const char* correlationId = IoTHubMessage_GetCorrelationId(messageHandle);
+        size_t index;
+
+        *size = 1 + OUTBOUND_EVENT_SIZE_LENGTH + bodySize + get_outbound_string_size(messageId) + get_outbound_string_size(correlationId) + OUTBOUND_EVENT_SIZE_LENGTH;
+        for (index = 0; index < propertyCount; index++)
         {
-            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_NONE)
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_018: [If parameter messageCallback is NULL and IoTHubClient_LL_SetMessageCallbackEx had not been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("not currently set to accept or process incoming messages.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_SYNC)
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_019: [If parameter messageCallback is NULL and IoTHubClient_LL_SetMessageCallback had been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallback function.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else
+            *size += get_outbound_string_size(keys[index]) + get_outbound_string_size(values[index]);
+        }
+
+        if (*size > handleData->outboundStoreBufferSize)
+        {
+            unsigned char* buffer = (unsigned char*)realloc(handleData->outboundStoreBuffer, *size);
+            if (buffer != NULL)
             {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_023: [If parameter messageCallback is NULL then IoTHubClient_LL_SetMessageCallbackEx shall call the underlying layer's _Unsubscribe function and return IOTHUB_CLIENT_OK.] */ 
-                handleData->IoTHubTransport_Unsubscribe(handleData->deviceHandle);
-                handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
-                handleData->messageCallback.callbackSync = NULL;
-                handleData->messageCallback.callbackAsync = NULL;
-                handleData->messageCallback.messageUserContextCallback = NULL;
-                result = IOTHUB_CLIENT_OK;
+                handleData->outboundStoreBuffer = buffer;
+                handleData->outboundStoreBufferSize = *size;
             }
         }
+
+        if (*size > handleData->outboundStoreBufferSize)
+        {
+            LogError("unable to allocate %lu bytes to serialize the event", (unsigned long)*size);
+            result = __FAILURE__;
+        }
         else
         {
-            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_SYNC)
-            {
-                /*Codes_SRS_IOTHUBCLIENT_LL_10_020: [If parameter messageCallback is non-NULL, and IoTHubClient_LL_SetMessageCallback had been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
-                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_MessageCallbackEx function before subscribing with MessageCallback.");
-                result = IOTHUB_CLIENT_ERROR;
-            }
-            else
+            unsigned char* cursor = handleData->outboundStoreBuffer;
+            *cursor++ = (unsigned char)contentType;
+            cursor = put_outbound_field(cursor, body, bodySize);
+            cursor = put_outbound_string(cursor, messageId);
+            cursor = put_outbound_string(cursor, correlationId);
+            cursor = put_outbound_size(cursor, propertyCount);
+            for (index = 0; index < propertyCount; index++)
             {
-                if (handleData->IoTHubTransport_Subscribe(handleData->deviceHandle) == 0)
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_10_024: [If parameter messageCallback is non-NULL then IoTHubClient_LL_SetMessageCallbackEx shall call the underlying layer's _Subscribe function.]*/
-                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_ASYNC;
-                    handleData->messageCallback.callbackAsync = messageCallback;
-                    handleData->messageCallback.messageUserContextCallback = userContextCallback;
-                    result = IOTHUB_CLIENT_OK;
-                }
-                else
-                {
-                    /*Codes_SRS_IOTHUBCLIENT_LL_10_025: [If the underlying layer's _Subscribe function fails, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR. Otherwise IoTHubClient_LL_SetMessageCallbackEx shall succeed and return IOTHUB_CLIENT_OK.] */
-                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
-                    handleData->messageCallback.callbackSync = NULL;
-                    handleData->messageCallback.callbackAsync = NULL;
-                    handleData->messageCallback.messageUserContextCallback = NULL;
-                    result = IOTHUB_CLIENT_ERROR;
-                }
+                cursor = put_outbound_string(cursor, keys[index]);
+                cursor = put_outbound_string(cursor, values[index]);
             }
+            result = 0;
         }
     }
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendMessageDisposition(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, MESSAGE_CALLBACK_INFO* message_data, IOTHUBMESSAGE_DISPOSITION_RESULT disposition)
+static IOTHUB_MESSAGE_HANDLE deserialize_outbound_event(const unsigned char* data, size_t size)
 {
-    IOTHUB_CLIENT_RESULT result;
-    if ((iotHubClientHandle == NULL) || (message_data == NULL))
+    IOTHUB_MESSAGE_HANDLE result;
+    const unsigned char* end = data + size;
+    const unsigned char* cursor = data + 1;
+    const unsigned char* body = NULL;
+    size_t bodySize = 0;
+    const char* messageId = NULL;
+    const char* correlationId = NULL;
+    size_t propertyCount = 0;
+
+    if ((size < 1) ||
+        ((data[0] != IOTHUBMESSAGE_BYTEARRAY) && (data[0] != IOTHUBMESSAGE_STRING)) ||
+        ((cursor = get_outbound_field(cursor, end, &body, &bodySize)) == NULL) ||
+        ((data[0] == IOTHUBMESSAGE_STRING) && ((bodySize == 0) || (body[bodySize - 1] != '\0'))) ||
+        ((cursor = get_outbound_string(cursor, end, &messageId)) == NULL) ||
+        ((cursor = get_outbound_string(cursor, end, &correlationId)) == NULL) ||
+        ((cursor = get_outbound_size(cursor, end, &propertyCount)) == NULL))
     {
-        /*Codes_SRS_IOTHUBCLIENT_LL_10_026: [IoTHubClient_LL_SendMessageDisposition shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.]*/
-        LogError("Invalid argument handle=%p, message=%p", iotHubClientHandle, message_data);
-        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("the event read from the outbound store is malformed");
+        result = NULL;
+    }
+    else if ((result = (data[0] == IOTHUBMESSAGE_STRING) ? IoTHubMessage_CreateFromString((const char*)body) : IoTHubMessage_CreateFromByteArray(body, bodySize)) == NULL)
+    {
+        LogError("unable to create the event read from the outbound store");
     }
     else
     {
-        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
-        /*Codes_SRS_IOTHUBCLIENT_LL_10_027: [IoTHubClient_LL_SendMessageDisposition shall return the result from calling the underlying layer's _Send_Message_Disposition.]*/
-        result = handleData->IoTHubTransport_SendMessageDisposition(message_data, disposition);
+        MAP_HANDLE properties = IoTHubMessage_Properties(result);
+        bool isValid =
+            ((messageId == NULL) || (IoTHubMessage_SetMessageId(result, messageId) == IOTHUB_MESSAGE_OK)) &&
+            ((correlationId == NULL) || (IoTHubMessage_SetCorrelationId(result, correlationId) == IOTHUB_MESSAGE_OK));
+        size_t index;
+        for (index = 0; isValid && (index < propertyCount); index++)
+        {
+            const char* key = NULL;
+            const char* value = NULL;
+            isValid =
+                ((cursor = get_outbound_string(cursor, end, &key)) != NULL) &&
+                ((cursor = get_outbound_string(cursor, end, &value)) != NULL) &&
+                (key != NULL) && (value != NULL) &&
+                (Map_AddOrUpdate(properties, key, value) == MAP_OK);
+        }
+
+        if (!isValid)
+        {
+            LogError("unable to restore the event read from the outbound store");
+            IoTHubMessage_Destroy(result);
+            result = NULL;
+        }
     }
     return result;
 }
 
-static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+/*Codes_SRS_IOTHUBCLIENT_LL_01_016: [ Once an event kept in the outbound store completes with any result other than IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, it shall be released from the outbound store. ]*/
+/*Codes_SRS_IOTHUBCLIENT_LL_01_040: [ An event kept in the outbound store that completes with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY shall stay in the outbound store, to be sent again by the next instance that opens it. ]*/
+static void complete_outbound_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, const IOTHUB_MESSAGE_LIST* entry, IOTHUB_CLIENT_CONFIRMATION_RESULT result)
 {
-    tickcounter_ms_t nowTick;
+    if ((handleData->outboundStore != NULL) && (entry->outboundStoreSequence != 0))
+    {
+        /*the events that are only on disk have no message*/
+        if ((entry->messageHandle != NULL) && (handleData->outboundStoreLoadedCount > 0))
+        {
+            handleData->outboundStoreLoadedCount--;
+        }
+
+        /*the application already got the outcome of any other result, sending the event again would only repeat it*/
+        if ((result != IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY) &&
+            (outbound_store_release(handleData->outboundStore, entry->outboundStoreSequence) != 0))
+        {
+            LogError("unable to release the event from the outbound store, it will be sent again by the next instance");
+        }
+    }
+}
+
+/*Codes_SRS_IOTHUBCLIENT_LL_01_014: [ When the outbound store is open, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall append the event to it before queuing it. ]*/
+static int store_outbound_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    int result;
+    size_t size;
+    if (serialize_outbound_event(handleData, entry->messageHandle, &size) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (outbound_store_append(handleData->outboundStore, handleData->outboundStoreBuffer, size, &entry->outboundStoreSequence) != 0)
+    {
+        LogError("unable to append the event to the outbound store");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (handleData->outboundStoreFirstSequence == 0)
+        {
+            handleData->outboundStoreFirstSequence = entry->outboundStoreSequence;
+        }
+        result = 0;
+    }
+    return result;
+}
+
+/*completes the events that are only on disk and could not be read back, they are released so they do not keep their segment alive*/
+static void fail_spilled_events(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, uint64_t sequence)
+{
+    while (!DList_IsListEmpty(&(handleData->outboundStoreSpilled)))
+    {
+        IOTHUB_MESSAGE_LIST* spilled = containingRecord(handleData->outboundStoreSpilled.Flink, IOTHUB_MESSAGE_LIST, entry);
+        if (spilled->outboundStoreSequence >= sequence)
+        {
+            break;
+        }
+
+        LogError("unable to read event %lu back from the outbound store", (unsigned long)spilled->outboundStoreSequence);
+        DList_RemoveEntryList(&(spilled->entry));
+        handleData->pendingEventCount--;
+        if (spilled->callback != NULL)
+        {
+            spilled->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, spilled->context);
+        }
+        complete_outbound_event(handleData, spilled, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+        free_message_list_entry(handleData, spilled);
+    }
+}
+
+#ifdef USE_COMPRESSION
+static const char CONTENT_ENCODING_PROPERTY[] = "content-encoding";
+
+/*replaces the body of an event with its zlib stream. Events that are too small, that the application already encoded or
+that do not get smaller are left untouched. Runs before the event is queued, so HTTP batching and the transports only
+ever see the compressed size. On failure the event is left as it was*/
+static int compress_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE messageHandle)
+{
+    int result;
+    const unsigned char* body;
+    size_t size;
+    MAP_HANDLE properties;
+    bool isEncoded;
+    const unsigned char* compressed;
+    size_t compressedSize;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(messageHandle);
+
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        if (IoTHubMessage_GetByteArray(messageHandle, &body, &size) != IOTHUB_MESSAGE_OK)
+        {
+            body = NULL;
+            size = 0;
+        }
+    }
+    else if (contentType == IOTHUBMESSAGE_STRING)
+    {
+        body = (const unsigned char*)IoTHubMessage_GetString(messageHandle);
+        size = (body == NULL) ? 0 : strlen((const char*)body);
+    }
+    else
+    {
+        body = NULL;
+        size = 0;
+    }
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_029: [ Events whose body is shorter than the compression threshold, that already have a "content-encoding" property or that would not get smaller shall be queued unchanged. ]*/
+    if ((body == NULL) || (size < handleData->compressionThreshold))
+    {
+        result = 0;
+    }
+    else if ((properties = IoTHubMessage_Properties(messageHandle)) == NULL)
+    {
+        LogError("unable to get the properties of the event");
+        result = __FAILURE__;
+    }
+    else if (Map_ContainsKey(properties, CONTENT_ENCODING_PROPERTY, &isEncoded) != MAP_OK)
+    {
+        LogError("unable to look up the %s property of the event", CONTENT_ENCODING_PROPERTY);
+        result = __FAILURE__;
+    }
+    else if (isEncoded ||
+        (payload_compressor_deflate(handleData->payloadCompressor, body, size, &compressed, &compressedSize) != 0))
+    {
+        result = 0;
+    }
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_028: [ When compression is enabled, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall replace the body of the event with its deflate stream and set its "content-encoding" property to "deflate" before queuing it. ]*/
+    else if (Map_AddOrUpdate(properties, CONTENT_ENCODING_PROPERTY, PAYLOAD_COMPRESSOR_CONTENT_ENCODING) != MAP_OK)
+    {
+        LogError("unable to set the %s property of the event", CONTENT_ENCODING_PROPERTY);
+        result = __FAILURE__;
+    }
+    else if (IoTHubMessage_SetByteArray(messageHandle, compressed, compressedSize) != IOTHUB_MESSAGE_OK)
+    {
+        LogError("unable to replace the body of the event with its %lu compressed bytes", (unsigned long)compressedSize);
+        (void)Map_Delete(properties, CONTENT_ENCODING_PROPERTY);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+#endif
+
+/*the outbound store keeps events as they were given, so they are compressed again every time they are read back*/
+static IOTHUB_MESSAGE_HANDLE read_stored_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, const unsigned char* data, size_t size)
+{
+    IOTHUB_MESSAGE_HANDLE result = deserialize_outbound_event(data, size);
+#ifdef USE_COMPRESSION
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_048: [ When compression is enabled, an event read back from the outbound store shall be compressed the same way; if that fails it shall be sent uncompressed. ]*/
+    if ((result != NULL) && (handleData->payloadCompressor != NULL) && (compress_event(handleData, result) != 0))
+    {
+        LogError("unable to compress the event read from the outbound store, it is sent uncompressed");
+    }
+#else
+    (void)handleData;
+#endif
+    return result;
+}
+
+/*an event read back from the outbound store keeps the timeout it was sent with, which can be earlier than the timeout of
+the events queued ahead of it (such as the ones of a previous instance, that get their timeout when they are read)*/
+static void queue_read_back_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_LIST* entry)
+{
+    if (entry->ms_timesOutAfter != 0)
+    {
+        PDLIST_ENTRY previous = handleData->waitingToSend.Blink;
+        while ((previous != &(handleData->waitingToSend)) && (containingRecord(previous, IOTHUB_MESSAGE_LIST, entry)->ms_timesOutAfter == 0))
+        {
+            previous = previous->Blink;
+        }
+
+        if ((previous != &(handleData->waitingToSend)) && (containingRecord(previous, IOTHUB_MESSAGE_LIST, entry)->ms_timesOutAfter > entry->ms_timesOutAfter))
+        {
+            handleData->messageTimeoutsOrdered = false;
+        }
+    }
+    DList_InsertTailList(&(handleData->waitingToSend), &(entry->entry));
+}
+
+static void on_stored_event(void* context, uint64_t sequence, const unsigned char* data, size_t size)
+{
+    IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)context;
+    IOTHUB_MESSAGE_LIST* spilled = NULL;
+    IOTHUB_MESSAGE_LIST* newEntry;
+    IOTHUB_MESSAGE_HANDLE messageHandle;
+
+    handleData->outboundStoreReadCount++;
+    fail_spilled_events(handleData, sequence);
+    if (!DList_IsListEmpty(&(handleData->outboundStoreSpilled)) &&
+        (containingRecord(handleData->outboundStoreSpilled.Flink, IOTHUB_MESSAGE_LIST, entry)->outboundStoreSequence == sequence))
+    {
+        spilled = containingRecord(handleData->outboundStoreSpilled.Flink, IOTHUB_MESSAGE_LIST, entry);
+    }
+
+    if ((spilled == NULL) && (handleData->outboundStoreFirstSequence != 0) && (sequence >= handleData->outboundStoreFirstSequence))
+    {
+        /*an event of this instance that already completed but could not be released, it stays there for the next instance*/
+    }
+    else if ((messageHandle = read_stored_event(handleData, data, size)) == NULL)
+    {
+        /*it can never be sent, keeping it would only keep its segment alive*/
+        (void)outbound_store_release(handleData->outboundStore, sequence);
+        if (spilled != NULL)
+        {
+            DList_RemoveEntryList(&(spilled->entry));
+            handleData->pendingEventCount--;
+            if (spilled->callback != NULL)
+            {
+                spilled->callback(IOTHUB_CLIENT_CONFIRMATION_ERROR, spilled->context);
+            }
+            free_message_list_entry(handleData, spilled);
+        }
+    }
+    else if (spilled != NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_043: [ An event read back from the outbound store shall be queued with the confirmation callback and timeout it was sent with. ]*/
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_051: [ If that timeout is earlier than the timeout of an event queued ahead of it, IoTHubClient_LL_DoWork shall look for timed out messages in all of waitingToSend until every timeout handed out so far has expired. ]*/
+        DList_RemoveEntryList(&(spilled->entry));
+        spilled->messageHandle = messageHandle;
+        queue_read_back_event(handleData, spilled);
+        handleData->outboundStoreLoadedCount++;
+    }
+    else if ((newEntry = allocate_message_list_entry(handleData)) == NULL)
+    {
+        LogError("unable to queue the event read from the outbound store, it stays there for the next instance");
+        IoTHubMessage_Destroy(messageHandle);
+    }
+    else if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
+    {
+        LogError("unable to queue the event read from the outbound store, it stays there for the next instance");
+        IoTHubMessage_Destroy(messageHandle);
+        free_message_list_entry(handleData, newEntry);
+    }
+    else
+    {
+        newEntry->messageHandle = messageHandle;
+        newEntry->callback = NULL;
+        newEntry->context = NULL;
+        newEntry->outboundStoreSequence = sequence;
+        DList_InsertTailList(&(handleData->waitingToSend), &(newEntry->entry));
+        handleData->pendingEventCount++;
+        handleData->outboundStoreLoadedCount++;
+    }
+}
+
+/*Codes_SRS_IOTHUBCLIENT_LL_01_042: [ While events are only in the outbound store, IoTHubClient_LL_DoWork shall read them back in the order they were sent, until "outbound_store_window" events are held in memory. ]*/
+static void load_outbound_events(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    if (handleData->outboundStoreHasBacklog && (handleData->outboundStoreLoadedCount < handleData->outboundStoreWindow))
+    {
+        size_t maxCount = handleData->outboundStoreWindow - handleData->outboundStoreLoadedCount;
+        handleData->outboundStoreReadCount = 0;
+        if (outbound_store_read(handleData->outboundStore, &handleData->outboundStoreCursor, maxCount, on_stored_event, handleData) != 0)
+        {
+            /*the next call goes on after the record that could not be read*/
+            LogError("unable to read every event of the outbound store");
+        }
+        else if (handleData->outboundStoreReadCount < maxCount)
+        {
+            handleData->outboundStoreHasBacklog = false;
+            fail_spilled_events(handleData, handleData->outboundStoreCursor);
+        }
+    }
+}
+
+static bool must_spill_outbound_event(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    return (handleData->outboundStore != NULL) &&
+        (handleData->outboundStoreHasBacklog || (handleData->outboundStoreLoadedCount >= handleData->outboundStoreWindow));
+}
+
+static IOTHUB_CLIENT_RESULT send_event_async(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback, bool takeOwnership)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_011: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle or eventMessageHandle is NULL.]*/
+    if (
+        (iotHubClientHandle == NULL) ||
+        (eventMessageHandle == NULL) ||
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_012: [IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter eventConfirmationCallback is NULL and userContextCallback is not NULL.] */
+        ((eventConfirmationCallback == NULL) && (userContextCallback != NULL))
+        )
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_023: [ When a message pool was created by OPTION_MESSAGE_POOL_SIZE, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall take the record queued for the event from the pool. ]*/
+        IOTHUB_MESSAGE_LIST *newEntry = allocate_message_list_entry(handleData);
+        if (newEntry == NULL)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LOG_ERROR_RESULT;
+        }
+        else
+        {
+            if (attach_ms_timesOutAfter(handleData, newEntry) != 0)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                LOG_ERROR_RESULT;
+                free_message_list_entry(handleData, newEntry);
+            }
+            else
+            {
+                if (takeOwnership)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_01_001: [ IoTHubClient_LL_SendEventAsync_Move shall add eventMessageHandle to the DLIST waitingToSend without cloning it. ]*/
+                    newEntry->messageHandle = eventMessageHandle;
+                }
+                /*Codes_SRS_IOTHUBCLIENT_LL_01_049: [ When a message pool was set with "message_pool_size", IoTHubClient_LL_SendEventAsync shall clone eventMessageHandle with IoTHubMessage_CloneFromPool. ]*/
+                else if (handleData->clonePool != NULL)
+                {
+                    newEntry->messageHandle = IoTHubMessage_CloneFromPool(handleData->clonePool, eventMessageHandle);
+                }
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
+                else
+                {
+                    newEntry->messageHandle = IoTHubMessage_Clone(eventMessageHandle);
+                }
+                newEntry->outboundStoreSequence = 0;
+
+                if (newEntry->messageHandle == NULL)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
+                    result = IOTHUB_CLIENT_ERROR;
+                    free_message_list_entry(handleData, newEntry);
+                    LOG_ERROR_RESULT;
+                }
+                else if ((handleData->outboundStore != NULL) && (store_outbound_event(handleData, newEntry) != 0))
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_01_015: [ If the event cannot be written to the outbound store, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                    result = IOTHUB_CLIENT_ERROR;
+                    if (!takeOwnership)
+                    {
+                        IoTHubMessage_Destroy(newEntry->messageHandle);
+                    }
+                    free_message_list_entry(handleData, newEntry);
+                    LOG_ERROR_RESULT;
+                }
+#ifdef USE_COMPRESSION
+                /*compression is the last step that can fail, so that a failed call leaves the event as it was given*/
+                else if ((handleData->payloadCompressor != NULL) && !must_spill_outbound_event(handleData) &&
+                    (compress_event(handleData, newEntry->messageHandle) != 0))
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_01_030: [ If the compressed body or its "content-encoding" property cannot be set, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                    result = IOTHUB_CLIENT_ERROR;
+                    if ((newEntry->outboundStoreSequence != 0) && (outbound_store_release(handleData->outboundStore, newEntry->outboundStoreSequence) != 0))
+                    {
+                        LogError("unable to release event %lu from the outbound store", (unsigned long)newEntry->outboundStoreSequence);
+                    }
+                    if (!takeOwnership)
+                    {
+                        IoTHubMessage_Destroy(newEntry->messageHandle);
+                    }
+                    free_message_list_entry(handleData, newEntry);
+                    LOG_ERROR_RESULT;
+                }
+#endif
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_013: [IoTHubClient_SendEventAsync shall add the DLIST waitingToSend a new record cloning the information from eventMessageHandle, eventConfirmationCallback, userContextCallback.]*/
+                    newEntry->callback = eventConfirmationCallback;
+                    newEntry->context = userContextCallback;
+                    if (must_spill_outbound_event(handleData))
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_LL_01_041: [ When "outbound_store_window" events of the outbound store are already in memory, or older events are only on disk, the event shall only be kept on disk: its message shall be destroyed and only its confirmation callback and timeout kept until it is read back. ]*/
+                        IoTHubMessage_Destroy(newEntry->messageHandle);
+                        newEntry->messageHandle = NULL;
+                        DList_InsertTailList(&(handleData->outboundStoreSpilled), &(newEntry->entry));
+                        handleData->outboundStoreHasBacklog = true;
+                    }
+                    else
+                    {
+                        if (handleData->outboundStore != NULL)
+                        {
+                            handleData->outboundStoreLoadedCount++;
+                            handleData->outboundStoreCursor = newEntry->outboundStoreSequence + 1;
+                        }
+                        DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
+                    }
+                    handleData->pendingEventCount++;
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_015: [Otherwise IoTHubClient_LL_SendEventAsync shall succeed and return IOTHUB_CLIENT_OK.] */
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, false);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync_Move(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void* userContextCallback)
+{
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_002: [ IoTHubClient_LL_SendEventAsync_Move shall validate its arguments the same way as IoTHubClient_LL_SendEventAsync. ]*/
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_003: [ On success the IoTHubClient_LL instance owns eventMessageHandle and shall destroy it once the message is confirmed or timed out. On failure the ownership stays with the caller. ]*/
+    return send_event_async(iotHubClientHandle, eventMessageHandle, eventConfirmationCallback, userContextCallback, true);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_016: [IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.] */
+        LogError("Invalid argument - iotHubClientHandle is NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        if (messageCallback == NULL)
+        {
+            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_NONE)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_010: [If parameter messageCallback is NULL and the _SetMessageCallback had not been called to subscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("not currently set to accept or process incoming messages.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_ASYNC)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_010: [If parameter messageCallback is NULL and the _SetMessageCallback had not been called to subscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallbackEx function.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_02_019: [If parameter messageCallback is NULL then IoTHubClient_LL_SetMessageCallback shall call the underlying layer's _Unsubscribe function and return IOTHUB_CLIENT_OK.] */
+                handleData->IoTHubTransport_Unsubscribe(handleData->deviceHandle);
+                handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
+                handleData->messageCallback.callbackSync = NULL;
+                handleData->messageCallback.callbackAsync = NULL;
+                handleData->messageCallback.messageUserContextCallback = NULL;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else
+        {
+            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_ASYNC)
+            {
+                /* Codes_SRS_IOTHUBCLIENT_LL_10_011: [If parameter messageCallback is non-NULL and the _SetMessageCallbackEx had been used to susbscribe for messages, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallbackEx function before subscribing with MessageCallback.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (handleData->IoTHubTransport_Subscribe(handleData->deviceHandle) == 0)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_017: [If parameter messageCallback is non-NULL then IoTHubClient_LL_SetMessageCallback shall call the underlying layer's _Subscribe function.]*/
+                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_SYNC;
+                    handleData->messageCallback.callbackSync = messageCallback;
+                    handleData->messageCallback.messageUserContextCallback = userContextCallback;
+                    result = IOTHUB_CLIENT_OK;
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_018: [If the underlying layer's _Subscribe function fails, then IoTHubClient_LL_SetMessageCallback shall fail and return IOTHUB_CLIENT_ERROR. Otherwise IoTHubClient_LL_SetMessageCallback shall succeed and return IOTHUB_CLIENT_OK.]*/
+                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
+                    handleData->messageCallback.callbackSync = NULL;
+                    handleData->messageCallback.callbackAsync = NULL;
+                    handleData->messageCallback.messageUserContextCallback = NULL;
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallbackEx(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC_EX messageCallback, void* userContextCallback)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubClientHandle == NULL)
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_10_021: [IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.]*/
+        LogError("Invalid argument - iotHubClientHandle is NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        if (messageCallback == NULL)
+        {
+            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_NONE)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_018: [If parameter messageCallback is NULL and IoTHubClient_LL_SetMessageCallbackEx had not been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("not currently set to accept or process incoming messages.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_SYNC)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_019: [If parameter messageCallback is NULL and IoTHubClient_LL_SetMessageCallback had been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_SetMessageCallback function.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_023: [If parameter messageCallback is NULL then IoTHubClient_LL_SetMessageCallbackEx shall call the underlying layer's _Unsubscribe function and return IOTHUB_CLIENT_OK.] */ 
+                handleData->IoTHubTransport_Unsubscribe(handleData->deviceHandle);
+                handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
+                handleData->messageCallback.callbackSync = NULL;
+                handleData->messageCallback.callbackAsync = NULL;
+                handleData->messageCallback.messageUserContextCallback = NULL;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else
+        {
+            if (handleData->messageCallback.messageCallbackType == MESSAGE_CALLBACK_TYPE_SYNC)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_10_020: [If parameter messageCallback is non-NULL, and IoTHubClient_LL_SetMessageCallback had been used to subscribe for messages, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR.] */
+                LogError("Invalid workflow sequence. Please unsubscribe using the IoTHubClient_LL_MessageCallbackEx function before subscribing with MessageCallback.");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (handleData->IoTHubTransport_Subscribe(handleData->deviceHandle) == 0)
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_10_024: [If parameter messageCallback is non-NULL then IoTHubClient_LL_SetMessageCallbackEx shall call the underlying layer's _Subscribe function.]*/
+                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_ASYNC;
+                    handleData->messageCallback.callbackAsync = messageCallback;
+                    handleData->messageCallback.messageUserContextCallback = userContextCallback;
+                    result = IOTHUB_CLIENT_OK;
+                }
+                else
+                {
+                    /*Codes_SRS_IOTHUBCLIENT_LL_10_025: [If the underlying layer's _Subscribe function fails, then IoTHubClient_LL_SetMessageCallbackEx shall fail and return IOTHUB_CLIENT_ERROR. Otherwise IoTHubClient_LL_SetMessageCallbackEx shall succeed and return IOTHUB_CLIENT_OK.] */
+                    handleData->messageCallback.messageCallbackType = MESSAGE_CALLBACK_TYPE_NONE;
+                    handleData->messageCallback.callbackSync = NULL;
+                    handleData->messageCallback.callbackAsync = NULL;
+                    handleData->messageCallback.messageUserContextCallback = NULL;
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendMessageDisposition(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, MESSAGE_CALLBACK_INFO* message_data, IOTHUBMESSAGE_DISPOSITION_RESULT disposition)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if ((iotHubClientHandle == NULL) || (message_data == NULL))
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_10_026: [IoTHubClient_LL_SendMessageDisposition shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL.]*/
+        LogError("Invalid argument handle=%p, message=%p", iotHubClientHandle, message_data);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+        /*Codes_SRS_IOTHUBCLIENT_LL_10_027: [IoTHubClient_LL_SendMessageDisposition shall return the result from calling the underlying layer's _Send_Message_Disposition.]*/
+        result = handleData->IoTHubTransport_SendMessageDisposition(message_data, disposition);
+    }
+    return result;
+}
+
+static void DoTimeoutsInList(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, PDLIST_ENTRY list, tickcounter_ms_t nowTick)
+{
+    DLIST_ENTRY* currentItemInWaitingToSend = list->Flink;
+    while (currentItemInWaitingToSend != list) /*while we are not at the end of the list*/
+    {
+        IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
+        /*Codes_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClient_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
+        if ((fullEntry->ms_timesOutAfter != 0) && (fullEntry->ms_timesOutAfter < nowTick))
+        {
+            PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
+            DList_RemoveEntryList(currentItemInWaitingToSend);
+            handleData->pendingEventCount--;
+            if (fullEntry->callback != NULL)
+            {
+                fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
+            }
+            complete_outbound_event(handleData, fullEntry, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
+            IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
+            free_message_list_entry(handleData, fullEntry);
+            currentItemInWaitingToSend = theNext;
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_007: [ While the timeouts of the messages in waitingToSend are in the order the messages were queued, IoTHubClient_LL_DoWork shall stop looking for timed out messages at the first message with a timeout that has not expired. ]*/
+        else if ((fullEntry->ms_timesOutAfter != 0) && handleData->messageTimeoutsOrdered)
+        {
+            break;
+        }
+        else
+        {
+            currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+        }
+    }
+}
+
+static void DoTimeouts(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    tickcounter_ms_t nowTick;
     if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
     {
-        LogError("unable to get the current ms, timeouts will not be processed");
+        LogError("unable to get the current ms, timeouts will not be processed");
+    }
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_006: [ If no message was ever given a timeout, IoTHubClient_LL_DoWork shall not iterate waitingToSend looking for timed out messages. ]*/
+    else if (handleData->latestMessageTimeout != 0)
+    {
+        DoTimeoutsInList(handleData, &(handleData->waitingToSend), nowTick);
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_045: [ The events that are only in the outbound store shall time out the same way. ]*/
+        DoTimeoutsInList(handleData, &(handleData->outboundStoreSpilled), nowTick);
+
+        if (!handleData->messageTimeoutsOrdered && (handleData->latestMessageTimeout < nowTick))
+        {
+            /*every timeout handed out so far has expired and was processed by the full pass above, any new one will be later than all of them*/
+            handleData->messageTimeoutsOrdered = true;
+        }
+    }
+}
+
+/*copies every member of source into target, later values win and nested objects are merged member by member*/
+static int merge_reported_state_object(JSON_Object* target, const JSON_Object* source)
+{
+    int result = 0;
+    size_t member_count = json_object_get_count(source);
+    size_t member_index;
+    for (member_index = 0; (member_index < member_count) && (result == 0); member_index++)
+    {
+        const char* name = json_object_get_name(source, member_index);
+        JSON_Value* value = json_object_get_value(source, name);
+        JSON_Object* target_object;
+        if ((json_value_get_type(value) == JSONObject) && ((target_object = json_object_get_object(target, name)) != NULL))
+        {
+            result = merge_reported_state_object(target_object, json_value_get_object(value));
+        }
+        else
+        {
+            JSON_Value* value_copy = json_value_deep_copy(value);
+            if (value_copy == NULL)
+            {
+                LogError("Failure copying reported state member %s", name);
+                result = __FAILURE__;
+            }
+            else if (json_object_set_value(target, name, value_copy) != JSONSuccess)
+            {
+                LogError("Failure merging reported state member %s", name);
+                json_value_free(value_copy);
+                result = __FAILURE__;
+            }
+        }
+    }
+    return result;
+}
+
+/*parson keeps numbers as doubles, so a number of a reported state is only merged as it was given when parson writes it
+back with the same text (integers beyond 2^53 and most decimals are not)*/
+static bool is_exact_number(const char* text, size_t length)
+{
+    bool result;
+    JSON_Value* number = json_value_init_number(strtod(text, NULL));
+    char* number_text;
+    if (number == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        if ((number_text = json_serialize_to_string(number)) == NULL)
+        {
+            result = false;
+        }
+        else
+        {
+            result = (strlen(number_text) == length) && (memcmp(number_text, text, length) == 0);
+            json_free_serialized_string(number_text);
+        }
+        json_value_free(number);
+    }
+    return result;
+}
+
+/*outside of strings, digits are only found in numbers*/
+static bool has_exact_numbers(const char* report_text)
+{
+    bool result = true;
+    bool is_in_string = false;
+    const char* cursor = report_text;
+    while (result && (*cursor != '\0'))
+    {
+        if (is_in_string)
+        {
+            if ((*cursor == '\\') && (cursor[1] != '\0'))
+            {
+                cursor++;
+            }
+            else if (*cursor == '"')
+            {
+                is_in_string = false;
+            }
+            cursor++;
+        }
+        else if (*cursor == '"')
+        {
+            is_in_string = true;
+            cursor++;
+        }
+        else if ((*cursor == '-') || ((*cursor >= '0') && (*cursor <= '9')))
+        {
+            const char* number_end = cursor + 1;
+            while ((*number_end != '\0') && (strchr("0123456789+-.eE", *number_end) != NULL))
+            {
+                number_end++;
+            }
+            result = is_exact_number(cursor, (size_t)(number_end - cursor));
+            cursor = number_end;
+        }
+        else
+        {
+            cursor++;
+        }
+    }
+    return result;
+}
+
+static int merge_reported_state(JSON_Object* target, CONSTBUFFER_HANDLE report_data_handle)
+{
+    int result;
+    const CONSTBUFFER* report_data = CONSTBUFFER_GetContent(report_data_handle);
+    char* report_text = (char*)malloc(report_data->size + 1);
+    if (report_text == NULL)
+    {
+        LogError("Failure allocating reported state text");
+        result = __FAILURE__;
     }
     else
     {
-        DLIST_ENTRY* currentItemInWaitingToSend = handleData->waitingToSend.Flink;
-        while (currentItemInWaitingToSend != &(handleData->waitingToSend)) /*while we are not at the end of the list*/
+        JSON_Value* report_value;
+        (void)memcpy(report_text, report_data->buffer, report_data->size);
+        report_text[report_data->size] = '\0';
+        if ((report_value = json_parse_string(report_text)) == NULL)
+        {
+            LogError("Reported state is not valid JSON, it cannot be coalesced");
+            result = __FAILURE__;
+        }
+        else
         {
-            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
-            /*Codes_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClient_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
-            if ((fullEntry->ms_timesOutAfter != 0) && (fullEntry->ms_timesOutAfter < nowTick))
+            if (json_value_get_type(report_value) != JSONObject)
             {
-                PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
-                DList_RemoveEntryList(currentItemInWaitingToSend);
-                if (fullEntry->callback != NULL)
-                {
-                    fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
-                }
-                IoTHubMessage_Destroy(fullEntry->messageHandle); /*because it has been cloned*/
-                free(fullEntry);
-                currentItemInWaitingToSend = theNext;
+                LogError("Reported state is not a JSON object, it cannot be coalesced");
+                result = __FAILURE__;
+            }
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_052: [ Reported states with a number that would not be written back exactly as it was given shall not be merged. ]*/
+            else if (!has_exact_numbers(report_text))
+            {
+                LogInfo("Reported state has a number that would change if it was coalesced");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = merge_reported_state_object(target, json_value_get_object(report_value));
+            }
+            json_value_free(report_value);
+        }
+        free(report_text);
+    }
+    return result;
+}
+
+/*replaces all the reported states waiting in iot_msg_queue with a single patch, leaves the queue untouched on failure*/
+static void coalesce_reported_states(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    DLIST_ENTRY* client_item = handleData->iot_msg_queue.Flink;
+    if ((client_item != &(handleData->iot_msg_queue)) && (client_item->Flink != &(handleData->iot_msg_queue)))
+    {
+        JSON_Value* merged_value = json_value_init_object();
+        if (merged_value == NULL)
+        {
+            LogError("Failure creating coalesced reported state");
+        }
+        else
+        {
+            JSON_Object* merged_object = json_value_get_object(merged_value);
+            int merge_result = 0;
+            while ((client_item != &(handleData->iot_msg_queue)) && (merge_result == 0))
+            {
+                IOTHUB_DEVICE_TWIN* queue_data = containingRecord(client_item, IOTHUB_DEVICE_TWIN, entry);
+                merge_result = merge_reported_state(merged_object, queue_data->report_data_handle);
+                client_item = client_item->Flink;
+            }
+
+            if (merge_result != 0)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_01_011: [ If the pending reported states cannot be merged, IoTHubClient_LL_DoWork shall publish them one by one. ]*/
+                LogInfo("Reported states were not coalesced, they will be sent one by one");
             }
             else
             {
-                currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+                char* merged_text = json_serialize_to_string(merged_value);
+                if (merged_text == NULL)
+                {
+                    LogError("Failure serializing coalesced reported state, they will be sent one by one");
+                }
+                else
+                {
+                    IOTHUB_DEVICE_TWIN* merged_item = dev_twin_data_create(handleData, get_next_item_id(handleData), (const unsigned char*)merged_text, strlen(merged_text), NULL, NULL);
+                    if (merged_item == NULL)
+                    {
+                        LogError("Failure creating coalesced reported state, they will be sent one by one");
+                    }
+                    else
+                    {
+                        /*Codes_SRS_IOTHUBCLIENT_LL_01_010: [ The reported states merged into the patch shall be kept with it, so that each of their callbacks is called with the status of the patch. ]*/
+                        IOTHUB_DEVICE_TWIN** chain_tail = &(merged_item->coalesced_items);
+                        PDLIST_ENTRY unsent;
+                        while ((unsent = DList_RemoveHeadList(&(handleData->iot_msg_queue))) != &(handleData->iot_msg_queue))
+                        {
+                            IOTHUB_DEVICE_TWIN* queue_data = containingRecord(unsent, IOTHUB_DEVICE_TWIN, entry);
+                            if (queue_data->coalesced_items != NULL)
+                            {
+                                /*an earlier patch that was not published yet, keep its originals and drop the patch itself*/
+                                *chain_tail = queue_data->coalesced_items;
+                                while (*chain_tail != NULL)
+                                {
+                                    chain_tail = &((*chain_tail)->coalesced_items);
+                                }
+                                queue_data->coalesced_items = NULL;
+                                device_twin_data_destroy(queue_data);
+                            }
+                            else
+                            {
+                                *chain_tail = queue_data;
+                                chain_tail = &(queue_data->coalesced_items);
+                            }
+                        }
+                        DList_InsertTailList(&(handleData->iot_msg_queue), &(merged_item->entry));
+                    }
+                    json_free_serialized_string(merged_text);
+                }
             }
+            json_value_free(merged_value);
         }
     }
 }
 
+/*returns true when the reported states in iot_msg_queue can be handed to the transport in this call*/
+static bool flush_reported_states(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    bool result;
+    tickcounter_ms_t nowTick;
+    if ((handleData->reportedStateCoalescingInterval == 0) || DList_IsListEmpty(&(handleData->iot_msg_queue)))
+    {
+        result = true;
+    }
+    else if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+    {
+        LogError("unable to get the current ms, reported states will not be coalesced");
+        result = true;
+    }
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_009: [ When "reported_state_coalescing_interval" is not 0, IoTHubClient_LL_DoWork shall hold the reported states until that many milliseconds have passed since the last flush and then merge all of them into one JSON patch, the values given last winning. ]*/
+    else if ((nowTick - handleData->lastReportedStateFlush) < handleData->reportedStateCoalescingInterval)
+    {
+        result = false;
+    }
+    else
+    {
+        coalesce_reported_states(handleData);
+        handleData->lastReportedStateFlush = nowTick;
+        result = true;
+    }
+    return result;
+}
+
 void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
     /*Codes_SRS_IOTHUBCLIENT_LL_02_020: [If parameter iotHubClientHandle is NULL then IoTHubClient_LL_DoWork shall not perform any action.] */
@@ -1049,8 +2037,18 @@ void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
         IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
         DoTimeouts(handleData);
 
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_017: [ Before the transport gets to send anything, IoTHubClient_LL_DoWork shall commit the outbound store, so every event appended since the previous call is made durable with a single sync. ]*/
+        if ((handleData->outboundStore != NULL) && (outbound_store_commit(handleData->outboundStore) != 0))
+        {
+            LogError("unable to commit the outbound store");
+        }
+        if (handleData->outboundStore != NULL)
+        {
+            load_outbound_events(handleData);
+        }
+
         /*Codes_SRS_IOTHUBCLIENT_LL_07_008: [ IoTHubClient_LL_DoWork shall iterate the message queue and execute the underlying transports IoTHubTransport_ProcessItem function for each item. ] */
-        DLIST_ENTRY* client_item = handleData->iot_msg_queue.Flink;
+        DLIST_ENTRY* client_item = flush_reported_states(handleData) ? handleData->iot_msg_queue.Flink : &(handleData->iot_msg_queue);
         while (client_item != &(handleData->iot_msg_queue)) /*while we are not at the end of the list*/
         {
             PDLIST_ENTRY next_item = client_item->Flink;
@@ -1085,6 +2083,12 @@ void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 
         /*Codes_SRS_IOTHUBCLIENT_LL_02_021: [Otherwise, IoTHubClient_LL_DoWork shall invoke the underlaying layer's _DoWork function.]*/
         handleData->IoTHubTransport_DoWork(handleData->transportHandle, iotHubClientHandle);
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_018: [ After the transport's _DoWork, IoTHubClient_LL_DoWork shall give the outbound store a chance to compact its oldest segment. ]*/
+        if ((handleData->outboundStore != NULL) && (outbound_store_compact(handleData->outboundStore) != 0))
+        {
+            LogError("unable to compact the outbound store");
+        }
     }
 }
 
@@ -1104,7 +2108,127 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHu
 
         /* Codes_SRS_IOTHUBCLIENT_09_008: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_IDLE if there is currently no items to be sent] */
         /* Codes_SRS_IOTHUBCLIENT_09_009: [IoTHubClient_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY if there are currently items to be sent] */
-        result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_047: [ While events are only in the outbound store, IoTHubClient_LL_GetSendStatus shall return IOTHUB_CLIENT_OK and status IOTHUB_CLIENT_SEND_STATUS_BUSY. ]*/
+        if (handleData->outboundStoreHasBacklog)
+        {
+            *iotHubClientStatus = IOTHUB_CLIENT_SEND_STATUS_BUSY;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else
+        {
+            result = handleData->IoTHubTransport_GetSendStatus(handleData->deviceHandle, iotHubClientStatus);
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetSendQueueSize(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, size_t* queueSize)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_004: [ If iotHubClientHandle or queueSize is NULL, IoTHubClient_LL_GetSendQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (iotHubClientHandle == NULL || queueSize == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_005: [ Otherwise IoTHubClient_LL_GetSendQueueSize shall set queueSize to the number of events accepted by IoTHubClient_LL_SendEventAsync whose confirmation callback has not been called yet and return IOTHUB_CLIENT_OK. ]*/
+        *queueSize = handleData->pendingEventCount;
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
+/*returns how long until the first message of list times out, at most maxWaitMs*/
+static tickcounter_ms_t get_message_timeout_wait(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData, PDLIST_ENTRY list, tickcounter_ms_t nowTick, tickcounter_ms_t maxWaitMs)
+{
+    tickcounter_ms_t result = maxWaitMs;
+    PDLIST_ENTRY currentEntry = list->Flink;
+    while (currentEntry != list)
+    {
+        IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentEntry, IOTHUB_MESSAGE_LIST, entry);
+        if (fullEntry->ms_timesOutAfter != 0)
+        {
+            /*DoTimeouts times a message out once the tick count is past ms_timesOutAfter*/
+            tickcounter_ms_t wait = (fullEntry->ms_timesOutAfter < nowTick) ? 0 : fullEntry->ms_timesOutAfter - nowTick + 1;
+            if (wait < result)
+            {
+                result = wait;
+            }
+            if (handleData->messageTimeoutsOrdered)
+            {
+                break;
+            }
+        }
+        currentEntry = currentEntry->Flink;
+    }
+    return result;
+}
+
+/*returns true while IoTHubClient_LL_DoWork has to keep running the transport to receive something: confirmations, acks or cloud to device traffic*/
+static bool is_waiting_on_transport(IOTHUB_CLIENT_LL_HANDLE_DATA* handleData)
+{
+    return (handleData->pendingEventCount > 0) ||
+        !DList_IsListEmpty(&(handleData->iot_msg_queue)) ||
+        !DList_IsListEmpty(&(handleData->iot_ack_queue)) ||
+        (handleData->messageCallback.messageCallbackType != MESSAGE_CALLBACK_TYPE_NONE) ||
+        (handleData->deviceTwinCallback != NULL) ||
+        (handleData->deviceMethodCallback != NULL) ||
+        (handleData->deviceInboundMethodCallback != NULL) ||
+        (handleData->conStatusCallback != NULL);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_GetWorkWaitTime(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, tickcounter_ms_t transportPollMs, tickcounter_ms_t* waitMs)
+{
+    IOTHUB_CLIENT_RESULT result;
+    tickcounter_ms_t nowTick;
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_053: [ If iotHubClientHandle or waitMs is NULL, IoTHubClient_LL_GetWorkWaitTime shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if ((iotHubClientHandle == NULL) || (waitMs == NULL))
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_054: [ If getting the current tick count fails, IoTHubClient_LL_GetWorkWaitTime shall return IOTHUB_CLIENT_ERROR. ]*/
+    else if (tickcounter_get_current_ms(((IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle)->tickCounter, &nowTick) != 0)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)iotHubClientHandle;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_055: [ While nothing is waiting on the transport, IoTHubClient_LL_GetWorkWaitTime shall start from IOTHUB_CLIENT_LL_NO_WORK_DEADLINE, otherwise from transportPollMs. ]*/
+        tickcounter_ms_t wait = is_waiting_on_transport(handleData) ? transportPollMs : IOTHUB_CLIENT_LL_NO_WORK_DEADLINE;
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_056: [ IoTHubClient_LL_GetWorkWaitTime shall shorten the wait to the number of milliseconds until the first message in waitingToSend or in the outbound store times out. ]*/
+        if (handleData->latestMessageTimeout != 0)
+        {
+            wait = get_message_timeout_wait(handleData, &(handleData->waitingToSend), nowTick, wait);
+            wait = get_message_timeout_wait(handleData, &(handleData->outboundStoreSpilled), nowTick, wait);
+        }
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_057: [ While reported states are held for coalescing, IoTHubClient_LL_GetWorkWaitTime shall shorten the wait to the number of milliseconds until they are due to be flushed. ]*/
+        if ((handleData->reportedStateCoalescingInterval != 0) && !DList_IsListEmpty(&(handleData->iot_msg_queue)))
+        {
+            tickcounter_ms_t elapsed = nowTick - handleData->lastReportedStateFlush;
+            tickcounter_ms_t flushWait = (elapsed >= handleData->reportedStateCoalescingInterval) ? 0 : handleData->reportedStateCoalescingInterval - elapsed;
+            if (flushWait < wait)
+            {
+                wait = flushWait;
+            }
+        }
+
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_058: [ IoTHubClient_LL_GetWorkWaitTime shall set waitMs to the resulting wait and return IOTHUB_CLIENT_OK. ]*/
+        *waitMs = wait;
+        result = IOTHUB_CLIENT_OK;
     }
 
     return result;
@@ -1125,17 +2249,24 @@ void IoTHubClient_LL_SendComplete(IOTHUB_CLIENT_LL_HANDLE handle, PDLIST_ENTRY c
     {
         /*Codes_SRS_IOTHUBCLIENT_LL_02_027: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_ERROR then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_ERROR and the context set to the context passed originally in the SendEventAsync call.] */
         /*Codes_SRS_IOTHUBCLIENT_LL_02_025: [If parameter result is IOTHUB_CLIENT_CONFIRMATION_OK then IoTHubClient_LL_SendComplete shall call all the non-NULL callbacks with the result parameter set to IOTHUB_CLIENT_CONFIRMATION_OK and the context set to the context passed originally in the SendEventAsync call.]*/
+        IOTHUB_CLIENT_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_HANDLE_DATA*)handle;
         PDLIST_ENTRY oldest;
         while ((oldest = DList_RemoveHeadList(completed)) != completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+            if (handleData->pendingEventCount > 0)
+            {
+                handleData->pendingEventCount--;
+            }
             /*Codes_SRS_IOTHUBCLIENT_LL_02_026: [If any callback is NULL then there shall not be a callback call.]*/
             if (messageList->callback != NULL)
             {
                 messageList->callback(result, messageList->context);
             }
+            complete_outbound_event(handleData, messageList, result);
             IoTHubMessage_Destroy(messageList->messageHandle);
-            free(messageList);
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_024: [ Once an event is completed, its record shall go back to the message pool it was taken from. ]*/
+            free_message_list_entry(handleData, messageList);
         }
     }
 }
@@ -1232,10 +2363,19 @@ void IoTHubClient_LL_ReportedStateComplete(IOTHUB_CLIENT_LL_HANDLE handle, uint3
             IOTHUB_DEVICE_TWIN* queue_data = containingRecord(client_item, IOTHUB_DEVICE_TWIN, entry);
             if (queue_data->item_id == item_id)
             {
+                IOTHUB_DEVICE_TWIN* coalesced_item;
                 if (queue_data->reported_state_callback != NULL)
                 {
                     queue_data->reported_state_callback(status_code, queue_data->context);
                 }
+                /*Codes_SRS_IOTHUBCLIENT_LL_01_010: [ The reported states merged into the patch shall be kept with it, so that each of their callbacks is called with the status of the patch. ]*/
+                for (coalesced_item = queue_data->coalesced_items; coalesced_item != NULL; coalesced_item = coalesced_item->coalesced_items)
+                {
+                    if (coalesced_item->reported_state_callback != NULL)
+                    {
+                        coalesced_item->reported_state_callback(status_code, coalesced_item->context);
+                    }
+                }
                 /*Codes_SRS_IOTHUBCLIENT_LL_07_009: [ IoTHubClient_LL_ReportedStateComplete shall remove the IOTHUB_DEVICE_TWIN item from the ack queue.]*/
                 DList_RemoveEntryList(client_item);
                 device_twin_data_destroy(queue_data);
@@ -1470,6 +2610,159 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubCli
             handleData->currentMessageTimeout = *(const tickcounter_ms_t*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_008: [ "reported_state_coalescing_interval" - value is a pointer to a tickcounter_ms_t. When not 0, reported states given to IoTHubClient_LL_SendReportedState are merged and published at most once per that many milliseconds. 0 (the default) publishes each reported state as it was given. ]*/
+        else if (strcmp(optionName, OPTION_REPORTED_STATE_COALESCING_INTERVAL) == 0)
+        {
+            handleData->reportedStateCoalescingInterval = *(const tickcounter_ms_t*)value;
+            result = IOTHUB_CLIENT_OK;
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_012: [ "outbound_store_path" - value is a const char* path prefix for the files of the outbound store. IoTHubClient_LL_SetOption shall open the outbound store and queue the events it still holds, up to "outbound_store_window" of them, without a confirmation callback, in the order they were sent. ]*/
+        else if (strcmp(optionName, OPTION_OUTBOUND_STORE_PATH) == 0)
+        {
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_013: [ If the outbound store is already open or cannot be opened, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+            if (handleData->outboundStore != NULL)
+            {
+                LogError("the outbound store is already open");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if ((handleData->outboundStore = outbound_store_open((const char*)value, handleData->outboundStoreSegmentSize)) == NULL)
+            {
+                LogError("unable to open the outbound store %s", (const char*)value);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                /*what is not read now is read by IoTHubClient_LL_DoWork as the events in memory complete*/
+                handleData->outboundStoreCursor = 0;
+                handleData->outboundStoreHasBacklog = true;
+                load_outbound_events(handleData);
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_020: [ "outbound_store_segment_size" - value is a pointer to an unsigned int, the size in bytes after which the outbound store starts a new segment. It shall be set before "outbound_store_path", otherwise IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+        else if (strcmp(optionName, OPTION_OUTBOUND_STORE_SEGMENT_SIZE) == 0)
+        {
+            if (*(const unsigned int*)value == 0)
+            {
+                LogError("the outbound store segment size cannot be 0");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if (handleData->outboundStore != NULL)
+            {
+                LogError("the outbound store is already open");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->outboundStoreSegmentSize = *(const unsigned int*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_046: [ "outbound_store_window" - value is a pointer to an unsigned int, the most events of the outbound store held in memory, 128 by default. If it is 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        else if (strcmp(optionName, OPTION_OUTBOUND_STORE_WINDOW) == 0)
+        {
+            if (*(const unsigned int*)value == 0)
+            {
+                LogError("the outbound store window cannot be 0");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->outboundStoreWindow = *(const unsigned int*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_021: [ "message_pool_size" - value is a pointer to an unsigned int, the number of events the client can have pending without allocating their bookkeeping on the heap. IoTHubClient_LL_SetOption shall replace the message pool with one of that many records, 0 (the default) removes the pool. ]*/
+        else if (strcmp(optionName, OPTION_MESSAGE_POOL_SIZE) == 0)
+        {
+            SLAB_POOL_HANDLE messagePool = NULL;
+            IOTHUB_MESSAGE_POOL_HANDLE clonePool = NULL;
+
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_022: [ If events are pending or the pool cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+            if (handleData->pendingEventCount != 0)
+            {
+                LogError("the message pool cannot be changed while %lu events are pending", (unsigned long)handleData->pendingEventCount);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if ((*(const unsigned int*)value != 0) &&
+                ((messagePool = slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), *(const unsigned int*)value)) == NULL))
+            {
+                LogError("unable to create a message pool of %lu records", (unsigned long)*(const unsigned int*)value);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_050: [ IoTHubClient_LL_SetOption shall also create a pool of that many message clones with IoTHubMessage_CreatePool. If that fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+            else if ((messagePool != NULL) &&
+                ((clonePool = IoTHubMessage_CreatePool(*(const unsigned int*)value)) == NULL))
+            {
+                LogError("unable to create a pool of %lu message clones", (unsigned long)*(const unsigned int*)value);
+                slab_pool_destroy(messagePool);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            /*Codes_SRS_IOTHUBCLIENT_LL_01_025: [ IoTHubClient_LL_SetOption shall pass "message_pool_size" to the transport, so that it can pool its own per-event records. If the transport returns IOTHUB_CLIENT_ERROR, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+            else if (handleData->IoTHubTransport_SetOption(handleData->transportHandle, optionName, value) == IOTHUB_CLIENT_ERROR)
+            {
+                LogError("the transport failed setting its message pool");
+                slab_pool_destroy(messagePool);
+                IoTHubMessage_DestroyPool(clonePool);
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (handleData->messagePool != NULL)
+                {
+                    slab_pool_destroy(handleData->messagePool);
+                    IoTHubMessage_DestroyPool(handleData->clonePool);
+                }
+                handleData->messagePool = messagePool;
+                handleData->clonePool = clonePool;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+#ifdef USE_COMPRESSION
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_027: [ "compression_threshold" - value is a pointer to an unsigned int. IoTHubClient_LL_SetOption shall enable compression of the events whose body is at least that many bytes long. ]*/
+        else if (strcmp(optionName, OPTION_COMPRESSION_THRESHOLD) == 0)
+        {
+            if ((handleData->payloadCompressor == NULL) &&
+                ((handleData->payloadCompressor = payload_compressor_create(NULL, 0)) == NULL))
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_01_033: [ If the payload compressor cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compression settings. ]*/
+                LogError("unable to create the payload compressor");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->compressionThreshold = *(const unsigned int*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_031: [ "compression_dictionary" - value is a pointer to an IOTHUB_COMPRESSION_DICTIONARY. IoTHubClient_LL_SetOption shall enable compression, with the default threshold of 256 bytes unless "compression_threshold" was set, and use a copy of the dictionary for every event compressed from then on. ]*/
+        else if (strcmp(optionName, OPTION_COMPRESSION_DICTIONARY) == 0)
+        {
+            const IOTHUB_COMPRESSION_DICTIONARY* dictionary = (const IOTHUB_COMPRESSION_DICTIONARY*)value;
+            PAYLOAD_COMPRESSOR_HANDLE payloadCompressor;
+
+            if ((dictionary->bytes == NULL) && (dictionary->size != 0))
+            {
+                LogError("invalid compression dictionary");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((payloadCompressor = payload_compressor_create(dictionary->bytes, dictionary->size)) == NULL)
+            {
+                /*Codes_SRS_IOTHUBCLIENT_LL_01_033: [ If the payload compressor cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compression settings. ]*/
+                LogError("unable to create the payload compressor");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (handleData->payloadCompressor != NULL)
+                {
+                    payload_compressor_destroy(handleData->payloadCompressor);
+                }
+                handleData->payloadCompressor = payloadCompressor;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+#endif
         else
         {
 
@@ -1720,4 +3013,25 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob(IOTHUB_CLIENT_LL_HANDLE iotHub
     }
     return result;
 }
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char* destinationFileName, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_034: [ If handle, destinationFileName or source is NULL, or source has no readCallback while its size is not 0, then IoTHubClient_LL_UploadMultipleBlocksToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (
+        (iotHubClientHandle == NULL) ||
+        (destinationFileName == NULL) ||
+        (source == NULL)
+        )
+    {
+        LogError("invalid parameters IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle=%p, const char* destinationFileName=%s, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source=%p", iotHubClientHandle, destinationFileName, source);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_035: [ IoTHubClient_LL_UploadMultipleBlocksToBlob shall call IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl and return what it returns. ]*/
+        result = IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(iotHubClientHandle->uploadToBlobHandle, destinationFileName, source);
+    }
+    return result;
+}
 #endif
@@ -43,6 +43,10 @@ int snprintf(char * s, size_t n, const char * format, ...)
 /*Codes_SRS_IOTHUBCLIENT_LL_02_085: [ IoTHubClient_LL_UploadToBlob shall use the same authorization as step 1. to prepare and perform a HTTP request with the following parameters: ]*/
 #define FILE_UPLOAD_FAILED_BODY "{ \"isSuccess\":false, \"statusCode\":-1,\"statusDescription\" : \"client not able to connect with the server\" }"
 
+/*blocks of IoTHubClient_LL_UploadMultipleBlocksToBlob uploaded at the same time, and how many times each is retried*/
+#define DEFAULT_BLOB_UPLOAD_PARALLELISM 4
+#define DEFAULT_BLOB_UPLOAD_BLOCK_RETRIES 3
+
 #define AUTHORIZATION_SCHEME_VALUES \
     DEVICE_KEY, \
     X509,       \
@@ -65,6 +69,8 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA_TAG
         STRING_HANDLE sas;          /*used when authorizationScheme is SAS_TOKEN*/
         UPLOADTOBLOB_X509_CREDENTIALS x509credentials; /*assumed to be used when both deviceKey and deviceSasToken are NULL*/
     } credentials;                              /*needed for file upload*/
+    size_t blobUploadParallelism;               /*needed for multiple blocks file upload*/
+    size_t blobUploadBlockRetries;              /*needed for multiple blocks file upload*/
 }IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA;
 
 IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const IOTHUB_CLIENT_CONFIG* config)
@@ -79,6 +85,8 @@ IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE IoTHubClient_LL_UploadToBlob_Create(const I
     {
         size_t iotHubNameLength = strlen(config->iotHubName);
         size_t iotHubSuffixLength = strlen(config->iotHubSuffix);
+        handleData->blobUploadParallelism = DEFAULT_BLOB_UPLOAD_PARALLELISM;
+        handleData->blobUploadBlockRetries = DEFAULT_BLOB_UPLOAD_BLOCK_RETRIES;
         handleData->deviceId = STRING_construct(config->deviceId);
         if (handleData->deviceId == NULL)
         {
@@ -698,170 +706,206 @@ static int IoTHubClient_LL_UploadToBlob_step3(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HAND
     return result;
 }
 
-IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, const unsigned char* source, size_t size)
+/*performs steps 1 to 3, step 2 uploads either source and size or, when blockSource is not NULL, the blocks it reads*/
+static IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_steps(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* handleData, const char* destinationFileName, const unsigned char* source, size_t size, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* blockSource)
 {
     IOTHUB_CLIENT_RESULT result;
     BUFFER_HANDLE toBeTransmitted;
     int requiredStringLength;
     char* requiredString;
 
-    /*Codes_SRS_IOTHUBCLIENT_LL_02_061: [ If handle is NULL then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
-    /*Codes_SRS_IOTHUBCLIENT_LL_02_062: [ If destinationFileName is NULL then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
-    /*Codes_SRS_IOTHUBCLIENT_LL_02_063: [ If source is NULL and size is greater than 0 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
-    if (
-        (handle == NULL) ||
-        (destinationFileName == NULL) ||
-        ((source == NULL) && (size > 0))
-        )
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_064: [ IoTHubClient_LL_UploadToBlob shall create an HTTPAPIEX_HANDLE to the IoTHub hostname. ]*/
+    HTTPAPIEX_HANDLE iotHubHttpApiExHandle = HTTPAPIEX_Create(handleData->hostname);
+
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_065: [ If creating the HTTPAPIEX_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+    if (iotHubHttpApiExHandle == NULL)
     {
-        LogError("invalid argument detected handle=%p destinationFileName=%p source=%p size=%zu", handle, destinationFileName, source, size);
-        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("unable to HTTPAPIEX_Create");
+        result = IOTHUB_CLIENT_ERROR;
     }
     else
     {
-        IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle;
+        if (
+            (handleData->authorizationScheme == X509) &&
 
-        /*Codes_SRS_IOTHUBCLIENT_LL_02_064: [ IoTHubClient_LL_UploadToBlob shall create an HTTPAPIEX_HANDLE to the IoTHub hostname. ]*/
-        HTTPAPIEX_HANDLE iotHubHttpApiExHandle = HTTPAPIEX_Create(handleData->hostname);
-
-        /*Codes_SRS_IOTHUBCLIENT_LL_02_065: [ If creating the HTTPAPIEX_HANDLE fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-        if (iotHubHttpApiExHandle == NULL)
+            /*transmit the x509certificate and x509privatekey*/
+            /*Codes_SRS_IOTHUBCLIENT_LL_02_106: [ - x509certificate and x509privatekey saved options shall be passed on the HTTPAPIEX_SetOption ]*/
+            (!(
+                (HTTPAPIEX_SetOption(iotHubHttpApiExHandle, OPTION_X509_CERT, handleData->credentials.x509credentials.x509certificate) == HTTPAPIEX_OK) &&
+                (HTTPAPIEX_SetOption(iotHubHttpApiExHandle, OPTION_X509_PRIVATE_KEY, handleData->credentials.x509credentials.x509privatekey) == HTTPAPIEX_OK)
+            ))
+            )
         {
-            LogError("unable to HTTPAPIEX_Create");
+            LogError("unable to HTTPAPIEX_SetOption for x509");
             result = IOTHUB_CLIENT_ERROR;
         }
         else
         {
-            if (
-                (handleData->authorizationScheme == X509) &&
-
-                /*transmit the x509certificate and x509privatekey*/
-                /*Codes_SRS_IOTHUBCLIENT_LL_02_106: [ - x509certificate and x509privatekey saved options shall be passed on the HTTPAPIEX_SetOption ]*/
-                (!(
-                    (HTTPAPIEX_SetOption(iotHubHttpApiExHandle, OPTION_X509_CERT, handleData->credentials.x509credentials.x509certificate) == HTTPAPIEX_OK) &&
-                    (HTTPAPIEX_SetOption(iotHubHttpApiExHandle, OPTION_X509_PRIVATE_KEY, handleData->credentials.x509credentials.x509privatekey) == HTTPAPIEX_OK)
-                ))
-                )
+
+            STRING_HANDLE correlationId = STRING_new();
+            if (correlationId == NULL)
             {
-                LogError("unable to HTTPAPIEX_SetOption for x509");
+                LogError("unable to STRING_new");
                 result = IOTHUB_CLIENT_ERROR;
             }
             else
             {
-
-                STRING_HANDLE correlationId = STRING_new();
-                if (correlationId == NULL)
+                STRING_HANDLE sasUri = STRING_new();
+                if (sasUri == NULL)
                 {
                     LogError("unable to STRING_new");
                     result = IOTHUB_CLIENT_ERROR;
                 }
                 else
                 {
-                    STRING_HANDLE sasUri = STRING_new();
-                    if (sasUri == NULL)
+                    /*Codes_SRS_IOTHUBCLIENT_LL_02_070: [ IoTHubClient_LL_UploadToBlob shall create request HTTP headers. ]*/
+                    HTTP_HEADERS_HANDLE requestHttpHeaders = HTTPHeaders_Alloc(); /*these are build by step 1 and used by step 3 too*/
+                    if (requestHttpHeaders == NULL)
                     {
-                        LogError("unable to STRING_new");
+                        LogError("unable to HTTPHeaders_Alloc");
                         result = IOTHUB_CLIENT_ERROR;
                     }
                     else
                     {
-                        /*Codes_SRS_IOTHUBCLIENT_LL_02_070: [ IoTHubClient_LL_UploadToBlob shall create request HTTP headers. ]*/
-                        HTTP_HEADERS_HANDLE requestHttpHeaders = HTTPHeaders_Alloc(); /*these are build by step 1 and used by step 3 too*/
-                        if (requestHttpHeaders == NULL)
+                        /*do step 1*/
+                        if (IoTHubClient_LL_UploadToBlob_step1and2(handleData, iotHubHttpApiExHandle, requestHttpHeaders, destinationFileName, correlationId, sasUri) != 0)
                         {
-                            LogError("unable to HTTPHeaders_Alloc");
+                            LogError("error in IoTHubClient_LL_UploadToBlob_step1");
                             result = IOTHUB_CLIENT_ERROR;
                         }
                         else
                         {
-                            /*do step 1*/
-                            if (IoTHubClient_LL_UploadToBlob_step1and2(handleData, iotHubHttpApiExHandle, requestHttpHeaders, destinationFileName, correlationId, sasUri) != 0)
+                            /*do step 2.*/
+
+                            unsigned int httpResponse;
+                            BUFFER_HANDLE responseToIoTHub = BUFFER_new();
+                            if (responseToIoTHub == NULL)
                             {
-                                LogError("error in IoTHubClient_LL_UploadToBlob_step1");
                                 result = IOTHUB_CLIENT_ERROR;
+                                LogError("unable to BUFFER_new");
                             }
                             else
                             {
-                                /*do step 2.*/
-
-                                unsigned int httpResponse;
-                                BUFFER_HANDLE responseToIoTHub = BUFFER_new();
-                                if (responseToIoTHub == NULL)
+                                int step2success;
+                                if (blockSource == NULL)
                                 {
-                                    result = IOTHUB_CLIENT_ERROR;
-                                    LogError("unable to BUFFER_new");
+                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_083: [ IoTHubClient_LL_UploadToBlob shall call Blob_UploadFromSasUri and capture the HTTP return code and HTTP body. ]*/
+                                    step2success = (Blob_UploadFromSasUri(STRING_c_str(sasUri), source, size, &httpResponse, responseToIoTHub) == BLOB_OK);
                                 }
                                 else
                                 {
-                                    int step2success;
-                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_083: [ IoTHubClient_LL_UploadToBlob shall call Blob_UploadFromSasUri and capture the HTTP return code and HTTP body. ]*/
-                                    step2success = (Blob_UploadFromSasUri(STRING_c_str(sasUri), source, size, &httpResponse, responseToIoTHub) == BLOB_OK);
-                                    if (!step2success)
-                                    {
-                                        /*Codes_SRS_IOTHUBCLIENT_LL_02_084: [ If Blob_UploadFromSasUri fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
-                                        LogError("unable to Blob_UploadFromSasUri");
+                                    /*Codes_SRS_IOTHUBCLIENT_LL_01_037: [ In step 2 IoTHubClient_LL_UploadMultipleBlocksToBlob shall call Blob_UploadMultipleBlocksFromSasUri passing source and the saved blob_upload_parallelism and blob_upload_block_retries, and capture the HTTP return code and HTTP body. ]*/
+                                    step2success = (Blob_UploadMultipleBlocksFromSasUri(STRING_c_str(sasUri), blockSource, handleData->blobUploadParallelism, handleData->blobUploadBlockRetries, &httpResponse, responseToIoTHub) == BLOB_OK);
+                                }
+                                if (!step2success)
+                                {
+                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_084: [ If Blob_UploadFromSasUri fails then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+                                    LogError("unable to Blob_UploadFromSasUri");
 
-                                        /*do step 3*/ /*try*/
-                                        /*Codes_SRS_IOTHUBCLIENT_LL_02_091: [ If step 2 fails without establishing an HTTP dialogue, then the HTTP message body shall look like: ]*/
-                                        if (BUFFER_build(responseToIoTHub, (const unsigned char*)FILE_UPLOAD_FAILED_BODY, sizeof(FILE_UPLOAD_FAILED_BODY) / sizeof(FILE_UPLOAD_FAILED_BODY[0])) == 0)
+                                    /*do step 3*/ /*try*/
+                                    /*Codes_SRS_IOTHUBCLIENT_LL_02_091: [ If step 2 fails without establishing an HTTP dialogue, then the HTTP message body shall look like: ]*/
+                                    if (BUFFER_build(responseToIoTHub, (const unsigned char*)FILE_UPLOAD_FAILED_BODY, sizeof(FILE_UPLOAD_FAILED_BODY) / sizeof(FILE_UPLOAD_FAILED_BODY[0])) == 0)
+                                    {
+                                        if (IoTHubClient_LL_UploadToBlob_step3(handleData, correlationId, iotHubHttpApiExHandle, requestHttpHeaders, responseToIoTHub) != 0)
                                         {
-                                            if (IoTHubClient_LL_UploadToBlob_step3(handleData, correlationId, iotHubHttpApiExHandle, requestHttpHeaders, responseToIoTHub) != 0)
-                                            {
-                                                LogError("IoTHubClient_LL_UploadToBlob_step3 failed");
-                                            }
+                                            LogError("IoTHubClient_LL_UploadToBlob_step3 failed");
                                         }
+                                    }
+                                    result = IOTHUB_CLIENT_ERROR;
+                                }
+                                else
+                                {
+                                    /*must make a json*/
+
+                                    requiredStringLength = snprintf(NULL, 0, "{\"isSuccess\":%s, \"statusCode\":%d, \"statusDescription\":\"%s\"}", ((httpResponse < 300) ? "true" : "false"), httpResponse, BUFFER_u_char(responseToIoTHub));
+
+                                    requiredString = malloc(requiredStringLength + 1);
+                                    if (requiredString == 0)
+                                    {
+                                        LogError("unable to malloc");
                                         result = IOTHUB_CLIENT_ERROR;
                                     }
                                     else
                                     {
-                                        /*must make a json*/
-
-                                        requiredStringLength = snprintf(NULL, 0, "{\"isSuccess\":%s, \"statusCode\":%d, \"statusDescription\":\"%s\"}", ((httpResponse < 300) ? "true" : "false"), httpResponse, BUFFER_u_char(responseToIoTHub));
-
-                                        requiredString = malloc(requiredStringLength + 1);
-                                        if (requiredString == 0)
+                                        /*do again snprintf*/
+                                        (void)snprintf(requiredString, requiredStringLength + 1, "{\"isSuccess\":%s, \"statusCode\":%d, \"statusDescription\":\"%s\"}", ((httpResponse < 300) ? "true" : "false"), httpResponse, BUFFER_u_char(responseToIoTHub));
+                                        toBeTransmitted = BUFFER_create((const unsigned char*)requiredString, requiredStringLength);
+                                        if (toBeTransmitted == NULL)
                                         {
-                                            LogError("unable to malloc");
+                                            LogError("unable to BUFFER_create");
                                             result = IOTHUB_CLIENT_ERROR;
                                         }
                                         else
                                         {
-                                            /*do again snprintf*/
-                                            (void)snprintf(requiredString, requiredStringLength + 1, "{\"isSuccess\":%s, \"statusCode\":%d, \"statusDescription\":\"%s\"}", ((httpResponse < 300) ? "true" : "false"), httpResponse, BUFFER_u_char(responseToIoTHub));
-                                            toBeTransmitted = BUFFER_create((const unsigned char*)requiredString, requiredStringLength);
-                                            if (toBeTransmitted == NULL)
+                                            if (IoTHubClient_LL_UploadToBlob_step3(handleData, correlationId, iotHubHttpApiExHandle, requestHttpHeaders, toBeTransmitted) != 0)
                                             {
-                                                LogError("unable to BUFFER_create");
+                                                LogError("IoTHubClient_LL_UploadToBlob_step3 failed");
                                                 result = IOTHUB_CLIENT_ERROR;
                                             }
                                             else
                                             {
-                                                if (IoTHubClient_LL_UploadToBlob_step3(handleData, correlationId, iotHubHttpApiExHandle, requestHttpHeaders, toBeTransmitted) != 0)
-                                                {
-                                                    LogError("IoTHubClient_LL_UploadToBlob_step3 failed");
-                                                    result = IOTHUB_CLIENT_ERROR;
-                                                }
-                                                else
-                                                {
-                                                    result = (httpResponse < 300) ? IOTHUB_CLIENT_OK : IOTHUB_CLIENT_ERROR;
-                                                }
-                                                BUFFER_delete(toBeTransmitted);
+                                                result = (httpResponse < 300) ? IOTHUB_CLIENT_OK : IOTHUB_CLIENT_ERROR;
                                             }
-                                            free(requiredString);
+                                            BUFFER_delete(toBeTransmitted);
                                         }
+                                        free(requiredString);
                                     }
-                                    BUFFER_delete(responseToIoTHub);
                                 }
+                                BUFFER_delete(responseToIoTHub);
                             }
-                            HTTPHeaders_Free(requestHttpHeaders);
                         }
-                        STRING_delete(sasUri);
+                        HTTPHeaders_Free(requestHttpHeaders);
                     }
-                    STRING_delete(correlationId);
+                    STRING_delete(sasUri);
                 }
+                STRING_delete(correlationId);
             }
-            HTTPAPIEX_Destroy(iotHubHttpApiExHandle);
         }
+        HTTPAPIEX_Destroy(iotHubHttpApiExHandle);
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, const unsigned char* source, size_t size)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_061: [ If handle is NULL then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_062: [ If destinationFileName is NULL then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    /*Codes_SRS_IOTHUBCLIENT_LL_02_063: [ If source is NULL and size is greater than 0 then IoTHubClient_LL_UploadToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (
+        (handle == NULL) ||
+        (destinationFileName == NULL) ||
+        ((source == NULL) && (size > 0))
+        )
+    {
+        LogError("invalid argument detected handle=%p destinationFileName=%p source=%p size=%zu", handle, destinationFileName, source, size);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        result = IoTHubClient_LL_UploadToBlob_steps((IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle, destinationFileName, source, size, NULL);
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadMultipleBlocksToBlob_Impl(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE handle, const char* destinationFileName, const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source)
+{
+    IOTHUB_CLIENT_RESULT result;
+    /*Codes_SRS_IOTHUBCLIENT_LL_01_034: [ If handle, destinationFileName or source is NULL, or source has no readCallback while its size is not 0, then IoTHubClient_LL_UploadMultipleBlocksToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+    if (
+        (handle == NULL) ||
+        (destinationFileName == NULL) ||
+        (source == NULL) ||
+        ((source->readCallback == NULL) && (source->size > 0))
+        )
+    {
+        LogError("invalid argument detected handle=%p destinationFileName=%p source=%p", handle, destinationFileName, source);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_036: [ IoTHubClient_LL_UploadMultipleBlocksToBlob shall perform steps 1 and 3 the same way IoTHubClient_LL_UploadToBlob does. ]*/
+        result = IoTHubClient_LL_UploadToBlob_steps((IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle, destinationFileName, NULL, 0, source);
     }
     return result;
 }
@@ -924,8 +968,36 @@ IOTHUB_CLIENT_RESULT IoTHubClient_LL_UploadToBlob_SetOption(IOTHUB_CLIENT_LL_UPL
     {
         IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA* handleData = (IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE_DATA*)handle;
 
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_038: [ blob_upload_parallelism - value is a pointer to a size_t, the number of blocks IoTHubClient_LL_UploadMultipleBlocksToBlob uploads at the same time. If it is 0 IoTHubClient_LL_UploadToBlob_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+        if (strcmp(optionName, OPTION_BLOB_UPLOAD_PARALLELISM) == 0)
+        {
+            if ((value == NULL) || (*(const size_t*)value == 0))
+            {
+                LogError("blob_upload_parallelism needs to be at least 1");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->blobUploadParallelism = *(const size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        /*Codes_SRS_IOTHUBCLIENT_LL_01_039: [ blob_upload_block_retries - value is a pointer to a size_t, the number of times IoTHubClient_LL_UploadMultipleBlocksToBlob retries a block. ]*/
+        else if (strcmp(optionName, OPTION_BLOB_UPLOAD_BLOCK_RETRIES) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("blob_upload_block_retries needs a value");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                handleData->blobUploadBlockRetries = *(const size_t*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         /*Codes_SRS_IOTHUBCLIENT_LL_02_100: [ x509certificate - then value then is a null terminated string that contains the x509 certificate. ]*/
-        if (strcmp(optionName, OPTION_X509_CERT) == 0)
+        else if (strcmp(optionName, OPTION_X509_CERT) == 0)
         {
             /*Codes_SRS_IOTHUBCLIENT_LL_02_109: [ If the authentication scheme is NOT x509 then IoTHubClient_LL_UploadToBlob_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
             if (handleData->authorizationScheme != X509)
@@ -0,0 +1,1054 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*the outbound store keeps the events accepted by IoTHubClient_LL_SendEventAsync on disk until the service has
+acknowledged them. It is an append-only log split in numbered segment files "<path>.<n>": appends and releases are
+both records written at the end of the active segment, so nothing is ever rewritten in place. The oldest segments
+are deleted once everything in them has been released, "<path>.head" remembers the number of the oldest segment.*/
+
+#ifndef _WIN32
+/*fileno and fsync are POSIX, not C99*/
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "iothub_client_outbound_store.h"
+
+/*every record is a header followed by its payload, all integers are little endian:
+magic (4) | type (1) | reserved (3) | sequence (8) | payload size (4) | crc32 of the first 20 bytes and of the payload (4)*/
+#define RECORD_MAGIC                0x5342544FUL
+#define RECORD_HEADER_SIZE          24
+#define RECORD_CHECKSUM_OFFSET      20
+#define RECORD_TYPE_DATA            1
+#define RECORD_TYPE_RELEASE         2
+
+/*a sealed segment holding less live payload than segment_size / COMPACTION_LIVE_FRACTION is rewritten by outbound_store_compact*/
+#define COMPACTION_LIVE_FRACTION    4
+
+#define MAX_SEGMENT_SIZE            (UINT32_MAX / 2)
+#define FILE_NAME_SUFFIX_SIZE       32
+
+typedef struct STORED_RECORD_TAG
+{
+    uint64_t sequence;
+    uint32_t segment;
+    uint32_t offset; /*of the record header in its segment*/
+    uint32_t size; /*of the payload*/
+    bool is_released;
+} STORED_RECORD;
+
+typedef struct STORE_SEGMENT_TAG
+{
+    size_t live_count;
+    size_t live_bytes;
+} STORE_SEGMENT;
+
+typedef struct OUTBOUND_STORE_INSTANCE_TAG
+{
+    char* path;
+    char* file_name;
+    char* other_file_name;
+    size_t segment_size;
+    FILE* active_file;
+    uint32_t first_segment;
+    uint32_t active_segment;
+    size_t active_size;
+    STORE_SEGMENT* segments; /*segments[0] is first_segment, segments[active_segment - first_segment] is the active one*/
+    size_t segment_capacity;
+    STORED_RECORD* records; /*ordered by sequence, the ones in [record_head, record_count) that are not released are pending*/
+    size_t record_head;
+    size_t record_count;
+    size_t record_capacity;
+    size_t pending_count;
+    uint64_t next_sequence;
+    bool is_dirty; /*records were written since the last sync*/
+    unsigned char* scratch;
+    size_t scratch_size;
+} OUTBOUND_STORE_INSTANCE;
+
+typedef struct SEQUENCE_LIST_TAG
+{
+    uint64_t* items;
+    size_t count;
+    size_t capacity;
+} SEQUENCE_LIST;
+
+static const uint32_t CRC32_NIBBLE_TABLE[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t size)
+{
+    size_t index;
+    for (index = 0; index < size; index++)
+    {
+        crc ^= data[index];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+static void put_uint32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)(value & 0xFF);
+    destination[1] = (unsigned char)((value >> 8) & 0xFF);
+    destination[2] = (unsigned char)((value >> 16) & 0xFF);
+    destination[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static uint32_t get_uint32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static uint32_t get_record_checksum(const unsigned char* header, const unsigned char* payload, size_t size)
+{
+    uint32_t crc = crc32_update(0xFFFFFFFF, header, RECORD_CHECKSUM_OFFSET);
+    return crc32_update(crc, payload, size) ^ 0xFFFFFFFF;
+}
+
+static void encode_record_header(unsigned char* header, unsigned char type, uint64_t sequence, const unsigned char* payload, uint32_t size)
+{
+    put_uint32(header, RECORD_MAGIC);
+    header[4] = type;
+    header[5] = 0;
+    header[6] = 0;
+    header[7] = 0;
+    put_uint32(header + 8, (uint32_t)(sequence & 0xFFFFFFFF));
+    put_uint32(header + 12, (uint32_t)(sequence >> 32));
+    put_uint32(header + 16, size);
+    put_uint32(header + RECORD_CHECKSUM_OFFSET, get_record_checksum(header, payload, size));
+}
+
+static int sync_file(FILE* file)
+{
+    int result;
+    if (fflush(file) != 0)
+    {
+        LogError("Failure flushing the outbound store");
+        result = __FAILURE__;
+    }
+#ifdef _WIN32
+    else if (_commit(_fileno(file)) != 0)
+#else
+    else if (fsync(fileno(file)) != 0)
+#endif
+    {
+        LogError("Failure syncing the outbound store to disk");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static const char* format_segment_name(const OUTBOUND_STORE_INSTANCE* store, char* buffer, uint32_t segment)
+{
+    (void)sprintf(buffer, "%s.%lu", store->path, (unsigned long)segment);
+    return buffer;
+}
+
+static const char* format_head_name(const OUTBOUND_STORE_INSTANCE* store, char* buffer, const char* suffix)
+{
+    (void)sprintf(buffer, "%s.head%s", store->path, suffix);
+    return buffer;
+}
+
+static int ensure_scratch(OUTBOUND_STORE_INSTANCE* store, size_t size)
+{
+    int result;
+    if (size <= store->scratch_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        unsigned char* scratch = (unsigned char*)realloc(store->scratch, size);
+        if (scratch == NULL)
+        {
+            LogError("Failure allocating %lu bytes for an outbound store record", (unsigned long)size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            store->scratch = scratch;
+            store->scratch_size = size;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*makes room for one more record at records[record_count]*/
+static int reserve_record(OUTBOUND_STORE_INSTANCE* store)
+{
+    int result;
+    if ((store->record_head > 0) && (store->record_head >= store->record_count / 2))
+    {
+        /*the released records at the front are not needed anymore*/
+        (void)memmove(store->records, store->records + store->record_head, (store->record_count - store->record_head) * sizeof(STORED_RECORD));
+        store->record_count -= store->record_head;
+        store->record_head = 0;
+    }
+
+    if (store->record_count < store->record_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t capacity = (store->record_capacity == 0) ? 64 : store->record_capacity * 2;
+        STORED_RECORD* records = (STORED_RECORD*)realloc(store->records, capacity * sizeof(STORED_RECORD));
+        if (records == NULL)
+        {
+            LogError("Failure growing the outbound store index");
+            result = __FAILURE__;
+        }
+        else
+        {
+            store->records = records;
+            store->record_capacity = capacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int add_sequence(SEQUENCE_LIST* list, uint64_t sequence)
+{
+    int result;
+    if (list->count == list->capacity)
+    {
+        size_t capacity = (list->capacity == 0) ? 64 : list->capacity * 2;
+        uint64_t* items = (uint64_t*)realloc(list->items, capacity * sizeof(uint64_t));
+        if (items == NULL)
+        {
+            LogError("Failure growing the list of released records");
+            result = __FAILURE__;
+        }
+        else
+        {
+            list->items = items;
+            list->capacity = capacity;
+        }
+    }
+
+    if (list->count < list->capacity)
+    {
+        list->items[list->count++] = sequence;
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+    return result;
+}
+
+/*makes room for the state of active_segment*/
+static int add_segment(OUTBOUND_STORE_INSTANCE* store)
+{
+    int result;
+    size_t index = store->active_segment - store->first_segment;
+    if (index < store->segment_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t capacity = (store->segment_capacity == 0) ? 8 : store->segment_capacity * 2;
+        STORE_SEGMENT* segments = (STORE_SEGMENT*)realloc(store->segments, capacity * sizeof(STORE_SEGMENT));
+        if (segments == NULL)
+        {
+            LogError("Failure growing the outbound store segment list");
+            result = __FAILURE__;
+        }
+        else
+        {
+            store->segments = segments;
+            store->segment_capacity = capacity;
+            result = 0;
+        }
+    }
+
+    if (result == 0)
+    {
+        store->segments[index].live_count = 0;
+        store->segments[index].live_bytes = 0;
+    }
+    return result;
+}
+
+static int open_active_segment(OUTBOUND_STORE_INSTANCE* store)
+{
+    int result;
+    if (add_segment(store) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((store->active_file = fopen(format_segment_name(store, store->file_name, store->active_segment), "wb")) == NULL)
+    {
+        LogError("Failure creating outbound store segment %s", store->file_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        store->active_size = 0;
+        result = 0;
+    }
+    return result;
+}
+
+static int rotate_segment(OUTBOUND_STORE_INSTANCE* store)
+{
+    int result;
+    /*a sealed segment is never written again, this is the only sync that is not batched by outbound_store_commit*/
+    if (sync_file(store->active_file) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)fclose(store->active_file);
+        store->active_file = NULL;
+        store->is_dirty = false;
+        store->active_segment++;
+        result = open_active_segment(store);
+    }
+    return result;
+}
+
+/*abandons the active segment after a failed write. What was written before the failure stays readable, the partial
+record ends the segment for the next scan, so the following records have to go to a new segment*/
+static void abandon_active_segment(OUTBOUND_STORE_INSTANCE* store)
+{
+    if (store->is_dirty && (sync_file(store->active_file) != 0))
+    {
+        LogError("The records appended to outbound store segment %lu before the failure may not be durable", (unsigned long)store->active_segment);
+    }
+    (void)fclose(store->active_file);
+    store->active_file = NULL;
+    store->is_dirty = false;
+    store->active_segment++;
+    if (open_active_segment(store) != 0)
+    {
+        LogError("Failure starting a new outbound store segment, the next write tries again");
+    }
+}
+
+static int write_record(OUTBOUND_STORE_INSTANCE* store, unsigned char type, uint64_t sequence, const unsigned char* payload, uint32_t size, uint32_t* segment, uint32_t* offset)
+{
+    int result;
+    unsigned char header[RECORD_HEADER_SIZE];
+
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_012: [ If the active segment could not be created, the next write shall try to create it again. ]*/
+    if ((store->active_file == NULL) && (open_active_segment(store) != 0))
+    {
+        LogError("The outbound store has no active segment");
+        result = __FAILURE__;
+    }
+    else if ((store->active_size > 0) &&
+        (store->active_size + RECORD_HEADER_SIZE + size > store->segment_size) &&
+        (rotate_segment(store) != 0))
+    {
+        result = __FAILURE__;
+    }
+    else if (store->active_file == NULL)
+    {
+        LogError("The outbound store has no active segment");
+        result = __FAILURE__;
+    }
+    else
+    {
+        encode_record_header(header, type, sequence, payload, size);
+        if ((fwrite(header, 1, RECORD_HEADER_SIZE, store->active_file) != RECORD_HEADER_SIZE) ||
+            ((size > 0) && (fwrite(payload, 1, size, store->active_file) != size)))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_011: [ If a record cannot be written, only that record shall fail: the records that follow it shall be written to a new segment. ]*/
+            LogError("Failure writing to outbound store segment %lu", (unsigned long)store->active_segment);
+            abandon_active_segment(store);
+            result = __FAILURE__;
+        }
+        else
+        {
+            *segment = store->active_segment;
+            *offset = (uint32_t)store->active_size;
+            store->active_size += RECORD_HEADER_SIZE + size;
+            store->is_dirty = true;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*index of the first record with a sequence that is not smaller than sequence*/
+static size_t find_first_record(OUTBOUND_STORE_INSTANCE* store, uint64_t sequence)
+{
+    size_t low = store->record_head;
+    size_t high = store->record_count;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (store->records[middle].sequence < sequence)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static STORED_RECORD* find_record(OUTBOUND_STORE_INSTANCE* store, uint64_t sequence)
+{
+    STORED_RECORD* result = NULL;
+    size_t index = find_first_record(store, sequence);
+    if ((index < store->record_count) && (store->records[index].sequence == sequence) && !store->records[index].is_released)
+    {
+        result = &store->records[index];
+    }
+    return result;
+}
+
+static int read_head_file(OUTBOUND_STORE_INSTANCE* store, uint32_t* first_segment)
+{
+    int result;
+    FILE* head = fopen(format_head_name(store, store->file_name, ""), "rb");
+    if (head == NULL)
+    {
+        /*the head is replaced by renaming a temporary file, on platforms where rename does not replace there is a window where only the temporary exists*/
+        head = fopen(format_head_name(store, store->file_name, ".tmp"), "rb");
+    }
+
+    if (head == NULL)
+    {
+        /*a new store*/
+        *first_segment = 0;
+        result = 0;
+    }
+    else
+    {
+        unsigned long value;
+        if (fscanf(head, "%lu", &value) != 1)
+        {
+            LogError("Outbound store head %s is not readable", store->file_name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            *first_segment = (uint32_t)value;
+            result = 0;
+        }
+        (void)fclose(head);
+    }
+    return result;
+}
+
+static int write_head_file(OUTBOUND_STORE_INSTANCE* store, uint32_t first_segment)
+{
+    int result;
+    FILE* head = fopen(format_head_name(store, store->other_file_name, ".tmp"), "wb");
+    if (head == NULL)
+    {
+        LogError("Failure creating outbound store head %s", store->other_file_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        bool is_written = (fprintf(head, "%lu\n", (unsigned long)first_segment) > 0) && (sync_file(head) == 0);
+        (void)fclose(head);
+        if (!is_written)
+        {
+            LogError("Failure writing outbound store head %s", store->other_file_name);
+            result = __FAILURE__;
+        }
+        else if ((rename(store->other_file_name, format_head_name(store, store->file_name, "")) != 0) &&
+            ((remove(store->file_name) != 0) || (rename(store->other_file_name, store->file_name) != 0)))
+        {
+            LogError("Failure replacing outbound store head %s", store->file_name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*deletes the oldest sealed segments for as long as nothing in them is pending*/
+static void remove_released_segments(OUTBOUND_STORE_INSTANCE* store)
+{
+    size_t released_count = 0;
+    size_t sealed_count = store->active_segment - store->first_segment;
+    while ((released_count < sealed_count) && (store->segments[released_count].live_count == 0))
+    {
+        released_count++;
+    }
+
+    if (released_count > 0)
+    {
+        /*the head moves first, a crash before the files are removed leaves files that the next open removes*/
+        if (write_head_file(store, store->first_segment + (uint32_t)released_count) == 0)
+        {
+            size_t index;
+            for (index = 0; index < released_count; index++)
+            {
+                if (remove(format_segment_name(store, store->file_name, store->first_segment + (uint32_t)index)) != 0)
+                {
+                    LogError("Failure removing outbound store segment %s", store->file_name);
+                }
+            }
+            (void)memmove(store->segments, store->segments + released_count, (store->active_segment - store->first_segment + 1 - released_count) * sizeof(STORE_SEGMENT));
+            store->first_segment += (uint32_t)released_count;
+        }
+    }
+}
+
+static void drop_released_head(OUTBOUND_STORE_INSTANCE* store)
+{
+    while ((store->record_head < store->record_count) && store->records[store->record_head].is_released)
+    {
+        store->record_head++;
+    }
+
+    if (store->record_head == store->record_count)
+    {
+        store->record_head = 0;
+        store->record_count = 0;
+    }
+}
+
+/*reads every record of one segment. A record that is cut short or fails its checksum ends the segment: that is where
+the process stopped writing, so nothing after it was ever acknowledged as committed*/
+static int scan_segment(OUTBOUND_STORE_INSTANCE* store, FILE* file, uint32_t segment, SEQUENCE_LIST* releases, uint64_t* last_sequence)
+{
+    int result = 0;
+    long length;
+
+    if ((fseek(file, 0, SEEK_END) != 0) || ((length = ftell(file)) < 0) || (fseek(file, 0, SEEK_SET) != 0))
+    {
+        LogError("Failure reading outbound store segment %lu", (unsigned long)segment);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t offset = 0;
+        unsigned char header[RECORD_HEADER_SIZE];
+        while ((result == 0) && (offset + RECORD_HEADER_SIZE <= (size_t)length))
+        {
+            uint64_t sequence;
+            uint32_t size;
+            if (fread(header, 1, RECORD_HEADER_SIZE, file) != RECORD_HEADER_SIZE)
+            {
+                break;
+            }
+
+            sequence = (uint64_t)get_uint32(header + 8) | ((uint64_t)get_uint32(header + 12) << 32);
+            size = get_uint32(header + 16);
+            if ((get_uint32(header) != RECORD_MAGIC) ||
+                ((header[4] != RECORD_TYPE_DATA) && (header[4] != RECORD_TYPE_RELEASE)) ||
+                (size > (size_t)length - offset - RECORD_HEADER_SIZE))
+            {
+                LogError("Outbound store segment %lu ends with an incomplete record at offset %lu", (unsigned long)segment, (unsigned long)offset);
+                break;
+            }
+            else if (ensure_scratch(store, size) != 0)
+            {
+                result = __FAILURE__;
+            }
+            else if (((size > 0) && (fread(store->scratch, 1, size, file) != size)) ||
+                (get_record_checksum(header, store->scratch, size) != get_uint32(header + RECORD_CHECKSUM_OFFSET)))
+            {
+                LogError("Outbound store segment %lu has a corrupted record at offset %lu", (unsigned long)segment, (unsigned long)offset);
+                break;
+            }
+            else
+            {
+                if (header[4] == RECORD_TYPE_RELEASE)
+                {
+                    result = add_sequence(releases, sequence);
+                }
+                else if ((result = reserve_record(store)) == 0)
+                {
+                    STORED_RECORD* record = &store->records[store->record_count++];
+                    record->sequence = sequence;
+                    record->segment = segment;
+                    record->offset = (uint32_t)offset;
+                    record->size = size;
+                    record->is_released = false;
+                }
+
+                if (sequence > *last_sequence)
+                {
+                    *last_sequence = sequence;
+                }
+                offset += RECORD_HEADER_SIZE + size;
+            }
+        }
+    }
+    return result;
+}
+
+static int compare_records(const void* left, const void* right)
+{
+    const STORED_RECORD* left_record = (const STORED_RECORD*)left;
+    const STORED_RECORD* right_record = (const STORED_RECORD*)right;
+    return (left_record->sequence < right_record->sequence) ? -1 :
+        (left_record->sequence > right_record->sequence) ? 1 :
+        (left_record->segment < right_record->segment) ? -1 :
+        (left_record->segment > right_record->segment) ? 1 : 0;
+}
+
+/*sorts the scanned records, drops the copies left behind by an interrupted compaction and the released ones*/
+static void index_records(OUTBOUND_STORE_INSTANCE* store, const SEQUENCE_LIST* releases)
+{
+    size_t index;
+    size_t kept = 0;
+
+    if (store->record_count > 1)
+    {
+        qsort(store->records, store->record_count, sizeof(STORED_RECORD), compare_records);
+    }
+    for (index = 0; index < store->record_count; index++)
+    {
+        /*the copy in the newest segment is the one that survives*/
+        if ((index + 1 == store->record_count) || (store->records[index + 1].sequence != store->records[index].sequence))
+        {
+            store->records[kept++] = store->records[index];
+        }
+    }
+    store->record_count = kept;
+
+    for (index = 0; index < releases->count; index++)
+    {
+        STORED_RECORD* record = find_record(store, releases->items[index]);
+        if (record != NULL)
+        {
+            record->is_released = true;
+        }
+    }
+
+    kept = 0;
+    for (index = 0; index < store->record_count; index++)
+    {
+        if (!store->records[index].is_released)
+        {
+            STORE_SEGMENT* segment = &store->segments[store->records[index].segment - store->first_segment];
+            segment->live_count++;
+            segment->live_bytes += store->records[index].size;
+            store->records[kept++] = store->records[index];
+        }
+    }
+    store->record_count = kept;
+    store->pending_count = kept;
+}
+
+static int load_segments(OUTBOUND_STORE_INSTANCE* store)
+{
+    int result;
+    uint32_t first_segment;
+
+    if (read_head_file(store, &first_segment) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SEQUENCE_LIST releases = { NULL, 0, 0 };
+        uint64_t last_sequence = 0;
+        FILE* file;
+        uint32_t orphan = first_segment;
+
+        /*segments that were released right before a crash*/
+        while ((orphan > 0) && (remove(format_segment_name(store, store->file_name, orphan - 1)) == 0))
+        {
+            orphan--;
+        }
+
+        store->first_segment = first_segment;
+        store->active_segment = first_segment;
+        result = 0;
+        while ((result == 0) && ((file = fopen(format_segment_name(store, store->file_name, store->active_segment), "rb")) != NULL))
+        {
+            if ((add_segment(store) != 0) ||
+                (scan_segment(store, file, store->active_segment, &releases, &last_sequence) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                store->active_segment++;
+            }
+            (void)fclose(file);
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_003: [ outbound_store_open shall always append to a new segment, so a record cut short by a crash is never followed by new records. ]*/
+        if ((result == 0) && (open_active_segment(store) == 0))
+        {
+            index_records(store, &releases);
+            store->next_sequence = last_sequence + 1;
+            remove_released_segments(store);
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+        free(releases.items);
+    }
+    return result;
+}
+
+OUTBOUND_STORE_HANDLE outbound_store_open(const char* path, size_t segment_size)
+{
+    OUTBOUND_STORE_INSTANCE* result;
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_001: [ If path is NULL or segment_size is 0 or too large to be addressed with 32 bits, outbound_store_open shall fail and return NULL. ]*/
+    if ((path == NULL) || (segment_size == 0) || (segment_size > MAX_SEGMENT_SIZE))
+    {
+        LogError("Invalid argument (path=%p, segment_size=%lu)", path, (unsigned long)segment_size);
+        result = NULL;
+    }
+    else if ((result = (OUTBOUND_STORE_INSTANCE*)malloc(sizeof(OUTBOUND_STORE_INSTANCE))) == NULL)
+    {
+        LogError("Failure allocating the outbound store");
+    }
+    else
+    {
+        size_t path_length = strlen(path);
+        (void)memset(result, 0, sizeof(OUTBOUND_STORE_INSTANCE));
+        result->segment_size = segment_size;
+
+        if (((result->path = (char*)malloc(path_length + 1)) == NULL) ||
+            ((result->file_name = (char*)malloc(path_length + FILE_NAME_SUFFIX_SIZE)) == NULL) ||
+            ((result->other_file_name = (char*)malloc(path_length + FILE_NAME_SUFFIX_SIZE)) == NULL))
+        {
+            LogError("Failure allocating the outbound store file names");
+            outbound_store_close(result);
+            result = NULL;
+        }
+        else
+        {
+            (void)memcpy(result->path, path, path_length + 1);
+            /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_002: [ outbound_store_open shall read every segment left by a previous instance, verify the checksum of every record and keep the data records that were not released as pending. ]*/
+            if (load_segments(result) != 0)
+            {
+                LogError("Failure loading the outbound store %s", path);
+                outbound_store_close(result);
+                result = NULL;
+            }
+        }
+    }
+    return result;
+}
+
+static int read_records(OUTBOUND_STORE_INSTANCE* store, uint64_t* sequence, size_t max_count, OUTBOUND_STORE_ON_RECORD on_record, void* context)
+{
+    int result = 0;
+    FILE* file = NULL;
+    uint32_t file_segment = 0;
+    size_t read_count = 0;
+    size_t index;
+
+    if ((store->active_file != NULL) && (fflush(store->active_file) != 0))
+    {
+        LogError("Failure flushing the outbound store");
+        result = __FAILURE__;
+    }
+
+    for (index = find_first_record(store, *sequence); (result == 0) && (read_count < max_count) && (index < store->record_count); index++)
+    {
+        STORED_RECORD record = store->records[index];
+        if (!record.is_released)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_016: [ A record that cannot be read shall be skipped, it stays pending, and outbound_store_read shall return a non-zero value. ]*/
+            *sequence = record.sequence + 1;
+            if ((file == NULL) || (file_segment != record.segment))
+            {
+                if (file != NULL)
+                {
+                    (void)fclose(file);
+                }
+                file_segment = record.segment;
+                file = fopen(format_segment_name(store, store->file_name, file_segment), "rb");
+            }
+
+            if ((file == NULL) ||
+                (ensure_scratch(store, record.size) != 0) ||
+                (fseek(file, (long)record.offset + RECORD_HEADER_SIZE, SEEK_SET) != 0) ||
+                ((record.size > 0) && (fread(store->scratch, 1, record.size, file) != record.size)))
+            {
+                LogError("Failure reading outbound store record %lu", (unsigned long)record.sequence);
+                result = __FAILURE__;
+            }
+            else
+            {
+                read_count++;
+                on_record(context, record.sequence, store->scratch, record.size);
+            }
+        }
+    }
+
+    if ((result == 0) && (read_count < max_count))
+    {
+        /*every pending record was read, what comes next is appended later*/
+        *sequence = store->next_sequence;
+    }
+
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return result;
+}
+
+int outbound_store_replay(OUTBOUND_STORE_HANDLE handle, OUTBOUND_STORE_ON_RECORD on_record, void* context)
+{
+    int result;
+    if ((handle == NULL) || (on_record == NULL))
+    {
+        LogError("Invalid argument (handle=%p, on_record=%p)", handle, on_record);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t sequence = 0;
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_004: [ outbound_store_replay shall call on_record for every pending record, in the order they were appended. on_record may release the record it is given. ]*/
+        result = read_records(handle, &sequence, SIZE_MAX, on_record, context);
+    }
+    return result;
+}
+
+int outbound_store_read(OUTBOUND_STORE_HANDLE handle, uint64_t* sequence, size_t max_count, OUTBOUND_STORE_ON_RECORD on_record, void* context)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_013: [ If handle, sequence or on_record is NULL, outbound_store_read shall fail and return a non-zero value. ]*/
+    if ((handle == NULL) || (sequence == NULL) || (on_record == NULL))
+    {
+        LogError("Invalid argument (handle=%p, sequence=%p, on_record=%p)", handle, sequence, on_record);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_014: [ outbound_store_read shall call on_record, in order, for at most max_count pending records whose sequence is not smaller than *sequence, and set *sequence past the last record it read. on_record may release the record it is given. ]*/
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_015: [ When fewer than max_count records were read, outbound_store_read shall set *sequence to the sequence the next outbound_store_append returns. ]*/
+        result = read_records(handle, sequence, max_count, on_record, context);
+    }
+    return result;
+}
+
+int outbound_store_append(OUTBOUND_STORE_HANDLE handle, const unsigned char* data, size_t size, uint64_t* sequence)
+{
+    int result;
+    if ((handle == NULL) || ((data == NULL) && (size > 0)) || (sequence == NULL) || (size > handle->segment_size))
+    {
+        LogError("Invalid argument (handle=%p, data=%p, size=%lu, sequence=%p)", handle, data, (unsigned long)size, sequence);
+        result = __FAILURE__;
+    }
+    else if (reserve_record(handle) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        STORED_RECORD* record = &handle->records[handle->record_count];
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_005: [ outbound_store_append shall write a data record at the end of the active segment, starting a new segment when the record would not fit, and return its sequence number. The record is durable once outbound_store_commit returns. ]*/
+        if (write_record(handle, RECORD_TYPE_DATA, handle->next_sequence, data, (uint32_t)size, &record->segment, &record->offset) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            STORE_SEGMENT* segment = &handle->segments[record->segment - handle->first_segment];
+            record->sequence = handle->next_sequence++;
+            record->size = (uint32_t)size;
+            record->is_released = false;
+            handle->record_count++;
+            handle->pending_count++;
+            segment->live_count++;
+            segment->live_bytes += size;
+            *sequence = record->sequence;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+int outbound_store_commit(OUTBOUND_STORE_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_006: [ outbound_store_commit shall flush and sync the active segment once for all the records written since the previous commit, and do nothing if there were none. ]*/
+    else if (!handle->is_dirty)
+    {
+        result = 0;
+    }
+    else if ((handle->active_file == NULL) || (sync_file(handle->active_file) != 0))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        handle->is_dirty = false;
+        result = 0;
+    }
+    return result;
+}
+
+int outbound_store_release(OUTBOUND_STORE_HANDLE handle, uint64_t sequence)
+{
+    int result;
+    STORED_RECORD* record;
+    uint32_t segment;
+    uint32_t offset;
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_008: [ If sequence is not pending, outbound_store_release shall fail and return a non-zero value. ]*/
+    else if ((record = find_record(handle, sequence)) == NULL)
+    {
+        LogError("Outbound store record %lu is not pending", (unsigned long)sequence);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_007: [ outbound_store_release shall append a release record for sequence, and delete the oldest segments once none of their records is pending. ]*/
+    else if (write_record(handle, RECORD_TYPE_RELEASE, sequence, NULL, 0, &segment, &offset) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        STORE_SEGMENT* record_segment = &handle->segments[record->segment - handle->first_segment];
+        record->is_released = true;
+        record_segment->live_count--;
+        record_segment->live_bytes -= record->size;
+        handle->pending_count--;
+        drop_released_head(handle);
+        remove_released_segments(handle);
+        result = 0;
+    }
+    return result;
+}
+
+int outbound_store_compact(OUTBOUND_STORE_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_009: [ When the oldest segment is sealed and less than a quarter of segment_size of it is pending, outbound_store_compact shall copy its pending records to the active segment, sync it and delete the oldest segment. ]*/
+    else if ((handle->first_segment == handle->active_segment) ||
+        (handle->segments[0].live_count == 0) ||
+        (handle->segments[0].live_bytes >= handle->segment_size / COMPACTION_LIVE_FRACTION))
+    {
+        result = 0;
+    }
+    else
+    {
+        uint32_t compacted_segment = handle->first_segment;
+        FILE* file = fopen(format_segment_name(handle, handle->file_name, compacted_segment), "rb");
+        if (file == NULL)
+        {
+            LogError("Failure opening outbound store segment %s", handle->file_name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t index;
+            result = 0;
+            for (index = handle->record_head; (result == 0) && (index < handle->record_count); index++)
+            {
+                STORED_RECORD* record = &handle->records[index];
+                if (!record->is_released && (record->segment == compacted_segment))
+                {
+                    uint32_t segment;
+                    uint32_t offset;
+                    if ((ensure_scratch(handle, record->size) != 0) ||
+                        (fseek(file, (long)record->offset + RECORD_HEADER_SIZE, SEEK_SET) != 0) ||
+                        ((record->size > 0) && (fread(handle->scratch, 1, record->size, file) != record->size)) ||
+                        (write_record(handle, RECORD_TYPE_DATA, record->sequence, handle->scratch, record->size, &segment, &offset) != 0))
+                    {
+                        LogError("Failure compacting outbound store record %lu", (unsigned long)record->sequence);
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        /*the copy keeps the sequence, if the old segment outlives a crash the newest copy wins at the next open*/
+                        handle->segments[0].live_count--;
+                        handle->segments[0].live_bytes -= record->size;
+                        handle->segments[segment - handle->first_segment].live_count++;
+                        handle->segments[segment - handle->first_segment].live_bytes += record->size;
+                        record->segment = segment;
+                        record->offset = offset;
+                    }
+                }
+            }
+            (void)fclose(file);
+
+            /*the copies have to be on disk before the originals go away*/
+            if ((result == 0) && (outbound_store_commit(handle) == 0))
+            {
+                remove_released_segments(handle);
+            }
+            else
+            {
+                result = __FAILURE__;
+            }
+        }
+    }
+    return result;
+}
+
+size_t outbound_store_get_pending_count(OUTBOUND_STORE_HANDLE handle)
+{
+    return (handle == NULL) ? 0 : handle->pending_count;
+}
+
+void outbound_store_close(OUTBOUND_STORE_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_010: [ outbound_store_close shall commit the records not committed yet, close the active segment and free all the resources. The segments stay on disk. ]*/
+        if (handle->active_file != NULL)
+        {
+            if (handle->is_dirty)
+            {
+                (void)sync_file(handle->active_file);
+            }
+            (void)fclose(handle->active_file);
+        }
+        free(handle->scratch);
+        free(handle->records);
+        free(handle->segments);
+        free(handle->other_file_name);
+        free(handle->file_name);
+        free(handle->path);
+        free(handle);
+    }
+}
@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*the payload compressor turns event bodies into zlib streams (RFC 1950, what HTTP calls "deflate"). One z_stream is
+kept for the lifetime of the client and reset for every event, so its ~256KB of state is allocated once. An optional
+preset dictionary (RFC 1950 FDICT) primes the window with the text the events have in common, which is what makes
+short JSON documents compress; its Adler-32 is written in every stream header so the receiver can pick the right one.*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include "zlib.h"
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "iothub_client_payload_compressor.h"
+
+/*deflate only looks at the last 32KB of the dictionary*/
+#define MAX_DICTIONARY_SIZE     32768
+
+typedef struct PAYLOAD_COMPRESSOR_INSTANCE_TAG
+{
+    z_stream stream;
+    unsigned char* dictionary;
+    size_t dictionary_size;
+    /*grown to the largest event seen minus one byte, anything that does not fit is not worth sending compressed*/
+    unsigned char* output;
+    size_t output_size;
+} PAYLOAD_COMPRESSOR_INSTANCE;
+
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    void* result;
+    (void)opaque;
+    if ((size != 0) && (items > SIZE_MAX / size))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = malloc((size_t)items * size);
+    }
+    return result;
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    free(address);
+}
+
+PAYLOAD_COMPRESSOR_HANDLE payload_compressor_create(const unsigned char* dictionary, size_t dictionary_size)
+{
+    PAYLOAD_COMPRESSOR_INSTANCE* result;
+    /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_001: [ If dictionary is NULL while dictionary_size is not 0, payload_compressor_create shall fail and return NULL. ]*/
+    if ((dictionary == NULL) && (dictionary_size != 0))
+    {
+        LogError("invalid arg const unsigned char* dictionary=%p, size_t dictionary_size=%zu", dictionary, dictionary_size);
+        result = NULL;
+    }
+    else if ((result = (PAYLOAD_COMPRESSOR_INSTANCE*)malloc(sizeof(PAYLOAD_COMPRESSOR_INSTANCE))) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_003: [ If any allocation fails, payload_compressor_create shall fail and return NULL. ]*/
+        LogError("unable to malloc the payload compressor");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(PAYLOAD_COMPRESSOR_INSTANCE));
+        result->stream.zalloc = zlib_alloc;
+        result->stream.zfree = zlib_free;
+        result->stream.opaque = Z_NULL;
+
+        /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_002: [ payload_compressor_create shall keep a copy of at most the last 32KB of dictionary. ]*/
+        if (dictionary_size > MAX_DICTIONARY_SIZE)
+        {
+            dictionary += dictionary_size - MAX_DICTIONARY_SIZE;
+            dictionary_size = MAX_DICTIONARY_SIZE;
+        }
+
+        if ((dictionary_size != 0) &&
+            ((result->dictionary = (unsigned char*)malloc(dictionary_size)) == NULL))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_003: [ If any allocation fails, payload_compressor_create shall fail and return NULL. ]*/
+            LogError("unable to malloc the compression dictionary");
+            free(result);
+            result = NULL;
+        }
+        /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_004: [ payload_compressor_create shall initialize a single deflate stream with the default compression level and a 32KB window. ]*/
+        else if (deflateInit2(&result->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_003: [ If any allocation fails, payload_compressor_create shall fail and return NULL. ]*/
+            LogError("deflateInit2 failed");
+            free(result->dictionary);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            if (dictionary_size != 0)
+            {
+                (void)memcpy(result->dictionary, dictionary, dictionary_size);
+            }
+            result->dictionary_size = dictionary_size;
+        }
+    }
+    return result;
+}
+
+int payload_compressor_deflate(PAYLOAD_COMPRESSOR_HANDLE handle, const unsigned char* source, size_t size, const unsigned char** compressed, size_t* compressed_size)
+{
+    int result;
+    /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_005: [ If handle, compressed or compressed_size is NULL, or source is NULL while size is not 0, payload_compressor_deflate shall fail and return a non-zero value. ]*/
+    if ((handle == NULL) || (compressed == NULL) || (compressed_size == NULL) || ((source == NULL) && (size != 0)))
+    {
+        LogError("invalid arg PAYLOAD_COMPRESSOR_HANDLE handle=%p, const unsigned char* source=%p, const unsigned char** compressed=%p, size_t* compressed_size=%p", handle, source, compressed, compressed_size);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_006: [ If the zlib stream of source would not be smaller than size bytes, payload_compressor_deflate shall return a non-zero value without logging an error. ]*/
+    else if ((size < 2) || (size > UINT_MAX))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        PAYLOAD_COMPRESSOR_INSTANCE* compressor = (PAYLOAD_COMPRESSOR_INSTANCE*)handle;
+        size_t output_size = size - 1;
+
+        if (compressor->output_size < output_size)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_008: [ The output buffer shall be reused across calls and only grown when source is larger than any previous one. ]*/
+            unsigned char* output = (unsigned char*)realloc(compressor->output, output_size);
+            if (output == NULL)
+            {
+                LogError("unable to realloc the compression buffer to %zu bytes", output_size);
+            }
+            else
+            {
+                compressor->output = output;
+                compressor->output_size = output_size;
+            }
+        }
+
+        if (compressor->output_size < output_size)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_009: [ If any zlib call or allocation fails, payload_compressor_deflate shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else if (deflateReset(&compressor->stream) != Z_OK)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_009: [ If any zlib call or allocation fails, payload_compressor_deflate shall fail and return a non-zero value. ]*/
+            LogError("deflateReset failed");
+            result = __FAILURE__;
+        }
+        else if ((compressor->dictionary_size != 0) &&
+            (deflateSetDictionary(&compressor->stream, compressor->dictionary, (uInt)compressor->dictionary_size) != Z_OK))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_009: [ If any zlib call or allocation fails, payload_compressor_deflate shall fail and return a non-zero value. ]*/
+            LogError("deflateSetDictionary failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            int deflate_result;
+            /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_007: [ payload_compressor_deflate shall compress source in a single deflate call, with the dictionary when one was given, and return in compressed and compressed_size the zlib stream, which stays valid until the next call. ]*/
+            compressor->stream.next_in = (Bytef*)source;
+            compressor->stream.avail_in = (uInt)size;
+            compressor->stream.next_out = compressor->output;
+            compressor->stream.avail_out = (uInt)output_size;
+
+            deflate_result = deflate(&compressor->stream, Z_FINISH);
+            if (deflate_result == Z_STREAM_END)
+            {
+                *compressed = compressor->output;
+                *compressed_size = (size_t)compressor->stream.total_out;
+                result = 0;
+            }
+            else if ((deflate_result == Z_OK) || (deflate_result == Z_BUF_ERROR))
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_006: [ If the zlib stream of source would not be smaller than size bytes, payload_compressor_deflate shall return a non-zero value without logging an error. ]*/
+                result = __FAILURE__;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_009: [ If any zlib call or allocation fails, payload_compressor_deflate shall fail and return a non-zero value. ]*/
+                LogError("deflate failed (%d)", deflate_result);
+                result = __FAILURE__;
+            }
+        }
+    }
+    return result;
+}
+
+void payload_compressor_destroy(PAYLOAD_COMPRESSOR_HANDLE handle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_010: [ If handle is NULL, payload_compressor_destroy shall do nothing. ]*/
+    if (handle != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_011: [ payload_compressor_destroy shall end the deflate stream and free all the resources. ]*/
+        (void)deflateEnd(&handle->stream);
+        free(handle->output);
+        free(handle->dictionary);
+        free(handle);
+    }
+}
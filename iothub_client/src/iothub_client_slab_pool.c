@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*the slab pool hands out fixed size records from a single block allocated up front, so the bookkeeping a client
+allocates for every event does not go through the heap once the pool is warm. The free records are chained through
+their own first bytes. When the block is exhausted the pool falls back to malloc and counts it, so a caller can tell
+whether the preallocation is large enough for its steady state.*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "iothub_client_slab_pool.h"
+
+typedef union SLAB_POOL_ALIGNMENT_TAG
+{
+    void* pointer;
+    uint64_t integer;
+    double real;
+} SLAB_POOL_ALIGNMENT;
+
+typedef struct SLAB_POOL_FREE_ITEM_TAG
+{
+    struct SLAB_POOL_FREE_ITEM_TAG* next;
+} SLAB_POOL_FREE_ITEM;
+
+typedef struct SLAB_POOL_INSTANCE_TAG
+{
+    unsigned char* items;
+    size_t item_size;
+    size_t capacity;
+    SLAB_POOL_FREE_ITEM* free_items;
+    size_t heap_allocation_count;
+} SLAB_POOL_INSTANCE;
+
+#define ROUND_UP_TO_ALIGNMENT(size) ((((size) + sizeof(SLAB_POOL_ALIGNMENT) - 1) / sizeof(SLAB_POOL_ALIGNMENT)) * sizeof(SLAB_POOL_ALIGNMENT))
+
+SLAB_POOL_HANDLE slab_pool_create(size_t item_size, size_t capacity)
+{
+    SLAB_POOL_INSTANCE* result;
+
+    /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_001: [ If item_size or capacity is 0, slab_pool_create shall fail and return NULL. ]*/
+    if ((item_size == 0) || (capacity == 0))
+    {
+        LogError("Invalid argument (item_size=%lu, capacity=%lu)", (unsigned long)item_size, (unsigned long)capacity);
+        result = NULL;
+    }
+    else
+    {
+        size_t header_size = ROUND_UP_TO_ALIGNMENT(sizeof(SLAB_POOL_INSTANCE));
+        size_t rounded_item_size;
+
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_002: [ slab_pool_create shall round item_size up so that every item is aligned for any type and can hold the free list link. ]*/
+        if (item_size < sizeof(SLAB_POOL_FREE_ITEM))
+        {
+            item_size = sizeof(SLAB_POOL_FREE_ITEM);
+        }
+
+        if (item_size > SIZE_MAX - sizeof(SLAB_POOL_ALIGNMENT))
+        {
+            rounded_item_size = 0;
+        }
+        else
+        {
+            rounded_item_size = ROUND_UP_TO_ALIGNMENT(item_size);
+        }
+
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_003: [ If the size of the pool cannot be represented in a size_t, slab_pool_create shall fail and return NULL. ]*/
+        if ((rounded_item_size == 0) || (capacity > (SIZE_MAX - header_size) / rounded_item_size))
+        {
+            LogError("Pool of %lu items of %lu bytes is too large", (unsigned long)capacity, (unsigned long)item_size);
+            result = NULL;
+        }
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_004: [ slab_pool_create shall allocate the pool and its capacity items with a single allocation. ]*/
+        else if ((result = (SLAB_POOL_INSTANCE*)malloc(header_size + (capacity * rounded_item_size))) == NULL)
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_005: [ If the allocation fails, slab_pool_create shall fail and return NULL. ]*/
+            LogError("Failed allocating pool of %lu items", (unsigned long)capacity);
+        }
+        else
+        {
+            size_t index;
+
+            result->items = (unsigned char*)result + header_size;
+            result->item_size = rounded_item_size;
+            result->capacity = capacity;
+            result->heap_allocation_count = 0;
+
+            /*the free list is built backwards so the items are handed out in address order*/
+            result->free_items = NULL;
+            for (index = capacity; index > 0; index--)
+            {
+                SLAB_POOL_FREE_ITEM* free_item = (SLAB_POOL_FREE_ITEM*)(result->items + ((index - 1) * rounded_item_size));
+                free_item->next = result->free_items;
+                result->free_items = free_item;
+            }
+        }
+    }
+
+    return result;
+}
+
+void* slab_pool_alloc(SLAB_POOL_HANDLE handle)
+{
+    void* result;
+
+    if (handle == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_006: [ If handle is NULL, slab_pool_alloc shall fail and return NULL. ]*/
+        LogError("Invalid argument (handle=NULL)");
+        result = NULL;
+    }
+    else if (handle->free_items != NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_007: [ slab_pool_alloc shall return a free item of the pool without allocating memory. ]*/
+        result = handle->free_items;
+        handle->free_items = handle->free_items->next;
+    }
+    /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_008: [ When all the items of the pool are in use, slab_pool_alloc shall allocate the item with malloc and count the allocation. ]*/
+    else if ((result = malloc(handle->item_size)) == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_009: [ If that allocation fails, slab_pool_alloc shall return NULL. ]*/
+        LogError("Pool exhausted and failed allocating an item");
+    }
+    else
+    {
+        handle->heap_allocation_count++;
+    }
+
+    return result;
+}
+
+void slab_pool_free(SLAB_POOL_HANDLE handle, void* item)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_010: [ If handle or item is NULL, slab_pool_free shall do nothing. ]*/
+    if ((handle != NULL) && (item != NULL))
+    {
+        unsigned char* address = (unsigned char*)item;
+
+        if ((address >= handle->items) && (address < handle->items + (handle->capacity * handle->item_size)))
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_011: [ An item of the pool shall be put back in the pool. ]*/
+            SLAB_POOL_FREE_ITEM* free_item = (SLAB_POOL_FREE_ITEM*)item;
+            free_item->next = handle->free_items;
+            handle->free_items = free_item;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_012: [ An item allocated by slab_pool_alloc with malloc shall be freed. ]*/
+            free(item);
+        }
+    }
+}
+
+size_t slab_pool_get_heap_allocation_count(SLAB_POOL_HANDLE handle)
+{
+    size_t result;
+
+    if (handle == NULL)
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_013: [ If handle is NULL, slab_pool_get_heap_allocation_count shall return 0. ]*/
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_014: [ slab_pool_get_heap_allocation_count shall return the number of items slab_pool_alloc allocated with malloc since the pool was created. ]*/
+        result = handle->heap_allocation_count;
+    }
+
+    return result;
+}
+
+void slab_pool_destroy(SLAB_POOL_HANDLE handle)
+{
+    /*Codes_SRS_IOTHUB_CLIENT_SLAB_POOL_01_015: [ slab_pool_destroy shall free the pool and all its items. If handle is NULL, slab_pool_destroy shall do nothing. ]*/
+    if (handle != NULL)
+    {
+        free(handle);
+    }
+}
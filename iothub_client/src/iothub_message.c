@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -26,8 +27,37 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     MAP_HANDLE properties;
     char* messageId;
     char* correlationId;
+    /*set when the payload is a caller owned buffer (IoTHubMessage_CreateFromByteArrayNoCopy), value.byteArray is then NULL*/
+    bool isExternalByteArray;
+    const unsigned char* externalByteArray;
+    size_t externalSize;
+    IOTHUB_MESSAGE_RELEASE_CALLBACK releaseCallback;
+    void* releaseContext;
+    /*"name=value&name=value" text handed over by a transport (IoTHubMessage_SetDeferredProperties), moved into properties on first use*/
+    char* deferredProperties;
+    /*set for the messages of an IOTHUB_MESSAGE_POOL_HANDLE, IoTHubMessage_Destroy gives them back to the pool*/
+    struct IOTHUB_MESSAGE_POOL_TAG* pool;
+    struct IOTHUB_MESSAGE_HANDLE_DATA_TAG* nextFree;
+    /*a pooled message keeps its content in pooledContent (followed by '\0'), value is then not used.
+    The storage, the properties map and the id strings stay with the message while it is in the pool*/
+    bool isPooledContent;
+    unsigned char* pooledContent;
+    size_t pooledContentSize;
+    size_t pooledContentCapacity;
+    char* spareMessageId;
+    size_t spareMessageIdCapacity;
+    char* spareCorrelationId;
+    size_t spareCorrelationIdCapacity;
 }IOTHUB_MESSAGE_HANDLE_DATA;
 
+typedef struct IOTHUB_MESSAGE_POOL_TAG
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* messages;
+    size_t capacity;
+    IOTHUB_MESSAGE_HANDLE_DATA* freeMessages;
+    size_t heapAllocationCount;
+} IOTHUB_MESSAGE_POOL;
+
 static bool ContainsOnlyUsAscii(const char* asciiValue)
 {
     bool result = true;
@@ -60,6 +90,37 @@ static int ValidateAsciiCharactersFilter(const char* mapKey, const char* mapValu
     return result;
 }
 
+static void release_content(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
+{
+    if (handleData->isPooledContent)
+    {
+        /*the storage stays with the pooled message*/
+    }
+    else if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        if (handleData->isExternalByteArray)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_027: [ If the message was created by IoTHubMessage_CreateFromByteArrayNoCopy, IoTHubMessage_Destroy shall call releaseCallback (if not NULL) passing the byte array, its size and releaseContext. ]*/
+            if (handleData->releaseCallback != NULL)
+            {
+                handleData->releaseCallback(handleData->externalByteArray, handleData->externalSize, handleData->releaseContext);
+            }
+        }
+        else
+        {
+            BUFFER_delete(handleData->value.byteArray);
+        }
+    }
+    else if (handleData->contentType == IOTHUBMESSAGE_STRING)
+    {
+        STRING_delete(handleData->value.string);
+    }
+    else
+    {
+        LogError("Unknown contentType in IoTHubMessage");
+    }
+}
+
 IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byteArray, size_t size)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
@@ -127,6 +188,14 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byt
                     result->contentType = IOTHUBMESSAGE_BYTEARRAY;
                     result->messageId = NULL;
                     result->correlationId = NULL;
+                    result->isExternalByteArray = false;
+                    result->externalByteArray = NULL;
+                    result->externalSize = 0;
+                    result->releaseCallback = NULL;
+                    result->releaseContext = NULL;
+                    result->deferredProperties = NULL;
+                    result->pool = NULL;
+                    result->isPooledContent = false;
                     /*all is fine, return result*/
                 }
             }
@@ -178,13 +247,136 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
                 result->contentType = IOTHUBMESSAGE_STRING;
                 result->messageId = NULL;
                 result->correlationId = NULL;
+                result->isExternalByteArray = false;
+                result->externalByteArray = NULL;
+                result->externalSize = 0;
+                result->releaseCallback = NULL;
+                result->releaseContext = NULL;
+                result->deferredProperties = NULL;
+                result->pool = NULL;
+                result->isPooledContent = false;
+            }
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArrayNoCopy(const unsigned char* byteArray, size_t size, IOTHUB_MESSAGE_RELEASE_CALLBACK releaseCallback, void* releaseContext)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    /*Codes_SRS_IOTHUBMESSAGE_01_020: [ If byteArray is NULL and size is not 0, IoTHubMessage_CreateFromByteArrayNoCopy shall return NULL. ]*/
+    if ((byteArray == NULL) && (size != 0))
+    {
+        LogError("Invalid argument - byteArray is NULL");
+        result = NULL;
+    }
+    else
+    {
+        result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
+        if (result == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_021: [ If there are any errors then IoTHubMessage_CreateFromByteArrayNoCopy shall return NULL and shall not call releaseCallback. ]*/
+            LogError("unable to malloc");
+        }
+        /*Codes_SRS_IOTHUBMESSAGE_01_022: [ IoTHubMessage_CreateFromByteArrayNoCopy shall call Map_Create to create the message properties. ]*/
+        else if ((result->properties = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_021: [ If there are any errors then IoTHubMessage_CreateFromByteArrayNoCopy shall return NULL and shall not call releaseCallback. ]*/
+            LogError("Map_Create failed");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_023: [ IoTHubMessage_CreateFromByteArrayNoCopy shall not copy byteArray, the message shall reference it until it is destroyed. ]*/
+            /*Codes_SRS_IOTHUBMESSAGE_01_024: [ The type of the new message shall be IOTHUBMESSAGE_BYTEARRAY. ]*/
+            result->contentType = IOTHUBMESSAGE_BYTEARRAY;
+            result->value.byteArray = NULL;
+            result->messageId = NULL;
+            result->correlationId = NULL;
+            result->isExternalByteArray = true;
+            result->externalByteArray = byteArray;
+            result->externalSize = size;
+            result->releaseCallback = releaseCallback;
+            result->releaseContext = releaseContext;
+            result->deferredProperties = NULL;
+            result->pool = NULL;
+            result->isPooledContent = false;
+        }
+    }
+    return result;
+}
+
+static int materialize_deferred_properties(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
+{
+    int result = 0;
+    if (handleData->deferredProperties != NULL)
+    {
+        char* pair = handleData->deferredProperties;
+        while ((pair != NULL) && (result == 0))
+        {
+            char* separator = strchr(pair, '&');
+            char* equals;
+            if (separator != NULL)
+            {
+                *separator = '\0';
+            }
+
+            /*Codes_SRS_IOTHUBMESSAGE_01_032: [ Pairs that do not contain '=' shall be skipped. ]*/
+            if ((equals = strchr(pair, '=')) != NULL)
+            {
+                *equals = '\0';
+                /*Codes_SRS_IOTHUBMESSAGE_01_031: [ The first call to IoTHubMessage_Properties after IoTHubMessage_SetDeferredProperties shall add every name=value pair of the deferred text to the properties map by calling Map_AddOrUpdate and then release the deferred text. ]*/
+                if (Map_AddOrUpdate(handleData->properties, pair, equals + 1) != MAP_OK)
+                {
+                    LogError("Map_AddOrUpdate failed for deferred property");
+                    result = __FAILURE__;
+                }
+                *equals = '=';
+            }
+
+            /*the text is put back together as it is walked so that it is still whole if a pair fails*/
+            if (separator != NULL)
+            {
+                *separator = '&';
+                pair = separator + 1;
+            }
+            else
+            {
+                pair = NULL;
             }
         }
+
+        /*Codes_SRS_IOTHUBMESSAGE_01_054: [ If adding a deferred property fails, the deferred text shall be kept so that the next call adds every pair again. ]*/
+        if (result == 0)
+        {
+            free(handleData->deferredProperties);
+            handleData->deferredProperties = NULL;
+        }
     }
     return result;
 }
 
 /*Codes_SRS_IOTHUBMESSAGE_03_001: [IoTHubMessage_Clone shall create a new IoT hub message with data content identical to that of the iotHubMessageHandle parameter.]*/
+static BUFFER_HANDLE clone_byte_array(const IOTHUB_MESSAGE_HANDLE_DATA* source)
+{
+    BUFFER_HANDLE result;
+    if (source->isPooledContent)
+    {
+        result = BUFFER_create(source->pooledContent, source->pooledContentSize);
+    }
+    else if (source->isExternalByteArray)
+    {
+        unsigned char temp = 0x00;
+        result = BUFFER_create((source->externalSize == 0) ? &temp : source->externalByteArray, source->externalSize);
+    }
+    else
+    {
+        result = BUFFER_clone(source->value.byteArray);
+    }
+    return result;
+}
+
 IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
@@ -195,6 +387,13 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         result = NULL;
         LogError("iotHubMessageHandle parameter cannot be NULL for IoTHubMessage_Clone");
     }
+    /*Codes_SRS_IOTHUBMESSAGE_01_034: [ IoTHubMessage_Clone shall move any deferred properties of iotHubMessageHandle into its properties map before cloning it. ]*/
+    else if (materialize_deferred_properties((IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle) != 0)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_03_004: [IoTHubMessage_Clone shall return NULL if it fails for any reason.]*/
+        result = NULL;
+        LogError("unable to apply the deferred properties of the source message");
+    }
     else
     {
         result = (IOTHUB_MESSAGE_HANDLE_DATA*)malloc(sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
@@ -209,6 +408,15 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
         {
             result->messageId = NULL;
             result->correlationId = NULL;
+            /*Codes_SRS_IOTHUBMESSAGE_01_025: [ The clone of a message created by IoTHubMessage_CreateFromByteArrayNoCopy shall own a copy of the byte array. ]*/
+            result->isExternalByteArray = false;
+            result->externalByteArray = NULL;
+            result->externalSize = 0;
+            result->releaseCallback = NULL;
+            result->releaseContext = NULL;
+            result->deferredProperties = NULL;
+            result->pool = NULL;
+            result->isPooledContent = false;
             if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
             {
                 LogError("unable to Copy messageId");
@@ -229,7 +437,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
             else if (source->contentType == IOTHUBMESSAGE_BYTEARRAY)
             {
                 /*Codes_SRS_IOTHUBMESSAGE_02_006: [IoTHubMessage_Clone shall clone to content by a call to BUFFER_clone] */
-                if ((result->value.byteArray = BUFFER_clone(source->value.byteArray)) == NULL)
+                if ((result->value.byteArray = clone_byte_array(source)) == NULL)
                 {
                     /*Codes_SRS_IOTHUBMESSAGE_03_004: [IoTHubMessage_Clone shall return NULL if it fails for any reason.]*/
                     LogError("unable to BUFFER_clone");
@@ -275,7 +483,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
             else /*can only be STRING*/
             {
                 /*Codes_SRS_IOTHUBMESSAGE_02_006: [IoTHubMessage_Clone shall clone the content by a call to BUFFER_clone or STRING_clone] */
-                if ((result->value.string = STRING_clone(source->value.string)) == NULL)
+                if ((result->value.string = (source->isPooledContent ? STRING_construct((const char*)source->pooledContent) : STRING_clone(source->value.string))) == NULL)
                 {
                     /*Codes_SRS_IOTHUBMESSAGE_03_004: [IoTHubMessage_Clone shall return NULL if it fails for any reason.]*/
                     if (result->messageId)
@@ -322,6 +530,275 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
     return result;
 }
 
+/*moves a string of a pooled message to its spare storage, where the next IoTHubMessage_CloneFromPool finds it*/
+static void keep_spare_string(char** value, char** spare, size_t* spareCapacity)
+{
+    if (*value != NULL)
+    {
+        if (*spare != NULL)
+        {
+            free(*spare);
+        }
+        *spareCapacity = strlen(*value) + 1;
+        *spare = *value;
+        *value = NULL;
+    }
+}
+
+static int copy_pooled_string(IOTHUB_MESSAGE_POOL* pool, char** value, char** spare, size_t* spareCapacity, const char* source)
+{
+    int result;
+    if (source == NULL)
+    {
+        *value = NULL;
+        result = 0;
+    }
+    else
+    {
+        size_t length = strlen(source) + 1;
+        if ((*spare != NULL) && (*spareCapacity >= length))
+        {
+            (void)memcpy(*spare, source, length);
+            *value = *spare;
+            *spare = NULL;
+            result = 0;
+        }
+        else
+        {
+            pool->heapAllocationCount++;
+            if (mallocAndStrcpy_s(value, source) != 0)
+            {
+                LogError("unable to copy a string of the message");
+                *value = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (*spare != NULL)
+                {
+                    free(*spare);
+                    *spare = NULL;
+                }
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+static void get_content(const IOTHUB_MESSAGE_HANDLE_DATA* handleData, const unsigned char** content, size_t* size)
+{
+    if (handleData->isPooledContent)
+    {
+        *content = handleData->pooledContent;
+        *size = handleData->pooledContentSize;
+    }
+    else if (handleData->contentType == IOTHUBMESSAGE_STRING)
+    {
+        *content = (const unsigned char*)STRING_c_str(handleData->value.string);
+        *size = STRING_length(handleData->value.string);
+    }
+    else if (handleData->isExternalByteArray)
+    {
+        *content = handleData->externalByteArray;
+        *size = handleData->externalSize;
+    }
+    else
+    {
+        *content = BUFFER_u_char(handleData->value.byteArray);
+        *size = BUFFER_length(handleData->value.byteArray);
+    }
+}
+
+static int copy_pooled_content(IOTHUB_MESSAGE_POOL* pool, IOTHUB_MESSAGE_HANDLE_DATA* message, const IOTHUB_MESSAGE_HANDLE_DATA* source)
+{
+    int result;
+    const unsigned char* content;
+    size_t size;
+    get_content(source, &content, &size);
+
+    if (size >= message->pooledContentCapacity)
+    {
+        /*one more byte for the '\0' of a string content*/
+        unsigned char* storage = (unsigned char*)malloc(size + 1);
+        pool->heapAllocationCount++;
+        if (storage == NULL)
+        {
+            LogError("unable to allocate %lu bytes for the content of the message", (unsigned long)(size + 1));
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message->pooledContent != NULL)
+            {
+                free(message->pooledContent);
+            }
+            message->pooledContent = storage;
+            message->pooledContentCapacity = size + 1;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        if (size != 0)
+        {
+            (void)memcpy(message->pooledContent, content, size);
+        }
+        message->pooledContent[size] = '\0';
+        message->pooledContentSize = size;
+    }
+    return result;
+}
+
+/*Map_AddOrUpdate appends new keys, so a property added to a pooled message after it was cloned (such as the
+"content-encoding" of a compressed event) follows the keys it was cloned with*/
+static bool starts_with_keys(const char* const* keys, size_t count, const char* const* otherKeys, size_t otherCount)
+{
+    bool result = (count >= otherCount);
+    size_t index;
+    for (index = 0; result && (index < otherCount); index++)
+    {
+        result = (strcmp(keys[index], otherKeys[index]) == 0);
+    }
+    return result;
+}
+
+static int copy_pooled_properties(IOTHUB_MESSAGE_POOL* pool, IOTHUB_MESSAGE_HANDLE_DATA* message, MAP_HANDLE source)
+{
+    int result;
+    const char* const* sourceKeys;
+    const char* const* sourceValues;
+    size_t sourceCount;
+    const char* const* keys;
+    const char* const* values;
+    size_t count;
+
+    if (Map_GetInternals(source, &sourceKeys, &sourceValues, &sourceCount) != MAP_OK)
+    {
+        LogError("unable to read the properties of the message");
+        result = __FAILURE__;
+    }
+    else if ((message->properties == NULL) ||
+        (Map_GetInternals(message->properties, &keys, &values, &count) != MAP_OK) ||
+        !starts_with_keys(keys, count, sourceKeys, sourceCount))
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_045: [ When the pooled message has no properties map yet, or its map does not start with the keys of the properties of iotHubMessageHandle in the same order, IoTHubMessage_CloneFromPool shall replace it with a Map_Clone of them. ]*/
+        MAP_HANDLE properties = Map_Clone(source);
+        pool->heapAllocationCount++;
+        if (properties == NULL)
+        {
+            LogError("unable to Map_Clone");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (message->properties != NULL)
+            {
+                Map_Destroy(message->properties);
+            }
+            message->properties = properties;
+            result = 0;
+        }
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_046: [ Otherwise IoTHubMessage_CloneFromPool shall keep the properties map of the pooled message and only call Map_AddOrUpdate for the values that differ. ]*/
+        size_t index;
+        result = 0;
+        /*Codes_SRS_IOTHUBMESSAGE_01_055: [ Keys of the pooled message that follow the keys of iotHubMessageHandle shall be removed with Map_Delete, from the last one. ]*/
+        while ((result == 0) && (count > sourceCount))
+        {
+            pool->heapAllocationCount++;
+            if (Map_Delete(message->properties, keys[count - 1]) != MAP_OK)
+            {
+                LogError("unable to remove the property %s", keys[count - 1]);
+                result = __FAILURE__;
+            }
+            else if (Map_GetInternals(message->properties, &keys, &values, &count) != MAP_OK)
+            {
+                LogError("unable to read the properties of the pooled message");
+                result = __FAILURE__;
+            }
+        }
+        for (index = 0; (result == 0) && (index < sourceCount); index++)
+        {
+            if (strcmp(values[index], sourceValues[index]) != 0)
+            {
+                pool->heapAllocationCount++;
+                if (Map_AddOrUpdate(message->properties, sourceKeys[index], sourceValues[index]) != MAP_OK)
+                {
+                    LogError("unable to update the property %s", sourceKeys[index]);
+                    result = __FAILURE__;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static void recycle_pooled_message(IOTHUB_MESSAGE_HANDLE_DATA* message)
+{
+    release_content(message);
+    message->isPooledContent = false;
+    if (message->deferredProperties != NULL)
+    {
+        free(message->deferredProperties);
+        message->deferredProperties = NULL;
+    }
+    keep_spare_string(&message->messageId, &message->spareMessageId, &message->spareMessageIdCapacity);
+    keep_spare_string(&message->correlationId, &message->spareCorrelationId, &message->spareCorrelationIdCapacity);
+}
+
+static int clone_into_pooled_message(IOTHUB_MESSAGE_POOL* pool, IOTHUB_MESSAGE_HANDLE_DATA* message, const IOTHUB_MESSAGE_HANDLE_DATA* source)
+{
+    int result;
+    /*nothing to release until the content is in place*/
+    message->isPooledContent = true;
+    message->contentType = source->contentType;
+    message->value.byteArray = NULL;
+    message->isExternalByteArray = false;
+    message->externalByteArray = NULL;
+    message->externalSize = 0;
+    message->releaseCallback = NULL;
+    message->releaseContext = NULL;
+    message->deferredProperties = NULL;
+    message->messageId = NULL;
+    message->correlationId = NULL;
+
+    /*Codes_SRS_IOTHUBMESSAGE_01_044: [ IoTHubMessage_CloneFromPool shall copy the content, message id and correlation id of iotHubMessageHandle into the storage the pooled message already has, and only allocate when that storage is too small. ]*/
+    if (copy_pooled_content(pool, message, source) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (copy_pooled_string(pool, &message->messageId, &message->spareMessageId, &message->spareMessageIdCapacity, source->messageId) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (copy_pooled_string(pool, &message->correlationId, &message->spareCorrelationId, &message->spareCorrelationIdCapacity, source->correlationId) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (copy_pooled_properties(pool, message, source->properties) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result != 0)
+    {
+        recycle_pooled_message(message);
+    }
+    return result;
+}
+
 IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
 {
     IOTHUB_MESSAGE_RESULT result;
@@ -346,10 +823,64 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMes
         }
         else
         {
-            /*Codes_SRS_IOTHUBMESSAGE_01_011: [The pointer shall be obtained by using BUFFER_u_char and it shall be copied in the buffer argument.]*/
-            *buffer = BUFFER_u_char(handleData->value.byteArray);
-            /*Codes_SRS_IOTHUBMESSAGE_01_012: [The size of the associated data shall be obtained by using BUFFER_length and it shall be copied to the size argument.]*/
-            *size = BUFFER_length(handleData->value.byteArray);
+            if (handleData->isPooledContent)
+            {
+                *buffer = handleData->pooledContent;
+                *size = handleData->pooledContentSize;
+            }
+            else if (handleData->isExternalByteArray)
+            {
+                /*Codes_SRS_IOTHUBMESSAGE_01_026: [ For a message created by IoTHubMessage_CreateFromByteArrayNoCopy, IoTHubMessage_GetByteArray shall return the caller owned byte array and its size. ]*/
+                *buffer = handleData->externalByteArray;
+                *size = handleData->externalSize;
+            }
+            else
+            {
+                /*Codes_SRS_IOTHUBMESSAGE_01_011: [The pointer shall be obtained by using BUFFER_u_char and it shall be copied in the buffer argument.]*/
+                *buffer = BUFFER_u_char(handleData->value.byteArray);
+                /*Codes_SRS_IOTHUBMESSAGE_01_012: [The size of the associated data shall be obtained by using BUFFER_length and it shall be copied to the size argument.]*/
+                *size = BUFFER_length(handleData->value.byteArray);
+            }
+            result = IOTHUB_MESSAGE_OK;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char* byteArray, size_t size)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    /*Codes_SRS_IOTHUBMESSAGE_01_036: [ If iotHubMessageHandle is NULL, or byteArray is NULL while size is not 0, IoTHubMessage_SetByteArray shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    if ((iotHubMessageHandle == NULL) || ((byteArray == NULL) && (size != 0)))
+    {
+        LogError("invalid arg passed to IoTHubMessage_SetByteArray IOTHUB_MESSAGE_HANDLE iotHubMessageHandle=%p, const unsigned char* byteArray=%p, size_t size=%zu", iotHubMessageHandle, byteArray, size);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
+        /*Codes_SRS_IOTHUBMESSAGE_01_037: [ IoTHubMessage_SetByteArray shall copy byteArray by calling BUFFER_create. ]*/
+        unsigned char temp = 0x00;
+        BUFFER_HANDLE content = BUFFER_create((size == 0) ? &temp : byteArray, size);
+        if (content == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_038: [ If BUFFER_create fails, IoTHubMessage_SetByteArray shall return IOTHUB_MESSAGE_ERROR and leave the message unchanged. ]*/
+            LogError("unable to BUFFER_create the new content");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_039: [ IoTHubMessage_SetByteArray shall then release the previous content the same way IoTHubMessage_Destroy does, including calling the releaseCallback of a message created by IoTHubMessage_CreateFromByteArrayNoCopy. ]*/
+            release_content(handleData);
+            /*Codes_SRS_IOTHUBMESSAGE_01_040: [ IoTHubMessage_SetByteArray shall set the content type of the message to IOTHUBMESSAGE_BYTEARRAY and return IOTHUB_MESSAGE_OK. ]*/
+            handleData->contentType = IOTHUBMESSAGE_BYTEARRAY;
+            handleData->value.byteArray = content;
+            handleData->isPooledContent = false;
+            handleData->isExternalByteArray = false;
+            handleData->externalByteArray = NULL;
+            handleData->externalSize = 0;
+            handleData->releaseCallback = NULL;
+            handleData->releaseContext = NULL;
             result = IOTHUB_MESSAGE_OK;
         }
     }
@@ -375,7 +906,7 @@ const char* IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
         else
         {
             /*Codes_SRS_IOTHUBMESSAGE_02_018: [IoTHubMessage_GetStringData shall return the currently stored null terminated string.] */
-            result = STRING_c_str(handleData->value.string);
+            result = handleData->isPooledContent ? (const char*)handleData->pooledContent : STRING_c_str(handleData->value.string);
         }
     }
     return result;
@@ -409,9 +940,57 @@ MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     }
     else
     {
-        /*Codes_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle it shall return a non-NULL MAP_HANDLE.]*/
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
-        result = handleData->properties;
+        if (materialize_deferred_properties(handleData) != 0)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_033: [ If adding a deferred property fails, IoTHubMessage_Properties shall return NULL. ]*/
+            LogError("unable to apply the deferred message properties");
+            result = NULL;
+        }
+        else
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle whose deferred properties (if any) were added it shall return a non-NULL MAP_HANDLE.]*/
+            result = handleData->properties;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetDeferredProperties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const char* properties, size_t length)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    /*Codes_SRS_IOTHUBMESSAGE_01_028: [ If iotHubMessageHandle is NULL, or properties is NULL while length is not 0, IoTHubMessage_SetDeferredProperties shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    if ((iotHubMessageHandle == NULL) || ((properties == NULL) && (length != 0)))
+    {
+        LogError("invalid arg passed to IoTHubMessage_SetDeferredProperties");
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_HANDLE_DATA* handleData = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
+        /*Codes_SRS_IOTHUBMESSAGE_01_035: [ Deferred properties already pending on the message shall be moved into the properties map first. ]*/
+        if (materialize_deferred_properties(handleData) != 0)
+        {
+            LogError("unable to apply the pending deferred properties");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else if (length == 0)
+        {
+            result = IOTHUB_MESSAGE_OK;
+        }
+        /*Codes_SRS_IOTHUBMESSAGE_01_029: [ IoTHubMessage_SetDeferredProperties shall keep a single copy of the length characters of properties and shall not touch the properties map. ]*/
+        else if ((handleData->deferredProperties = (char*)malloc(length + 1)) == NULL)
+        {
+            /*Codes_SRS_IOTHUBMESSAGE_01_030: [ If the copy cannot be allocated, IoTHubMessage_SetDeferredProperties shall return IOTHUB_MESSAGE_ERROR. ]*/
+            LogError("unable to malloc the deferred properties");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else
+        {
+            (void)memcpy(handleData->deferredProperties, properties, length);
+            handleData->deferredProperties[length] = '\0';
+            result = IOTHUB_MESSAGE_OK;
+        }
     }
     return result;
 }
@@ -520,25 +1099,144 @@ void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     /*Codes_SRS_IOTHUBMESSAGE_01_004: [If iotHubMessageHandle is NULL, IoTHubMessage_Destroy shall do nothing.] */
     if (iotHubMessageHandle != NULL)
     {
-        /*Codes_SRS_IOTHUBMESSAGE_01_003: [IoTHubMessage_Destroy shall free all resources associated with iotHubMessageHandle.]  */
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = iotHubMessageHandle;
-        if (handleData->contentType == IOTHUBMESSAGE_BYTEARRAY)
+        if (handleData->pool != NULL)
         {
-            BUFFER_delete(handleData->value.byteArray);
+            /*Codes_SRS_IOTHUBMESSAGE_01_048: [ A message taken from a pool shall be given back to it, keeping the storage of its content, its properties map and the storage of its message id and correlation id for the next IoTHubMessage_CloneFromPool. ]*/
+            recycle_pooled_message(handleData);
+            handleData->nextFree = handleData->pool->freeMessages;
+            handleData->pool->freeMessages = handleData;
         }
-        else if (handleData->contentType == IOTHUBMESSAGE_STRING)
+        else
         {
-            STRING_delete(handleData->value.string);
+            /*Codes_SRS_IOTHUBMESSAGE_01_003: [IoTHubMessage_Destroy shall free all resources associated with iotHubMessageHandle.]  */
+            release_content(handleData);
+            Map_Destroy(handleData->properties);
+            free(handleData->deferredProperties);
+            free(handleData->messageId);
+            handleData->messageId = NULL;
+            free(handleData->correlationId);
+            handleData->correlationId = NULL;
+            free(handleData);
         }
-        else
+    }
+}
+
+IOTHUB_MESSAGE_POOL_HANDLE IoTHubMessage_CreatePool(size_t capacity)
+{
+    IOTHUB_MESSAGE_POOL* result;
+    /*Codes_SRS_IOTHUBMESSAGE_01_041: [ If capacity is 0 or the pool would not fit in a size_t, IoTHubMessage_CreatePool shall fail and return NULL. ]*/
+    if ((capacity == 0) || (capacity > (((size_t)-1) - sizeof(IOTHUB_MESSAGE_POOL)) / sizeof(IOTHUB_MESSAGE_HANDLE_DATA)))
+    {
+        LogError("invalid capacity %lu", (unsigned long)capacity);
+        result = NULL;
+    }
+    /*Codes_SRS_IOTHUBMESSAGE_01_042: [ IoTHubMessage_CreatePool shall allocate the pool and its capacity messages with a single allocation, the content storage and properties map of a message are only allocated when it is first used. ]*/
+    else if ((result = (IOTHUB_MESSAGE_POOL*)malloc(sizeof(IOTHUB_MESSAGE_POOL) + (capacity * sizeof(IOTHUB_MESSAGE_HANDLE_DATA)))) == NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_043: [ If the allocation fails, IoTHubMessage_CreatePool shall return NULL. ]*/
+        LogError("unable to malloc a pool of %lu messages", (unsigned long)capacity);
+    }
+    else
+    {
+        size_t index;
+        result->messages = (IOTHUB_MESSAGE_HANDLE_DATA*)(result + 1);
+        result->capacity = capacity;
+        result->freeMessages = NULL;
+        result->heapAllocationCount = 0;
+        for (index = capacity; index > 0; index--)
         {
-            LogError("Unknown contentType in IoTHubMessage");
+            IOTHUB_MESSAGE_HANDLE_DATA* message = &result->messages[index - 1];
+            (void)memset(message, 0, sizeof(IOTHUB_MESSAGE_HANDLE_DATA));
+            message->pool = result;
+            message->nextFree = result->freeMessages;
+            result->freeMessages = message;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CloneFromPool(IOTHUB_MESSAGE_POOL_HANDLE pool, IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    IOTHUB_MESSAGE_HANDLE_DATA* result;
+    if ((pool == NULL) || (iotHubMessageHandle == NULL))
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_047: [ If pool or iotHubMessageHandle is NULL, or the clone fails for any reason, IoTHubMessage_CloneFromPool shall return NULL. ]*/
+        LogError("invalid arg (NULL) passed to IoTHubMessage_CloneFromPool");
+        result = NULL;
+    }
+    else if (pool->freeMessages == NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_049: [ When all the messages of the pool are in use, IoTHubMessage_CloneFromPool shall return IoTHubMessage_Clone(iotHubMessageHandle) and count the allocation. ]*/
+        pool->heapAllocationCount++;
+        result = IoTHubMessage_Clone(iotHubMessageHandle);
+    }
+    /*the deferred properties of the source are moved into its map first, like IoTHubMessage_Clone does*/
+    else if (materialize_deferred_properties(iotHubMessageHandle) != 0)
+    {
+        LogError("unable to apply the deferred properties of the source message");
+        result = NULL;
+    }
+    else
+    {
+        result = pool->freeMessages;
+        pool->freeMessages = result->nextFree;
+        if (clone_into_pooled_message(pool, result, iotHubMessageHandle) != 0)
+        {
+            result->nextFree = pool->freeMessages;
+            pool->freeMessages = result;
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+size_t IoTHubMessage_GetPoolHeapAllocationCount(IOTHUB_MESSAGE_POOL_HANDLE pool)
+{
+    size_t result;
+    if (pool == NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_050: [ If pool is NULL, IoTHubMessage_GetPoolHeapAllocationCount shall return 0. ]*/
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_051: [ IoTHubMessage_GetPoolHeapAllocationCount shall return the number of times IoTHubMessage_CloneFromPool had to allocate memory, or to update or remove a value of a properties map, since the pool was created. ]*/
+        result = pool->heapAllocationCount;
+    }
+    return result;
+}
+
+void IoTHubMessage_DestroyPool(IOTHUB_MESSAGE_POOL_HANDLE pool)
+{
+    /*Codes_SRS_IOTHUBMESSAGE_01_052: [ If pool is NULL, IoTHubMessage_DestroyPool shall do nothing. ]*/
+    if (pool != NULL)
+    {
+        /*Codes_SRS_IOTHUBMESSAGE_01_053: [ IoTHubMessage_DestroyPool shall free the pool, and the content storage, properties map and id strings of its messages. ]*/
+        size_t index;
+        for (index = 0; index < pool->capacity; index++)
+        {
+            IOTHUB_MESSAGE_HANDLE_DATA* message = &pool->messages[index];
+            if (message->properties != NULL)
+            {
+                Map_Destroy(message->properties);
+            }
+            if (message->pooledContent != NULL)
+            {
+                free(message->pooledContent);
+            }
+            /*a message that was not given back still holds its id strings*/
+            keep_spare_string(&message->messageId, &message->spareMessageId, &message->spareMessageIdCapacity);
+            keep_spare_string(&message->correlationId, &message->spareCorrelationId, &message->spareCorrelationIdCapacity);
+            if (message->spareMessageId != NULL)
+            {
+                free(message->spareMessageId);
+            }
+            if (message->spareCorrelationId != NULL)
+            {
+                free(message->spareCorrelationId);
+            }
         }
-        Map_Destroy(handleData->properties);
-        free(handleData->messageId);
-        handleData->messageId = NULL;
-        free(handleData->correlationId);
-        handleData->correlationId = NULL;
-        free(handleData);
+        free(pool);
     }
 }
@@ -5,27 +5,61 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include <signal.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "iothubtransport.h"
 #include "iothub_client.h"
 #include "iothub_client_private.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/vector.h"
 
+/*the lower layer only makes progress in DoWork (sending, receiving from the socket, keep alives), so the idle wait stays short*/
+#define TRANSPORT_WORKER_BUSY_WAIT_MS 1
+#define TRANSPORT_WORKER_IDLE_WAIT_MS 10
+
 typedef struct TRANSPORT_HANDLE_DATA_TAG
 {
 	TRANSPORT_LL_HANDLE transportLLHandle;
     THREAD_HANDLE workerThreadHandle;
     LOCK_HANDLE lockHandle;
     sig_atomic_t stopThread;
+	COND_HANDLE workCondition; /*created with the worker thread, pooled connections wake their pool worker instead*/
+	int workSignaled;
 	TRANSPORT_PROVIDER_FIELDS;
 	VECTOR_HANDLE clients;
+	struct TRANSPORT_POOL_HANDLE_DATA_TAG* pool; /*NULL unless this transport is one of the connections of a transport pool*/
+	size_t poolIndex;
+	size_t pooledDevices;
 } TRANSPORT_HANDLE_DATA;
 
+typedef struct TRANSPORT_POOL_WORKER_TAG
+{
+	struct TRANSPORT_POOL_HANDLE_DATA_TAG* pool;
+	size_t index;
+	THREAD_HANDLE threadHandle;
+	sig_atomic_t stopThread;
+	COND_HANDLE workCondition;
+	int workSignaled;
+} TRANSPORT_POOL_WORKER;
+
+typedef struct TRANSPORT_POOL_HANDLE_DATA_TAG
+{
+	IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol;
+	const char* iotHubName;
+	const char* iotHubSuffix;
+	size_t devicesPerConnection;
+	size_t workerThreadCount;
+	TRANSPORT_POOL_WORKER* workers;
+	LOCK_HANDLE lockHandle;
+	VECTOR_HANDLE transports;
+} TRANSPORT_POOL_HANDLE_DATA;
+
 /* Used for Unit test */
 const size_t IoTHubTransport_ThreadTerminationOffset = offsetof(TRANSPORT_HANDLE_DATA, stopThread);
+const size_t IoTHubTransport_PoolWorkerTerminationOffset = offsetof(TRANSPORT_POOL_WORKER, stopThread);
 
 TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix)
 {
@@ -103,6 +137,11 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 						/*Codes_SRS_IOTHUBTRANSPORT_17_001: [ IoTHubTransport_Create shall return a non-NULL handle on success.]*/
 						result->stopThread = 1;
 						result->workerThreadHandle = NULL; /* create thread when work needs to be done */
+						result->workCondition = NULL;
+						result->workSignaled = 0;
+						result->pool = NULL;
+						result->poolIndex = 0;
+						result->pooledDevices = 0;
                         result->IoTHubTransport_GetHostname = transportProtocol->IoTHubTransport_GetHostname;
 						result->IoTHubTransport_SetOption = transportProtocol->IoTHubTransport_SetOption;
 						result->IoTHubTransport_Create = transportProtocol->IoTHubTransport_Create;
@@ -123,16 +162,30 @@ TRANSPORT_HANDLE  IoTHubTransport_Create(IOTHUB_CLIENT_TRANSPORT_PROVIDER protoc
 	return result;
 }
 
+/*this function shall be called with lock held, it returns the wait period to use after the next pass*/
+static int wait_for_work(COND_HANDLE workCondition, LOCK_HANDLE lock, int* workSignaled, int waitTime)
+{
+	if (!*workSignaled)
+	{
+		(void)Condition_Wait(workCondition, lock, waitTime);
+	}
+
+	/*a signaled pass usually leaves the lower layer with more to do (acks, the rest of a batch), so it is followed by a short wait*/
+	waitTime = (*workSignaled) ? TRANSPORT_WORKER_BUSY_WAIT_MS : TRANSPORT_WORKER_IDLE_WAIT_MS;
+	*workSignaled = 0;
+	return waitTime;
+}
+
 static int transport_worker_thread(void* threadArgument)
 {
 	TRANSPORT_HANDLE_DATA* transportData = (TRANSPORT_HANDLE_DATA*)threadArgument;
+	int waitTime = TRANSPORT_WORKER_IDLE_WAIT_MS;
 
 	while (1)
 	{
 		/*Codes_SRS_IOTHUBTRANSPORT_17_030: [ All calls to lower layer transport DoWork shall be protected by the lock created in IoTHubTransport_Create. ]*/
 		if (Lock(transportData->lockHandle) == LOCK_OK)
 		{
-			/*Codes_SRS_IOTHUBTRANSPORT_17_031: [ If acquiring the lock fails, lower layer transport DoWork shall not be called. ]*/
 			if (transportData->stopThread)
 			{
 				/*Codes_SRS_IOTHUBTRANSPORT_17_028: [ The thread shall exit when IoTHubTransport_EndWorkerThread has been called for each clientHandle which invoked IoTHubTransport_StartWorkerThread. ]*/
@@ -142,11 +195,17 @@ static int transport_worker_thread(void* threadArgument)
 			else
 			{
 				(transportData->IoTHubTransport_DoWork)(transportData->transportLLHandle, NULL);
+
+				/*Codes_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork again when IoTHubTransport_SignalWorkerThread is called or when the wait period expires. ]*/
+				waitTime = wait_for_work(transportData->workCondition, transportData->lockHandle, &transportData->workSignaled, waitTime);
 				(void)Unlock(transportData->lockHandle);
 			}
 		}
-		/*Codes_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork every 1 ms. ]*/
-		ThreadAPI_Sleep(1);
+		else
+		{
+			/*Codes_SRS_IOTHUBTRANSPORT_17_031: [ If acquiring the lock fails, lower layer transport DoWork shall not be called. ]*/
+			ThreadAPI_Sleep(1);
+		}
 	}
 
 	return 0;
@@ -160,19 +219,98 @@ static bool find_by_handle(const void* element, const void* value)
 	return (*guess == match);
 }
 
+static int transport_pool_worker_thread(void* threadArgument)
+{
+	TRANSPORT_POOL_WORKER* worker = (TRANSPORT_POOL_WORKER*)threadArgument;
+	TRANSPORT_POOL_HANDLE_DATA* poolData = worker->pool;
+	int waitTime = TRANSPORT_WORKER_IDLE_WAIT_MS;
+
+	/*Codes_SRS_IOTHUBTRANSPORT_01_020: [ A pool worker thread shall exit when IoTHubTransport_DestroyPool is called. ]*/
+	while (!worker->stopThread)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_01_021: [ Pool worker thread number i shall service the connections i, i + workerThreadCount, i + 2 * workerThreadCount and so on. ]*/
+		size_t index = worker->index;
+		TRANSPORT_HANDLE_DATA* transportData;
+		do
+		{
+			transportData = NULL;
+			/*the pool lock is only held to look the connection up, so handing out a connection never waits for a DoWork*/
+			if (Lock(poolData->lockHandle) == LOCK_OK)
+			{
+				if (index < VECTOR_size(poolData->transports))
+				{
+					transportData = *(TRANSPORT_HANDLE_DATA**)VECTOR_element(poolData->transports, index);
+				}
+				(void)Unlock(poolData->lockHandle);
+			}
+
+			if (transportData != NULL)
+			{
+				/*Codes_SRS_IOTHUBTRANSPORT_01_022: [ Every call to a connection's lower layer transport DoWork shall be protected by that connection's lock. ]*/
+				if (Lock(transportData->lockHandle) == LOCK_OK)
+				{
+					/*Codes_SRS_IOTHUBTRANSPORT_01_023: [ A pool worker thread shall only call DoWork for connections which have at least one client that invoked IoTHubTransport_StartWorkerThread. ]*/
+					if (!transportData->stopThread)
+					{
+						(transportData->IoTHubTransport_DoWork)(transportData->transportLLHandle, NULL);
+					}
+					(void)Unlock(transportData->lockHandle);
+				}
+				index += poolData->workerThreadCount;
+			}
+		} while (transportData != NULL);
+
+		/*Codes_SRS_IOTHUBTRANSPORT_01_024: [ A pool worker thread shall service its connections again when IoTHubTransport_SignalWorkerThread is called for one of them or when the wait period expires. ]*/
+		if (Lock(poolData->lockHandle) == LOCK_OK)
+		{
+			if (!worker->stopThread)
+			{
+				waitTime = wait_for_work(worker->workCondition, poolData->lockHandle, &worker->workSignaled, waitTime);
+			}
+			(void)Unlock(poolData->lockHandle);
+		}
+		else
+		{
+			ThreadAPI_Sleep(1);
+		}
+	}
+
+	return 0;
+}
+
 static IOTHUB_CLIENT_RESULT start_worker_if_needed(TRANSPORT_HANDLE_DATA * transportData, IOTHUB_CLIENT_HANDLE clientHandle)
 {
 	IOTHUB_CLIENT_RESULT result;
-	if (transportData->workerThreadHandle == NULL)
+	bool hasWorker;
+	if (transportData->pool != NULL)
 	{
-		/*Codes_SRS_IOTHUBTRANSPORT_17_018: [ If the worker thread does not exist, IoTHubTransport_StartWorkerThread shall start the thread using ThreadAPI_Create. ]*/
+		/*Codes_SRS_IOTHUBTRANSPORT_01_013: [ If the transport is a pooled connection, IoTHubTransport_StartWorkerThread shall not create a thread and shall have the pool's worker threads call its DoWork instead. ]*/
 		transportData->stopThread = 0;
-		if (ThreadAPI_Create(&transportData->workerThreadHandle, transport_worker_thread, transportData) != THREADAPI_OK)
+		hasWorker = true;
+	}
+	else
+	{
+		if (transportData->workerThreadHandle == NULL)
 		{
-			transportData->workerThreadHandle = NULL;
+			/*Codes_SRS_IOTHUBTRANSPORT_01_025: [ Before starting the worker thread a condition shall be created by calling Condition_Init. The worker thread waits on it between calls to lower layer transport DoWork. ]*/
+			if ((transportData->workCondition == NULL) &&
+				((transportData->workCondition = Condition_Init()) == NULL))
+			{
+				LogError("Condition_Init failed");
+			}
+			else
+			{
+				/*Codes_SRS_IOTHUBTRANSPORT_17_018: [ If the worker thread does not exist, IoTHubTransport_StartWorkerThread shall start the thread using ThreadAPI_Create. ]*/
+				transportData->stopThread = 0;
+				if (ThreadAPI_Create(&transportData->workerThreadHandle, transport_worker_thread, transportData) != THREADAPI_OK)
+				{
+					transportData->workerThreadHandle = NULL;
+				}
+			}
 		}
+		hasWorker = (transportData->workerThreadHandle != NULL);
 	}
-	if (transportData->workerThreadHandle != NULL)
+	if (hasWorker)
 	{
 		/*Codes_SRS_IOTHUBTRANSPORT_17_020: [ IoTHubTransport_StartWorkerThread shall search for IoTHubClient clientHandle in the list of IoTHubClient handles. ]*/
 		bool addToList = ((VECTOR_size(transportData->clients) == 0) || (VECTOR_find_if(transportData->clients, find_by_handle, clientHandle) == NULL));
@@ -201,10 +339,23 @@ static IOTHUB_CLIENT_RESULT start_worker_if_needed(TRANSPORT_HANDLE_DATA * trans
 	return result;
 }
 
+static void post_work_condition(COND_HANDLE workCondition, int* workSignaled)
+{
+	*workSignaled = 1;
+	if (workCondition != NULL)
+	{
+		if (Condition_Post(workCondition) != COND_OK)
+		{
+			LogError("Condition_Post failed");
+		}
+	}
+}
+
 static void stop_worker_thread(TRANSPORT_HANDLE_DATA * transportData)
 {
 	/*Codes_SRS_IOTHUBTRANSPORT_17_043: [** IoTHubTransport_SignalEndWorkerThread shall signal the worker thread to end.*/
 	transportData->stopThread = 1;
+	post_work_condition(transportData->workCondition, &transportData->workSignaled);
 }
 
 static void wait_worker_thread(TRANSPORT_HANDLE_DATA * transportData)
@@ -233,8 +384,20 @@ static bool signal_end_worker_thread(TRANSPORT_HANDLE_DATA * transportData, IOTH
 		/*Codes_SRS_IOTHUBTRANSPORT_17_026: [ IoTHubTransport_EndWorkerThread shall remove clientHandlehandle from handle list. ]*/
 		VECTOR_erase(transportData->clients, element, 1);
 	}
+	if (transportData->pool != NULL)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_01_014: [ If the transport is a pooled connection, IoTHubTransport_SignalEndWorkerThread shall stop the pool's worker threads from calling its DoWork once the client list is empty. ]*/
+		if (VECTOR_size(transportData->clients) == 0)
+		{
+			transportData->stopThread = 1;
+		}
+
+		/*Codes_SRS_IOTHUBTRANSPORT_01_015: [ If the transport is a pooled connection, IoTHubTransport_SignalEndWorkerThread shall keep the device slot taken by IoTHubTransport_GetPooledTransport, it is released by IoTHubTransport_Destroy. ]*/
+		/*Codes_SRS_IOTHUBTRANSPORT_01_016: [ If the transport is a pooled connection, IoTHubTransport_SignalEndWorkerThread shall return false. ]*/
+		okToJoin = false;
+	}
 	/*Codes_SRS_IOTHUBTRANSPORT_17_025: [ If the worker thread does not exist, then IoTHubTransport_EndWorkerThread shall return. ]*/
-	if (transportData->workerThreadHandle != NULL)
+	else if (transportData->workerThreadHandle != NULL)
 	{
 		if (VECTOR_size(transportData->clients) == 0)
 		{
@@ -253,29 +416,61 @@ static bool signal_end_worker_thread(TRANSPORT_HANDLE_DATA * transportData, IOTH
 	return okToJoin;
 }
 
+static void destroy_transport(TRANSPORT_HANDLE_DATA * transportData)
+{
+	/*Codes_SRS_IOTHUBTRANSPORT_17_033: [ IoTHubTransport_Destroy shall lock the transport lock. ]*/
+	if (Lock(transportData->lockHandle) != LOCK_OK)
+	{
+		LogError("Unable to lock - will still attempt to end thread without thread safety");
+		stop_worker_thread(transportData);
+	}
+	else
+	{
+		stop_worker_thread(transportData);
+		(void)Unlock(transportData->lockHandle);
+	}
+	wait_worker_thread(transportData);
+	/*Codes_SRS_IOTHUBTRANSPORT_17_010: [ IoTHubTransport_Destroy shall free all resources. ]*/
+	if (transportData->workCondition != NULL)
+	{
+		Condition_Deinit(transportData->workCondition);
+	}
+	Lock_Deinit(transportData->lockHandle);
+	(transportData->IoTHubTransport_Destroy)(transportData->transportLLHandle);
+	VECTOR_destroy(transportData->clients);
+	free(transportData);
+}
+
 void IoTHubTransport_Destroy(TRANSPORT_HANDLE transportHandle)
 {
 	/*Codes_SRS_IOTHUBTRANSPORT_17_011: [ IoTHubTransport_Destroy shall do nothing if transportHandle is NULL. ]*/
 	if (transportHandle != NULL)
 	{
 		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
-		/*Codes_SRS_IOTHUBTRANSPORT_17_033: [ IoTHubTransport_Destroy shall lock the transport lock. ]*/
-		if (Lock(transportData->lockHandle) != LOCK_OK)
+		if (transportData->pool != NULL)
 		{
-			LogError("Unable to lock - will still attempt to end thread without thread safety");
-			stop_worker_thread(transportData);
+			/*Codes_SRS_IOTHUBTRANSPORT_01_017: [ If transportHandle is a pooled connection, IoTHubTransport_Destroy shall release the device slot taken by IoTHubTransport_GetPooledTransport and leave the connection in the pool until IoTHubTransport_DestroyPool. ]*/
+			if (Lock(transportData->pool->lockHandle) != LOCK_OK)
+			{
+				LogError("Unable to lock the transport pool, the device slot is not released");
+			}
+			else
+			{
+				if (transportData->pooledDevices == 0)
+				{
+					LogError("the pooled transport has no device slot to release");
+				}
+				else
+				{
+					transportData->pooledDevices--;
+				}
+				(void)Unlock(transportData->pool->lockHandle);
+			}
 		}
 		else
 		{
-			stop_worker_thread(transportData);
-			(void)Unlock(transportData->lockHandle);
+			destroy_transport(transportData);
 		}
-		wait_worker_thread(transportData);
-		/*Codes_SRS_IOTHUBTRANSPORT_17_010: [ IoTHubTransport_Destroy shall free all resources. ]*/
-		Lock_Deinit(transportData->lockHandle);
-		(transportData->IoTHubTransport_Destroy)(transportData->transportLLHandle);
-		VECTOR_destroy(transportData->clients);
-		free(transportHandle);
 	}
 }
 
@@ -368,3 +563,248 @@ void IoTHubTransport_JoinWorkerThread(TRANSPORT_HANDLE transportHandle, IOTHUB_C
 		wait_worker_thread(transportData);
 	}
 }
+
+void IoTHubTransport_SignalWorkerThread(TRANSPORT_HANDLE transportHandle)
+{
+	/*Codes_SRS_IOTHUBTRANSPORT_01_026: [ If transportHandle is NULL, IoTHubTransport_SignalWorkerThread shall do nothing. ]*/
+	if (transportHandle != NULL)
+	{
+		TRANSPORT_HANDLE_DATA * transportData = (TRANSPORT_HANDLE_DATA*)transportHandle;
+		if (transportData->pool == NULL)
+		{
+			/*Codes_SRS_IOTHUBTRANSPORT_01_027: [ IoTHubTransport_SignalWorkerThread shall wake up the worker thread by calling Condition_Post. ]*/
+			post_work_condition(transportData->workCondition, &transportData->workSignaled);
+		}
+		/*Codes_SRS_IOTHUBTRANSPORT_01_028: [ If the transport is a pooled connection, IoTHubTransport_SignalWorkerThread shall wake up the pool worker thread which services the connection. ]*/
+		else if (Lock(transportData->pool->lockHandle) != LOCK_OK)
+		{
+			LogError("Unable to lock the transport pool, the pool worker is not signaled");
+		}
+		else
+		{
+			TRANSPORT_POOL_WORKER* worker = &transportData->pool->workers[transportData->poolIndex % transportData->pool->workerThreadCount];
+			post_work_condition(worker->workCondition, &worker->workSignaled);
+			(void)Unlock(transportData->pool->lockHandle);
+		}
+	}
+}
+
+static void stop_pool_workers(TRANSPORT_POOL_HANDLE_DATA* poolData, size_t workerCount)
+{
+	size_t index;
+	if (Lock(poolData->lockHandle) != LOCK_OK)
+	{
+		LogError("Unable to lock - will still attempt to end the pool workers without thread safety");
+		for (index = 0; index < workerCount; index++)
+		{
+			poolData->workers[index].stopThread = 1;
+			post_work_condition(poolData->workers[index].workCondition, &poolData->workers[index].workSignaled);
+		}
+	}
+	else
+	{
+		for (index = 0; index < workerCount; index++)
+		{
+			poolData->workers[index].stopThread = 1;
+			post_work_condition(poolData->workers[index].workCondition, &poolData->workers[index].workSignaled);
+		}
+		(void)Unlock(poolData->lockHandle);
+	}
+
+	for (index = 0; index < workerCount; index++)
+	{
+		int res;
+		if (ThreadAPI_Join(poolData->workers[index].threadHandle, &res) != THREADAPI_OK)
+		{
+			LogError("ThreadAPI_Join failed");
+		}
+		Condition_Deinit(poolData->workers[index].workCondition);
+	}
+}
+
+TRANSPORT_POOL_HANDLE IoTHubTransport_CreatePool(IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol, const char* iotHubName, const char* iotHubSuffix, size_t devicesPerConnection, size_t workerThreadCount)
+{
+	TRANSPORT_POOL_HANDLE_DATA* result;
+
+	if (protocol == NULL || iotHubName == NULL || iotHubSuffix == NULL || devicesPerConnection == 0 || workerThreadCount == 0)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_01_001: [ If protocol, iotHubName or iotHubSuffix is NULL, IoTHubTransport_CreatePool shall return NULL. ]*/
+		/*Codes_SRS_IOTHUBTRANSPORT_01_002: [ If devicesPerConnection or workerThreadCount is 0, IoTHubTransport_CreatePool shall return NULL. ]*/
+		LogError("Invalid argument, protocol [%p], name [%p], suffix [%p], devicesPerConnection [%lu], workerThreadCount [%lu].", protocol, iotHubName, iotHubSuffix, (unsigned long)devicesPerConnection, (unsigned long)workerThreadCount);
+		result = NULL;
+	}
+	else
+	{
+		size_t iotHubNameLength = strlen(iotHubName) + 1;
+		size_t iotHubSuffixLength = strlen(iotHubSuffix) + 1;
+
+		/*Codes_SRS_IOTHUBTRANSPORT_01_003: [ IoTHubTransport_CreatePool shall allocate memory for the pool data, including copies of iotHubName and iotHubSuffix. ]*/
+		result = (TRANSPORT_POOL_HANDLE_DATA*)malloc(sizeof(TRANSPORT_POOL_HANDLE_DATA) + iotHubNameLength + iotHubSuffixLength);
+		if (result == NULL)
+		{
+			/*Codes_SRS_IOTHUBTRANSPORT_01_004: [ If any resource cannot be created, IoTHubTransport_CreatePool shall free everything it created and return NULL. ]*/
+			LogError("Transport pool was not allocated.");
+		}
+		else
+		{
+			char* names = (char*)(result + 1);
+			(void)memcpy(names, iotHubName, iotHubNameLength);
+			(void)memcpy(names + iotHubNameLength, iotHubSuffix, iotHubSuffixLength);
+			result->protocol = protocol;
+			result->iotHubName = names;
+			result->iotHubSuffix = names + iotHubNameLength;
+			result->devicesPerConnection = devicesPerConnection;
+			result->workerThreadCount = workerThreadCount;
+
+			/*Codes_SRS_IOTHUBTRANSPORT_01_005: [ IoTHubTransport_CreatePool shall create the pool lock by calling Lock_Init and the list of connections by calling VECTOR_create. ]*/
+			if ((result->lockHandle = Lock_Init()) == NULL)
+			{
+				LogError("transport pool Lock not created.");
+				free(result);
+				result = NULL;
+			}
+			else if ((result->transports = VECTOR_create(sizeof(TRANSPORT_HANDLE))) == NULL)
+			{
+				LogError("transport pool connection list not created.");
+				Lock_Deinit(result->lockHandle);
+				free(result);
+				result = NULL;
+			}
+			else if ((result->workers = (TRANSPORT_POOL_WORKER*)malloc(workerThreadCount * sizeof(TRANSPORT_POOL_WORKER))) == NULL)
+			{
+				LogError("transport pool workers not allocated.");
+				VECTOR_destroy(result->transports);
+				Lock_Deinit(result->lockHandle);
+				free(result);
+				result = NULL;
+			}
+			else
+			{
+				size_t index;
+				for (index = 0; index < workerThreadCount; index++)
+				{
+					result->workers[index].pool = result;
+					result->workers[index].index = index;
+					result->workers[index].stopThread = 0;
+					result->workers[index].workSignaled = 0;
+
+					/*Codes_SRS_IOTHUBTRANSPORT_01_029: [ IoTHubTransport_CreatePool shall create a condition for every worker thread by calling Condition_Init. ]*/
+					if ((result->workers[index].workCondition = Condition_Init()) == NULL)
+					{
+						LogError("unable to create the condition of transport pool worker thread %lu", (unsigned long)index);
+						break;
+					}
+					/*Codes_SRS_IOTHUBTRANSPORT_01_006: [ IoTHubTransport_CreatePool shall start workerThreadCount worker threads by calling ThreadAPI_Create. ]*/
+					else if (ThreadAPI_Create(&result->workers[index].threadHandle, transport_pool_worker_thread, &result->workers[index]) != THREADAPI_OK)
+					{
+						LogError("unable to create transport pool worker thread %lu", (unsigned long)index);
+						Condition_Deinit(result->workers[index].workCondition);
+						break;
+					}
+				}
+
+				if (index < workerThreadCount)
+				{
+					stop_pool_workers(result, index);
+					free(result->workers);
+					VECTOR_destroy(result->transports);
+					Lock_Deinit(result->lockHandle);
+					free(result);
+					result = NULL;
+				}
+			}
+		}
+	}
+
+	/*Codes_SRS_IOTHUBTRANSPORT_01_007: [ IoTHubTransport_CreatePool shall return a non-NULL handle on success. ]*/
+	return result;
+}
+
+TRANSPORT_HANDLE IoTHubTransport_GetPooledTransport(TRANSPORT_POOL_HANDLE transportPoolHandle)
+{
+	TRANSPORT_HANDLE_DATA* result;
+
+	if (transportPoolHandle == NULL)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_01_008: [ If transportPoolHandle is NULL, IoTHubTransport_GetPooledTransport shall return NULL. ]*/
+		LogError("Invalid NULL transportPoolHandle");
+		result = NULL;
+	}
+	else if (Lock(transportPoolHandle->lockHandle) != LOCK_OK)
+	{
+		/*Codes_SRS_IOTHUBTRANSPORT_01_012: [ If any step fails, IoTHubTransport_GetPooledTransport shall return NULL. ]*/
+		LogError("Unable to lock the transport pool");
+		result = NULL;
+	}
+	else
+	{
+		size_t count = VECTOR_size(transportPoolHandle->transports);
+		size_t index;
+		result = NULL;
+
+		/*Codes_SRS_IOTHUBTRANSPORT_01_009: [ IoTHubTransport_GetPooledTransport shall return the first connection of the pool which holds fewer than devicesPerConnection devices. ]*/
+		for (index = 0; index < count; index++)
+		{
+			TRANSPORT_HANDLE_DATA* transportData = *(TRANSPORT_HANDLE_DATA**)VECTOR_element(transportPoolHandle->transports, index);
+			if (transportData->pooledDevices < transportPoolHandle->devicesPerConnection)
+			{
+				result = transportData;
+				break;
+			}
+		}
+
+		if (result == NULL)
+		{
+			/*Codes_SRS_IOTHUBTRANSPORT_01_010: [ If every connection is full, IoTHubTransport_GetPooledTransport shall create a new connection by calling IoTHubTransport_Create and add it to the pool. ]*/
+			result = IoTHubTransport_Create(transportPoolHandle->protocol, transportPoolHandle->iotHubName, transportPoolHandle->iotHubSuffix);
+			if (result == NULL)
+			{
+				LogError("unable to create a pooled connection");
+			}
+			else if (VECTOR_push_back(transportPoolHandle->transports, &result, 1) != 0)
+			{
+				LogError("unable to add the connection to the pool");
+				IoTHubTransport_Destroy(result);
+				result = NULL;
+			}
+			else
+			{
+				result->pool = transportPoolHandle;
+				result->poolIndex = count;
+			}
+		}
+
+		if (result != NULL)
+		{
+			/*Codes_SRS_IOTHUBTRANSPORT_01_011: [ IoTHubTransport_GetPooledTransport shall reserve one device slot on the returned connection. ]*/
+			result->pooledDevices++;
+		}
+		(void)Unlock(transportPoolHandle->lockHandle);
+	}
+
+	return result;
+}
+
+void IoTHubTransport_DestroyPool(TRANSPORT_POOL_HANDLE transportPoolHandle)
+{
+	/*Codes_SRS_IOTHUBTRANSPORT_01_018: [ If transportPoolHandle is NULL, IoTHubTransport_DestroyPool shall do nothing. ]*/
+	if (transportPoolHandle != NULL)
+	{
+		size_t count;
+		size_t index;
+
+		/*Codes_SRS_IOTHUBTRANSPORT_01_019: [ IoTHubTransport_DestroyPool shall stop and join every worker thread, then destroy every connection of the pool and free all resources. ]*/
+		stop_pool_workers(transportPoolHandle, transportPoolHandle->workerThreadCount);
+
+		count = VECTOR_size(transportPoolHandle->transports);
+		for (index = 0; index < count; index++)
+		{
+			destroy_transport(*(TRANSPORT_HANDLE_DATA**)VECTOR_element(transportPoolHandle->transports, index));
+		}
+
+		VECTOR_destroy(transportPoolHandle->transports);
+		Lock_Deinit(transportPoolHandle->lockHandle);
+		free(transportPoolHandle->workers);
+		free(transportPoolHandle);
+	}
+}
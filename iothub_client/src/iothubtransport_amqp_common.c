@@ -70,6 +70,7 @@ typedef struct AMQP_TRANSPORT_INSTANCE_TAG
 	size_t option_sas_token_refresh_time_secs;                          // Device-specific option.
 	size_t option_cbs_request_timeout_secs;                             // Device-specific option.
 	size_t option_send_event_timeout_secs;                              // Device-specific option.
+	bool option_batching;                                               // Device-specific option.
 } AMQP_TRANSPORT_INSTANCE;
 
 typedef struct AMQP_TRANSPORT_DEVICE_INSTANCE_TAG
@@ -978,6 +979,16 @@ static int replicate_device_options_to(AMQP_TRANSPORT_DEVICE_INSTANCE* dev_insta
 		LogError("Failed to apply option DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS to device '%s' (device_set_option failed)", STRING_c_str(dev_instance->device_id));
 		result = __FAILURE__;
 	}
+	// Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_033: [If `batching` was enabled on the transport, it shall be applied to each new registered device using device_set_option()]
+	else if (dev_instance->transport_instance->option_batching &&
+		device_set_option(
+			dev_instance->device_handle,
+			DEVICE_OPTION_BATCHING,
+			&dev_instance->transport_instance->option_batching) != RESULT_OK)
+	{
+		LogError("Failed to apply option DEVICE_OPTION_BATCHING to device '%s' (device_set_option failed)", STRING_c_str(dev_instance->device_id));
+		result = __FAILURE__;
+	}
 	else if (auth_mode == DEVICE_AUTH_MODE_CBS)
 	{
 		if (device_set_option(
@@ -1039,6 +1050,10 @@ static const char* get_device_option_name_from(const char* iothubclient_option_n
 	{
 		device_option_name = DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS;
 	}
+	else if (strcmp(OPTION_BATCHING, iothubclient_option_name) == 0)
+	{
+		device_option_name = DEVICE_OPTION_BATCHING;
+	}
 	else
 	{
 		device_option_name = NULL;
@@ -1529,6 +1544,11 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_AMQP_Common_SetOption(TRANSPORT_LL_HANDLE h
 			is_device_specific_option = true;
 			transport_instance->option_send_event_timeout_secs = *(size_t*)value;
 		}
+		else if (strcmp(OPTION_BATCHING, option) == 0)
+		{
+			is_device_specific_option = true;
+			transport_instance->option_batching = *(bool*)value;
+		}
 		else
 		{
 			is_device_specific_option = false;
@@ -1563,6 +1583,11 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_AMQP_Common_SetOption(TRANSPORT_LL_HANDLE h
 				result = IOTHUB_CLIENT_OK;
 			}
 		}
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_032: [If `option` is `message_pool_size`, IoTHubTransport_AMQP_Common_SetOption shall return IOTHUB_CLIENT_OK without doing anything else, the messenger already recycles the records of the events it sends]
+		else if (strcmp(OPTION_MESSAGE_POOL_SIZE, option) == 0)
+		{
+			result = IOTHUB_CLIENT_OK;
+		}
 		else
 		{
 			result = IOTHUB_CLIENT_OK;
@@ -1204,7 +1204,8 @@ int device_set_option(DEVICE_HANDLE handle, const char* name, void* value)
 				result = RESULT_OK;
 			}
 		}
-		else if (strcmp(DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS, name) == 0)
+		else if (strcmp(DEVICE_OPTION_EVENT_SEND_TIMEOUT_SECS, name) == 0 ||
+			strcmp(DEVICE_OPTION_BATCHING, name) == 0)
 		{
 			// Codes_SRS_DEVICE_09_086: [If `name` refers to messenger module, it shall be passed along with `value` to messenger_set_option]
 			if (messenger_set_option(instance->messenger_handle, name, value) != RESULT_OK)
@@ -9,7 +9,7 @@
 #include "azure_c_shared_utility/agenttime.h" 
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/uniqueid.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_uamqp_c/link.h"
 #include "azure_uamqp_c/messaging.h"
 #include "azure_uamqp_c/message_sender.h"
@@ -34,14 +34,20 @@
 #define MAX_MESSAGE_SENDER_STATE_CHANGE_TIMEOUT_SECS    300
 #define MAX_MESSAGE_RECEIVER_STATE_CHANGE_TIMEOUT_SECS  300
 #define UNIQUE_ID_BUFFER_SIZE                           37
+#define MAX_POOLED_SEND_EVENT_TASKS                     64
+#define AMQP_BATCHING_FORMAT_CODE                       0x80013700
+#define DEFAULT_MAX_EVENTS_PER_BATCH                    100
+#define DEFAULT_MAX_BATCH_SIZE_IN_BYTES                 (255 * 1024)
 #define STRING_NULL_TERMINATOR                          '\0'
  
 typedef struct MESSENGER_INSTANCE_TAG
 {
 	STRING_HANDLE device_id;
 	STRING_HANDLE iothub_host_fqdn;
-	SINGLYLINKEDLIST_HANDLE waiting_to_send;
-	SINGLYLINKEDLIST_HANDLE in_progress_list;
+	DLIST_ENTRY waiting_to_send;
+	DLIST_ENTRY in_progress_list;
+	DLIST_ENTRY send_event_task_pool;
+	size_t send_event_task_pool_size;
 	MESSENGER_STATE state;
 	
 	ON_MESSENGER_STATE_CHANGED_CALLBACK on_state_changed_callback;
@@ -64,18 +70,28 @@ typedef struct MESSENGER_INSTANCE_TAG
 	size_t event_send_retry_limit;
 	size_t event_send_error_count;
 	size_t event_send_timeout_secs;
+	// False once event_send_timeout_secs is shortened while events are in progress, until those events no longer time out out of order.
+	bool in_progress_timeouts_ordered;
+	bool is_batching_enabled;
+	size_t max_events_per_batch;
+	size_t max_batch_size_in_bytes;
 	time_t last_message_sender_state_change_time;
 	time_t last_message_receiver_state_change_time;
 } MESSENGER_INSTANCE;
 
 typedef struct MESSENGER_SEND_EVENT_TASK_TAG
 {
+	DLIST_ENTRY entry;
 	IOTHUB_MESSAGE_LIST* message;
 	ON_MESSENGER_EVENT_SEND_COMPLETE on_event_send_complete_callback;
 	void* context;
 	time_t send_time;
+	// event_send_timeout_secs at the time the event was sent (0 means it never times out).
+	size_t send_timeout_secs;
 	MESSENGER_INSTANCE *messenger;
 	bool is_timed_out;
+	// Next event carried by the same batched AMQP message; the batch completion callback is registered on the first one only.
+	struct MESSENGER_SEND_EVENT_TASK_TAG* next_in_batch;
 } MESSENGER_SEND_EVENT_TASK;
 
 // @brief
@@ -773,147 +789,74 @@ static int create_message_receiver(MESSENGER_INSTANCE* instance)
 	return result;
 }
 
-static int move_event_to_in_progress_list(MESSENGER_SEND_EVENT_TASK* task)
+// @brief
+//     Gets a MESSENGER_SEND_EVENT_TASK from the instance pool, or allocates a new one if the pool is empty.
+static MESSENGER_SEND_EVENT_TASK* create_send_event_task(MESSENGER_INSTANCE* instance)
 {
-	int result; 
+	MESSENGER_SEND_EVENT_TASK* task;
 
-	if (singlylinkedlist_add(task->messenger->in_progress_list, (void*)task) == NULL)
+	if (instance->send_event_task_pool_size > 0)
 	{
-		result = __FAILURE__;
-		LogError("Failed moving event to in_progress list (singlylinkedlist_add failed)");
+		task = containingRecord(DList_RemoveHeadList(&instance->send_event_task_pool), MESSENGER_SEND_EVENT_TASK, entry);
+		instance->send_event_task_pool_size--;
 	}
 	else
 	{
-		result = RESULT_OK;
+		task = (MESSENGER_SEND_EVENT_TASK*)malloc(sizeof(MESSENGER_SEND_EVENT_TASK));
 	}
 
-	return result;
-}
-
-static bool find_MESSENGER_SEND_EVENT_TASK_on_list(LIST_ITEM_HANDLE list_item, const void* match_context)
-{
-	return (list_item != NULL && singlylinkedlist_item_get_value(list_item) == match_context);
+	return task;
 }
 
-static void remove_event_from_in_progress_list(MESSENGER_SEND_EVENT_TASK *task)
+// @brief
+//     Returns a MESSENGER_SEND_EVENT_TASK to the instance pool, or frees it if the pool is full.
+// @remarks
+//     The task must not be on any list.
+static void destroy_send_event_task(MESSENGER_INSTANCE* instance, MESSENGER_SEND_EVENT_TASK* task)
 {
-	LIST_ITEM_HANDLE list_item = singlylinkedlist_find(task->messenger->in_progress_list, find_MESSENGER_SEND_EVENT_TASK_on_list, (void*)task);
-
-	if (list_item != NULL)
+	if (instance->send_event_task_pool_size < MAX_POOLED_SEND_EVENT_TASKS)
 	{
-		if (singlylinkedlist_remove(task->messenger->in_progress_list, list_item) != RESULT_OK)
-		{
-			LogError("Failed removing event from in_progress list (singlylinkedlist_remove failed)");
-		}
+		DList_InsertHeadList(&instance->send_event_task_pool, &task->entry);
+		instance->send_event_task_pool_size++;
 	}
-}
-
-static int copy_events_to_list(SINGLYLINKEDLIST_HANDLE from_list, SINGLYLINKEDLIST_HANDLE to_list)
-{
-	int result;
-	LIST_ITEM_HANDLE list_item;
-
-	result = RESULT_OK;
-	list_item = singlylinkedlist_get_head_item(from_list);
-
-	while (list_item != NULL)
+	else
 	{
-		MESSENGER_SEND_EVENT_TASK *task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_item);
-
-		if (singlylinkedlist_add(to_list, task) == NULL)
-		{
-			LogError("Failed copying event to destination list (singlylinkedlist_add failed)");
-			result = __FAILURE__;
-			break;
-		}
-		else
-		{
-			list_item = singlylinkedlist_get_next_item(list_item);
-		}
+		free(task);
 	}
-
-	return result;
 }
 
-static int singlylinkedlist_clear(SINGLYLINKEDLIST_HANDLE list)
+static void move_event_to_in_progress_list(MESSENGER_SEND_EVENT_TASK* task)
 {
-	int result;
-	LIST_ITEM_HANDLE list_item;
-
-	result = RESULT_OK;
-
-	while ((list_item = singlylinkedlist_get_head_item(list)) != NULL)
-	{
-		if (singlylinkedlist_remove(list, list_item) != RESULT_OK)
-		{
-			LogError("Failed removing items from list (%d)", list);
-			result = __FAILURE__;
-			break;
-		}
-	}
-
-	return result;
+	DList_InsertTailList(&task->messenger->in_progress_list, &task->entry);
 }
 
-static int move_events_to_wait_to_send_list(MESSENGER_INSTANCE* instance)
+static void remove_event_from_in_progress_list(MESSENGER_SEND_EVENT_TASK *task)
 {
-	int result;
-	LIST_ITEM_HANDLE list_item;
+	(void)DList_RemoveEntryList(&task->entry);
+	// Points the entry to itself, so removing it again is harmless.
+	DList_InitializeListHead(&task->entry);
+}
 
-	if ((list_item = singlylinkedlist_get_head_item(instance->in_progress_list)) == NULL)
-	{
-		result = RESULT_OK;
-	}
-	else
+static void move_events_to_wait_to_send_list(MESSENGER_INSTANCE* instance)
+{
+	// Taking from the tail of in_progress_list and inserting at the head of waiting_to_send 
+	// keeps the original send order of the events.
+	while (!DList_IsListEmpty(&instance->in_progress_list))
 	{
-		SINGLYLINKEDLIST_HANDLE new_wait_to_send_list;
-
-		if ((new_wait_to_send_list = singlylinkedlist_create()) == NULL)
-		{
-			LogError("Failed moving events back to wait_to_send list (singlylinkedlist_create failed to create new wait_to_send_list)");
-			result = __FAILURE__;
-		}
-		else
-		{
-			SINGLYLINKEDLIST_HANDLE new_in_progress_list;
-		
-			if (copy_events_to_list(instance->in_progress_list, new_wait_to_send_list) != RESULT_OK)
-			{
-				LogError("Failed moving events back to wait_to_send list (failed adding in_progress_list items to new_wait_to_send_list)");
-				singlylinkedlist_destroy(new_wait_to_send_list);
-				result = __FAILURE__;
-			}
-			else if (copy_events_to_list(instance->waiting_to_send, new_wait_to_send_list) != RESULT_OK)
-			{
-				LogError("Failed moving events back to wait_to_send list (failed adding wait_to_send items to new_wait_to_send_list)");
-				singlylinkedlist_destroy(new_wait_to_send_list);
-				result = __FAILURE__;
-			}
-			else if ((new_in_progress_list = singlylinkedlist_create()) == NULL)
-			{
-				LogError("Failed moving events back to wait_to_send list (singlylinkedlist_create failed to create new in_progress_list)");
-				singlylinkedlist_destroy(new_wait_to_send_list);
-				result = __FAILURE__;
-			}
-			else 
-			{
-				singlylinkedlist_destroy(instance->waiting_to_send);
-				singlylinkedlist_destroy(instance->in_progress_list);
-				instance->waiting_to_send = new_wait_to_send_list;
-				instance->in_progress_list = new_in_progress_list;
-				result = RESULT_OK;
-			}
-		}
+		PDLIST_ENTRY entry = instance->in_progress_list.Blink;
+		(void)DList_RemoveEntryList(entry);
+		DList_InsertHeadList(&instance->waiting_to_send, entry);
 	}
-
-	return result;
 }
 
 static void internal_on_event_send_complete_callback(void* context, MESSAGE_SEND_RESULT send_result)
 { 
-	if (context != NULL)
+	MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)context;
+
+	// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_004: [If `task` leads a batch, the completion shall be applied to every event of the batch, in the order they were added to it]
+	while (task != NULL)
 	{
-		MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)context;
+		MESSENGER_SEND_EVENT_TASK* next_task = task->next_in_batch;
 
 		if (task->is_timed_out == false)
 		{
@@ -940,91 +883,214 @@ static void internal_on_event_send_complete_callback(void* context, MESSAGE_SEND
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_128: [`task` shall be removed from `instance->in_progress_list`]  
 		remove_event_from_in_progress_list(task);
 
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be destroyed using free()]  
-		free(task);
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be returned to the instance task pool, or destroyed using free() if the pool is full]  
+		destroy_send_event_task(task->messenger, task);
+
+		task = next_task;
 	}
 }
 
 static MESSENGER_SEND_EVENT_TASK* get_next_event_to_send(MESSENGER_INSTANCE* instance)
 {
 	MESSENGER_SEND_EVENT_TASK* task;
-	LIST_ITEM_HANDLE list_item;
 
-	if ((list_item = singlylinkedlist_get_head_item(instance->waiting_to_send)) == NULL)
+	if (DList_IsListEmpty(&instance->waiting_to_send))
 	{
 		task = NULL;
 	}
 	else
 	{
-		task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_item);
-
-		if (singlylinkedlist_remove(instance->waiting_to_send, list_item) != RESULT_OK)
-		{
-			LogError("Failed removing item from waiting_to_send list (singlylinkedlist_remove failed)");
-		}
+		task = containingRecord(DList_RemoveHeadList(&instance->waiting_to_send), MESSENGER_SEND_EVENT_TASK, entry);
 	}
 
 	return task;
 }
 
-static int send_pending_events(MESSENGER_INSTANCE* instance)
+// @brief
+//     Invokes the upper layer callback of every event in a batch with `send_result`, then removes and destroys them.
+static void fail_batched_events(MESSENGER_INSTANCE* instance, MESSENGER_SEND_EVENT_TASK* task, MESSENGER_EVENT_SEND_COMPLETE_RESULT send_result)
 {
-	int result = RESULT_OK;
+	while (task != NULL)
+	{
+		MESSENGER_SEND_EVENT_TASK* next_task = task->next_in_batch;
 
-	MESSENGER_SEND_EVENT_TASK* task;
+		task->on_event_send_complete_callback(task->message, send_result, (void*)task->context);
+		remove_event_from_in_progress_list(task);
+		destroy_send_event_task(instance, task);
 
-	while ((task = get_next_event_to_send(instance)) != NULL)
+		task = next_task;
+	}
+}
+
+// @brief
+//     Sends the events in `instance->waiting_to_send` packed into batched AMQP messages (format 0x80013700),
+//     each carrying up to `instance->max_events_per_batch` events or `instance->max_batch_size_in_bytes` of encoded events.
+static int send_pending_events_batched(MESSENGER_INSTANCE* instance)
+{
+	int result = RESULT_OK;
+
+	while (result == RESULT_OK && !DList_IsListEmpty(&instance->waiting_to_send))
 	{
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_153: [messenger_do_work() shall move each event to be sent from `instance->wait_to_send_list` to `instance->in_progress_list`] 
-		if (move_event_to_in_progress_list(task) != RESULT_OK)
+		MESSAGE_HANDLE batch;
+
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_001: [If batching is enabled, messenger_do_work() shall create a MESSAGE_HANDLE with message_create() and set its format to 0x80013700 with message_set_message_format()]
+		if ((batch = message_create()) == NULL)
 		{
+			LogError("Failed sending events (failed creating the batch message)");
+			result = __FAILURE__;
+		}
+		else if (message_set_message_format(batch, AMQP_BATCHING_FORMAT_CODE) != RESULT_OK)
+		{
+			LogError("Failed sending events (failed setting the batch message format)");
+			message_destroy(batch);
 			result = __FAILURE__;
-			task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, (void*)task->context);
-			break;
 		}
 		else
 		{
-			int uamqp_result;
-			MESSAGE_HANDLE amqp_message = NULL;
+			MESSENGER_SEND_EVENT_TASK* first_task = NULL;
+			MESSENGER_SEND_EVENT_TASK* last_task = NULL;
+			size_t batch_size = 0;
+			size_t event_count = 0;
+
+			MESSENGER_SEND_EVENT_TASK* task;
 
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message()]  
-			if ((uamqp_result = message_create_from_iothub_message(task->message->messageHandle, &amqp_message)) != RESULT_OK)
+			while (event_count < instance->max_events_per_batch && (task = get_next_event_to_send(instance)) != NULL)
 			{
-				LogError("Failed sending event message (failed creating AMQP message; error: %d).", uamqp_result);
+				BINARY_DATA encoded_event;
 
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_155: [If message_create_from_iothub_message() fails, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]  
-				task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, (void*)task->context);
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_002: [Each event shall be encoded with message_create_uamqp_encoding_from_iothub_message() and added to the batch with message_add_body_amqp_data(), until the batch holds `instance->max_events_per_batch` events or adding the next one would exceed `instance->max_batch_size_in_bytes`]
+				if (message_create_uamqp_encoding_from_iothub_message(task->message->messageHandle, &encoded_event) != RESULT_OK)
+				{
+					LogError("Failed sending event message (failed encoding it for the batch)");
 
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
-				remove_event_from_in_progress_list(task);
-				free(task);
-				
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_156: [If message_create_from_iothub_message() fails, messenger_do_work() shall skip to the next event to be sent]  
+					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_003: [If an event cannot be encoded or added to the batch, its `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, and it shall be destroyed]
+					task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, (void*)task->context);
+					destroy_send_event_task(instance, task);
+				}
+				else if (event_count > 0 && batch_size + encoded_event.length > instance->max_batch_size_in_bytes)
+				{
+					// Left for the next batch.
+					free((void*)encoded_event.bytes);
+					DList_InsertHeadList(&instance->waiting_to_send, &task->entry);
+					break;
+				}
+				else
+				{
+					int add_result = message_add_body_amqp_data(batch, encoded_event);
+					free((void*)encoded_event.bytes);
+
+					if (add_result != RESULT_OK)
+					{
+						LogError("Failed sending event message (failed adding it to the batch)");
+						task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, (void*)task->context);
+						destroy_send_event_task(instance, task);
+					}
+					else
+					{
+						move_event_to_in_progress_list(task);
+						task->next_in_batch = NULL;
+
+						if (last_task == NULL)
+						{
+							first_task = task;
+						}
+						else
+						{
+							last_task->next_in_batch = task;
+						}
+
+						last_task = task;
+						batch_size += encoded_event.length;
+						event_count++;
+					}
+				}
 			}
-			else
+
+			if (first_task != NULL)
 			{
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_157: [The MESSAGE_HANDLE shall be submitted for sending using messagesender_send(), passing `internal_on_event_send_complete_callback`]  
-				uamqp_result = messagesender_send(instance->message_sender, amqp_message, internal_on_event_send_complete_callback, task);
-				task->send_time = get_time(NULL);
+				time_t send_time;
+
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_005: [The batch shall be submitted with messagesender_send(), passing `internal_on_event_send_complete_callback` and the first event of the batch as context]
+				int uamqp_result = messagesender_send(instance->message_sender, batch, internal_on_event_send_complete_callback, first_task);
+				send_time = get_time(NULL);
 
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_159: [The MESSAGE_HANDLE shall be destroyed using message_destroy().]
-				message_destroy(amqp_message);
+				for (task = first_task; task != NULL; task = task->next_in_batch)
+				{
+					task->send_time = send_time;
+					task->send_timeout_secs = instance->event_send_timeout_secs;
+				}
 
 				if (uamqp_result != RESULT_OK)
 				{
-					LogError("Failed sending event (messagesender_send failed; error: %d)", uamqp_result);
+					LogError("Failed sending batch of %lu events (messagesender_send failed; error: %d)", (unsigned long)event_count, uamqp_result);
 
+					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_006: [If messagesender_send() fails, every event of the batch shall be completed with result EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING and destroyed, and messenger_do_work() shall stop sending]
+					fail_batched_events(instance, first_task, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING);
 					result = __FAILURE__;
+				}
+			}
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_007: [The batch MESSAGE_HANDLE shall be destroyed using message_destroy()]
+			message_destroy(batch);
+		}
+	}
+
+	return result;
+}
 
-					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_158: [If messagesender_send() fails, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING]
-					task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, (void*)task->context);
+static int send_pending_events(MESSENGER_INSTANCE* instance)
+{
+	int result = RESULT_OK;
 
-					// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
-					remove_event_from_in_progress_list(task);
-					free(task);
+	MESSENGER_SEND_EVENT_TASK* task;
 
-					break;
-				}
+	while ((task = get_next_event_to_send(instance)) != NULL)
+	{
+		int uamqp_result;
+		MESSAGE_HANDLE amqp_message = NULL;
+
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_153: [messenger_do_work() shall move each event to be sent from `instance->wait_to_send_list` to `instance->in_progress_list`] 
+		move_event_to_in_progress_list(task);
+		task->next_in_batch = NULL;
+
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_154: [A MESSAGE_HANDLE shall be obtained out of the event's IOTHUB_MESSAGE_HANDLE instance by using message_create_from_iothub_message()]  
+		if ((uamqp_result = message_create_from_iothub_message(task->message->messageHandle, &amqp_message)) != RESULT_OK)
+		{
+			LogError("Failed sending event message (failed creating AMQP message; error: %d).", uamqp_result);
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_155: [If message_create_from_iothub_message() fails, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]  
+			task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, (void*)task->context);
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
+			remove_event_from_in_progress_list(task);
+			destroy_send_event_task(instance, task);
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_156: [If message_create_from_iothub_message() fails, messenger_do_work() shall skip to the next event to be sent]  
+		}
+		else
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_157: [The MESSAGE_HANDLE shall be submitted for sending using messagesender_send(), passing `internal_on_event_send_complete_callback`]  
+			uamqp_result = messagesender_send(instance->message_sender, amqp_message, internal_on_event_send_complete_callback, task);
+			task->send_time = get_time(NULL);
+			task->send_timeout_secs = instance->event_send_timeout_secs;
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_159: [The MESSAGE_HANDLE shall be destroyed using message_destroy().]
+			message_destroy(amqp_message);
+
+			if (uamqp_result != RESULT_OK)
+			{
+				LogError("Failed sending event (messagesender_send failed; error: %d)", uamqp_result);
+
+				result = __FAILURE__;
+
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_158: [If messagesender_send() fails, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING]
+				task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, (void*)task->context);
+
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_160: [If any failure occurs the event shall be removed from `instance->in_progress_list` and destroyed]  
+				remove_event_from_in_progress_list(task);
+				destroy_send_event_task(instance, task);
+
+				break;
 			}
 		}
 	}
@@ -1033,48 +1099,74 @@ static int send_pending_events(MESSENGER_INSTANCE* instance)
 }
 
 // @brief
-//     Goes through each task in in_progress_list and checks if the events timed out to be sent.
+//     Tells whether the event send timeout `a` expires sooner than `b`, where 0 means never.
+static bool is_shorter_send_timeout(size_t a, size_t b)
+{
+	return (a != 0 && (b == 0 || a < b));
+}
+
+// @brief
+//     Goes through the tasks in in_progress_list and checks if the events timed out to be sent.
 // @remarks
 //     If an event is timed out, it is marked as such but not removed, and the upper layer callback is invoked.
+//     Tasks are added to in_progress_list in the order they are sent, so while the timeout has not been shortened
+//     they also time out in that order and the check stops at the first task that has not timed out yet.
+//     Otherwise all tasks are checked, until the remaining ones are back in timeout order.
 // @returns
 //     0 if no failures occur, non-zero otherwise.
 static int process_event_send_timeouts(MESSENGER_INSTANCE* instance)
 {
 	int result = RESULT_OK;
+	bool is_ordered = true;
+	// 1 is the shortest timeout that expires, so the first task checked is never out of order.
+	size_t last_send_timeout_secs = 1;
+	PDLIST_ENTRY list_entry = instance->in_progress_list.Flink;
 
-	if (instance->event_send_timeout_secs > 0)
+	while (list_entry != &instance->in_progress_list)
 	{
-		LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->in_progress_list);
+		MESSENGER_SEND_EVENT_TASK* task = containingRecord(list_entry, MESSENGER_SEND_EVENT_TASK, entry);
 
-		while (list_item != NULL)
+		if (task->is_timed_out == false)
 		{
-			MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_item);
+			int is_timed_out = 0;
 
-			if (task->is_timed_out == false)
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_012: [An event shall time out `task->send_timeout_secs` seconds after it was sent, using the value of `instance->event_send_timeout_secs` at the time it was sent, or never if that value is 0]
+			if (task->send_timeout_secs > 0 && is_timeout_reached(task->send_time, task->send_timeout_secs, &is_timed_out) != RESULT_OK)
 			{
-				int is_timed_out;
+				LogError("messenger failed to evaluate event send timeout of event %d", task->message);
+				result = __FAILURE__;
+			}
+			else if (is_timed_out)
+			{
+				task->is_timed_out = true;
 
-				if (is_timeout_reached(task->send_time, instance->event_send_timeout_secs, &is_timed_out) == RESULT_OK)
+				if (task->on_event_send_complete_callback != NULL)
 				{
-					if (is_timed_out)
-					{
-						task->is_timed_out = true;
-
-						if (task->on_event_send_complete_callback != NULL)
-						{
-							task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, task->context);
-						}
-					}
+					task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, task->context);
 				}
-				else
+			}
+			else if (instance->in_progress_timeouts_ordered)
+			{
+				break;
+			}
+			else
+			{
+				if (is_shorter_send_timeout(task->send_timeout_secs, last_send_timeout_secs))
 				{
-					LogError("messenger failed to evaluate event send timeout of event %d", task->message);
-					result = __FAILURE__;
+					is_ordered = false;
 				}
-			}
 
-			list_item = singlylinkedlist_get_next_item(list_item);
+				last_send_timeout_secs = task->send_timeout_secs;
+			}
 		}
+
+		list_entry = list_entry->Flink;
+	}
+
+	if (!instance->in_progress_timeouts_ordered && result == RESULT_OK && is_ordered &&
+		!is_shorter_send_timeout(instance->event_send_timeout_secs, last_send_timeout_secs))
+	{
+		instance->in_progress_timeouts_ordered = true;
 	}
 
 	return result;
@@ -1084,20 +1176,20 @@ static int process_event_send_timeouts(MESSENGER_INSTANCE* instance)
 //     Removes all the timed out events from the in_progress_list, without invoking callbacks or detroying the messages.
 static void remove_timed_out_events(MESSENGER_INSTANCE* instance)
 {
-	LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->in_progress_list);
+	PDLIST_ENTRY list_entry = instance->in_progress_list.Flink;
 
-	while (list_item != NULL)
+	while (list_entry != &instance->in_progress_list)
 	{
-		MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_item);
+		MESSENGER_SEND_EVENT_TASK* task = containingRecord(list_entry, MESSENGER_SEND_EVENT_TASK, entry);
+
+		// Saving the next entry, since removing the task resets its links.
+		list_entry = list_entry->Flink;
 
 		if (task->is_timed_out == true)
 		{
 			remove_event_from_in_progress_list(task);
-
-			free(task);
+			destroy_send_event_task(instance, task);
 		}
-
-		list_item = singlylinkedlist_get_next_item(list_item);
 	}
 }
 
@@ -1121,6 +1213,9 @@ static void* messenger_clone_option(const char* name, const void* value)
 	else
 	{
 		if (strcmp(MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, name) == 0 ||
+			strcmp(MESSENGER_OPTION_BATCHING, name) == 0 ||
+			strcmp(MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, name) == 0 ||
+			strcmp(MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, name) == 0 ||
 			strcmp(MESSENGER_OPTION_SAVED_OPTIONS, name) == 0)
 		{
 			result = (void*)value;
@@ -1325,24 +1420,13 @@ int messenger_send_async(MESSENGER_HANDLE messenger_handle, IOTHUB_MESSAGE_LIST*
 		MESSENGER_SEND_EVENT_TASK *task;
 		MESSENGER_INSTANCE *instance = (MESSENGER_INSTANCE*)messenger_handle;
 
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_137: [messenger_send_async() shall allocate memory for a MESSENGER_SEND_EVENT_TASK structure (aka `task`)]  
-		if ((task = (MESSENGER_SEND_EVENT_TASK*)malloc(sizeof(MESSENGER_SEND_EVENT_TASK))) == NULL)
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_137: [messenger_send_async() shall take a MESSENGER_SEND_EVENT_TASK structure (aka `task`) from the instance task pool, or allocate memory for one if the pool is empty]  
+		if ((task = create_send_event_task(instance)) == NULL)
 		{
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_138: [If malloc() fails, messenger_send_async() shall fail and return a non-zero value]
 			LogError("Failed sending event (failed to create struct for task; malloc failed)");
 			result = __FAILURE__;
 		}
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_100: [`task` shall be added to `instance->waiting_to_send` using singlylinkedlist_add()]  
-		else if (singlylinkedlist_add(instance->waiting_to_send, task) == NULL)
-		{
-			LogError("Failed sending event (singlylinkedlist_add failed)");
-
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_139: [If singlylinkedlist_add() fails, messenger_send_async() shall fail and return a non-zero value]
-			result = __FAILURE__;
-
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_142: [If any failure occurs, messenger_send_async() shall free any memory it has allocated]
-			free(task);
-		}
 		else
 		{
 			memset(task, 0, sizeof(MESSENGER_SEND_EVENT_TASK));
@@ -1352,6 +1436,9 @@ int messenger_send_async(MESSENGER_HANDLE messenger_handle, IOTHUB_MESSAGE_LIST*
 			task->send_time = INDEFINITE_TIME;
 			task->messenger = instance;
 			task->is_timed_out = false;
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_100: [`task` shall be added to the end of `instance->waiting_to_send`]  
+			DList_InsertTailList(&instance->waiting_to_send, &task->entry);
 			
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_143: [If no failures occur, messenger_send_async() shall return zero]  
 			result = RESULT_OK;
@@ -1380,11 +1467,9 @@ int messenger_get_send_status(MESSENGER_HANDLE messenger_handle, MESSENGER_SEND_
 	else
 	{
 		MESSENGER_INSTANCE* instance = (MESSENGER_INSTANCE*)messenger_handle;
-		LIST_ITEM_HANDLE wts_list_head = singlylinkedlist_get_head_item(instance->waiting_to_send);
-		LIST_ITEM_HANDLE ip_list_head = singlylinkedlist_get_head_item(instance->in_progress_list);
 
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_147: [If `instance->in_progress_list` and `instance->wait_to_send_list` are empty, send_status shall be set to MESSENGER_SEND_STATUS_IDLE] 
-		if (wts_list_head == NULL && ip_list_head == NULL)
+		if (DList_IsListEmpty(&instance->waiting_to_send) && DList_IsListEmpty(&instance->in_progress_list))
 		{
 			*send_status = MESSENGER_SEND_STATUS_IDLE;
 		}
@@ -1474,20 +1559,11 @@ int messenger_stop(MESSENGER_HANDLE messenger_handle)
 			remove_timed_out_events(instance);
 
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_162: [messenger_stop() shall move all items from `instance->in_progress_list` to the beginning of `instance->wait_to_send_list`]
-			if (move_events_to_wait_to_send_list(instance) != RESULT_OK)
-			{
-				LogError("Messenger failed to move events in progress back to wait_to_send list");
-				
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_163: [If not all items from `instance->in_progress_list` can be moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_ERROR, and `instance->on_state_changed_callback` invoked]
-				update_messenger_state(instance, MESSENGER_STATE_ERROR);
-				result = __FAILURE__;
-			}
-			else
-			{
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_164: [If all items get successfuly moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_STOPPED, and `instance->on_state_changed_callback` invoked]
-				update_messenger_state(instance, MESSENGER_STATE_STOPPED);
-				result = RESULT_OK;
-			}
+			move_events_to_wait_to_send_list(instance);
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_164: [Once all items are moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_STOPPED, and `instance->on_state_changed_callback` invoked]
+			update_messenger_state(instance, MESSENGER_STATE_STOPPED);
+			result = RESULT_OK;
 		}
 	}
 
@@ -1612,7 +1688,8 @@ void messenger_do_work(MESSENGER_HANDLE messenger_handle)
 			{
 				update_messenger_state(instance, MESSENGER_STATE_ERROR);
 			}
-			else if (send_pending_events(instance) != RESULT_OK && instance->event_send_retry_limit > 0)
+			else if ((instance->is_batching_enabled ? send_pending_events_batched(instance) : send_pending_events(instance)) != RESULT_OK &&
+				instance->event_send_retry_limit > 0)
 			{
 				instance->event_send_error_count++;
 
@@ -1640,7 +1717,6 @@ void messenger_destroy(MESSENGER_HANDLE messenger_handle)
 	}
 	else
 	{
-		LIST_ITEM_HANDLE list_node;
 		MESSENGER_INSTANCE* instance = (MESSENGER_INSTANCE*)messenger_handle;
 
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_110: [If the `instance->state` is not MESSENGER_STATE_STOPPED, messenger_destroy() shall invoke messenger_stop()]
@@ -1651,37 +1727,29 @@ void messenger_destroy(MESSENGER_HANDLE messenger_handle)
 
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_111: [All elements of `instance->in_progress_list` and `instance->wait_to_send_list` shall be removed, invoking `task->on_event_send_complete_callback` for each with EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED]
 
-		// Note: yes messenger_stop() tried to move all events from in_progress_list to wait_to_send_list, 
-		//       but we need to iterate through in case any events failed to be moved.
-		while ((list_node = singlylinkedlist_get_head_item(instance->in_progress_list)) != NULL)
+		// Note: yes messenger_stop() moved all events from in_progress_list to wait_to_send_list, 
+		//       but in_progress_list is drained as well in case messenger_stop() was not able to run.
+		while (!DList_IsListEmpty(&instance->in_progress_list))
 		{
-			MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_node);
-
-			(void)singlylinkedlist_remove(instance->in_progress_list, list_node);
+			MESSENGER_SEND_EVENT_TASK* task = containingRecord(DList_RemoveHeadList(&instance->in_progress_list), MESSENGER_SEND_EVENT_TASK, entry);
 
-			if (task != NULL)
-			{
-				task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
-				free(task);
-			}
+			task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
+			free(task);
 		}
 
-		while ((list_node = singlylinkedlist_get_head_item(instance->waiting_to_send)) != NULL)
+		while (!DList_IsListEmpty(&instance->waiting_to_send))
 		{
-			MESSENGER_SEND_EVENT_TASK* task = (MESSENGER_SEND_EVENT_TASK*)singlylinkedlist_item_get_value(list_node);
-
-			(void)singlylinkedlist_remove(instance->waiting_to_send, list_node);
+			MESSENGER_SEND_EVENT_TASK* task = containingRecord(DList_RemoveHeadList(&instance->waiting_to_send), MESSENGER_SEND_EVENT_TASK, entry);
 
-			if (task != NULL)
-			{
-				task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
-				free(task);
-			}
+			task->on_event_send_complete_callback(task->message, MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED, (void*)task->context);
+			free(task);
 		}
 
-		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_150: [`instance->in_progress_list` and `instance->wait_to_send_list` shall be destroyed using singlylinkedlist_destroy()]
-		singlylinkedlist_destroy(instance->waiting_to_send);
-		singlylinkedlist_destroy(instance->in_progress_list);
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_150: [All MESSENGER_SEND_EVENT_TASK structures in the instance task pool shall be destroyed using free()]
+		while (!DList_IsListEmpty(&instance->send_event_task_pool))
+		{
+			free(containingRecord(DList_RemoveHeadList(&instance->send_event_task_pool), MESSENGER_SEND_EVENT_TASK, entry));
+		}
 
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_112: [`instance->iothub_host_fqdn` shall be destroyed using STRING_delete()]
 		STRING_delete(instance->iothub_host_fqdn);
@@ -1737,9 +1805,18 @@ MESSENGER_HANDLE messenger_create(const MESSENGER_CONFIG* messenger_config)
 			instance->message_receiver_previous_state = MESSAGE_RECEIVER_STATE_IDLE;
 			instance->event_send_retry_limit = DEFAULT_EVENT_SEND_RETRY_LIMIT;
 			instance->event_send_timeout_secs = DEFAULT_EVENT_SEND_TIMEOUT_SECS;
+			instance->in_progress_timeouts_ordered = true;
+			instance->max_events_per_batch = DEFAULT_MAX_EVENTS_PER_BATCH;
+			instance->max_batch_size_in_bytes = DEFAULT_MAX_BATCH_SIZE_IN_BYTES;
 			instance->last_message_sender_state_change_time = INDEFINITE_TIME;
 			instance->last_message_receiver_state_change_time = INDEFINITE_TIME;
 
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_165: [`instance->wait_to_send_list`, `instance->in_progress_list` and the instance task pool shall be initialized as empty lists]
+			DList_InitializeListHead(&instance->waiting_to_send);
+			DList_InitializeListHead(&instance->in_progress_list);
+			DList_InitializeListHead(&instance->send_event_task_pool);
+			instance->send_event_task_pool_size = 0;
+
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_008: [messenger_create() shall save a copy of `messenger_config->device_id` into `instance->device_id`]
 			if ((instance->device_id = STRING_construct(messenger_config->device_id)) == NULL)
 			{
@@ -1754,20 +1831,6 @@ MESSENGER_HANDLE messenger_create(const MESSENGER_CONFIG* messenger_config)
 				handle = NULL;
 				LogError("messenger_create failed (iothub_host_fqdn could not be copied; STRING_construct failed)");
 			}
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_165: [`instance->wait_to_send_list` shall be set using singlylinkedlist_create()]
-			else if ((instance->waiting_to_send = singlylinkedlist_create()) == NULL)
-			{
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_166: [If singlylinkedlist_create() fails, messenger_create() shall fail and return NULL]  
-				handle = NULL;
-				LogError("messenger_create failed (singlylinkedlist_create failed to create wait_to_send_list)");
-			}
-			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_132: [`instance->in_progress_list` shall be set using singlylinkedlist_create()]  
-			else if ((instance->in_progress_list = singlylinkedlist_create()) == NULL)
-			{
-				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_133: [If singlylinkedlist_create() fails, messenger_create() shall fail and return NULL] 
-				handle = NULL;
-				LogError("messenger_create failed (singlylinkedlist_create failed to create in_progress_list)");
-			}
 			else
 			{
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_013: [`messenger_config->on_state_changed_callback` shall be saved into `instance->on_state_changed_callback`]
@@ -1808,9 +1871,53 @@ int messenger_set_option(MESSENGER_HANDLE messenger_handle, const char* name, vo
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_168: [If name matches MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, `value` shall be saved on `instance->event_send_timeout_secs`]
 		if (strcmp(MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, name) == 0)
 		{
-			instance->event_send_timeout_secs = *((size_t*)value);
+			size_t event_send_timeout_secs = *((size_t*)value);
+
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_013: [If the new timeout is shorter than the current one and `instance->in_progress_list` is not empty, messenger_do_work() shall check every in-progress event for timeout until they no longer time out out of order]
+			if (is_shorter_send_timeout(event_send_timeout_secs, instance->event_send_timeout_secs) && !DList_IsListEmpty(&instance->in_progress_list))
+			{
+				instance->in_progress_timeouts_ordered = false;
+			}
+
+			instance->event_send_timeout_secs = event_send_timeout_secs;
+			result = RESULT_OK;
+		}
+		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_008: [If name matches MESSENGER_OPTION_BATCHING, `value` shall be saved on `instance->is_batching_enabled`]
+		else if (strcmp(MESSENGER_OPTION_BATCHING, name) == 0)
+		{
+			instance->is_batching_enabled = *((bool*)value);
 			result = RESULT_OK;
 		}
+		else if (strcmp(MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, name) == 0)
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_010: [If the value of MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES is 0, messenger_set_option shall fail and return a non-zero value]
+			if (*((size_t*)value) == 0)
+			{
+				LogError("messenger_set_option failed (%s cannot be 0)", name);
+				result = __FAILURE__;
+			}
+			else
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_009: [If name matches MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, `value` shall be saved on `instance->max_events_per_batch` or `instance->max_batch_size_in_bytes`]
+				instance->max_events_per_batch = *((size_t*)value);
+				result = RESULT_OK;
+			}
+		}
+		else if (strcmp(MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, name) == 0)
+		{
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_010: [If the value of MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES is 0, messenger_set_option shall fail and return a non-zero value]
+			if (*((size_t*)value) == 0)
+			{
+				LogError("messenger_set_option failed (%s cannot be 0)", name);
+				result = __FAILURE__;
+			}
+			else
+			{
+				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_009: [If name matches MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, `value` shall be saved on `instance->max_events_per_batch` or `instance->max_batch_size_in_bytes`]
+				instance->max_batch_size_in_bytes = *((size_t*)value);
+				result = RESULT_OK;
+			}
+		}
 		// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_169: [If name matches MESSENGER_OPTION_SAVED_OPTIONS, `value` shall be applied using OptionHandler_FeedOptions]
 		else if (strcmp(MESSENGER_OPTION_SAVED_OPTIONS, name) == 0)
 		{
@@ -1864,11 +1971,27 @@ OPTIONHANDLER_HANDLE messenger_retrieve_options(MESSENGER_HANDLE messenger_handl
 
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_176: [Each option of `instance` shall be added to the OPTIONHANDLER_HANDLE instance using OptionHandler_AddOption]
 			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_177: [If OptionHandler_AddOption fails, messenger_retrieve_options shall fail and return NULL]
+			// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_011: [The options saved shall be MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, MESSENGER_OPTION_BATCHING, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH and MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES]
 			if (OptionHandler_AddOption(options, MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, (void*)&instance->event_send_timeout_secs) != OPTIONHANDLER_OK)
 			{
 				LogError("Failed to retrieve options from messenger instance (OptionHandler_Create failed for option '%s')", MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS);
 				result = NULL;
 			}
+			else if (OptionHandler_AddOption(options, MESSENGER_OPTION_BATCHING, (void*)&instance->is_batching_enabled) != OPTIONHANDLER_OK)
+			{
+				LogError("Failed to retrieve options from messenger instance (OptionHandler_Create failed for option '%s')", MESSENGER_OPTION_BATCHING);
+				result = NULL;
+			}
+			else if (OptionHandler_AddOption(options, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, (void*)&instance->max_events_per_batch) != OPTIONHANDLER_OK)
+			{
+				LogError("Failed to retrieve options from messenger instance (OptionHandler_Create failed for option '%s')", MESSENGER_OPTION_MAX_EVENTS_PER_BATCH);
+				result = NULL;
+			}
+			else if (OptionHandler_AddOption(options, MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, (void*)&instance->max_batch_size_in_bytes) != OPTIONHANDLER_OK)
+			{
+				LogError("Failed to retrieve options from messenger instance (OptionHandler_Create failed for option '%s')", MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES);
+				result = NULL;
+			}
 			else
 			{
 				// Codes_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_179: [If no failures occur, messenger_retrieve_options shall return the OPTIONHANDLER_HANDLE instance]
@@ -14,6 +14,7 @@
 #include "iothub_client_ll.h"
 #include "iothub_client_options.h"
 #include "iothub_client_private.h"
+#include "iothub_client_slab_pool.h"
 #include "azure_umqtt_c/mqtt_client.h"
 #include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/tickcounter.h"
@@ -21,7 +22,6 @@
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/platform.h"
 
-#include "azure_c_shared_utility/string_tokenizer.h"
 #include "iothub_client_version.h"
 
 #include "iothubtransport_mqtt_common.h"
@@ -45,6 +45,8 @@
 #define STATUS_CODE_FAILURE_VALUE   500
 #define STATUS_CODE_TIMEOUT_VALUE   408
 #define ERROR_TIME_FOR_RETRY_SECS   5       // We won't retry more than once every 5 seconds
+#define DEFAULT_MAX_IN_FLIGHT_MESSAGES  0   // 0 means no limit
+#define DEFAULT_MAX_PUBLISH_PER_DOWORK  0   // 0 means no limit
 
 static const char TOPIC_DEVICE_TWIN_PREFIX[] = "$iothub/twin";
 static const char TOPIC_DEVICE_METHOD_PREFIX[] = "$iothub/methods";
@@ -78,6 +80,12 @@ static const char* CORRELATION_ID_PROPERTY = "cid";
 #define SUBSCRIBE_DEVICE_METHOD_TOPIC           0x0010
 #define SUBSCRIBE_TOPIC_COUNT                   4
 
+/*inbound topic fields (method name, message/correlation id) up to this length are made into strings on the stack*/
+#define TOPIC_FIELD_STACK_SIZE                  128
+
+// Number of slots each packet id index holds inside the transport before it has to grow on the heap, must be a power of 2
+#define PACKET_ID_INDEX_INITIAL_SLOTS           16
+
 DEFINE_ENUM_STRINGS(MQTT_CLIENT_EVENT_ERROR, MQTT_CLIENT_EVENT_ERROR_VALUES)
 
 typedef struct SYSTEM_PROPERTY_INFO_TAG
@@ -92,7 +100,6 @@ static SYSTEM_PROPERTY_INFO sysPropList[] = {
     { "%24.uid", 7 },
     { "%24.to", 6 },
     { "%24.cid", 7 },
-    { "devices/", 8 },
     { "iothub-operation", 16 },
     { "iothub-ack", 10 }
 };
@@ -141,6 +148,22 @@ typedef struct MQTT_TRANSPORT_CREDENTIALS_TAG
     } CREDENTIAL_VALUE;
 } MQTT_TRANSPORT_CREDENTIALS;
 
+typedef struct PACKET_ID_SLOT_TAG
+{
+    uint16_t packet_id;
+    void* item;
+} PACKET_ID_SLOT;
+
+// Open addressing table from packet id to the item waiting for it. Packet ids are handed out sequentially,
+// so the low bits of the id are used directly as the hash and consecutive requests land in consecutive slots.
+typedef struct PACKET_ID_INDEX_TAG
+{
+    PACKET_ID_SLOT* slots;
+    size_t slot_count;
+    size_t item_count;
+    PACKET_ID_SLOT initial_slots[PACKET_ID_INDEX_INITIAL_SLOTS];
+} PACKET_ID_INDEX;
+
 typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
 {
     // Topic control
@@ -199,12 +222,20 @@ typedef struct MQTTTRANSPORT_HANDLE_DATA_TAG
     // Internal lists for message tracking
     PDLIST_ENTRY waitingToSend;
     DLIST_ENTRY ack_waiting_queue;
+    PACKET_ID_INDEX ack_waiting_index;
 
     // Message tracking
     CONTROL_PACKET_TYPE currPacketState;
 
     // Telemetry specific
     DLIST_ENTRY telemetry_waitingForAck;
+    PACKET_ID_INDEX telemetry_waitingForAck_index;
+    size_t telemetry_inFlightCount;
+    size_t maxInFlightMessages;
+    size_t maxPublishPerDoWork;
+    SLAB_POOL_HANDLE messageDetailsPool; /*NULL unless "message_pool_size" was set, then the MQTT_MESSAGE_DETAILS_LIST records come from it*/
+    char* telemetryTopicBuffer; /*scratch space for event topics that carry properties, only grows*/
+    size_t telemetryTopicBufferSize;
 
     //Retry Logic
     RETRY_LOGIC* retryLogic;
@@ -234,9 +265,28 @@ typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
 
 typedef struct DEVICE_METHOD_INFO_TAG
 {
-    STRING_HANDLE request_id;
+    /*points just past the structure, both live in one allocation*/
+    char* request_id;
 } DEVICE_METHOD_INFO;
 
+/*a piece of an inbound topic, not zero terminated*/
+typedef struct MQTT_TOPIC_SPAN_TAG
+{
+    const char* start;
+    size_t length;
+} MQTT_TOPIC_SPAN;
+
+typedef struct MQTT_TOPIC_INFO_TAG
+{
+    IOTHUB_IDENTITY_TYPE type;
+    bool patch_msg;
+    int status_code;
+    size_t request_id;
+    MQTT_TOPIC_SPAN method_name;
+    MQTT_TOPIC_SPAN method_request_id;
+    MQTT_TOPIC_SPAN properties;
+} MQTT_TOPIC_INFO;
+
 static int RetryPolicy_Exponential_BackOff_With_Jitter(bool *permit, size_t* delay, void* retryContextCallback)
 {
     int result;
@@ -535,16 +585,150 @@ static bool CanRetry(RETRY_LOGIC *retryLogic)
 }
 
 
-static uint16_t get_next_packet_id(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+static void packet_id_index_init(PACKET_ID_INDEX* index)
+{
+    index->slots = index->initial_slots;
+    index->slot_count = PACKET_ID_INDEX_INITIAL_SLOTS;
+    index->item_count = 0;
+    (void)memset(index->initial_slots, 0, sizeof(index->initial_slots));
+}
+
+static void packet_id_index_deinit(PACKET_ID_INDEX* index)
+{
+    if (index->slots != index->initial_slots)
+    {
+        free(index->slots);
+    }
+    packet_id_index_init(index);
+}
+
+static size_t packet_id_index_find_slot(const PACKET_ID_INDEX* index, uint16_t packet_id)
+{
+    size_t mask = index->slot_count - 1;
+    size_t position = packet_id & mask;
+    while ((index->slots[position].item != NULL) && (index->slots[position].packet_id != packet_id))
+    {
+        position = (position + 1) & mask;
+    }
+    return position;
+}
+
+static void* packet_id_index_find(const PACKET_ID_INDEX* index, uint16_t packet_id)
 {
-    if (transport_data->packetId+1 >= USHRT_MAX)
+    return index->slots[packet_id_index_find_slot(index, packet_id)].item;
+}
+
+static int packet_id_index_grow(PACKET_ID_INDEX* index)
+{
+    int result;
+    size_t new_slot_count = index->slot_count * 2;
+    PACKET_ID_SLOT* new_slots = (PACKET_ID_SLOT*)malloc(new_slot_count * sizeof(PACKET_ID_SLOT));
+    if (new_slots == NULL)
     {
-        transport_data->packetId = 1;
+        LogError("Failure allocating packet id index.");
+        result = __FAILURE__;
     }
     else
     {
-        transport_data->packetId++;
+        PACKET_ID_SLOT* old_slots = index->slots;
+        size_t old_slot_count = index->slot_count;
+        size_t slot_index;
+
+        (void)memset(new_slots, 0, new_slot_count * sizeof(PACKET_ID_SLOT));
+        index->slots = new_slots;
+        index->slot_count = new_slot_count;
+        for (slot_index = 0; slot_index < old_slot_count; slot_index++)
+        {
+            if (old_slots[slot_index].item != NULL)
+            {
+                index->slots[packet_id_index_find_slot(index, old_slots[slot_index].packet_id)] = old_slots[slot_index];
+            }
+        }
+        if (old_slots != index->initial_slots)
+        {
+            free(old_slots);
+        }
+        result = 0;
+    }
+    return result;
+}
+
+static int packet_id_index_add(PACKET_ID_INDEX* index, uint16_t packet_id, void* item)
+{
+    int result;
+    /* keep the load under 3/4 so probes stay short */
+    if (((index->item_count + 1) * 4 > index->slot_count * 3) && (packet_id_index_grow(index) != 0))
+    {
+        result = __FAILURE__;
     }
+    else
+    {
+        size_t position = packet_id_index_find_slot(index, packet_id);
+        if (index->slots[position].item == NULL)
+        {
+            index->item_count++;
+        }
+        index->slots[position].packet_id = packet_id;
+        index->slots[position].item = item;
+        result = 0;
+    }
+    return result;
+}
+
+static void* packet_id_index_remove(PACKET_ID_INDEX* index, uint16_t packet_id)
+{
+    size_t mask = index->slot_count - 1;
+    size_t hole = packet_id_index_find_slot(index, packet_id);
+    void* result = index->slots[hole].item;
+    if (result != NULL)
+    {
+        /* shift the rest of the probe run back into the hole so later lookups do not stop early */
+        size_t position = hole;
+        while (true)
+        {
+            size_t home;
+            position = (position + 1) & mask;
+            if (index->slots[position].item == NULL)
+            {
+                break;
+            }
+            home = index->slots[position].packet_id & mask;
+            if (((position > hole) && ((home <= hole) || (home > position))) ||
+                ((position < hole) && ((home <= hole) && (home > position))))
+            {
+                index->slots[hole] = index->slots[position];
+                hole = position;
+            }
+        }
+        index->slots[hole].item = NULL;
+        index->item_count--;
+        if ((index->item_count == 0) && (index->slots != index->initial_slots))
+        {
+            /* give the heap table back once the burst has drained */
+            packet_id_index_deinit(index);
+        }
+    }
+    return result;
+}
+
+static uint16_t get_next_packet_id(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    size_t attempts = 0;
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_014: [ A packet id that is still waiting for a PUBACK or a device twin response shall not be handed out again. ] */
+    do
+    {
+        if (transport_data->packetId+1 >= USHRT_MAX)
+        {
+            transport_data->packetId = 1;
+        }
+        else
+        {
+            transport_data->packetId++;
+        }
+        attempts++;
+    } while ((attempts < USHRT_MAX) &&
+        ((packet_id_index_find(&transport_data->telemetry_waitingForAck_index, transport_data->packetId) != NULL) ||
+        (packet_id_index_find(&transport_data->ack_waiting_index, transport_data->packetId) != NULL)));
     return transport_data->packetId;
 }
 
@@ -570,203 +754,212 @@ static const char* retrieve_mqtt_return_codes(CONNECT_RETURN_CODE rtn_code)
     }
 }
 
-static int retrieve_device_method_rid_info(const char* resp_topic, STRING_HANDLE method_name, STRING_HANDLE request_id)
+static bool topic_starts_with(const char* topic, size_t topic_length, const char* prefix, size_t prefix_length)
 {
-    int result;
-    STRING_TOKENIZER_HANDLE token_handle = STRING_TOKENIZER_create_from_char(resp_topic);
-    if (token_handle == NULL)
+    bool result;
+    if (topic_length < prefix_length)
     {
-        LogError("Failed creating token from device twin topic.");
-        result = __FAILURE__;
+        result = false;
     }
     else
     {
-        STRING_HANDLE token_value;
-        if ((token_value = STRING_new()) == NULL)
-        {
-            LogError("Failed allocating new string .");
-            result = __FAILURE__;
-        }
-        else
+        size_t index;
+        result = true;
+        for (index = 0; index < prefix_length; index++)
         {
-            size_t token_index = 0;
-            size_t request_id_length = strlen(REQUEST_ID_PROPERTY);
-            result = __FAILURE__;
-            while (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/") == 0)
+            if (TOUPPER(prefix[index]) != TOUPPER(topic[index]))
             {
-                if (token_index == 3)
-                {
-                    if (STRING_concat_with_STRING(method_name, token_value) != 0)
-                    {
-                        LogError("Failed STRING_concat_with_STRING.");
-                        result = __FAILURE__;
-                        break;
-                    }
-                }
-                else if (token_index == 4)
-                {
-                    if (STRING_length(token_value) >= request_id_length)
-                    {
-                        const char* request_id_value = STRING_c_str(token_value);
-                        if (memcmp(request_id_value, REQUEST_ID_PROPERTY, request_id_length) == 0)
-                        {
-                            if (STRING_concat(request_id, request_id_value+request_id_length) != 0)
-                            {
-                                LogError("Failed STRING_concat failed.");
-                                result = __FAILURE__;
-                            }
-                            else
-                            {
-                                result = 0;
-                            }
-                            break;
-                        }
-                    }
-                }
-                token_index++;
+                result = false;
+                break;
             }
-            STRING_delete(token_value);
         }
-        STRING_TOKENIZER_destroy(token_handle);
     }
     return result;
 }
 
-static int parse_device_twin_topic_info(const char* resp_topic, bool* patch_msg, size_t* request_id, int* status_code)
+/*reads the segment that follows the '/' at position, returns where that segment ends or NULL if position is not a '/'*/
+static const char* read_topic_segment(const char* position, const char* end, MQTT_TOPIC_SPAN* segment)
+{
+    const char* result;
+    if ((position >= end) || (*position != '/'))
+    {
+        result = NULL;
+    }
+    else
+    {
+        segment->start = position + 1;
+        result = segment->start;
+        while ((result < end) && (*result != '/'))
+        {
+            result++;
+        }
+        segment->length = (size_t)(result - segment->start);
+    }
+    return result;
+}
+
+/*value of the leading decimal digits of the span, 0 if there are none*/
+static size_t topic_span_to_number(const char* start, size_t length)
+{
+    size_t result = 0;
+    size_t index;
+    for (index = 0; (index < length) && (start[index] >= '0') && (start[index] <= '9'); index++)
+    {
+        result = (result * 10) + (size_t)(start[index] - '0');
+    }
+    return result;
+}
+
+/*returns the span as a zero terminated string, copied into buffer when it fits and into a new allocation otherwise*/
+static char* topic_span_to_string(const MQTT_TOPIC_SPAN* span, char* buffer, size_t buffer_size)
+{
+    char* result;
+    if (span->length < buffer_size)
+    {
+        result = buffer;
+    }
+    else if ((result = (char*)malloc(span->length + 1)) == NULL)
+    {
+        LogError("Failure allocating a copy of a topic field");
+    }
+
+    if (result != NULL)
+    {
+        (void)memcpy(result, span->start, span->length);
+        result[span->length] = '\0';
+    }
+    return result;
+}
+
+static int parse_device_twin_topic(const char* position, const char* end, MQTT_TOPIC_INFO* topic_info)
 {
     int result;
-    STRING_TOKENIZER_HANDLE token_handle = STRING_TOKENIZER_create_from_char(resp_topic);
-    if (token_handle == NULL)
+    MQTT_TOPIC_SPAN segment;
+    size_t request_id_length = strlen(REQUEST_ID_PROPERTY);
+
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_007: [ For a device twin topic, the segment after $iothub/twin shall tell a desired properties PATCH from a response, a response shall carry the status code in the next segment and the request id after ?$rid= in the one after. ] */
+    if ((position = read_topic_segment(position, end, &segment)) == NULL)
+    {
+        LogError("Failure: device twin topic has no operation segment");
+        result = __FAILURE__;
+    }
+    else if ((segment.length == 5) && (memcmp(segment.start, "PATCH", 5) == 0))
     {
-        LogError("Failed creating token from device twin topic.");
+        topic_info->patch_msg = true;
+        result = 0;
+    }
+    else if ((position = read_topic_segment(position, end, &segment)) == NULL)
+    {
+        LogError("Failure: device twin topic has no status code segment");
         result = __FAILURE__;
-        *status_code = 0;
-        *request_id = 0;
-        *patch_msg = false;
     }
     else
     {
-        STRING_HANDLE token_value;
-        if ((token_value = STRING_new()) == NULL)
+        topic_info->status_code = (int)topic_span_to_number(segment.start, segment.length);
+        if ((read_topic_segment(position, end, &segment) != NULL) &&
+            (segment.length >= request_id_length) &&
+            (memcmp(segment.start, REQUEST_ID_PROPERTY, request_id_length) == 0))
         {
-            LogError("Failed allocating new string .");
-            result = __FAILURE__;
-            *status_code = 0;
-            *request_id = 0;
-            *patch_msg = false;
+            topic_info->request_id = topic_span_to_number(segment.start + request_id_length, segment.length - request_id_length);
         }
-        else
-        {
-            result = __FAILURE__;
-            size_t token_count = 0;
-            while (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/") == 0)
-            {
-                if (token_count == 2)
-                {
-                    if (strcmp(STRING_c_str(token_value), "PATCH") == 0)
-                    {
-                        *patch_msg = true;
-                        *status_code = 0;
-                        *request_id = 0;
-                        result = 0;
-                        break;
-                    }
-                    else
-                    {
-                        *patch_msg = false;
-                    }
-                }
-                else if (token_count == 3)
-                {
-                    *status_code = atol(STRING_c_str(token_value));
-                    if (STRING_TOKENIZER_get_next_token(token_handle, token_value, "/?$rid=") == 0)
-                    {
-                        *request_id = (size_t)atol(STRING_c_str(token_value));
-                    }
-                    *patch_msg = false;
-                    result = 0;
-                    break;
-                }
-                token_count++;
-            }
-            STRING_delete(token_value);
-        }
-        STRING_TOKENIZER_destroy(token_handle);
+        result = 0;
     }
     return result;
 }
 
-static IOTHUB_IDENTITY_TYPE retrieve_topic_type(const char* topic_resp)
+static int parse_device_method_topic(const char* position, const char* end, MQTT_TOPIC_INFO* topic_info)
 {
-    IOTHUB_IDENTITY_TYPE type;
-    size_t dev_twin_topic_len = sizeof(TOPIC_DEVICE_TWIN_PREFIX)-1;
-    size_t dev_method_topic_len = sizeof(TOPIC_DEVICE_METHOD_PREFIX)-1;
-    size_t topic_len = strlen(topic_resp);
-    size_t len_to_use = (dev_twin_topic_len > dev_method_topic_len) ? dev_twin_topic_len : dev_method_topic_len;
+    int result;
+    MQTT_TOPIC_SPAN segment;
+    size_t request_id_length = strlen(REQUEST_ID_PROPERTY);
 
-    bool search_device_twin = true;
-    bool search_device_method = true;
-    if (topic_len < len_to_use)
+    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_008: [ For a device method topic, the second segment after $iothub/methods shall be the method name and the third one shall start with ?$rid= followed by the request id, otherwise the topic shall be rejected. ] */
+    if (((position = read_topic_segment(position, end, &segment)) == NULL) ||
+        ((position = read_topic_segment(position, end, &topic_info->method_name)) == NULL) ||
+        (read_topic_segment(position, end, &segment) == NULL) ||
+        (segment.length < request_id_length) ||
+        (memcmp(segment.start, REQUEST_ID_PROPERTY, request_id_length) != 0))
     {
-        search_device_twin = false;
-        search_device_method = false;
+        LogError("Failure: device method topic is not $iothub/methods/POST/{name}/?$rid={id}");
+        result = __FAILURE__;
     }
     else
     {
-        size_t index = 0;
-        for (index = 0; index < len_to_use && (search_device_twin || search_device_method); index++)
+        topic_info->method_request_id.start = segment.start + request_id_length;
+        topic_info->method_request_id.length = segment.length - request_id_length;
+        result = 0;
+    }
+    return result;
+}
+
+/*classifies an inbound topic and picks out its fields in one pass over the text, nothing is copied or allocated*/
+static int parse_mqtt_topic(const char* topic, size_t topic_length, MQTT_TOPIC_INFO* topic_info)
+{
+    int result;
+    size_t dev_twin_topic_len = sizeof(TOPIC_DEVICE_TWIN_PREFIX) - 1;
+    size_t dev_method_topic_len = sizeof(TOPIC_DEVICE_METHOD_PREFIX) - 1;
+    const char* end = topic + topic_length;
+
+    topic_info->patch_msg = false;
+    topic_info->status_code = 0;
+    topic_info->request_id = 0;
+    topic_info->method_name.start = NULL;
+    topic_info->method_name.length = 0;
+    topic_info->method_request_id.start = NULL;
+    topic_info->method_request_id.length = 0;
+    topic_info->properties.start = NULL;
+    topic_info->properties.length = 0;
+
+    if (topic_starts_with(topic, topic_length, TOPIC_DEVICE_TWIN_PREFIX, dev_twin_topic_len))
+    {
+        topic_info->type = IOTHUB_TYPE_DEVICE_TWIN;
+        result = parse_device_twin_topic(topic + dev_twin_topic_len, end, topic_info);
+    }
+    else if (topic_starts_with(topic, topic_length, TOPIC_DEVICE_METHOD_PREFIX, dev_method_topic_len))
+    {
+        topic_info->type = IOTHUB_TYPE_DEVICE_METHODS;
+        result = parse_device_method_topic(topic + dev_method_topic_len, end, topic_info);
+    }
+    else
+    {
+        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_009: [ For any other topic, the text after the last '/' shall be taken as the message properties. ] */
+        const char* properties = end;
+        while ((properties > topic) && (*(properties - 1) != '/'))
         {
-            if (search_device_twin)
-            {
-                if (index > dev_twin_topic_len)
-                {
-                    search_device_twin = false;
-                }
-                else
-                {
-                    if (index == dev_twin_topic_len)
-                    {
-                        break;
-                    }
-                    else if (TOUPPER(TOPIC_DEVICE_TWIN_PREFIX[index]) != TOUPPER(topic_resp[index]))
-                    {
-                        search_device_twin = false;
-                    }
-                }
-            }
-            if (search_device_method)
-            {
-                if (index > dev_method_topic_len)
-                {
-                    search_device_method = false;
-                }
-                else
-                {
-                    if (index == dev_method_topic_len)
-                    {
-                        break;
-                    }
-                    else if (TOUPPER(TOPIC_DEVICE_METHOD_PREFIX[index]) != TOUPPER(topic_resp[index]))
-                    {
-                        search_device_method = false;
-                    }
-                }
-            }
+            properties--;
         }
+        topic_info->type = IOTHUB_TYPE_TELEMETRY;
+        topic_info->properties.start = properties;
+        topic_info->properties.length = (size_t)(end - properties);
+        result = 0;
     }
-    if (search_device_twin)
+    return result;
+}
+
+static MQTT_MESSAGE_DETAILS_LIST* allocate_message_details(PMQTTTRANSPORT_HANDLE_DATA transport_data)
+{
+    MQTT_MESSAGE_DETAILS_LIST* result;
+    if (transport_data->messageDetailsPool != NULL)
     {
-        type = IOTHUB_TYPE_DEVICE_TWIN;
+        result = (MQTT_MESSAGE_DETAILS_LIST*)slab_pool_alloc(transport_data->messageDetailsPool);
     }
-    else if (search_device_method)
+    else
+    {
+        result = (MQTT_MESSAGE_DETAILS_LIST*)malloc(sizeof(MQTT_MESSAGE_DETAILS_LIST));
+    }
+    return result;
+}
+
+static void free_message_details(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry)
+{
+    if (transport_data->messageDetailsPool != NULL)
     {
-        type = IOTHUB_TYPE_DEVICE_METHODS;
+        slab_pool_free(transport_data->messageDetailsPool, mqttMsgEntry);
     }
     else
     {
-        type = IOTHUB_TYPE_TELEMETRY;
+        free(mqttMsgEntry);
     }
-    return type;
 }
 
 static void sendMsgComplete(IOTHUB_MESSAGE_LIST* iothubMsgList, PMQTTTRANSPORT_HANDLE_DATA transport_data, IOTHUB_CLIENT_CONFIRMATION_RESULT confirmResult)
@@ -777,36 +970,72 @@ static void sendMsgComplete(IOTHUB_MESSAGE_LIST* iothubMsgList, PMQTTTRANSPORT_H
     IoTHubClient_LL_SendComplete(transport_data->llClientHandle, &messageCompleted, confirmResult);
 }
 
-static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, const char* eventTopic)
+// Renders the event topic followed by the message properties. A message without properties publishes on the event topic
+// itself, otherwise the topic is written into a buffer kept by the transport that is sized exactly for the first topic
+// that does not fit and reused afterwards, so steady traffic builds its topics without touching the heap.
+static const char* render_telemetry_topic(PMQTTTRANSPORT_HANDLE_DATA transport_data, IOTHUB_MESSAGE_HANDLE iothub_message_handle)
 {
-    STRING_HANDLE result = STRING_construct(eventTopic);
+    const char* result = STRING_c_str(transport_data->topic_MqttEvent);
     const char* const* propertyKeys;
     const char* const* propertyValues;
     size_t propertyCount;
 
-    // Construct Properties
     MAP_HANDLE properties_map = IoTHubMessage_Properties(iothub_message_handle);
     if (properties_map != NULL)
     {
         if (Map_GetInternals(properties_map, &propertyKeys, &propertyValues, &propertyCount) != MAP_OK)
         {
             LogError("Failed to get the internals of the property map.");
-            STRING_delete(result);
             result = NULL;
         }
-        else
+        else if (propertyCount != 0)
         {
-            if (propertyCount != 0)
+            size_t index;
+            size_t topicLength = strlen(result);
+            size_t requiredSize = topicLength + (2 * propertyCount); /*one '=' per property, separators between them and the terminator*/
+            for (index = 0; index < propertyCount; index++)
+            {
+                requiredSize += strlen(propertyKeys[index]) + strlen(propertyValues[index]);
+            }
+
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_018: [ The topic of a telemetry message with properties shall be rendered into a buffer owned by the transport that is only reallocated, to the exact size needed, when a topic does not fit. ]*/
+            if (requiredSize > transport_data->telemetryTopicBufferSize)
+            {
+                char* newBuffer = (char*)realloc(transport_data->telemetryTopicBuffer, requiredSize);
+                if (newBuffer == NULL)
+                {
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_019: [ If the buffer cannot be grown the message shall not be published. ]*/
+                    LogError("Failed to allocate %lu bytes for the event topic.", (unsigned long)requiredSize);
+                    result = NULL;
+                }
+                else
+                {
+                    transport_data->telemetryTopicBuffer = newBuffer;
+                    transport_data->telemetryTopicBufferSize = requiredSize;
+                }
+            }
+
+            if (result != NULL)
             {
-                size_t index = 0;
-                for (index = 0; index < propertyCount && result != NULL; index++)
+                char* position = transport_data->telemetryTopicBuffer;
+                (void)memcpy(position, result, topicLength);
+                position += topicLength;
+                for (index = 0; index < propertyCount; index++)
                 {
-                    if (STRING_sprintf(result, "%s=%s%s", propertyKeys[index], propertyValues[index], propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
+                    size_t keyLength = strlen(propertyKeys[index]);
+                    size_t valueLength = strlen(propertyValues[index]);
+                    if (index != 0)
                     {
-                        STRING_delete(result);
-                        result = NULL;
+                        *position++ = PROPERTY_SEPARATOR[0];
                     }
+                    (void)memcpy(position, propertyKeys[index], keyLength);
+                    position += keyLength;
+                    *position++ = '=';
+                    (void)memcpy(position, propertyValues[index], valueLength);
+                    position += valueLength;
                 }
+                *position = '\0';
+                result = transport_data->telemetryTopicBuffer;
             }
         }
     }
@@ -816,14 +1045,14 @@ static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
 static int publish_mqtt_telemetry_msg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, const unsigned char* payload, size_t len)
 {
     int result;
-    STRING_HANDLE msgTopic = addPropertiesTouMqttMessage(mqttMsgEntry->iotHubMessageEntry->messageHandle, STRING_c_str(transport_data->topic_MqttEvent));
+    const char* msgTopic = render_telemetry_topic(transport_data, mqttMsgEntry->iotHubMessageEntry->messageHandle);
     if (msgTopic == NULL)
     {
         result = __FAILURE__;
     }
     else
     {
-        MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create(mqttMsgEntry->packet_id, STRING_c_str(msgTopic), DELIVER_AT_LEAST_ONCE, payload, len);
+        MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create(mqttMsgEntry->packet_id, msgTopic, DELIVER_AT_LEAST_ONCE, payload, len);
         if (mqttMsg == NULL)
         {
             result = __FAILURE__;
@@ -849,17 +1078,16 @@ static int publish_mqtt_telemetry_msg(PMQTTTRANSPORT_HANDLE_DATA transport_data,
             }
             mqttmessage_destroy(mqttMsg);
         }
-        STRING_delete(msgTopic);
     }
     return result;
 }
 
-static int publish_device_method_message(MQTTTRANSPORT_HANDLE_DATA* transport_data, int status_code, STRING_HANDLE request_id, const unsigned char* response, size_t response_size)
+static int publish_device_method_message(MQTTTRANSPORT_HANDLE_DATA* transport_data, int status_code, const char* request_id, const unsigned char* response, size_t response_size)
 {
     int result;
     uint16_t packet_id = get_next_packet_id(transport_data);
 
-    STRING_HANDLE msg_topic = STRING_construct_sprintf(DEVICE_METHOD_RESPONSE_TOPIC, status_code, STRING_c_str(request_id) );
+    STRING_HANDLE msg_topic = STRING_construct_sprintf(DEVICE_METHOD_RESPONSE_TOPIC, status_code, request_id);
     if (msg_topic == NULL)
     {
         LogError("Failed constructing message topic.");
@@ -918,10 +1146,17 @@ static int publish_device_twin_get_message(MQTTTRANSPORT_HANDLE_DATA* transport_
         }
         else
         {
-            MQTT_MESSAGE_HANDLE mqtt_get_msg = mqttmessage_create(mqtt_info->packet_id, STRING_c_str(msg_topic), DELIVER_AT_MOST_ONCE, NULL, 0);
-            if (mqtt_get_msg == NULL)
+            MQTT_MESSAGE_HANDLE mqtt_get_msg;
+            if (packet_id_index_add(&transport_data->ack_waiting_index, mqtt_info->packet_id, mqtt_info) != 0)
+            {
+                LogError("Failed indexing device twin get request.");
+                free(mqtt_info);
+                result = __FAILURE__;
+            }
+            else if ((mqtt_get_msg = mqttmessage_create(mqtt_info->packet_id, STRING_c_str(msg_topic), DELIVER_AT_MOST_ONCE, NULL, 0)) == NULL)
             {
                 LogError("Failed constructing mqtt message.");
+                (void)packet_id_index_remove(&transport_data->ack_waiting_index, mqtt_info->packet_id);
                 free(mqtt_info);
                 result = __FAILURE__;
             }
@@ -930,6 +1165,7 @@ static int publish_device_twin_get_message(MQTTTRANSPORT_HANDLE_DATA* transport_
                 if (mqtt_client_publish(transport_data->mqttClient, mqtt_get_msg) != 0)
                 {
                     LogError("Failed publishing to mqtt client.");
+                    (void)packet_id_index_remove(&transport_data->ack_waiting_index, mqtt_info->packet_id);
                     free(mqtt_info);
                     result = __FAILURE__;
                 }
@@ -957,6 +1193,12 @@ static int publish_device_twin_message(MQTTTRANSPORT_HANDLE_DATA* transport_data
         LogError("Failed constructing reported prop topic.");
         result = __FAILURE__;
     }
+    else if (packet_id_index_add(&transport_data->ack_waiting_index, mqtt_info->packet_id, mqtt_info) != 0)
+    {
+        LogError("Failed indexing reported prop request.");
+        STRING_delete(msgTopic);
+        result = __FAILURE__;
+    }
     else
     {
         const CONSTBUFFER* data_buff = CONSTBUFFER_GetContent(device_twin_info->report_data_handle);
@@ -988,19 +1230,24 @@ static int publish_device_twin_message(MQTTTRANSPORT_HANDLE_DATA* transport_data
             }
             mqttmessage_destroy(mqtt_rpt_msg);
         }
+        if (result != 0)
+        {
+            (void)packet_id_index_remove(&transport_data->ack_waiting_index, mqtt_info->packet_id);
+        }
         STRING_delete(msgTopic);
     }
     return result;
 }
 
-static bool isSystemProperty(const char* tokenData)
+static bool isSystemProperty(const MQTT_TOPIC_SPAN* name)
 {
     bool result = false;
     size_t propCount = sizeof(sysPropList)/sizeof(sysPropList[0]);
     size_t index = 0;
     for (index = 0; index < propCount; index++)
     {
-        if (memcmp(tokenData, sysPropList[index].propName, sysPropList[index].propLength) == 0)
+        if ((name->length >= sysPropList[index].propLength) &&
+            (memcmp(name->start, sysPropList[index].propName, sysPropList[index].propLength) == 0))
         {
             result = true;
             break;
@@ -1009,154 +1256,178 @@ static bool isSystemProperty(const char* tokenData)
     return result;
 }
 
-static int extractMqttProperties(IOTHUB_MESSAGE_HANDLE IoTHubMessage, const char* topic_name)
+/*reads the name=value pair that starts at position, returns where the next pair starts; value->start is NULL when the pair has no '='*/
+static const char* read_topic_property(const char* position, const char* end, MQTT_TOPIC_SPAN* name, MQTT_TOPIC_SPAN* value)
 {
-    int result;
-    STRING_HANDLE mqttTopic = STRING_construct(topic_name);
-    if (mqttTopic == NULL)
+    const char* result = position;
+    name->start = position;
+    value->start = NULL;
+    value->length = 0;
+    while ((result < end) && (*result != '&'))
     {
-        LogError("Failure constructing string topic name.");
-        result = __FAILURE__;
+        if ((*result == '=') && (value->start == NULL))
+        {
+            value->start = result + 1;
+        }
+        result++;
+    }
+
+    if (value->start == NULL)
+    {
+        name->length = (size_t)(result - position);
     }
     else
     {
-        STRING_TOKENIZER_HANDLE token = STRING_TOKENIZER_create(mqttTopic);
-        if (token != NULL)
+        name->length = (size_t)(value->start - 1 - position);
+        value->length = (size_t)(result - value->start);
+    }
+
+    if (result < end)
+    {
+        result++;
+    }
+    return result;
+}
+
+static int setSystemProperty(IOTHUB_MESSAGE_HANDLE IoTHubMessage, const MQTT_TOPIC_SPAN* name, const MQTT_TOPIC_SPAN* value)
+{
+    int result = 0;
+    if ((value->start != NULL) && (name->length > 3))
+    {
+        const char* suffix = name->start + name->length - 3;
+        bool is_message_id = (memcmp(suffix, MESSAGE_ID_PROPERTY, 3) == 0);
+        if (is_message_id || (memcmp(suffix, CORRELATION_ID_PROPERTY, 3) == 0))
         {
-            MAP_HANDLE propertyMap = IoTHubMessage_Properties(IoTHubMessage);
-            if (propertyMap == NULL)
+            char buffer[TOPIC_FIELD_STACK_SIZE];
+            char* propValue = topic_span_to_string(value, buffer, sizeof(buffer));
+            if (propValue == NULL)
             {
-                LogError("Failure to retrieve IoTHubMessage_properties.");
                 result = __FAILURE__;
             }
             else
             {
-                STRING_HANDLE output = STRING_new();
-                if (output == NULL)
+                if (is_message_id)
                 {
-                    LogError("Failure to allocate STRING_new.");
+                    if (IoTHubMessage_SetMessageId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
+                    {
+                        LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'messageId' property.");
+                        result = __FAILURE__;
+                    }
+                }
+                else if (IoTHubMessage_SetCorrelationId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
+                {
+                    LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'correlationId' property.");
                     result = __FAILURE__;
                 }
-                else
+
+                if (propValue != buffer)
                 {
-                    result = 0;
+                    free(propValue);
+                }
+            }
+        }
+    }
+    return result;
+}
 
-                    while (STRING_TOKENIZER_get_next_token(token, output, PROPERTY_SEPARATOR) == 0 && result == 0)
-                    {
-                        const char* tokenData = STRING_c_str(output);
-                        size_t tokenLen = strlen(tokenData);
-                        if (tokenData == NULL || tokenLen == 0)
-                        {
-                            break;
-                        }
-                        else
-                        {
-                            if (isSystemProperty(tokenData))
-                            {
-                                const char* iterator = tokenData;
-                                while (iterator != NULL && *iterator != '\0' && result == 0)
-                                {
-                                    if (*iterator == '=')
-                                    {
-                                        size_t nameLen = iterator - tokenData;
-                                        char* propName = malloc(nameLen + 1);
-
-                                        size_t valLen = tokenLen - (nameLen + 1) + 1;
-                                        char* propValue = malloc(valLen + 1);
-
-                                        if (propName == NULL || propValue == NULL)
-                                        {
-                                            result = __FAILURE__;
-                                        }
-                                        else
-                                        {
-                                            strncpy(propName, tokenData, nameLen);
-                                            propName[nameLen] = '\0';
-
-                                            strncpy(propValue, iterator + 1, valLen);
-                                            propValue[valLen] = '\0';
-
-                                            if (nameLen > 3)
-                                            {
-                                                if (strcmp((const char*)&propName[nameLen - 3], MESSAGE_ID_PROPERTY) == 0)
-                                                {
-                                                    if (IoTHubMessage_SetMessageId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                    {
-                                                        LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'messageId' property.");
-                                                        result = __FAILURE__;
-                                                    }
-                                                }
-
-                                                if (strcmp((const char*)&propName[nameLen - 3], CORRELATION_ID_PROPERTY) == 0)
-                                                {
-                                                    if (IoTHubMessage_SetCorrelationId(IoTHubMessage, propValue) != IOTHUB_MESSAGE_OK)
-                                                    {
-                                                        LogError("Failed to set IOTHUB_MESSAGE_HANDLE 'correlationId' property.");
-                                                        result = __FAILURE__;
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        free(propName);
-                                        free(propValue);
-
-                                        break;
-                                    }
-                                    iterator++;
-                                }
-                            }
-                            else
-                            {
-                                const char* iterator = tokenData;
-                                while (iterator != NULL && *iterator != '\0' && result == 0)
-                                {
-                                    if (*iterator == '=')
-                                    {
-                                        size_t nameLen = iterator - tokenData;
-                                        char* propName = malloc(nameLen + 1);
-
-                                        size_t valLen = tokenLen - (nameLen + 1) + 1;
-                                        char* propValue = malloc(valLen + 1);
-
-                                        if (propName == NULL || propValue == NULL)
-                                        {
-                                            result = __FAILURE__;
-                                        }
-                                        else
-                                        {
-                                            strncpy(propName, tokenData, nameLen);
-                                            propName[nameLen] = '\0';
-
-                                            strncpy(propValue, iterator + 1, valLen);
-                                            propValue[valLen] = '\0';
-
-                                            if (Map_AddOrUpdate(propertyMap, propName, propValue) != MAP_OK)
-                                            {
-                                                LogError("Map_AddOrUpdate failed.");
-                                                result = __FAILURE__;
-                                            }
-                                        }
-                                        free(propName);
-                                        free(propValue);
-
-                                        break;
-                                    }
-                                    iterator++;
-                                }
-                            }
-                        }
-                    }
-                    STRING_delete(output);
+/*system properties sit between application properties, the application ones are copied next to each other first*/
+static int setInterleavedAppProperties(IOTHUB_MESSAGE_HANDLE IoTHubMessage, const MQTT_TOPIC_SPAN* properties)
+{
+    int result;
+    char* appProperties = (char*)malloc(properties->length);
+    if (appProperties == NULL)
+    {
+        LogError("Failure allocating application properties.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t appLength = 0;
+        const char* position = properties->start;
+        const char* end = properties->start + properties->length;
+        while (position < end)
+        {
+            MQTT_TOPIC_SPAN name;
+            MQTT_TOPIC_SPAN value;
+            const char* next = read_topic_property(position, end, &name, &value);
+            if ((value.start != NULL) && !isSystemProperty(&name))
+            {
+                size_t pairLength = (size_t)((value.start + value.length) - name.start);
+                if (appLength != 0)
+                {
+                    appProperties[appLength++] = '&';
                 }
+                (void)memcpy(appProperties + appLength, name.start, pairLength);
+                appLength += pairLength;
             }
-            STRING_TOKENIZER_destroy(token);
+            position = next;
+        }
+
+        if (IoTHubMessage_SetDeferredProperties(IoTHubMessage, appProperties, appLength) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("Failure setting the message properties.");
+            result = __FAILURE__;
         }
         else
         {
-            LogError("Unable to create Tokenizer object.");
+            result = 0;
+        }
+        free(appProperties);
+    }
+    return result;
+}
+
+static int extractMqttProperties(IOTHUB_MESSAGE_HANDLE IoTHubMessage, const MQTT_TOPIC_SPAN* properties)
+{
+    int result = 0;
+    const char* position = properties->start;
+    const char* end = properties->start + properties->length;
+    const char* appStart = NULL;
+    const char* appEnd = NULL;
+    bool systemAfterApp = false;
+    bool appInterleaved = false;
+
+    while ((position < end) && (result == 0))
+    {
+        MQTT_TOPIC_SPAN name;
+        MQTT_TOPIC_SPAN value;
+        const char* next = read_topic_property(position, end, &name, &value);
+        if (isSystemProperty(&name))
+        {
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_010: [ System properties ending in mid or cid shall be set on the message with IoTHubMessage_SetMessageId and IoTHubMessage_SetCorrelationId. ] */
+            if (appStart != NULL)
+            {
+                systemAfterApp = true;
+            }
+            result = setSystemProperty(IoTHubMessage, &name, &value);
+        }
+        else if (value.start != NULL)
+        {
+            if (appStart == NULL)
+            {
+                appStart = name.start;
+            }
+            else if (systemAfterApp)
+            {
+                appInterleaved = true;
+            }
+            appEnd = value.start + value.length;
+        }
+        position = next;
+    }
+
+    if ((result == 0) && (appStart != NULL))
+    {
+        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_011: [ Application properties shall be handed to the message with IoTHubMessage_SetDeferredProperties so that the properties map is only built when the application reads it. ] */
+        if (appInterleaved)
+        {
+            result = setInterleavedAppProperties(IoTHubMessage, properties);
+        }
+        else if (IoTHubMessage_SetDeferredProperties(IoTHubMessage, appStart, (size_t)(appEnd - appStart)) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("Failure setting the message properties.");
             result = __FAILURE__;
         }
-        STRING_delete(mqttTopic);
     }
     return result;
 }
@@ -1168,101 +1439,85 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
     {
         /* Tests_SRS_IOTHUB_MQTT_TRANSPORT_07_052: [ mqtt_notification_callback shall extract the topic Name from the MQTT_MESSAGE_HANDLE. ] */
         const char* topic_resp = mqttmessage_getTopicName(msgHandle);
+        MQTT_TOPIC_INFO topic_info;
         if (topic_resp == NULL)
         {
             LogError("Failure: NULL topic name encountered");
         }
+        else if (parse_mqtt_topic(topic_resp, strlen(topic_resp), &topic_info) != 0)
+        {
+            LogError("Failure: parsing topic info");
+        }
         else
         {
             PMQTTTRANSPORT_HANDLE_DATA transportData = (PMQTTTRANSPORT_HANDLE_DATA)callbackCtx;
 
-            IOTHUB_IDENTITY_TYPE type = retrieve_topic_type(topic_resp);
-            if (type == IOTHUB_TYPE_DEVICE_TWIN)
+            if (topic_info.type == IOTHUB_TYPE_DEVICE_TWIN)
             {
-                size_t request_id;
-                int status_code;
-                bool notification_msg;
-                if (parse_device_twin_topic_info(topic_resp, &notification_msg, &request_id, &status_code) != 0)
+                const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
+                if (topic_info.patch_msg)
                 {
-                    LogError("Failure: parsing device topic info");
+                    IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_PARTIAL, payload->message, payload->length);
                 }
                 else
                 {
-                    const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
-                    if (notification_msg)
-                    {
-                        IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_PARTIAL, payload->message, payload->length);
-                    }
-                    else
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_013: [ Device twin responses and PUBACKs shall be matched to the request waiting for them through a table keyed by packet id instead of a walk of the waiting list. ] */
+                    MQTT_DEVICE_TWIN_ITEM* msg_entry = (topic_info.request_id > USHRT_MAX) ? NULL :
+                        (MQTT_DEVICE_TWIN_ITEM*)packet_id_index_remove(&transportData->ack_waiting_index, (uint16_t)topic_info.request_id);
+                    if (msg_entry != NULL)
                     {
-                        PDLIST_ENTRY dev_twin_item = transportData->ack_waiting_queue.Flink;
-                        while (dev_twin_item != &transportData->ack_waiting_queue)
+                        (void)DList_RemoveEntryList(&msg_entry->entry);
+                        if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
                         {
-                            DLIST_ENTRY saveListEntry;
-                            saveListEntry.Flink = dev_twin_item->Flink;
-                            MQTT_DEVICE_TWIN_ITEM* msg_entry = containingRecord(dev_twin_item, MQTT_DEVICE_TWIN_ITEM, entry);
-                            if (request_id == msg_entry->packet_id)
-                            {
-                                (void)DList_RemoveEntryList(dev_twin_item);
-                                if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
-                                {
-                                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_054: [ If type is IOTHUB_TYPE_DEVICE_TWIN, then on success if msg_type is RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_RetrievePropertyComplete... ] */
-                                    IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_COMPLETE, payload->message, payload->length);
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_055: [ if device_twin_msg_type is not RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_ReportedStateComplete ] */
-                                    IoTHubClient_LL_ReportedStateComplete(transportData->llClientHandle, msg_entry->iothub_msg_id, status_code);
-                                }
-                                free(msg_entry);
-                                break;
-                            }
-                            dev_twin_item = saveListEntry.Flink;
+                            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_054: [ If type is IOTHUB_TYPE_DEVICE_TWIN, then on success if msg_type is RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_RetrievePropertyComplete... ] */
+                            IoTHubClient_LL_RetrievePropertyComplete(transportData->llClientHandle, DEVICE_TWIN_UPDATE_COMPLETE, payload->message, payload->length);
+                        }
+                        else
+                        {
+                            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_055: [ if device_twin_msg_type is not RETRIEVE_PROPERTIES then mqtt_notification_callback shall call IoTHubClient_LL_ReportedStateComplete ] */
+                            IoTHubClient_LL_ReportedStateComplete(transportData->llClientHandle, msg_entry->iothub_msg_id, topic_info.status_code);
                         }
+                        free(msg_entry);
                     }
                 }
             }
-            else if (type == IOTHUB_TYPE_DEVICE_METHODS)
+            else if (topic_info.type == IOTHUB_TYPE_DEVICE_METHODS)
             {
-                STRING_HANDLE method_name = STRING_new();
-                if (method_name == NULL)
+                /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_012: [ The request id of a device method shall be kept in the same allocation as its DEVICE_METHOD_INFO. ] */
+                DEVICE_METHOD_INFO* dev_method_info = (DEVICE_METHOD_INFO*)malloc(sizeof(DEVICE_METHOD_INFO) + topic_info.method_request_id.length + 1);
+                if (dev_method_info == NULL)
                 {
-                    LogError("Failure: allocating method_name string value");
+                    LogError("Failure: allocating DEVICE_METHOD_INFO object");
                 }
                 else
                 {
-                    DEVICE_METHOD_INFO* dev_method_info = malloc(sizeof(DEVICE_METHOD_INFO) );
-                    if (dev_method_info == NULL)
+                    char method_name_buffer[TOPIC_FIELD_STACK_SIZE];
+                    char* method_name;
+
+                    dev_method_info->request_id = (char*)(dev_method_info + 1);
+                    (void)memcpy(dev_method_info->request_id, topic_info.method_request_id.start, topic_info.method_request_id.length);
+                    dev_method_info->request_id[topic_info.method_request_id.length] = '\0';
+
+                    if ((method_name = topic_span_to_string(&topic_info.method_name, method_name_buffer, sizeof(method_name_buffer))) == NULL)
                     {
-                        LogError("Failure: allocating DEVICE_METHOD_INFO object");
+                        LogError("Failure: copying the method name");
+                        free(dev_method_info);
                     }
                     else
                     {
-                        dev_method_info->request_id = STRING_new();
-                        if (dev_method_info->request_id == NULL)
+                        /* CodesSRS_IOTHUB_MQTT_TRANSPORT_07_053: [ If type is IOTHUB_TYPE_DEVICE_METHODS, then on success mqtt_notification_callback shall call IoTHubClient_LL_DeviceMethodComplete. ] */
+                        const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
+                        if (IoTHubClient_LL_DeviceMethodComplete(transportData->llClientHandle, method_name, payload->message, payload->length, (void*)dev_method_info) != 0)
                         {
-                            LogError("Failure constructing request_id string");
+                            LogError("Failure: IoTHubClient_LL_DeviceMethodComplete");
                             free(dev_method_info);
                         }
-                        else if (retrieve_device_method_rid_info(topic_resp, method_name, dev_method_info->request_id) != 0)
+
+                        if (method_name != method_name_buffer)
                         {
-                            LogError("Failure: retrieve device topic info");
-                            STRING_delete(dev_method_info->request_id);
-                            free(dev_method_info);
-                        }
-                        else
-                        {
-                            /* CodesSRS_IOTHUB_MQTT_TRANSPORT_07_053: [ If type is IOTHUB_TYPE_DEVICE_METHODS, then on success mqtt_notification_callback shall call IoTHubClient_LL_DeviceMethodComplete. ] */
-                            const APP_PAYLOAD* payload = mqttmessage_getApplicationMsg(msgHandle);
-                            if (IoTHubClient_LL_DeviceMethodComplete(transportData->llClientHandle, STRING_c_str(method_name), payload->message, payload->length, (void*)dev_method_info) != 0)
-                            {
-                                LogError("Failure: IoTHubClient_LL_DeviceMethodComplete");
-                                STRING_delete(dev_method_info->request_id);
-                                free(dev_method_info);
-                            }
+                            free(method_name);
                         }
                     }
-                    STRING_delete(method_name);
                 }
             }
             else
@@ -1276,9 +1531,10 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
                 else
                 {
                     // Will need to update this when the service has messages that can be rejected
-                    if (extractMqttProperties(IoTHubMessage, topic_resp) != 0)
+                    if (extractMqttProperties(IoTHubMessage, &topic_info.properties) != 0)
                     {
                         LogError("failure extracting mqtt properties.");
+                        IoTHubMessage_Destroy(IoTHubMessage);
                     }
                     else
                     {
@@ -1286,6 +1542,7 @@ static void mqtt_notification_callback(MQTT_MESSAGE_HANDLE msgHandle, void* call
                         if (messageData == NULL)
                         {
                             LogError("malloc failed");
+                            IoTHubMessage_Destroy(IoTHubMessage);
                         }
                         else
                         {
@@ -1323,20 +1580,14 @@ static void mqtt_operation_complete_callback(MQTT_CLIENT_HANDLE handle, MQTT_CLI
                 const PUBLISH_ACK* puback = (const PUBLISH_ACK*)msgInfo;
                 if (puback != NULL)
                 {
-                    PDLIST_ENTRY currentListEntry = transport_data->telemetry_waitingForAck.Flink;
-                    while (currentListEntry != &transport_data->telemetry_waitingForAck)
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_013: [ Device twin responses and PUBACKs shall be matched to the request waiting for them through a table keyed by packet id instead of a walk of the waiting list. ] */
+                    MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = (MQTT_MESSAGE_DETAILS_LIST*)packet_id_index_remove(&transport_data->telemetry_waitingForAck_index, puback->packetId);
+                    if (mqttMsgEntry != NULL)
                     {
-                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
-                        DLIST_ENTRY saveListEntry;
-                        saveListEntry.Flink = currentListEntry->Flink;
-
-                        if (puback->packetId == mqttMsgEntry->packet_id)
-                        {
-                            (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
-                            sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
-                            free(mqttMsgEntry);
-                        }
-                        currentListEntry = saveListEntry.Flink;
+                        (void)DList_RemoveEntryList(&mqttMsgEntry->entry); //First remove the item from Waiting for Ack List.
+                        transport_data->telemetry_inFlightCount--;
+                        sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
+                        free_message_details(transport_data, mqttMsgEntry);
                     }
                 }
                 else
@@ -1935,6 +2186,8 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                     /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_010: [IoTHubTransport_MQTT_Common_Create shall allocate memory to save its internal state where all topics, hostname, device_id, device_key, sasTokenSr and client handle shall be saved.] */
                     DList_InitializeListHead(&(state->telemetry_waitingForAck));
                     DList_InitializeListHead(&(state->ack_waiting_queue));
+                    packet_id_index_init(&(state->telemetry_waitingForAck_index));
+                    packet_id_index_init(&(state->ack_waiting_index));
                     state->isDestroyCalled = false;
                     state->isRegistered = false;
                     state->isConnected = false;
@@ -1956,6 +2209,12 @@ static PMQTTTRANSPORT_HANDLE_DATA InitializeTransportHandleData(const IOTHUB_CLI
                     state->topic_DeviceMethods = NULL;
                     state->log_trace = state->raw_trace = false;
                     state->retryLogic = NULL;
+                    state->telemetry_inFlightCount = 0;
+                    state->maxInFlightMessages = DEFAULT_MAX_IN_FLIGHT_MESSAGES;
+                    state->maxPublishPerDoWork = DEFAULT_MAX_PUBLISH_PER_DOWORK;
+                    state->messageDetailsPool = NULL;
+                    state->telemetryTopicBuffer = NULL;
+                    state->telemetryTopicBufferSize = 0;
                     srand((unsigned int)get_time(NULL));
                 }
             }
@@ -2057,8 +2316,9 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
         {
             PDLIST_ENTRY currentEntry = DList_RemoveHeadList(&transport_data->telemetry_waitingForAck);
             MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+            transport_data->telemetry_inFlightCount--;
             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
-            free(mqttMsgEntry);
+            free_message_details(transport_data, mqttMsgEntry);
         }
         while (!DList_IsListEmpty(&transport_data->ack_waiting_queue))
         {
@@ -2067,6 +2327,16 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
             IoTHubClient_LL_ReportedStateComplete(transport_data->llClientHandle, mqtt_device_twin->iothub_msg_id, STATUS_CODE_TIMEOUT_VALUE);
             free(mqtt_device_twin);
         }
+        packet_id_index_deinit(&transport_data->telemetry_waitingForAck_index);
+        packet_id_index_deinit(&transport_data->ack_waiting_index);
+        if (transport_data->messageDetailsPool != NULL)
+        {
+            slab_pool_destroy(transport_data->messageDetailsPool);
+        }
+        if (transport_data->telemetryTopicBuffer != NULL)
+        {
+            free(transport_data->telemetryTopicBuffer);
+        }
 
         switch (transport_data->transport_creds.credential_type)
         {
@@ -2297,7 +2567,6 @@ int IoTHubTransport_MQTT_Common_DeviceMethod_Response(IOTHUB_DEVICE_HANDLE handl
             {
                 result = 0;
             }
-            STRING_delete(dev_method_info->request_id);
             free(dev_method_info);
         }
     }
@@ -2471,23 +2740,38 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
             else if (transport_data->currPacketState == PUBLISH_TYPE)
             {
                 PDLIST_ENTRY currentListEntry = transport_data->telemetry_waitingForAck.Flink;
-                while (currentListEntry != &transport_data->telemetry_waitingForAck)
+                tickcounter_ms_t current_ms;
+                if (currentListEntry == &transport_data->telemetry_waitingForAck)
                 {
-                    MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
-                    DLIST_ENTRY nextListEntry;
-                    nextListEntry.Flink = currentListEntry->Flink;
-
-                    tickcounter_ms_t current_ms;
-                    (void)tickcounter_get_current_ms(transport_data->msgTickCounter, &current_ms);
-                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_033: [IoTHubTransport_MQTT_Common_DoWork shall iterate through the Waiting Acknowledge messages looking for any message that has been waiting longer than 2 min.]*/
-                    if (((current_ms - mqttMsgEntry->msgPublishTime) / 1000) > RESEND_TIMEOUT_VALUE_MIN)
+                    /* Nothing is waiting for a PUBACK, so there is nothing to time out */
+                }
+                else if (tickcounter_get_current_ms(transport_data->msgTickCounter, &current_ms) != 0)
+                {
+                    LogError("Failed retrieving tickcounter info, resend timeouts will not be processed");
+                }
+                else
+                {
+                    while (currentListEntry != &transport_data->telemetry_waitingForAck)
                     {
+                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentListEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
+                        DLIST_ENTRY nextListEntry;
+                        nextListEntry.Flink = currentListEntry->Flink;
+
+                        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_033: [IoTHubTransport_MQTT_Common_DoWork shall iterate through the Waiting Acknowledge messages looking for any message that has been waiting longer than 2 min.]*/
+                        if (((current_ms - mqttMsgEntry->msgPublishTime) / 1000) <= RESEND_TIMEOUT_VALUE_MIN)
+                        {
+                            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_005: [ Since the Waiting Acknowledge list is kept ordered by publish time, IoTHubTransport_MQTT_Common_DoWork shall stop iterating it at the first message that has not been waiting longer than 2 min. ]*/
+                            break;
+                        }
+
                         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_034: [If IoTHubTransport_MQTT_Common_DoWork has resent the message two times then it shall fail the message] */
                         if (mqttMsgEntry->retryCount >= MAX_SEND_RECOUNT_LIMIT)
                         {
+                            (void)packet_id_index_remove(&transport_data->telemetry_waitingForAck_index, mqttMsgEntry->packet_id);
                             (void)DList_RemoveEntryList(currentListEntry);
+                            transport_data->telemetry_inFlightCount--;
                             sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
-                            free(mqttMsgEntry);
+                            free_message_details(transport_data, mqttMsgEntry);
                         }
                         else
                         {
@@ -2501,20 +2785,40 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                             {
                                 if (publish_mqtt_telemetry_msg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
                                 {
+                                    (void)packet_id_index_remove(&transport_data->telemetry_waitingForAck_index, mqttMsgEntry->packet_id);
                                     (void)DList_RemoveEntryList(currentListEntry);
+                                    transport_data->telemetry_inFlightCount--;
                                     sendMsgComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                                    free(mqttMsgEntry);
+                                    free_message_details(transport_data, mqttMsgEntry);
+                                }
+                                else
+                                {
+                                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_006: [ A message that has been resent shall be moved to the end of the Waiting Acknowledge list. ]*/
+                                    (void)DList_RemoveEntryList(currentListEntry);
+                                    DList_InsertTailList(&(transport_data->telemetry_waitingForAck), currentListEntry);
                                 }
                             }
                         }
+                        currentListEntry = nextListEntry.Flink;
                     }
-                    currentListEntry = nextListEntry.Flink;
                 }
 
+                size_t publishedCount = 0;
                 currentListEntry = transport_data->waitingToSend->Flink;
                 /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_027: [IoTHubTransport_MQTT_Common_DoWork shall inspect the "waitingToSend" DLIST passed in config structure.] */
                 while (currentListEntry != transport_data->waitingToSend)
                 {
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_003: [ IoTHubTransport_MQTT_Common_DoWork shall stop publishing messages from waitingToSend when the number of telemetry messages waiting for PUBACK reaches the "max_in_flight_messages" value, unless that value is 0. ]*/
+                    if (transport_data->maxInFlightMessages != 0 && transport_data->telemetry_inFlightCount >= transport_data->maxInFlightMessages)
+                    {
+                        break;
+                    }
+                    /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_004: [ IoTHubTransport_MQTT_Common_DoWork shall publish at most "max_publish_per_dowork" messages from waitingToSend in one call, unless that value is 0. ]*/
+                    if (transport_data->maxPublishPerDoWork != 0 && publishedCount >= transport_data->maxPublishPerDoWork)
+                    {
+                        break;
+                    }
+
                     IOTHUB_MESSAGE_LIST* iothubMsgList = containingRecord(currentListEntry, IOTHUB_MESSAGE_LIST, entry);
                     DLIST_ENTRY savedFromCurrentListEntry;
                     savedFromCurrentListEntry.Flink = currentListEntry->Flink;
@@ -2529,7 +2833,8 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                     else
                     {
                         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_029: [IoTHubTransport_MQTT_Common_DoWork shall create a MQTT_MESSAGE_HANDLE and pass this to a call to mqtt_client_publish.] */
-                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = (MQTT_MESSAGE_DETAILS_LIST*)malloc(sizeof(MQTT_MESSAGE_DETAILS_LIST));
+                        /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_016: [ When a message pool was set with "message_pool_size", the record tracking a telemetry message until its PUBACK shall be taken from the pool and go back to it once the message is completed. ]*/
+                        MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = allocate_message_details(transport_data);
                         if (mqttMsgEntry == NULL)
                         {
                             LogError("Allocation Error: Failure allocating MQTT Message Detail List.");
@@ -2539,16 +2844,26 @@ void IoTHubTransport_MQTT_Common_DoWork(TRANSPORT_LL_HANDLE handle, IOTHUB_CLIEN
                             mqttMsgEntry->retryCount = 0;
                             mqttMsgEntry->iotHubMessageEntry = iothubMsgList;
                             mqttMsgEntry->packet_id = get_next_packet_id(transport_data);
-                            if (publish_mqtt_telemetry_msg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
+                            publishedCount++;
+                            if (packet_id_index_add(&transport_data->telemetry_waitingForAck_index, mqttMsgEntry->packet_id, mqttMsgEntry) != 0)
                             {
+                                LogError("Failure indexing MQTT Message Detail List.");
                                 (void)(DList_RemoveEntryList(currentListEntry));
                                 sendMsgComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                                free(mqttMsgEntry);
+                                free_message_details(transport_data, mqttMsgEntry);
+                            }
+                            else if (publish_mqtt_telemetry_msg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
+                            {
+                                (void)packet_id_index_remove(&transport_data->telemetry_waitingForAck_index, mqttMsgEntry->packet_id);
+                                (void)(DList_RemoveEntryList(currentListEntry));
+                                sendMsgComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+                                free_message_details(transport_data, mqttMsgEntry);
                             }
                             else
                             {
                                 (void)(DList_RemoveEntryList(currentListEntry));
                                 DList_InsertTailList(&(transport_data->telemetry_waitingForAck), &(mqttMsgEntry->entry));
+                                transport_data->telemetry_inFlightCount++;
                             }
                         }
                     }
@@ -2634,6 +2949,45 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE h
             }
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(OPTION_MAX_IN_FLIGHT_MESSAGES, option) == 0)
+        {
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_001: [ If the option parameter is set to "max_in_flight_messages" then the value shall be an unsigned int_ptr and the value will limit the number of telemetry messages waiting for PUBACK. A value of 0 removes the limit. ]*/
+            transport_data->maxInFlightMessages = *((const unsigned int*)value);
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(OPTION_MAX_PUBLISH_PER_DOWORK, option) == 0)
+        {
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_002: [ If the option parameter is set to "max_publish_per_dowork" then the value shall be an unsigned int_ptr and the value will limit the number of telemetry messages published by one call to IoTHubTransport_MQTT_Common_DoWork. A value of 0 removes the limit. ]*/
+            transport_data->maxPublishPerDoWork = *((const unsigned int*)value);
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(OPTION_MESSAGE_POOL_SIZE, option) == 0)
+        {
+            SLAB_POOL_HANDLE messageDetailsPool = NULL;
+
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_015: [ If the option parameter is set to "message_pool_size" then the value shall be an unsigned int*, IoTHubTransport_MQTT_Common_SetOption shall replace the pool of the records tracking telemetry messages with one of that many records. A value of 0 removes the pool. ]*/
+            /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_01_017: [ If telemetry messages are waiting for PUBACK or the pool cannot be created, IoTHubTransport_MQTT_Common_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current pool. ]*/
+            if (!DList_IsListEmpty(&transport_data->telemetry_waitingForAck))
+            {
+                LogError("the message pool cannot be changed while messages are waiting for PUBACK");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if ((*((const unsigned int*)value) != 0) &&
+                ((messageDetailsPool = slab_pool_create(sizeof(MQTT_MESSAGE_DETAILS_LIST), *((const unsigned int*)value))) == NULL))
+            {
+                LogError("unable to create a message pool of %lu records", (unsigned long)*((const unsigned int*)value));
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (transport_data->messageDetailsPool != NULL)
+                {
+                    slab_pool_destroy(transport_data->messageDetailsPool);
+                }
+                transport_data->messageDetailsPool = messageDetailsPool;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         /* Codes_SRS_IOTHUB_MQTT_TRANSPORT_07_039: [If the option parameter is set to "x509certificate" then the value shall be a const char of the certificate to be used for x509.] */
         else if ((strcmp(OPTION_X509_CERT, option) == 0) && (transport_data->transport_creds.credential_type != X509))
         {
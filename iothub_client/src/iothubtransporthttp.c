@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <time.h>
@@ -18,7 +19,6 @@
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
 #include "azure_c_shared_utility/strings.h"
-#include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 #include "azure_c_shared_utility/httpheaders.h"
@@ -40,9 +40,6 @@ const char* IOTHUB_CORRELATION_ID = "iothub-correlationid";
 #define MAXIMUM_PAYLOAD_OVERHEAD 384
 #define MAXIMUM_PROPERTY_OVERHEAD 16
 
-/*forward declaration*/
-static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count);
-
 typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
 {
     STRING_HANDLE hostName;
@@ -961,232 +958,280 @@ static int IoTHubTransportHttp_DeviceMethod_Response(IOTHUB_DEVICE_HANDLE handle
     return __FAILURE__;
 }
 
-/*produces a representation of the properties, if they exist*/
-/*if they do not exist, produces ""*/
-static int concat_Properties(STRING_HANDLE existing, MAP_HANDLE map, size_t* propertiesMessageSizeContribution)
+#define BATCH_BYTEARRAY_BODY_BEGIN "{\"body\":\""
+#define BATCH_BYTEARRAY_BODY_END "\""
+#define BATCH_STRING_BODY_BEGIN "{\"body\":"
+#define BATCH_STRING_BODY_END ",\"base64Encoded\":false"
+#define BATCH_PROPERTIES_BEGIN ",\"properties\":{"
+#define BATCH_PROPERTY_NAME_BEGIN "\"" IOTHUB_APP_PREFIX
+#define BATCH_PROPERTY_NAME_END "\":\""
+#define BATCH_PROPERTY_VALUE_END "\""
+#define BATCH_PROPERTIES_END "}"
+#define BATCH_ITEM_END "}," /*the last comma shall be replaced by a ']' by DaCr's suggestion (which is awesome enough to receive credits in the source code)*/
+
+#define LITERAL_LENGTH(literal) (sizeof(literal) - 1)
+
+static const char base64Characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char hexCharacters[] = "0123456789ABCDEF";
+
+/*everything needed to measure and then serialize 1 item of a batch, as obtained from the IoTHubMessage*/
+typedef struct BATCH_ITEM_TAG
 {
-    int result;
+    IOTHUBMESSAGE_CONTENT_TYPE contentType;
+    const unsigned char* source; /*content of an IOTHUBMESSAGE_BYTEARRAY message*/
+    size_t size;
+    const char* string; /*content of an IOTHUBMESSAGE_STRING message*/
     const char*const* keys;
     const char*const* values;
     size_t count;
-    if (Map_GetInternals(map, &keys, &values, &count) != MAP_OK)
+} BATCH_ITEM;
+
+static size_t getBase64EncodedLength(size_t size)
+{
+    return 4 * ((size + 2) / 3);
+}
+
+/*writes the base64 encoding of source at destination, returns the first byte after it*/
+static unsigned char* writeBase64(unsigned char* destination, const unsigned char* source, size_t size)
+{
+    size_t i;
+    for (i = 0; i + 2 < size; i += 3)
     {
-        result = __FAILURE__;
-        LogError("error while Map_GetInternals");
+        *destination++ = base64Characters[source[i] >> 2];
+        *destination++ = base64Characters[((source[i] & 0x03) << 4) | (source[i + 1] >> 4)];
+        *destination++ = base64Characters[((source[i + 1] & 0x0F) << 2) | (source[i + 2] >> 6)];
+        *destination++ = base64Characters[source[i + 2] & 0x3F];
+    }
+
+    if (size - i == 1)
+    {
+        *destination++ = base64Characters[source[i] >> 2];
+        *destination++ = base64Characters[(source[i] & 0x03) << 4];
+        *destination++ = '=';
+        *destination++ = '=';
+    }
+    else if (size - i == 2)
+    {
+        *destination++ = base64Characters[source[i] >> 2];
+        *destination++ = base64Characters[((source[i] & 0x03) << 4) | (source[i + 1] >> 4)];
+        *destination++ = base64Characters[(source[i + 1] & 0x0F) << 2];
+        *destination++ = '=';
     }
     else
     {
+        /*no padding needed*/
+    }
+    return destination;
+}
 
-        if (count == 0)
+/*computes the length of the JSON representation of source (quotes included) using the same escaping as STRING_new_JSON*/
+static int getJSONStringLength(const char* source, size_t* length)
+{
+    int result;
+    size_t i;
+    *length = 2; /*the opening and closing quotes*/
+    for (i = 0; source[i] != '\0'; i++)
+    {
+        unsigned char c = (unsigned char)source[i];
+        if (c >= 128)
         {
-            /*Codes_SRS_TRANSPORTMULTITHTTP_17_064: [If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload*/
-            /*no properties - do nothing with existing*/
-            result = 0;
-            *propertiesMessageSizeContribution = 0;
+            break;
+        }
+        else if (c <= 0x1F)
+        {
+            *length += 6; /*\u00xx*/
+        }
+        else if ((c == '"') || (c == '\\') || (c == '/'))
+        {
+            *length += 2;
         }
         else
         {
-            /*Codes_SRS_TRANSPORTMULTITHTTP_17_058: [If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2*/
-            if (STRING_concat(existing, ",\"properties\":") != 0)
-            {
-                /*go ahead and return it*/
-                result = __FAILURE__;
-                LogError("failed STRING_concat");
-            }
-            else if (appendMapToJSON(existing, keys, values, count) != 0)
-            {
-                result = __FAILURE__;
-                LogError("unable to append the properties");
-            }
-            else
-            {
-                /*all is fine*/
-                size_t i;
-                *propertiesMessageSizeContribution = 0;
-                for (i = 0;i < count;i++)
-                {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_063: [Every property name shall add to the message size the length of the property name + the length of the property value + 16 bytes.] */
-                    *propertiesMessageSizeContribution += (strlen(keys[i]) + strlen(values[i]) + MAXIMUM_PROPERTY_OVERHEAD);
-                }
-                result = 0;
-            }
+            *length += 1;
         }
     }
-    return result;
-}
 
-/*produces a JSON representation of the map : {"a": "value_of_a","b":"value_of_b"}*/
-static int appendMapToJSON(STRING_HANDLE existing, const char* const* keys, const char* const* values, size_t count) /*under consideration: move to MAP module when it has more than 1 user*/
-{
-    int result;
-    if (STRING_concat(existing, "{") != 0)
+    if (source[i] != '\0')
     {
-        /*go on and return it*/
-        LogError("STRING_construct failed");
+        LogError("character outside [1...127] found at position %lu", (unsigned long)i);
         result = __FAILURE__;
     }
     else
     {
-        size_t i;
-        for (i = 0; i < count; i++)
-        {
-            if (!(
-                (STRING_concat(existing, (i == 0) ? "\"" IOTHUB_APP_PREFIX : ",\"" IOTHUB_APP_PREFIX) == 0) &&
-                (STRING_concat(existing, keys[i]) == 0) &&
-                (STRING_concat(existing, "\":\"") == 0) &&
-                (STRING_concat(existing, values[i]) == 0) &&
-                (STRING_concat(existing, "\"") == 0)
-                ))
-            {
-                LogError("unable to STRING_concat");
-                break;
-            }
-        }
+        result = 0;
+    }
+    return result;
+}
 
-        if (i < count)
+/*writes the JSON representation of source at destination, returns the first byte after it*/
+static unsigned char* writeJSONString(unsigned char* destination, const char* source)
+{
+    size_t i;
+    *destination++ = '"';
+    for (i = 0; source[i] != '\0'; i++)
+    {
+        unsigned char c = (unsigned char)source[i];
+        if (c <= 0x1F)
         {
-            result = __FAILURE__;
-            /*error, let it go through*/
+            *destination++ = '\\';
+            *destination++ = 'u';
+            *destination++ = '0';
+            *destination++ = '0';
+            *destination++ = hexCharacters[c >> 4];
+            *destination++ = hexCharacters[c & 0x0F];
         }
-        else if (STRING_concat(existing, "}") != 0)
+        else if ((c == '"') || (c == '\\') || (c == '/'))
         {
-            LogError("unable to STRING_concat");
-            result = __FAILURE__;
+            *destination++ = '\\';
+            *destination++ = c;
         }
         else
         {
-            /*all is fine*/
-            result = 0;
+            *destination++ = c;
         }
     }
-    return result;
+    *destination++ = '"';
+    return destination;
 }
 
-/*makes the following string:{"body":"base64 encoding of the message content"[,"properties":{"a":"valueOfA"}]}*/
-/*return NULL if there was a failure, or a non-NULL STRING_HANDLE that contains the intended data*/
-static STRING_HANDLE make1EventJSONitem(PDLIST_ENTRY item, size_t *messageSizeContribution)
+static unsigned char* writeBytes(unsigned char* destination, const char* source, size_t size)
 {
-    STRING_HANDLE result; /*temp wants to contain :{"body":"base64 encoding of the message content"[,"properties":{"a":"valueOfA"}]}*/
-    IOTHUB_MESSAGE_LIST* message = containingRecord(item, IOTHUB_MESSAGE_LIST, entry);
-    IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message->messageHandle);
+    (void)memcpy(destination, source, size);
+    return destination + size;
+}
+
+/*fills item from the message and computes both the message size as seen by the service and the exact number of bytes the item takes in the payload (trailing ',' included)*/
+/*returns 0 if the message can be batched*/
+static int getBatchItem(PDLIST_ENTRY listEntry, BATCH_ITEM* item, size_t* messageSizeContribution, size_t* encodedSize)
+{
+    int result;
+    size_t bodySize = 0;
+    size_t bodyEncodedSize = 0;
+    IOTHUB_MESSAGE_LIST* message = containingRecord(listEntry, IOTHUB_MESSAGE_LIST, entry);
 
-    switch (contentType)
+    item->contentType = IoTHubMessage_GetContentType(message->messageHandle);
+    switch (item->contentType)
     {
     case IOTHUBMESSAGE_BYTEARRAY:
     {
-        result = STRING_construct("{\"body\":\"");
-        if (result == NULL)
+        if (IoTHubMessage_GetByteArray(message->messageHandle, &item->source, &item->size) != IOTHUB_MESSAGE_OK)
         {
-            LogError("unable to STRING_construct");
+            LogError("unable to get the data for the message.");
+            result = __FAILURE__;
         }
         else
         {
-            const unsigned char* source;
-            size_t size;
-
-            if (IoTHubMessage_GetByteArray(message->messageHandle, &source, &size) != IOTHUB_MESSAGE_OK)
-            {
-                LogError("unable to get the data for the message.");
-                STRING_delete(result);
-                result = NULL;
-            }
-            else
-            {
-                STRING_HANDLE encoded = Base64_Encode_Bytes(source, size);
-                if (encoded == NULL)
-                {
-                    LogError("unable to Base64_Encode_Bytes.");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    size_t propertiesSize;
-                    if (!(
-                        (STRING_concat_with_STRING(result, encoded) == 0) &&
-                        (STRING_concat(result, "\"") == 0) && /*\" because closing value*/
-                        (concat_Properties(result, IoTHubMessage_Properties(message->messageHandle), &propertiesSize) == 0) &&
-                        (STRING_concat(result, "},") == 0) /*the last comma shall be replaced by a ']' by DaCr's suggestion (which is awesome enough to receive credits in the source code)*/
-                        ))
-                    {
-                        STRING_delete(result);
-                        result = NULL;
-                        LogError("unable to STRING_concat_with_STRING.");
-                    }
-                    else
-                    {
-                        /*all is fine... */
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
-                        *messageSizeContribution = size + MAXIMUM_PAYLOAD_OVERHEAD + propertiesSize;
-                    }
-                    STRING_delete(encoded);
-                }
-            }
+            bodySize = item->size;
+            bodyEncodedSize = LITERAL_LENGTH(BATCH_BYTEARRAY_BODY_BEGIN) + getBase64EncodedLength(item->size) + LITERAL_LENGTH(BATCH_BYTEARRAY_BODY_END);
+            result = 0;
         }
         break;
     }
     /*Codes_SRS_TRANSPORTMULTITHTTP_17_057: [If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false}] */
     case IOTHUBMESSAGE_STRING:
     {
-        result = STRING_construct("{\"body\":");
-        if (result == NULL)
+        size_t jsonLength;
+        if ((item->string = IoTHubMessage_GetString(message->messageHandle)) == NULL)
         {
-            LogError("unable to STRING_construct");
+            LogError("unable to IoTHubMessage_GetString");
+            result = __FAILURE__;
+        }
+        else if (getJSONStringLength(item->string, &jsonLength) != 0)
+        {
+            LogError("unable to JSON encode the message");
+            result = __FAILURE__;
         }
         else
         {
-            const char* source = IoTHubMessage_GetString(message->messageHandle);
-            if (source == NULL)
-            {
-                LogError("unable to IoTHubMessage_GetString");
-                STRING_delete(result);
-                result = NULL;
-            }
-            else
-            {
-                STRING_HANDLE asJson = STRING_new_JSON(source);
-                if (asJson == NULL)
-                {
-                    LogError("unable to STRING_new_JSON");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    size_t propertiesSize;
-                    if (!(
-                        (STRING_concat_with_STRING(result, asJson) == 0) &&
-                        (STRING_concat(result, ",\"base64Encoded\":false") == 0) &&
-                        (concat_Properties(result, IoTHubMessage_Properties(message->messageHandle), &propertiesSize) == 0) &&
-                        (STRING_concat(result, "},") == 0) /*the last comma shall be replaced by a ']' by DaCr's suggestion (which is awesome enough to receive credits in the source code)*/
-                        ))
-                    {
-                        LogError("unable to STRING_concat_with_STRING");
-                        STRING_delete(result);
-                        result = NULL;
-                    }
-                    else
-                    {
-                        /*result has the intended content*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
-                        *messageSizeContribution = strlen(source) + MAXIMUM_PAYLOAD_OVERHEAD + propertiesSize;
-                    }
-                    STRING_delete(asJson);
-                }
-            }
+            bodySize = strlen(item->string);
+            bodyEncodedSize = LITERAL_LENGTH(BATCH_STRING_BODY_BEGIN) + jsonLength + LITERAL_LENGTH(BATCH_STRING_BODY_END);
+            result = 0;
         }
         break;
     }
     default:
     {
-        LogError("an unknown message type was encountered (%d)", contentType);
-        result = NULL; /*unknown message type*/
+        LogError("an unknown message type was encountered (%d)", item->contentType);
+        result = __FAILURE__; /*unknown message type*/
         break;
     }
     }
+
+    if (result == 0)
+    {
+        if (Map_GetInternals(IoTHubMessage_Properties(message->messageHandle), &item->keys, &item->values, &item->count) != MAP_OK)
+        {
+            LogError("error while Map_GetInternals");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t propertiesSize = 0;
+            size_t propertiesEncodedSize = 0;
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_064: [If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload*/
+            if (item->count > 0)
+            {
+                size_t i;
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_058: [If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2*/
+                propertiesEncodedSize = LITERAL_LENGTH(BATCH_PROPERTIES_BEGIN) + (item->count - 1) /*the commas between properties*/ + LITERAL_LENGTH(BATCH_PROPERTIES_END);
+                for (i = 0; i < item->count; i++)
+                {
+                    size_t keyLength = strlen(item->keys[i]);
+                    size_t valueLength = strlen(item->values[i]);
+                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_063: [Every property name shall add to the message size the length of the property name + the length of the property value + 16 bytes.] */
+                    propertiesSize += (keyLength + valueLength + MAXIMUM_PROPERTY_OVERHEAD);
+                    propertiesEncodedSize += LITERAL_LENGTH(BATCH_PROPERTY_NAME_BEGIN) + keyLength + LITERAL_LENGTH(BATCH_PROPERTY_NAME_END) + valueLength + LITERAL_LENGTH(BATCH_PROPERTY_VALUE_END);
+                }
+            }
+
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_062: [The message size is computed from the length of the payload + 384.] */
+            *messageSizeContribution = bodySize + MAXIMUM_PAYLOAD_OVERHEAD + propertiesSize;
+            *encodedSize = bodyEncodedSize + propertiesEncodedSize + LITERAL_LENGTH(BATCH_ITEM_END);
+        }
+    }
     return result;
 }
 
+/*writes {"body":...[,"properties":{"iothub-app-a":"valueOfA"}]}, at destination, returns the first byte after it*/
+/*destination is expected to have room for exactly the encodedSize computed by getBatchItem*/
+static unsigned char* writeBatchItem(unsigned char* destination, const BATCH_ITEM* item)
+{
+    if (item->contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        destination = writeBytes(destination, BATCH_BYTEARRAY_BODY_BEGIN, LITERAL_LENGTH(BATCH_BYTEARRAY_BODY_BEGIN));
+        destination = writeBase64(destination, item->source, item->size);
+        destination = writeBytes(destination, BATCH_BYTEARRAY_BODY_END, LITERAL_LENGTH(BATCH_BYTEARRAY_BODY_END));
+    }
+    else
+    {
+        destination = writeBytes(destination, BATCH_STRING_BODY_BEGIN, LITERAL_LENGTH(BATCH_STRING_BODY_BEGIN));
+        destination = writeJSONString(destination, item->string);
+        destination = writeBytes(destination, BATCH_STRING_BODY_END, LITERAL_LENGTH(BATCH_STRING_BODY_END));
+    }
+
+    if (item->count > 0)
+    {
+        size_t i;
+        destination = writeBytes(destination, BATCH_PROPERTIES_BEGIN, LITERAL_LENGTH(BATCH_PROPERTIES_BEGIN));
+        for (i = 0; i < item->count; i++)
+        {
+            if (i > 0)
+            {
+                *destination++ = ',';
+            }
+            destination = writeBytes(destination, BATCH_PROPERTY_NAME_BEGIN, LITERAL_LENGTH(BATCH_PROPERTY_NAME_BEGIN));
+            destination = writeBytes(destination, item->keys[i], strlen(item->keys[i]));
+            destination = writeBytes(destination, BATCH_PROPERTY_NAME_END, LITERAL_LENGTH(BATCH_PROPERTY_NAME_END));
+            destination = writeBytes(destination, item->values[i], strlen(item->values[i]));
+            destination = writeBytes(destination, BATCH_PROPERTY_VALUE_END, LITERAL_LENGTH(BATCH_PROPERTY_VALUE_END));
+        }
+        destination = writeBytes(destination, BATCH_PROPERTIES_END, LITERAL_LENGTH(BATCH_PROPERTIES_END));
+    }
+
+    destination = writeBytes(destination, BATCH_ITEM_END, LITERAL_LENGTH(BATCH_ITEM_END));
+    return destination;
+}
+
 #define MAKE_PAYLOAD_RESULT_VALUES \
     MAKE_PAYLOAD_OK, /*returned when there is a payload to be later send by HTTP*/ \
     MAKE_PAYLOAD_NO_ITEMS, /*returned when there are no items to be send*/ \
@@ -1195,133 +1240,136 @@ static STRING_HANDLE make1EventJSONitem(PDLIST_ENTRY item, size_t *messageSizeCo
 
 DEFINE_ENUM(MAKE_PAYLOAD_RESULT, MAKE_PAYLOAD_RESULT_VALUES);
 
+static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
+{
+    /*this function takes a list, and inserts it in another list. When done in the context of this file, it reverses the effects of a not-able-to-send situation*/
+    DList_AppendTailList(destination->Flink, source);
+    DList_RemoveEntryList(source);
+    DList_InitializeListHead(source);
+}
+
 /*this function assembles several {"body":"base64 encoding of the message content"," base64Encoded": true} into 1 payload*/
+/*the items that fit are measured first, then the payload is allocated once at its exact size and every item is serialized straight into it*/
+/*when MAKE_PAYLOAD_OK is returned the batched items are in eventConfirmations and *payload has to be BUFFER_delete'd by the caller*/
 /*Codes_SRS_TRANSPORTMULTITHTTP_17_056: [IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...]]*/
-static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, STRING_HANDLE* payload)
+static MAKE_PAYLOAD_RESULT makePayload(HTTPTRANSPORT_PERDEVICE_DATA* deviceData, BUFFER_HANDLE* payload)
 {
     MAKE_PAYLOAD_RESULT result;
     size_t allMessagesSize = 0;
-    *payload = STRING_construct("[");
-    if (*payload == NULL)
-    {
-        LogError("unable to STRING_construct");
-        result = MAKE_PAYLOAD_ERROR;
-    }
-    else
-    {
-        bool isFirst = true;
-        PDLIST_ENTRY actual;
-        bool keepGoing = true; /*keepGoing gets sometimes to false from within the loop*/
-                               /*either all the items enter the list or only some*/
-        result = MAKE_PAYLOAD_OK; /*optimistically initializing it*/
-        while (keepGoing && ((actual = deviceData->waitingToSend->Flink) != deviceData->waitingToSend))
+    size_t payloadSize = 1; /*the opening '['. The closing ']' takes the place of the last item's ','*/
+    bool isFirst = true;
+    bool keepGoing = true; /*keepGoing gets sometimes to false from within the loop*/
+                           /*either all the items enter the list or only some*/
+    PDLIST_ENTRY actual;
+
+    *payload = NULL;
+    result = MAKE_PAYLOAD_OK; /*optimistically initializing it*/
+
+    /*Codes_SRS_TRANSPORTMULTITHTTP_01_004: [ IoTHubTransportHttp_DoWork shall compute the exact size of the serialized batch before building it. ]*/
+    while (keepGoing && ((actual = deviceData->waitingToSend->Flink) != deviceData->waitingToSend))
+    {
+        BATCH_ITEM item;
+        size_t messageSize;
+        size_t encodedSize;
+        if (getBatchItem(actual, &item, &messageSize, &encodedSize) != 0)
         {
-            size_t messageSize;
-            STRING_HANDLE temp = make1EventJSONitem(actual, &messageSize);
             if (isFirst)
             {
-                isFirst = false;
+                /*first item failed to be measured, nothing to send*/
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                if (temp == NULL) /*first item failed to create, nothing to send*/
-                {
-                    result = MAKE_PAYLOAD_ERROR;
-                    STRING_delete(*payload);
-                    *payload = NULL;
-                    keepGoing = false;
-                }
-                else
-                {
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
-                    if (messageSize > MAXIMUM_MESSAGE_SIZE)
-                    {
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
-                        STRING_delete(*payload);
-                        *payload = NULL;
-                        keepGoing = false;
-                    }
-                    else
-                    {
-                        if (STRING_concat_with_STRING(*payload, temp) != 0)
-                        {
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                            result = MAKE_PAYLOAD_ERROR;
-                            STRING_delete(*payload);
-                            *payload = NULL;
-                            keepGoing = false;
-                        }
-                        else
-                        {
-                            /*first item was put nicely in the payload*/
-                            PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                            DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                            allMessagesSize += messageSize;
-                        }
-                    }
-                    STRING_delete(temp);
-                }
+                result = MAKE_PAYLOAD_ERROR;
             }
             else
             {
-                /*there is at least 1 item already in the payload*/
-                if (temp == NULL)
-                {
-                    /*there are multiple payloads encoded, the last one had an internal error, just go with those - closing the payload happens "after the loop"*/
-                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                    result = MAKE_PAYLOAD_OK;
-                    keepGoing = false;
-                }
-                else
-                {
-                    if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
-                    {
-                        /*this item doesn't make it to the payload, but the payload is valid so far*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                        result = MAKE_PAYLOAD_OK;
-                        keepGoing = false;
-                    }
-                    else if (STRING_concat_with_STRING(*payload, temp) != 0)
-                    {
-                        /*should still send what there is so far...*/
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
-                        result = MAKE_PAYLOAD_OK;
-                        keepGoing = false;
-                    }
-                    else
-                    {
-                        /*cool, the payload made it there, let's continue... */
-                        PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
-                        DList_InsertTailList(&(deviceData->eventConfirmations), head);
-                        allMessagesSize += messageSize;
-                    }
-                    STRING_delete(temp);
-                }
+                /*there are multiple payloads measured, the last one had an internal error, just go with those*/
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
             }
+            keepGoing = false;
+        }
+        /*Codes_SRS_TRANSPORTMULTITHTTP_17_061: [The message size shall be limited to 255KB - 1 byte.]*/
+        else if (allMessagesSize + messageSize > MAXIMUM_MESSAGE_SIZE)
+        {
+            if (isFirst)
+            {
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_065: [If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_BATCHSTATE_FAILED.]*/
+                PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
+                DList_InsertTailList(&(deviceData->eventConfirmations), head);
+                result = MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT;
+            }
+            else
+            {
+                /*this item doesn't make it to the payload, but the payload is valid so far*/
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_066: [If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload.]*/
+            }
+            keepGoing = false;
+        }
+        else
+        {
+            /*cool, the item makes it in the payload, let's continue... */
+            PDLIST_ENTRY head = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
+            DList_InsertTailList(&(deviceData->eventConfirmations), head);
+            allMessagesSize += messageSize;
+            payloadSize += encodedSize;
         }
+        isFirst = false;
+    }
 
-        /*closing the payload*/
-        if (result == MAKE_PAYLOAD_OK)
+    if (result == MAKE_PAYLOAD_OK)
+    {
+        /*Codes_SRS_TRANSPORTMULTITHTTP_01_005: [ IoTHubTransportHttp_DoWork shall serialize the batched messages directly into a single BUFFER_HANDLE of that exact size. ]*/
+        if ((*payload = BUFFER_new()) == NULL)
         {
-            ((char*)STRING_c_str(*payload))[STRING_length(*payload) - 1] = ']'; /*TODO - do this in STRING_HANDLE*/
+            LogError("unable to BUFFER_new");
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+            result = MAKE_PAYLOAD_ERROR;
+        }
+        else if (BUFFER_pre_build(*payload, payloadSize) != 0)
+        {
+            LogError("unable to BUFFER_pre_build");
+            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+            BUFFER_delete(*payload);
+            *payload = NULL;
+            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+            result = MAKE_PAYLOAD_ERROR;
         }
         else
         {
-            /*no need to close anything*/
+            unsigned char* destination = BUFFER_u_char(*payload);
+            PDLIST_ENTRY current;
+
+            *destination++ = '[';
+            for (current = deviceData->eventConfirmations.Flink; current != &(deviceData->eventConfirmations); current = current->Flink)
+            {
+                BATCH_ITEM item;
+                size_t messageSize;
+                size_t encodedSize;
+                if (getBatchItem(current, &item, &messageSize, &encodedSize) != 0)
+                {
+                    break;
+                }
+                destination = writeBatchItem(destination, &item);
+            }
+
+            if (current != &(deviceData->eventConfirmations))
+            {
+                LogError("unable to serialize a message that was already measured");
+                /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+                BUFFER_delete(*payload);
+                *payload = NULL;
+                reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                result = MAKE_PAYLOAD_ERROR;
+            }
+            else
+            {
+                /*closing the payload*/
+                *(destination - 1) = ']';
+            }
         }
     }
     return result;
 }
 
-static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
-{
-    /*this function takes a list, and inserts it in another list. When done in the context of this file, it reverses the effects of a not-able-to-send situation*/
-    DList_AppendTailList(destination->Flink, source);
-    DList_RemoveEntryList(source);
-    DList_InitializeListHead(source);
-}
-
 static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
 {
 
@@ -1343,67 +1391,46 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
             else
             {
                 /*Codes_SRS_TRANSPORTMULTITHTTP_17_059: [It shall inspect the "waitingToSend" DLIST passed in config structure.] */
-                STRING_HANDLE payload;
+                BUFFER_HANDLE payload;
                 switch (makePayload(deviceData, &payload))
                 {
                 case MAKE_PAYLOAD_OK:
                 {
                     /*Codes_SRS_TRANSPORTMULTITHTTP_17_068: [Once a final payload has been obtained, IoTHubTransportHttp_DoWork shall call HTTPAPIEX_SAS_ExecuteRequest passing the following parameters:] */
-                    BUFFER_HANDLE temp = BUFFER_new();
-                    if (temp == NULL)
+                    unsigned int statusCode;
+                    if (HTTPAPIEX_SAS_ExecuteRequest(
+                        deviceData->sasObject,
+                        handleData->httpApiExHandle,
+                        HTTPAPI_REQUEST_POST,
+                        STRING_c_str(deviceData->eventHTTPrelativePath),
+                        deviceData->eventHTTPrequestHeaders,
+                        payload,
+                        &statusCode,
+                        NULL,
+                        NULL
+                        ) != HTTPAPIEX_OK)
                     {
-                        LogError("unable to BUFFER_new");
-                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
+                        LogError("unable to HTTPAPIEX_ExecuteRequest");
+                        //items go back to waitingToSend
+                        /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
                         reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                     }
                     else
                     {
-                        if (BUFFER_build(temp, (const unsigned char*)STRING_c_str(payload), STRING_length(payload)) != 0)
+                        if (statusCode < 300)
                         {
-                            LogError("unable to BUFFER_build");
-                            //items go back to waitingToSend
-                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_067: [If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity.]*/
-                            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
+                            IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
                         }
                         else
                         {
-                            unsigned int statusCode;
-                            if (HTTPAPIEX_SAS_ExecuteRequest(
-                                deviceData->sasObject,
-                                handleData->httpApiExHandle,
-                                HTTPAPI_REQUEST_POST,
-                                STRING_c_str(deviceData->eventHTTPrelativePath),
-                                deviceData->eventHTTPrequestHeaders,
-                                temp,
-                                &statusCode,
-                                NULL,
-                                NULL
-                                ) != HTTPAPIEX_OK)
-                            {
-                                LogError("unable to HTTPAPIEX_ExecuteRequest");
-                                //items go back to waitingToSend
-                                /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
-                            }
-                            else
-                            {
-                                if (statusCode < 300)
-                                {
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_070: [If HTTPAPIEX_SAS_ExecuteRequest does not fail and http status code <300 then IoTHubTransportHttp_DoWork shall call IoTHubClient_LL_SendComplete. Parameter PDLIST_ENTRY completed shall point to a list containing all the items batched, and parameter IOTHUB_CLIENT_CONFIRMATION_RESULT result shall be set to IOTHUB_CLIENT_CONFIRMATION_OK. The batched items shall be removed from waitingToSend.] */
-                                    IoTHubClient_LL_SendComplete(iotHubClientHandle, &(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK);
-                                }
-                                else
-                                {
-                                    //items go back to waitingToSend
-                                    /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
-                                    LogError("unexpected HTTP status code (%u)", statusCode);
-                                    reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
-                                }
-                            }
+                            //items go back to waitingToSend
+                            /*Codes_SRS_TRANSPORTMULTITHTTP_17_069: [if HTTPAPIEX_SAS_ExecuteRequest fails or the http status code >=300 then IoTHubTransportHttp_DoWork shall not do any other action (it is assumed at the next _DoWork it shall be retried).] */
+                            LogError("unexpected HTTP status code (%u)", statusCode);
+                            reversePutListBackIn(&(deviceData->eventConfirmations), deviceData->waitingToSend);
                         }
-                        BUFFER_delete(temp);
                     }
-                    STRING_delete(payload);
+                    BUFFER_delete(payload);
                     break;
                 }
                 case MAKE_PAYLOAD_FIRST_ITEM_DOES_NOT_FIT:
@@ -1,8 +1,12 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "uamqp_messaging.h"
 #include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_uamqp_c/message.h"
 #include "azure_uamqp_c/amqpvalue.h"
@@ -11,6 +15,421 @@
 #define RESULT_OK 0
 #endif
 
+// AMQP 1.0 wire format constructors and section descriptors (AMQP 1.0 spec, parts 1.6 and 3.2).
+#define AMQP_CONSTRUCTOR_DESCRIBED                  0x00
+#define AMQP_CONSTRUCTOR_NULL                       0x40
+#define AMQP_CONSTRUCTOR_SMALLULONG                 0x53
+#define AMQP_CONSTRUCTOR_ULONG                      0x80
+#define AMQP_CONSTRUCTOR_VBIN8                      0xa0
+#define AMQP_CONSTRUCTOR_STR8                       0xa1
+#define AMQP_CONSTRUCTOR_SYM8                       0xa3
+#define AMQP_CONSTRUCTOR_VBIN32                     0xb0
+#define AMQP_CONSTRUCTOR_STR32                      0xb1
+#define AMQP_CONSTRUCTOR_SYM32                      0xb3
+#define AMQP_CONSTRUCTOR_LIST8                      0xc0
+#define AMQP_CONSTRUCTOR_MAP8                       0xc1
+#define AMQP_CONSTRUCTOR_LIST32                     0xd0
+#define AMQP_CONSTRUCTOR_MAP32                      0xd1
+#define AMQP_DESCRIPTOR_PROPERTIES                  0x73
+#define AMQP_DESCRIPTOR_APPLICATION_PROPERTIES      0x74
+#define AMQP_DESCRIPTOR_DATA                        0x75
+#define AMQP_SYMBOL_APPLICATION_PROPERTIES          "amqp:application-properties:map"
+#define AMQP_PROPERTIES_CORRELATION_ID_INDEX        5
+
+typedef struct ENCODING_BUFFER_TAG
+{
+	unsigned char* bytes;
+	size_t size;
+	size_t position;
+} ENCODING_BUFFER;
+
+typedef struct DECODING_BUFFER_TAG
+{
+	unsigned char* bytes;
+	size_t size;
+	size_t position;
+} DECODING_BUFFER;
+
+typedef struct EVENT_FIELDS_TAG
+{
+	const char* message_id;
+	const char* correlation_id;
+	const char* const* property_keys;
+	const char* const* property_values;
+	size_t property_count;
+	const unsigned char* content;
+	size_t content_size;
+} EVENT_FIELDS;
+
+static int write_encoded_bytes(void* context, const unsigned char* bytes, size_t length)
+{
+	int result;
+	ENCODING_BUFFER* buffer = (ENCODING_BUFFER*)context;
+
+	if (buffer->size - buffer->position < length)
+	{
+		LogError("Encoded AMQP value exceeds its reported size.");
+		result = __FAILURE__;
+	}
+	else
+	{
+		(void)memcpy(buffer->bytes + buffer->position, bytes, length);
+		buffer->position += length;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+// The encode_* helpers below write at `buffer` and return the number of bytes written.
+// When `buffer` is NULL nothing is written, so the same code computes the encoded size.
+static unsigned char* buffer_at(unsigned char* buffer, size_t offset)
+{
+	return (buffer == NULL ? NULL : buffer + offset);
+}
+
+static size_t encode_uint32(unsigned char* buffer, uint32_t value)
+{
+	if (buffer != NULL)
+	{
+		buffer[0] = (unsigned char)(value >> 24);
+		buffer[1] = (unsigned char)(value >> 16);
+		buffer[2] = (unsigned char)(value >> 8);
+		buffer[3] = (unsigned char)value;
+	}
+
+	return sizeof(uint32_t);
+}
+
+static size_t encode_null(unsigned char* buffer)
+{
+	if (buffer != NULL)
+	{
+		buffer[0] = AMQP_CONSTRUCTOR_NULL;
+	}
+
+	return 1;
+}
+
+static size_t encode_variable_width(unsigned char* buffer, unsigned char constructor8, unsigned char constructor32, const void* value, size_t length)
+{
+	size_t size;
+
+	if (length <= UINT8_MAX)
+	{
+		if (buffer != NULL)
+		{
+			buffer[0] = constructor8;
+			buffer[1] = (unsigned char)length;
+		}
+		size = 2;
+	}
+	else
+	{
+		if (buffer != NULL)
+		{
+			buffer[0] = constructor32;
+			(void)encode_uint32(buffer + 1, (uint32_t)length);
+		}
+		size = 1 + sizeof(uint32_t);
+	}
+
+	if (buffer != NULL && length > 0)
+	{
+		(void)memcpy(buffer + size, value, length);
+	}
+
+	return size + length;
+}
+
+static size_t encode_string(unsigned char* buffer, const char* value)
+{
+	return encode_variable_width(buffer, AMQP_CONSTRUCTOR_STR8, AMQP_CONSTRUCTOR_STR32, value, strlen(value));
+}
+
+static size_t encode_compound_header(unsigned char* buffer, unsigned char constructor8, unsigned char constructor32, size_t content_size, size_t count)
+{
+	size_t size;
+
+	// The size of a compound value includes its count field.
+	if (content_size + 1 <= UINT8_MAX && count <= UINT8_MAX)
+	{
+		if (buffer != NULL)
+		{
+			buffer[0] = constructor8;
+			buffer[1] = (unsigned char)(content_size + 1);
+			buffer[2] = (unsigned char)count;
+		}
+		size = 3;
+	}
+	else
+	{
+		if (buffer != NULL)
+		{
+			buffer[0] = constructor32;
+			(void)encode_uint32(buffer + 1, (uint32_t)(content_size + sizeof(uint32_t)));
+			(void)encode_uint32(buffer + 1 + sizeof(uint32_t), (uint32_t)count);
+		}
+		size = 1 + 2 * sizeof(uint32_t);
+	}
+
+	return size;
+}
+
+static size_t encode_section_descriptor(unsigned char* buffer, unsigned char descriptor)
+{
+	if (buffer != NULL)
+	{
+		buffer[0] = AMQP_CONSTRUCTOR_DESCRIBED;
+		buffer[1] = AMQP_CONSTRUCTOR_SMALLULONG;
+		buffer[2] = descriptor;
+	}
+
+	return 3;
+}
+
+static size_t encode_properties_section(unsigned char* buffer, const char* message_id, const char* correlation_id)
+{
+	size_t content_size;
+	size_t field_count;
+	size_t size;
+
+	// message-id is the first field of the properties list and correlation-id the sixth; the fields in between are encoded as null.
+	content_size = (message_id != NULL ? encode_string(NULL, message_id) : encode_null(NULL));
+	field_count = 1;
+
+	if (correlation_id != NULL)
+	{
+		content_size += (AMQP_PROPERTIES_CORRELATION_ID_INDEX - 1) * encode_null(NULL) + encode_string(NULL, correlation_id);
+		field_count = AMQP_PROPERTIES_CORRELATION_ID_INDEX + 1;
+	}
+
+	size = encode_section_descriptor(buffer, AMQP_DESCRIPTOR_PROPERTIES);
+	size += encode_compound_header(buffer_at(buffer, size), AMQP_CONSTRUCTOR_LIST8, AMQP_CONSTRUCTOR_LIST32, content_size, field_count);
+	size += (message_id != NULL ? encode_string(buffer_at(buffer, size), message_id) : encode_null(buffer_at(buffer, size)));
+
+	if (correlation_id != NULL)
+	{
+		size_t i;
+		for (i = 1; i < AMQP_PROPERTIES_CORRELATION_ID_INDEX; i++)
+		{
+			size += encode_null(buffer_at(buffer, size));
+		}
+		size += encode_string(buffer_at(buffer, size), correlation_id);
+	}
+
+	return size;
+}
+
+static size_t encode_application_properties_section(unsigned char* buffer, const char* const* keys, const char* const* values, size_t count)
+{
+	size_t content_size = 0;
+	size_t size;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		content_size += encode_string(NULL, keys[i]) + encode_string(NULL, values[i]);
+	}
+
+	size = encode_section_descriptor(buffer, AMQP_DESCRIPTOR_APPLICATION_PROPERTIES);
+	size += encode_compound_header(buffer_at(buffer, size), AMQP_CONSTRUCTOR_MAP8, AMQP_CONSTRUCTOR_MAP32, content_size, 2 * count);
+
+	if (buffer == NULL)
+	{
+		size += content_size;
+	}
+	else
+	{
+		for (i = 0; i < count; i++)
+		{
+			size += encode_string(buffer + size, keys[i]);
+			size += encode_string(buffer + size, values[i]);
+		}
+	}
+
+	return size;
+}
+
+static size_t encode_event(unsigned char* buffer, const EVENT_FIELDS* event)
+{
+	size_t size = 0;
+
+	if (event->message_id != NULL || event->correlation_id != NULL)
+	{
+		size += encode_properties_section(buffer, event->message_id, event->correlation_id);
+	}
+
+	if (event->property_count > 0)
+	{
+		size += encode_application_properties_section(buffer_at(buffer, size), event->property_keys, event->property_values, event->property_count);
+	}
+
+	size += encode_section_descriptor(buffer_at(buffer, size), AMQP_DESCRIPTOR_DATA);
+	size += encode_variable_width(buffer_at(buffer, size), AMQP_CONSTRUCTOR_VBIN8, AMQP_CONSTRUCTOR_VBIN32, event->content, event->content_size);
+
+	return size;
+}
+
+static int decode_bytes(DECODING_BUFFER* buffer, size_t length, unsigned char** bytes)
+{
+	int result;
+
+	if (buffer->size - buffer->position < length)
+	{
+		result = __FAILURE__;
+	}
+	else
+	{
+		*bytes = buffer->bytes + buffer->position;
+		buffer->position += length;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+static int decode_width(DECODING_BUFFER* buffer, bool is_wide, uint32_t* value)
+{
+	int result;
+	unsigned char* bytes;
+
+	if (decode_bytes(buffer, (is_wide ? sizeof(uint32_t) : 1), &bytes) != RESULT_OK)
+	{
+		result = __FAILURE__;
+	}
+	else
+	{
+		*value = (is_wide ? (((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3]) : (uint32_t)bytes[0]);
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+static int decode_application_properties_descriptor(DECODING_BUFFER* buffer)
+{
+	int result;
+	unsigned char* bytes;
+	uint32_t length;
+
+	// The descriptor may be the numeric code, in either ulong encoding, or its symbolic name.
+	if (decode_bytes(buffer, 2, &bytes) != RESULT_OK || bytes[0] != AMQP_CONSTRUCTOR_DESCRIBED)
+	{
+		result = __FAILURE__;
+	}
+	else if (bytes[1] == AMQP_CONSTRUCTOR_SMALLULONG)
+	{
+		result = (decode_bytes(buffer, 1, &bytes) == RESULT_OK && bytes[0] == AMQP_DESCRIPTOR_APPLICATION_PROPERTIES) ? RESULT_OK : __FAILURE__;
+	}
+	else if (bytes[1] == AMQP_CONSTRUCTOR_ULONG)
+	{
+		static const unsigned char descriptor[8] = { 0, 0, 0, 0, 0, 0, 0, AMQP_DESCRIPTOR_APPLICATION_PROPERTIES };
+		result = (decode_bytes(buffer, sizeof(descriptor), &bytes) == RESULT_OK && memcmp(bytes, descriptor, sizeof(descriptor)) == 0) ? RESULT_OK : __FAILURE__;
+	}
+	else if (bytes[1] == AMQP_CONSTRUCTOR_SYM8 || bytes[1] == AMQP_CONSTRUCTOR_SYM32)
+	{
+		result = (decode_width(buffer, bytes[1] == AMQP_CONSTRUCTOR_SYM32, &length) == RESULT_OK &&
+			length == sizeof(AMQP_SYMBOL_APPLICATION_PROPERTIES) - 1 &&
+			decode_bytes(buffer, length, &bytes) == RESULT_OK &&
+			memcmp(bytes, AMQP_SYMBOL_APPLICATION_PROPERTIES, length) == 0) ? RESULT_OK : __FAILURE__;
+	}
+	else
+	{
+		result = __FAILURE__;
+	}
+
+	return result;
+}
+
+static int decode_string(DECODING_BUFFER* buffer, char** value, size_t* length)
+{
+	int result;
+	unsigned char* constructor;
+	unsigned char* bytes;
+	uint32_t string_length;
+
+	if (decode_bytes(buffer, 1, &constructor) != RESULT_OK ||
+		(*constructor != AMQP_CONSTRUCTOR_STR8 && *constructor != AMQP_CONSTRUCTOR_STR32) ||
+		decode_width(buffer, *constructor == AMQP_CONSTRUCTOR_STR32, &string_length) != RESULT_OK ||
+		decode_bytes(buffer, string_length, &bytes) != RESULT_OK)
+	{
+		result = __FAILURE__;
+	}
+	else
+	{
+		*value = (char*)bytes;
+		*length = string_length;
+		result = RESULT_OK;
+	}
+
+	return result;
+}
+
+// @brief
+//     Parses an encoded application-properties section in a single pass, adding each property to `properties_map`.
+//     The strings are NUL-terminated in place, so `bytes` must have one spare byte after `size`.
+static int decode_application_properties_section(unsigned char* bytes, size_t size, MAP_HANDLE properties_map)
+{
+	int result;
+	DECODING_BUFFER buffer;
+	unsigned char* constructor;
+	uint32_t map_size;
+	uint32_t element_count;
+
+	buffer.bytes = bytes;
+	buffer.size = size;
+	buffer.position = 0;
+
+	if (decode_application_properties_descriptor(&buffer) != RESULT_OK ||
+		decode_bytes(&buffer, 1, &constructor) != RESULT_OK ||
+		(*constructor != AMQP_CONSTRUCTOR_MAP8 && *constructor != AMQP_CONSTRUCTOR_MAP32) ||
+		decode_width(&buffer, *constructor == AMQP_CONSTRUCTOR_MAP32, &map_size) != RESULT_OK ||
+		decode_width(&buffer, *constructor == AMQP_CONSTRUCTOR_MAP32, &element_count) != RESULT_OK ||
+		element_count % 2 != 0)
+	{
+		LogError("Failed parsing the uAMQP message application properties map.");
+		result = __FAILURE__;
+	}
+	else
+	{
+		uint32_t i;
+		result = RESULT_OK;
+
+		for (i = 0; result == RESULT_OK && i < element_count; i += 2)
+		{
+			char* key_name;
+			char* key_value;
+			size_t key_name_length;
+			size_t key_value_length;
+
+			if (decode_string(&buffer, &key_name, &key_name_length) != RESULT_OK ||
+				decode_string(&buffer, &key_value, &key_value_length) != RESULT_OK)
+			{
+				LogError("Failed parsing the uAMQP property name or value (only string properties are supported).");
+				result = __FAILURE__;
+			}
+			else
+			{
+				// The byte after the name is the (already parsed) value constructor; the byte after the value belongs to the next pair, so it is restored.
+				char next_byte = key_value[key_value_length];
+				key_name[key_name_length] = '\0';
+				key_value[key_value_length] = '\0';
+
+				if (Map_AddOrUpdate(properties_map, key_name, key_value) != MAP_OK)
+				{
+					LogError("Failed to add/update IoTHub message property map.");
+					result = __FAILURE__;
+				}
+
+				key_value[key_value_length] = next_byte;
+			}
+		}
+	}
+
+	return result;
+}
+
 static int addPropertiesTouAMQPMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, MESSAGE_HANDLE uamqp_message)
 {
 	int result = RESULT_OK;
@@ -287,8 +706,6 @@ static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothu
 {
 	int result;
 	AMQP_VALUE uamqp_app_properties = NULL;
-	AMQP_VALUE uamqp_app_properties_ipdv = NULL;
-	uint32_t property_count = 0;
 	MAP_HANDLE iothub_message_properties_map;
 
 	// Codes_SRS_UAMQP_MESSAGING_09_027: [The IOTHUB_MESSAGE_HANDLE properties shall be retrieved using IoTHubMessage_Properties.]
@@ -314,72 +731,46 @@ static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothu
 		}
 		else
 		{
-			// Codes_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
-			if ((uamqp_app_properties_ipdv = amqpvalue_get_inplace_described_value(uamqp_app_properties)) == NULL)
+			ENCODING_BUFFER buffer;
+			size_t encoded_size;
+
+			// Codes_SRS_UAMQP_MESSAGING_01_007: [The encoded size of the uAMQP message application properties shall be obtained using amqpvalue_get_encoded_size.]
+			if (amqpvalue_get_encoded_size(uamqp_app_properties, &encoded_size) != 0)
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-				LogError("Failed getting the map of uAMQP message application properties (return code %d).", result);
+				// Codes_SRS_UAMQP_MESSAGING_01_008: [If amqpvalue_get_encoded_size fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+				LogError("Failed getting the encoded size of the uAMQP message application properties.");
 				result = __FAILURE__;
 			}
-			// Codes_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
-			else if ((result = amqpvalue_get_map_pair_count(uamqp_app_properties_ipdv, &property_count)) != 0)
+			// Codes_SRS_UAMQP_MESSAGING_01_009: [The application properties shall be encoded with amqpvalue_encode into a single buffer, allocated with one spare byte so the property strings can be terminated in place.]
+			else if ((buffer.bytes = (unsigned char*)malloc(encoded_size + 1)) == NULL)
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-				LogError("Failed reading the number of values in the uAMQP property map (return code %d).", result);
+				// Codes_SRS_UAMQP_MESSAGING_01_010: [If the buffer cannot be allocated or amqpvalue_encode fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+				LogError("Failed allocating %lu bytes to decode the uAMQP message application properties.", (unsigned long)encoded_size);
 				result = __FAILURE__;
 			}
 			else
 			{
-				// Codes_SRS_UAMQP_MESSAGING_09_036: [IoTHubMessage_CreateFromuAMQPMessage() shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
-				uint32_t i;
-				for (i = 0; result == RESULT_OK && i < property_count; i++)
-				{
-					AMQP_VALUE map_key_name = NULL;
-					AMQP_VALUE map_key_value = NULL;
-					const char *key_name;
-					const char* key_value;
-
-					// Codes_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
-					if ((result = amqpvalue_get_map_key_value_pair(uamqp_app_properties_ipdv, i, &map_key_name, &map_key_value)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed reading the key/value pair from the uAMQP property map (return code %d).", result);
-						result = __FAILURE__;
-					}
+				buffer.size = encoded_size;
+				buffer.position = 0;
 
-					// Codes_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
-					else if ((result = amqpvalue_get_string(map_key_name, &key_name)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed parsing the uAMQP property name (return code %d).", result);
-						result = __FAILURE__;
-					}
-					// Codes_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
-					else if ((result = amqpvalue_get_string(map_key_value, &key_value)) != 0)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed parsing the uAMQP property value (return code %d).", result);
-						result = __FAILURE__;
-					}
-					// Codes_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
-					else if (Map_AddOrUpdate(iothub_message_properties_map, key_name, key_value) != MAP_OK)
-					{
-						// Codes_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-						LogError("Failed to add/update IoTHub message property map.");
-						result = __FAILURE__;
-					}
-
-					// Codes_SRS_UAMQP_MESSAGING_09_045: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property name and value (obtained with amqpvalue_get_string) by calling amqpvalue_destroy().]
-					if (map_key_name != NULL)
-					{
-						amqpvalue_destroy(map_key_name);
-					}
-
-					if (map_key_value != NULL)
-					{
-						amqpvalue_destroy(map_key_value);
-					}
+				if (amqpvalue_encode(uamqp_app_properties, write_encoded_bytes, &buffer) != 0)
+				{
+					// Codes_SRS_UAMQP_MESSAGING_01_010: [If the buffer cannot be allocated or amqpvalue_encode fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+					LogError("Failed encoding the uAMQP message application properties.");
+					result = __FAILURE__;
 				}
+				// Codes_SRS_UAMQP_MESSAGING_01_011: [The encoded map shall be parsed in a single pass, adding each name and value directly to the IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate, without creating an AMQP_VALUE per property.]
+				else if (decode_application_properties_section(buffer.bytes, buffer.position, iothub_message_properties_map) != RESULT_OK)
+				{
+					// Codes_SRS_UAMQP_MESSAGING_01_012: [If the map is malformed, holds a non-string name or value, or Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+					result = __FAILURE__;
+				}
+				else
+				{
+					result = RESULT_OK;
+				}
+
+				free(buffer.bytes);
 			}
 
 			// Codes_SRS_UAMQP_MESSAGING_09_046: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property (obtained with message_get_application_properties) by calling amqpvalue_destroy().]
@@ -535,3 +926,85 @@ int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MES
 
 	return result;
 }
+
+int message_create_uamqp_encoding_from_iothub_message(IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+{
+	int result;
+	IOTHUBMESSAGE_CONTENT_TYPE contentType = IoTHubMessage_GetContentType(message_handle);
+	const char* messageContent = NULL;
+	size_t messageContentSize = 0;
+	MAP_HANDLE properties_map;
+	const char* const* propertyKeys;
+	const char* const* propertyValues;
+	size_t propertyCount = 0;
+
+	// Codes_SRS_UAMQP_MESSAGING_01_001: [The content of the IOTHUB_MESSAGE_HANDLE instance shall be obtained with IoTHubMessage_GetByteArray() or IoTHubMessage_GetString(), depending on its content type.]
+	if (contentType == IOTHUBMESSAGE_BYTEARRAY &&
+		IoTHubMessage_GetByteArray(message_handle, (const unsigned char **)&messageContent, &messageContentSize) != IOTHUB_MESSAGE_OK)
+	{
+		LogError("Failed getting the BYTE array representation of the IOTHUB_MESSAGE_HANDLE instance.");
+		result = __FAILURE__;
+	}
+	else if (contentType == IOTHUBMESSAGE_STRING &&
+		((messageContent = IoTHubMessage_GetString(message_handle)) == NULL))
+	{
+		LogError("Failed getting the STRING representation of the IOTHUB_MESSAGE_HANDLE instance.");
+		result = __FAILURE__;
+	}
+	else if (contentType == IOTHUBMESSAGE_UNKNOWN)
+	{
+		LogError("Cannot encode IOTHUB_MESSAGE_HANDLE with content type IOTHUBMESSAGE_UNKNOWN.");
+		result = __FAILURE__;
+	}
+	// Codes_SRS_UAMQP_MESSAGING_01_002: [The message properties shall be read directly from the internals of the map returned by IoTHubMessage_Properties(), using Map_GetInternals().]
+	else if ((properties_map = IoTHubMessage_Properties(message_handle)) == NULL)
+	{
+		LogError("Failed to get property map from IoTHub message.");
+		result = __FAILURE__;
+	}
+	else if (Map_GetInternals(properties_map, &propertyKeys, &propertyValues, &propertyCount) != MAP_OK)
+	{
+		LogError("Failed to get the internals of the property map.");
+		result = __FAILURE__;
+	}
+	else
+	{
+		EVENT_FIELDS event;
+		size_t encoded_size;
+		unsigned char* encoded_bytes;
+
+		if (contentType == IOTHUBMESSAGE_STRING)
+		{
+			messageContentSize = strlen(messageContent);
+		}
+
+		event.message_id = IoTHubMessage_GetMessageId(message_handle);
+		event.correlation_id = IoTHubMessage_GetCorrelationId(message_handle);
+		event.property_keys = propertyKeys;
+		event.property_values = propertyValues;
+		event.property_count = propertyCount;
+		event.content = (const unsigned char*)messageContent;
+		event.content_size = messageContentSize;
+
+		// Codes_SRS_UAMQP_MESSAGING_01_003: [The properties, application-properties and data sections shall be written directly in AMQP wire format, without creating any intermediate AMQP_VALUE; the properties and application-properties sections shall be omitted when empty.]
+		// Codes_SRS_UAMQP_MESSAGING_01_004: [The encoded size shall be computed first, so the sections are written into a single buffer allocated for their exact size, which shall be returned in `body_binary_data` and released by the caller with free().]
+		encoded_size = encode_event(NULL, &event);
+
+		if ((encoded_bytes = (unsigned char*)malloc(encoded_size)) == NULL)
+		{
+			LogError("Failed to allocate %lu bytes for an encoded event.", (unsigned long)encoded_size);
+			result = __FAILURE__;
+		}
+		else
+		{
+			(void)encode_event(encoded_bytes, &event);
+
+			body_binary_data->bytes = encoded_bytes;
+			body_binary_data->length = encoded_size;
+			result = RESULT_OK;
+		}
+	}
+
+	// Codes_SRS_UAMQP_MESSAGING_01_005: [If any failure occurs, message_create_uamqp_encoding_from_iothub_message() shall free everything it allocated and return a non-zero value.]
+	return result;
+}
@@ -0,0 +1,529 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*offline benchmark of the AMQP messenger event path with many events in flight. The uamqp link, message sender and
+message functions are replaced below by stubs that only remember the send complete callbacks, so what is measured is
+the messenger's own bookkeeping: taking a task for messenger_send_async, moving it to the in progress list on
+messenger_do_work and finding, removing and recycling it when the send completes. The same number of events is sent
+once with a small window (SMALL_WINDOW events in flight at a time) and once with all of them in flight, and the sends
+are completed in a shuffled order, like the service settles them. When the per event times of both windows are the
+same, the cost of an event does not depend on how many others are in flight. The result is a single key=value line
+so that runs can be diffed and graphed*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/message_sender.h"
+#include "azure_uamqp_c/message_receiver.h"
+#include "uamqp_messaging.h"
+#include "iothub_client_private.h"
+#include "iothubtransport_amqp_messenger.h"
+
+#define SMALL_WINDOW 100
+#define MAX_START_ATTEMPTS 10
+
+typedef struct SENT_EVENT_TAG
+{
+    ON_MESSAGE_SEND_COMPLETE on_send_complete;
+    void* context;
+} SENT_EVENT;
+
+typedef struct PHASE_TIMES_TAG
+{
+    uint64_t sendAsync;
+    uint64_t doWork;
+    uint64_t complete;
+} PHASE_TIMES;
+
+static ON_MESSAGE_SENDER_STATE_CHANGED senderStateChangedCallback;
+static void* senderStateChangedContext;
+static SENT_EVENT* sentEvents;
+static size_t sentEventsCapacity;
+static size_t sentEventsCount;
+static size_t completedEvents;
+static size_t failedEvents;
+static MESSENGER_STATE messengerState = MESSENGER_STATE_STOPPED;
+
+/*any non-NULL value will do as a handle, the stubs never look behind it*/
+static int fakeHandleTarget;
+#define FAKE_HANDLE(type) ((type)(void*)&fakeHandleTarget)
+
+LINK_HANDLE link_create(SESSION_HANDLE session, const char* name, role link_role, AMQP_VALUE source, AMQP_VALUE target)
+{
+    (void)session;
+    (void)name;
+    (void)link_role;
+    (void)source;
+    (void)target;
+    return FAKE_HANDLE(LINK_HANDLE);
+}
+
+void link_destroy(LINK_HANDLE link)
+{
+    (void)link;
+}
+
+int link_set_max_message_size(LINK_HANDLE link, uint64_t max_message_size)
+{
+    (void)link;
+    (void)max_message_size;
+    return 0;
+}
+
+int link_set_attach_properties(LINK_HANDLE link, fields attach_properties)
+{
+    (void)link;
+    (void)attach_properties;
+    return 0;
+}
+
+int link_set_rcv_settle_mode(LINK_HANDLE link, receiver_settle_mode rcv_settle_mode)
+{
+    (void)link;
+    (void)rcv_settle_mode;
+    return 0;
+}
+
+MESSAGE_SENDER_HANDLE messagesender_create(LINK_HANDLE link, ON_MESSAGE_SENDER_STATE_CHANGED on_message_sender_state_changed, void* context)
+{
+    (void)link;
+    senderStateChangedCallback = on_message_sender_state_changed;
+    senderStateChangedContext = context;
+    return FAKE_HANDLE(MESSAGE_SENDER_HANDLE);
+}
+
+int messagesender_open(MESSAGE_SENDER_HANDLE message_sender)
+{
+    (void)message_sender;
+    senderStateChangedCallback(senderStateChangedContext, MESSAGE_SENDER_STATE_OPEN, MESSAGE_SENDER_STATE_IDLE);
+    return 0;
+}
+
+void messagesender_destroy(MESSAGE_SENDER_HANDLE message_sender)
+{
+    (void)message_sender;
+}
+
+int messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context)
+{
+    int result;
+    (void)message_sender;
+    (void)message;
+
+    if (sentEventsCount == sentEventsCapacity)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        sentEvents[sentEventsCount].on_send_complete = on_message_send_complete;
+        sentEvents[sentEventsCount].context = callback_context;
+        sentEventsCount++;
+        result = 0;
+    }
+
+    return result;
+}
+
+MESSAGE_RECEIVER_HANDLE messagereceiver_create(LINK_HANDLE link, ON_MESSAGE_RECEIVER_STATE_CHANGED on_message_receiver_state_changed, void* context)
+{
+    (void)link;
+    (void)on_message_receiver_state_changed;
+    (void)context;
+    return FAKE_HANDLE(MESSAGE_RECEIVER_HANDLE);
+}
+
+int messagereceiver_open(MESSAGE_RECEIVER_HANDLE message_receiver, ON_MESSAGE_RECEIVED on_message_received, const void* callback_context)
+{
+    (void)message_receiver;
+    (void)on_message_received;
+    (void)callback_context;
+    return 0;
+}
+
+int messagereceiver_close(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    (void)message_receiver;
+    return 0;
+}
+
+void messagereceiver_destroy(MESSAGE_RECEIVER_HANDLE message_receiver)
+{
+    (void)message_receiver;
+}
+
+int messagereceiver_get_link_name(MESSAGE_RECEIVER_HANDLE message_receiver, const char** link_name)
+{
+    (void)message_receiver;
+    *link_name = "link-rcv";
+    return 0;
+}
+
+int messagereceiver_get_received_message_id(MESSAGE_RECEIVER_HANDLE message_receiver, delivery_number* message_number)
+{
+    (void)message_receiver;
+    *message_number = 0;
+    return 0;
+}
+
+int messagereceiver_send_message_disposition(MESSAGE_RECEIVER_HANDLE message_receiver, const char* link_name, delivery_number message_number, AMQP_VALUE delivery_state)
+{
+    (void)message_receiver;
+    (void)link_name;
+    (void)message_number;
+    (void)delivery_state;
+    return 0;
+}
+
+AMQP_VALUE messaging_create_source(const char* address)
+{
+    (void)address;
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE messaging_create_target(const char* address)
+{
+    (void)address;
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE messaging_delivery_accepted(void)
+{
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE messaging_delivery_released(void)
+{
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE messaging_delivery_rejected(const char* error_condition, const char* error_description)
+{
+    (void)error_condition;
+    (void)error_description;
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE amqpvalue_create_map(void)
+{
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE amqpvalue_create_symbol(const char* value)
+{
+    (void)value;
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+AMQP_VALUE amqpvalue_create_string(const char* value)
+{
+    (void)value;
+    return FAKE_HANDLE(AMQP_VALUE);
+}
+
+int amqpvalue_set_map_value(AMQP_VALUE map, AMQP_VALUE key, AMQP_VALUE value)
+{
+    (void)map;
+    (void)key;
+    (void)value;
+    return 0;
+}
+
+void amqpvalue_destroy(AMQP_VALUE value)
+{
+    (void)value;
+}
+
+MESSAGE_HANDLE message_create(void)
+{
+    return FAKE_HANDLE(MESSAGE_HANDLE);
+}
+
+void message_destroy(MESSAGE_HANDLE message)
+{
+    (void)message;
+}
+
+int message_set_message_format(MESSAGE_HANDLE message, uint32_t message_format)
+{
+    (void)message;
+    (void)message_format;
+    return 0;
+}
+
+int message_add_body_amqp_data(MESSAGE_HANDLE message, BINARY_DATA amqp_data)
+{
+    (void)message;
+    (void)amqp_data;
+    return 0;
+}
+
+int message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_message, MESSAGE_HANDLE* uamqp_message)
+{
+    (void)iothub_message;
+    *uamqp_message = FAKE_HANDLE(MESSAGE_HANDLE);
+    return 0;
+}
+
+int message_create_uamqp_encoding_from_iothub_message(IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+{
+    (void)message_handle;
+    body_binary_data->bytes = NULL;
+    body_binary_data->length = 0;
+    return 0;
+}
+
+int IoTHubMessage_CreateFromUamqpMessage(MESSAGE_HANDLE uamqp_message, IOTHUB_MESSAGE_HANDLE* iothubclient_message)
+{
+    (void)uamqp_message;
+    (void)iothubclient_message;
+    return __LINE__;
+}
+
+static uint64_t get_time_ns(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/*the order only has to look random and be the same from one run to the next*/
+static uint64_t nextRandom(uint64_t* state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 11;
+}
+
+static void on_messenger_state_changed(void* context, MESSENGER_STATE previous_state, MESSENGER_STATE new_state)
+{
+    (void)context;
+    (void)previous_state;
+    messengerState = new_state;
+}
+
+static void on_event_send_complete(IOTHUB_MESSAGE_LIST* iothub_message_list, MESSENGER_EVENT_SEND_COMPLETE_RESULT messenger_event_send_complete_result, void* context)
+{
+    (void)iothub_message_list;
+    (void)context;
+    if (messenger_event_send_complete_result == MESSENGER_EVENT_SEND_COMPLETE_RESULT_OK)
+    {
+        completedEvents++;
+    }
+    else
+    {
+        failedEvents++;
+    }
+}
+
+static MESSENGER_HANDLE createStartedMessenger(void)
+{
+    MESSENGER_HANDLE result;
+    MESSENGER_CONFIG config;
+
+    config.device_id = "perfDevice";
+    config.iothub_host_fqdn = "perfhub.azure-devices.net";
+    config.on_state_changed_callback = on_messenger_state_changed;
+    config.on_state_changed_context = NULL;
+
+    if ((result = messenger_create(&config)) == NULL)
+    {
+        (void)printf("messenger_create failed\n");
+    }
+    else if (messenger_start(result, FAKE_HANDLE(SESSION_HANDLE)) != 0)
+    {
+        (void)printf("messenger_start failed\n");
+        messenger_destroy(result);
+        result = NULL;
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; (messengerState != MESSENGER_STATE_STARTED) && (i < MAX_START_ATTEMPTS); i++)
+        {
+            messenger_do_work(result);
+        }
+
+        if (messengerState != MESSENGER_STATE_STARTED)
+        {
+            (void)printf("the messenger did not start\n");
+            messenger_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+/*sends count events, window at a time, and completes each window in a shuffled order. Returns 0 and the time per
+event of each phase, or a non-zero value when an event is not sent or does not complete*/
+static int timeEvents(MESSENGER_HANDLE messenger, IOTHUB_MESSAGE_LIST* messages, size_t count, size_t window, size_t* order, PHASE_TIMES* times)
+{
+    int result = 0;
+    uint64_t state = 42;
+    size_t sent;
+
+    times->sendAsync = 0;
+    times->doWork = 0;
+    times->complete = 0;
+    completedEvents = 0;
+    failedEvents = 0;
+
+    for (sent = 0; (result == 0) && (sent < count); sent += window)
+    {
+        size_t inFlight = (count - sent < window) ? (count - sent) : window;
+        uint64_t start;
+        size_t i;
+
+        start = get_time_ns();
+        for (i = 0; i < inFlight; i++)
+        {
+            if (messenger_send_async(messenger, &messages[sent + i], on_event_send_complete, NULL) != 0)
+            {
+                break;
+            }
+        }
+        times->sendAsync += get_time_ns() - start;
+
+        if (i != inFlight)
+        {
+            (void)printf("messenger_send_async failed\n");
+            result = 1;
+        }
+        else
+        {
+            sentEventsCount = 0;
+
+            start = get_time_ns();
+            messenger_do_work(messenger);
+            times->doWork += get_time_ns() - start;
+
+            if (sentEventsCount != inFlight)
+            {
+                (void)printf("messenger_do_work sent %lu events instead of %lu\n", (unsigned long)sentEventsCount, (unsigned long)inFlight);
+                result = 1;
+            }
+            else
+            {
+                for (i = 0; i < inFlight; i++)
+                {
+                    order[i] = i;
+                }
+                for (i = inFlight; i > 1; i--)
+                {
+                    size_t j = (size_t)(nextRandom(&state) % i);
+                    size_t temp = order[i - 1];
+                    order[i - 1] = order[j];
+                    order[j] = temp;
+                }
+
+                start = get_time_ns();
+                for (i = 0; i < inFlight; i++)
+                {
+                    sentEvents[order[i]].on_send_complete(sentEvents[order[i]].context, MESSAGE_SEND_OK);
+                }
+                times->complete += get_time_ns() - start;
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        if ((completedEvents != count) || (failedEvents != 0))
+        {
+            (void)printf("%lu events completed and %lu failed out of %lu\n", (unsigned long)completedEvents, (unsigned long)failedEvents, (unsigned long)count);
+            result = 1;
+        }
+        else
+        {
+            times->sendAsync /= count;
+            times->doWork /= count;
+            times->complete /= count;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t count = 10000;
+
+    if ((argc == 3) && (strcmp(argv[1], "--events") == 0))
+    {
+        count = (size_t)strtoul(argv[2], NULL, 10);
+    }
+
+    if (((argc != 1) && (argc != 3)) || (count == 0))
+    {
+        (void)printf("usage: %s [--events N]\n", argv[0]);
+        result = 1;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_LIST* messages = (IOTHUB_MESSAGE_LIST*)calloc(count, sizeof(IOTHUB_MESSAGE_LIST));
+        size_t* order = (size_t*)malloc(count * sizeof(size_t));
+        sentEvents = (SENT_EVENT*)malloc(count * sizeof(SENT_EVENT));
+        sentEventsCapacity = count;
+
+        if ((messages == NULL) || (order == NULL) || (sentEvents == NULL))
+        {
+            (void)printf("unable to allocate %lu events\n", (unsigned long)count);
+            result = 1;
+        }
+        else
+        {
+            MESSENGER_HANDLE messenger;
+            size_t i;
+
+            for (i = 0; i < count; i++)
+            {
+                messages[i].messageHandle = FAKE_HANDLE(IOTHUB_MESSAGE_HANDLE);
+            }
+
+            if ((messenger = createStartedMessenger()) == NULL)
+            {
+                result = 1;
+            }
+            else
+            {
+                size_t smallWindow = (count < SMALL_WINDOW) ? count : SMALL_WINDOW;
+                PHASE_TIMES smallWindowTimes;
+                PHASE_TIMES fullWindowTimes;
+
+                if ((timeEvents(messenger, messages, count, smallWindow, order, &smallWindowTimes) != 0) ||
+                    (timeEvents(messenger, messages, count, count, order, &fullWindowTimes) != 0))
+                {
+                    result = 1;
+                }
+                else
+                {
+                    (void)printf("events=%lu", (unsigned long)count);
+                    (void)printf(" send_async_ns_in_flight_%lu=%lu do_work_ns_in_flight_%lu=%lu complete_ns_in_flight_%lu=%lu",
+                        (unsigned long)smallWindow, (unsigned long)smallWindowTimes.sendAsync,
+                        (unsigned long)smallWindow, (unsigned long)smallWindowTimes.doWork,
+                        (unsigned long)smallWindow, (unsigned long)smallWindowTimes.complete);
+                    (void)printf(" send_async_ns_in_flight_%lu=%lu do_work_ns_in_flight_%lu=%lu complete_ns_in_flight_%lu=%lu",
+                        (unsigned long)count, (unsigned long)fullWindowTimes.sendAsync,
+                        (unsigned long)count, (unsigned long)fullWindowTimes.doWork,
+                        (unsigned long)count, (unsigned long)fullWindowTimes.complete);
+                    (void)printf("\n");
+                    result = 0;
+                }
+
+                messenger_destroy(messenger);
+            }
+        }
+
+        free(sentEvents);
+        free(order);
+        free(messages);
+    }
+
+    return result;
+}
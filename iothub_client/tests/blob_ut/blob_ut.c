@@ -29,6 +29,8 @@ static void my_gballoc_free(void* s)
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
 #undef ENABLE_MOCKS
 
 #include "blob.h"
@@ -51,6 +53,15 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 
+TEST_DEFINE_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
+TEST_DEFINE_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#define TEST_LOCK_HANDLE ((LOCK_HANDLE)0x4242)
+#define TEST_THREAD_HANDLE ((THREAD_HANDLE)0x4243)
+
 static HTTPAPIEX_HANDLE my_HTTPAPIEX_Create(const char* hostName)
 {
     (void)hostName;
@@ -74,6 +85,19 @@ static void my_BUFFER_delete(BUFFER_HANDLE h)
     my_gballoc_free(h);
 }
 
+static BUFFER_HANDLE my_BUFFER_new(void)
+{
+    return (BUFFER_HANDLE)my_gballoc_malloc(1);
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    (void)func;
+    (void)arg;
+    *threadHandle = TEST_THREAD_HANDLE;
+    return THREADAPI_OK;
+}
+
 static HTTP_HEADERS_HANDLE my_HTTPHeaders_Alloc(void)
 {
     return (HTTP_HEADERS_HANDLE)my_gballoc_malloc(1);
@@ -167,6 +191,15 @@ TEST_SUITE_INITIALIZE(TestSuiteInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, "a");
     REGISTER_GLOBAL_MOCK_HOOK(STRING_delete, my_STRING_delete);
 
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, my_BUFFER_new);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_new, NULL);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_pre_build, __FAILURE__);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+
 
 
 
@@ -176,10 +209,15 @@ TEST_SUITE_INITIALIZE(TestSuiteInitialize)
 
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
 
     REGISTER_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE);
     REGISTER_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT);
     REGISTER_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
 
     testValidBufferHandle = BUFFER_create((const unsigned char*)"a", 1);
     ASSERT_IS_NOT_NULL(testValidBufferHandle);
@@ -1055,5 +1093,566 @@ TEST_FUNCTION(Blob_UploadFromSasUri_when_http_code_is_404_it_immediately_succeed
     
 }
 
+#define TEST_BLOCK_SIZE (4 * 1024 * 1024)
+#define TEST_MAX_READS 4
+
+static uint64_t readOffsets[TEST_MAX_READS];
+static size_t readSizes[TEST_MAX_READS];
+static size_t readCount;
+static int readResult;
+static unsigned int blockCallbackIds[TEST_MAX_READS];
+static size_t blockCallbackCount;
+
+static int test_readCallback(void* context, uint64_t offset, unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    ASSERT_IS_TRUE(readCount < TEST_MAX_READS);
+    readOffsets[readCount] = offset;
+    readSizes[readCount] = size;
+    readCount++;
+    return readResult;
+}
+
+static void test_blockCallback(void* context, unsigned int blockId)
+{
+    (void)context;
+    ASSERT_IS_TRUE(blockCallbackCount < TEST_MAX_READS);
+    blockCallbackIds[blockCallbackCount++] = blockId;
+}
+
+static void setup_multiple_blocks_test(IOTHUB_CLIENT_FILE_UPLOAD_SOURCE* source, uint64_t size, unsigned char* checkpoint)
+{
+    readCount = 0;
+    readResult = 0;
+    blockCallbackCount = 0;
+    source->size = size;
+    source->readCallback = test_readCallback;
+    source->readContext = NULL;
+    source->checkpoint = checkpoint;
+    source->blockCallback = test_blockCallback;
+    source->blockCallbackContext = NULL;
+}
+
+/*expectations of reading a block and sending it with Put Block, attempts - 1 of which are answered with retryStatus*/
+static void setup_put_block_expectations(size_t blockSize, int isLocked, size_t attempts, const unsigned int* retryStatus, const unsigned int* status)
+{
+    size_t attempt;
+    if (isLocked)
+    {
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    }
+    STRICT_EXPECTED_CALL(BUFFER_new()); /*this is the content of the block*/
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, blockSize))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG)) /*this is where readCallback puts the block*/
+        .IgnoreArgument_handle();
+    if (isLocked)
+    {
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    }
+
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 6)) /*this is the block ID*/
+        .IgnoreArgument_source();
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b")); /*this is building the relativePath*/
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=block&blockid="))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_s1()
+        .IgnoreArgument_s2();
+    for (attempt = 1; attempt <= attempts; attempt++)
+    {
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_relativePath()
+            .IgnoreArgument_requestContent()
+            .IgnoreArgument_statusCode()
+            .IgnoreArgument_responseContent()
+            .CopyOutArgumentBuffer_statusCode((attempt == attempts) ? status : retryStatus, sizeof(unsigned int));
+        if (attempt != attempts)
+        {
+            STRICT_EXPECTED_CALL(ThreadAPI_Sleep((unsigned int)(1000 * attempt)));
+        }
+    }
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*this is the relativePath*/
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*this is the block ID*/
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG)) /*this is the content of the block*/
+        .IgnoreArgument_handle();
+
+    if (isLocked)
+    {
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    }
+    if (*status >= 300)
+    {
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG)) /*the response of storage would be copied to httpResponse*/
+            .IgnoreArgument_handle();
+    }
+    if (isLocked)
+    {
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    }
+}
+
+static void setup_put_block_list_expectations(size_t blockCount)
+{
+    size_t blockId;
+    STRICT_EXPECTED_CALL(STRING_construct("<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n<BlockList>"));
+    for (blockId = 0; blockId < blockCount; blockId++)
+    {
+        STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 6))
+            .IgnoreArgument_source();
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "<Latest>"))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_s1()
+            .IgnoreArgument_s2();
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "</Latest>"))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+    }
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "</BlockList>"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b"));
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=blocklist"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)) /*this is the XML*/
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)) /*this is the relative path*/
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, &httpResponse, NULL, testValidBufferHandle))
+        .IgnoreArgument_handle()
+        .IgnoreArgument_relativePath()
+        .IgnoreArgument_requestContent()
+        .CopyOutArgumentBuffer_statusCode(&TwoHundred, sizeof(TwoHundred));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+}
+
+/*Tests_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_SasUri_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri(NULL, &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_source_fails)
+{
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", NULL, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_httpStatus_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 0, NULL, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_NULL_readCallback_and_non_zero_size_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+    source.readCallback = NULL;
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_001: [ If SASURI, source or httpStatus is NULL, if source has no readCallback while its size is not 0, or if parallelism is 0 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_with_zero_parallelism_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 0, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_002: [ If the size of source is bigger than 50000*4*1024*1024 then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_size_is_exceeded)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 50000ULL * TEST_BLOCK_SIZE + 1, NULL);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_003: [ If the hostname cannot be determined from SASURI then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_INVALID_ARG. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_when_SasUri_is_wrong_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h", &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_004: [ Blob_UploadMultipleBlocksFromSasUri shall create an HTTPAPIEX_HANDLE to the hostname, used by the calling thread for its blocks and for the block list. ]*/
+/*Tests_SRS_BLOB_01_007: [ The ID of a block shall be the BASE64 encoding of its zero based index printed on 6 digits (000000... 049999). ]*/
+/*Tests_SRS_BLOB_01_009: [ Blob_UploadMultipleBlocksFromSasUri shall read every block through readCallback, one block at a time and in increasing offset order. ]*/
+/*Tests_SRS_BLOB_01_011: [ Every block shall be uploaded by a PUT request to base relativePath + "&comp=block&blockid=" + the block ID. ]*/
+/*Tests_SRS_BLOB_01_015: [ Once storage has accepted a block its bit shall be set in the checkpoint and blockCallback, if any, shall be called with its ID, never concurrently. ]*/
+/*Tests_SRS_BLOB_01_016: [ After all the blocks have been accepted Blob_UploadMultipleBlocksFromSasUri shall PUT to base relativePath + "&comp=blocklist" the XML list of all the block IDs, in order, passing httpStatus and httpResponse. ]*/
+/*Tests_SRS_BLOB_01_018: [ Otherwise Blob_UploadMultipleBlocksFromSasUri shall succeed and return BLOB_OK. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_happy_path)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    unsigned char checkpoint[1] = { 0 };
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, TEST_BLOCK_SIZE + 1, checkpoint);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new()); /*this is the response of storage to Put Block*/
+    setup_put_block_expectations(TEST_BLOCK_SIZE, 0, 1, NULL, &TwoHundredOne);
+    setup_put_block_expectations(1, 0, 1, NULL, &TwoHundredOne);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL)); /*no threads*/
+    setup_put_block_list_expectations(2);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 3, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, readCount);
+    ASSERT_IS_TRUE(readOffsets[0] == 0);
+    ASSERT_ARE_EQUAL(size_t, TEST_BLOCK_SIZE, readSizes[0]);
+    ASSERT_IS_TRUE(readOffsets[1] == TEST_BLOCK_SIZE);
+    ASSERT_ARE_EQUAL(size_t, 1, readSizes[1]);
+    ASSERT_ARE_EQUAL(size_t, 2, blockCallbackCount);
+    ASSERT_ARE_EQUAL(int, 0, blockCallbackIds[0]);
+    ASSERT_ARE_EQUAL(int, 1, blockCallbackIds[1]);
+    ASSERT_ARE_EQUAL(int, 0x03, checkpoint[0]);
+}
+
+/*Tests_SRS_BLOB_01_008: [ Blocks whose bit is set in the checkpoint shall not be read nor uploaded. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_skips_blocks_in_the_checkpoint)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    unsigned char checkpoint[1] = { 0x01 };
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, TEST_BLOCK_SIZE + 1, checkpoint);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    setup_put_block_expectations(1, 0, 1, NULL, &TwoHundredOne);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    setup_put_block_list_expectations(2); /*the block list still has all the blocks*/
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 3, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, readCount);
+    ASSERT_IS_TRUE(readOffsets[0] == TEST_BLOCK_SIZE);
+    ASSERT_ARE_EQUAL(size_t, 1, blockCallbackCount);
+    ASSERT_ARE_EQUAL(int, 1, blockCallbackIds[0]);
+    ASSERT_ARE_EQUAL(int, 0x03, checkpoint[0]);
+}
+
+/*Tests_SRS_BLOB_01_012: [ If the request fails or storage answers 408, 429 or 5xx, the block shall be uploaded again, at most blockRetries more times, waiting a second longer before every retry. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_retries_a_block_when_storage_is_busy)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    const unsigned int FiveHundredThree = 503;
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    setup_put_block_expectations(1, 0, 3, &FiveHundredThree, &TwoHundredOne);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    setup_put_block_list_expectations(1);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 2, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_013: [ If a block still cannot be uploaded, Blob_UploadMultipleBlocksFromSasUri shall stop uploading and return BLOB_HTTP_ERROR when the request failed, or BLOB_OK with the HTTP status and response of storage otherwise. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_stops_when_storage_refuses_a_block)
+{
+    ///arrange
+    const unsigned int FourHundredThree = 403;
+    unsigned char checkpoint[1] = { 0 };
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, TEST_BLOCK_SIZE + 1, checkpoint);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    setup_put_block_expectations(TEST_BLOCK_SIZE, 0, 1, NULL, &FourHundredThree); /*403 is not retried*/
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 3, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 403, httpResponse);
+    ASSERT_ARE_EQUAL(size_t, 1, readCount);
+    ASSERT_ARE_EQUAL(size_t, 0, blockCallbackCount);
+    ASSERT_ARE_EQUAL(int, 0, checkpoint[0]);
+}
+
+/*Tests_SRS_BLOB_01_013: [ If a block still cannot be uploaded, Blob_UploadMultipleBlocksFromSasUri shall stop uploading and return BLOB_HTTP_ERROR when the request failed, or BLOB_OK with the HTTP status and response of storage otherwise. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_HTTPAPIEX_ExecuteRequest_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, 1))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 6))
+        .IgnoreArgument_source();
+    STRICT_EXPECTED_CALL(STRING_construct("/something?a=b"));
+    STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "&comp=block&blockid="))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_s1()
+        .IgnoreArgument_s2();
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+        .IgnoreArgument_handle()
+        .IgnoreArgument_relativePath()
+        .IgnoreArgument_requestContent()
+        .IgnoreArgument_statusCode()
+        .IgnoreArgument_responseContent()
+        .SetReturn(HTTPAPIEX_ERROR);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_HTTP_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_010: [ If readCallback fails then Blob_UploadMultipleBlocksFromSasUri shall fail and return BLOB_ERROR. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_fails_when_readCallback_fails)
+{
+    ///arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, 1, NULL);
+    readResult = 1;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_pre_build(IGNORED_PTR_ARG, 1))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 1, 0, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, readCount);
+}
+
+/*Tests_SRS_BLOB_01_005: [ When parallelism and the number of blocks are both bigger than 1, Blob_UploadMultipleBlocksFromSasUri shall start up to parallelism - 1 threads that upload blocks alongside the calling thread. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_starts_threads)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, TEST_BLOCK_SIZE + 1, NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(THREAD_HANDLE))); /*2 blocks, so only 1 more thread even if parallelism is 4*/
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    /*the mocked thread does nothing, the calling thread uploads everything*/
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    setup_put_block_expectations(TEST_BLOCK_SIZE, 1, 1, NULL, &TwoHundredOne);
+    setup_put_block_expectations(1, 1, 1, NULL, &TwoHundredOne);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_res();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    setup_put_block_list_expectations(2);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 4, 3, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_BLOB_01_005: [ When parallelism and the number of blocks are both bigger than 1, Blob_UploadMultipleBlocksFromSasUri shall start up to parallelism - 1 threads that upload blocks alongside the calling thread. ]*/
+TEST_FUNCTION(Blob_UploadMultipleBlocksFromSasUri_uploads_alone_when_ThreadAPI_Create_fails)
+{
+    ///arrange
+    const unsigned int TwoHundredOne = 201;
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source;
+    setup_multiple_blocks_test(&source, TEST_BLOCK_SIZE + 1, NULL);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen("h.h") + 1));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create("h.h"));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(THREAD_HANDLE)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    setup_put_block_expectations(TEST_BLOCK_SIZE, 1, 1, NULL, &TwoHundredOne);
+    setup_put_block_expectations(1, 1, 1, NULL, &TwoHundredOne);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    setup_put_block_list_expectations(2);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+
+    ///act
+    BLOB_RESULT result = Blob_UploadMultipleBlocksFromSasUri("https://h.h/something?a=b", &source, 4, 3, &httpResponse, testValidBufferHandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(BLOB_RESULT, BLOB_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
 END_TEST_SUITE(blob_ut);
@@ -0,0 +1,611 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void* real_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_outbound_store.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_STORE_PATH                     "outbound_store_ut"
+#define TEST_SEGMENT_SIZE                   ((size_t)4096)
+#define TEST_SMALL_SEGMENT_SIZE             ((size_t)100)
+#define TEST_RECORD_HEADER_SIZE             24
+#define TEST_MAX_SEGMENTS                   16
+#define TEST_MAX_REPLAYED                   16
+
+static const unsigned char TEST_PAYLOAD_A[] = "first event...";
+static const unsigned char TEST_PAYLOAD_B[] = "second event..";
+static const unsigned char TEST_PAYLOAD_C[] = "third event...";
+
+static size_t replayed_count;
+static uint64_t replayed_sequences[TEST_MAX_REPLAYED];
+static unsigned char replayed_first_bytes[TEST_MAX_REPLAYED];
+static size_t replayed_sizes[TEST_MAX_REPLAYED];
+static bool release_on_replay;
+
+
+// Helpers
+
+static void on_record(void* context, uint64_t sequence, const unsigned char* data, size_t size)
+{
+    if (replayed_count < TEST_MAX_REPLAYED)
+    {
+        replayed_sequences[replayed_count] = sequence;
+        replayed_first_bytes[replayed_count] = (size > 0) ? data[0] : 0;
+        replayed_sizes[replayed_count] = size;
+        replayed_count++;
+    }
+
+    if (release_on_replay)
+    {
+        ASSERT_ARE_EQUAL(int, 0, outbound_store_release((OUTBOUND_STORE_HANDLE)context, sequence));
+    }
+}
+
+static const char* get_segment_name(char* buffer, unsigned long segment)
+{
+    (void)sprintf(buffer, "%s.%lu", TEST_STORE_PATH, segment);
+    return buffer;
+}
+
+static bool segment_exists(unsigned long segment)
+{
+    char name[64];
+    FILE* file = fopen(get_segment_name(name, segment), "rb");
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    return (file != NULL);
+}
+
+static void remove_store_files(void)
+{
+    char name[64];
+    unsigned long segment;
+    for (segment = 0; segment < TEST_MAX_SEGMENTS; segment++)
+    {
+        (void)remove(get_segment_name(name, segment));
+    }
+    (void)remove(TEST_STORE_PATH ".head");
+    (void)remove(TEST_STORE_PATH ".head.tmp");
+}
+
+static OUTBOUND_STORE_HANDLE open_and_replay(size_t segment_size)
+{
+    OUTBOUND_STORE_HANDLE handle = outbound_store_open(TEST_STORE_PATH, segment_size);
+    ASSERT_IS_NOT_NULL(handle);
+    replayed_count = 0;
+    ASSERT_ARE_EQUAL(int, 0, outbound_store_replay(handle, on_record, handle));
+    return handle;
+}
+
+static uint64_t append_payload(OUTBOUND_STORE_HANDLE handle, const unsigned char* payload)
+{
+    uint64_t sequence = 0;
+    ASSERT_ARE_EQUAL(int, 0, outbound_store_append(handle, payload, strlen((const char*)payload), &sequence));
+    return sequence;
+}
+
+static void patch_segment(unsigned long segment, long offset, unsigned char value)
+{
+    char name[64];
+    FILE* file = fopen(get_segment_name(name, segment), "r+b");
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_EQUAL(int, 0, fseek(file, offset, SEEK_SET));
+    ASSERT_ARE_EQUAL(int, 1, (int)fwrite(&value, 1, 1, file));
+    (void)fclose(file);
+}
+
+static void append_to_segment(unsigned long segment, const unsigned char* data, size_t size)
+{
+    char name[64];
+    FILE* file = fopen(get_segment_name(name, segment), "ab");
+    ASSERT_IS_NOT_NULL(file);
+    ASSERT_ARE_EQUAL(int, (int)size, (int)fwrite(data, 1, size, file));
+    (void)fclose(file);
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_outbound_store_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    remove_store_files();
+    replayed_count = 0;
+    release_on_replay = false;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    remove_store_files();
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_001: [ If path is NULL or segment_size is 0 or too large to be addressed with 32 bits, outbound_store_open shall fail and return NULL. ]
+TEST_FUNCTION(outbound_store_open_NULL_path_fails)
+{
+    // arrange
+
+    // act
+    OUTBOUND_STORE_HANDLE handle = outbound_store_open(NULL, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_001: [ If path is NULL or segment_size is 0 or too large to be addressed with 32 bits, outbound_store_open shall fail and return NULL. ]
+TEST_FUNCTION(outbound_store_open_zero_segment_size_fails)
+{
+    // arrange
+
+    // act
+    OUTBOUND_STORE_HANDLE handle = outbound_store_open(TEST_STORE_PATH, 0);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(outbound_store_open_malloc_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    OUTBOUND_STORE_HANDLE handle = outbound_store_open(TEST_STORE_PATH, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_003: [ outbound_store_open shall always append to a new segment, so a record cut short by a crash is never followed by new records. ]
+TEST_FUNCTION(outbound_store_open_empty_store_succeeds)
+{
+    // arrange
+
+    // act
+    OUTBOUND_STORE_HANDLE handle = outbound_store_open(TEST_STORE_PATH, TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(int, 0, (int)outbound_store_get_pending_count(handle));
+    ASSERT_IS_TRUE(segment_exists(0));
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_002: [ outbound_store_open shall read every segment left by a previous instance, verify the checksum of every record and keep the data records that were not released as pending. ]
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_004: [ outbound_store_replay shall call on_record for every pending record, in the order they were appended. on_record may release the record it is given. ]
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_010: [ outbound_store_close shall commit the records not committed yet, close the active segment and free all the resources. The segments stay on disk. ]
+TEST_FUNCTION(outbound_store_open_replays_pending_records_in_order)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    uint64_t sequence_c = append_payload(handle, TEST_PAYLOAD_C);
+    outbound_store_close(handle);
+
+    // act
+    handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_IS_TRUE(sequence_a < sequence_b);
+    ASSERT_IS_TRUE(sequence_b < sequence_c);
+    ASSERT_ARE_EQUAL(int, 3, (int)outbound_store_get_pending_count(handle));
+    ASSERT_ARE_EQUAL(int, 3, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_a);
+    ASSERT_IS_TRUE(replayed_sequences[1] == sequence_b);
+    ASSERT_IS_TRUE(replayed_sequences[2] == sequence_c);
+    ASSERT_ARE_EQUAL(int, (int)TEST_PAYLOAD_A[0], (int)replayed_first_bytes[0]);
+    ASSERT_ARE_EQUAL(int, (int)strlen((const char*)TEST_PAYLOAD_B), (int)replayed_sizes[1]);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_007: [ outbound_store_release shall append a release record for sequence, and delete the oldest segments once none of their records is pending. ]
+TEST_FUNCTION(outbound_store_released_records_are_not_replayed)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    uint64_t sequence_c = append_payload(handle, TEST_PAYLOAD_C);
+
+    // act
+    int result = outbound_store_release(handle, sequence_b);
+    outbound_store_close(handle);
+    handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 2, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_a);
+    ASSERT_IS_TRUE(replayed_sequences[1] == sequence_c);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_004: [ outbound_store_replay shall call on_record for every pending record, in the order they were appended. on_record may release the record it is given. ]
+TEST_FUNCTION(outbound_store_replay_on_record_can_release)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    (void)append_payload(handle, TEST_PAYLOAD_A);
+    (void)append_payload(handle, TEST_PAYLOAD_B);
+    release_on_replay = true;
+
+    // act
+    replayed_count = 0;
+    int result = outbound_store_replay(handle, on_record, handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 2, (int)replayed_count);
+    ASSERT_ARE_EQUAL(int, 0, (int)outbound_store_get_pending_count(handle));
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_013: [ If handle, sequence or on_record is NULL, outbound_store_read shall fail and return a non-zero value. ]
+TEST_FUNCTION(outbound_store_read_NULL_sequence_fails)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // act
+    int result = outbound_store_read(handle, NULL, 1, on_record, handle);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_014: [ outbound_store_read shall call on_record, in order, for at most max_count pending records whose sequence is not smaller than *sequence, and set *sequence past the last record it read. on_record may release the record it is given. ]
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_015: [ When fewer than max_count records were read, outbound_store_read shall set *sequence to the sequence the next outbound_store_append returns. ]
+TEST_FUNCTION(outbound_store_read_reads_the_pending_records_in_windows)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    uint64_t sequence_c = append_payload(handle, TEST_PAYLOAD_C);
+    uint64_t cursor = 0;
+
+    // act
+    replayed_count = 0;
+    int first_result = outbound_store_read(handle, &cursor, 2, on_record, handle);
+    size_t first_count = replayed_count;
+    uint64_t first_cursor = cursor;
+    replayed_count = 0;
+    int second_result = outbound_store_read(handle, &cursor, 2, on_record, handle);
+    uint64_t sequence_d = append_payload(handle, TEST_PAYLOAD_A);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, first_result);
+    ASSERT_ARE_EQUAL(int, 2, (int)first_count);
+    ASSERT_IS_TRUE(first_cursor == sequence_b + 1);
+    ASSERT_ARE_EQUAL(int, 0, second_result);
+    ASSERT_ARE_EQUAL(int, 1, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_c);
+    ASSERT_IS_TRUE(cursor == sequence_d);
+    ASSERT_IS_TRUE(sequence_a < sequence_b);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_002: [ outbound_store_open shall read every segment left by a previous instance, verify the checksum of every record and keep the data records that were not released as pending. ]
+TEST_FUNCTION(outbound_store_open_ignores_torn_record)
+{
+    // arrange
+    static const unsigned char torn_header[] = { 0x4F, 0x54, 0x42, 0x53, 0x01, 0x00 };
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    outbound_store_close(handle);
+    append_to_segment(0, torn_header, sizeof(torn_header));
+
+    // act
+    handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    outbound_store_close(handle);
+    handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_a);
+    ASSERT_IS_TRUE(replayed_sequences[1] == sequence_b);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_002: [ outbound_store_open shall read every segment left by a previous instance, verify the checksum of every record and keep the data records that were not released as pending. ]
+TEST_FUNCTION(outbound_store_open_ignores_corrupted_record)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    (void)append_payload(handle, TEST_PAYLOAD_B);
+    outbound_store_close(handle);
+    patch_segment(0, (long)(TEST_RECORD_HEADER_SIZE + strlen((const char*)TEST_PAYLOAD_A) + TEST_RECORD_HEADER_SIZE), 'X');
+
+    // act
+    handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_a);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_005: [ outbound_store_append shall write a data record at the end of the active segment, starting a new segment when the record would not fit, and return its sequence number. The record is durable once outbound_store_commit returns. ]
+TEST_FUNCTION(outbound_store_append_NULL_sequence_fails)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+
+    // act
+    int result = outbound_store_append(handle, TEST_PAYLOAD_A, sizeof(TEST_PAYLOAD_A), NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, (int)outbound_store_get_pending_count(handle));
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_005: [ outbound_store_append shall write a data record at the end of the active segment, starting a new segment when the record would not fit, and return its sequence number. The record is durable once outbound_store_commit returns. ]
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_007: [ outbound_store_release shall append a release record for sequence, and delete the oldest segments once none of their records is pending. ]
+TEST_FUNCTION(outbound_store_release_removes_fully_released_segment)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SMALL_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    uint64_t sequence_c = append_payload(handle, TEST_PAYLOAD_C);
+    ASSERT_IS_TRUE(segment_exists(1));
+
+    // act
+    int result_a = outbound_store_release(handle, sequence_a);
+    int result_b = outbound_store_release(handle, sequence_b);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_a);
+    ASSERT_ARE_EQUAL(int, 0, result_b);
+    ASSERT_IS_FALSE(segment_exists(0));
+    ASSERT_ARE_EQUAL(int, 1, (int)outbound_store_get_pending_count(handle));
+    outbound_store_close(handle);
+    handle = open_and_replay(TEST_SMALL_SEGMENT_SIZE);
+    ASSERT_ARE_EQUAL(int, 1, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_c);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_008: [ If sequence is not pending, outbound_store_release shall fail and return a non-zero value. ]
+TEST_FUNCTION(outbound_store_release_twice_fails)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    ASSERT_ARE_EQUAL(int, 0, outbound_store_release(handle, sequence_a));
+
+    // act
+    int result = outbound_store_release(handle, sequence_a);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_008: [ If sequence is not pending, outbound_store_release shall fail and return a non-zero value. ]
+TEST_FUNCTION(outbound_store_release_unknown_sequence_fails)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+
+    // act
+    int result = outbound_store_release(handle, sequence_a + 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 1, (int)outbound_store_get_pending_count(handle));
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_006: [ outbound_store_commit shall flush and sync the active segment once for all the records written since the previous commit, and do nothing if there were none. ]
+TEST_FUNCTION(outbound_store_commit_succeeds)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    (void)append_payload(handle, TEST_PAYLOAD_A);
+    (void)append_payload(handle, TEST_PAYLOAD_B);
+
+    // act
+    int result = outbound_store_commit(handle);
+    int second_result = outbound_store_commit(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, second_result);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+TEST_FUNCTION(outbound_store_commit_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = outbound_store_commit(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_009: [ When the oldest segment is sealed and less than a quarter of segment_size of it is pending, outbound_store_compact shall copy its pending records to the active segment, sync it and delete the oldest segment. ]
+TEST_FUNCTION(outbound_store_compact_moves_live_records_forward)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SMALL_SEGMENT_SIZE);
+    uint64_t sequence_a = append_payload(handle, TEST_PAYLOAD_A);
+    uint64_t sequence_b = append_payload(handle, TEST_PAYLOAD_B);
+    uint64_t sequence_c = append_payload(handle, TEST_PAYLOAD_C);
+    ASSERT_ARE_EQUAL(int, 0, outbound_store_release(handle, sequence_b));
+    ASSERT_IS_TRUE(segment_exists(0));
+
+    // act
+    int result = outbound_store_compact(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(segment_exists(0));
+    ASSERT_ARE_EQUAL(int, 2, (int)outbound_store_get_pending_count(handle));
+    outbound_store_close(handle);
+    handle = open_and_replay(TEST_SMALL_SEGMENT_SIZE);
+    ASSERT_ARE_EQUAL(int, 2, (int)replayed_count);
+    ASSERT_IS_TRUE(replayed_sequences[0] == sequence_a);
+    ASSERT_IS_TRUE(replayed_sequences[1] == sequence_c);
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_OUTBOUND_STORE_01_009: [ When the oldest segment is sealed and less than a quarter of segment_size of it is pending, outbound_store_compact shall copy its pending records to the active segment, sync it and delete the oldest segment. ]
+TEST_FUNCTION(outbound_store_compact_keeps_active_segment)
+{
+    // arrange
+    OUTBOUND_STORE_HANDLE handle = open_and_replay(TEST_SEGMENT_SIZE);
+    (void)append_payload(handle, TEST_PAYLOAD_A);
+
+    // act
+    int result = outbound_store_compact(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(segment_exists(0));
+    ASSERT_ARE_EQUAL(int, 1, (int)outbound_store_get_pending_count(handle));
+
+    // cleanup
+    outbound_store_close(handle);
+}
+
+TEST_FUNCTION(outbound_store_get_pending_count_NULL_handle_returns_0)
+{
+    // arrange
+
+    // act
+    size_t result = outbound_store_get_pending_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, (int)result);
+}
+
+END_TEST_SUITE(iothub_client_outbound_store_ut)
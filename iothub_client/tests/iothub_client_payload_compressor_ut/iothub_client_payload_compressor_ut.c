@@ -0,0 +1,447 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void* real_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+#include "zlib.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_payload_compressor.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_MAX_PAYLOAD_SIZE               1024
+#define TEST_LARGE_DICTIONARY_SIZE          40000
+
+static const char TEST_EVENT[] = "{\"deviceId\":\"myFirstDevice\",\"windSpeed\":10.5,\"temperature\":21.25,\"humidity\":62.5,\"status\":\"running\"}";
+static const char TEST_DICTIONARY[] = "{\"deviceId\":\"myFirstDevice\",\"windSpeed\":,\"temperature\":,\"humidity\":,\"status\":\"running\"}";
+
+static unsigned char inflated[TEST_MAX_PAYLOAD_SIZE];
+
+
+// Helpers
+
+static size_t inflate_payload(const unsigned char* compressed, size_t compressed_size, const unsigned char* dictionary, size_t dictionary_size)
+{
+    z_stream stream;
+    int inflate_result;
+
+    (void)memset(&stream, 0, sizeof(stream));
+    ASSERT_ARE_EQUAL(int, Z_OK, inflateInit(&stream));
+    stream.next_in = (Bytef*)compressed;
+    stream.avail_in = (uInt)compressed_size;
+    stream.next_out = inflated;
+    stream.avail_out = (uInt)sizeof(inflated);
+
+    inflate_result = inflate(&stream, Z_FINISH);
+    if (inflate_result == Z_NEED_DICT)
+    {
+        ASSERT_IS_NOT_NULL(dictionary);
+        ASSERT_ARE_EQUAL(int, Z_OK, inflateSetDictionary(&stream, dictionary, (uInt)dictionary_size));
+        inflate_result = inflate(&stream, Z_FINISH);
+    }
+    ASSERT_ARE_EQUAL(int, Z_STREAM_END, inflate_result);
+    ASSERT_ARE_EQUAL(int, 0, (int)stream.avail_in);
+    (void)inflateEnd(&stream);
+
+    return (size_t)stream.total_out;
+}
+
+static void fill_with_noise(unsigned char* buffer, size_t size)
+{
+    uint32_t state = 0x12345678;
+    size_t i;
+    for (i = 0; i < size; i++)
+    {
+        state = state * 1103515245 + 12345;
+        buffer[i] = (unsigned char)(state >> 24);
+    }
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_payload_compressor_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    (void)memset(inflated, 0, sizeof(inflated));
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_001: [ If dictionary is NULL while dictionary_size is not 0, payload_compressor_create shall fail and return NULL. ]
+TEST_FUNCTION(payload_compressor_create_NULL_dictionary_with_size_fails)
+{
+    // arrange
+
+    // act
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 1);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_003: [ If any allocation fails, payload_compressor_create shall fail and return NULL. ]
+TEST_FUNCTION(payload_compressor_create_malloc_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_003: [ If any allocation fails, payload_compressor_create shall fail and return NULL. ]
+TEST_FUNCTION(payload_compressor_create_dictionary_malloc_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(TEST_DICTIONARY) - 1))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create((const unsigned char*)TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_004: [ payload_compressor_create shall initialize a single deflate stream with the default compression level and a 32KB window. ]
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_007: [ payload_compressor_deflate shall compress source in a single deflate call, with the dictionary when one was given, and return in compressed and compressed_size the zlib stream, which stays valid until the next call. ]
+TEST_FUNCTION(payload_compressor_deflate_round_trips)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    char source[4 * sizeof(TEST_EVENT)];
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    (void)sprintf(source, "[%s,%s,%s]", TEST_EVENT, TEST_EVENT, TEST_EVENT);
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)source, strlen(source), &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(compressed);
+    ASSERT_IS_TRUE(compressed_size < strlen(source));
+    ASSERT_ARE_EQUAL(int, (int)strlen(source), (int)inflate_payload(compressed, compressed_size, NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(inflated, source, strlen(source)));
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_007: [ payload_compressor_deflate shall compress source in a single deflate call, with the dictionary when one was given, and return in compressed and compressed_size the zlib stream, which stays valid until the next call. ]
+TEST_FUNCTION(payload_compressor_deflate_with_dictionary_round_trips_and_is_smaller)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    size_t plain_compressed_size = 0;
+    PAYLOAD_COMPRESSOR_HANDLE plain = payload_compressor_create(NULL, 0);
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create((const unsigned char*)TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+    ASSERT_IS_NOT_NULL(plain);
+    ASSERT_IS_NOT_NULL(handle);
+    if (payload_compressor_deflate(plain, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size) == 0)
+    {
+        plain_compressed_size = compressed_size;
+    }
+    else
+    {
+        plain_compressed_size = sizeof(TEST_EVENT) - 1;
+    }
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(compressed_size < plain_compressed_size);
+    /*FDICT is set in the zlib header*/
+    ASSERT_ARE_EQUAL(int, 0x20, compressed[1] & 0x20);
+    ASSERT_ARE_EQUAL(int, (int)(sizeof(TEST_EVENT) - 1), (int)inflate_payload(compressed, compressed_size, (const unsigned char*)TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(inflated, TEST_EVENT, sizeof(TEST_EVENT) - 1));
+
+    // cleanup
+    payload_compressor_destroy(handle);
+    payload_compressor_destroy(plain);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_002: [ payload_compressor_create shall keep a copy of at most the last 32KB of dictionary. ]
+TEST_FUNCTION(payload_compressor_create_keeps_the_last_32KB_of_the_dictionary)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    unsigned char* dictionary = (unsigned char*)real_malloc(TEST_LARGE_DICTIONARY_SIZE);
+    ASSERT_IS_NOT_NULL(dictionary);
+    fill_with_noise(dictionary, TEST_LARGE_DICTIONARY_SIZE);
+    (void)memcpy(dictionary + TEST_LARGE_DICTIONARY_SIZE - (sizeof(TEST_DICTIONARY) - 1), TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(dictionary, TEST_LARGE_DICTIONARY_SIZE);
+    ASSERT_IS_NOT_NULL(handle);
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)(sizeof(TEST_EVENT) - 1), (int)inflate_payload(compressed, compressed_size, dictionary + TEST_LARGE_DICTIONARY_SIZE - 32768, 32768));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(inflated, TEST_EVENT, sizeof(TEST_EVENT) - 1));
+
+    // cleanup
+    payload_compressor_destroy(handle);
+    real_free(dictionary);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_006: [ If the zlib stream of source would not be smaller than size bytes, payload_compressor_deflate shall return a non-zero value without logging an error. ]
+TEST_FUNCTION(payload_compressor_deflate_incompressible_source_returns_non_zero)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    unsigned char source[256];
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    fill_with_noise(source, sizeof(source));
+
+    // act
+    int result = payload_compressor_deflate(handle, source, sizeof(source), &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_006: [ If the zlib stream of source would not be smaller than size bytes, payload_compressor_deflate shall return a non-zero value without logging an error. ]
+TEST_FUNCTION(payload_compressor_deflate_1_byte_returns_non_zero)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_008: [ The output buffer shall be reused across calls and only grown when source is larger than any previous one. ]
+TEST_FUNCTION(payload_compressor_deflate_reuses_the_output_buffer)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create((const unsigned char*)TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1);
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(int, 0, payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size));
+    umock_c_reset_all_calls();
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)(sizeof(TEST_EVENT) - 1), (int)inflate_payload(compressed, compressed_size, (const unsigned char*)TEST_DICTIONARY, sizeof(TEST_DICTIONARY) - 1));
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_009: [ If any zlib call or allocation fails, payload_compressor_deflate shall fail and return a non-zero value. ]
+TEST_FUNCTION(payload_compressor_deflate_realloc_fails)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(TEST_EVENT) - 2))
+        .SetReturn(NULL);
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_005: [ If handle, compressed or compressed_size is NULL, or source is NULL while size is not 0, payload_compressor_deflate shall fail and return a non-zero value. ]
+TEST_FUNCTION(payload_compressor_deflate_NULL_handle_fails)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+
+    // act
+    int result = payload_compressor_deflate(NULL, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_005: [ If handle, compressed or compressed_size is NULL, or source is NULL while size is not 0, payload_compressor_deflate shall fail and return a non-zero value. ]
+TEST_FUNCTION(payload_compressor_deflate_NULL_source_fails)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    size_t compressed_size = 0;
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = payload_compressor_deflate(handle, NULL, 10, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_005: [ If handle, compressed or compressed_size is NULL, or source is NULL while size is not 0, payload_compressor_deflate shall fail and return a non-zero value. ]
+TEST_FUNCTION(payload_compressor_deflate_NULL_compressed_size_fails)
+{
+    // arrange
+    const unsigned char* compressed = NULL;
+    PAYLOAD_COMPRESSOR_HANDLE handle = payload_compressor_create(NULL, 0);
+    ASSERT_IS_NOT_NULL(handle);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = payload_compressor_deflate(handle, (const unsigned char*)TEST_EVENT, sizeof(TEST_EVENT) - 1, &compressed, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    payload_compressor_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_PAYLOAD_COMPRESSOR_01_010: [ If handle is NULL, payload_compressor_destroy shall do nothing. ]
+TEST_FUNCTION(payload_compressor_destroy_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    payload_compressor_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothub_client_payload_compressor_ut)
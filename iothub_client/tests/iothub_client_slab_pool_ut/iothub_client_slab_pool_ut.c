@@ -0,0 +1,452 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdbool>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes.h"
+#include "umocktypes_c.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_slab_pool.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+
+// Data definitions
+
+#define TEST_ITEM_SIZE                      ((size_t)20)
+#define TEST_CAPACITY                       ((size_t)4)
+#define TEST_STEADY_STATE_ROUNDS            1000
+
+typedef struct TEST_RECORD_TAG
+{
+    char tag;
+    uint64_t value;
+} TEST_RECORD;
+
+
+// Helpers
+
+static SLAB_POOL_HANDLE create_pool(size_t item_size, size_t capacity)
+{
+    SLAB_POOL_HANDLE handle = slab_pool_create(item_size, capacity);
+    ASSERT_IS_NOT_NULL(handle);
+    umock_c_reset_all_calls();
+    return handle;
+}
+
+
+BEGIN_TEST_SUITE(iothub_client_slab_pool_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    int result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_001: [ If item_size or capacity is 0, slab_pool_create shall fail and return NULL. ]
+TEST_FUNCTION(slab_pool_create_zero_item_size_fails)
+{
+    // arrange
+
+    // act
+    SLAB_POOL_HANDLE handle = slab_pool_create(0, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_001: [ If item_size or capacity is 0, slab_pool_create shall fail and return NULL. ]
+TEST_FUNCTION(slab_pool_create_zero_capacity_fails)
+{
+    // arrange
+
+    // act
+    SLAB_POOL_HANDLE handle = slab_pool_create(TEST_ITEM_SIZE, 0);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_003: [ If the size of the pool cannot be represented in a size_t, slab_pool_create shall fail and return NULL. ]
+TEST_FUNCTION(slab_pool_create_too_large_fails)
+{
+    // arrange
+
+    // act
+    SLAB_POOL_HANDLE handle1 = slab_pool_create(TEST_ITEM_SIZE, SIZE_MAX / TEST_ITEM_SIZE);
+    SLAB_POOL_HANDLE handle2 = slab_pool_create(SIZE_MAX, 1);
+
+    // assert
+    ASSERT_IS_NULL(handle1);
+    ASSERT_IS_NULL(handle2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_005: [ If the allocation fails, slab_pool_create shall fail and return NULL. ]
+TEST_FUNCTION(slab_pool_create_malloc_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    SLAB_POOL_HANDLE handle = slab_pool_create(TEST_ITEM_SIZE, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_004: [ slab_pool_create shall allocate the pool and its capacity items with a single allocation. ]
+TEST_FUNCTION(slab_pool_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    SLAB_POOL_HANDLE handle = slab_pool_create(TEST_ITEM_SIZE, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, (int)slab_pool_get_heap_allocation_count(handle));
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_006: [ If handle is NULL, slab_pool_alloc shall fail and return NULL. ]
+TEST_FUNCTION(slab_pool_alloc_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    void* item = slab_pool_alloc(NULL);
+
+    // assert
+    ASSERT_IS_NULL(item);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_002: [ slab_pool_create shall round item_size up so that every item is aligned for any type and can hold the free list link. ]
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_007: [ slab_pool_alloc shall return a free item of the pool without allocating memory. ]
+TEST_FUNCTION(slab_pool_alloc_returns_distinct_aligned_items_without_allocating)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(sizeof(TEST_RECORD) + 1, TEST_CAPACITY);
+    TEST_RECORD* items[TEST_CAPACITY];
+    size_t i;
+    size_t j;
+
+    // act
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        items[i] = (TEST_RECORD*)slab_pool_alloc(handle);
+        ASSERT_IS_NOT_NULL(items[i]);
+        memset(items[i], (int)i, sizeof(TEST_RECORD) + 1);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, (int)((uintptr_t)items[i] % sizeof(uint64_t)));
+        ASSERT_ARE_EQUAL(int, (int)i, (int)((unsigned char*)items[i])[sizeof(TEST_RECORD)]);
+        for (j = i + 1; j < TEST_CAPACITY; j++)
+        {
+            ASSERT_ARE_NOT_EQUAL(void_ptr, items[i], items[j]);
+        }
+    }
+    ASSERT_ARE_EQUAL(int, 0, (int)slab_pool_get_heap_allocation_count(handle));
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_002: [ slab_pool_create shall round item_size up so that every item is aligned for any type and can hold the free list link. ]
+TEST_FUNCTION(slab_pool_items_smaller_than_a_pointer_succeed)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(1, 2);
+
+    // act
+    void* item1 = slab_pool_alloc(handle);
+    void* item2 = slab_pool_alloc(handle);
+    slab_pool_free(handle, item1);
+    slab_pool_free(handle, item2);
+    void* item3 = slab_pool_alloc(handle);
+    void* item4 = slab_pool_alloc(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, item2, item3);
+    ASSERT_ARE_EQUAL(void_ptr, item1, item4);
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_008: [ When all the items of the pool are in use, slab_pool_alloc shall allocate the item with malloc and count the allocation. ]
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_014: [ slab_pool_get_heap_allocation_count shall return the number of items slab_pool_alloc allocated with malloc since the pool was created. ]
+TEST_FUNCTION(slab_pool_alloc_exhausted_pool_allocates_from_the_heap)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, 1);
+    void* item1 = slab_pool_alloc(handle);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    void* item2 = slab_pool_alloc(handle);
+
+    // assert
+    ASSERT_IS_NOT_NULL(item2);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, item1, item2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, (int)slab_pool_get_heap_allocation_count(handle));
+
+    // cleanup
+    slab_pool_free(handle, item2);
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_009: [ If that allocation fails, slab_pool_alloc shall return NULL. ]
+TEST_FUNCTION(slab_pool_alloc_exhausted_pool_malloc_fails)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, 1);
+    (void)slab_pool_alloc(handle);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    void* item = slab_pool_alloc(handle);
+
+    // assert
+    ASSERT_IS_NULL(item);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, (int)slab_pool_get_heap_allocation_count(handle));
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_010: [ If handle or item is NULL, slab_pool_free shall do nothing. ]
+TEST_FUNCTION(slab_pool_free_NULL_arguments_do_nothing)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, 1);
+    void* item = slab_pool_alloc(handle);
+
+    // act
+    slab_pool_free(NULL, item);
+    slab_pool_free(handle, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    slab_pool_free(handle, item);
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_011: [ An item of the pool shall be put back in the pool. ]
+TEST_FUNCTION(slab_pool_free_pool_item_puts_it_back)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, 1);
+    void* item1 = slab_pool_alloc(handle);
+
+    // act
+    slab_pool_free(handle, item1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, item1, slab_pool_alloc(handle));
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_012: [ An item allocated by slab_pool_alloc with malloc shall be freed. ]
+TEST_FUNCTION(slab_pool_free_heap_item_frees_it)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, 1);
+    void* item1 = slab_pool_alloc(handle);
+    void* item2 = slab_pool_alloc(handle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(item2));
+
+    // act
+    slab_pool_free(handle, item2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // the heap item did not join the pool
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    slab_pool_free(handle, item1);
+    ASSERT_ARE_EQUAL(void_ptr, item1, slab_pool_alloc(handle));
+    void* item3 = slab_pool_alloc(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    slab_pool_free(handle, item3);
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_007: [ slab_pool_alloc shall return a free item of the pool without allocating memory. ]
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_011: [ An item of the pool shall be put back in the pool. ]
+TEST_FUNCTION(slab_pool_steady_state_does_not_allocate)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, TEST_CAPACITY);
+    void* in_flight[TEST_CAPACITY];
+    size_t round;
+    size_t i;
+
+    // act
+    for (round = 0; round < TEST_STEADY_STATE_ROUNDS; round++)
+    {
+        size_t count = (round % TEST_CAPACITY) + 1;
+        for (i = 0; i < count; i++)
+        {
+            in_flight[i] = slab_pool_alloc(handle);
+            ASSERT_IS_NOT_NULL(in_flight[i]);
+        }
+        for (i = count; i > 0; i--)
+        {
+            slab_pool_free(handle, in_flight[(i + round) % count]);
+        }
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, (int)slab_pool_get_heap_allocation_count(handle));
+
+    // cleanup
+    slab_pool_destroy(handle);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_013: [ If handle is NULL, slab_pool_get_heap_allocation_count shall return 0. ]
+TEST_FUNCTION(slab_pool_get_heap_allocation_count_NULL_handle_returns_0)
+{
+    // arrange
+
+    // act
+    size_t result = slab_pool_get_heap_allocation_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, (int)result);
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_015: [ slab_pool_destroy shall free the pool and all its items. If handle is NULL, slab_pool_destroy shall do nothing. ]
+TEST_FUNCTION(slab_pool_destroy_frees_the_pool)
+{
+    // arrange
+    SLAB_POOL_HANDLE handle = create_pool(TEST_ITEM_SIZE, TEST_CAPACITY);
+    (void)slab_pool_alloc(handle);
+
+    STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+    // act
+    slab_pool_destroy(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+// Tests_SRS_IOTHUB_CLIENT_SLAB_POOL_01_015: [ slab_pool_destroy shall free the pool and all its items. If handle is NULL, slab_pool_destroy shall do nothing. ]
+TEST_FUNCTION(slab_pool_destroy_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    slab_pool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothub_client_slab_pool_ut)
@@ -4,9 +4,11 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <cstddef>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #endif
 
 static void* my_gballoc_malloc(size_t size)
@@ -57,6 +59,13 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "iothub_client_ll_uploadtoblob.h"
 #endif
 
+#include "iothub_client_outbound_store.h"
+#include "iothub_client_slab_pool.h"
+
+#ifdef USE_COMPRESSION
+#include "iothub_client_payload_compressor.h"
+#endif
+
 MOCKABLE_FUNCTION(, void, test_event_confirmation_callback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result, void*, userContextCallback);
 MOCKABLE_FUNCTION(, IOTHUBMESSAGE_DISPOSITION_RESULT, test_message_callback_async, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback);
 MOCKABLE_FUNCTION(, void, iothub_reported_state_callback, int, status_code, void*, userContextCallback);
@@ -154,6 +163,14 @@ static const char* TEST_STRING_VALUE = "Test string value";
 #define TEST_TRANSPORT_LL_HANDLE            (TRANSPORT_LL_HANDLE)0x49
 #define TEST_IOTHUB_DEVICE_HANDLE           (IOTHUB_DEVICE_HANDLE)0x50
 #define TEST_MESSAGE_HANDLE                 (IOTHUB_MESSAGE_HANDLE)0x51
+#define TEST_OUTBOUND_STORE_HANDLE          (OUTBOUND_STORE_HANDLE)0x52
+#define TEST_OUTBOUND_STORE_PATH            "outbound_store"
+#define TEST_SLAB_POOL_HANDLE               (SLAB_POOL_HANDLE)0x53
+#define TEST_MESSAGE_POOL_SIZE              8
+#define TEST_PAYLOAD_COMPRESSOR_HANDLE      (PAYLOAD_COMPRESSOR_HANDLE)0x54
+#define TEST_PAYLOAD_COMPRESSOR_HANDLE_2    (PAYLOAD_COMPRESSOR_HANDLE)0x55
+#define TEST_COMPRESSION_THRESHOLD          4
+#define TEST_CLONE_POOL_HANDLE              (IOTHUB_MESSAGE_POOL_HANDLE)0x56
 #define TEST_TIME_VALUE                     (time_t)123456
 
 #define TEST_BUFFER_HANDLE                  (BUFFER_HANDLE)0x52
@@ -227,6 +244,18 @@ static const IOTHUB_CLIENT_DEVICE_CONFIG TEST_DEVICE_CONFIG_NULL_device_key_NULL
     NULL
 };
 
+static void* my_slab_pool_alloc(SLAB_POOL_HANDLE handle)
+{
+    (void)handle;
+    return my_gballoc_malloc(sizeof(IOTHUB_MESSAGE_LIST));
+}
+
+static void my_slab_pool_free(SLAB_POOL_HANDLE handle, void* item)
+{
+    (void)handle;
+    my_gballoc_free(item);
+}
+
 static STRING_HANDLE my_STRING_new(void)
 {
     return (STRING_HANDLE)my_gballoc_malloc(1);
@@ -287,11 +316,26 @@ static void my_tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
     my_gballoc_free(tick_counter);
 }
 
+static CONSTBUFFER_HANDLE g_last_constbuffer = NULL;
+
 static CONSTBUFFER_HANDLE my_CONSTBUFFER_Create(const unsigned char* source, size_t size)
 {
-    (void)source;
-    (void)size;
-    return (CONSTBUFFER_HANDLE)my_gballoc_malloc(1);
+    /*the content is kept right after the CONSTBUFFER so that coalesced reported states can be parsed*/
+    CONSTBUFFER* result = (CONSTBUFFER*)my_gballoc_malloc(sizeof(CONSTBUFFER) + size);
+    unsigned char* content = (unsigned char*)(result + 1);
+    if (size > 0)
+    {
+        (void)memcpy(content, source, size);
+    }
+    result->buffer = content;
+    result->size = size;
+    g_last_constbuffer = (CONSTBUFFER_HANDLE)result;
+    return g_last_constbuffer;
+}
+
+static const CONSTBUFFER* my_CONSTBUFFER_GetContent(CONSTBUFFER_HANDLE constbufferHandle)
+{
+    return (const CONSTBUFFER*)constbufferHandle;
 }
 
 static void my_CONSTBUFFER_Destroy(CONSTBUFFER_HANDLE constbufferHandle)
@@ -310,15 +354,28 @@ static void my_IoTHubClient_LL_UploadToBlob_Destroy(IOTHUB_CLIENT_LL_UPLOADTOBLO
     my_gballoc_free(handle);
 }
 
+static PDLIST_ENTRY registered_waitingToSend;
+
 static IOTHUB_DEVICE_HANDLE my_FAKE_IoTHubTransport_Register(TRANSPORT_LL_HANDLE handle, const IOTHUB_DEVICE_CONFIG* device, IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, PDLIST_ENTRY waitingToSend)
 {
     (void)handle;
     (void)device;
     (void)iotHubClientHandle;
-    (void)waitingToSend;
+    registered_waitingToSend = waitingToSend;
     return (IOTHUB_DEVICE_HANDLE)my_gballoc_malloc(1);
 }
 
+static uint64_t last_outbound_store_sequence;
+
+static int my_outbound_store_append(OUTBOUND_STORE_HANDLE handle, const unsigned char* data, size_t size, uint64_t* sequence)
+{
+    (void)handle;
+    (void)data;
+    (void)size;
+    *sequence = ++last_outbound_store_sequence;
+    return 0;
+}
+
 static void my_FAKE_IoTHubTransport_Unregister(TRANSPORT_LL_HANDLE handle)
 {
     my_gballoc_free(handle);
@@ -447,6 +504,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_TRANSPORT_PROVIDER, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_DEVICE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_POOL_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_DEVICE_TWIN_STATE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_IDENTITY_TYPE, void*);
@@ -467,6 +525,16 @@ TEST_SUITE_INITIALIZE(suite_init)
 #ifndef DONT_USE_UPLOADTOBLOB
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_LL_UPLOADTOBLOB_HANDLE, void*);
 #endif // DONT_USE_UPLOADTOBLOB
+    REGISTER_UMOCK_ALIAS_TYPE(OUTBOUND_STORE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OUTBOUND_STORE_ON_RECORD, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SLAB_POOL_HANDLE, void*);
+#ifdef USE_COMPRESSION
+    REGISTER_UMOCK_ALIAS_TYPE(PAYLOAD_COMPRESSOR_HANDLE, void*);
+#endif
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
 
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_GetVersionString, "version 1.0");
 
@@ -514,12 +582,36 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_CreateFromString, (IOTHUB_MESSAGE_HANDLE)0x44);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_Clone, (IOTHUB_MESSAGE_HANDLE)0x44);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_Clone, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_CreatePool, TEST_CLONE_POOL_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_CreatePool, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_CloneFromPool, (IOTHUB_MESSAGE_HANDLE)0x44);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_CloneFromPool, NULL);
 
     REGISTER_GLOBAL_MOCK_RETURN(get_time, (time_t)TEST_TIME_VALUE);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+
+    REGISTER_GLOBAL_MOCK_RETURN(outbound_store_open, TEST_OUTBOUND_STORE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(outbound_store_open, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(outbound_store_append, my_outbound_store_append);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(outbound_store_append, __FAILURE__);
+
+#ifdef USE_COMPRESSION
+    REGISTER_GLOBAL_MOCK_RETURN(payload_compressor_create, TEST_PAYLOAD_COMPRESSOR_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(payload_compressor_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(payload_compressor_deflate, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(payload_compressor_deflate, __FAILURE__);
+#endif
+
+    REGISTER_GLOBAL_MOCK_RETURN(slab_pool_create, TEST_SLAB_POOL_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(slab_pool_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(slab_pool_alloc, my_slab_pool_alloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(slab_pool_alloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(slab_pool_free, my_slab_pool_free);
 
     REGISTER_GLOBAL_MOCK_HOOK(STRING_new, my_STRING_new);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_new, NULL);
@@ -537,6 +629,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(CONSTBUFFER_Create, NULL);
 
     REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_Destroy, my_CONSTBUFFER_Destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_GetContent, my_CONSTBUFFER_GetContent);
 
     REGISTER_GLOBAL_MOCK_HOOK(STRING_TOKENIZER_create, my_STRING_TOKENIZER_create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_TOKENIZER_create, NULL);
@@ -614,6 +707,8 @@ static void setup_iothubclient_ll_create_mocks()
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
 
     STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Create(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
@@ -726,6 +821,8 @@ static void setup_iothubclient_ll_createwithtransport_mocks()
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(DList_InitializeListHead(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Register(TEST_DEVICE_CONFIG.transportHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
         .IgnoreArgument(3)
@@ -1479,6 +1576,49 @@ TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_succeeds)
     IoTHubClient_LL_Destroy(handle);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_01_001: [ IoTHubClient_LL_SendEventAsync_Move shall add eventMessageHandle to the DLIST waitingToSend without cloning it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_Move_succeeds)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_002: [ IoTHubClient_LL_SendEventAsync_Move shall validate its arguments the same way as IoTHubClient_LL_SendEventAsync. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_Move_with_NULL_messageHandle_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync_Move(handle, NULL, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_02_010: [IoTHubClient_LL_Destroy shall call the underlaying layer's _Destroy function and shall free the resources allocated by IoTHubClient (if any).] */
 /*Tests_SRS_IOTHUBCLIENT_LL_02_033: [Otherwise, IoTHubClient_LL_Destroy shall complete all the event message callbacks that are in the waitingToSend list with the result IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY.] */
 TEST_FUNCTION(IoTHubClient_LL_Destroy_after_sendEvent_succeeds)
@@ -2819,6 +2959,191 @@ TEST_FUNCTION(IoTHubClient_GetSendStatus_HasEventToSend_Succeeds)
     IoTHubClient_LL_Destroy(handle);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_01_004: [ If iotHubClientHandle or queueSize is NULL, IoTHubClient_LL_GetSendQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetSendQueueSize_with_NULL_handle_fails)
+{
+    // arrange
+    size_t queueSize;
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendQueueSize(NULL, &queueSize);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_004: [ If iotHubClientHandle or queueSize is NULL, IoTHubClient_LL_GetSendQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetSendQueueSize_with_NULL_queueSize_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendQueueSize(handle, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_005: [ Otherwise IoTHubClient_LL_GetSendQueueSize shall set queueSize to the number of events accepted by IoTHubClient_LL_SendEventAsync whose confirmation callback has not been called yet and return IOTHUB_CLIENT_OK. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetSendQueueSize_counts_pending_events)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    size_t queueSizeBefore = 42;
+    size_t queueSizeAfter = 0;
+    (void)IoTHubClient_LL_GetSendQueueSize(handle, &queueSizeBefore);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)2);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetSendQueueSize(handle, &queueSizeAfter);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 0, queueSizeBefore);
+    ASSERT_ARE_EQUAL(size_t, 2, queueSizeAfter);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_053: [ If iotHubClientHandle or waitMs is NULL, IoTHubClient_LL_GetWorkWaitTime shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_with_NULL_handle_fails)
+{
+    // arrange
+    tickcounter_ms_t waitMs;
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(NULL, 10, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_053: [ If iotHubClientHandle or waitMs is NULL, IoTHubClient_LL_GetWorkWaitTime shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_with_NULL_waitMs_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(handle, 10, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_054: [ If getting the current tick count fails, IoTHubClient_LL_GetWorkWaitTime shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_fails_when_getting_the_tick_count_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t waitMs;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetReturn(__LINE__);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(handle, 10, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_055: [ While nothing is waiting on the transport, IoTHubClient_LL_GetWorkWaitTime shall start from IOTHUB_CLIENT_LL_NO_WORK_DEADLINE, otherwise from transportPollMs. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_058: [ IoTHubClient_LL_GetWorkWaitTime shall set waitMs to the resulting wait and return IOTHUB_CLIENT_OK. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_without_pending_work_has_no_deadline)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t waitMs = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(handle, 10, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_IS_TRUE(waitMs == IOTHUB_CLIENT_LL_NO_WORK_DEADLINE);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_055: [ While nothing is waiting on the transport, IoTHubClient_LL_GetWorkWaitTime shall start from IOTHUB_CLIENT_LL_NO_WORK_DEADLINE, otherwise from transportPollMs. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_with_an_event_in_flight_returns_the_transport_poll_period)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t waitMs = 0;
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(handle, 10, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 10, (size_t)waitMs);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_056: [ IoTHubClient_LL_GetWorkWaitTime shall shorten the wait to the number of milliseconds until the first message in waitingToSend or in the outbound store times out. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_returns_the_time_until_the_first_message_times_out)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t messageTimeout = 5000;
+    tickcounter_ms_t waitMs = 0;
+    (void)IoTHubClient_LL_SetOption(handle, "messageTimeout", &messageTimeout);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(handle, 60000, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    /*the tick counter moved 1000 ms since the event was sent, the event times out once the tick count is past its timeout*/
+    ASSERT_ARE_EQUAL(size_t, 4001, (size_t)waitMs);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_02_034: [If iotHubClientHandle is NULL then IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG.]*/
 TEST_FUNCTION(IoTHubClient_LL_SetOption_with_NULL_handle_fails)
 {
@@ -3407,6 +3732,57 @@ TEST_FUNCTION(IoTHubClient_LL_SetOption_2_messages_one_with_timeout_one_without_
     IoTHubClient_LL_Destroy(handle);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_LL_01_007: [ While the timeouts of the messages in waitingToSend are in the order the messages were queued, IoTHubClient_LL_DoWork shall stop looking for timed out messages at the first message with a timeout that has not expired. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_02_044: [ Messages already delivered to IoTHubClient_LL shall not have their timeouts modified by a new call to IoTHubClient_LL_SetOption. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_messageTimeout_decreased_times_out_later_message_first)
+{
+    //arrange
+
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t ten = 10;
+    (void)IoTHubClient_LL_SetOption(handle, "messageTimeout", &ten);
+
+    /*first message is sent at time=10 and expires at 20*/
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &ten, sizeof(ten));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)TEST_DEVICEMESSAGE_HANDLE);
+
+    /*second message is sent at time=10 and expires at 11, before the message queued ahead of it*/
+    tickcounter_ms_t one = 1;
+    (void)IoTHubClient_LL_SetOption(handle, "messageTimeout", &one);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &ten, sizeof(ten));
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_DEVICEMESSAGE_HANDLE, test_event_confirmation_callback, (void*)(TEST_DEVICEMESSAGE_HANDLE_2));
+    umock_c_reset_all_calls();
+
+    tickcounter_ms_t twelve = 12;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .CopyOutArgumentBuffer(2, &twelve, sizeof(twelve));
+
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG)) /*this is removing the second item from waitingToSend*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, (void*)(TEST_DEVICEMESSAGE_HANDLE_2)));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllCalls();
+
+    //act
+    IoTHubClient_LL_DoWork(handle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_02_041: [ If more than value miliseconds have passed since the call to IoTHubClient_LL_SendEventAsync then the message callback shall be called with a status code of IOTHUB_CLIENT_CONFIRMATION_TIMEOUT. ]*/
 TEST_FUNCTION(IoTHubClient_LL_SetOption_messageTimeout_when_tickcounter_fails_in_do_work_no_timeout_callbacks_are_called) /*test wants to see that message that did not timeout yet do not have their callbacks called*/
 {
@@ -3501,19 +3877,52 @@ TEST_FUNCTION(IoTHubClient_LL_UploadToBlob_with_NULL_source_and_size_greater_tha
     ///cleanup
     IoTHubClient_LL_Destroy(h);
 }
-#endif 
 
-/* Tests_SRS_IOTHUBCLIENT_LL_10_016: [ Otherwise IoTHubClient_LL_SendReportedState shall succeed and return IOTHUB_CLIENT_OK.] */
-TEST_FUNCTION(IoTHubClient_LL_SendReportedState_succeeds)
+/*Tests_SRS_IOTHUBCLIENT_LL_01_034: [ If handle, destinationFileName or source is NULL, or source has no readCallback while its size is not 0, then IoTHubClient_LL_UploadMultipleBlocksToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadMultipleBlocksToBlob_with_NULL_handle_fails)
 {
     //arrange
-    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
-    umock_c_reset_all_calls();
-
-    setup_iothubclient_ll_sendreportedstate_mocks();
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source = { 0, NULL, NULL, NULL, NULL, NULL };
 
     //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadMultipleBlocksToBlob(NULL, "irrelevantFileName", &source);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    ///cleanup
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_034: [ If handle, destinationFileName or source is NULL, or source has no readCallback while its size is not 0, then IoTHubClient_LL_UploadMultipleBlocksToBlob shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_UploadMultipleBlocksToBlob_with_NULL_source_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_UploadMultipleBlocksToBlob(h, "someFileName.txt", NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+#endif 
+
+/* Tests_SRS_IOTHUBCLIENT_LL_10_016: [ Otherwise IoTHubClient_LL_SendReportedState shall succeed and return IOTHUB_CLIENT_OK.] */
+TEST_FUNCTION(IoTHubClient_LL_SendReportedState_succeeds)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    setup_iothubclient_ll_sendreportedstate_mocks();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
 
     //assert
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
@@ -3687,6 +4096,186 @@ TEST_FUNCTION(IoTHubClient_LL_DoWork_SendReportedState_continue_processing_succe
     IoTHubClient_LL_Destroy(h);
 }
 
+static const char TEST_COALESCED_STATE_1[] = "{\"a\":1,\"b\":{\"x\":1,\"y\":2}}";
+static const char TEST_COALESCED_STATE_2[] = "{\"b\":{\"y\":3,\"z\":4},\"c\":\"s\"}";
+static const char TEST_COALESCED_STATE_3[] = "{\"a\":5}";
+static const char TEST_COALESCED_STATE_MERGED[] = "{\"a\":5,\"b\":{\"x\":1,\"y\":3,\"z\":4},\"c\":\"s\"}";
+
+static IOTHUB_CLIENT_LL_HANDLE create_with_coalesced_reported_states(tickcounter_ms_t interval)
+{
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, "reported_state_coalescing_interval", &interval);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_1, strlen(TEST_COALESCED_STATE_1), iothub_reported_state_callback, (void*)1);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_2, strlen(TEST_COALESCED_STATE_2), iothub_reported_state_callback, (void*)2);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_3, strlen(TEST_COALESCED_STATE_3), iothub_reported_state_callback, (void*)3);
+    return h;
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_008: [ "reported_state_coalescing_interval" - value is a pointer to a tickcounter_ms_t. When not 0, reported states given to IoTHubClient_LL_SendReportedState are merged and published at most once per that many milliseconds. 0 (the default) publishes each reported state as it was given. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_reported_state_coalescing_interval_succeeds)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t interval = 500;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "reported_state_coalescing_interval", &interval);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_057: [ While reported states are held for coalescing, IoTHubClient_LL_GetWorkWaitTime shall shorten the wait to the number of milliseconds until they are due to be flushed. ]*/
+TEST_FUNCTION(IoTHubClient_LL_GetWorkWaitTime_returns_the_time_until_reported_states_are_flushed)
+{
+    // arrange
+    IOTHUB_CLIENT_LL_HANDLE h = create_with_coalesced_reported_states(10000);
+    tickcounter_ms_t waitMs = 0;
+    umock_c_reset_all_calls();
+    g_current_ms = 4000; /*no flush happened yet, the next tick count is 5000 ms after it*/
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_GetWorkWaitTime(h, 60000, &waitMs);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 5000, (size_t)waitMs);
+
+    // cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_009: [ When "reported_state_coalescing_interval" is not 0, IoTHubClient_LL_DoWork shall hold the reported states until that many milliseconds have passed since the last flush and then merge all of them into one JSON patch, the values given last winning. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_coalesces_reported_states_into_one_patch)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE h = create_with_coalesced_reported_states(500);
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubClient_LL_DoWork(h);
+
+    ///assert
+    const CONSTBUFFER* merged = my_CONSTBUFFER_GetContent(g_last_constbuffer);
+    ASSERT_ARE_EQUAL(int, (int)strlen(TEST_COALESCED_STATE_MERGED), (int)merged->size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(TEST_COALESCED_STATE_MERGED, merged->buffer, merged->size));
+    ASSERT_IS_NOT_NULL(strstr(umock_c_get_actual_calls(), "FAKE_IoTHubTransport_ProcessItem"));
+    ASSERT_IS_NULL(strstr(strstr(umock_c_get_actual_calls(), "FAKE_IoTHubTransport_ProcessItem") + 1, "FAKE_IoTHubTransport_ProcessItem"));
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_010: [ The reported states merged into the patch shall be kept with it, so that each of their callbacks is called with the status of the patch. ]*/
+TEST_FUNCTION(IoTHubClient_LL_ReportedStateComplete_calls_every_coalesced_callback)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE h = create_with_coalesced_reported_states(500);
+    IoTHubClient_LL_DoWork(h);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(iothub_reported_state_callback(TEST_DEVICE_STATUS_CODE, (void*)1));
+    STRICT_EXPECTED_CALL(iothub_reported_state_callback(TEST_DEVICE_STATUS_CODE, (void*)2));
+    STRICT_EXPECTED_CALL(iothub_reported_state_callback(TEST_DEVICE_STATUS_CODE, (void*)3));
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    for (size_t index = 0; index < 4; index++)
+    {
+        STRICT_EXPECTED_CALL(CONSTBUFFER_Destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    }
+
+    //act
+    /*items 2, 3 and 4 were merged into item 5*/
+    IoTHubClient_LL_ReportedStateComplete(h, 5, TEST_DEVICE_STATUS_CODE);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_009: [ When "reported_state_coalescing_interval" is not 0, IoTHubClient_LL_DoWork shall hold the reported states until that many milliseconds have passed since the last flush and then merge all of them into one JSON patch, the values given last winning. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_holds_reported_states_until_the_interval_elapses)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE h = create_with_coalesced_reported_states(1000000);
+    IoTHubClient_LL_DoWork(h);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_1, strlen(TEST_COALESCED_STATE_1), iothub_reported_state_callback, (void*)4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*_DoWork will ask "what's the time"*/
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*and again to know if the reported states can be flushed*/
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG, h))
+        .IgnoreArgument(1);
+
+    //act
+    IoTHubClient_LL_DoWork(h);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_011: [ If the pending reported states cannot be merged, IoTHubClient_LL_DoWork shall publish them one by one. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_sends_reported_states_one_by_one_when_they_are_not_JSON_objects)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t interval = 500;
+    (void)IoTHubClient_LL_SetOption(h, "reported_state_coalescing_interval", &interval);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_1, strlen(TEST_COALESCED_STATE_1), iothub_reported_state_callback, (void*)1);
+    (void)IoTHubClient_LL_SendReportedState(h, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, (void*)2);
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubClient_LL_DoWork(h);
+
+    ///assert
+    const char* first_item = strstr(umock_c_get_actual_calls(), "FAKE_IoTHubTransport_ProcessItem");
+    ASSERT_IS_NOT_NULL(first_item);
+    ASSERT_IS_NOT_NULL(strstr(first_item + 1, "FAKE_IoTHubTransport_ProcessItem"));
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_052: [ Reported states with a number that would not be written back exactly as it was given shall not be merged. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_sends_reported_states_one_by_one_when_a_number_would_change)
+{
+    //arrange
+    static const char TEST_LARGE_INTEGER_STATE[] = "{\"n\":9007199254740993}";
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    tickcounter_ms_t interval = 500;
+    (void)IoTHubClient_LL_SetOption(h, "reported_state_coalescing_interval", &interval);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_COALESCED_STATE_1, strlen(TEST_COALESCED_STATE_1), iothub_reported_state_callback, (void*)1);
+    (void)IoTHubClient_LL_SendReportedState(h, (const unsigned char*)TEST_LARGE_INTEGER_STATE, strlen(TEST_LARGE_INTEGER_STATE), iothub_reported_state_callback, (void*)2);
+    umock_c_reset_all_calls();
+
+    //act
+    IoTHubClient_LL_DoWork(h);
+
+    ///assert
+    const CONSTBUFFER* last = my_CONSTBUFFER_GetContent(g_last_constbuffer);
+    const char* first_item = strstr(umock_c_get_actual_calls(), "FAKE_IoTHubTransport_ProcessItem");
+    ASSERT_IS_NOT_NULL(first_item);
+    ASSERT_IS_NOT_NULL(strstr(first_item + 1, "FAKE_IoTHubTransport_ProcessItem"));
+    ASSERT_ARE_EQUAL(int, (int)strlen(TEST_LARGE_INTEGER_STATE), (int)last->size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(TEST_LARGE_INTEGER_STATE, last->buffer, last->size));
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(h);
+}
+
 /*Tests_SRS_IOTHUBCLIENT_LL_12_017: [ `IoTHubClient_LL_SetDeviceMethodCallback` shall fail and return `IOTHUB_CLIENT_INVALID_ARG` if parameter `iotHubClientHandle` is `NULL`. ]*/
 TEST_FUNCTION(IoTHubClient_LL_SetDeviceMethodCallback_with_NULL_iotHubClientHandle_fails)
 {
@@ -4232,4 +4821,1182 @@ TEST_FUNCTION(IoTHubClient_LL_DeviceMethodResponse_succeed)
     IoTHubClient_LL_Destroy(h);
 }
 
+static IOTHUB_CLIENT_LL_HANDLE create_with_outbound_store(void)
+{
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+    return h;
+}
+
+static void setup_store_outbound_event_expectations(const unsigned char** body, size_t* bodySize, const char* const** keys, size_t* propertyCount)
+{
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubMessageHandle()
+        .SetReturn(IOTHUBMESSAGE_BYTEARRAY);
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubMessageHandle()
+        .CopyOutArgumentBuffer_buffer(body, sizeof(*body))
+        .CopyOutArgumentBuffer_size(bodySize, sizeof(*bodySize));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubMessageHandle();
+    STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .CopyOutArgumentBuffer_keys(keys, sizeof(*keys))
+        .CopyOutArgumentBuffer_values(keys, sizeof(*keys))
+        .CopyOutArgumentBuffer_count(propertyCount, sizeof(*propertyCount));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubMessageHandle();
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubMessageHandle();
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_012: [ "outbound_store_path" - value is a const char* path prefix for the files of the outbound store. IoTHubClient_LL_SetOption shall open the outbound store and queue the events it still holds, up to "outbound_store_window" of them, without a confirmation callback, in the order they were sent. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_path_opens_and_replays_the_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(outbound_store_open(TEST_OUTBOUND_STORE_PATH, OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE));
+    STRICT_EXPECTED_CALL(outbound_store_read(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, 128, IGNORED_PTR_ARG, handle))
+        .IgnoreArgument_sequence()
+        .IgnoreArgument_on_record();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_013: [ If the outbound store is already open or cannot be opened, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_path_fails_when_open_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(outbound_store_open(TEST_OUTBOUND_STORE_PATH, OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_013: [ If the outbound store is already open or cannot be opened, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_path_twice_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_020: [ "outbound_store_segment_size" - value is a pointer to an unsigned int, the size in bytes after which the outbound store starts a new segment. It shall be set before "outbound_store_path", otherwise IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_segment_size_is_used_to_open_the_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int segmentSize = 4096;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(outbound_store_open(TEST_OUTBOUND_STORE_PATH, 4096));
+    STRICT_EXPECTED_CALL(outbound_store_read(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, 128, IGNORED_PTR_ARG, handle))
+        .IgnoreArgument_sequence()
+        .IgnoreArgument_on_record();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_segment_size", &segmentSize);
+    IOTHUB_CLIENT_RESULT pathResult = IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, pathResult);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_020: [ "outbound_store_segment_size" - value is a pointer to an unsigned int, the size in bytes after which the outbound store starts a new segment. It shall be set before "outbound_store_path", otherwise IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_segment_size_0_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int segmentSize = 0;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_segment_size", &segmentSize);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_020: [ "outbound_store_segment_size" - value is a pointer to an unsigned int, the size in bytes after which the outbound store starts a new segment. It shall be set before "outbound_store_path", otherwise IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_segment_size_after_open_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    unsigned int segmentSize = 4096;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_segment_size", &segmentSize);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_014: [ When the outbound store is open, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall append the event to it before queuing it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_appends_the_event_to_the_outbound_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    const unsigned char* body = (const unsigned char*)"abc";
+    size_t bodySize = 3;
+    const char* const* keys = NULL;
+    size_t propertyCount = 0;
+    /*content type, body, message id, correlation id, property count*/
+    size_t storedSize = 1 + (4 + 3) + 4 + 4 + 4;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    setup_store_outbound_event_expectations(&body, &bodySize, &keys, &propertyCount);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, storedSize));
+    STRICT_EXPECTED_CALL(outbound_store_append(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, storedSize, IGNORED_PTR_ARG))
+        .IgnoreArgument_data()
+        .IgnoreArgument_sequence();
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_015: [ If the event cannot be written to the outbound store, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_fails_when_the_outbound_store_append_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    const unsigned char* body = (const unsigned char*)"abc";
+    size_t bodySize = 3;
+    const char* const* keys = NULL;
+    size_t propertyCount = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    setup_store_outbound_event_expectations(&body, &bodySize, &keys, &propertyCount);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(outbound_store_append(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_data()
+        .IgnoreArgument_size()
+        .IgnoreArgument_sequence()
+        .SetReturn(__FAILURE__);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)0x44));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_016: [ Once an event kept in the outbound store completes with any result other than IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, it shall be released from the outbound store. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_releases_the_event_from_the_outbound_store)
+{
+    ///arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->outboundStoreSequence = 7;
+    DList_InsertTailList(&temp, &(one->entry));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(outbound_store_release(TEST_OUTBOUND_STORE_HANDLE, 7));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
+    STRICT_EXPECTED_CALL(gballoc_free(one));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_040: [ An event kept in the outbound store that completes with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY shall stay in the outbound store, to be sent again by the next instance that opens it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_BECAUSE_DESTROY_keeps_the_event_in_the_outbound_store)
+{
+    ///arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->outboundStoreSequence = 7;
+    DList_InsertTailList(&temp, &(one->entry));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, (void*)1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
+    STRICT_EXPECTED_CALL(gballoc_free(one));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_016: [ Once an event kept in the outbound store completes with any result other than IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, it shall be released from the outbound store. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_ERROR_releases_the_event_from_the_outbound_store)
+{
+    ///arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->outboundStoreSequence = 7;
+    DList_InsertTailList(&temp, &(one->entry));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_ERROR, (void*)1));
+    STRICT_EXPECTED_CALL(outbound_store_release(TEST_OUTBOUND_STORE_HANDLE, 7));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
+    STRICT_EXPECTED_CALL(gballoc_free(one));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_046: [ "outbound_store_window" - value is a pointer to an unsigned int, the most events of the outbound store held in memory, 128 by default. If it is 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_window_0_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int window = 0;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_window", &window);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_046: [ "outbound_store_window" - value is a pointer to an unsigned int, the most events of the outbound store held in memory, 128 by default. If it is 0, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_outbound_store_window_limits_the_events_read_when_opening)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int window = 5;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(outbound_store_open(TEST_OUTBOUND_STORE_PATH, OUTBOUND_STORE_DEFAULT_SEGMENT_SIZE));
+    STRICT_EXPECTED_CALL(outbound_store_read(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, 5, IGNORED_PTR_ARG, handle))
+        .IgnoreArgument_sequence()
+        .IgnoreArgument_on_record();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "outbound_store_window", &window);
+    IOTHUB_CLIENT_RESULT pathResult = IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, pathResult);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_041: [ When "outbound_store_window" events of the outbound store are already in memory, or older events are only on disk, the event shall only be kept on disk: its message shall be destroyed and only its confirmation callback and timeout kept until it is read back. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_beyond_the_outbound_store_window_keeps_the_event_on_disk_only)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int window = 1;
+    const unsigned char* body = (const unsigned char*)"abc";
+    size_t bodySize = 3;
+    const char* const* keys = NULL;
+    size_t propertyCount = 0;
+    (void)IoTHubClient_LL_SetOption(handle, "outbound_store_window", &window);
+    (void)IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    setup_store_outbound_event_expectations(&body, &bodySize, &keys, &propertyCount);
+    STRICT_EXPECTED_CALL(outbound_store_append(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_data()
+        .IgnoreArgument_size()
+        .IgnoreArgument_sequence();
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)0x44));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)2);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_042: [ While events are only in the outbound store, IoTHubClient_LL_DoWork shall read them back in the order they were sent, until "outbound_store_window" events are held in memory. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_reads_back_the_events_that_are_only_in_the_outbound_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int window = 1;
+    (void)IoTHubClient_LL_SetOption(handle, "outbound_store_window", &window);
+    (void)IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    (void)IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)2);
+    /*the first event completes, which makes room for the second one*/
+    DLIST_ENTRY completed;
+    DList_InitializeListHead(&completed);
+    PDLIST_ENTRY first = DList_RemoveHeadList(registered_waitingToSend);
+    DList_InsertTailList(&completed, first);
+    IoTHubClient_LL_SendComplete(handle, &completed, IOTHUB_CLIENT_CONFIRMATION_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(outbound_store_commit(TEST_OUTBOUND_STORE_HANDLE));
+    STRICT_EXPECTED_CALL(outbound_store_read(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, handle))
+        .IgnoreArgument_sequence()
+        .IgnoreArgument_on_record();
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG, handle))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(outbound_store_compact(TEST_OUTBOUND_STORE_HANDLE));
+
+    //act
+    IoTHubClient_LL_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_017: [ Before the transport gets to send anything, IoTHubClient_LL_DoWork shall commit the outbound store, so every event appended since the previous call is made durable with a single sync. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_018: [ After the transport's _DoWork, IoTHubClient_LL_DoWork shall give the outbound store a chance to compact its oldest segment. ]*/
+TEST_FUNCTION(IoTHubClient_LL_DoWork_commits_and_compacts_the_outbound_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(outbound_store_commit(TEST_OUTBOUND_STORE_HANDLE));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG, handle))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(outbound_store_compact(TEST_OUTBOUND_STORE_HANDLE));
+
+    //act
+    IoTHubClient_LL_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_019: [ IoTHubClient_LL_Destroy shall close the outbound store, the events it holds that were not released are sent by the next instance that opens it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_closes_the_outbound_store)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_outbound_store();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(outbound_store_close(TEST_OUTBOUND_STORE_HANDLE));
+
+    //act
+    IoTHubClient_LL_Destroy(handle);
+
+    //assert
+    /*the other calls made by IoTHubClient_LL_Destroy are covered by its own tests*/
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+}
+
+static IOTHUB_CLIENT_LL_HANDLE create_with_message_pool(void)
+{
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, "message_pool_size", &poolSize);
+    return h;
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_021: [ "message_pool_size" - value is a pointer to an unsigned int, the number of events the client can have pending without allocating their bookkeeping on the heap. IoTHubClient_LL_SetOption shall replace the message pool with one of that many records, 0 (the default) removes the pool. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_025: [ IoTHubClient_LL_SetOption shall pass "message_pool_size" to the transport, so that it can pool its own per-event records. If the transport returns IOTHUB_CLIENT_ERROR, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_050: [ IoTHubClient_LL_SetOption shall also create a pool of that many message clones with IoTHubMessage_CreatePool. If that fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_creates_the_pool)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreatePool(TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, "message_pool_size", &poolSize))
+        .IgnoreArgument_handle();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_021: [ "message_pool_size" - value is a pointer to an unsigned int, the number of events the client can have pending without allocating their bookkeeping on the heap. IoTHubClient_LL_SetOption shall replace the message pool with one of that many records, 0 (the default) removes the pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_0_removes_the_pool)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    unsigned int poolSize = 0;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, "message_pool_size", &poolSize))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(slab_pool_destroy(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_DestroyPool(TEST_CLONE_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+    IOTHUB_CLIENT_RESULT sendResult = IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, sendResult);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_022: [ If events are pending or the pool cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_fails_while_events_are_pending)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    (void)IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_022: [ If events are pending or the pool cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_fails_when_the_pool_cannot_be_created)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), TEST_MESSAGE_POOL_SIZE))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_050: [ IoTHubClient_LL_SetOption shall also create a pool of that many message clones with IoTHubMessage_CreatePool. If that fails, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_fails_when_the_clone_pool_cannot_be_created)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreatePool(TEST_MESSAGE_POOL_SIZE))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(slab_pool_destroy(TEST_SLAB_POOL_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_025: [ IoTHubClient_LL_SetOption shall pass "message_pool_size" to the transport, so that it can pool its own per-event records. If the transport returns IOTHUB_CLIENT_ERROR, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_fails_when_the_transport_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreatePool(TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, "message_pool_size", &poolSize))
+        .IgnoreArgument_handle()
+        .SetReturn(IOTHUB_CLIENT_ERROR);
+    STRICT_EXPECTED_CALL(slab_pool_destroy(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_DestroyPool(TEST_CLONE_POOL_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_025: [ IoTHubClient_LL_SetOption shall pass "message_pool_size" to the transport, so that it can pool its own per-event records. If the transport returns IOTHUB_CLIENT_ERROR, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current message pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_message_pool_size_succeeds_when_the_transport_does_not_know_it)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    unsigned int poolSize = TEST_MESSAGE_POOL_SIZE;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_create(sizeof(IOTHUB_MESSAGE_LIST), TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CreatePool(TEST_MESSAGE_POOL_SIZE));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, "message_pool_size", &poolSize))
+        .IgnoreArgument_handle()
+        .SetReturn(IOTHUB_CLIENT_INVALID_ARG);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "message_pool_size", &poolSize);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_023: [ When a message pool was created by OPTION_MESSAGE_POOL_SIZE, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall take the record queued for the event from the pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_Move_with_a_message_pool_does_not_allocate)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    umock_c_reset_all_calls();
+
+    /*no gballoc_malloc: the payload moved in is the only memory the event owns*/
+    STRICT_EXPECTED_CALL(slab_pool_alloc(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_023: [ When a message pool was created by OPTION_MESSAGE_POOL_SIZE, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall take the record queued for the event from the pool. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_049: [ When a message pool was set with "message_pool_size", IoTHubClient_LL_SendEventAsync shall clone eventMessageHandle with IoTHubMessage_CloneFromPool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_a_message_pool_clones_from_the_pool)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    umock_c_reset_all_calls();
+
+    /*no gballoc_malloc and no IoTHubMessage_Clone: both the record and the clone come from pools*/
+    STRICT_EXPECTED_CALL(slab_pool_alloc(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CloneFromPool(TEST_CLONE_POOL_HANDLE, TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_02_014: [If cloning and/or adding the information fails for any reason, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR.] */
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_a_message_pool_fails_when_the_clone_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_alloc(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_CloneFromPool(TEST_CLONE_POOL_HANDLE, TEST_MESSAGE_HANDLE))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(slab_pool_free(TEST_SLAB_POOL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_023: [ When a message pool was created by OPTION_MESSAGE_POOL_SIZE, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall take the record queued for the event from the pool. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_with_a_message_pool_fails_when_the_pool_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(slab_pool_alloc(TEST_SLAB_POOL_HANDLE))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_024: [ Once an event is completed, its record shall go back to the message pool it was taken from. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendComplete_with_a_message_pool_returns_the_record_to_the_pool)
+{
+    ///arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->outboundStoreSequence = 0;
+    DList_InsertTailList(&temp, &(one->entry));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
+    STRICT_EXPECTED_CALL(slab_pool_free(TEST_SLAB_POOL_HANDLE, one));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubClient_LL_SendComplete(handle, &temp, IOTHUB_CLIENT_CONFIRMATION_OK);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_026: [ IoTHubClient_LL_Destroy shall destroy the message pool after all the events have been completed. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_destroys_the_message_pool)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_message_pool();
+    (void)IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, (void*)1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(slab_pool_free(TEST_SLAB_POOL_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(slab_pool_destroy(TEST_SLAB_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_DestroyPool(TEST_CLONE_POOL_HANDLE));
+
+    //act
+    IoTHubClient_LL_Destroy(handle);
+
+    //assert
+    /*the other calls made by IoTHubClient_LL_Destroy are covered by its own tests*/
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+}
+
+#ifdef USE_COMPRESSION
+static IOTHUB_CLIENT_LL_HANDLE create_with_compression(void)
+{
+    unsigned int threshold = TEST_COMPRESSION_THRESHOLD;
+    IOTHUB_CLIENT_LL_HANDLE h = IoTHubClient_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClient_LL_SetOption(h, "compression_threshold", &threshold);
+    return h;
+}
+
+static void setup_compress_event_expectations(const unsigned char** body, size_t* bodySize, bool* isEncoded)
+{
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType((IOTHUB_MESSAGE_HANDLE)0x44))
+        .SetReturn(IOTHUBMESSAGE_BYTEARRAY);
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray((IOTHUB_MESSAGE_HANDLE)0x44, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_buffer(body, sizeof(*body))
+        .CopyOutArgumentBuffer_size(bodySize, sizeof(*bodySize));
+    if (*bodySize >= TEST_COMPRESSION_THRESHOLD)
+    {
+        STRICT_EXPECTED_CALL(IoTHubMessage_Properties((IOTHUB_MESSAGE_HANDLE)0x44));
+        STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, "content-encoding", IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .CopyOutArgumentBuffer_keyExists(isEncoded, sizeof(*isEncoded));
+    }
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_027: [ "compression_threshold" - value is a pointer to an unsigned int. IoTHubClient_LL_SetOption shall enable compression of the events whose body is at least that many bytes long. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_threshold_creates_the_compressor)
+{
+    //arrange
+    unsigned int threshold = TEST_COMPRESSION_THRESHOLD;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(payload_compressor_create(NULL, 0));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "compression_threshold", &threshold);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_033: [ If the payload compressor cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compression settings. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_threshold_fails_when_the_compressor_cannot_be_created)
+{
+    //arrange
+    unsigned int threshold = TEST_COMPRESSION_THRESHOLD;
+    IOTHUB_CLIENT_LL_HANDLE handle = IoTHubClient_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(payload_compressor_create(NULL, 0))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "compression_threshold", &threshold);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_031: [ "compression_dictionary" - value is a pointer to an IOTHUB_COMPRESSION_DICTIONARY. IoTHubClient_LL_SetOption shall enable compression, with the default threshold of 256 bytes unless "compression_threshold" was set, and use a copy of the dictionary for every event compressed from then on. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_dictionary_replaces_the_compressor)
+{
+    //arrange
+    static const unsigned char dictionaryBytes[] = { '{', '"', 't', '"', ':' };
+    IOTHUB_COMPRESSION_DICTIONARY dictionary;
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    dictionary.bytes = dictionaryBytes;
+    dictionary.size = sizeof(dictionaryBytes);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(payload_compressor_create(dictionaryBytes, sizeof(dictionaryBytes)))
+        .SetReturn(TEST_PAYLOAD_COMPRESSOR_HANDLE_2);
+    STRICT_EXPECTED_CALL(payload_compressor_destroy(TEST_PAYLOAD_COMPRESSOR_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "compression_dictionary", &dictionary);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_033: [ If the payload compressor cannot be created, IoTHubClient_LL_SetOption shall return IOTHUB_CLIENT_ERROR and keep the current compression settings. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SetOption_compression_dictionary_keeps_the_compressor_when_create_fails)
+{
+    //arrange
+    static const unsigned char dictionaryBytes[] = { '{', '"', 't', '"', ':' };
+    IOTHUB_COMPRESSION_DICTIONARY dictionary;
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    dictionary.bytes = dictionaryBytes;
+    dictionary.size = sizeof(dictionaryBytes);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(payload_compressor_create(dictionaryBytes, sizeof(dictionaryBytes)))
+        .SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SetOption(handle, "compression_dictionary", &dictionary);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_028: [ When compression is enabled, IoTHubClient_LL_SendEventAsync and IoTHubClient_LL_SendEventAsync_Move shall replace the body of the event with its deflate stream and set its "content-encoding" property to "deflate" before queuing it. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_compresses_the_event)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"aaaaaaaa";
+    size_t bodySize = 8;
+    bool isEncoded = false;
+    const unsigned char* compressed = (const unsigned char*)"zz";
+    size_t compressedSize = 2;
+    umock_c_reset_all_calls();
+
+    setup_compress_event_expectations(&body, &bodySize, &isEncoded);
+    STRICT_EXPECTED_CALL(payload_compressor_deflate(TEST_PAYLOAD_COMPRESSOR_HANDLE, body, bodySize, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_compressed(&compressed, sizeof(compressed))
+        .CopyOutArgumentBuffer_compressed_size(&compressedSize, sizeof(compressedSize));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, "content-encoding", "deflate"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetByteArray((IOTHUB_MESSAGE_HANDLE)0x44, compressed, compressedSize));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_029: [ Events whose body is shorter than the compression threshold, that already have a "content-encoding" property or that would not get smaller shall be queued unchanged. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_does_not_compress_events_below_the_threshold)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"aaa";
+    size_t bodySize = TEST_COMPRESSION_THRESHOLD - 1;
+    bool isEncoded = false;
+    umock_c_reset_all_calls();
+
+    setup_compress_event_expectations(&body, &bodySize, &isEncoded);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_029: [ Events whose body is shorter than the compression threshold, that already have a "content-encoding" property or that would not get smaller shall be queued unchanged. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_does_not_compress_already_encoded_events)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"aaaaaaaa";
+    size_t bodySize = 8;
+    bool isEncoded = true;
+    umock_c_reset_all_calls();
+
+    setup_compress_event_expectations(&body, &bodySize, &isEncoded);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_029: [ Events whose body is shorter than the compression threshold, that already have a "content-encoding" property or that would not get smaller shall be queued unchanged. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_queues_the_event_unchanged_when_it_does_not_get_smaller)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"abcdefgh";
+    size_t bodySize = 8;
+    bool isEncoded = false;
+    umock_c_reset_all_calls();
+
+    setup_compress_event_expectations(&body, &bodySize, &isEncoded);
+    STRICT_EXPECTED_CALL(payload_compressor_deflate(TEST_PAYLOAD_COMPRESSOR_HANDLE, body, bodySize, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_compressed()
+        .IgnoreArgument_compressed_size()
+        .SetReturn(__FAILURE__);
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_030: [ If the compressed body or its "content-encoding" property cannot be set, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_fails_when_the_compressed_body_cannot_be_set)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"aaaaaaaa";
+    size_t bodySize = 8;
+    bool isEncoded = false;
+    const unsigned char* compressed = (const unsigned char*)"zz";
+    size_t compressedSize = 2;
+    umock_c_reset_all_calls();
+
+    setup_compress_event_expectations(&body, &bodySize, &isEncoded);
+    STRICT_EXPECTED_CALL(payload_compressor_deflate(TEST_PAYLOAD_COMPRESSOR_HANDLE, body, bodySize, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_compressed(&compressed, sizeof(compressed))
+        .CopyOutArgumentBuffer_compressed_size(&compressedSize, sizeof(compressedSize));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, "content-encoding", "deflate"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetByteArray((IOTHUB_MESSAGE_HANDLE)0x44, compressed, compressedSize))
+        .SetReturn(IOTHUB_MESSAGE_ERROR);
+    STRICT_EXPECTED_CALL(Map_Delete(IGNORED_PTR_ARG, "content-encoding"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)0x44));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_030: [ If the compressed body or its "content-encoding" property cannot be set, IoTHubClient_LL_SendEventAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+/*Tests_SRS_IOTHUBCLIENT_LL_01_003: [ On success the IoTHubClient_LL instance owns eventMessageHandle and shall destroy it once the message is confirmed or timed out. On failure the ownership stays with the caller. ]*/
+TEST_FUNCTION(IoTHubClient_LL_SendEventAsync_Move_releases_the_stored_event_and_keeps_the_message_when_compression_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    const unsigned char* body = (const unsigned char*)"aaaaaaaa";
+    size_t bodySize = 8;
+    const char* const* keys = NULL;
+    size_t propertyCount = 0;
+    bool isEncoded = false;
+    const unsigned char* compressed = (const unsigned char*)"zz";
+    size_t compressedSize = 2;
+    (void)IoTHubClient_LL_SetOption(handle, "outbound_store_path", TEST_OUTBOUND_STORE_PATH);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    setup_store_outbound_event_expectations(&body, &bodySize, &keys, &propertyCount);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(outbound_store_append(TEST_OUTBOUND_STORE_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_data()
+        .IgnoreArgument_size()
+        .IgnoreArgument_sequence();
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE))
+        .SetReturn(IOTHUBMESSAGE_BYTEARRAY);
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_buffer(&body, sizeof(body))
+        .CopyOutArgumentBuffer_size(&bodySize, sizeof(bodySize));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, "content-encoding", IGNORED_PTR_ARG))
+        .IgnoreArgument_handle()
+        .CopyOutArgumentBuffer_keyExists(&isEncoded, sizeof(isEncoded));
+    STRICT_EXPECTED_CALL(payload_compressor_deflate(TEST_PAYLOAD_COMPRESSOR_HANDLE, body, bodySize, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_compressed(&compressed, sizeof(compressed))
+        .CopyOutArgumentBuffer_compressed_size(&compressedSize, sizeof(compressedSize));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, "content-encoding", "deflate"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetByteArray(TEST_MESSAGE_HANDLE, compressed, compressedSize))
+        .SetReturn(IOTHUB_MESSAGE_ERROR);
+    STRICT_EXPECTED_CALL(Map_Delete(IGNORED_PTR_ARG, "content-encoding"))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(outbound_store_release(TEST_OUTBOUND_STORE_HANDLE, IGNORED_NUM_ARG))
+        .IgnoreArgument_sequence();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_LL_SendEventAsync_Move(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_LL_Destroy(handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_LL_01_032: [ IoTHubClient_LL_Destroy shall destroy the payload compressor. ]*/
+TEST_FUNCTION(IoTHubClient_LL_Destroy_destroys_the_payload_compressor)
+{
+    //arrange
+    IOTHUB_CLIENT_LL_HANDLE handle = create_with_compression();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(payload_compressor_destroy(TEST_PAYLOAD_COMPRESSOR_HANDLE));
+
+    //act
+    IoTHubClient_LL_Destroy(handle);
+
+    //assert
+    /*the other calls made by IoTHubClient_LL_Destroy are covered by its own tests*/
+    ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+}
+#endif /*USE_COMPRESSION*/
+
 END_TEST_SUITE(iothubclient_ll_ut)
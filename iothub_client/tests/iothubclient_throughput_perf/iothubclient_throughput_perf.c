@@ -0,0 +1,618 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*offline throughput benchmark: N independent device clients send telemetry as fast as their send window allows to a
+loopback mock hub that acknowledges every message as soon as it has been read. The result is a single key=value line so
+that runs can be diffed and graphed*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub_client.h"
+#include "iothub_client_ll.h"
+#include "iothub_message.h"
+#include "iothub_client_options.h"
+#include "iothubtransporthttp.h"
+
+#include "mock_hub.h"
+#include "loopback_transport.h"
+
+#define MAX_PROPERTIES  64
+
+typedef enum BENCH_API_TAG
+{
+    BENCH_API_LL,
+    BENCH_API_CONVENIENCE
+} BENCH_API;
+
+typedef struct BENCH_OPTIONS_TAG
+{
+    MOCK_HUB_PROTOCOL protocol;
+    BENCH_API api;
+    size_t devices;
+    size_t messages;
+    size_t payload;
+    size_t properties;
+    size_t window;
+    unsigned int timeout;
+    bool httpBatching;
+    bool move;
+    const char* store; /*NULL unless --store was given*/
+    unsigned int pool;
+} BENCH_OPTIONS;
+
+typedef struct BENCH_DEVICE_TAG
+{
+    IOTHUB_CLIENT_LL_HANDLE llHandle;
+    IOTHUB_CLIENT_HANDLE handle;
+    size_t sent;
+    size_t outstanding;
+} BENCH_DEVICE;
+
+typedef struct BENCH_SEND_CONTEXT_TAG
+{
+    BENCH_DEVICE* device;
+    uint64_t sentAt;
+} BENCH_SEND_CONTEXT;
+
+typedef struct BENCH_STATE_TAG
+{
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    BENCH_SEND_CONTEXT* sendContexts;
+    uint64_t* latencies;
+    size_t confirmed;
+    size_t failed;
+    uint64_t sendTime; /*spent in IoTHubClient_(LL_)SendEventAsync, that is where the outbound store appends*/
+    uint64_t doWorkTime; /*spent in IoTHubClient_LL_DoWork, that is where the transports build and publish the messages*/
+} BENCH_STATE;
+
+static BENCH_STATE state;
+static char propertyNames[MAX_PROPERTIES][16];
+static char propertyValues[MAX_PROPERTIES][16];
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+/*the executable is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so every allocation made by the SDK
+and by the shared utility library is counted here*/
+static volatile size_t allocationCount;
+
+extern void* __real_malloc(size_t size);
+extern void* __real_calloc(size_t count, size_t size);
+extern void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    (void)__sync_fetch_and_add(&allocationCount, 1);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    (void)__sync_fetch_and_add(&allocationCount, 1);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    (void)__sync_fetch_and_add(&allocationCount, 1);
+    return __real_realloc(ptr, size);
+}
+
+static size_t get_allocation_count(void)
+{
+    return __sync_fetch_and_add(&allocationCount, 0);
+}
+#else
+static size_t get_allocation_count(void)
+{
+    return 0;
+}
+#endif
+
+static uint64_t get_time_us(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint64_t leftValue = *(const uint64_t*)left;
+    uint64_t rightValue = *(const uint64_t*)right;
+    return (leftValue < rightValue) ? -1 : (leftValue > rightValue) ? 1 : 0;
+}
+
+static void print_usage(const char* name)
+{
+    (void)printf("usage: %s [--transport mqtt|amqp|http] [--api ll|convenience] [--devices N] [--messages N]\n"
+        "       [--payload BYTES] [--properties N] [--window N] [--timeout SECONDS] [--http-batching] [--move]\n"
+        "       [--store PATH] [--pool N]\n"
+        "  --messages is per device, --window is the number of unconfirmed messages allowed per device\n"
+        "  --store keeps the events of every device in an outbound store at PATH-<deviceId>\n"
+        "  --pool preallocates N message records per device (message_pool_size)\n", name);
+}
+
+static int parse_options(int argc, char** argv, BENCH_OPTIONS* options)
+{
+    int result = 0;
+    int index;
+
+    options->protocol = MOCK_HUB_PROTOCOL_MQTT;
+    options->api = BENCH_API_LL;
+    options->devices = 1;
+    options->messages = 10000;
+    options->payload = 256;
+    options->properties = 0;
+    options->window = 100;
+    options->timeout = 60;
+    options->httpBatching = false;
+    options->move = false;
+    options->store = NULL;
+    options->pool = 0;
+
+    for (index = 1; (result == 0) && (index < argc); index++)
+    {
+        const char* value = (index + 1 < argc) ? argv[index + 1] : NULL;
+        if (strcmp(argv[index], "--http-batching") == 0)
+        {
+            options->httpBatching = true;
+        }
+        else if (strcmp(argv[index], "--move") == 0)
+        {
+            options->move = true;
+        }
+        else if (value == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            index++;
+            if (strcmp(argv[index - 1], "--transport") == 0)
+            {
+                if (strcmp(value, "mqtt") == 0)
+                {
+                    options->protocol = MOCK_HUB_PROTOCOL_MQTT;
+                }
+                else if (strcmp(value, "amqp") == 0)
+                {
+                    options->protocol = MOCK_HUB_PROTOCOL_AMQP;
+                }
+                else if (strcmp(value, "http") == 0)
+                {
+                    options->protocol = MOCK_HUB_PROTOCOL_HTTP;
+                }
+                else
+                {
+                    result = 1;
+                }
+            }
+            else if (strcmp(argv[index - 1], "--api") == 0)
+            {
+                if (strcmp(value, "ll") == 0)
+                {
+                    options->api = BENCH_API_LL;
+                }
+                else if (strcmp(value, "convenience") == 0)
+                {
+                    options->api = BENCH_API_CONVENIENCE;
+                }
+                else
+                {
+                    result = 1;
+                }
+            }
+            else if (strcmp(argv[index - 1], "--devices") == 0)
+            {
+                options->devices = (size_t)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--messages") == 0)
+            {
+                options->messages = (size_t)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--payload") == 0)
+            {
+                options->payload = (size_t)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--properties") == 0)
+            {
+                options->properties = (size_t)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--window") == 0)
+            {
+                options->window = (size_t)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--timeout") == 0)
+            {
+                options->timeout = (unsigned int)strtoul(value, NULL, 10);
+            }
+            else if (strcmp(argv[index - 1], "--store") == 0)
+            {
+                options->store = value;
+            }
+            else if (strcmp(argv[index - 1], "--pool") == 0)
+            {
+                options->pool = (unsigned int)strtoul(value, NULL, 10);
+            }
+            else
+            {
+                result = 1;
+            }
+        }
+    }
+
+    if ((result == 0) &&
+        ((options->devices == 0) || (options->messages == 0) || (options->window == 0) || (options->timeout == 0) || (options->properties > MAX_PROPERTIES)))
+    {
+        result = 1;
+    }
+    return result;
+}
+
+static void on_send_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    BENCH_SEND_CONTEXT* sendContext = (BENCH_SEND_CONTEXT*)userContextCallback;
+    uint64_t latency = get_time_us() - sendContext->sentAt;
+
+    /*the LL run is single threaded, the lock only matters for the convenience layer's worker threads*/
+    (void)Lock(state.lock);
+    if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        state.latencies[state.confirmed++] = latency;
+    }
+    else
+    {
+        state.failed++;
+    }
+    sendContext->device->outstanding--;
+    (void)Condition_Post(state.condition);
+    (void)Unlock(state.lock);
+}
+
+static IOTHUB_CLIENT_RESULT send_one(const BENCH_OPTIONS* options, BENCH_DEVICE* device, BENCH_SEND_CONTEXT* sendContext, const unsigned char* payload)
+{
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_CreateFromByteArray(payload, options->payload);
+    if (message == NULL)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        MAP_HANDLE properties = IoTHubMessage_Properties(message);
+        size_t index;
+
+        result = IOTHUB_CLIENT_OK;
+        for (index = 0; (result == IOTHUB_CLIENT_OK) && (index < options->properties); index++)
+        {
+            if (Map_AddOrUpdate(properties, propertyNames[index], propertyValues[index]) != MAP_OK)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+            }
+        }
+
+        if (result == IOTHUB_CLIENT_OK)
+        {
+            sendContext->device = device;
+            sendContext->sentAt = get_time_us();
+            if (options->api == BENCH_API_LL)
+            {
+                result = options->move ?
+                    IoTHubClient_LL_SendEventAsync_Move(device->llHandle, message, on_send_confirmation, sendContext) :
+                    IoTHubClient_LL_SendEventAsync(device->llHandle, message, on_send_confirmation, sendContext);
+            }
+            else
+            {
+                result = options->move ?
+                    IoTHubClient_SendEventAsync_Move(device->handle, message, on_send_confirmation, sendContext) :
+                    IoTHubClient_SendEventAsync(device->handle, message, on_send_confirmation, sendContext);
+            }
+        }
+
+        /*on success a moved message belongs to the client*/
+        if (!options->move || (result != IOTHUB_CLIENT_OK))
+        {
+            IoTHubMessage_Destroy(message);
+        }
+    }
+    return result;
+}
+
+static IOTHUB_CLIENT_TRANSPORT_PROVIDER get_protocol(MOCK_HUB_PROTOCOL protocol)
+{
+    IOTHUB_CLIENT_TRANSPORT_PROVIDER result;
+    switch (protocol)
+    {
+        case MOCK_HUB_PROTOCOL_MQTT: result = LoopbackMQTT_Protocol; break;
+        case MOCK_HUB_PROTOCOL_AMQP: result = LoopbackAMQP_Protocol; break;
+        default: result = HTTP_Protocol; break;
+    }
+    return result;
+}
+
+static const char* get_protocol_name(MOCK_HUB_PROTOCOL protocol)
+{
+    return (protocol == MOCK_HUB_PROTOCOL_MQTT) ? "mqtt" : (protocol == MOCK_HUB_PROTOCOL_AMQP) ? "amqp" : "http";
+}
+
+static char* get_store_path(const BENCH_OPTIONS* options, const char* deviceId)
+{
+    char* result = (char*)malloc(strlen(options->store) + 1 + strlen(deviceId) + 1);
+    if (result != NULL)
+    {
+        (void)sprintf(result, "%s-%s", options->store, deviceId);
+    }
+    return result;
+}
+
+static int create_devices(const BENCH_OPTIONS* options, BENCH_DEVICE* devices)
+{
+    int result = 0;
+    size_t index;
+    for (index = 0; (result == 0) && (index < options->devices); index++)
+    {
+        char deviceId[32];
+        char* storePath = NULL;
+        IOTHUB_CLIENT_CONFIG config;
+        (void)sprintf(deviceId, "bench-device-%lu", (unsigned long)index);
+
+        /*neither deviceKey nor deviceSasToken: x509 authentication, so AMQP needs neither SASL nor CBS*/
+        (void)memset(&config, 0, sizeof(config));
+        config.protocol = get_protocol(options->protocol);
+        config.deviceId = deviceId;
+        config.iotHubName = "mock-hub";
+        config.iotHubSuffix = "localhost";
+
+        if (options->api == BENCH_API_LL)
+        {
+            if ((devices[index].llHandle = IoTHubClient_LL_Create(&config)) == NULL)
+            {
+                result = 1;
+            }
+            else if (options->httpBatching && (IoTHubClient_LL_SetOption(devices[index].llHandle, OPTION_BATCHING, &options->httpBatching) != IOTHUB_CLIENT_OK))
+            {
+                result = 1;
+            }
+            else if ((options->store != NULL) &&
+                (((storePath = get_store_path(options, deviceId)) == NULL) ||
+                (IoTHubClient_LL_SetOption(devices[index].llHandle, OPTION_OUTBOUND_STORE_PATH, storePath) != IOTHUB_CLIENT_OK)))
+            {
+                result = 1;
+            }
+            else if ((options->pool != 0) && (IoTHubClient_LL_SetOption(devices[index].llHandle, OPTION_MESSAGE_POOL_SIZE, &options->pool) != IOTHUB_CLIENT_OK))
+            {
+                result = 1;
+            }
+        }
+        else
+        {
+            if ((devices[index].handle = IoTHubClient_Create(&config)) == NULL)
+            {
+                result = 1;
+            }
+            else if (options->httpBatching && (IoTHubClient_SetOption(devices[index].handle, OPTION_BATCHING, &options->httpBatching) != IOTHUB_CLIENT_OK))
+            {
+                result = 1;
+            }
+            else if ((options->store != NULL) &&
+                (((storePath = get_store_path(options, deviceId)) == NULL) ||
+                (IoTHubClient_SetOption(devices[index].handle, OPTION_OUTBOUND_STORE_PATH, storePath) != IOTHUB_CLIENT_OK)))
+            {
+                result = 1;
+            }
+            else if ((options->pool != 0) && (IoTHubClient_SetOption(devices[index].handle, OPTION_MESSAGE_POOL_SIZE, &options->pool) != IOTHUB_CLIENT_OK))
+            {
+                result = 1;
+            }
+        }
+        free(storePath);
+    }
+    return result;
+}
+
+static void destroy_devices(const BENCH_OPTIONS* options, BENCH_DEVICE* devices)
+{
+    size_t index;
+    for (index = 0; index < options->devices; index++)
+    {
+        if (devices[index].llHandle != NULL)
+        {
+            IoTHubClient_LL_Destroy(devices[index].llHandle);
+        }
+        if (devices[index].handle != NULL)
+        {
+            IoTHubClient_Destroy(devices[index].handle);
+        }
+    }
+}
+
+/*returns once every message has been confirmed or failed, or when the timeout expires*/
+static void run(const BENCH_OPTIONS* options, BENCH_DEVICE* devices, const unsigned char* payload, uint64_t deadline)
+{
+    size_t total = options->devices * options->messages;
+    bool isDone = false;
+
+    while (!isDone)
+    {
+        size_t index;
+        bool hasSent = false;
+
+        for (index = 0; index < options->devices; index++)
+        {
+            BENCH_DEVICE* device = &devices[index];
+            bool canSend;
+
+            (void)Lock(state.lock);
+            canSend = (device->sent < options->messages) && (device->outstanding < options->window);
+            while (canSend)
+            {
+                BENCH_SEND_CONTEXT* sendContext = &state.sendContexts[index * options->messages + device->sent];
+                device->outstanding++;
+                device->sent++;
+
+                /*the convenience layer may confirm on its own thread before send_one returns*/
+                (void)Unlock(state.lock);
+                uint64_t sendStart = get_time_us();
+                IOTHUB_CLIENT_RESULT sendResult = send_one(options, device, sendContext, payload);
+                uint64_t sendTime = get_time_us() - sendStart;
+                (void)Lock(state.lock);
+                state.sendTime += sendTime;
+                if (sendResult != IOTHUB_CLIENT_OK)
+                {
+                    device->outstanding--;
+                    state.failed++;
+                }
+                hasSent = true;
+                canSend = (device->sent < options->messages) && (device->outstanding < options->window);
+            }
+            (void)Unlock(state.lock);
+
+            if (options->api == BENCH_API_LL)
+            {
+                uint64_t doWorkStart = get_time_us();
+                IoTHubClient_LL_DoWork(device->llHandle);
+                state.doWorkTime += get_time_us() - doWorkStart;
+            }
+        }
+
+        (void)Lock(state.lock);
+        isDone = (state.confirmed + state.failed == total) || (get_time_us() > deadline);
+        if (!isDone && !hasSent && (options->api == BENCH_API_CONVENIENCE))
+        {
+            (void)Condition_Wait(state.condition, state.lock, 100);
+        }
+        (void)Unlock(state.lock);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    BENCH_OPTIONS options;
+
+    if (parse_options(argc, argv, &options) != 0)
+    {
+        print_usage(argv[0]);
+        result = 2;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\n");
+        result = 1;
+    }
+    else
+    {
+        size_t total = options.devices * options.messages;
+        MOCK_HUB_HANDLE hub;
+        BENCH_DEVICE* devices = (BENCH_DEVICE*)calloc(options.devices, sizeof(BENCH_DEVICE));
+        unsigned char* payload = (unsigned char*)malloc(options.payload + 1);
+        size_t index;
+
+        (void)signal(SIGPIPE, SIG_IGN);
+        for (index = 0; index < options.properties; index++)
+        {
+            (void)sprintf(propertyNames[index], "property%lu", (unsigned long)index);
+            (void)sprintf(propertyValues[index], "value%lu", (unsigned long)index);
+        }
+
+        (void)memset(&state, 0, sizeof(state));
+        state.sendContexts = (BENCH_SEND_CONTEXT*)calloc(total, sizeof(BENCH_SEND_CONTEXT));
+        state.latencies = (uint64_t*)calloc(total, sizeof(uint64_t));
+        state.lock = Lock_Init();
+        state.condition = Condition_Init();
+
+        if ((devices == NULL) || (payload == NULL) || (state.sendContexts == NULL) || (state.latencies == NULL) ||
+            (state.lock == NULL) || (state.condition == NULL))
+        {
+            (void)printf("unable to allocate the benchmark state\n");
+            result = 1;
+        }
+        else if ((hub = mock_hub_start(options.protocol)) == NULL)
+        {
+            (void)printf("unable to start the mock hub\n");
+            result = 1;
+        }
+        else
+        {
+            (void)memset(payload, 'x', options.payload);
+            loopback_transport_set_port(mock_hub_get_port(hub));
+
+            if (create_devices(&options, devices) != 0)
+            {
+                (void)printf("unable to create the device clients\n");
+                result = 1;
+            }
+            else
+            {
+                uint64_t start;
+                uint64_t elapsed;
+                size_t allocationsBefore;
+                size_t allocations;
+                struct rusage usage;
+                double elapsedSeconds;
+                double p50;
+                double p99;
+
+                allocationsBefore = get_allocation_count();
+                start = get_time_us();
+                run(&options, devices, payload, start + (uint64_t)options.timeout * 1000000);
+                elapsed = get_time_us() - start;
+                allocations = get_allocation_count() - allocationsBefore;
+
+                (void)Lock(state.lock);
+                qsort(state.latencies, state.confirmed, sizeof(uint64_t), compare_latencies);
+                p50 = (state.confirmed == 0) ? 0.0 : (double)state.latencies[(state.confirmed - 1) / 2] / 1000.0;
+                p99 = (state.confirmed == 0) ? 0.0 : (double)state.latencies[((state.confirmed - 1) * 99) / 100] / 1000.0;
+                elapsedSeconds = (double)elapsed / 1000000.0;
+                (void)getrusage(RUSAGE_SELF, &usage);
+
+                (void)printf("transport=%s api=%s store=%s pool=%lu devices=%lu payload=%lu properties=%lu messages=%lu confirmed=%lu failed=%lu "
+                    "elapsed_s=%.3f msgs_per_s=%.0f send_us_per_msg=%.2f dowork_us_per_msg=%.2f p50_ms=%.3f p99_ms=%.3f allocs_per_msg=%.1f peak_rss_kb=%ld hub_deliveries=%lu\n",
+                    get_protocol_name(options.protocol), (options.api == BENCH_API_LL) ? "ll" : "convenience", (options.store != NULL) ? "disk" : "memory", (unsigned long)options.pool,
+                    (unsigned long)options.devices, (unsigned long)options.payload, (unsigned long)options.properties,
+                    (unsigned long)total, (unsigned long)state.confirmed, (unsigned long)state.failed,
+                    elapsedSeconds, (elapsedSeconds > 0.0) ? (double)state.confirmed / elapsedSeconds : 0.0, (double)state.sendTime / (double)total, (double)state.doWorkTime / (double)total, p50, p99,
+                    (double)allocations / (double)total, usage.ru_maxrss, (unsigned long)mock_hub_get_delivery_count(hub));
+
+                result = (state.confirmed == total) ? 0 : 1;
+                (void)Unlock(state.lock);
+            }
+
+            destroy_devices(&options, devices);
+            mock_hub_stop(hub);
+        }
+
+        if (state.condition != NULL)
+        {
+            Condition_Deinit(state.condition);
+        }
+        if (state.lock != NULL)
+        {
+            (void)Lock_Deinit(state.lock);
+        }
+        free(state.latencies);
+        free(state.sendContexts);
+        free(payload);
+        free(devices);
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,405 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/buffer_.h"
+
+#include "iothubtransportmqtt.h"
+#include "iothubtransportamqp.h"
+#include "iothubtransport_mqtt_common.h"
+#include "iothubtransport_amqp_common.h"
+#include "loopback_transport.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define LOOPBACK_ADDRESS        "127.0.0.1"
+#define RESPONSE_CHUNK_SIZE     4096
+
+static int loopback_port;
+static TRANSPORT_PROVIDER loopbackMQTTProvider;
+static TRANSPORT_PROVIDER loopbackAMQPProvider;
+
+void loopback_transport_set_port(int port)
+{
+    loopback_port = port;
+}
+
+static XIO_HANDLE getLoopbackIoTransport(const char* fqdn)
+{
+    SOCKETIO_CONFIG socketio_config;
+    (void)fqdn;
+    socketio_config.hostname = LOOPBACK_ADDRESS;
+    socketio_config.port = loopback_port;
+    socketio_config.accepted_socket = NULL;
+    return xio_create(socketio_get_interface_description(), &socketio_config);
+}
+
+static TRANSPORT_LL_HANDLE LoopbackMQTT_Create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return IoTHubTransport_MQTT_Common_Create(config, getLoopbackIoTransport);
+}
+
+static TRANSPORT_LL_HANDLE LoopbackAMQP_Create(const IOTHUBTRANSPORT_CONFIG* config)
+{
+    return IoTHubTransport_AMQP_Common_Create(config, getLoopbackIoTransport);
+}
+
+const TRANSPORT_PROVIDER* LoopbackMQTT_Protocol(void)
+{
+    loopbackMQTTProvider = *MQTT_Protocol();
+    loopbackMQTTProvider.IoTHubTransport_Create = LoopbackMQTT_Create;
+    return &loopbackMQTTProvider;
+}
+
+const TRANSPORT_PROVIDER* LoopbackAMQP_Protocol(void)
+{
+    loopbackAMQPProvider = *AMQP_Protocol();
+    loopbackAMQPProvider.IoTHubTransport_Create = LoopbackAMQP_Create;
+    return &loopbackAMQPProvider;
+}
+
+/*the platform HTTPAPI only speaks https. The benchmark executable defines every HTTPAPI_* symbol itself, so the linker
+never pulls the platform one out of the shared utility library and HTTPAPIEX ends up on plain HTTP/1.1 over 127.0.0.1*/
+typedef struct HTTP_HANDLE_DATA_TAG
+{
+    int socket;
+    unsigned char* response;
+    size_t responseSize;
+    size_t responseUsed;
+} HTTP_HANDLE_DATA;
+
+static const char* const requestTypeNames[] = { "GET", "POST", "PUT", "DELETE", "PATCH" };
+
+static int send_all(int socket, const void* bytes, size_t length)
+{
+    int result = 0;
+    size_t sent = 0;
+    while ((result == 0) && (sent < length))
+    {
+        ssize_t written = send(socket, (const unsigned char*)bytes + sent, length - sent, MSG_NOSIGNAL);
+        if (written > 0)
+        {
+            sent += (size_t)written;
+        }
+        else if ((written < 0) && (errno == EINTR))
+        {
+            /*try again*/
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+    }
+    return result;
+}
+
+/*reads until the response holds at least "needed" bytes*/
+static int receive_at_least(HTTP_HANDLE_DATA* httpHandle, size_t needed)
+{
+    int result = 0;
+    while ((result == 0) && (httpHandle->responseUsed < needed))
+    {
+        ssize_t received;
+        if (httpHandle->responseSize - httpHandle->responseUsed < RESPONSE_CHUNK_SIZE)
+        {
+            size_t newSize = httpHandle->responseUsed + ((needed > httpHandle->responseUsed + RESPONSE_CHUNK_SIZE) ? needed - httpHandle->responseUsed : RESPONSE_CHUNK_SIZE);
+            unsigned char* newResponse = (unsigned char*)realloc(httpHandle->response, newSize);
+            if (newResponse == NULL)
+            {
+                LogError("unable to grow the response buffer");
+                result = __FAILURE__;
+                break;
+            }
+            httpHandle->response = newResponse;
+            httpHandle->responseSize = newSize;
+        }
+
+        received = recv(httpHandle->socket, httpHandle->response + httpHandle->responseUsed, httpHandle->responseSize - httpHandle->responseUsed, 0);
+        if (received > 0)
+        {
+            httpHandle->responseUsed += (size_t)received;
+        }
+        else if ((received < 0) && (errno == EINTR))
+        {
+            /*try again*/
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+    }
+    return result;
+}
+
+static size_t find_head_end(const HTTP_HANDLE_DATA* httpHandle)
+{
+    size_t result = 0;
+    size_t index;
+    for (index = 0; index + 4 <= httpHandle->responseUsed; index++)
+    {
+        if (memcmp(httpHandle->response + index, "\r\n\r\n", 4) == 0)
+        {
+            result = index + 4;
+            break;
+        }
+    }
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_Init(void)
+{
+    return HTTPAPI_OK;
+}
+
+void HTTPAPI_Deinit(void)
+{
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+    (void)hostName;
+    if ((result = (HTTP_HANDLE_DATA*)calloc(1, sizeof(HTTP_HANDLE_DATA))) == NULL)
+    {
+        LogError("unable to allocate the loopback HTTP connection");
+    }
+    else if ((result->socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        LogError("socket failed");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        struct sockaddr_in address;
+        int noDelay = 1;
+        (void)memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)loopback_port);
+        address.sin_addr.s_addr = inet_addr(LOOPBACK_ADDRESS);
+        (void)setsockopt(result->socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (connect(result->socket, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            LogError("unable to connect to %s:%d", LOOPBACK_ADDRESS, loopback_port);
+            (void)close(result->socket);
+            free(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        (void)close(handle->socket);
+        free(handle->response);
+        free(handle);
+    }
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+    size_t headerCount;
+
+    if ((handle == NULL) || (relativePath == NULL) || (httpHeadersHandle == NULL) ||
+        ((size_t)requestType >= sizeof(requestTypeNames) / sizeof(requestTypeNames[0])) ||
+        ((content == NULL) && (contentLength > 0)))
+    {
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headerCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_HTTP_HEADERS_FAILED;
+    }
+    else
+    {
+        /*the head is assembled in one go so that small requests leave in a single segment*/
+        size_t headLength = strlen(requestTypeNames[requestType]) + strlen(relativePath) + 64;
+        char** headers = (char**)calloc(headerCount + 1, sizeof(char*));
+        char* head = NULL;
+        bool hasContentLength = false;
+        size_t index;
+
+        result = (headers == NULL) ? HTTPAPI_ALLOC_FAILED : HTTPAPI_OK;
+        for (index = 0; (result == HTTPAPI_OK) && (index < headerCount); index++)
+        {
+            if (HTTPHeaders_GetHeader(httpHeadersHandle, index, &headers[index]) != HTTP_HEADERS_OK)
+            {
+                result = HTTPAPI_HTTP_HEADERS_FAILED;
+            }
+            else
+            {
+                /*HTTPAPIEX normally supplies Content-Length itself*/
+                hasContentLength = hasContentLength || (strncmp(headers[index], "Content-Length:", 15) == 0);
+                headLength += strlen(headers[index]) + 2;
+            }
+        }
+
+        if ((result == HTTPAPI_OK) && ((head = (char*)malloc(headLength)) == NULL))
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+
+        if (result == HTTPAPI_OK)
+        {
+            size_t used = (size_t)sprintf(head, "%s %s HTTP/1.1\r\n", requestTypeNames[requestType], relativePath);
+            for (index = 0; index < headerCount; index++)
+            {
+                used += (size_t)sprintf(head + used, "%s\r\n", headers[index]);
+            }
+            if (!hasContentLength)
+            {
+                used += (size_t)sprintf(head + used, "Content-Length: %lu\r\n", (unsigned long)contentLength);
+            }
+            used += (size_t)sprintf(head + used, "\r\n");
+
+            if ((send_all(handle->socket, head, used) != 0) ||
+                ((contentLength > 0) && (send_all(handle->socket, content, contentLength) != 0)))
+            {
+                LogError("unable to send the HTTP request");
+                result = HTTPAPI_SEND_REQUEST_FAILED;
+            }
+        }
+
+        if (result == HTTPAPI_OK)
+        {
+            size_t headEnd;
+            handle->responseUsed = 0;
+            while (((headEnd = find_head_end(handle)) == 0) && (receive_at_least(handle, handle->responseUsed + 1) == 0))
+            {
+                /*keep reading the head*/
+            }
+
+            if (headEnd == 0)
+            {
+                LogError("unable to receive the HTTP response head");
+                result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
+            }
+            else
+            {
+                char* line = (char*)handle->response;
+                size_t bodyLength = 0;
+                unsigned int status = 0;
+
+                handle->response[headEnd - 2] = '\0';
+                if (sscanf(line, "HTTP/1.%*d %u", &status) != 1)
+                {
+                    LogError("malformed HTTP status line");
+                    result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
+                }
+
+                line = strstr(line, "\r\n");
+                while ((result == HTTPAPI_OK) && (line != NULL) && (line[2] != '\0'))
+                {
+                    char* name = line + 2;
+                    char* colon;
+                    line = strstr(name, "\r\n");
+                    if (line != NULL)
+                    {
+                        *line = '\0';
+                    }
+
+                    if ((colon = strchr(name, ':')) != NULL)
+                    {
+                        char* value = colon + 1;
+                        *colon = '\0';
+                        while (*value == ' ')
+                        {
+                            value++;
+                        }
+
+                        if (strcmp(name, "Content-Length") == 0)
+                        {
+                            bodyLength = (size_t)strtoul(value, NULL, 10);
+                        }
+
+                        if ((responseHeadersHandle != NULL) &&
+                            (HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, name, value) != HTTP_HEADERS_OK))
+                        {
+                            result = HTTPAPI_HTTP_HEADERS_FAILED;
+                        }
+                    }
+
+                    if (line != NULL)
+                    {
+                        *line = '\r';
+                    }
+                }
+
+                if (result == HTTPAPI_OK)
+                {
+                    if (receive_at_least(handle, headEnd + bodyLength) != 0)
+                    {
+                        LogError("unable to receive the HTTP response body");
+                        result = HTTPAPI_READ_DATA_FAILED;
+                    }
+                    else if ((responseContent != NULL) && (BUFFER_build(responseContent, handle->response + headEnd, bodyLength) != 0))
+                    {
+                        result = HTTPAPI_ALLOC_FAILED;
+                    }
+                    else
+                    {
+                        if (statusCode != NULL)
+                        {
+                            *statusCode = status;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (headers != NULL)
+        {
+            for (index = 0; index < headerCount; index++)
+            {
+                free(headers[index]);
+            }
+            free(headers);
+        }
+        free(head);
+    }
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)optionName;
+    (void)value;
+    return HTTPAPI_OK;
+}
+
+HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
+{
+    (void)optionName;
+    (void)value;
+    (void)savedValue;
+    return HTTPAPI_INVALID_ARG;
+}
@@ -0,0 +1,26 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include "iothub_transport_ll.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*every transport created after this call connects in clear text to 127.0.0.1:port instead of the hub's TLS endpoint*/
+extern void loopback_transport_set_port(int port);
+
+/*the MQTT and AMQP providers, only with IoTHubTransport_Create replaced so that the transport runs over a socketio.
+HTTP needs no provider of its own: the benchmark links its own HTTPAPI (see loopback_transport.c)*/
+extern const TRANSPORT_PROVIDER* LoopbackMQTT_Protocol(void);
+extern const TRANSPORT_PROVIDER* LoopbackAMQP_Protocol(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOPBACK_TRANSPORT_H */
@@ -0,0 +1,1336 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+
+#include "mock_hub.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define MAX_CONNECTIONS             256
+#define POLL_PERIOD_MS              100
+#define RECEIVE_CHUNK_SIZE          65536
+
+#define AMQP_MAX_FRAME_SIZE         (1024 * 1024)
+#define AMQP_MAX_SESSIONS           4
+#define AMQP_MAX_LINKS              8
+#define AMQP_LINK_CREDIT            5000
+#define AMQP_KEEPALIVE_PERIOD_MS    1000
+#define AMQP_PERFORMATIVE_SIZE      4096
+
+#define AMQP_OPEN                   0x10
+#define AMQP_BEGIN                  0x11
+#define AMQP_ATTACH                 0x12
+#define AMQP_FLOW                   0x13
+#define AMQP_TRANSFER               0x14
+#define AMQP_DISPOSITION            0x15
+#define AMQP_DETACH                 0x16
+#define AMQP_END                    0x17
+#define AMQP_CLOSE                  0x18
+#define AMQP_ACCEPTED               0x24
+
+static const unsigned char AMQP_HEADER[] = { 'A', 'M', 'Q', 'P', 0, 1, 0, 0 };
+static const unsigned char AMQP_EMPTY_FRAME[] = { 0, 0, 0, 8, 2, 0, 0, 0 };
+static const char HTTP_NO_CONTENT_RESPONSE[] = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n";
+
+typedef struct AMQP_LINK_TAG
+{
+    bool isUsed;
+    uint32_t handle;
+    bool isTelemetry; /*the client is the sender on this link, so the hub grants credit and settles the deliveries*/
+    uint32_t deliveryCount;
+    uint32_t creditLeft;
+    uint32_t deliveryId;
+    bool isSettled;
+} AMQP_LINK;
+
+typedef struct AMQP_SESSION_TAG
+{
+    bool isUsed;
+    uint16_t channel;
+    uint32_t nextIncomingId;
+    bool hasPendingDisposition;
+    uint32_t pendingFirst;
+    uint32_t pendingLast;
+    AMQP_LINK links[AMQP_MAX_LINKS];
+} AMQP_SESSION;
+
+typedef struct MOCK_HUB_CONNECTION_TAG
+{
+    struct MOCK_HUB_TAG* hub;
+    int socket;
+    THREAD_HANDLE thread;
+    unsigned char* input;
+    size_t inputSize;
+    size_t inputUsed;
+    unsigned char* output;
+    size_t outputSize;
+    size_t outputUsed;
+    size_t deliveries;
+    bool isClosing;
+    bool amqpHeaderReceived;
+    bool amqpOpened;
+    AMQP_SESSION sessions[AMQP_MAX_SESSIONS];
+} MOCK_HUB_CONNECTION;
+
+typedef int(*ON_BYTES_RECEIVED)(MOCK_HUB_CONNECTION* connection, const unsigned char* bytes, size_t length, size_t* consumed);
+
+typedef struct MOCK_HUB_TAG
+{
+    ON_BYTES_RECEIVED onBytesReceived;
+    bool isAmqp;
+    int listenSocket;
+    int port;
+    THREAD_HANDLE listenThread;
+    LOCK_HANDLE lock;
+    bool stop;
+    size_t deliveryCount;
+    size_t connectionCount;
+    MOCK_HUB_CONNECTION* connections[MAX_CONNECTIONS];
+} MOCK_HUB;
+
+typedef struct AMQP_WRITER_TAG
+{
+    unsigned char bytes[AMQP_PERFORMATIVE_SIZE];
+    size_t length;
+    bool overflow;
+} AMQP_WRITER;
+
+static bool is_stopping(MOCK_HUB* hub)
+{
+    bool result;
+    (void)Lock(hub->lock);
+    result = hub->stop;
+    (void)Unlock(hub->lock);
+    return result;
+}
+
+static uint16_t read_uint16(const unsigned char* bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+static uint32_t read_uint32(const unsigned char* bytes)
+{
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
+}
+
+static int output_append(MOCK_HUB_CONNECTION* connection, const void* bytes, size_t length)
+{
+    int result;
+    if (connection->outputUsed + length > connection->outputSize)
+    {
+        size_t newSize = (connection->outputSize == 0) ? 4096 : connection->outputSize;
+        unsigned char* newOutput;
+        while (newSize < connection->outputUsed + length)
+        {
+            newSize *= 2;
+        }
+
+        if ((newOutput = (unsigned char*)realloc(connection->output, newSize)) == NULL)
+        {
+            LogError("unable to grow the output buffer to %zu bytes", newSize);
+            result = __FAILURE__;
+        }
+        else
+        {
+            connection->output = newOutput;
+            connection->outputSize = newSize;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        (void)memcpy(connection->output + connection->outputUsed, bytes, length);
+        connection->outputUsed += length;
+    }
+    return result;
+}
+
+static int output_flush(MOCK_HUB_CONNECTION* connection)
+{
+    int result = 0;
+    size_t sent = 0;
+    while ((result == 0) && (sent < connection->outputUsed))
+    {
+        ssize_t written = send(connection->socket, connection->output + sent, connection->outputUsed - sent, MSG_NOSIGNAL);
+        if (written > 0)
+        {
+            sent += (size_t)written;
+        }
+        else if ((written < 0) && (errno == EINTR))
+        {
+            /*try again*/
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+    }
+    connection->outputUsed = 0;
+    return result;
+}
+
+/*MQTT 3.1.1: CONNECT, PUBLISH (QoS 0 and 1), SUBSCRIBE, UNSUBSCRIBE, PINGREQ and DISCONNECT*/
+static int mqtt_on_bytes_received(MOCK_HUB_CONNECTION* connection, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result = 0;
+    size_t position = 0;
+
+    while ((result == 0) && (!connection->isClosing) && (length - position >= 2))
+    {
+        size_t remainingLength = 0;
+        size_t headerLength = 1;
+        size_t multiplier = 1;
+        bool isComplete = false;
+
+        while ((headerLength <= 4) && (position + headerLength < length))
+        {
+            unsigned char encoded = bytes[position + headerLength];
+            remainingLength += (encoded & 0x7F) * multiplier;
+            multiplier *= 128;
+            headerLength++;
+            if ((encoded & 0x80) == 0)
+            {
+                isComplete = true;
+                break;
+            }
+        }
+
+        if (!isComplete)
+        {
+            if (headerLength > 4)
+            {
+                LogError("malformed MQTT remaining length");
+                result = __FAILURE__;
+            }
+            break;
+        }
+        else if (length - position - headerLength < remainingLength)
+        {
+            break;
+        }
+        else
+        {
+            const unsigned char* packet = bytes + position + headerLength;
+            unsigned char packetType = bytes[position] >> 4;
+
+            switch (packetType)
+            {
+                case 1: /*CONNECT*/
+                {
+                    static const unsigned char connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                    result = output_append(connection, connack, sizeof(connack));
+                    break;
+                }
+                case 3: /*PUBLISH*/
+                {
+                    unsigned char qos = (bytes[position] >> 1) & 0x03;
+                    size_t topicLength = (remainingLength >= 2) ? read_uint16(packet) : 0;
+                    connection->deliveries++;
+                    if (qos > 0)
+                    {
+                        if (remainingLength < 2 + topicLength + 2)
+                        {
+                            LogError("malformed MQTT PUBLISH");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            unsigned char puback[] = { 0x40, 0x02, 0x00, 0x00 };
+                            puback[2] = packet[2 + topicLength];
+                            puback[3] = packet[2 + topicLength + 1];
+                            result = output_append(connection, puback, sizeof(puback));
+                        }
+                    }
+                    break;
+                }
+                case 8: /*SUBSCRIBE*/
+                {
+                    unsigned char suback[4 + 32];
+                    size_t topicCount = 0;
+                    size_t index = 2;
+                    while ((result == 0) && (index + 2 <= remainingLength))
+                    {
+                        index += 2 + read_uint16(packet + index);
+                        if ((index >= remainingLength) || (topicCount == 32))
+                        {
+                            LogError("malformed or too large MQTT SUBSCRIBE");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            suback[4 + topicCount] = (packet[index] > 1) ? 1 : packet[index];
+                            topicCount++;
+                            index++;
+                        }
+                    }
+
+                    if (result == 0)
+                    {
+                        suback[0] = 0x90;
+                        suback[1] = (unsigned char)(2 + topicCount);
+                        suback[2] = packet[0];
+                        suback[3] = packet[1];
+                        result = output_append(connection, suback, 4 + topicCount);
+                    }
+                    break;
+                }
+                case 10: /*UNSUBSCRIBE*/
+                {
+                    unsigned char unsuback[] = { 0xB0, 0x02, 0x00, 0x00 };
+                    unsuback[2] = packet[0];
+                    unsuback[3] = packet[1];
+                    result = output_append(connection, unsuback, sizeof(unsuback));
+                    break;
+                }
+                case 12: /*PINGREQ*/
+                {
+                    static const unsigned char pingresp[] = { 0xD0, 0x00 };
+                    result = output_append(connection, pingresp, sizeof(pingresp));
+                    break;
+                }
+                case 14: /*DISCONNECT*/
+                {
+                    connection->isClosing = true;
+                    break;
+                }
+                default:
+                {
+                    /*PUBACK, PUBREC... are never expected from a device that only sends telemetry*/
+                    break;
+                }
+            }
+
+            position += headerLength + remainingLength;
+        }
+    }
+
+    *consumed = position;
+    return result;
+}
+
+/*HTTP/1.1 with Content-Length bodies, every request is answered with 204*/
+static int http_on_bytes_received(MOCK_HUB_CONNECTION* connection, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result = 0;
+    size_t position = 0;
+
+    while ((result == 0) && (position < length))
+    {
+        const char* request = (const char*)bytes + position;
+        size_t available = length - position;
+        size_t headLength = 0;
+        size_t contentLength = 0;
+        size_t index;
+
+        for (index = 0; index + 4 <= available; index++)
+        {
+            if (memcmp(request + index, "\r\n\r\n", 4) == 0)
+            {
+                headLength = index + 4;
+                break;
+            }
+        }
+
+        if (headLength == 0)
+        {
+            break;
+        }
+
+        for (index = 0; index + 2 < headLength; index++)
+        {
+            static const char contentLengthName[] = "\r\ncontent-length:";
+            size_t nameLength = sizeof(contentLengthName) - 1;
+            size_t character;
+            for (character = 0; character < nameLength && index + character < headLength; character++)
+            {
+                char c = request[index + character];
+                if ((c >= 'A') && (c <= 'Z'))
+                {
+                    c = (char)(c - 'A' + 'a');
+                }
+                if (c != contentLengthName[character])
+                {
+                    break;
+                }
+            }
+
+            if (character == nameLength)
+            {
+                contentLength = (size_t)strtoul(request + index + nameLength, NULL, 10);
+                break;
+            }
+        }
+
+        if (available - headLength < contentLength)
+        {
+            break;
+        }
+
+        if ((strncmp(request, "POST ", 5) == 0) && (strstr(request, "/messages/events") != NULL) && (strstr(request, "/messages/events") < request + headLength))
+        {
+            connection->deliveries++;
+        }
+
+        result = output_append(connection, HTTP_NO_CONTENT_RESPONSE, sizeof(HTTP_NO_CONTENT_RESPONSE) - 1);
+        position += headLength + contentLength;
+    }
+
+    *consumed = position;
+    return result;
+}
+
+/*AMQP 1.0 type system, just what is needed to walk the fields of a performative*/
+static size_t amqp_get_value_size(const unsigned char* bytes, size_t length)
+{
+    size_t result;
+    if (length == 0)
+    {
+        result = 0;
+    }
+    else if (bytes[0] == 0x00)
+    {
+        size_t descriptorSize = amqp_get_value_size(bytes + 1, length - 1);
+        size_t valueSize = (descriptorSize == 0) ? 0 : amqp_get_value_size(bytes + 1 + descriptorSize, length - 1 - descriptorSize);
+        result = (valueSize == 0) ? 0 : 1 + descriptorSize + valueSize;
+    }
+    else
+    {
+        size_t width;
+        switch (bytes[0] >> 4)
+        {
+            case 0x4: width = 0; break;
+            case 0x5: width = 1; break;
+            case 0x6: width = 2; break;
+            case 0x7: width = 4; break;
+            case 0x8: width = 8; break;
+            case 0x9: width = 16; break;
+            case 0xA: case 0xC: case 0xE: width = (length >= 2) ? (size_t)1 + bytes[1] : length; break;
+            case 0xB: case 0xD: case 0xF: width = (length >= 5) ? (size_t)4 + read_uint32(bytes + 1) : length; break;
+            default: width = length; break;
+        }
+        result = (1 + width <= length) ? 1 + width : 0;
+    }
+    return result;
+}
+
+static int amqp_get_list(const unsigned char* bytes, size_t length, const unsigned char** fields, size_t* fieldsLength, uint32_t* count)
+{
+    int result;
+    if ((length >= 1) && (bytes[0] == 0x45))
+    {
+        *fields = bytes + 1;
+        *fieldsLength = 0;
+        *count = 0;
+        result = 0;
+    }
+    else if ((length >= 3) && (bytes[0] == 0xC0) && ((size_t)bytes[1] + 2 <= length) && (bytes[1] >= 1))
+    {
+        *fields = bytes + 3;
+        *fieldsLength = (size_t)bytes[1] - 1;
+        *count = bytes[2];
+        result = 0;
+    }
+    else if ((length >= 9) && (bytes[0] == 0xD0) && ((size_t)read_uint32(bytes + 1) + 5 <= length) && (read_uint32(bytes + 1) >= 4))
+    {
+        *fields = bytes + 9;
+        *fieldsLength = (size_t)read_uint32(bytes + 1) - 4;
+        *count = read_uint32(bytes + 5);
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+    return result;
+}
+
+/*returns the encoded field, or NULL when the field is absent (missing from the end of the list)*/
+static const unsigned char* amqp_get_field(const unsigned char* fields, size_t fieldsLength, uint32_t count, uint32_t index, size_t* fieldLength)
+{
+    const unsigned char* result = NULL;
+    size_t position = 0;
+    uint32_t current;
+    for (current = 0; current < count; current++)
+    {
+        size_t size = amqp_get_value_size(fields + position, fieldsLength - position);
+        if (size == 0)
+        {
+            break;
+        }
+        else if (current == index)
+        {
+            result = fields + position;
+            *fieldLength = size;
+            break;
+        }
+        position += size;
+    }
+    return result;
+}
+
+static bool amqp_get_uint(const unsigned char* fields, size_t fieldsLength, uint32_t count, uint32_t index, uint32_t* value)
+{
+    size_t fieldLength = 0;
+    const unsigned char* field = amqp_get_field(fields, fieldsLength, count, index, &fieldLength);
+    bool result = true;
+    if (field == NULL)
+    {
+        result = false;
+    }
+    else if (field[0] == 0x43)
+    {
+        *value = 0;
+    }
+    else if (((field[0] == 0x52) || (field[0] == 0x50)) && (fieldLength >= 2))
+    {
+        *value = field[1];
+    }
+    else if ((field[0] == 0x60) && (fieldLength >= 3))
+    {
+        *value = read_uint16(field + 1);
+    }
+    else if ((field[0] == 0x70) && (fieldLength >= 5))
+    {
+        *value = read_uint32(field + 1);
+    }
+    else
+    {
+        result = false;
+    }
+    return result;
+}
+
+static bool amqp_get_bool(const unsigned char* fields, size_t fieldsLength, uint32_t count, uint32_t index, bool defaultValue)
+{
+    size_t fieldLength = 0;
+    const unsigned char* field = amqp_get_field(fields, fieldsLength, count, index, &fieldLength);
+    bool result;
+    if (field == NULL)
+    {
+        result = defaultValue;
+    }
+    else if (field[0] == 0x41)
+    {
+        result = true;
+    }
+    else if ((field[0] == 0x56) && (fieldLength >= 2))
+    {
+        result = (field[1] != 0);
+    }
+    else if (field[0] == 0x42)
+    {
+        result = false;
+    }
+    else
+    {
+        result = defaultValue;
+    }
+    return result;
+}
+
+static void amqp_write_bytes(AMQP_WRITER* writer, const void* bytes, size_t length)
+{
+    if (writer->length + length > sizeof(writer->bytes))
+    {
+        writer->overflow = true;
+    }
+    else
+    {
+        (void)memcpy(writer->bytes + writer->length, bytes, length);
+        writer->length += length;
+    }
+}
+
+static void amqp_write_byte(AMQP_WRITER* writer, unsigned char value)
+{
+    amqp_write_bytes(writer, &value, 1);
+}
+
+static void amqp_write_uint(AMQP_WRITER* writer, uint32_t value)
+{
+    unsigned char encoded[5];
+    encoded[0] = 0x70;
+    encoded[1] = (unsigned char)(value >> 24);
+    encoded[2] = (unsigned char)(value >> 16);
+    encoded[3] = (unsigned char)(value >> 8);
+    encoded[4] = (unsigned char)value;
+    amqp_write_bytes(writer, encoded, sizeof(encoded));
+}
+
+static void amqp_write_ushort(AMQP_WRITER* writer, uint16_t value)
+{
+    unsigned char encoded[3];
+    encoded[0] = 0x60;
+    encoded[1] = (unsigned char)(value >> 8);
+    encoded[2] = (unsigned char)value;
+    amqp_write_bytes(writer, encoded, sizeof(encoded));
+}
+
+static void amqp_write_bool(AMQP_WRITER* writer, bool value)
+{
+    amqp_write_byte(writer, value ? 0x41 : 0x42);
+}
+
+static void amqp_write_field_or_null(AMQP_WRITER* writer, const unsigned char* field, size_t fieldLength)
+{
+    if (field == NULL)
+    {
+        amqp_write_byte(writer, 0x40);
+    }
+    else
+    {
+        amqp_write_bytes(writer, field, fieldLength);
+    }
+}
+
+/*every performative is written as a described list32, the size and count are patched by amqp_end_performative*/
+static void amqp_begin_performative(AMQP_WRITER* writer, unsigned char descriptor)
+{
+    static const unsigned char listHeader[9] = { 0xD0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    writer->length = 0;
+    writer->overflow = false;
+    amqp_write_byte(writer, 0x00);
+    amqp_write_byte(writer, 0x53);
+    amqp_write_byte(writer, descriptor);
+    amqp_write_bytes(writer, listHeader, sizeof(listHeader));
+}
+
+static int amqp_end_performative(MOCK_HUB_CONNECTION* connection, AMQP_WRITER* writer, uint16_t channel, uint32_t fieldCount)
+{
+    int result;
+    if (writer->overflow)
+    {
+        LogError("AMQP performative does not fit in %d bytes", AMQP_PERFORMATIVE_SIZE);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t listSize = (uint32_t)(writer->length - 3 - 5);
+        uint32_t frameSize = (uint32_t)(writer->length + 8);
+        unsigned char frameHeader[8];
+
+        writer->bytes[4] = (unsigned char)(listSize >> 24);
+        writer->bytes[5] = (unsigned char)(listSize >> 16);
+        writer->bytes[6] = (unsigned char)(listSize >> 8);
+        writer->bytes[7] = (unsigned char)listSize;
+        writer->bytes[8] = (unsigned char)(fieldCount >> 24);
+        writer->bytes[9] = (unsigned char)(fieldCount >> 16);
+        writer->bytes[10] = (unsigned char)(fieldCount >> 8);
+        writer->bytes[11] = (unsigned char)fieldCount;
+
+        frameHeader[0] = (unsigned char)(frameSize >> 24);
+        frameHeader[1] = (unsigned char)(frameSize >> 16);
+        frameHeader[2] = (unsigned char)(frameSize >> 8);
+        frameHeader[3] = (unsigned char)frameSize;
+        frameHeader[4] = 2;
+        frameHeader[5] = 0;
+        frameHeader[6] = (unsigned char)(channel >> 8);
+        frameHeader[7] = (unsigned char)channel;
+
+        if ((output_append(connection, frameHeader, sizeof(frameHeader)) != 0) ||
+            (output_append(connection, writer->bytes, writer->length) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static AMQP_SESSION* amqp_find_session(MOCK_HUB_CONNECTION* connection, uint16_t channel)
+{
+    AMQP_SESSION* result = NULL;
+    size_t index;
+    for (index = 0; index < AMQP_MAX_SESSIONS; index++)
+    {
+        if (connection->sessions[index].isUsed && (connection->sessions[index].channel == channel))
+        {
+            result = &connection->sessions[index];
+            break;
+        }
+    }
+    return result;
+}
+
+static AMQP_LINK* amqp_find_link(AMQP_SESSION* session, uint32_t handle)
+{
+    AMQP_LINK* result = NULL;
+    size_t index;
+    for (index = 0; index < AMQP_MAX_LINKS; index++)
+    {
+        if (session->links[index].isUsed && (session->links[index].handle == handle))
+        {
+            result = &session->links[index];
+            break;
+        }
+    }
+    return result;
+}
+
+static int amqp_send_flow(MOCK_HUB_CONNECTION* connection, AMQP_SESSION* session, AMQP_LINK* link)
+{
+    AMQP_WRITER writer;
+    amqp_begin_performative(&writer, AMQP_FLOW);
+    amqp_write_uint(&writer, session->nextIncomingId);  /*next-incoming-id*/
+    amqp_write_uint(&writer, 0x7FFFFFFF);               /*incoming-window*/
+    amqp_write_uint(&writer, 0);                        /*next-outgoing-id*/
+    amqp_write_uint(&writer, 0x7FFFFFFF);               /*outgoing-window*/
+    amqp_write_uint(&writer, link->handle);             /*handle*/
+    amqp_write_uint(&writer, link->deliveryCount);      /*delivery-count*/
+    amqp_write_uint(&writer, AMQP_LINK_CREDIT);         /*link-credit*/
+    link->creditLeft = AMQP_LINK_CREDIT;
+    return amqp_end_performative(connection, &writer, session->channel, 7);
+}
+
+static int amqp_flush_disposition(MOCK_HUB_CONNECTION* connection, AMQP_SESSION* session)
+{
+    int result;
+    if (!session->hasPendingDisposition)
+    {
+        result = 0;
+    }
+    else
+    {
+        static const unsigned char accepted[] = { 0x00, 0x53, AMQP_ACCEPTED, 0x45 };
+        AMQP_WRITER writer;
+        amqp_begin_performative(&writer, AMQP_DISPOSITION);
+        amqp_write_bool(&writer, true);                     /*role: receiver*/
+        amqp_write_uint(&writer, session->pendingFirst);    /*first*/
+        amqp_write_uint(&writer, session->pendingLast);     /*last*/
+        amqp_write_bool(&writer, true);                     /*settled*/
+        amqp_write_bytes(&writer, accepted, sizeof(accepted)); /*state*/
+        session->hasPendingDisposition = false;
+        result = amqp_end_performative(connection, &writer, session->channel, 5);
+    }
+    return result;
+}
+
+static int amqp_on_transfer(MOCK_HUB_CONNECTION* connection, AMQP_SESSION* session, const unsigned char* fields, size_t fieldsLength, uint32_t count)
+{
+    int result = 0;
+    uint32_t handle;
+    AMQP_LINK* link;
+
+    session->nextIncomingId++;
+
+    if (!amqp_get_uint(fields, fieldsLength, count, 0, &handle) ||
+        ((link = amqp_find_link(session, handle)) == NULL))
+    {
+        LogError("AMQP transfer on an unknown link");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint32_t deliveryId;
+        if (amqp_get_uint(fields, fieldsLength, count, 1, &deliveryId))
+        {
+            /*only the first frame of a multi-frame delivery carries delivery-id and settled*/
+            link->deliveryId = deliveryId;
+            link->isSettled = amqp_get_bool(fields, fieldsLength, count, 4, false);
+        }
+
+        if (!amqp_get_bool(fields, fieldsLength, count, 5, false))
+        {
+            connection->deliveries++;
+            link->deliveryCount++;
+            if (link->creditLeft > 0)
+            {
+                link->creditLeft--;
+            }
+
+            if (!link->isSettled)
+            {
+                if (session->hasPendingDisposition && (link->deliveryId == session->pendingLast + 1))
+                {
+                    session->pendingLast = link->deliveryId;
+                }
+                else
+                {
+                    result = amqp_flush_disposition(connection, session);
+                    session->hasPendingDisposition = true;
+                    session->pendingFirst = link->deliveryId;
+                    session->pendingLast = link->deliveryId;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static int amqp_on_attach(MOCK_HUB_CONNECTION* connection, AMQP_SESSION* session, const unsigned char* fields, size_t fieldsLength, uint32_t count)
+{
+    int result;
+    size_t nameLength = 0;
+    const unsigned char* name = amqp_get_field(fields, fieldsLength, count, 0, &nameLength);
+    uint32_t handle;
+
+    if ((name == NULL) || !amqp_get_uint(fields, fieldsLength, count, 1, &handle))
+    {
+        LogError("malformed AMQP attach");
+        result = __FAILURE__;
+    }
+    else
+    {
+        bool isClientReceiver = amqp_get_bool(fields, fieldsLength, count, 2, false);
+        AMQP_LINK* link = NULL;
+        size_t index;
+        for (index = 0; index < AMQP_MAX_LINKS; index++)
+        {
+            if (!session->links[index].isUsed)
+            {
+                link = &session->links[index];
+                break;
+            }
+        }
+
+        if (link == NULL)
+        {
+            LogError("too many AMQP links on a session");
+            result = __FAILURE__;
+        }
+        else
+        {
+            AMQP_WRITER writer;
+            uint32_t initialDeliveryCount = 0;
+            size_t fieldIndex;
+
+            (void)memset(link, 0, sizeof(AMQP_LINK));
+            link->isUsed = true;
+            link->handle = handle;
+            link->isTelemetry = !isClientReceiver;
+            if (link->isTelemetry)
+            {
+                (void)amqp_get_uint(fields, fieldsLength, count, 9, &initialDeliveryCount);
+                link->deliveryCount = initialDeliveryCount;
+            }
+
+            /*the hub side of the link mirrors name, settle modes, source and target*/
+            amqp_begin_performative(&writer, AMQP_ATTACH);
+            amqp_write_bytes(&writer, name, nameLength);
+            amqp_write_uint(&writer, handle);
+            amqp_write_bool(&writer, !isClientReceiver);
+            for (fieldIndex = 3; fieldIndex <= 6; fieldIndex++)
+            {
+                size_t length = 0;
+                const unsigned char* field = amqp_get_field(fields, fieldsLength, count, (uint32_t)fieldIndex, &length);
+                amqp_write_field_or_null(&writer, field, length);
+            }
+            amqp_write_byte(&writer, 0x40); /*unsettled*/
+            amqp_write_bool(&writer, false); /*incomplete-unsettled*/
+            if (isClientReceiver)
+            {
+                amqp_write_uint(&writer, 0); /*initial-delivery-count*/
+            }
+            else
+            {
+                amqp_write_byte(&writer, 0x40);
+            }
+
+            result = amqp_end_performative(connection, &writer, session->channel, 10);
+            if ((result == 0) && link->isTelemetry)
+            {
+                result = amqp_send_flow(connection, session, link);
+            }
+        }
+    }
+    return result;
+}
+
+static int amqp_on_frame(MOCK_HUB_CONNECTION* connection, uint16_t channel, const unsigned char* body, size_t bodyLength)
+{
+    int result;
+    const unsigned char* fields;
+    size_t fieldsLength;
+    uint32_t count;
+    size_t descriptorSize = (bodyLength >= 2) ? amqp_get_value_size(body + 1, bodyLength - 1) : 0;
+
+    if ((bodyLength < 3) || (body[0] != 0x00) || (descriptorSize == 0) ||
+        (amqp_get_list(body + 1 + descriptorSize, bodyLength - 1 - descriptorSize, &fields, &fieldsLength, &count) != 0))
+    {
+        LogError("malformed AMQP performative");
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char descriptor = ((body[1] == 0x53) || (body[1] == 0x80)) ? body[descriptorSize] : 0;
+        AMQP_SESSION* session = amqp_find_session(connection, channel);
+        AMQP_WRITER writer;
+
+        switch (descriptor)
+        {
+            case AMQP_OPEN:
+            {
+                amqp_begin_performative(&writer, AMQP_OPEN);
+                amqp_write_bytes(&writer, "\xA1\x08mock-hub", 10);   /*container-id*/
+                amqp_write_byte(&writer, 0x40);                     /*hostname*/
+                amqp_write_uint(&writer, AMQP_MAX_FRAME_SIZE);      /*max-frame-size*/
+                amqp_write_ushort(&writer, AMQP_MAX_SESSIONS - 1);  /*channel-max*/
+                connection->amqpOpened = true;
+                result = amqp_end_performative(connection, &writer, 0, 4);
+                break;
+            }
+            case AMQP_BEGIN:
+            {
+                uint32_t nextOutgoingId = 0;
+                size_t index;
+                session = NULL;
+                for (index = 0; index < AMQP_MAX_SESSIONS; index++)
+                {
+                    if (!connection->sessions[index].isUsed)
+                    {
+                        session = &connection->sessions[index];
+                        break;
+                    }
+                }
+
+                if (session == NULL)
+                {
+                    LogError("too many AMQP sessions");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    (void)amqp_get_uint(fields, fieldsLength, count, 1, &nextOutgoingId);
+                    (void)memset(session, 0, sizeof(AMQP_SESSION));
+                    session->isUsed = true;
+                    session->channel = channel;
+                    session->nextIncomingId = nextOutgoingId;
+
+                    amqp_begin_performative(&writer, AMQP_BEGIN);
+                    amqp_write_ushort(&writer, channel);    /*remote-channel*/
+                    amqp_write_uint(&writer, 0);            /*next-outgoing-id*/
+                    amqp_write_uint(&writer, 0x7FFFFFFF);   /*incoming-window*/
+                    amqp_write_uint(&writer, 0x7FFFFFFF);   /*outgoing-window*/
+                    result = amqp_end_performative(connection, &writer, channel, 4);
+                }
+                break;
+            }
+            case AMQP_ATTACH:
+            {
+                result = (session == NULL) ? __FAILURE__ : amqp_on_attach(connection, session, fields, fieldsLength, count);
+                break;
+            }
+            case AMQP_TRANSFER:
+            {
+                result = (session == NULL) ? __FAILURE__ : amqp_on_transfer(connection, session, fields, fieldsLength, count);
+                break;
+            }
+            case AMQP_DETACH:
+            {
+                uint32_t handle;
+                if ((session == NULL) || !amqp_get_uint(fields, fieldsLength, count, 0, &handle))
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    AMQP_LINK* link = amqp_find_link(session, handle);
+                    if (link != NULL)
+                    {
+                        link->isUsed = false;
+                    }
+
+                    amqp_begin_performative(&writer, AMQP_DETACH);
+                    amqp_write_uint(&writer, handle);
+                    amqp_write_bool(&writer, true); /*closed*/
+                    result = amqp_flush_disposition(connection, session);
+                    if (result == 0)
+                    {
+                        result = amqp_end_performative(connection, &writer, channel, 2);
+                    }
+                }
+                break;
+            }
+            case AMQP_END:
+            {
+                if (session == NULL)
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = amqp_flush_disposition(connection, session);
+                    session->isUsed = false;
+                    amqp_begin_performative(&writer, AMQP_END);
+                    if (result == 0)
+                    {
+                        result = amqp_end_performative(connection, &writer, channel, 0);
+                    }
+                }
+                break;
+            }
+            case AMQP_CLOSE:
+            {
+                amqp_begin_performative(&writer, AMQP_CLOSE);
+                connection->isClosing = true;
+                result = amqp_end_performative(connection, &writer, 0, 0);
+                break;
+            }
+            default:
+            {
+                /*flow and disposition frames from the device need no answer*/
+                result = 0;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+/*AMQP 1.0 without SASL (the devices use x509 authentication, so no CBS either)*/
+static int amqp_on_bytes_received(MOCK_HUB_CONNECTION* connection, const unsigned char* bytes, size_t length, size_t* consumed)
+{
+    int result = 0;
+    size_t position = 0;
+    size_t index;
+
+    if (!connection->amqpHeaderReceived && (length >= sizeof(AMQP_HEADER)))
+    {
+        if (memcmp(bytes, AMQP_HEADER, sizeof(AMQP_HEADER)) != 0)
+        {
+            LogError("unsupported AMQP protocol header (SASL is not supported by the mock hub)");
+            result = __FAILURE__;
+        }
+        else
+        {
+            connection->amqpHeaderReceived = true;
+            position = sizeof(AMQP_HEADER);
+            result = output_append(connection, AMQP_HEADER, sizeof(AMQP_HEADER));
+        }
+    }
+
+    while ((result == 0) && connection->amqpHeaderReceived && (!connection->isClosing) && (length - position >= 8))
+    {
+        uint32_t frameSize = read_uint32(bytes + position);
+        size_t dataOffset = (size_t)bytes[position + 4] * 4;
+
+        if ((frameSize < 8) || (frameSize > AMQP_MAX_FRAME_SIZE) || (dataOffset < 8) || (dataOffset > frameSize) || (bytes[position + 5] != 0))
+        {
+            LogError("malformed AMQP frame");
+            result = __FAILURE__;
+        }
+        else if (length - position < frameSize)
+        {
+            break;
+        }
+        else
+        {
+            if (frameSize > dataOffset)
+            {
+                result = amqp_on_frame(connection, read_uint16(bytes + position + 6), bytes + position + dataOffset, frameSize - dataOffset);
+            }
+            position += frameSize;
+        }
+    }
+
+    /*settlements and credit are answered once per read, so back to back transfers share one disposition*/
+    for (index = 0; (result == 0) && (index < AMQP_MAX_SESSIONS); index++)
+    {
+        AMQP_SESSION* session = &connection->sessions[index];
+        if (session->isUsed)
+        {
+            size_t linkIndex;
+            result = amqp_flush_disposition(connection, session);
+            for (linkIndex = 0; (result == 0) && (linkIndex < AMQP_MAX_LINKS); linkIndex++)
+            {
+                if (session->links[linkIndex].isUsed && session->links[linkIndex].isTelemetry &&
+                    (session->links[linkIndex].creditLeft < AMQP_LINK_CREDIT / 2))
+                {
+                    result = amqp_send_flow(connection, session, &session->links[linkIndex]);
+                }
+            }
+        }
+    }
+
+    *consumed = position;
+    return result;
+}
+
+static int connection_thread(void* context)
+{
+    MOCK_HUB_CONNECTION* connection = (MOCK_HUB_CONNECTION*)context;
+    MOCK_HUB* hub = connection->hub;
+    int result = 0;
+
+    while ((result == 0) && (!connection->isClosing) && (!is_stopping(hub)))
+    {
+        struct pollfd descriptor;
+        int pollResult;
+        descriptor.fd = connection->socket;
+        descriptor.events = POLLIN;
+        descriptor.revents = 0;
+
+        pollResult = poll(&descriptor, 1, hub->isAmqp ? AMQP_KEEPALIVE_PERIOD_MS : POLL_PERIOD_MS);
+        if (pollResult == 0)
+        {
+            if (hub->isAmqp && connection->amqpOpened)
+            {
+                result = output_append(connection, AMQP_EMPTY_FRAME, sizeof(AMQP_EMPTY_FRAME));
+            }
+        }
+        else if (pollResult < 0)
+        {
+            if (errno != EINTR)
+            {
+                result = __FAILURE__;
+            }
+        }
+        else
+        {
+            ssize_t received;
+            if (connection->inputSize - connection->inputUsed < RECEIVE_CHUNK_SIZE)
+            {
+                size_t newSize = connection->inputUsed + RECEIVE_CHUNK_SIZE;
+                unsigned char* newInput = (unsigned char*)realloc(connection->input, newSize);
+                if (newInput == NULL)
+                {
+                    LogError("unable to grow the input buffer to %zu bytes", newSize);
+                    result = __FAILURE__;
+                    break;
+                }
+                connection->input = newInput;
+                connection->inputSize = newSize;
+            }
+
+            received = recv(connection->socket, connection->input + connection->inputUsed, connection->inputSize - connection->inputUsed, 0);
+            if (received == 0)
+            {
+                /*device closed the connection*/
+                break;
+            }
+            else if (received < 0)
+            {
+                if (errno != EINTR)
+                {
+                    result = __FAILURE__;
+                }
+            }
+            else
+            {
+                size_t consumed = 0;
+                connection->inputUsed += (size_t)received;
+                result = hub->onBytesReceived(connection, connection->input, connection->inputUsed, &consumed);
+                if (consumed > 0)
+                {
+                    (void)memmove(connection->input, connection->input + consumed, connection->inputUsed - consumed);
+                    connection->inputUsed -= consumed;
+                }
+
+                if (connection->deliveries > 0)
+                {
+                    (void)Lock(hub->lock);
+                    hub->deliveryCount += connection->deliveries;
+                    (void)Unlock(hub->lock);
+                    connection->deliveries = 0;
+                }
+            }
+        }
+
+        if ((connection->outputUsed > 0) && (output_flush(connection) != 0))
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    (void)shutdown(connection->socket, SHUT_RDWR);
+    return result;
+}
+
+static int listen_thread(void* context)
+{
+    MOCK_HUB* hub = (MOCK_HUB*)context;
+
+    while (!is_stopping(hub))
+    {
+        struct pollfd descriptor;
+        descriptor.fd = hub->listenSocket;
+        descriptor.events = POLLIN;
+        descriptor.revents = 0;
+
+        if (poll(&descriptor, 1, POLL_PERIOD_MS) > 0)
+        {
+            int accepted = accept(hub->listenSocket, NULL, NULL);
+            if (accepted >= 0)
+            {
+                MOCK_HUB_CONNECTION* connection = (MOCK_HUB_CONNECTION*)calloc(1, sizeof(MOCK_HUB_CONNECTION));
+                int noDelay = 1;
+                (void)setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+                if (connection == NULL)
+                {
+                    LogError("unable to allocate a connection");
+                    (void)close(accepted);
+                }
+                else
+                {
+                    connection->hub = hub;
+                    connection->socket = accepted;
+
+                    (void)Lock(hub->lock);
+                    if (hub->connectionCount == MAX_CONNECTIONS)
+                    {
+                        LogError("too many connections to the mock hub");
+                        (void)close(accepted);
+                        free(connection);
+                    }
+                    else if (ThreadAPI_Create(&connection->thread, connection_thread, connection) != THREADAPI_OK)
+                    {
+                        LogError("unable to create a connection thread");
+                        (void)close(accepted);
+                        free(connection);
+                    }
+                    else
+                    {
+                        hub->connections[hub->connectionCount++] = connection;
+                    }
+                    (void)Unlock(hub->lock);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+MOCK_HUB_HANDLE mock_hub_start(MOCK_HUB_PROTOCOL protocol)
+{
+    MOCK_HUB* result = (MOCK_HUB*)calloc(1, sizeof(MOCK_HUB));
+    if (result == NULL)
+    {
+        LogError("unable to allocate the mock hub");
+    }
+    else
+    {
+        struct sockaddr_in address;
+        socklen_t addressLength = sizeof(address);
+        int reuse = 1;
+
+        (void)memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+
+        result->isAmqp = (protocol == MOCK_HUB_PROTOCOL_AMQP);
+        result->onBytesReceived =
+            (protocol == MOCK_HUB_PROTOCOL_MQTT) ? mqtt_on_bytes_received :
+            (protocol == MOCK_HUB_PROTOCOL_AMQP) ? amqp_on_bytes_received :
+            http_on_bytes_received;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->listenSocket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        {
+            LogError("socket failed");
+            (void)Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+        else if ((setsockopt(result->listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0) ||
+            (bind(result->listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+            (listen(result->listenSocket, MAX_CONNECTIONS) != 0) ||
+            (getsockname(result->listenSocket, (struct sockaddr*)&address, &addressLength) != 0))
+        {
+            LogError("unable to listen on the loopback interface");
+            (void)close(result->listenSocket);
+            (void)Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->port = ntohs(address.sin_port);
+            if (ThreadAPI_Create(&result->listenThread, listen_thread, result) != THREADAPI_OK)
+            {
+                LogError("unable to create the listening thread");
+                (void)close(result->listenSocket);
+                (void)Lock_Deinit(result->lock);
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+    return result;
+}
+
+int mock_hub_get_port(MOCK_HUB_HANDLE hub)
+{
+    return (hub == NULL) ? -1 : hub->port;
+}
+
+size_t mock_hub_get_delivery_count(MOCK_HUB_HANDLE hub)
+{
+    size_t result;
+    if (hub == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        (void)Lock(hub->lock);
+        result = hub->deliveryCount;
+        (void)Unlock(hub->lock);
+    }
+    return result;
+}
+
+void mock_hub_stop(MOCK_HUB_HANDLE hub)
+{
+    if (hub != NULL)
+    {
+        size_t index;
+        int threadResult;
+
+        (void)Lock(hub->lock);
+        hub->stop = true;
+        (void)Unlock(hub->lock);
+
+        (void)ThreadAPI_Join(hub->listenThread, &threadResult);
+        (void)close(hub->listenSocket);
+
+        /*no new connection can show up once the listening thread is gone*/
+        for (index = 0; index < hub->connectionCount; index++)
+        {
+            MOCK_HUB_CONNECTION* connection = hub->connections[index];
+            (void)ThreadAPI_Join(connection->thread, &threadResult);
+            (void)close(connection->socket);
+            free(connection->input);
+            free(connection->output);
+            free(connection);
+        }
+
+        (void)Lock_Deinit(hub->lock);
+        free(hub);
+    }
+}
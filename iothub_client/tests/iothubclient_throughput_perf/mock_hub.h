@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef MOCK_HUB_H
+#define MOCK_HUB_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*the mock hub is a loopback stand-in for the IoT Hub endpoints. It speaks just enough MQTT 3.1.1, AMQP 1.0 and
+HTTP/1.1 (all of them without TLS) to acknowledge every telemetry message as soon as it has been read from the socket*/
+typedef enum MOCK_HUB_PROTOCOL_TAG
+{
+    MOCK_HUB_PROTOCOL_MQTT,
+    MOCK_HUB_PROTOCOL_AMQP,
+    MOCK_HUB_PROTOCOL_HTTP
+} MOCK_HUB_PROTOCOL;
+
+typedef struct MOCK_HUB_TAG* MOCK_HUB_HANDLE;
+
+/*starts listening on an ephemeral 127.0.0.1 port. Every accepted connection is served by its own thread*/
+extern MOCK_HUB_HANDLE mock_hub_start(MOCK_HUB_PROTOCOL protocol);
+extern int mock_hub_get_port(MOCK_HUB_HANDLE hub);
+
+/*number of telemetry deliveries acknowledged so far: MQTT PUBLISH packets, AMQP transfers or HTTP event POST requests*/
+extern size_t mock_hub_get_delivery_count(MOCK_HUB_HANDLE hub);
+
+/*closes the listener and every connection, then joins all the threads*/
+extern void mock_hub_stop(MOCK_HUB_HANDLE hub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOCK_HUB_H */
@@ -36,6 +36,7 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #undef ENABLE_MOCKS
 
 #include "iothub_client.h"
+#include "iothub_client_options.h"
 
 static void* g_userContextCallback;
 static size_t g_queue_number_items = 0;
@@ -54,6 +55,7 @@ static void my_test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_RESUL
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 #include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/condition.h"
 
 #include "iothub_client_ll.h"
 
@@ -97,6 +99,7 @@ static LOCK_TEST_INFO g_transport_lock;
 
 static THREAD_START_FUNC g_thread_func;
 static void* g_thread_func_arg;
+static THREAD_START_FUNC g_first_thread_func;
 static IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK g_eventConfirmationCallback;
 static IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK g_deviceTwinCallback;
 static IOTHUB_CLIENT_REPORTED_STATE_CALLBACK g_reportedStateCallback;
@@ -125,6 +128,7 @@ static IOTHUB_CLIENT_DEVICE_CONFIG* TEST_CLIENT_DEVICE_CONFIG = (IOTHUB_CLIENT_D
 static METHOD_HANDLE TEST_METHOD_ID = (METHOD_HANDLE)0x111B;
 static STRING_HANDLE TEST_STRING_HANDLE = (STRING_HANDLE)0x111C;
 static BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x111D;
+static COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x111E;
 
 static const char* TEST_CONNECTION_STRING = "Test_connection_string";
 static const char* TEST_DEVICE_ID = "theidofTheDevice";
@@ -133,7 +137,7 @@ static const char* TEST_IOTHUBNAME = "theNameoftheIotHub";
 static const char* TEST_DEVICE_SAS = "theSasOfTheDevice";
 static const char* TEST_IOTHUBSUFFIX = "theSuffixoftheIotHubHostname";
 static const char* TEST_METHOD_NAME = "method_name";
-static const unsigned char* TEST_DEVICE_METHOD_RESPONSE = (const unsigned char*)0x62;
+static const unsigned char* TEST_DEVICE_METHOD_RESPONSE = (const unsigned char*)"b";
 static size_t TEST_DEVICE_RESP_LENGTH = 1;
 static void* CALLBACK_CONTEXT = (void*)0x1210;
 
@@ -183,6 +187,10 @@ static THREADAPI_RESULT my_ThreadAPI_Join(THREAD_HANDLE threadHandle, int *res)
 static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
 {
     *threadHandle = TEST_THREAD_HANDLE;
+    if (g_first_thread_func == NULL)
+    {
+        g_first_thread_func = func;
+    }
     g_thread_func = func;
     g_thread_func_arg = arg;
     return THREADAPI_OK;
@@ -198,6 +206,28 @@ static void my_ThreadAPI_Sleep(unsigned int milliseconds)
     }
 }
 
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    (void)handle;
+    (void)lock;
+    (void)timeout_milliseconds;
+    g_thread_loop_count++;
+    if ((g_how_thread_loops > 0) && (g_how_thread_loops == g_thread_loop_count))
+    {
+        *(sig_atomic_t*)(((char*)g_thread_func_arg) + IoTHubClient_ThreadTerminationOffset) = 1; /*tell the thread to stop*/
+    }
+    return COND_TIMEOUT;
+}
+
+static tickcounter_ms_t g_ll_work_wait_time;
+static IOTHUB_CLIENT_RESULT my_IoTHubClient_LL_GetWorkWaitTime(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, tickcounter_ms_t transportPollMs, tickcounter_ms_t* waitMs)
+{
+    (void)iotHubClientHandle;
+    (void)transportPollMs;
+    *waitMs = g_ll_work_wait_time;
+    return IOTHUB_CLIENT_OK;
+}
+
 static IOTHUB_CLIENT_RESULT my_IoTHubClient_LL_GetSendStatus(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     (void)iotHubClientHandle;
@@ -387,6 +417,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONFIRMATION_RESULT, int);
     REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint64_t);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_TRANSPORT_PROVIDER, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_DEVICE_TWIN_STATE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RESULT, int);
@@ -403,6 +434,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_REPORTED_STATE_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_RESULT, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const IOTHUB_CLIENT_FILE_UPLOAD_SOURCE*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RETRY_POLICY, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK, void*);
@@ -417,10 +449,14 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(METHOD_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
 
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_LL_CreateFromConnectionString, TEST_IOTHUB_CLIENT_HANDLE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_CreateFromConnectionString, NULL);
@@ -432,6 +468,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_SendEventAsync, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_GetSendStatus, my_IoTHubClient_LL_GetSendStatus);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_GetSendStatus, IOTHUB_CLIENT_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_GetWorkWaitTime, my_IoTHubClient_LL_GetWorkWaitTime);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_GetWorkWaitTime, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_GetLastMessageReceiveTime, my_IoTHubClient_LL_GetLastMessageReceiveTime);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_GetLastMessageReceiveTime, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_LL_SetOption, IOTHUB_CLIENT_OK);
@@ -452,6 +490,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_DeviceMethodResponse, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_LL_UploadToBlob, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_UploadToBlob, IOTHUB_CLIENT_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_LL_UploadMultipleBlocksToBlob, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClient_LL_UploadMultipleBlocksToBlob, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_LL_GetRetryPolicy, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClient_LL_Destroy, my_IoTHubClient_LL_Destroy);
     REGISTER_GLOBAL_MOCK_HOOK(test_event_confirmation_callback, my_test_event_confirmation_callback);
@@ -488,6 +528,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
 
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Post, COND_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, my_VECTOR_create);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_create, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_move, my_VECTOR_move);
@@ -523,9 +569,11 @@ TEST_FUNCTION_INITIALIZE(method_init)
 
     g_thread_func = NULL;
     g_thread_func_arg = NULL;
+    g_first_thread_func = NULL;
     g_userContextCallback = NULL;
     g_how_thread_loops = 0;
     g_thread_loop_count = 0;
+    g_ll_work_wait_time = 10;
     g_queue_element = NULL;
     g_queue_element_size = 0;
     g_queue_number_items = 0;
@@ -598,6 +646,7 @@ static void setup_iothubclient_sendeventasync(bool use_threads)
         .IgnoreArgument_handle();
     if (use_threads)
     {
+        STRICT_EXPECTED_CALL(Condition_Init());
         EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     }
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -606,21 +655,19 @@ static void setup_iothubclient_sendeventasync(bool use_threads)
         .IgnoreArgument(1)
         .IgnoreArgument(3)
         .IgnoreArgument(4);
+    if (use_threads)
+    {
+        STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    }
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 }
 
-static void setup_iothubclient_uploadtoblobasync()
+static void setup_iothubclient_uploadtoblobasync_thread_start()
 {
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a UPLOADTOBLOB_SAVED_DATA*/
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "someFileName.txt")) /*this is making a copy of the filename*/
-        .IgnoreArgument_destination()
-        .IgnoreArgument_source();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a UPLOADTOBLOB_SAVED_DATA*/
-        .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is adding UPLOADTOBLOB_SAVED_DATA to the list of UPLOADTOBLOB_SAVED_DATAs to be cleaned*/
         .IgnoreArgument(1)
@@ -629,6 +676,18 @@ static void setup_iothubclient_uploadtoblobasync()
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+}
+
+static void setup_iothubclient_uploadtoblobasync()
+{
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a UPLOADTOBLOB_SAVED_DATA*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "someFileName.txt")) /*this is making a copy of the filename*/
+        .IgnoreArgument_destination()
+        .IgnoreArgument_source();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a UPLOADTOBLOB_SAVED_DATA*/
+        .IgnoreArgument(1);
+    setup_iothubclient_uploadtoblobasync_thread_start();
 
     STRICT_EXPECTED_CALL(IoTHubClient_LL_UploadToBlob(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1)) /*this is the thread calling into _LL layer*/
         .IgnoreArgument(2)
@@ -963,11 +1022,9 @@ TEST_FUNCTION(IoTHubClient_Destroy_calls_IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBA
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
     EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_Destroy(IGNORED_PTR_ARG))
         .IgnoreArgument_iotHubClientHandle();
-    STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-        .IgnoreArgument_handle()
-        .IgnoreArgument_elements();
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument_ptr();
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SLL_HANDLE));
@@ -976,10 +1033,10 @@ TEST_FUNCTION(IoTHubClient_Destroy_calls_IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBA
     STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_threadHandle()
         .IgnoreArgument_res();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE,0));
     STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, (void*)0x42));
+    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE));
     STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1034,6 +1091,74 @@ TEST_FUNCTION(IoTHubClient_SendEventAsync_succeed)
     IoTHubClient_Destroy(iothub_handle);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_01_057: [ IoTHubClient_SendEventAsync_Move shall call IoTHubClient_LL_SendEventAsync_Move instead of IoTHubClient_LL_SendEventAsync. ]*/
+/*Tests_SRS_IOTHUBCLIENT_01_058: [ IoTHubClient_SendEventAsync_Move shall behave as IoTHubClient_SendEventAsync, except that on success the ownership of eventMessageHandle is transferred to the client. ]*/
+TEST_FUNCTION(IoTHubClient_SendEventAsync_Move_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
+    EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendEventAsync_Move(IGNORED_PTR_ARG, TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync_Move(iothub_handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_01_084: [ If the transport connection is shared, waking up the worker thread shall be done by calling IoTHubTransport_SignalWorkerThread. ]*/
+TEST_FUNCTION(IoTHubClient_SendEventAsync_with_a_shared_transport_signals_the_transport_worker)
+{
+    // arrange
+    IOTHUB_CLIENT_CONFIG client_config;
+    client_config.deviceId = TEST_DEVICE_ID;
+    client_config.deviceKey = TEST_DEVICE_KEY;
+    client_config.deviceSasToken = TEST_DEVICE_SAS;
+    client_config.protocol = TEST_TRANSPORT_PROVIDER;
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_CreateWithTransport(TEST_TRANSPORT_HANDLE, &client_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubTransport_StartWorkerThread(TEST_TRANSPORT_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_clientHandle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendEventAsync(IGNORED_PTR_ARG, TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL(IoTHubTransport_SignalWorkerThread(TEST_TRANSPORT_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
 /* Tests_SRS_IOTHUBCLIENT_01_010: [If starting the thread fails, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_ERROR.] */
 /* Tests_SRS_IOTHUBCLIENT_01_011: [If iotHubClientHandle is NULL, IoTHubClient_SendEventAsync shall return IOTHUB_CLIENT_INVALID_ARG.] */
 /* Tests_SRS_IOTHUBCLIENT_01_013: [When IoTHubClient_LL_SendEventAsync is called, IoTHubClient_SendEventAsync shall return the result of IoTHubClient_LL_SendEventAsync.] */
@@ -1086,8 +1211,6 @@ TEST_FUNCTION(IoTHubClient_SendEventAsync_event_confirm_callback_succeed)
     (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(VECTOR_push_back(TEST_VECTOR_HANDLE, IGNORED_PTR_ARG, 1))
-        .IgnoreArgument_elements();
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG) );
 
     // act
@@ -1099,19 +1222,23 @@ TEST_FUNCTION(IoTHubClient_SendEventAsync_event_confirm_callback_succeed)
         .IgnoreArgument_handle();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE)).SetReturn(1);
-        STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
     STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_OK, NULL));
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
 
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    /*the pass produced user callbacks, so the next one does not wait*/
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -1193,6 +1320,72 @@ TEST_FUNCTION(IoTHubClient_GetSendStatus_succeed)
     IoTHubClient_Destroy(iothub_handle);
 }
 
+/*Tests_SRS_IOTHUBCLIENT_01_060: [ If iotHubClientHandle is NULL, IoTHubClient_GetSendQueueSize shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_GetSendQueueSize_iothub_handle_NULL_fail)
+{
+    // arrange
+    size_t queueSize;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_GetSendQueueSize(NULL, &queueSize);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+/*Tests_SRS_IOTHUBCLIENT_01_062: [ If acquiring the lock fails, IoTHubClient_GetSendQueueSize shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_GetSendQueueSize_lock_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    size_t queueSize;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle().SetReturn(LOCK_ERROR);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_GetSendQueueSize(iothub_handle, &queueSize);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_01_061: [ IoTHubClient_GetSendQueueSize shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+/*Tests_SRS_IOTHUBCLIENT_01_063: [ IoTHubClient_GetSendQueueSize shall return the result of calling IoTHubClient_LL_GetSendQueueSize with the IoTHubClient_LL handle created by IoTHubClient_Create and the parameter queueSize. ]*/
+TEST_FUNCTION(IoTHubClient_GetSendQueueSize_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    size_t queueSize;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetSendQueueSize(TEST_IOTHUB_CLIENT_HANDLE, &queueSize));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_GetSendQueueSize(iothub_handle, &queueSize);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
 TEST_FUNCTION(IoTHubClient_SetMessageCallback_client_handle_NULL_fail)
 {
     // arrange
@@ -1213,6 +1406,7 @@ TEST_FUNCTION(IoTHubClient_SetMessageCallback_client_handle_NULL_fail)
 /* Tests_SRS_IOTHUBCLIENT_01_027: [IoTHubClient_SetMessageCallback shall be made thread-safe by using the lock created in IoTHubClient_Create.] */
 /* Tests_SRS_IOTHUBCLIENT_25_087: [ `IoTHubClient_SetConnectionStatusCallback` shall be made thread-safe by using the lock created in `IoTHubClient_Create`. ] */
 /* Tests_SRS_IOTHUBCLIENT_25_086: [ When `IoTHubClient_LL_SetConnectionStatusCallback` is called, `IoTHubClient_SetConnectionStatusCallback` shall return the result of `IoTHubClient_LL_SetConnectionStatusCallback`.] */
+/* Tests_SRS_IOTHUBCLIENT_01_085: [ If setting the message callback succeeds, IoTHubClient_SetMessageCallback shall wake up the worker thread by calling Condition_Post. ]*/
 TEST_FUNCTION(IoTHubClient_SetMessageCallback_succeed)
 {
     // arrange
@@ -1221,12 +1415,14 @@ TEST_FUNCTION(IoTHubClient_SetMessageCallback_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument_size();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetMessageCallbackEx(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_messageCallback()
         .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -1255,6 +1451,7 @@ TEST_FUNCTION(IoTHubClient_SetMessageCallback_fail)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument_size();
@@ -1290,6 +1487,7 @@ TEST_FUNCTION(IoTHubClient_SetMessageCallback_fails_if_SetMessageCallbackEx_fail
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
@@ -1335,6 +1533,7 @@ TEST_FUNCTION(IoTHubClient_SetConnectionStatusCallback_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument_size();
@@ -1366,6 +1565,7 @@ TEST_FUNCTION(IoTHubClient_SetConnectionStatusCallback_fail)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument_size();
@@ -1421,6 +1621,7 @@ TEST_FUNCTION(IoTHubClient_SetRetryPolicy_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetRetryPolicy(TEST_IOTHUB_CLIENT_HANDLE, retry_policy, retry_in_seconds))
         .IgnoreArgument(2);
@@ -1467,6 +1668,7 @@ TEST_FUNCTION(IoTHubClient_GetRetryPolicy_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_GetRetryPolicy(TEST_IOTHUB_CLIENT_HANDLE, &retry_policy, &retry_in_seconds));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
@@ -1671,121 +1873,121 @@ TEST_FUNCTION(IoTHubClient_SetOption_option_value_NULL_fail)
 
 /* Tests_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.] */
 /* Tests_SRS_IOTHUBCLIENT_01_041: [ IoTHubClient_SetOption shall be made thread-safe by using the lock created in IoTHubClient_Create. ] */
-TEST_FUNCTION(IoTHubClient_SetOption_succeed)
+/* Tests_SRS_IOTHUBCLIENT_01_053: [ If iotHubClientHandle, wakeupCount or doWorkCount is NULL, IoTHubClient_GetWorkerStatistics shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_GetWorkerStatistics_client_handle_NULL_fail)
+{
+    // arrange
+    size_t wakeup_count;
+    size_t do_work_count;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_GetWorkerStatistics(NULL, &wakeup_count, &do_work_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_054: [ IoTHubClient_GetWorkerStatistics shall be made thread-safe by using the lock created in IoTHubClient_Create. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_056: [ IoTHubClient_GetWorkerStatistics shall return in wakeupCount the number of times the worker thread woke up and in doWorkCount the number of times it called IoTHubClient_LL_DoWork. ]*/
+TEST_FUNCTION(IoTHubClient_GetWorkerStatistics_succeed)
 {
     // arrange
     IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, NULL, NULL);
+    g_how_thread_loops = 1;
+    g_thread_func(g_thread_func_arg);
     umock_c_reset_all_calls();
 
-    const char* option_name = "option_name";
-    const void* option_value = (void*)0x0123;
+    size_t wakeup_count;
+    size_t do_work_count;
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_IOTHUB_CLIENT_HANDLE, option_name, option_value));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, option_name, option_value);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_GetWorkerStatistics(iothub_handle, &wakeup_count, &do_work_count);
 
     // assert
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, wakeup_count);
+    ASSERT_ARE_EQUAL(size_t, 1, do_work_count);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     IoTHubClient_Destroy(iothub_handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.]*/
-/* Tests_SRS_IOTHUBCLIENT_01_042: [If acquiring the lock fails, IoTHubClient_GetLastMessageReceiveTime shall return IOTHUB_CLIENT_ERROR. ]*/
-/* Tests_SRS_IOTHUBCLIENT_10_007: [IoTHubClient_SetDeviceTwinCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL. ]*/
-/* Tests_SRS_IOTHUBCLIENT_10_002: [If acquiring the lock fails, IoTHubClient_SetDeviceTwinCallback shall return IOTHUB_CLIENT_ERROR. ]*/
-/* Tests_SRS_IOTHUBCLIENT_10_004: [If starting the thread fails, IoTHubClient_SetDeviceTwinCallback shall return IOTHUB_CLIENT_ERROR. ]*/
-TEST_FUNCTION(IoTHubClient_SetOption_fail)
+/* Tests_SRS_IOTHUBCLIENT_01_050: [ If optionName is OPTION_WORKER_IDLE_WAIT_TIME then value shall be interpreted as a pointer to an unsigned int holding the number of milliseconds the worker thread waits between two calls to IoTHubClient_LL_DoWork while something is expected from the transport. ]*/
+TEST_FUNCTION(IoTHubClient_SetOption_worker_idle_wait_time_succeed)
 {
     // arrange
     IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
     umock_c_reset_all_calls();
 
-    int negativeTestsInitResult = umock_c_negative_tests_init();
-    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
-
-    const char* option_name = "option_name";
-    const void* option_value = (void*)0x0123;
+    unsigned int idle_wait_time = 500;
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_IOTHUB_CLIENT_HANDLE, option_name, option_value));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
-    umock_c_negative_tests_snapshot();
-
-    size_t calls_cannot_fail[] = { 2 };
-
     // act
-    size_t count = umock_c_negative_tests_call_count();
-    for (size_t index = 0; index < count; index++)
-    {
-        if (should_skip_index(index, calls_cannot_fail, sizeof(calls_cannot_fail)/sizeof(calls_cannot_fail[0])) != 0)
-        {
-            continue;
-        }
-
-        umock_c_negative_tests_reset();
-        umock_c_negative_tests_fail_call(index);
-
-        char tmp_msg[64];
-        sprintf(tmp_msg, "IoTHubClient_SetOption failure in test %zu/%zu", index, count);
-        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, option_name, option_value);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, OPTION_WORKER_IDLE_WAIT_TIME, &idle_wait_time);
 
-        // assert
-        ASSERT_ARE_NOT_EQUAL_WITH_MSG(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result, tmp_msg);
-    }
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    umock_c_negative_tests_deinit();
     IoTHubClient_Destroy(iothub_handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_LL_10_007: [** `IoTHubClient_SetDeviceTwinCallback` shall fail and return `IOTHUB_CLIENT_INVALID_ARG` if parameter `iotHubClientHandle` is `NULL`. ]*/
-TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_client_handle_fail)
+/* Tests_SRS_IOTHUBCLIENT_01_051: [ If the idle wait time is 0 or greater than INT_MAX then IoTHubClient_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_SetOption_worker_idle_wait_time_0_fails)
 {
     // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    unsigned int idle_wait_time = 0;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
 
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetDeviceTwinCallback(NULL, test_device_twin_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, OPTION_WORKER_IDLE_WAIT_TIME, &idle_wait_time);
 
     // assert
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    IoTHubClient_Destroy(iothub_handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_10_005: [ IoTHubClient_SetDeviceTwinCallback shall call IoTHubClient_LL_SetDeviceTwinCallback, while passing the IoTHubClient_LL handle created by IoTHubClient_LL_Create along with the parameters iothub_ll_device_twin_callback and IOTHUB_QUEUE_CONTEXT variable. ] */
-/* Tests_SRS_IOTHUBCLIENT_10_006: [ When IoTHubClient_LL_SetDeviceTwinCallback is called, IoTHubClient_SetDeviceTwinCallback shall return the result of IoTHubClient_LL_SetDeviceTwinCallback. ] */
-/* Tests_SRS_IOTHUBCLIENT_10_020: [ IoTHubClient_SetDeviceTwinCallback shall be made thread-safe by using the lock created in IoTHubClient_Create. ] */
-TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_succeed)
+/* Tests_SRS_IOTHUBCLIENT_01_075: [ If optionName is OPTION_CALLBACK_DISPATCH_THREAD then value shall be interpreted as a pointer to a bool; when true, user callbacks shall be called from a dedicated thread instead of the thread calling IoTHubClient_LL_DoWork. ]*/
+TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatch_thread_succeed)
 {
     // arrange
     IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
     umock_c_reset_all_calls();
 
+    bool use_dispatch_thread = true;
+
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreArgument_size();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_deviceTwinCallback()
-        .IgnoreArgument_userContextCallback();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
     // act
-    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetDeviceTwinCallback(iothub_handle, test_device_twin_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, OPTION_CALLBACK_DISPATCH_THREAD, &use_dispatch_thread);
 
     // assert
     ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
@@ -1795,35 +1997,188 @@ TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_succeed)
     IoTHubClient_Destroy(iothub_handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_10_002: [** If acquiring the lock fails, `IoTHubClient_SetDeviceTwinCallback` shall return `IOTHUB_CLIENT_ERROR`. ]*/
-/* Tests_SRS_IOTHUBCLIENT_10_004: [** If starting the thread fails, `IoTHubClient_SetDeviceTwinCallback` shall return `IOTHUB_CLIENT_ERROR`. ]*/
-TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_fail)
+/* Tests_SRS_IOTHUBCLIENT_01_076: [ If the worker thread or the callback dispatch thread is already running, IoTHubClient_SetOption shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_SetOption_callback_dispatch_thread_after_thread_start_fails)
 {
     // arrange
     IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetConnectionStatusCallback(iothub_handle, test_connection_status_callback, NULL);
     umock_c_reset_all_calls();
 
-    int negativeTestsInitResult = umock_c_negative_tests_init();
-    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    bool use_dispatch_thread = true;
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .IgnoreArgument_size();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_deviceTwinCallback()
-        .IgnoreArgument_userContextCallback();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
-    umock_c_negative_tests_snapshot();
-
     // act
-    size_t calls_cannot_fail[] = { 2, 3 };
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, OPTION_CALLBACK_DISPATCH_THREAD, &use_dispatch_thread);
 
-    size_t count = umock_c_negative_tests_call_count();
-    for (size_t index = 0; index < count; index++)
-    {
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClient_SetOption_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    const char* option_name = "option_name";
+    const void* option_value = (void*)0x0123;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_IOTHUB_CLIENT_HANDLE, option_name, option_value));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, option_name, option_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_02_038: [If optionName doesn't match one of the options handled by this module then IoTHubClient_SetOption shall call IoTHubClient_LL_SetOption passing the same parameters and return what IoTHubClient_LL_SetOption returns.]*/
+/* Tests_SRS_IOTHUBCLIENT_01_042: [If acquiring the lock fails, IoTHubClient_GetLastMessageReceiveTime shall return IOTHUB_CLIENT_ERROR. ]*/
+/* Tests_SRS_IOTHUBCLIENT_10_007: [IoTHubClient_SetDeviceTwinCallback shall fail and return IOTHUB_CLIENT_INVALID_ARG if parameter iotHubClientHandle is NULL. ]*/
+/* Tests_SRS_IOTHUBCLIENT_10_002: [If acquiring the lock fails, IoTHubClient_SetDeviceTwinCallback shall return IOTHUB_CLIENT_ERROR. ]*/
+/* Tests_SRS_IOTHUBCLIENT_10_004: [If starting the thread fails, IoTHubClient_SetDeviceTwinCallback shall return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_SetOption_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    const char* option_name = "option_name";
+    const void* option_value = (void*)0x0123;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetOption(TEST_IOTHUB_CLIENT_HANDLE, option_name, option_value));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    umock_c_negative_tests_snapshot();
+
+    size_t calls_cannot_fail[] = { 2 };
+
+    // act
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
+        if (should_skip_index(index, calls_cannot_fail, sizeof(calls_cannot_fail)/sizeof(calls_cannot_fail[0])) != 0)
+        {
+            continue;
+        }
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        char tmp_msg[64];
+        sprintf(tmp_msg, "IoTHubClient_SetOption failure in test %zu/%zu", index, count);
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_SetOption(iothub_handle, option_name, option_value);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result, tmp_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_LL_10_007: [** `IoTHubClient_SetDeviceTwinCallback` shall fail and return `IOTHUB_CLIENT_INVALID_ARG` if parameter `iotHubClientHandle` is `NULL`. ]*/
+TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_client_handle_fail)
+{
+    // arrange
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetDeviceTwinCallback(NULL, test_device_twin_callback, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
+/* Tests_SRS_IOTHUBCLIENT_10_005: [ IoTHubClient_SetDeviceTwinCallback shall call IoTHubClient_LL_SetDeviceTwinCallback, while passing the IoTHubClient_LL handle created by IoTHubClient_LL_Create along with the parameters iothub_ll_device_twin_callback and IOTHUB_QUEUE_CONTEXT variable. ] */
+/* Tests_SRS_IOTHUBCLIENT_10_006: [ When IoTHubClient_LL_SetDeviceTwinCallback is called, IoTHubClient_SetDeviceTwinCallback shall return the result of IoTHubClient_LL_SetDeviceTwinCallback. ] */
+/* Tests_SRS_IOTHUBCLIENT_10_020: [ IoTHubClient_SetDeviceTwinCallback shall be made thread-safe by using the lock created in IoTHubClient_Create. ] */
+/* Tests_SRS_IOTHUBCLIENT_01_086: [ If IoTHubClient_LL_SetDeviceTwinCallback succeeds, IoTHubClient_SetDeviceTwinCallback shall wake up the worker thread by calling Condition_Post. ]*/
+TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
+    EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_deviceTwinCallback()
+        .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetDeviceTwinCallback(iothub_handle, test_device_twin_callback, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_10_002: [** If acquiring the lock fails, `IoTHubClient_SetDeviceTwinCallback` shall return `IOTHUB_CLIENT_ERROR`. ]*/
+/* Tests_SRS_IOTHUBCLIENT_10_004: [** If starting the thread fails, `IoTHubClient_SetDeviceTwinCallback` shall return `IOTHUB_CLIENT_ERROR`. ]*/
+TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceTwinCallback(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_deviceTwinCallback()
+        .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    umock_c_negative_tests_snapshot();
+
+    // act
+    size_t calls_cannot_fail[] = { 2, 3 };
+
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
         if (should_skip_index(index, calls_cannot_fail, sizeof(calls_cannot_fail)/sizeof(calls_cannot_fail[0])) != 0)
         {
             continue;
@@ -1853,9 +2208,6 @@ TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_device_twin_callback_succeed)
     (void)IoTHubClient_SetDeviceTwinCallback(iothub_handle, test_device_twin_callback, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(VECTOR_push_back(TEST_VECTOR_HANDLE, IGNORED_PTR_ARG, 1))
-        .IgnoreArgument_elements();
-
     // act
     g_deviceTwinCallback(DEVICE_TWIN_UPDATE_COMPLETE, NULL, 0, g_userContextCallback);
 
@@ -1863,7 +2215,6 @@ TEST_FUNCTION(IoTHubClient_SetDeviceTwinCallback_device_twin_callback_succeed)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    my_VECTOR_clear(NULL);
     IoTHubClient_Destroy(iothub_handle);
 }
 
@@ -1894,12 +2245,14 @@ TEST_FUNCTION(IoTHubClient_SendReportedState_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .IgnoreArgument_size();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SendReportedState(TEST_IOTHUB_CLIENT_HANDLE, reported_state, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_reportedStateCallback()
         .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -1977,8 +2330,6 @@ TEST_FUNCTION(IoTHubClient_SendReportedState_report_state_callback_succeed)
     IOTHUB_CLIENT_RESULT result = IoTHubClient_SendReportedState(iothub_handle, reported_state, 1, test_report_state_callback, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(VECTOR_push_back(TEST_VECTOR_HANDLE, IGNORED_PTR_ARG, 1))
-        .IgnoreArgument_elements();
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG) );
 
     // act
@@ -1989,7 +2340,6 @@ TEST_FUNCTION(IoTHubClient_SendReportedState_report_state_callback_succeed)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    my_VECTOR_clear(NULL);
     IoTHubClient_Destroy(iothub_handle);
 }
 
@@ -2014,6 +2364,7 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_iothub_fail)
 /* Tests_SRS_IOTHUBCLIENT_12_018: [ IoTHubClient_SetDeviceMethodCallback shall be made thread - safe by using the lock created in IoTHubClient_Create. ]*/
 /* Tests_SRS_IOTHUBCLIENT_12_017: [ When IoTHubClient_LL_SetDeviceMethodCallback is called, IoTHubClient_SetDeviceMethodCallback shall return the result of IoTHubClient_LL_SetDeviceMethodCallback. ]*/
 /* Tests_SRS_IOTHUBCLIENT_12_018: [ IoTHubClient_SetDeviceMethodCallback shall be made thread - safe by using the lock created in IoTHubClient_Create. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_087: [ If IoTHubClient_LL_SetDeviceMethodCallback succeeds, IoTHubClient_SetDeviceMethodCallback shall wake up the worker thread by calling Condition_Post. ]*/
 TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_succeed)
 {
     // arrange
@@ -2022,8 +2373,10 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback(TEST_IOTHUB_CLIENT_HANDLE, test_method_callback, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2105,6 +2458,7 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_handle_NULL)
 /*Tests_SRS_IOTHUBCLIENT_07_003: [ If the transport handle is NULL and the worker thread is not initialized, the thread shall be started by calling IoTHubTransport_StartWorkerThread. ]*/
 /*Tests_SRS_IOTHUBCLIENT_07_005: [ IoTHubClient_SetDeviceMethodCallback_Ex shall call IoTHubClient_LL_SetDeviceMethodCallback_Ex, while passing the IoTHubClient_LL_handle created by IoTHubClient_LL_Create along with the parameters iothub_ll_inbound_device_method_callback and IOTHUB_QUEUE_CONTEXT. ]*/
 /*Tests_SRS_IOTHUBCLIENT_07_006: [ When IoTHubClient_LL_SetDeviceMethodCallback_Ex is called, IoTHubClient_SetDeviceMethodCallback_Ex shall return the result of IoTHubClient_LL_SetDeviceMethodCallback_Ex. ] */
+/*Tests_SRS_IOTHUBCLIENT_01_088: [ If IoTHubClient_LL_SetDeviceMethodCallback_Ex succeeds, IoTHubClient_SetDeviceMethodCallback_Ex shall wake up the worker thread by calling Condition_Post. ]*/
 TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_succeed)
 {
     // arrange
@@ -2113,11 +2467,13 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback_Ex(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_inboundDeviceMethodCallback()
         .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2137,6 +2493,7 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_succeed)
 /*Tests_SRS_IOTHUBCLIENT_07_003: [ If the transport handle is NULL and the worker thread is not initialized, the thread shall be started by calling IoTHubTransport_StartWorkerThread. ]*/
 /*Tests_SRS_IOTHUBCLIENT_07_005: [ IoTHubClient_SetDeviceMethodCallback_Ex shall call IoTHubClient_LL_SetDeviceMethodCallback_Ex, while passing the IoTHubClient_LL_handle created by IoTHubClient_LL_Create along with the parameters iothub_ll_inbound_device_method_callback and IOTHUB_QUEUE_CONTEXT. ]*/
 /*Tests_SRS_IOTHUBCLIENT_07_006: [ When IoTHubClient_LL_SetDeviceMethodCallback_Ex is called, IoTHubClient_SetDeviceMethodCallback_Ex shall return the result of IoTHubClient_LL_SetDeviceMethodCallback_Ex. ] */
+/*Tests_SRS_IOTHUBCLIENT_01_088: [ If IoTHubClient_LL_SetDeviceMethodCallback_Ex succeeds, IoTHubClient_SetDeviceMethodCallback_Ex shall wake up the worker thread by calling Condition_Post. ]*/
 TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_NonNULL_callback_succeed)
 {
     // arrange
@@ -2145,11 +2502,13 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_NonNULL_callback_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback_Ex(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_inboundDeviceMethodCallback()
         .IgnoreArgument_userContextCallback();
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2174,10 +2533,7 @@ TEST_FUNCTION(IoTHubClient_call_inbound_device_callback_succeed)
     (void)IoTHubClient_SetDeviceMethodCallback_Ex(iothub_handle, test_incoming_method_callback, NULL);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(STRING_construct(IGNORED_PTR_ARG))
-        .IgnoreArgument_psz();
-    EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, strlen(TEST_METHOD_NAME) + 1 + TEST_DEVICE_RESP_LENGTH));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
         .IgnoreArgument_ptr();
 
@@ -2216,6 +2572,7 @@ TEST_FUNCTION(IoTHubClient_call_inbound_device_callback_usercontext_NULL)
 }
 
 /* Tests_SRS_IOTHUBCLIENT_07_008: [ If inboundDeviceMethodCallback is NULL, IoTHubClient_SetDeviceMethodCallback_Ex shall call IoTHubClient_LL_SetDeviceMethodCallback_Ex, passing NULL for the iothub_ll_inbound_device_method_callback. ] */
+/* Tests_SRS_IOTHUBCLIENT_01_088: [ If IoTHubClient_LL_SetDeviceMethodCallback_Ex succeeds, IoTHubClient_SetDeviceMethodCallback_Ex shall wake up the worker thread by calling Condition_Post. ]*/
 TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_remove_succeed)
 {
     // arrange
@@ -2224,8 +2581,10 @@ TEST_FUNCTION(IoTHubClient_SetDeviceMethodCallback_Ex_remove_succeed)
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
     EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(IoTHubClient_LL_SetDeviceMethodCallback_Ex(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2400,103 +2759,240 @@ TEST_FUNCTION(IoTHubClient_UploadToBlobAsync_succeeds)
         .SetReturn((void*)g_thread_func_arg);
     IoTHubClient_Destroy(iothub_handle);
 }
-#endif
 
-TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_incoming_method_callback_succeed)
+static int test_file_upload_read_callback(void* context, uint64_t offset, unsigned char* buffer, size_t size)
 {
-    // arrange
-    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
-    (void)IoTHubClient_SetDeviceMethodCallback_Ex(iothub_handle, test_incoming_method_callback, CALLBACK_CONTEXT);
-    (void)g_inboundDeviceCallback(TEST_METHOD_NAME, TEST_DEVICE_METHOD_RESPONSE, TEST_DEVICE_RESP_LENGTH, TEST_METHOD_ID, g_userContextCallback);
-    umock_c_reset_all_calls();
-
-    g_how_thread_loops = 1;
-
-    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE)).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
+    (void)context;
+    (void)offset;
+    (void)buffer;
+    (void)size;
+    return 0;
+}
 
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(test_incoming_method_callback(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0, TEST_METHOD_ID, CALLBACK_CONTEXT))
-        .IgnoreArgument_method_name()
-        .IgnoreArgument_payload()
-        .IgnoreArgument_size();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
-    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
+/*Tests_SRS_IOTHUBCLIENT_01_080: [ If iotHubClientHandle, destinationFileName or source is NULL then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_UploadMultipleBlocksToBlobAsync_with_NULL_iotHubClientHandle_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source = { 1, test_file_upload_read_callback, NULL, NULL, NULL, NULL };
 
-    // act
-    g_thread_func(g_thread_func_arg);
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_UploadMultipleBlocksToBlobAsync(NULL, "a", &source, NULL, NULL);
 
-    // assert
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    // cleanup
-    IoTHubClient_Destroy(iothub_handle);
+    //cleanup
 }
 
-/* Test_SRS_IOTHUBCLIENT_07_002: [ IoTHubClient_SetDeviceTwinCallback shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SetDeviceTwinCallback function as a user context. ] */
-TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_device_twin_succeed)
+/*Tests_SRS_IOTHUBCLIENT_01_080: [ If iotHubClientHandle, destinationFileName or source is NULL then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_UploadMultipleBlocksToBlobAsync_with_NULL_destinationFileName_fails)
 {
-    // arrange
+    //arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source = { 1, test_file_upload_read_callback, NULL, NULL, NULL, NULL };
     IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
-    (void)IoTHubClient_SetDeviceTwinCallback(iothub_handle, test_device_twin_callback, NULL);
-    g_deviceTwinCallback(DEVICE_TWIN_UPDATE_COMPLETE, NULL, 0, g_userContextCallback);
     umock_c_reset_all_calls();
 
-    g_how_thread_loops = 1;
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_UploadMultipleBlocksToBlobAsync(iothub_handle, NULL, &source, NULL, NULL);
 
-    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE)).SetReturn(1);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
-    STRICT_EXPECTED_CALL(test_device_twin_callback(DEVICE_TWIN_UPDATE_COMPLETE, NULL, 0, NULL));
+    //cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
 
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
-    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
+/*Tests_SRS_IOTHUBCLIENT_01_080: [ If iotHubClientHandle, destinationFileName or source is NULL then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_INVALID_ARG. ]*/
+TEST_FUNCTION(IoTHubClient_UploadMultipleBlocksToBlobAsync_with_NULL_source_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
 
-    // act
-    ASSERT_IS_NOT_NULL(g_thread_func);
-    g_thread_func(g_thread_func_arg);
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_UploadMultipleBlocksToBlobAsync(iothub_handle, "someFileName.txt", NULL, NULL, NULL);
 
-    // assert
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    // cleanup
+    //cleanup
     IoTHubClient_Destroy(iothub_handle);
 }
 
-/* Tests_SRS_IOTHUBCLIENT_07_001: [ IoTHubClient_SendEventAsync shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SendEventAsync function as a user context. ]*/
-/* Tests_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_Create shall call IoTHubClient_LL_DoWork every 1 ms.] */
+/*Tests_SRS_IOTHUBCLIENT_01_082: [ If copying to the structure or spawning the thread fails, then IoTHubClient_UploadMultipleBlocksToBlobAsync shall fail and return IOTHUB_CLIENT_ERROR. ]*/
+TEST_FUNCTION(IoTHubClient_UploadMultipleBlocksToBlobAsync_fails_when_copying_the_file_name_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source = { 1, test_file_upload_read_callback, NULL, NULL, NULL, NULL };
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "someFileName.txt"))
+        .IgnoreArgument_destination()
+        .IgnoreArgument_source()
+        .SetReturn(__FAILURE__);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_UploadMultipleBlocksToBlobAsync(iothub_handle, "someFileName.txt", &source, test_file_upload_callback, (void*)1);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/*Tests_SRS_IOTHUBCLIENT_01_081: [ IoTHubClient_UploadMultipleBlocksToBlobAsync shall copy destinationFileName, the content of source (not the data it points to), iotHubClientFileUploadCallback and context into a structure and spawn a thread uploading it, the same way IoTHubClient_UploadToBlobAsync does. ]*/
+/*Tests_SRS_IOTHUBCLIENT_01_083: [ The thread shall call IoTHubClient_LL_UploadMultipleBlocksToBlob passing the information packed in the structure. ]*/
+TEST_FUNCTION(IoTHubClient_UploadMultipleBlocksToBlobAsync_succeeds)
+{
+    //arrange
+    IOTHUB_CLIENT_FILE_UPLOAD_SOURCE source = { 1, test_file_upload_read_callback, NULL, NULL, NULL, NULL };
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating a UPLOADTOBLOB_SAVED_DATA*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "someFileName.txt")) /*this is making a copy of the filename*/
+        .IgnoreArgument_destination()
+        .IgnoreArgument_source();
+    setup_iothubclient_uploadtoblobasync_thread_start();
+
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_UploadMultipleBlocksToBlob(TEST_IOTHUB_CLIENT_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*this is the thread calling into _LL layer*/
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(test_file_upload_callback(FILE_UPLOAD_OK, (void*)1))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_UploadMultipleBlocksToBlobAsync(iothub_handle, "someFileName.txt", &source, test_file_upload_callback, (void*)1);
+
+    g_thread_func(g_thread_func_arg); /*this is the thread uploading function*/
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)0x1111);
+    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)0x1112);
+    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG))
+        .SetReturn((void*)g_thread_func_arg);
+    IoTHubClient_Destroy(iothub_handle);
+}
+#endif
+
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_incoming_method_callback_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetDeviceMethodCallback_Ex(iothub_handle, test_incoming_method_callback, CALLBACK_CONTEXT);
+    (void)g_inboundDeviceCallback(TEST_METHOD_NAME, TEST_DEVICE_METHOD_RESPONSE, TEST_DEVICE_RESP_LENGTH, TEST_METHOD_ID, g_userContextCallback);
+    umock_c_reset_all_calls();
+
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(test_incoming_method_callback(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0, TEST_METHOD_ID, CALLBACK_CONTEXT))
+        .IgnoreArgument_method_name()
+        .IgnoreArgument_payload()
+        .IgnoreArgument_size();
+    /*the pass produced user callbacks, so the next one does not wait*/
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Test_SRS_IOTHUBCLIENT_07_002: [ IoTHubClient_SetDeviceTwinCallback shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SetDeviceTwinCallback function as a user context. ] */
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_device_twin_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetDeviceTwinCallback(iothub_handle, test_device_twin_callback, NULL);
+    g_deviceTwinCallback(DEVICE_TWIN_UPDATE_COMPLETE, NULL, 0, g_userContextCallback);
+    umock_c_reset_all_calls();
+
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(test_device_twin_callback(DEVICE_TWIN_UPDATE_COMPLETE, NULL, 0, NULL));
+
+    /*the pass produced user callbacks, so the next one does not wait*/
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_07_001: [ IoTHubClient_SendEventAsync shall allocate a IOTHUB_QUEUE_CONTEXT object to be sent to the IoTHubClient_LL_SendEventAsync function as a user context. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_037: [The thread created by IoTHubClient_Create shall call IoTHubClient_LL_DoWork every 1 ms.] */
 /* Tests_SRS_IOTHUBCLIENT_01_038: [The thread shall exit when IoTHubClient_Destroy is called.] */
 /* Tests_SRS_IOTHUBCLIENT_01_039: [All calls to IoTHubClient_LL_DoWork shall be protected by the lock created in IotHubClient_Create.] */
 /* Tests_SRS_IOTHUBCLIENT_02_072: [ All threads marked as disposable (upon completion of a file upload) shall be joined and the data structures build for them shall be freed. ]*/
@@ -2514,19 +3010,23 @@ TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_event_confirm_succeed)
         .IgnoreArgument_handle();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE))
-        .SetReturn(1);
-
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
     STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_OK, NULL));
 
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    /*the pass produced user callbacks, so the next one does not wait*/
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2557,19 +3057,23 @@ TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_reported_state_succeed)
         .IgnoreArgument_handle();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE))
-        .SetReturn(1);
-
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
     STRICT_EXPECTED_CALL(test_report_state_callback(REPORTED_STATE_STATUS_CODE, NULL));
 
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    /*the pass produced user callbacks, so the next one does not wait*/
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2601,13 +3105,8 @@ TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_message_callback_succeed)
         .IgnoreArgument_handle();
     STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
-    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE))
-        .SetReturn(1);
-
-    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
     STRICT_EXPECTED_CALL(test_message_confirmation_callback(NULL, NULL));
 
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
@@ -2617,10 +3116,19 @@ TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_message_callback_succeed)
         .IgnoreArgument_messageData();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
-    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
-    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    /*the pass produced user callbacks, so the next one does not wait*/
     STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
     STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
         .IgnoreArgument_handle();
 
@@ -2637,4 +3145,314 @@ TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_message_callback_succeed)
     IoTHubClient_Destroy(iothub_handle);
 }
 
+/* Tests_SRS_IOTHUBCLIENT_01_037: [ The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every time it is signaled that there is work to be done or when the wait period expires. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_044: [ The wait period shall be the one given by IoTHubClient_LL_GetWorkWaitTime with the idle wait period as the transport poll period. The thread shall not wait when the last pass produced user callbacks or when that wait is 0, and shall wait until it is signaled when IoTHubClient_LL_GetWorkWaitTime returns IOTHUB_CLIENT_LL_NO_WORK_DEADLINE. ]*/
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_waits_until_the_LL_deadline)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    g_ll_work_wait_time = 3;
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 3))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_037: [ The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every time it is signaled that there is work to be done or when the wait period expires. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_044: [ The wait period shall be the one given by IoTHubClient_LL_GetWorkWaitTime with the idle wait period as the transport poll period. The thread shall not wait when the last pass produced user callbacks or when that wait is 0, and shall wait until it is signaled when IoTHubClient_LL_GetWorkWaitTime returns IOTHUB_CLIENT_LL_NO_WORK_DEADLINE. ]*/
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_without_LL_deadline_waits_until_signaled)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    g_ll_work_wait_time = IOTHUB_CLIENT_LL_NO_WORK_DEADLINE;
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+#ifndef DONT_USE_UPLOADTOBLOB
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+#endif
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_037: [ The thread created by IoTHubClient_SendEvent or IoTHubClient_SetMessageCallback shall call IoTHubClient_LL_DoWork every time it is signaled that there is work to be done or when the wait period expires. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_044: [ The wait period shall be the one given by IoTHubClient_LL_GetWorkWaitTime with the idle wait period as the transport poll period. The thread shall not wait when the last pass produced user callbacks or when that wait is 0, and shall wait until it is signaled when IoTHubClient_LL_GetWorkWaitTime returns IOTHUB_CLIENT_LL_NO_WORK_DEADLINE. ]*/
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_waits_for_idle_wait_time_when_GetWorkWaitTime_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs()
+        .SetReturn(IOTHUB_CLIENT_ERROR);
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_064: [ User callbacks shall be queued in a ring of USER_CALLBACK_RING_SIZE preallocated slots whose data storage is reused. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_065: [ If the ring is full, or if callbacks are already waiting in the overflow list, the callback shall be added to the overflow list. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_067: [ User callbacks shall be dispatched in the order they were queued, the ones in the ring first and then the ones in the overflow list. ]*/
+TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_ring_overflow_keeps_order)
+{
+    // arrange
+    size_t index;
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetConnectionStatusCallback(iothub_handle, test_connection_status_callback, CALLBACK_CONTEXT);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(VECTOR_push_back(TEST_VECTOR_HANDLE, IGNORED_PTR_ARG, 1))
+        .IgnoreArgument_elements();
+
+    for (index = 0; index < 32; index++)
+    {
+        g_connectionStatusCallback(IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK, g_userContextCallback);
+    }
+    g_connectionStatusCallback(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK, g_userContextCallback);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    umock_c_reset_all_calls();
+
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(VECTOR_move(TEST_VECTOR_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    for (index = 0; index < 32; index++)
+    {
+        STRICT_EXPECTED_CALL(test_connection_status_callback(IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK, CALLBACK_CONTEXT));
+    }
+    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE));
+    STRICT_EXPECTED_CALL(VECTOR_element(TEST_VECTOR_HANDLE, 0));
+    STRICT_EXPECTED_CALL(test_connection_status_callback(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK, CALLBACK_CONTEXT));
+    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
+    /*the pass produced user callbacks, so the next one does not wait*/
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_DoWork(TEST_IOTHUB_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_GetWorkWaitTime(TEST_IOTHUB_CLIENT_HANDLE, 10, IGNORED_PTR_ARG))
+        .IgnoreArgument_waitMs();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 10))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    g_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_068: [ If OPTION_CALLBACK_DISPATCH_THREAD was set to true, the callback dispatch thread shall be started by calling ThreadAPI_Create before the worker thread is started. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_069: [ Before starting the callback dispatch thread a condition shall be created by calling Condition_Init. ]*/
+TEST_FUNCTION(IoTHubClient_SendEventAsync_starts_callback_dispatch_thread_succeed)
+{
+    // arrange
+    bool use_dispatch_thread = true;
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetOption(iothub_handle, OPTION_CALLBACK_DISPATCH_THREAD, &use_dispatch_thread);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Init());
+    EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Init());
+    EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_SendEventAsync(IGNORED_PTR_ARG, TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_IS_NOT_NULL(g_first_thread_func);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_066: [ Queueing a user callback shall wake up the callback dispatch thread (if any) by calling Condition_Post. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_070: [ The callback dispatch thread shall wait on its condition until a user callback is queued, then dispatch the queued callbacks without holding the lock. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_071: [ The callback dispatch thread shall exit when IoTHubClient_Destroy is called. ]*/
+TEST_FUNCTION(IoTHubClient_CallbackDispatch_Thread_event_confirm_succeed)
+{
+    // arrange
+    bool use_dispatch_thread = true;
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetOption(iothub_handle, OPTION_CALLBACK_DISPATCH_THREAD, &use_dispatch_thread);
+    (void)IoTHubClient_SendEventAsync(iothub_handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    g_eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, g_userContextCallback);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    umock_c_reset_all_calls();
+
+    g_how_thread_loops = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(test_event_confirmation_callback(IOTHUB_CLIENT_CONFIRMATION_OK, NULL));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_lock();
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    // act
+    ASSERT_IS_NOT_NULL(g_first_thread_func);
+    g_first_thread_func(g_thread_func_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Destroy(iothub_handle);
+}
+
+/* Tests_SRS_IOTHUBCLIENT_01_072: [ IoTHubClient_Destroy shall signal the callback dispatch thread (if any) to end by calling Condition_Post. ]*/
+/* Tests_SRS_IOTHUBCLIENT_01_073: [ IoTHubClient_Destroy shall join the callback dispatch thread. ]*/
+TEST_FUNCTION(IoTHubClient_Destroy_joins_callback_dispatch_thread_succeed)
+{
+    // arrange
+    bool use_dispatch_thread = true;
+    IOTHUB_CLIENT_HANDLE iothub_handle = IoTHubClient_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClient_SetOption(iothub_handle, OPTION_CALLBACK_DISPATCH_THREAD, &use_dispatch_thread);
+    (void)IoTHubClient_SetConnectionStatusCallback(iothub_handle, test_connection_status_callback, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubClient_LL_Destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument_iotHubClientHandle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_threadHandle()
+        .IgnoreArgument_res();
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_threadHandle()
+        .IgnoreArgument_res();
+    STRICT_EXPECTED_CALL(VECTOR_size(TEST_VECTOR_HANDLE));
+    STRICT_EXPECTED_CALL(VECTOR_destroy(TEST_VECTOR_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    IoTHubClient_Destroy(iothub_handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
 END_TEST_SUITE(iothubclient_ut)
@@ -71,6 +71,20 @@ static size_t whenShallMap_Create_fail;
 static size_t currentMap_Clone_call;
 static size_t whenShallMap_Clone_fail;
 
+static size_t currentMap_AddOrUpdate_call;
+static size_t whenShallMap_AddOrUpdate_fail;
+
+/*every map has the properties g_mapKeys=g_mapValues, but the call whenShallMap_GetInternals_change_a_value and
+the call whenShallMap_GetInternals_add_a_key, that also has content-encoding=deflate*/
+static const char* const g_mapKeys[] = { "name", "version" };
+static const char* const g_mapValues[] = { "sensor", "1" };
+static const char* const g_changedMapValues[] = { "sensor", "2" };
+static const char* const g_addedMapKeys[] = { "name", "version", "content-encoding" };
+static const char* const g_addedMapValues[] = { "sensor", "1", "deflate" };
+static size_t currentMap_GetInternals_call;
+static size_t whenShallMap_GetInternals_change_a_value;
+static size_t whenShallMap_GetInternals_add_a_key;
+
 /*different STRING constructors*/
 static size_t currentSTRING_new_call;
 static size_t whenShallSTRING_new_fail;
@@ -97,6 +111,17 @@ static size_t whenShallSTRING_concat_with_STRING_fail;
 static MAP_FILTER_CALLBACK g_mapFilterFunc;
 
 static const unsigned char c[1] = { '3' };
+static size_t g_release_callback_count;
+static const unsigned char* g_released_byte_array;
+static void* g_released_context;
+
+static void test_release_callback(const unsigned char* byteArray, size_t size, void* context)
+{
+    (void)size;
+    g_release_callback_count++;
+    g_released_byte_array = byteArray;
+    g_released_context = context;
+}
 static const char* TEST_MESSAGE_ID = "3820ADAE-E3CA-4065-843A-A6BDE950D8DC";
 static const char* TEST_MESSAGE_ID2 = "052BA01A-ECBF-48CF-BC7B-64B315D898B7";
 
@@ -244,6 +269,38 @@ public:
         free(handle);
     MOCK_VOID_METHOD_END()
 
+    MOCK_STATIC_METHOD_3(, MAP_RESULT, Map_AddOrUpdate, MAP_HANDLE, handle, const char*, key, const char*, value)
+        MAP_RESULT result2;
+        currentMap_AddOrUpdate_call++;
+        if (currentMap_AddOrUpdate_call == whenShallMap_AddOrUpdate_fail)
+        {
+            result2 = MAP_ERROR;
+        }
+        else
+        {
+            result2 = MAP_OK;
+        }
+    MOCK_METHOD_END(MAP_RESULT, result2)
+
+    MOCK_STATIC_METHOD_4(, MAP_RESULT, Map_GetInternals, MAP_HANDLE, handle, const char*const**, keys, const char*const**, values, size_t*, count)
+        currentMap_GetInternals_call++;
+        if (currentMap_GetInternals_call == whenShallMap_GetInternals_add_a_key)
+        {
+            *keys = g_addedMapKeys;
+            *values = g_addedMapValues;
+            *count = sizeof(g_addedMapKeys) / sizeof(g_addedMapKeys[0]);
+        }
+        else
+        {
+            *keys = g_mapKeys;
+            *values = (currentMap_GetInternals_call == whenShallMap_GetInternals_change_a_value) ? g_changedMapValues : g_mapValues;
+            *count = sizeof(g_mapKeys) / sizeof(g_mapKeys[0]);
+        }
+    MOCK_METHOD_END(MAP_RESULT, MAP_OK)
+
+    MOCK_STATIC_METHOD_2(, MAP_RESULT, Map_Delete, MAP_HANDLE, handle, const char*, key)
+    MOCK_METHOD_END(MAP_RESULT, MAP_OK)
+
         /*Strings*/
         MOCK_STATIC_METHOD_0(, STRING_HANDLE, STRING_new)
         STRING_HANDLE result2;
@@ -370,6 +427,9 @@ DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubMessageMocks, , int, BUFFER_size, BUFFER_HAN
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubMessageMocks, , MAP_HANDLE, Map_Create, MAP_FILTER_CALLBACK, mapFilterFunc);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubMessageMocks, , void, Map_Destroy, MAP_HANDLE, handle)
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubMessageMocks, , MAP_HANDLE, Map_Clone, MAP_HANDLE, handle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIoTHubMessageMocks, , MAP_RESULT, Map_AddOrUpdate, MAP_HANDLE, handle, const char*, key, const char*, value);
+DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubMessageMocks, , MAP_RESULT, Map_GetInternals, MAP_HANDLE, handle, const char*const**, keys, const char*const**, values, size_t*, count);
+DECLARE_GLOBAL_MOCK_METHOD_2(CIoTHubMessageMocks, , MAP_RESULT, Map_Delete, MAP_HANDLE, handle, const char*, key);
 
 DECLARE_GLOBAL_MOCK_METHOD_0(CIoTHubMessageMocks, , STRING_HANDLE, STRING_new);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubMessageMocks, , STRING_HANDLE, STRING_clone, STRING_HANDLE, handle);
@@ -430,6 +490,17 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         currentMap_Clone_call = 0;
         whenShallMap_Clone_fail = 0;
 
+        currentMap_AddOrUpdate_call = 0;
+        whenShallMap_AddOrUpdate_fail = 0;
+
+        currentMap_GetInternals_call = 0;
+        whenShallMap_GetInternals_change_a_value = 0;
+        whenShallMap_GetInternals_add_a_key = 0;
+
+        g_release_callback_count = 0;
+        g_released_byte_array = NULL;
+        g_released_context = NULL;
+
         currentmalloc_call = 0;
         whenShallmalloc_fail = 0;
 
@@ -731,6 +802,154 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         ///cleanup
     }
 
+    /*Tests_SRS_IOTHUBMESSAGE_01_022: [ IoTHubMessage_CreateFromByteArrayNoCopy shall call Map_Create to create the message properties. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_023: [ IoTHubMessage_CreateFromByteArrayNoCopy shall not copy byteArray, the message shall reference it until it is destroyed. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_024: [ The type of the new message shall be IOTHUBMESSAGE_BYTEARRAY. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_happy_path)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_Create(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, (void*)0x42);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(h);
+        mocks.AssertActualAndExpectedCalls();
+        auto messageType = IoTHubMessage_GetContentType(h);
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, messageType);
+        ASSERT_ARE_EQUAL(size_t, 0, g_release_callback_count);
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_020: [ If byteArray is NULL and size is not 0, IoTHubMessage_CreateFromByteArrayNoCopy shall return NULL. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_fails_when_size_non_zero_buffer_NULL)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(NULL, 1, test_release_callback, NULL);
+
+        ///assert
+        ASSERT_IS_NULL(h);
+        ASSERT_ARE_EQUAL(size_t, 0, g_release_callback_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_021: [ If there are any errors then IoTHubMessage_CreateFromByteArrayNoCopy shall return NULL and shall not call releaseCallback. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreateFromByteArrayNoCopy_fails_when_Map_Create_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_Create(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        whenShallMap_Create_fail = currentMap_Create_call + 1;
+
+        ///act
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, NULL);
+
+        ///assert
+        ASSERT_IS_NULL(h);
+        ASSERT_ARE_EQUAL(size_t, 0, g_release_callback_count);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_026: [ For a message created by IoTHubMessage_CreateFromByteArrayNoCopy, IoTHubMessage_GetByteArray shall return the caller owned byte array and its size. ]*/
+    TEST_FUNCTION(IoTHubMessage_GetByteArray_NoCopy_returns_the_caller_buffer)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, NULL);
+        const unsigned char* byteArray;
+        size_t size;
+        mocks.ResetAllCalls();
+
+        ///act
+        auto r = IoTHubMessage_GetByteArray(h, &byteArray, &size);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, r);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)c, (void*)byteArray);
+        ASSERT_ARE_EQUAL(size_t, 1, size);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_027: [ If the message was created by IoTHubMessage_CreateFromByteArrayNoCopy, IoTHubMessage_Destroy shall call releaseCallback (if not NULL) passing the byte array, its size and releaseContext. ]*/
+    TEST_FUNCTION(IoTHubMessage_Destroy_NoCopy_calls_the_release_callback)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Map_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(h));
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
+
+        ///act
+        IoTHubMessage_Destroy(h);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+        ASSERT_ARE_EQUAL(size_t, 1, g_release_callback_count);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)c, (void*)g_released_byte_array);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_released_context);
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_025: [ The clone of a message created by IoTHubMessage_CreateFromByteArrayNoCopy shall own a copy of the byte array. ]*/
+    TEST_FUNCTION(IoTHubMessage_Clone_of_NoCopy_message_copies_the_byte_array)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, NULL);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_create(c, 1));
+        STRICT_EXPECTED_CALL(mocks, Map_Clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_Clone(h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(r);
+        ASSERT_ARE_EQUAL(size_t, 0, g_release_callback_count);
+        IoTHubMessage_Destroy(h);
+        ASSERT_ARE_EQUAL(size_t, 1, g_release_callback_count);
+    }
+
     /*Tests_SRS_IOTHUBMESSAGE_01_004: [If iotHubMessageHandle is NULL, IoTHubMessage_Destroy shall do nothing.] */
     TEST_FUNCTION(IoTHubMessage_Destroy_With_NULL_handle_does_nothing)
     {
@@ -761,6 +980,7 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         STRICT_EXPECTED_CALL(mocks, gballoc_free(h));
         STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
         STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
 
         ///act
         IoTHubMessage_Destroy(h);
@@ -786,6 +1006,7 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         STRICT_EXPECTED_CALL(mocks, gballoc_free(h));
         STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
         STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG)).IgnoreArgument(1);
 
         ///act
         IoTHubMessage_Destroy(h);
@@ -909,6 +1130,130 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         IoTHubMessage_Destroy(h);
     }
 
+    /*Tests_SRS_IOTHUBMESSAGE_01_036: [ If iotHubMessageHandle is NULL, or byteArray is NULL while size is not 0, IoTHubMessage_SetByteArray shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetByteArray_with_NULL_handle_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        auto r = IoTHubMessage_SetByteArray(NULL, c, 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_036: [ If iotHubMessageHandle is NULL, or byteArray is NULL while size is not 0, IoTHubMessage_SetByteArray shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetByteArray_with_NULL_byteArray_and_non_zero_size_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        mocks.ResetAllCalls();
+
+        ///act
+        auto r = IoTHubMessage_SetByteArray(h, NULL, 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_037: [ IoTHubMessage_SetByteArray shall copy byteArray by calling BUFFER_create. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_039: [ IoTHubMessage_SetByteArray shall then release the previous content the same way IoTHubMessage_Destroy does, including calling the releaseCallback of a message created by IoTHubMessage_CreateFromByteArrayNoCopy. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_040: [ IoTHubMessage_SetByteArray shall set the content type of the message to IOTHUBMESSAGE_BYTEARRAY and return IOTHUB_MESSAGE_OK. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetByteArray_replaces_a_STRING_content)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        const unsigned char newContent[2] = { 'x', 'y' };
+        const unsigned char* byteArray;
+        size_t size;
+        auto h = IoTHubMessage_CreateFromString("aaaa");
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, BUFFER_create(newContent, 2));
+        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_SetByteArray(h, newContent, 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, r);
+        mocks.AssertActualAndExpectedCalls();
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, IoTHubMessage_GetContentType(h));
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetByteArray(h, &byteArray, &size));
+        ASSERT_ARE_EQUAL(size_t, 2, size);
+        ASSERT_ARE_EQUAL(uint8_t, 'x', byteArray[0]);
+        ASSERT_ARE_EQUAL(uint8_t, 'y', byteArray[1]);
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_039: [ IoTHubMessage_SetByteArray shall then release the previous content the same way IoTHubMessage_Destroy does, including calling the releaseCallback of a message created by IoTHubMessage_CreateFromByteArrayNoCopy. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetByteArray_releases_a_NoCopy_content)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        const unsigned char newContent[2] = { 'x', 'y' };
+        const unsigned char* byteArray;
+        size_t size;
+        auto h = IoTHubMessage_CreateFromByteArrayNoCopy(c, 1, test_release_callback, (void*)0x42);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, BUFFER_create(newContent, 2));
+
+        ///act
+        auto r = IoTHubMessage_SetByteArray(h, newContent, 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, r);
+        mocks.AssertActualAndExpectedCalls();
+        ASSERT_ARE_EQUAL(size_t, 1, g_release_callback_count);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)c, (void*)g_released_byte_array);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_released_context);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetByteArray(h, &byteArray, &size));
+        ASSERT_ARE_EQUAL(size_t, 2, size);
+        ASSERT_ARE_EQUAL(uint8_t, 'x', byteArray[0]);
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+        ASSERT_ARE_EQUAL(size_t, 1, g_release_callback_count);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_038: [ If BUFFER_create fails, IoTHubMessage_SetByteArray shall return IOTHUB_MESSAGE_ERROR and leave the message unchanged. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetByteArray_fails_when_BUFFER_create_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        const unsigned char newContent[2] = { 'x', 'y' };
+        auto h = IoTHubMessage_CreateFromString("aaaa");
+        mocks.ResetAllCalls();
+
+        whenShallBUFFER_create_fail = currentBUFFER_create_call + 1;
+        STRICT_EXPECTED_CALL(mocks, BUFFER_create(newContent, 2));
+
+        ///act
+        auto r = IoTHubMessage_SetByteArray(h, newContent, 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, r);
+        mocks.AssertActualAndExpectedCalls();
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_STRING, IoTHubMessage_GetContentType(h));
+        ASSERT_ARE_EQUAL(char_ptr, "aaaa", IoTHubMessage_GetString(h));
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
     /*Tests_SRS_IOTHUBMESSAGE_03_001: [IoTHubMessage_Clone shall create a new IoT hub message with data content identical to that of the iotHubMessageHandle parameter.]*/
     /*Tests_SRS_IOTHUBMESSAGE_02_006: [IoTHubMessage_Clone shall clone the content by a call to BUFFER_clone or STRING_clone] */
     /*Tests_SRS_IOTHUBMESSAGE_02_005: [IoTHubMessage_Clone shall clone the properties map by using Map_Clone.] */
@@ -1138,7 +1483,7 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         IoTHubMessage_Destroy(h);
     }
 
-    /*Tests_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle it shall return a non-NULL MAP_HANDLE.] */
+    /*Tests_SRS_IOTHUBMESSAGE_02_002: [Otherwise, for any non-NULL iotHubMessageHandle whose deferred properties (if any) were added it shall return a non-NULL MAP_HANDLE.] */
     TEST_FUNCTION(IoTHubMessage_Properties_happy_path)
     {        
         ///arrange
@@ -1173,87 +1518,285 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         ///cleanup
     }
 
-    /*Tests_SRS_IOTHUBMESSAGE_02_008: [If any parameter is NULL then IoTHubMessage_GetContentType shall return IOTHUBMESSAGE_UNKNOWN.] */
-    TEST_FUNCTION(IoTHubMessage_GetContentType_with_NULL_handle_fails)
+    /*Tests_SRS_IOTHUBMESSAGE_01_028: [ If iotHubMessageHandle is NULL, or properties is NULL while length is not 0, IoTHubMessage_SetDeferredProperties shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetDeferredProperties_with_NULL_handle_fails)
     {
         ///arrange
         CIoTHubMessageMocks mocks;
-        mocks.ResetAllCalls();
 
         ///act
-        auto r = IoTHubMessage_GetContentType(NULL);
+        auto r = IoTHubMessage_SetDeferredProperties(NULL, "a=1", 3);
 
         ///assert
-        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_UNKNOWN, r);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
         mocks.AssertActualAndExpectedCalls();
 
         ///cleanup
     }
 
-    /*Tests_SRS_IOTHUBMESSAGE_02_016: [If any parameter is NULL then IoTHubMessage_GetString  shall return NULL.] */
-    TEST_FUNCTION(IoTHubMessage_GetString_with_NULL_handle_returns_NULL)
+    /*Tests_SRS_IOTHUBMESSAGE_01_028: [ If iotHubMessageHandle is NULL, or properties is NULL while length is not 0, IoTHubMessage_SetDeferredProperties shall return IOTHUB_MESSAGE_INVALID_ARG. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetDeferredProperties_with_NULL_properties_fails)
     {
         ///arrange
         CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
         mocks.ResetAllCalls();
 
         ///act
-        auto r = IoTHubMessage_GetString(NULL);
+        auto r = IoTHubMessage_SetDeferredProperties(h, NULL, 3);
 
         ///assert
-        ASSERT_IS_NULL(r);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, r);
         mocks.AssertActualAndExpectedCalls();
 
         ///cleanup
+        IoTHubMessage_Destroy(h);
     }
 
-    /*Tests_SRS_IOTHUBMESSAGE_02_018: [IoTHubMessage_GetStringData shall return the currently stored null terminated string.] */
-    TEST_FUNCTION(IoTHubMessage_GetString_happy_path)
+    /*Tests_SRS_IOTHUBMESSAGE_01_029: [ IoTHubMessage_SetDeferredProperties shall keep a single copy of the length characters of properties and shall not touch the properties map. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetDeferredProperties_copies_the_text_only)
     {
         ///arrange
         CIoTHubMessageMocks mocks;
-        auto h = IoTHubMessage_CreateFromString("c, 1");
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
         mocks.ResetAllCalls();
 
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(8));
 
         ///act
-        auto r = IoTHubMessage_GetString(h);
+        auto r = IoTHubMessage_SetDeferredProperties(h, "a=1&b=22&c=3", 7);
 
         ///assert
-        ASSERT_ARE_EQUAL(char_ptr, "c, 1", r);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, r);
         mocks.AssertActualAndExpectedCalls();
 
         ///cleanup
         IoTHubMessage_Destroy(h);
     }
 
-    /*Tests_SRS_IOTHUBMESSAGE_02_017: [IoTHubMessage_GetString shall return NULL if the iotHubMessageHandle does not refer to a IOTHUBMESSAGE of type STRING.] */
-    TEST_FUNCTION(IoTHubMessage_GetString_with_BYTEARRAY_fails)
+    /*Tests_SRS_IOTHUBMESSAGE_01_030: [ If the copy cannot be allocated, IoTHubMessage_SetDeferredProperties shall return IOTHUB_MESSAGE_ERROR. ]*/
+    TEST_FUNCTION(IoTHubMessage_SetDeferredProperties_fails_when_malloc_fails)
     {
         ///arrange
         CIoTHubMessageMocks mocks;
         auto h = IoTHubMessage_CreateFromByteArray(c, 1);
         mocks.ResetAllCalls();
 
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(4));
+
         ///act
-        auto r = IoTHubMessage_GetString(h);
+        auto r = IoTHubMessage_SetDeferredProperties(h, "a=1", 3);
 
         ///assert
-        ASSERT_IS_NULL(r);
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, r);
         mocks.AssertActualAndExpectedCalls();
 
         ///cleanup
         IoTHubMessage_Destroy(h);
     }
 
-    /* Tests_SRS_IOTHUBMESSAGE_07_012: [if any of the parameters are NULL then IoTHubMessage_SetMessageId shall return a IOTHUB_MESSAGE_INVALID_ARG value.] */
-    TEST_FUNCTION(IoTHubMessage_SetMessageId_NULL_handle_Fails)
+    /*Tests_SRS_IOTHUBMESSAGE_01_031: [ The first call to IoTHubMessage_Properties after IoTHubMessage_SetDeferredProperties shall add every name=value pair of the deferred text to the properties map by calling Map_AddOrUpdate and then release the deferred text. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_032: [ Pairs that do not contain '=' shall be skipped. ]*/
+    TEST_FUNCTION(IoTHubMessage_Properties_adds_the_deferred_properties)
     {
         ///arrange
         CIoTHubMessageMocks mocks;
-
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        (void)IoTHubMessage_SetDeferredProperties(h, "a=1&junk&b=22&c=", 16);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "a", "1"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "b", "22"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "c", ""))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r1 = IoTHubMessage_Properties(h);
+        auto r2 = IoTHubMessage_Properties(h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(r1);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)r1, (void*)r2);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_033: [ If adding a deferred property fails, IoTHubMessage_Properties shall return NULL. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_054: [ If adding a deferred property fails, the deferred text shall be kept so that the next call adds every pair again. ]*/
+    TEST_FUNCTION(IoTHubMessage_Properties_fails_when_Map_AddOrUpdate_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        (void)IoTHubMessage_SetDeferredProperties(h, "a=1&b=2", 7);
+        mocks.ResetAllCalls();
+
+        whenShallMap_AddOrUpdate_fail = currentMap_AddOrUpdate_call + 1;
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "a", "1"))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_Properties(h);
+
+        ///assert
+        ASSERT_IS_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_054: [ If adding a deferred property fails, the deferred text shall be kept so that the next call adds every pair again. ]*/
+    TEST_FUNCTION(IoTHubMessage_Properties_adds_every_deferred_property_again_after_a_failure)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        (void)IoTHubMessage_SetDeferredProperties(h, "a=1&b=2&c=3", 11);
+        whenShallMap_AddOrUpdate_fail = currentMap_AddOrUpdate_call + 2;
+        (void)IoTHubMessage_Properties(h);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "a", "1"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "b", "2"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "c", "3"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_Properties(h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_034: [ IoTHubMessage_Clone shall move any deferred properties of iotHubMessageHandle into its properties map before cloning it. ]*/
+    TEST_FUNCTION(IoTHubMessage_Clone_adds_the_deferred_properties_before_Map_Clone)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        (void)IoTHubMessage_SetDeferredProperties(h, "a=1", 3);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "a", "1"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_Clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_Clone(h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(r);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_02_008: [If any parameter is NULL then IoTHubMessage_GetContentType shall return IOTHUBMESSAGE_UNKNOWN.] */
+    TEST_FUNCTION(IoTHubMessage_GetContentType_with_NULL_handle_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        mocks.ResetAllCalls();
+
+        ///act
+        auto r = IoTHubMessage_GetContentType(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_UNKNOWN, r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_02_016: [If any parameter is NULL then IoTHubMessage_GetString  shall return NULL.] */
+    TEST_FUNCTION(IoTHubMessage_GetString_with_NULL_handle_returns_NULL)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        mocks.ResetAllCalls();
+
+        ///act
+        auto r = IoTHubMessage_GetString(NULL);
+
+        ///assert
+        ASSERT_IS_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_02_018: [IoTHubMessage_GetStringData shall return the currently stored null terminated string.] */
+    TEST_FUNCTION(IoTHubMessage_GetString_happy_path)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromString("c, 1");
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        auto r = IoTHubMessage_GetString(h);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, "c, 1", r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_02_017: [IoTHubMessage_GetString shall return NULL if the iotHubMessageHandle does not refer to a IOTHUBMESSAGE of type STRING.] */
+    TEST_FUNCTION(IoTHubMessage_GetString_with_BYTEARRAY_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        mocks.ResetAllCalls();
+
+        ///act
+        auto r = IoTHubMessage_GetString(h);
+
+        ///assert
+        ASSERT_IS_NULL(r);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /* Tests_SRS_IOTHUBMESSAGE_07_012: [if any of the parameters are NULL then IoTHubMessage_SetMessageId shall return a IOTHUB_MESSAGE_INVALID_ARG value.] */
+    TEST_FUNCTION(IoTHubMessage_SetMessageId_NULL_handle_Fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
         ///act
         IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetMessageId(NULL, TEST_MESSAGE_ID);
 
@@ -1520,4 +2063,360 @@ BEGIN_TEST_SUITE(iothubmessage_ut)
         IoTHubMessage_Destroy(h);
     }
 
+    /*Tests_SRS_IOTHUBMESSAGE_01_041: [ If capacity is 0 or the pool would not fit in a size_t, IoTHubMessage_CreatePool shall fail and return NULL. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreatePool_with_0_capacity_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(0);
+
+        ///assert
+        ASSERT_IS_NULL(pool);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_042: [ IoTHubMessage_CreatePool shall allocate the pool and its capacity messages with a single allocation, the content storage and properties map of a message are only allocated when it is first used. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreatePool_allocates_once)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(4);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(pool);
+        ASSERT_ARE_EQUAL(size_t, 0, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_DestroyPool(pool);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_043: [ If the allocation fails, IoTHubMessage_CreatePool shall return NULL. ]*/
+    TEST_FUNCTION(IoTHubMessage_CreatePool_fails_when_malloc_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        whenShallmalloc_fail = 1;
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(4);
+
+        ///assert
+        ASSERT_IS_NULL(pool);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_047: [ If pool or iotHubMessageHandle is NULL, or the clone fails for any reason, IoTHubMessage_CloneFromPool shall return NULL. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_with_NULL_pool_fails)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        mocks.ResetAllCalls();
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(NULL, h);
+
+        ///assert
+        ASSERT_IS_NULL(clone);
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_044: [ IoTHubMessage_CloneFromPool shall copy the content, message id and correlation id of iotHubMessageHandle into the storage the pooled message already has, and only allocate when that storage is too small. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_045: [ When the pooled message has no properties map yet, or its map does not start with the keys of the properties of iotHubMessageHandle in the same order, IoTHubMessage_CloneFromPool shall replace it with a Map_Clone of them. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_allocates_the_storage_of_a_message_on_first_use)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        const unsigned char* content;
+        size_t size;
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, BUFFER_u_char(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(2));
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_Clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, IoTHubMessage_GetContentType(clone));
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetByteArray(clone, &content, &size));
+        ASSERT_ARE_EQUAL(size_t, 1, size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(content, c, 1));
+        ASSERT_ARE_EQUAL(size_t, 2, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_044: [ IoTHubMessage_CloneFromPool shall copy the content, message id and correlation id of iotHubMessageHandle into the storage the pooled message already has, and only allocate when that storage is too small. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_046: [ Otherwise IoTHubMessage_CloneFromPool shall keep the properties map of the pooled message and only call Map_AddOrUpdate for the values that differ. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_048: [ A message taken from a pool shall be given back to it, keeping the storage of its content, its properties map and the storage of its message id and correlation id for the next IoTHubMessage_CloneFromPool. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_reuses_the_message_without_allocating)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromString("steady state");
+        (void)IoTHubMessage_SetMessageId(h, TEST_MESSAGE_ID);
+        (void)IoTHubMessage_SetCorrelationId(h, TEST_MESSAGE_ID2);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IoTHubMessage_Destroy(IoTHubMessage_CloneFromPool(pool, h));
+        size_t heapAllocationCount = IoTHubMessage_GetPoolHeapAllocationCount(pool);
+        mocks.ResetAllCalls();
+
+        /*no gballoc_malloc, mallocAndStrcpy_s, BUFFER_create or Map_Clone: the clone, its content, ids and properties are all reused*/
+        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+        IoTHubMessage_Destroy(clone);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(size_t, heapAllocationCount, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_044: [ IoTHubMessage_CloneFromPool shall copy the content, message id and correlation id of iotHubMessageHandle into the storage the pooled message already has, and only allocate when that storage is too small. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_copies_the_string_and_ids_of_the_source)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromString("steady state");
+        (void)IoTHubMessage_SetMessageId(h, TEST_MESSAGE_ID);
+        (void)IoTHubMessage_SetCorrelationId(h, TEST_MESSAGE_ID2);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IoTHubMessage_Destroy(IoTHubMessage_CloneFromPool(pool, h));
+        mocks.ResetAllCalls();
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_STRING, IoTHubMessage_GetContentType(clone));
+        ASSERT_ARE_EQUAL(char_ptr, "steady state", IoTHubMessage_GetString(clone));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_MESSAGE_ID, IoTHubMessage_GetMessageId(clone));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_MESSAGE_ID2, IoTHubMessage_GetCorrelationId(clone));
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_046: [ Otherwise IoTHubMessage_CloneFromPool shall keep the properties map of the pooled message and only call Map_AddOrUpdate for the values that differ. ]*/
+    /*Tests_SRS_IOTHUBMESSAGE_01_051: [ IoTHubMessage_GetPoolHeapAllocationCount shall return the number of times IoTHubMessage_CloneFromPool had to allocate memory, or to update or remove a value of a properties map, since the pool was created. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_only_updates_the_properties_that_differ)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IoTHubMessage_Destroy(IoTHubMessage_CloneFromPool(pool, h));
+        size_t heapAllocationCount = IoTHubMessage_GetPoolHeapAllocationCount(pool);
+        mocks.ResetAllCalls();
+        /*the source has version=2*/
+        whenShallMap_GetInternals_change_a_value = currentMap_GetInternals_call + 1;
+
+        STRICT_EXPECTED_CALL(mocks, BUFFER_u_char(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_AddOrUpdate(IGNORED_PTR_ARG, "version", "2"))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(size_t, heapAllocationCount + 1, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_055: [ Keys of the pooled message that follow the keys of iotHubMessageHandle shall be removed with Map_Delete, from the last one. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_removes_a_property_added_to_the_pooled_message)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IoTHubMessage_Destroy(IoTHubMessage_CloneFromPool(pool, h));
+        size_t heapAllocationCount = IoTHubMessage_GetPoolHeapAllocationCount(pool);
+        mocks.ResetAllCalls();
+        /*the pooled message was given content-encoding=deflate after its previous clone*/
+        whenShallMap_GetInternals_add_a_key = currentMap_GetInternals_call + 2;
+
+        STRICT_EXPECTED_CALL(mocks, BUFFER_u_char(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_length(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+        STRICT_EXPECTED_CALL(mocks, Map_Delete(IGNORED_PTR_ARG, "content-encoding"))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_EQUAL(size_t, heapAllocationCount + 1, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_049: [ When all the messages of the pool are in use, IoTHubMessage_CloneFromPool shall return IoTHubMessage_Clone(iotHubMessageHandle) and count the allocation. ]*/
+    TEST_FUNCTION(IoTHubMessage_CloneFromPool_clones_on_the_heap_when_the_pool_is_exhausted)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IOTHUB_MESSAGE_HANDLE pooled = IoTHubMessage_CloneFromPool(pool, h);
+        size_t heapAllocationCount = IoTHubMessage_GetPoolHeapAllocationCount(pool);
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, Map_Clone(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(clone);
+        ASSERT_ARE_NOT_EQUAL(void_ptr, pooled, clone);
+        ASSERT_ARE_EQUAL(size_t, heapAllocationCount + 1, IoTHubMessage_GetPoolHeapAllocationCount(pool));
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_Destroy(pooled);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_048: [ A message taken from a pool shall be given back to it, keeping the storage of its content, its properties map and the storage of its message id and correlation id for the next IoTHubMessage_CloneFromPool. ]*/
+    TEST_FUNCTION(IoTHubMessage_Destroy_gives_a_pooled_message_back_to_its_pool)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CloneFromPool(pool, h);
+        mocks.ResetAllCalls();
+
+        ///act
+        IoTHubMessage_Destroy(clone);
+
+        ///assert
+        /*no gballoc_free and no Map_Destroy, and the next clone gets the same message*/
+        mocks.AssertActualAndExpectedCalls();
+        ASSERT_ARE_EQUAL(void_ptr, clone, IoTHubMessage_CloneFromPool(pool, h));
+
+        ///cleanup
+        IoTHubMessage_Destroy(clone);
+        IoTHubMessage_DestroyPool(pool);
+        IoTHubMessage_Destroy(h);
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_050: [ If pool is NULL, IoTHubMessage_GetPoolHeapAllocationCount shall return 0. ]*/
+    TEST_FUNCTION(IoTHubMessage_GetPoolHeapAllocationCount_with_NULL_returns_0)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+
+        ///act
+        size_t result = IoTHubMessage_GetPoolHeapAllocationCount(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+        mocks.AssertActualAndExpectedCalls();
+    }
+
+    /*Tests_SRS_IOTHUBMESSAGE_01_053: [ IoTHubMessage_DestroyPool shall free the pool, and the content storage, properties map and id strings of its messages. ]*/
+    TEST_FUNCTION(IoTHubMessage_DestroyPool_frees_the_storage_of_its_messages)
+    {
+        ///arrange
+        CIoTHubMessageMocks mocks;
+        auto h = IoTHubMessage_CreateFromByteArray(c, 1);
+        IOTHUB_MESSAGE_POOL_HANDLE pool = IoTHubMessage_CreatePool(1);
+        IoTHubMessage_Destroy(IoTHubMessage_CloneFromPool(pool, h));
+        mocks.ResetAllCalls();
+
+        STRICT_EXPECTED_CALL(mocks, Map_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(mocks, gballoc_free(pool));
+
+        ///act
+        IoTHubMessage_DestroyPool(pool);
+
+        ///assert
+        mocks.AssertActualAndExpectedCalls();
+
+        ///cleanup
+        IoTHubMessage_Destroy(h);
+    }
+
 END_TEST_SUITE(iothubmessage_ut)
@@ -2650,6 +2650,62 @@ TEST_FUNCTION(SetOption_log_trace)
 }
 
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_01_032: [If `option` is `message_pool_size`, IoTHubTransport_AMQP_Common_SetOption shall return IOTHUB_CLIENT_OK without doing anything else, the messenger already recycles the records of the events it sends]
+TEST_FUNCTION(SetOption_message_pool_size_succeeds)
+{
+	// arrange
+	initialize_test_variables();
+	TRANSPORT_LL_HANDLE handle = create_transport();
+
+	IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+	IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+	ASSERT_IS_NOT_NULL(device_handle);
+
+	umock_c_reset_all_calls();
+
+	// act
+	unsigned int value = 16;
+	IOTHUB_CLIENT_RESULT result = IoTHubTransport_AMQP_Common_SetOption(handle, OPTION_MESSAGE_POOL_SIZE, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_OK, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	destroy_transport(handle, device_handle, NULL);
+}
+
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_102: [If `option` is a device-specific option, it shall be saved and applied to each registered device using device_set_option()]
+TEST_FUNCTION(SetOption_batching_applied_to_registered_devices)
+{
+	// arrange
+	initialize_test_variables();
+	TRANSPORT_LL_HANDLE handle = create_transport();
+
+	IOTHUB_DEVICE_CONFIG* device_config = create_device_config(TEST_DEVICE_ID_CHAR_PTR, true);
+	IOTHUB_DEVICE_HANDLE device_handle = register_device(handle, device_config, &TEST_waitingToSend, true);
+	ASSERT_IS_NOT_NULL(device_handle);
+
+	bool value = true;
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_REGISTERED_DEVICES_LIST));
+	EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG)).SetReturn(device_handle);
+	STRICT_EXPECTED_CALL(device_set_option(TEST_DEVICE_HANDLE, DEVICE_OPTION_BATCHING, &value));
+	EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+
+	// act
+	IOTHUB_CLIENT_RESULT result = IoTHubTransport_AMQP_Common_SetOption(handle, OPTION_BATCHING, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_OK, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	destroy_transport(handle, device_handle, NULL);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_105: [If `option` does not match one of the options handled by this module, it shall be passed to `instance->tls_io` using xio_setoption()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_106: [If `instance->tls_io` is NULL, it shall be set invoking instance->underlying_io_transport_provider()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_COMMON_09_108: [When `instance->tls_io` is created, IoTHubTransport_AMQP_Common_SetOption shall apply `instance->saved_tls_options` with OptionHandler_FeedOptions()]
@@ -41,7 +41,6 @@ void real_free(void* ptr)
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/strings.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_uamqp_c/session.h"
@@ -55,6 +54,7 @@ void real_free(void* ptr)
 
 #undef ENABLE_MOCKS
 
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "iothubtransport_amqp_messenger.h"
 
 
@@ -132,18 +132,13 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_MESSAGE_DISPOSITION_ACCEPTED_AMQP_VALUE      (AMQP_VALUE)0x4471
 #define TEST_MESSAGE_DISPOSITION_RELEASED_AMQP_VALUE      (AMQP_VALUE)0x4472
 #define TEST_MESSAGE_DISPOSITION_REJECTED_AMQP_VALUE      (AMQP_VALUE)0x4473
-#define TEST_SINGLYLINKEDLIST_HANDLE                      (SINGLYLINKEDLIST_HANDLE)0x4476
-#define TEST_LIST_ITEM_HANDLE                             (LIST_ITEM_HANDLE)0x4477
 #define TEST_SEND_EVENT_TASK                              (const void*)0x4478
 #define TEST_IOTHUB_CLIENT_HANDLE                         (void*)0x4479
 static IOTHUB_MESSAGE_LIST* TEST_IOTHUB_MESSAGE_LIST_HANDLE;
-static SINGLYLINKEDLIST_HANDLE TEST_WAIT_TO_SEND_LIST;
-static SINGLYLINKEDLIST_HANDLE TEST_IN_PROGRESS_LIST;
-#define TEST_WAIT_TO_SEND_LIST1                           (SINGLYLINKEDLIST_HANDLE)0x4481
-#define TEST_WAIT_TO_SEND_LIST2                           (SINGLYLINKEDLIST_HANDLE)0x4482
-#define TEST_IN_PROGRESS_LIST1                            (SINGLYLINKEDLIST_HANDLE)0x4483
-#define TEST_IN_PROGRESS_LIST2                            (SINGLYLINKEDLIST_HANDLE)0x4484
 #define TEST_OPTIONHANDLER_HANDLE                         (OPTIONHANDLER_HANDLE)0x4485
+#define TEST_BATCH_MESSAGE_HANDLE                         (MESSAGE_HANDLE)0x4486
+#define TEST_AMQP_BATCHING_FORMAT_CODE                    0x80013700
+#define TEST_ENCODED_EVENT_SIZE                           64
 #define INDEFINITE_TIME                                   ((time_t)-1)
 
 static delivery_number TEST_DELIVERY_NUMBER;
@@ -189,8 +184,10 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
 #endif
 
 
+#define TEST_MANY_IN_PROGRESS_EVENTS                      10000
+
 static int saved_malloc_returns_count = 0;
-static void* saved_malloc_returns[20];
+static void* saved_malloc_returns[TEST_MANY_IN_PROGRESS_EVENTS + 20];
 
 static void* TEST_malloc(size_t size)
 {
@@ -217,18 +214,6 @@ static void TEST_free(void* ptr)
 }
 
 
-static int saved_wait_to_send_list_count;
-static const void* saved_wait_to_send_list[20];
-
-static int saved_wait_to_send_list_count2;
-static const void* saved_wait_to_send_list2[20];
-
-static int saved_in_progress_list_count;
-static const void* saved_in_progress_list[20];
-
-static int saved_in_progress_list_count2;
-static const void* saved_in_progress_list2[20];
-
 static void* saved_on_state_changed_callback_context;
 static MESSENGER_STATE saved_on_state_changed_callback_previous_state;
 static MESSENGER_STATE saved_on_state_changed_callback_new_state;
@@ -376,6 +361,18 @@ static int TEST_message_create_from_iothub_message(IOTHUB_MESSAGE_HANDLE iothub_
 }
 
 
+static size_t TEST_encoded_event_size;
+static int TEST_message_create_uamqp_encoding_from_iothub_message(IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
+{
+	(void)message_handle;
+
+	// Tracked by TEST_malloc, so the messenger releasing it with free() is balanced.
+	body_binary_data->bytes = (const unsigned char*)TEST_malloc(TEST_encoded_event_size);
+	body_binary_data->length = TEST_encoded_event_size;
+
+	return 0;
+}
+
 static MESSAGE_HANDLE saved_IoTHubMessage_CreateFromUamqpMessage_uamqp_message;
 static int TEST_IoTHubMessage_CreateFromUamqpMessage_return;
 static int TEST_IoTHubMessage_CreateFromUamqpMessage(MESSAGE_HANDLE uamqp_message, IOTHUB_MESSAGE_HANDLE* iothub_message)
@@ -395,6 +392,8 @@ static MESSAGE_SENDER_HANDLE saved_messagesender_send_message_sender;
 static MESSAGE_HANDLE saved_messagesender_send_message;
 static ON_MESSAGE_SEND_COMPLETE saved_messagesender_send_on_message_send_complete;
 static void* saved_messagesender_send_callback_context;
+static int saved_messagesender_send_callback_contexts_count;
+static void* saved_messagesender_send_callback_contexts[TEST_MANY_IN_PROGRESS_EVENTS];
 
 static int TEST_messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE_HANDLE message, ON_MESSAGE_SEND_COMPLETE on_message_send_complete, void* callback_context)
 {
@@ -403,218 +402,12 @@ static int TEST_messagesender_send(MESSAGE_SENDER_HANDLE message_sender, MESSAGE
     saved_messagesender_send_on_message_send_complete = on_message_send_complete;
     saved_messagesender_send_callback_context = callback_context;
 
-    return TEST_messagesender_send_result;
-}
-
-
-static bool TEST_singlylinkedlist_add_fail_return = false;
-static LIST_ITEM_HANDLE TEST_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
-{
-	if (list == TEST_WAIT_TO_SEND_LIST1)
-	{
-		saved_wait_to_send_list[saved_wait_to_send_list_count++] = item;
-	}
-	else if (list == TEST_WAIT_TO_SEND_LIST2)
-	{
-		saved_wait_to_send_list2[saved_wait_to_send_list_count2++] = item;
-	}
-	else if (list == TEST_IN_PROGRESS_LIST1)
-	{
-		saved_in_progress_list[saved_in_progress_list_count++] = item;
-	}
-	else if (list == TEST_IN_PROGRESS_LIST2)
-	{
-		saved_in_progress_list2[saved_in_progress_list_count2++] = item;
-	}
-
-	return TEST_singlylinkedlist_add_fail_return ? NULL : (LIST_ITEM_HANDLE)item;
-}
-
-static int TEST_singlylinkedlist_remove_return = 0;
-static int TEST_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
-{
-	const void** TEST_list = NULL;
-	int* TEST_list_count = NULL;
-
-	if (list == TEST_WAIT_TO_SEND_LIST1)
-	{
-		TEST_list = saved_wait_to_send_list;
-		TEST_list_count = &saved_wait_to_send_list_count;
-	}
-	else if (list == TEST_WAIT_TO_SEND_LIST2)
-	{
-		TEST_list = saved_wait_to_send_list2;
-		TEST_list_count = &saved_wait_to_send_list_count2;
-	}
-	else if (list == TEST_IN_PROGRESS_LIST1)
-	{
-		TEST_list = saved_in_progress_list;
-		TEST_list_count = &saved_in_progress_list_count;
-	}
-	else // i.e., "if (list == TEST_IN_PROGRESS_LIST2)"
-	{
-		TEST_list = saved_in_progress_list2;
-		TEST_list_count = &saved_in_progress_list_count2;
-	}
-
-	int i;
-	int item_found = 0;
-	for (i = 0; i < *TEST_list_count; i++)
-	{
-		if (item_found)
-		{
-			TEST_list[i - 1] = TEST_list[i];
-		}
-		else if (TEST_list[i] == item)
-		{
-			item_found = 1;
-		}
-	}
-
-	if (item_found)
-	{
-		(*TEST_list_count)--;
-	}
-
-	return item_found == 1 ? 0 : 1;
-}
-
-static LIST_ITEM_HANDLE TEST_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FUNCTION match_function, const void* match_context)
-{
-	(void)list;
-	(void)match_function;
-	return (LIST_ITEM_HANDLE)match_context;
-}
-
-static const void* TEST_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
-{
-	return (const void*)item_handle;
-}
-
-static LIST_ITEM_HANDLE TEST_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
-{
-	LIST_ITEM_HANDLE list_item;
-
-	if (list == TEST_WAIT_TO_SEND_LIST1)
-	{
-		if (saved_wait_to_send_list_count <= 0)
-		{
-			list_item = NULL;
-		}
-		else
-		{
-			list_item = (LIST_ITEM_HANDLE)saved_wait_to_send_list[0];
-		}
-	}
-	else if (list == TEST_WAIT_TO_SEND_LIST2)
-	{
-		if (saved_wait_to_send_list_count2 <= 0)
-		{
-			list_item = NULL;
-		}
-		else
-		{
-			list_item = (LIST_ITEM_HANDLE)saved_wait_to_send_list2[0];
-		}
-	}
-	else if (list == TEST_IN_PROGRESS_LIST1)
-	{
-		if (saved_in_progress_list_count <= 0)
-		{
-			list_item = NULL;
-		}
-		else
-		{
-			list_item = (LIST_ITEM_HANDLE)saved_in_progress_list[0];
-		}
-	}
-	else if (list == TEST_IN_PROGRESS_LIST2)
-	{
-		if (saved_in_progress_list_count2 <= 0)
-		{
-			list_item = NULL;
-		}
-		else
-		{
-			list_item = (LIST_ITEM_HANDLE)saved_in_progress_list2[0];
-		}
-	}
-	else
-	{
-		list_item = NULL;
-	}
-
-	return list_item;
-}
-
-static LIST_ITEM_HANDLE TEST_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle)
-{
-	LIST_ITEM_HANDLE next_item = NULL;
-
-	int i;
-	int item_found = 0;
-	for (i = 0; i < saved_in_progress_list_count; i++)
-	{
-		if (item_found)
-		{
-			next_item = (LIST_ITEM_HANDLE)saved_in_progress_list[i];
-			break;
-		}
-		else if (saved_in_progress_list[i] == (void*)item_handle)
-		{
-			item_found = 1;
-		}
-	}
-
-	if (item_found == 0)
-	{
-		for (i = 0; i < saved_in_progress_list_count2; i++)
-		{
-			if (item_found)
-			{
-				next_item = (LIST_ITEM_HANDLE)saved_in_progress_list2[i];
-				break;
-			}
-			else if (saved_in_progress_list2[i] == (void*)item_handle)
-			{
-				item_found = 1;
-			}
-		}
-	}
-
-	if (item_found == 0)
-	{
-		for (i = 0; i < saved_wait_to_send_list_count2; i++)
-		{
-			if (item_found)
-			{
-				next_item = (LIST_ITEM_HANDLE)saved_wait_to_send_list2[i];
-				break;
-			}
-			else if (saved_wait_to_send_list2[i] == (void*)item_handle)
-			{
-				item_found = 1;
-			}
-		}
-	}
-
-	if (item_found == 0)
-	{
-		for (i = 0; i < saved_wait_to_send_list_count; i++)
-		{
-			if (item_found)
-			{
-				next_item = (LIST_ITEM_HANDLE)saved_wait_to_send_list[i];
-				break;
-			}
-			else if (saved_wait_to_send_list[i] == (void*)item_handle)
-			{
-				item_found = 1;
-			}
-		}
-	}
+    if (saved_messagesender_send_callback_contexts_count < TEST_MANY_IN_PROGRESS_EVENTS)
+    {
+        saved_messagesender_send_callback_contexts[saved_messagesender_send_callback_contexts_count++] = callback_context;
+    }
 
-	return next_item;
+    return TEST_messagesender_send_result;
 }
 
 
@@ -624,8 +417,6 @@ static void set_expected_calls_for_messenger_create(MESSENGER_CONFIG* config)
     // memset() - not mocked.
     STRICT_EXPECTED_CALL(STRING_construct(config->device_id)).SetReturn(TEST_DEVICE_ID_STRING_HANDLE);
     STRICT_EXPECTED_CALL(STRING_construct(config->iothub_host_fqdn)).SetReturn(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE);
-	STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(TEST_WAIT_TO_SEND_LIST);
-	STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(TEST_IN_PROGRESS_LIST);
 }
 
 static void set_expected_calls_for_attach_device_client_type_to_link(LINK_HANDLE link_handle, int amqpvalue_set_map_value_result, int link_set_attach_properties_result)
@@ -714,14 +505,15 @@ static void set_expected_calls_for_message_receiver_destroy()
 static void set_expected_calls_for_messenger_send_async()
 {
 	EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-	EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG));
 }
 
 static IOTHUB_MESSAGE_LIST* TEST_on_event_send_complete_message;
 static MESSENGER_EVENT_SEND_COMPLETE_RESULT TEST_on_event_send_complete_result;
 static void* TEST_on_event_send_complete_context;
+static int TEST_on_event_send_complete_count;
 static void TEST_on_event_send_complete(IOTHUB_MESSAGE_LIST* message, MESSENGER_EVENT_SEND_COMPLETE_RESULT result, void* context)
 {
+	TEST_on_event_send_complete_count++;
 	TEST_on_event_send_complete_message = message;
 	TEST_on_event_send_complete_result = result;
 	TEST_on_event_send_complete_context = context;
@@ -811,7 +603,7 @@ static void set_expected_calls_for_message_sender_destroy()
 	STRICT_EXPECTED_CALL(link_destroy(TEST_EVENT_SENDER_LINK_HANDLE));
 }
 
-static void set_expected_calls_for_messenger_stop(int wait_to_send_list_length, int in_progress_list_length, bool destroy_message_receiver)
+static void set_expected_calls_for_messenger_stop(bool destroy_message_receiver)
 {
 	set_expected_calls_for_message_sender_destroy();
 
@@ -820,80 +612,7 @@ static void set_expected_calls_for_messenger_stop(int wait_to_send_list_length,
 		set_expected_calls_for_message_receiver_destroy();
 	}
 
-	// remove timed out events
-	if (in_progress_list_length <= 0)
-	{
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-	}
-	else
-	{
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
-
-		int i;
-		for (i = 0; i < in_progress_list_length; i++)
-		{
-			EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-			// por fazer: adicionar codigo para remover items prescritos.
-
-			if (i < (in_progress_list_length - 1))
-			{
-				EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-			}
-			else
-			{
-				EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG)).SetReturn(NULL);
-			}
-		}
-	}
-
-	// Move events to wts list
-	if (in_progress_list_length <= 0)
-	{
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-	}
-	else
-	{
-		SINGLYLINKEDLIST_HANDLE new_wts_list = (TEST_WAIT_TO_SEND_LIST == TEST_WAIT_TO_SEND_LIST1 ? TEST_WAIT_TO_SEND_LIST2 : TEST_WAIT_TO_SEND_LIST1);
-		SINGLYLINKEDLIST_HANDLE new_ip_list = (TEST_IN_PROGRESS_LIST == TEST_IN_PROGRESS_LIST1 ? TEST_IN_PROGRESS_LIST2 : TEST_IN_PROGRESS_LIST1);
-
-		// rest of function
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
-		STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(new_wts_list);
-
-		// Moving in_progress_list items to the new wts list.
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
-		int i;
-		for (i = 0; i < in_progress_list_length; i++)
-		{
-			EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-			EXPECTED_CALL(singlylinkedlist_add(new_wts_list, IGNORED_PTR_ARG));
-			EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-		}
-
-		// Moving wts (wait to send) list items to the new wts list.
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
-		for (i = 0; i < wait_to_send_list_length; i++)
-		{
-			EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-			EXPECTED_CALL(singlylinkedlist_add(new_wts_list, IGNORED_PTR_ARG));
-			EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-		}
-
-		STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(new_ip_list);
-		STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_WAIT_TO_SEND_LIST));
-		STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_IN_PROGRESS_LIST));
-		TEST_WAIT_TO_SEND_LIST = new_wts_list;
-		TEST_IN_PROGRESS_LIST = new_ip_list;
-	}
-}
-
-static void set_expected_calls_for_on_message_send_complete()
-{
-	STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-		.IgnoreArgument_match_context()
-		.IgnoreArgument_match_function();
-	STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG)).IgnoreArgument_item_handle();
-	EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	// Removing timed out events and moving in-progress events back to the wait_to_send list do not allocate memory.
 }
 
 static void set_expected_calls_for_message_do_work_send_pending_events(int number_of_events_pending, time_t current_time)
@@ -901,11 +620,6 @@ static void set_expected_calls_for_message_do_work_send_pending_events(int numbe
 	int i;
 	for (i = 0; i < number_of_events_pending; i++)
     {
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
-		EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-		STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_WAIT_TO_SEND_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
-		STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
-
         STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
             .IgnoreArgument(2);
 
@@ -915,8 +629,38 @@ static void set_expected_calls_for_message_do_work_send_pending_events(int numbe
 
         EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
     }
+}
+
+static void set_expected_calls_for_send_batch(int number_of_events, time_t current_time)
+{
+	int i;
 
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
+	STRICT_EXPECTED_CALL(message_create()).SetReturn(TEST_BATCH_MESSAGE_HANDLE);
+	STRICT_EXPECTED_CALL(message_set_message_format(TEST_BATCH_MESSAGE_HANDLE, TEST_AMQP_BATCHING_FORMAT_CODE));
+
+	for (i = 0; i < number_of_events; i++)
+	{
+		STRICT_EXPECTED_CALL(message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+			.IgnoreArgument(2);
+		STRICT_EXPECTED_CALL(message_add_body_amqp_data(TEST_BATCH_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+			.IgnoreArgument(2);
+		EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	}
+
+	STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER_HANDLE, TEST_BATCH_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(3).IgnoreArgument(4);
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+	STRICT_EXPECTED_CALL(message_destroy(TEST_BATCH_MESSAGE_HANDLE));
+}
+
+static MESSENGER_HANDLE create_and_start_batching_messenger(MESSENGER_CONFIG* config)
+{
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+	bool batching = true;
+
+	ASSERT_ARE_EQUAL(int, 0, messenger_set_option(handle, MESSENGER_OPTION_BATCHING, &batching));
+
+	return handle;
 }
 
 static time_t add_seconds(time_t base_time, int seconds)
@@ -939,25 +683,12 @@ static time_t add_seconds(time_t base_time, int seconds)
 
 static void set_expected_calls_for_process_event_send_timeouts(size_t in_progress_list_length, size_t send_event_timeout_secs, time_t current_time)
 {
-	if (in_progress_list_length <= 0)
-	{
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-	}
-	else
-	{
-		time_t send_time = add_seconds(current_time, -1 * (int)send_event_timeout_secs);
+	time_t send_time = add_seconds(current_time, -1 * (int)send_event_timeout_secs);
 
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
-		
-		for (; in_progress_list_length > 0; in_progress_list_length--)
-		{
-			EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-			STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
-			EXPECTED_CALL(get_difftime(current_time, send_time)).SetReturn(difftime(current_time, send_time));
-			EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
-		}
-
-		EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG)).SetReturn(NULL);
+	for (; in_progress_list_length > 0; in_progress_list_length--)
+	{
+		STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+		EXPECTED_CALL(get_difftime(current_time, send_time)).SetReturn(difftime(current_time, send_time));
 	}
 }
 
@@ -984,11 +715,11 @@ static void set_expected_calls_for_messenger_do_work(MESSENGER_DO_WORK_EXP_CALL_
 	}
 }
 
-static void set_expected_calls_for_messenger_destroy(MESSENGER_CONFIG* config, MESSENGER_HANDLE messenger_handle, bool destroy_message_sender, bool destroy_message_receiver, int wait_to_send_list_length, int in_progress_list_length)
+static void set_expected_calls_for_messenger_destroy(MESSENGER_CONFIG* config, MESSENGER_HANDLE messenger_handle, bool destroy_message_sender, bool destroy_message_receiver, int wait_to_send_list_length, int in_progress_list_length, int pooled_send_event_tasks)
 {
 	(void)config;
 
-	set_expected_calls_for_messenger_stop(wait_to_send_list_length, in_progress_list_length, destroy_message_receiver);
+	set_expected_calls_for_messenger_stop(destroy_message_receiver);
 
 	time_t current_time = time(NULL);
 
@@ -997,24 +728,21 @@ static void set_expected_calls_for_messenger_destroy(MESSENGER_CONFIG* config, M
 	do_work_profile->destroy_message_receiver = destroy_message_receiver;
 	set_expected_calls_for_messenger_do_work(do_work_profile);
 
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-
 	wait_to_send_list_length += in_progress_list_length; // all events from in_progress_list should have been moved to wts list.
 
 	while (wait_to_send_list_length > 0)
 	{
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST)); 
-		EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-		STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_WAIT_TO_SEND_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
 		EXPECTED_CALL(free(IGNORED_PTR_ARG)); // Freeing the SEND_EVENT_TASK instance.
 
 		wait_to_send_list_length--;
 	}
 
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST)).SetReturn(NULL);
+	while (pooled_send_event_tasks > 0)
+	{
+		EXPECTED_CALL(free(IGNORED_PTR_ARG)); // Freeing the pooled SEND_EVENT_TASK instances.
 
-	STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_WAIT_TO_SEND_LIST));
-	STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_IN_PROGRESS_LIST));
+		pooled_send_event_tasks--;
+	}
 
 	STRICT_EXPECTED_CALL(STRING_delete(TEST_IOTHUB_HOST_FQDN_STRING_HANDLE));
 	STRICT_EXPECTED_CALL(STRING_delete(TEST_DEVICE_ID_STRING_HANDLE));
@@ -1185,9 +913,6 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(ON_MESSAGE_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_MESSAGE_RECEIVER_STATE_CHANGED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(receiver_settle_mode, int);
-	REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
-	REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
-	REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(MESSENGER_SEND_STATUS, int);
 	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_RESULT, int);
@@ -1197,6 +922,19 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_UMOCK_ALIAS_TYPE(time_t, int);
 	REGISTER_UMOCK_ALIAS_TYPE(delivery_number, int);
 	REGISTER_UMOCK_ALIAS_TYPE(MESSENGER_MESSAGE_DISPOSITION_INFO, void*);
+	REGISTER_UMOCK_ALIAS_TYPE(BINARY_DATA, void*);
+
+	REGISTER_GLOBAL_MOCK_HOOK(message_create_uamqp_encoding_from_iothub_message, TEST_message_create_uamqp_encoding_from_iothub_message);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_create_uamqp_encoding_from_iothub_message, 1);
+
+	REGISTER_GLOBAL_MOCK_RETURN(message_create, TEST_BATCH_MESSAGE_HANDLE);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_create, NULL);
+
+	REGISTER_GLOBAL_MOCK_RETURN(message_set_message_format, 0);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_set_message_format, 1);
+
+	REGISTER_GLOBAL_MOCK_RETURN(message_add_body_amqp_data, 0);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_add_body_amqp_data, 1);
 
     REGISTER_GLOBAL_MOCK_HOOK(malloc, TEST_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(free, TEST_free);
@@ -1206,20 +944,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_open, TEST_messagereceiver_open);
     REGISTER_GLOBAL_MOCK_HOOK(message_create_from_iothub_message, TEST_message_create_from_iothub_message);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_CreateFromUamqpMessage, TEST_IoTHubMessage_CreateFromUamqpMessage);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, TEST_singlylinkedlist_add);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, TEST_singlylinkedlist_get_head_item);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, TEST_singlylinkedlist_remove);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, TEST_singlylinkedlist_item_get_value);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, TEST_singlylinkedlist_get_next_item);
-	REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, TEST_singlylinkedlist_find);
 	REGISTER_GLOBAL_MOCK_HOOK(messagereceiver_get_link_name, TEST_messagereceiver_get_link_name);
 
-	REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_remove, 0);
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_remove, 555);
-
-	REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_add, TEST_LIST_ITEM_HANDLE);
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_add, NULL);
-
     REGISTER_GLOBAL_MOCK_RETURN(STRING_construct, TEST_STRING_HANDLE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_construct, NULL);
 
@@ -1330,15 +1056,6 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 
     saved_malloc_returns_count = 0;
 
-	TEST_WAIT_TO_SEND_LIST = TEST_WAIT_TO_SEND_LIST1;
-	TEST_IN_PROGRESS_LIST = TEST_IN_PROGRESS_LIST1;
-
-	TEST_singlylinkedlist_add_fail_return = false;
-	saved_wait_to_send_list_count = 0;
-	saved_wait_to_send_list_count2 = 0;
-	saved_in_progress_list_count = 0;
-	saved_in_progress_list_count2 = 0;
-	
     saved_messagesender_create_link = NULL;
     saved_messagesender_create_on_message_sender_state_changed = NULL;
     saved_messagesender_create_context = NULL;
@@ -1355,6 +1072,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     saved_messagesender_send_message = NULL;
     saved_messagesender_send_on_message_send_complete = NULL;
     saved_messagesender_send_callback_context = NULL;
+    saved_messagesender_send_callback_contexts_count = 0;
 
     saved_messagereceiver_create_link = NULL;
     saved_messagereceiver_create_on_message_receiver_state_changed = NULL;
@@ -1377,6 +1095,8 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 	TEST_on_event_send_complete_message = NULL;
 	TEST_on_event_send_complete_result = MESSENGER_EVENT_SEND_COMPLETE_RESULT_OK;
 	TEST_on_event_send_complete_context = NULL;
+	TEST_on_event_send_complete_count = 0;
+	TEST_encoded_event_size = TEST_ENCODED_EVENT_SIZE;
 
 	TEST_DELIVERY_NUMBER = (delivery_number)1234;
 	TEST_messagereceiver_get_link_name_link_name = TEST_MESSAGE_RECEIVER_LINK_NAME_CHAR_PTR;
@@ -1444,8 +1164,7 @@ TEST_FUNCTION(messenger_create_config_NULL_iothub_host_fqdn)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_006: [messenger_create() shall allocate memory for the messenger instance structure (aka `instance`)]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_008: [messenger_create() shall save a copy of `messenger_config->device_id` into `instance->device_id`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_010: [messenger_create() shall save a copy of `messenger_config->iothub_host_fqdn` into `instance->iothub_host_fqdn`]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_165: [`instance->wait_to_send_list` shall be set using singlylinkedlist_create()]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_132: [`instance->in_progress_list` shall be set using singlylinkedlist_create()]   
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_165: [`instance->wait_to_send_list`, `instance->in_progress_list` and the instance task pool shall be initialized as empty lists]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_013: [`messenger_config->on_state_changed_callback` shall be saved into `instance->on_state_changed_callback`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_014: [`messenger_config->on_state_changed_context` shall be saved into `instance->on_state_changed_context`]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_015: [If no failures occurr, messenger_create() shall return a handle to `instance`]
@@ -1471,8 +1190,6 @@ TEST_FUNCTION(messenger_create_success)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_007: [If malloc() fails, messenger_create() shall fail and return NULL]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_009: [If STRING_construct() fails, messenger_create() shall fail and return NULL]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_011: [If STRING_construct() fails, messenger_create() shall fail and return NULL] 
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_166: [If singlylinkedlist_create() fails, messenger_create() shall fail and return NULL]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_133: [If singlylinkedlist_create() fails, messenger_create() shall fail and return NULL]
 TEST_FUNCTION(messenger_create_failure_checks)
 {
     // arrange
@@ -1488,12 +1205,6 @@ TEST_FUNCTION(messenger_create_failure_checks)
     size_t i;
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
-        if (i == 3)
-        {
-            // These expected calls do not cause the API to fail.
-            continue;
-        }
-
         // arrange
         char error_msg[64];
 
@@ -1691,7 +1402,7 @@ TEST_FUNCTION(messenger_stop_succeeds)
     MESSENGER_HANDLE handle = create_and_start_messenger2(config, true);
 
     umock_c_reset_all_calls();
-    set_expected_calls_for_messenger_stop(0, 0, true);
+    set_expected_calls_for_messenger_stop(true);
 
     // act
     int result = messenger_stop(handle);
@@ -1726,10 +1437,10 @@ TEST_FUNCTION(messenger_destroy_NULL_handle)
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_063: [`instance->sender_link` shall be destroyed using link_destroy()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_064: [`instance->receiver_link` shall be destroyed using link_destroy()] 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_162: [If `instance->state` is MESSENGER_STATE_STOPPING, messenger_do_work() shall move all items from `instance->in_progress_list` to the beginning of `instance->wait_to_send_list`]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_164: [If all items get successfuly moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_STOPPED, and `instance->on_state_changed_callback` invoked]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_164: [Once all items are moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_STOPPED, and `instance->on_state_changed_callback` invoked]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_110: [If the `instance->state` is not MESSENGER_STATE_STOPPED, messenger_destroy() shall invoke messenger_stop() and messenger_do_work() once]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_111: [All elements of `instance->in_progress_list` and `instance->wait_to_send_list` shall be removed, invoking `task->on_event_send_complete_callback` for each with MESSENGER_EVENT_SEND_COMPLETE_RESULT_MESSENGER_DESTROYED]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_150: [`instance->in_progress_list` and `instance->wait_to_send_list` shall be destroyed using singlylinkedlist_destroy()]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_150: [All MESSENGER_SEND_EVENT_TASK structures in the instance task pool shall be destroyed using free()]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_112: [`instance->iothub_host_fqdn` shall be destroyed using STRING_delete()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_113: [`instance->device_id` shall be destroyed using STRING_delete()]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_114: [messenger_destroy() shall destroy `instance` with free()] 
@@ -1748,7 +1459,7 @@ TEST_FUNCTION(messenger_destroy_succeeds)
 	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
     umock_c_reset_all_calls();
-    set_expected_calls_for_messenger_destroy(config, handle, true, true, 1, 1);
+    set_expected_calls_for_messenger_destroy(config, handle, true, true, 1, 1, 0);
 
     // act
     messenger_destroy(handle);
@@ -1759,37 +1470,6 @@ TEST_FUNCTION(messenger_destroy_succeeds)
     // cleanup
 }
 
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_163: [If not all items from `instance->in_progress_list` can be moved back to `instance->wait_to_send_list`, `instance->state` shall be set to MESSENGER_STATE_ERROR, and `instance->on_state_changed_callback` invoked]
-TEST_FUNCTION(messenger_destroy_FAIL_TO_ROLLBACK_EVENTS)
-{
-	// arrange
-	MESSENGER_CONFIG* config = get_messenger_config();
-	MESSENGER_HANDLE handle = create_and_start_messenger2(config, true);
-
-	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
-
-	time_t current_time = time(NULL);
-	MESSENGER_DO_WORK_EXP_CALL_PROFILE* mdecp = get_msgr_do_work_exp_call_profile(MESSENGER_STATE_STARTED, true, true, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
-	crank_messenger_do_work(handle, mdecp);
-
-	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
-
-	umock_c_reset_all_calls();
-	set_expected_calls_for_message_sender_destroy();
-	set_expected_calls_for_message_receiver_destroy();
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST));
-	STRICT_EXPECTED_CALL(singlylinkedlist_create()).SetReturn(NULL);
-
-	// act
-	messenger_destroy(handle);
-
-	// assert
-	ASSERT_ARE_EQUAL(int, MESSENGER_STATE_STOPPING, saved_on_state_changed_callback_previous_state);
-	ASSERT_ARE_EQUAL(int, MESSENGER_STATE_ERROR, saved_on_state_changed_callback_new_state);
-
-	// cleanup
-}
-
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_065: [If `messenger_handle` is NULL, messenger_do_work() shall fail and return]
 TEST_FUNCTION(messenger_do_work_NULL_handle)
 {
@@ -2078,7 +1758,7 @@ TEST_FUNCTION(messenger_do_work_destroy_message_receiver)
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_107: [If no failure occurs, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_OK]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_128: [`task` shall be removed from `instance->in_progress_list`]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be destroyed using free()]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be returned to the instance task pool, or destroyed using free() if the pool is full]
 TEST_FUNCTION(messenger_do_work_on_event_send_complete_OK)
 {
     // arrange
@@ -2092,7 +1772,6 @@ TEST_FUNCTION(messenger_do_work_on_event_send_complete_OK)
 	crank_messenger_do_work(handle, mdwp);
 
 	umock_c_reset_all_calls();
-	set_expected_calls_for_on_message_send_complete();
 
     // act
     ASSERT_IS_NOT_NULL(saved_messagesender_send_on_message_send_complete);
@@ -2111,7 +1790,7 @@ TEST_FUNCTION(messenger_do_work_on_event_send_complete_OK)
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_108: [If a failure occurred, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_128: [`task` shall be removed from `instance->in_progress_list`]  
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be destroyed using free()]  
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be returned to the instance task pool, or destroyed using free() if the pool is full]
 TEST_FUNCTION(messenger_do_work_on_event_send_complete_ERROR)
 {
     // arrange
@@ -2125,7 +1804,6 @@ TEST_FUNCTION(messenger_do_work_on_event_send_complete_ERROR)
 	crank_messenger_do_work(handle, mdwp);
 
     umock_c_reset_all_calls();
-    set_expected_calls_for_on_message_send_complete();
 
     // act
     ASSERT_IS_NOT_NULL(saved_messagesender_send_on_message_send_complete);
@@ -2142,6 +1820,258 @@ TEST_FUNCTION(messenger_do_work_on_event_send_complete_ERROR)
     messenger_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_128: [`task` shall be removed from `instance->in_progress_list`]  
+TEST_FUNCTION(messenger_do_work_on_event_send_complete_out_of_order_with_many_events_in_progress)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+	MESSENGER_SEND_STATUS send_status;
+	int i;
+
+	umock_c_reset_all_calls();
+
+	for (i = 0; i < TEST_MANY_IN_PROGRESS_EVENTS; i++)
+	{
+		ASSERT_ARE_EQUAL(int, 0, messenger_send_async(handle, TEST_IOTHUB_MESSAGE_LIST_HANDLE, TEST_on_event_send_complete, TEST_IOTHUB_CLIENT_HANDLE));
+	}
+
+	messenger_do_work(handle);
+	umock_c_reset_all_calls();
+
+	ASSERT_ARE_EQUAL(int, TEST_MANY_IN_PROGRESS_EVENTS, saved_messagesender_send_callback_contexts_count);
+
+	// act
+	// Completing from the middle outwards, so no completion hits the head of in_progress_list.
+	for (i = 0; i < TEST_MANY_IN_PROGRESS_EVENTS / 2; i++)
+	{
+		saved_messagesender_send_on_message_send_complete(saved_messagesender_send_callback_contexts[TEST_MANY_IN_PROGRESS_EVENTS / 2 + i], MESSAGE_SEND_OK);
+		saved_messagesender_send_on_message_send_complete(saved_messagesender_send_callback_contexts[TEST_MANY_IN_PROGRESS_EVENTS / 2 - i - 1], MESSAGE_SEND_OK);
+	}
+
+	// assert
+	ASSERT_ARE_EQUAL(int, MESSENGER_EVENT_SEND_COMPLETE_RESULT_OK, TEST_on_event_send_complete_result);
+	ASSERT_ARE_EQUAL(int, 0, messenger_get_send_status(handle, &send_status));
+	ASSERT_ARE_EQUAL(int, MESSENGER_SEND_STATUS_IDLE, send_status);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_012: [An event shall time out `task->send_timeout_secs` seconds after it was sent, using the value of `instance->event_send_timeout_secs` at the time it was sent, or never if that value is 0]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_013: [If the new timeout is shorter than the current one and `instance->in_progress_list` is not empty, messenger_do_work() shall check every in-progress event for timeout until they no longer time out out of order]
+TEST_FUNCTION(messenger_do_work_times_out_events_sent_after_the_timeout_is_shortened)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+	time_t current_time = time(NULL);
+	size_t timeout_secs = 10;
+
+	send_events(handle, 1);
+	crank_messenger_do_work(handle, get_msgr_do_work_exp_call_profile(MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS));
+
+	ASSERT_ARE_EQUAL(int, 0, messenger_set_option(handle, MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, &timeout_secs));
+
+	send_events(handle, 1);
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+	EXPECTED_CALL(get_difftime(current_time, current_time)).SetReturn(1);
+	set_expected_calls_for_message_do_work_send_pending_events(1, current_time);
+	messenger_do_work(handle);
+
+	TEST_on_event_send_complete_count = 0;
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+	EXPECTED_CALL(get_difftime(current_time, current_time)).SetReturn(20);
+	STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(current_time);
+	EXPECTED_CALL(get_difftime(current_time, current_time)).SetReturn(20);
+
+	// act
+	messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 1, TEST_on_event_send_complete_count);
+	ASSERT_ARE_EQUAL(int, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_TIMEOUT, TEST_on_event_send_complete_result);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_001: [If batching is enabled, messenger_do_work() shall create a MESSAGE_HANDLE with message_create() and set its format to 0x80013700 with message_set_message_format()]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_002: [Each event shall be encoded with message_create_uamqp_encoding_from_iothub_message() and added to the batch with message_add_body_amqp_data(), until the batch holds `instance->max_events_per_batch` events or adding the next one would exceed `instance->max_batch_size_in_bytes`]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_005: [The batch shall be submitted with messagesender_send(), passing `internal_on_event_send_complete_callback` and the first event of the batch as context]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_007: [The batch MESSAGE_HANDLE shall be destroyed using message_destroy()]
+TEST_FUNCTION(messenger_do_work_send_events_batched_success)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+
+	ASSERT_ARE_EQUAL(int, 3, send_events(handle, 3));
+
+	time_t current_time = time(NULL);
+	MESSENGER_DO_WORK_EXP_CALL_PROFILE *do_work_profile = get_msgr_do_work_exp_call_profile(MESSENGER_STATE_STARTED, false, false, 0, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+
+	umock_c_reset_all_calls();
+	set_expected_calls_for_messenger_do_work(do_work_profile);
+	set_expected_calls_for_send_batch(3, current_time);
+
+	// act
+	messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 1, saved_messagesender_send_callback_contexts_count);
+	ASSERT_ARE_EQUAL(int, 0, TEST_on_event_send_complete_count);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_002: [Each event shall be encoded with message_create_uamqp_encoding_from_iothub_message() and added to the batch with message_add_body_amqp_data(), until the batch holds `instance->max_events_per_batch` events or adding the next one would exceed `instance->max_batch_size_in_bytes`]
+TEST_FUNCTION(messenger_do_work_send_events_batched_splits_at_byte_budget)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+
+	ASSERT_ARE_EQUAL(int, 3, send_events(handle, 3));
+	TEST_encoded_event_size = 100 * 1024;
+
+	umock_c_reset_all_calls();
+
+	// act
+	messenger_do_work(handle);
+
+	// assert
+	// Two 100KB events fit in 255KB, the third one goes in a second batch.
+	ASSERT_ARE_EQUAL(int, 2, saved_messagesender_send_callback_contexts_count);
+	ASSERT_ARE_EQUAL(int, 0, TEST_on_event_send_complete_count);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_002: [Each event shall be encoded with message_create_uamqp_encoding_from_iothub_message() and added to the batch with message_add_body_amqp_data(), until the batch holds `instance->max_events_per_batch` events or adding the next one would exceed `instance->max_batch_size_in_bytes`]
+TEST_FUNCTION(messenger_do_work_send_events_batched_honors_the_batch_limit_options)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+	size_t max_events_per_batch = 2;
+	size_t max_batch_size_in_bytes = 150 * 1024;
+
+	ASSERT_ARE_EQUAL(int, 0, messenger_set_option(handle, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, &max_events_per_batch));
+	ASSERT_ARE_EQUAL(int, 5, send_events(handle, 5));
+
+	umock_c_reset_all_calls();
+
+	// act
+	messenger_do_work(handle);
+	ASSERT_ARE_EQUAL(int, 3, saved_messagesender_send_callback_contexts_count);
+
+	ASSERT_ARE_EQUAL(int, 0, messenger_set_option(handle, MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, &max_batch_size_in_bytes));
+	ASSERT_ARE_EQUAL(int, 2, send_events(handle, 2));
+	TEST_encoded_event_size = 100 * 1024;
+	messenger_do_work(handle);
+
+	// assert
+	// 5 events at 2 per batch make 3 batches; two 100KB events do not fit together in 150KB.
+	ASSERT_ARE_EQUAL(int, 5, saved_messagesender_send_callback_contexts_count);
+	ASSERT_ARE_EQUAL(int, 0, TEST_on_event_send_complete_count);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_004: [If `task` leads a batch, the completion shall be applied to every event of the batch, in the order they were added to it]
+TEST_FUNCTION(messenger_do_work_on_batch_send_complete_completes_every_event)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+	MESSENGER_SEND_STATUS send_status;
+
+	ASSERT_ARE_EQUAL(int, 3, send_events(handle, 3));
+	messenger_do_work(handle);
+	ASSERT_ARE_EQUAL(int, 1, saved_messagesender_send_callback_contexts_count);
+
+	umock_c_reset_all_calls();
+
+	// act
+	saved_messagesender_send_on_message_send_complete(saved_messagesender_send_callback_context, MESSAGE_SEND_OK);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 3, TEST_on_event_send_complete_count);
+	ASSERT_ARE_EQUAL(int, MESSENGER_EVENT_SEND_COMPLETE_RESULT_OK, TEST_on_event_send_complete_result);
+	ASSERT_ARE_EQUAL(int, 0, messenger_get_send_status(handle, &send_status));
+	ASSERT_ARE_EQUAL(int, MESSENGER_SEND_STATUS_IDLE, send_status);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_003: [If an event cannot be encoded or added to the batch, its `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, and it shall be destroyed]
+TEST_FUNCTION(messenger_do_work_send_events_batched_encoding_fails)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+
+	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(message_create());
+	STRICT_EXPECTED_CALL(message_set_message_format(TEST_BATCH_MESSAGE_HANDLE, TEST_AMQP_BATCHING_FORMAT_CODE));
+	STRICT_EXPECTED_CALL(message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).SetReturn(1);
+	STRICT_EXPECTED_CALL(message_destroy(TEST_BATCH_MESSAGE_HANDLE));
+
+	// act
+	messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, saved_messagesender_send_callback_contexts_count);
+	ASSERT_ARE_EQUAL(int, 1, TEST_on_event_send_complete_count);
+	ASSERT_ARE_EQUAL(int, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE, TEST_on_event_send_complete_result);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_006: [If messagesender_send() fails, every event of the batch shall be completed with result EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING and destroyed, and messenger_do_work() shall stop sending]
+TEST_FUNCTION(messenger_do_work_send_events_batched_messagesender_send_fails)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_batching_messenger(config);
+	MESSENGER_SEND_STATUS send_status;
+
+	ASSERT_ARE_EQUAL(int, 3, send_events(handle, 3));
+	TEST_messagesender_send_result = 1;
+
+	umock_c_reset_all_calls();
+
+	// act
+	messenger_do_work(handle);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 1, saved_messagesender_send_callback_contexts_count);
+	ASSERT_ARE_EQUAL(int, 3, TEST_on_event_send_complete_count);
+	ASSERT_ARE_EQUAL(int, MESSENGER_EVENT_SEND_COMPLETE_RESULT_ERROR_FAIL_SENDING, TEST_on_event_send_complete_result);
+	ASSERT_ARE_EQUAL(int, 0, messenger_get_send_status(handle, &send_status));
+	ASSERT_ARE_EQUAL(int, MESSENGER_SEND_STATUS_IDLE, send_status);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_155: [If message_create_from_iothub_message() fails, `task->on_event_send_complete_callback` shall be invoked with result EVENT_SEND_COMPLETE_RESULT_ERROR_CANNOT_PARSE]  
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_156: [If message_create_from_iothub_message() fails, messenger_do_work() shall skip to the next event to be sent]
 TEST_FUNCTION(messenger_do_work_send_events_message_create_from_iothub_message_fails)
@@ -2153,22 +2083,8 @@ TEST_FUNCTION(messenger_do_work_send_events_message_create_from_iothub_message_f
 	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
 	umock_c_reset_all_calls();
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
-	EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-	STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_WAIT_TO_SEND_LIST, IGNORED_PTR_ARG))
-		.IgnoreArgument(2);
-	STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG))
-		.IgnoreArgument(2);
 	STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
 		.IgnoreArgument(2).SetReturn(1);
-	STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-		.IgnoreArgument_match_context()
-		.IgnoreArgument_match_function();
-	STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG))
-		.IgnoreArgument(2);
-	EXPECTED_CALL(free(IGNORED_PTR_ARG));
-	STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST)).SetReturn(NULL);
 
     // act
     messenger_do_work(handle);
@@ -2201,27 +2117,13 @@ TEST_FUNCTION(messenger_do_work_send_events_messagesender_send_fails)
 		ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
 
 		umock_c_reset_all_calls();
-		// timeout checks
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_IN_PROGRESS_LIST)).SetReturn(NULL);
-		
 		// send events
-		STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_WAIT_TO_SEND_LIST));
-		EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-		STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_WAIT_TO_SEND_LIST, IGNORED_PTR_ARG))
-			.IgnoreArgument(2);
-		STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG))
-			.IgnoreArgument(2);
 		STRICT_EXPECTED_CALL(message_create_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
 			.IgnoreArgument(2);
 		STRICT_EXPECTED_CALL(messagesender_send(TEST_MESSAGE_SENDER_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
 			.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4).SetReturn(1);
 		EXPECTED_CALL(get_time(NULL)).SetReturn(INDEFINITE_TIME);
 		EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
-		STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-			.IgnoreArgument_match_function()
-			.IgnoreArgument_match_context();
-		STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_IN_PROGRESS_LIST, IGNORED_PTR_ARG)).IgnoreArgument(2);
-		EXPECTED_CALL(free(IGNORED_PTR_ARG));
 
         // act
         messenger_do_work(handle);
@@ -2543,8 +2445,6 @@ TEST_FUNCTION(messenger_send_async_NULL_callback)
 }
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_138: [If malloc() fails, messenger_send_async() shall fail and return a non-zero value]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_139: [If singlylinkedlist_add() fails, messenger_send_async() shall fail and return a non-zero value]
-// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_142: [If any failure occurs, messenger_send_async() shall free any memory it has allocated]
 TEST_FUNCTION(messenger_send_async_failure_checks)
 {
 	// arrange
@@ -2580,6 +2480,36 @@ TEST_FUNCTION(messenger_send_async_failure_checks)
 	messenger_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_137: [messenger_send_async() shall take a MESSENGER_SEND_EVENT_TASK structure (aka `task`) from the instance task pool, or allocate memory for one if the pool is empty]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_130: [`task` shall be returned to the instance task pool, or destroyed using free() if the pool is full]
+TEST_FUNCTION(messenger_send_async_reuses_pooled_task)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	ASSERT_ARE_EQUAL(int, 1, send_events(handle, 1));
+
+	time_t current_time = time(NULL);
+	MESSENGER_DO_WORK_EXP_CALL_PROFILE *mdwp = get_msgr_do_work_exp_call_profile(MESSENGER_STATE_STARTED, false, false, 1, 0, current_time, DEFAULT_EVENT_SEND_TIMEOUT_SECS);
+	crank_messenger_do_work(handle, mdwp);
+
+	ASSERT_IS_NOT_NULL(saved_messagesender_send_on_message_send_complete);
+	saved_messagesender_send_on_message_send_complete(saved_messagesender_send_callback_context, MESSAGE_SEND_OK);
+
+	umock_c_reset_all_calls();
+
+	// act
+	int result = messenger_send_async(handle, TEST_IOTHUB_MESSAGE_LIST_HANDLE, TEST_on_event_send_complete, TEST_IOTHUB_CLIENT_HANDLE);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_144: [If `messenger_handle` is NULL, messenger_get_send_status() shall fail and return a non-zero value] 
 TEST_FUNCTION(messenger_get_send_status_NULL_handle)
 {
@@ -2734,6 +2664,84 @@ TEST_FUNCTION(messenger_set_option_EVENT_SEND_TIMEOUT_SECS)
 	messenger_destroy(handle);
 }
 
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_008: [If name matches MESSENGER_OPTION_BATCHING, `value` shall be saved on `instance->is_batching_enabled`]
+TEST_FUNCTION(messenger_set_option_BATCHING)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	bool value = true;
+
+	// act
+	int result = messenger_set_option(handle, MESSENGER_OPTION_BATCHING, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_009: [If name matches MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, `value` shall be saved on `instance->max_events_per_batch` or `instance->max_batch_size_in_bytes`]
+TEST_FUNCTION(messenger_set_option_MAX_EVENTS_PER_BATCH)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	size_t value = 10;
+
+	// act
+	int result = messenger_set_option(handle, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_009: [If name matches MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, `value` shall be saved on `instance->max_events_per_batch` or `instance->max_batch_size_in_bytes`]
+TEST_FUNCTION(messenger_set_option_MAX_BATCH_SIZE_IN_BYTES)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	size_t value = 64 * 1024;
+
+	// act
+	int result = messenger_set_option(handle, MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, &value);
+
+	// assert
+	ASSERT_ARE_EQUAL(int, 0, result);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_010: [If the value of MESSENGER_OPTION_MAX_EVENTS_PER_BATCH or MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES is 0, messenger_set_option shall fail and return a non-zero value]
+TEST_FUNCTION(messenger_set_option_batch_limits_of_0_fail)
+{
+	// arrange
+	MESSENGER_CONFIG* config = get_messenger_config();
+	MESSENGER_HANDLE handle = create_and_start_messenger2(config, false);
+
+	size_t value = 0;
+
+	// act
+	int result1 = messenger_set_option(handle, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, &value);
+	int result2 = messenger_set_option(handle, MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, &value);
+
+	// assert
+	ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+	ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+
+	// cleanup
+	messenger_destroy(handle);
+}
+
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_169: [If name matches MESSENGER_OPTION_SAVED_OPTIONS, `value` shall be applied using OptionHandler_FeedOptions]
 TEST_FUNCTION(messenger_set_option_SAVED_OPTIONS)
 {
@@ -2983,6 +2991,12 @@ static void set_expected_calls_for_messenger_retrieve_options()
 
 	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, IGNORED_PTR_ARG))
 		.IgnoreArgument(3);
+	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, MESSENGER_OPTION_BATCHING, IGNORED_PTR_ARG))
+		.IgnoreArgument(3);
+	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH, IGNORED_PTR_ARG))
+		.IgnoreArgument(3);
+	STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES, IGNORED_PTR_ARG))
+		.IgnoreArgument(3);
 }
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_173: [If `messenger_handle` is NULL, messenger_retrieve_options shall fail and return NULL]
@@ -3002,6 +3016,7 @@ TEST_FUNCTION(messenger_retrieve_options_NULL_handle)
 }
 
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_174: [An OPTIONHANDLER_HANDLE instance shall be created using OptionHandler_Create]
+// Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_01_011: [The options saved shall be MESSENGER_OPTION_EVENT_SEND_TIMEOUT_SECS, MESSENGER_OPTION_BATCHING, MESSENGER_OPTION_MAX_EVENTS_PER_BATCH and MESSENGER_OPTION_MAX_BATCH_SIZE_IN_BYTES]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_176: [Each option of `instance` shall be added to the OPTIONHANDLER_HANDLE instance using OptionHandler_AddOption]
 // Tests_SRS_IOTHUBTRANSPORT_AMQP_MESSENGER_09_179: [If no failures occur, messenger_retrieve_options shall return the OPTIONHANDLER_HANDLE instance]
 TEST_FUNCTION(messenger_retrieve_options_succeeds)
@@ -12,6 +12,7 @@
 #include "iothubtransport.h"
 
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
 #include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/vector.h"
 
@@ -60,6 +61,8 @@ static bool checkProtocolGatewayIsNull;
 static size_t howManyDoWorkCalls = 0;
 static size_t doWorkCallCount = 0;
 extern "C" const size_t IoTHubTransport_ThreadTerminationOffset;
+extern "C" const size_t IoTHubTransport_PoolWorkerTerminationOffset;
+static size_t threadTerminationOffset;
 static THREAD_START_FUNC threadFunc;
 static void* threadFuncArg;
 
@@ -72,6 +75,7 @@ static void* threadFuncArg;
 #define TEST_IOTHUB_CLIENT_HANDLE2 (IOTHUB_CLIENT_HANDLE)0xDEAF
 #define TEST_LOCK_HANDLE (LOCK_HANDLE)0x4443
 #define TEST_THREAD_HANDLE (THREAD_HANDLE)0x4442
+#define TEST_COND_HANDLE (COND_HANDLE)0x4444
 
 
 
@@ -363,7 +367,7 @@ public:
     MOCK_STATIC_METHOD_1(, void, ThreadAPI_Sleep, unsigned int, milliseconds)
         if ((howManyDoWorkCalls > 0) && (howManyDoWorkCalls == doWorkCallCount))
         {
-            * (sig_atomic_t*)(((char*)threadFuncArg) + IoTHubTransport_ThreadTerminationOffset) = 1; /*tell the thread to stop*/
+            * (sig_atomic_t*)(((char*)threadFuncArg) + threadTerminationOffset) = 1; /*tell the thread to stop*/
         }
     MOCK_VOID_METHOD_END();
 
@@ -377,6 +381,20 @@ public:
     MOCK_STATIC_METHOD_1(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
     MOCK_METHOD_END(LOCK_RESULT, LOCK_OK);
 
+    /* Condition mocks */
+    MOCK_STATIC_METHOD_0(, COND_HANDLE, Condition_Init);
+    MOCK_METHOD_END(COND_HANDLE, TEST_COND_HANDLE);
+    MOCK_STATIC_METHOD_1(, COND_RESULT, Condition_Post, COND_HANDLE, handle);
+    MOCK_METHOD_END(COND_RESULT, COND_OK);
+    MOCK_STATIC_METHOD_3(, COND_RESULT, Condition_Wait, COND_HANDLE, handle, LOCK_HANDLE, lock, int, timeout_milliseconds)
+        if ((howManyDoWorkCalls > 0) && (howManyDoWorkCalls == doWorkCallCount))
+        {
+            * (sig_atomic_t*)(((char*)threadFuncArg) + threadTerminationOffset) = 1; /*tell the thread to stop*/
+        }
+    MOCK_METHOD_END(COND_RESULT, COND_TIMEOUT);
+    MOCK_STATIC_METHOD_1(, void, Condition_Deinit, COND_HANDLE, handle);
+    MOCK_VOID_METHOD_END();
+
 };
 
 DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , void, DList_InitializeListHead, PDLIST_ENTRY, listHead);
@@ -449,6 +467,11 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , LOCK_RESULT, Lock, LOCK_HA
 DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , LOCK_RESULT, Unlock, LOCK_HANDLE, handle);
 DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
 
+DECLARE_GLOBAL_MOCK_METHOD_0(CIotHubTransportMocks, , COND_HANDLE, Condition_Init);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , COND_RESULT, Condition_Post, COND_HANDLE, handle);
+DECLARE_GLOBAL_MOCK_METHOD_3(CIotHubTransportMocks, , COND_RESULT, Condition_Wait, COND_HANDLE, handle, LOCK_HANDLE, lock, int, timeout_milliseconds);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIotHubTransportMocks, , void, Condition_Deinit, COND_HANDLE, handle);
+
 static TRANSPORT_PROVIDER FAKE_transport_provider =
 {
     FAKE_IoTHubTransport_SendMessageDisposition,
@@ -504,6 +527,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     checkProtocolGatewayIsNull = false;
     howManyDoWorkCalls = 0;
     doWorkCallCount = 0;
+    threadTerminationOffset = IoTHubTransport_ThreadTerminationOffset;
 
 }
 
@@ -738,11 +762,13 @@ TEST_FUNCTION(IoTHubTransport_Destroy_success_thread_join_fails)
 
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments()
         .SetFailReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(mocks, Condition_Deinit(TEST_COND_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Lock_Deinit(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_Destroy(IGNORED_PTR_ARG))
@@ -882,6 +908,7 @@ TEST_FUNCTION(IoTHubTransport_GetLLTransport_fail)
 }
 
 //Tests_SRS_IOTHUBTRANSPORT_17_018: [ If the worker thread does not exist, IoTHubTransport_StartWorkerThread shall start the thread using ThreadAPI_Create. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_025: [ Before starting the worker thread a condition shall be created by calling Condition_Init. The worker thread waits on it between calls to lower layer transport DoWork. ]
 //Tests_SRS_IOTHUBTRANSPORT_17_021: [ If handle is not found, then clientHandle shall be added to the list. ]
 //Tests_SRS_IOTHUBTRANSPORT_17_022: [ Upon success, IoTHubTransport_StartWorkerThread shall return IOTHUB_CLIENT_OK.]
 TEST_FUNCTION(IoTHubTransport_StartWorkerThread_success)
@@ -892,6 +919,7 @@ TEST_FUNCTION(IoTHubTransport_StartWorkerThread_success)
     auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
     STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, transportHandle))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
@@ -1018,6 +1046,7 @@ TEST_FUNCTION(IoTHubTransport_StartWorkerThread_thread_create_fails_returns_erro
     auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
     STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, transportHandle))
         .IgnoreArgument(1)
         .IgnoreArgument(2)
@@ -1034,6 +1063,29 @@ TEST_FUNCTION(IoTHubTransport_StartWorkerThread_thread_create_fails_returns_erro
     IoTHubTransport_Destroy(transportHandle);
 }
 
+//Tests_SRS_IOTHUBTRANSPORT_17_019: [ If thread creation fails, IoTHubTransport_StartWorkerThread shall return IOTHUB_CLIENT_ERROR. ]
+TEST_FUNCTION(IoTHubTransport_StartWorkerThread_condition_init_fails_returns_error)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Condition_Init())
+        .SetFailReturn((COND_HANDLE)NULL);
+    ///act
+
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_StartWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)result, (int)IOTHUB_CLIENT_ERROR);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_Destroy(transportHandle);
+}
+
 //Tests_SRS_IOTHUBTRANSPORT_17_042: [ If Adding to the client list fails, IoTHubTransport_StartWorkerThread shall return IOTHUB_CLIENT_ERROR. ]
 TEST_FUNCTION(IoTHubTransport_StartWorkerThread_Vector_push_back_returns_error)
 {
@@ -1043,6 +1095,7 @@ TEST_FUNCTION(IoTHubTransport_StartWorkerThread_Vector_push_back_returns_error)
     auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
     mocks.ResetAllCalls();
 
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
     STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, transportHandle))
         .IgnoreArgument(1)
         .IgnoreArgument(2);
@@ -1085,6 +1138,7 @@ TEST_FUNCTION(IoTHubTransport_SignalEndWorkerThread_success)
         .IgnoreArgument(2);
     STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
 
     ///act
     auto rv = IoTHubTransport_SignalEndWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
@@ -1278,9 +1332,9 @@ TEST_FUNCTION(IoTHubTransport_JoinWorkerThread_join_fails)
     IoTHubTransport_Destroy(transportHandle);
 }
 
-//Tests_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork every 1 ms. ]
+//Tests_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork again when IoTHubTransport_SignalWorkerThread is called or when the wait period expires. ]
 //Tests_SRS_IOTHUBTRANSPORT_17_030: [ All calls to lower layer transport DoWork shall be protected by the lock created in IoTHubTransport_Create. ]
-TEST_FUNCTION(IoTHubTransport_worker_thread_runs_every_1_ms)
+TEST_FUNCTION(IoTHubTransport_worker_thread_waits_for_work_between_DoWork_calls)
 {
     CIotHubTransportMocks mocks;
     ///arrange
@@ -1294,12 +1348,12 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_every_1_ms)
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
 
     STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
-    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 10));
 
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
-    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 10));
 
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
@@ -1317,7 +1371,7 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_every_1_ms)
     IoTHubTransport_Destroy(transportHandle);
 }
 
-//Tests_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork every 1 ms. ]
+//Tests_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork again when IoTHubTransport_SignalWorkerThread is called or when the wait period expires. ]
 //Tests_SRS_IOTHUBTRANSPORT_17_030: [ All calls to lower layer transport DoWork shall be protected by the lock created in IoTHubTransport_Create. 
 TEST_FUNCTION(IoTHubTransport_worker_thread_runs_two_devices_once)
 {
@@ -1335,7 +1389,7 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_two_devices_once)
 
     STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
 
-    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 10));
 
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
@@ -1351,6 +1405,41 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_two_devices_once)
     IoTHubTransport_Destroy(transportHandle);
 }
 
+//Tests_SRS_IOTHUBTRANSPORT_17_029: [ The thread shall call lower layer transport DoWork again when IoTHubTransport_SignalWorkerThread is called or when the wait period expires. ]
+TEST_FUNCTION(IoTHubTransport_worker_thread_does_not_wait_when_signaled_and_waits_1_ms_after)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
+    (void)IoTHubTransport_StartWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    IoTHubTransport_SignalWorkerThread(transportHandle);
+    mocks.ResetAllCalls();
+
+    howManyDoWorkCalls = 2;
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 1));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    threadFunc(threadFuncArg);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_SignalEndWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    IoTHubTransport_Destroy(transportHandle);
+}
+
 //Tests_SRS_IOTHUBTRANSPORT_17_031: [ If acquiring the lock fails, lower layer transport DoWork shall not be called. ]
 TEST_FUNCTION(IoTHubTransport_worker_thread_runs_lock_fails)
 {
@@ -1371,7 +1460,7 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_lock_fails)
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
-    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 10));
 
     STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
     STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
@@ -1389,5 +1478,456 @@ TEST_FUNCTION(IoTHubTransport_worker_thread_runs_lock_fails)
     IoTHubTransport_Destroy(transportHandle);
 }
 
+//Tests_SRS_IOTHUBTRANSPORT_01_026: [ If transportHlHandle is NULL, IoTHubTransport_SignalWorkerThread shall do nothing. ]
+TEST_FUNCTION(IoTHubTransport_SignalWorkerThread_null_transport_does_nothing)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    ///act
+    IoTHubTransport_SignalWorkerThread(NULL);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_027: [ IoTHubTransport_SignalWorkerThread shall wake up the worker thread by calling Condition_Post. ]
+TEST_FUNCTION(IoTHubTransport_SignalWorkerThread_posts_the_worker_condition)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto transportHandle = IoTHubTransport_Create(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix);
+    (void)IoTHubTransport_StartWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
+
+    ///act
+    IoTHubTransport_SignalWorkerThread(transportHandle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_SignalEndWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    IoTHubTransport_Destroy(transportHandle);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_003: [ IoTHubTransport_CreatePool shall allocate memory for the pool data, including copies of iotHubName and iotHubSuffix. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_005: [ IoTHubTransport_CreatePool shall create the pool lock by calling Lock_Init and the list of connections by calling VECTOR_create. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_029: [ IoTHubTransport_CreatePool shall create a condition for every worker thread by calling Condition_Init. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_006: [ IoTHubTransport_CreatePool shall start workerThreadCount worker threads by calling ThreadAPI_Create. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_007: [ IoTHubTransport_CreatePool shall return a non-NULL handle on success. ]
+TEST_FUNCTION(IoTHubTransport_CreatePool_success_returns_non_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock_Init());
+    STRICT_EXPECTED_CALL(mocks, VECTOR_create(sizeof(TRANSPORT_HANDLE)));
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
+    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
+    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    ///act
+    auto result = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 10, 2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(result);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_001: [ If protocol, iotHubName or iotHubSuffix is NULL, IoTHubTransport_CreatePool shall return NULL. ]
+TEST_FUNCTION(IoTHubTransport_CreatePool_null_arguments_return_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    ///act
+    auto result1 = IoTHubTransport_CreatePool(NULL, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 10, 2);
+    auto result2 = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, NULL, TEST_CONFIG.iotHubSuffix, 10, 2);
+    auto result3 = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, NULL, 10, 2);
+
+    ///assert
+    ASSERT_IS_NULL(result1);
+    ASSERT_IS_NULL(result2);
+    ASSERT_IS_NULL(result3);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_002: [ If devicesPerConnection or workerThreadCount is 0, IoTHubTransport_CreatePool shall return NULL. ]
+TEST_FUNCTION(IoTHubTransport_CreatePool_zero_counts_return_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    ///act
+    auto result1 = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 0, 2);
+    auto result2 = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 10, 0);
+
+    ///assert
+    ASSERT_IS_NULL(result1);
+    ASSERT_IS_NULL(result2);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_004: [ If any resource cannot be created, IoTHubTransport_CreatePool shall free everything it created and return NULL. ]
+TEST_FUNCTION(IoTHubTransport_CreatePool_thread_create_fails_returns_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock_Init());
+    STRICT_EXPECTED_CALL(mocks, VECTOR_create(sizeof(TRANSPORT_HANDLE)));
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Condition_Init());
+    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments()
+        .SetFailReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(mocks, Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock_Deinit(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    auto result = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 10, 1);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_008: [ If transportPoolHandle is NULL, IoTHubTransport_GetPooledTransport shall return NULL. ]
+TEST_FUNCTION(IoTHubTransport_GetPooledTransport_null_pool_returns_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    ///act
+    auto result = IoTHubTransport_GetPooledTransport(NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_010: [ If every connection is full, IoTHubTransport_GetPooledTransport shall create a new connection by calling IoTHubTransport_Create and add it to the pool. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_011: [ IoTHubTransport_GetPooledTransport shall reserve one device slot on the returned connection. ]
+TEST_FUNCTION(IoTHubTransport_GetPooledTransport_creates_the_first_connection)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 2, 1);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_Create(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock_Init());
+    STRICT_EXPECTED_CALL(mocks, VECTOR_create(sizeof(IOTHUB_CLIENT_HANDLE)));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    auto result = IoTHubTransport_GetPooledTransport(pool);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(void_ptr, (void_ptr)(0x42), (void_ptr)IoTHubTransport_GetLLTransport(result));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_009: [ IoTHubTransport_GetPooledTransport shall return the first connection of the pool which holds fewer than devicesPerConnection devices. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_010: [ If every connection is full, IoTHubTransport_GetPooledTransport shall create a new connection by calling IoTHubTransport_Create and add it to the pool. ]
+TEST_FUNCTION(IoTHubTransport_GetPooledTransport_fills_a_connection_before_creating_the_next)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 2, 1);
+    mocks.ResetAllCalls();
+
+    ///act
+    auto transport1 = IoTHubTransport_GetPooledTransport(pool);
+    auto transport2 = IoTHubTransport_GetPooledTransport(pool);
+    auto transport3 = IoTHubTransport_GetPooledTransport(pool);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(transport1);
+    ASSERT_IS_NOT_NULL(transport3);
+    ASSERT_ARE_EQUAL(void_ptr, (void_ptr)transport1, (void_ptr)transport2);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void_ptr)transport1, (void_ptr)transport3);
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_012: [ If any step fails, IoTHubTransport_GetPooledTransport shall return NULL. ]
+TEST_FUNCTION(IoTHubTransport_GetPooledTransport_connection_create_fails_returns_null)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 2, 1);
+    mocks.ResetAllCalls();
+    whenShallmalloc_fail = currentmalloc_call + 1;
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    auto result = IoTHubTransport_GetPooledTransport(pool);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_013: [ If the transport is a pooled connection, IoTHubTransport_StartWorkerThread shall not create a thread and shall have the pool's worker threads call its DoWork instead. ]
+TEST_FUNCTION(IoTHubTransport_StartWorkerThread_pooled_connection_does_not_create_a_thread)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 2, 1);
+    auto transportHandle = IoTHubTransport_GetPooledTransport(pool);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubTransport_StartWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, (int)IOTHUB_CLIENT_OK, (int)result);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    (void)IoTHubTransport_SignalEndWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_015: [ If the transport is a pooled connection, IoTHubTransport_SignalEndWorkerThread shall keep the device slot taken by IoTHubTransport_GetPooledTransport, it is released by IoTHubTransport_Destroy. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_016: [ If the transport is a pooled connection, IoTHubTransport_SignalEndWorkerThread shall return false. ]
+TEST_FUNCTION(IoTHubTransport_SignalEndWorkerThread_pooled_connection_keeps_the_slot)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 1, 1);
+    auto transportHandle = IoTHubTransport_GetPooledTransport(pool);
+    (void)IoTHubTransport_StartWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    mocks.ResetAllCalls();
+
+    ///act
+    bool okToJoin = IoTHubTransport_SignalEndWorkerThread(transportHandle, TEST_IOTHUB_CLIENT_HANDLE1);
+    auto nextTransport = IoTHubTransport_GetPooledTransport(pool);
+
+    ///assert
+    ASSERT_IS_FALSE(okToJoin);
+    ASSERT_IS_NOT_NULL(nextTransport);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void_ptr)transportHandle, (void_ptr)nextTransport);
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_017: [ If transportHandle is a pooled connection, IoTHubTransport_Destroy shall release the device slot taken by IoTHubTransport_GetPooledTransport and leave the connection in the pool until IoTHubTransport_DestroyPool. ]
+TEST_FUNCTION(IoTHubTransport_Destroy_pooled_connection_releases_the_slot)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 1, 1);
+    auto transportHandle = IoTHubTransport_GetPooledTransport(pool);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    IoTHubTransport_Destroy(transportHandle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(void_ptr, (void_ptr)transportHandle, (void_ptr)IoTHubTransport_GetPooledTransport(pool));
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_028: [ If the transport is a pooled connection, IoTHubTransport_SignalWorkerThread shall wake up the pool worker thread which services the connection. ]
+TEST_FUNCTION(IoTHubTransport_SignalWorkerThread_pooled_connection_posts_the_pool_worker_condition)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 1, 2);
+    auto transportHandle = IoTHubTransport_GetPooledTransport(pool);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    IoTHubTransport_SignalWorkerThread(transportHandle);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransport_DestroyPool(pool);
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_018: [ If transportPoolHandle is NULL, IoTHubTransport_DestroyPool shall do nothing. ]
+TEST_FUNCTION(IoTHubTransport_DestroyPool_null_does_nothing)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+
+    ///act
+    IoTHubTransport_DestroyPool(NULL);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_019: [ IoTHubTransport_DestroyPool shall stop and join every worker thread, then destroy every connection of the pool and free all resources. ]
+TEST_FUNCTION(IoTHubTransport_DestroyPool_joins_workers_and_destroys_connections)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 1, 2);
+    (void)IoTHubTransport_GetPooledTransport(pool);
+    mocks.ResetAllCalls();
+
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_element(IGNORED_PTR_ARG, 0))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_Destroy((TRANSPORT_LL_HANDLE)(0x42)));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IoTHubTransport_DestroyPool(pool);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+//Tests_SRS_IOTHUBTRANSPORT_01_021: [ Pool worker thread number i shall service the connections i, i + workerThreadCount, i + 2 * workerThreadCount and so on. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_022: [ Every call to a connection's lower layer transport DoWork shall be protected by that connection's lock. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_023: [ A pool worker thread shall only call DoWork for connections which have at least one client that invoked IoTHubTransport_StartWorkerThread. ]
+//Tests_SRS_IOTHUBTRANSPORT_01_024: [ A pool worker thread shall service its connections again when IoTHubTransport_SignalWorkerThread is called for one of them or when the wait period expires. ]
+TEST_FUNCTION(IoTHubTransport_pool_worker_thread_calls_DoWork_for_started_connections_only)
+{
+    CIotHubTransportMocks mocks;
+    ///arrange
+    auto pool = IoTHubTransport_CreatePool(TEST_CONFIG.protocol, TEST_CONFIG.iotHubName, TEST_CONFIG.iotHubSuffix, 1, 1);
+    (void)IoTHubTransport_GetPooledTransport(pool);
+    auto startedTransport = IoTHubTransport_GetPooledTransport(pool);
+    (void)IoTHubTransport_StartWorkerThread(startedTransport, TEST_IOTHUB_CLIENT_HANDLE1);
+    mocks.ResetAllCalls();
+
+    howManyDoWorkCalls = 1;
+    threadTerminationOffset = IoTHubTransport_PoolWorkerTerminationOffset;
+
+    /*the connection nobody started*/
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_element(IGNORED_PTR_ARG, 0))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    /*the started connection*/
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, VECTOR_element(IGNORED_PTR_ARG, 1))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, FAKE_IoTHubTransport_DoWork((TRANSPORT_LL_HANDLE)(0x42), NULL));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    /*end of the list*/
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 10));
+    STRICT_EXPECTED_CALL(mocks, Unlock(TEST_LOCK_HANDLE));
+
+    ///act
+    threadFunc(threadFuncArg);
+
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    (void)IoTHubTransport_SignalEndWorkerThread(startedTransport, TEST_IOTHUB_CLIENT_HANDLE1);
+    IoTHubTransport_DestroyPool(pool);
+}
+
 END_TEST_SUITE(iothubtransport_ut)
 
@@ -1701,6 +1701,44 @@ static void setupDoWorkLoopForNextDevice(CIoTHubTransportHttpMocks &mocks, size_
         .IgnoreArgument(1);
 }
 
+/*a batched item is queried once when the batch is measured and once more when it is serialized*/
+static void setupBatchedItemQuery(CIoTHubTransportHttpMocks &mocks, IOTHUB_MESSAGE_HANDLE messageHandle, IOTHUBMESSAGE_CONTENT_TYPE contentType, MAP_HANDLE properties)
+{
+    (void)mocks;
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(messageHandle));
+    if (contentType == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+    }
+    else
+    {
+        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(messageHandle));
+    }
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(messageHandle));
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(properties, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
+}
+
+/*the batched payload is allocated once, at its exact size, and released after HTTPAPIEX_SAS_ExecuteRequest*/
+static void setupBatchedPayloadBuffer(CIoTHubTransportHttpMocks &mocks)
+{
+    (void)mocks;
+
+    STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+    STRICT_EXPECTED_CALL(mocks, BUFFER_pre_build(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+}
+
 //
 //static void setupInitHappyPathUpThroughHostName(CIoTHubTransportHttpMocks &mocks, bool deallocateCreated)
 //{
@@ -5290,51 +5328,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_2devices_2nd_has_1_event_item_as_string
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
-
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"base64Encoded\":false")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message10.messageHandle, IOTHUBMESSAGE_STRING, TEST_MAP_EMPTY);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -5342,21 +5337,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_2devices_2nd_has_1_event_item_as_string
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message10.entry)))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message10.messageHandle, IOTHUBMESSAGE_STRING, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -9206,6 +9189,8 @@ TEST_FUNCTION(HTTP_Protocol_succeeds)
 //Tests_SRS_TRANSPORTMULTITHTTP_17_053: [ If option SetBatching is true then _DoWork shall send batched event message as specced below. ]
 //Tests_SRS_TRANSPORTMULTITHTTP_17_117: [ If optionName is an option handled by IoTHubTransportHttp then it shall be set. ]
 //Tests_SRS_TRANSPORTMULTITHTTP_17_120: [ "Batching" ]
+//Tests_SRS_TRANSPORTMULTITHTTP_01_004: [ IoTHubTransportHttp_DoWork shall compute the exact size of the serialized batch before building it. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_01_005: [ IoTHubTransportHttp_DoWork shall serialize the batched messages directly into a single BUFFER_HANDLE of that exact size. ]
 TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_happy_path_succeeds)
 {
     ///arrange
@@ -9223,55 +9208,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_happy_path_succeeds)
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -9279,21 +9217,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_happy_path_succeeds)
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -9350,55 +9276,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_ht
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -9406,21 +9285,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_ht
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -9476,55 +9343,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_HT
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -9532,21 +9352,9 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_HT
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -9586,7 +9394,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_HT
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BUFFER_build_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BUFFER_pre_build_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -9603,55 +9411,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -9660,21 +9421,14 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
         .IgnoreArgument(1);
 
     {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
+        /*allocating the HTTP payload*/
         STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        whenShallBUFFER_build_fail = 1;
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        STRICT_EXPECTED_CALL(mocks, BUFFER_pre_build(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
             .IgnoreArgument(1)
             .IgnoreArgument(2)
-            .IgnoreArgument(3)
             .SetReturn(__FAILURE__);
+        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
     }
 
     STRICT_EXPECTED_CALL(mocks, DList_AppendTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).IgnoreAllArguments();
@@ -9711,73 +9465,26 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
     {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
+        /*allocating the HTTP payload*/
+        whenShallBUFFER_new_fail = 1;
+        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+    }
 
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_AppendTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG)).IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
-        .IgnoreArgument(1);
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        whenShallBUFFER_new_fail = 1;
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-    }
-
-    STRICT_EXPECTED_CALL(mocks, DList_AppendTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveEntryList(IGNORED_PTR_ARG)).IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(mocks, DList_InitializeListHead(IGNORED_PTR_ARG)).IgnoreAllArguments();
-
-    ENABLE_BATCHING();
+    ENABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -9790,7 +9497,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_puts_it_back_when_BU
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_with_STRING_fails_it_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_IoTHubMessage_GetByteArray_it_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -9807,50 +9514,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_wi
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        whenShallSTRING_concat_with_STRING_fail = 7;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
+    /*measuring the batch*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .SetReturn(IOTHUB_MESSAGE_ERROR);
 
     ENABLE_BATCHING();
 
@@ -9864,8 +9533,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_wi
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_055: [ If updating Content-Type fails for any reason, then _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_HTTP_headers_fails_it_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -9880,46 +9549,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
 
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        whenShallSTRING_concat_fail = currentSTRING_concat_call + 2;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
+        .IgnoreArgument(1)
+        .SetReturn(HTTP_HEADERS_ERROR);
 
     ENABLE_BATCHING();
 
@@ -9933,12 +9564,14 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it_fails_2)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_065: [ If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_CLIENT_CONFIRMATION_ERROR. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_17_061: [ The message size shall be limited to 255KB - 1 byte. ]
+//Tests_SRS_TRANSPORTMULTITHTTP_17_062: [ The message size is computed from the length of the payload + 384. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_bigger_than_256K_path_succeeds)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message4.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -9951,37 +9584,17 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message4.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*building the list of messages to be notified because this is 100% fail (>256K)*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message4.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-
-        whenShallSTRING_concat_fail = currentSTRING_concat_call + 1;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR))
+        .IgnoreArgument(2);
 
     ENABLE_BATCHING();
 
@@ -9995,12 +9608,13 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_it
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_with_STRING_it_fails_2)
+/*this is a test that wants to see that "almost" 255KB message still fits*/
+//Tests_SRS_TRANSPORTMULTITHTTP_17_062: [ The message size is computed from the length of the payload + 384. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_almost255_happy_path_succeeds)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message5.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -10013,33 +9627,43 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_wi
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message5.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message5.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message5.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
 
-        whenShallSTRING_concat_with_STRING_fail = 6;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        /*end of the first batched payload*/
-    }
+    /*once the event has been succesfull...*/
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
 
     ENABLE_BATCHING();
 
@@ -10053,12 +9677,13 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_concat_wi
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_Base64_Encode_Bytes_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_056: [ IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...] ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_makes_1_batch_succeeds)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
     DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -10071,25 +9696,47 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_Base64_Encode_By
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
+        .IgnoreArgument(1);
+    setupBatchedItemQuery(mocks, message2.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message2.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+    setupBatchedItemQuery(mocks, message2.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
-        whenShallBase64_Encode_Bytes_fail = 1;
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        /*end of the first batched payload*/
-    }
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+
+    /*once the event has been succesfull...*/
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
 
     ENABLE_BATCHING();
 
@@ -10103,17 +9750,17 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_Base64_Encode_By
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_IoTHubMessage_GetByteArray_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_066: [ If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_items_fails_the_first_one_still_makes_1_batch_succeeds_1)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
     DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
     mocks.ResetAllCalls();
-
     setupDoWorkLoopOnceForOneDevice(mocks);
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
@@ -10121,24 +9768,48 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_IoTHubMessage_Ge
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .SetReturn(IOTHUB_MESSAGE_ERROR);
+    /*the second item cannot be measured*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message2.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message2.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .SetReturn(IOTHUB_MESSAGE_ERROR);
 
-        /*end of the first batched payload*/
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+
+    /*once the event has been succesfull...*/
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
 
     ENABLE_BATCHING();
 
@@ -10152,17 +9823,17 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_IoTHubMessage_Ge
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_construct_fails_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_066: [ If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_items_fails_the_first_one_still_makes_1_batch_succeeds_2)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
     DList_InsertTailList(&(waitingToSend), &(message1.entry));
+    DList_InsertTailList(&(waitingToSend), &(message2.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
     mocks.ResetAllCalls();
-
     setupDoWorkLoopOnceForOneDevice(mocks);
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
@@ -10170,767 +9841,28 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_construct
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        whenShallSTRING_construct_fail = currentSTRING_construct_call + 2;
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        /*end of the first batched payload*/
-    }
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_067: [ If there is no valid payload, IoTHubTransportHttp_DoWork shall advance to the next activity. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_STRING_construct_it_fails)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    whenShallSTRING_construct_fail = currentSTRING_construct_call + 1;
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_055: [ If updating Content-Type fails for any reason, then _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_when_HTTP_headers_fails_it_fails)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1)
-        .SetReturn(HTTP_HEADERS_ERROR);
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_065: [ If the oldest message in waitingToSend causes the message size to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_CLIENT_CONFIRMATION_ERROR. ]
-//Tests_SRS_TRANSPORTMULTITHTTP_17_061: [ The message size shall be limited to 255KB - 1 byte. ]
-//Tests_SRS_TRANSPORTMULTITHTTP_17_062: [ The message size is computed from the length of the payload + 384. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_bigger_than_256K_path_succeeds)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message4.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message4.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message4.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(bigBufferOverflow, TEST_BIG_BUFFER_1_OVERFLOW_SIZE));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message4.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        /*building the list of messages to be notified because this is 100% fail (>256K)*/
-        STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message4.entry)))
-            .IgnoreArgument(1);
-    }
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR))
-        .IgnoreArgument(2);
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-/*this is a test that wants to see that "almost" 255KB message still fits*/
-//Tests_SRS_TRANSPORTMULTITHTTP_17_062: [ The message size is computed from the length of the payload + 384. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_almost255_happy_path_succeeds)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message5.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message5.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message5.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(bigBufferFit, TEST_BIG_BUFFER_1_FIT_SIZE));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message5.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message5.entry)))
-        .IgnoreArgument(1);
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
-
-    /*executing HTTP goodies*/
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
-        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
-        IGNORED_PTR_ARG,
-        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
-        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
-        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
-        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
-        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
-        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
-        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
-        ))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
-
-    /*once the event has been succesfull...*/
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
-        .IgnoreArgument(2);
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_056: [ IoTHubTransportHttp_DoWork shall build the following string:[{"body":"base64 encoding of the message1 content"},{"body":"base64 encoding of the message2 content"}...] ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_makes_1_batch_succeeds)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
-    DList_InsertTailList(&(waitingToSend), &(message2.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    /*this is second batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message2.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer2, buffer2_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the second payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    {
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message2.entry)))
-        .IgnoreArgument(1);
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
-
-    /*executing HTTP goodies*/
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
-        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
-        IGNORED_PTR_ARG,
-        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
-        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
-        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
-        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
-        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
-        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
-        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
-        ))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
-
-    /*once the event has been succesfull...*/
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
-        .IgnoreArgument(2);
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_066: [ If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_items_fails_the_first_one_still_makes_1_batch_succeeds_1)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
-    DList_InsertTailList(&(waitingToSend), &(message2.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    /*this is second batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message2.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer2, buffer2_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        whenShallSTRING_concat_fail = currentSTRING_concat_call + 4;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the second batched payload*/
-    }
-
-    {
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
-        .IgnoreArgument(1);
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
-
-    /*executing HTTP goodies*/
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
-        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
-        IGNORED_PTR_ARG,
-        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
-        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
-        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
-        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
-        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
-        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
-        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
-        ))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
-
-    /*once the event has been succesfull...*/
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
-        .IgnoreArgument(2);
-
-    ENABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_066: [ If at any point during construction of the string there are errors, IoTHubTransportHttp_DoWork shall use the so far constructed string as payload. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_when_the_second_items_fails_the_first_one_still_makes_1_batch_succeeds_2)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message1.entry));
-    DList_InsertTailList(&(waitingToSend), &(message2.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);;
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    /*this is second batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message2.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer2, buffer2_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message2.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the second batched payload*/
-    }
-
-    {
-        /*adding the second payload to the "big" payload*/
-        whenShallSTRING_concat_with_STRING_fail = currentSTRING_concat_with_STRING_call + 4;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    {
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    /*the properties of the second item cannot be measured*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message2.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message2.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message2.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4)
+        .SetReturn(MAP_ERROR);
 
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -10987,113 +9919,19 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_the_second_one_does_
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message1.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(buffer1, buffer1_size));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message1.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    /*this is second batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message5.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(message5.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL(mocks, Base64_Encode_Bytes(bigBufferFit, TEST_BIG_BUFFER_1_FIT_SIZE));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message5.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the second payload to the "big" payload*/
-    }
-
-    {
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
     STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message1.entry)))
         .IgnoreArgument(1);
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*the second item is measured, but does not fit*/
+    setupBatchedItemQuery(mocks, message5.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
+
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message1.messageHandle, IOTHUBMESSAGE_BYTEARRAY, TEST_MAP_EMPTY);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -11284,7 +10122,7 @@ TEST_FUNCTION(IoTHubTransportHttp_GetSendStatus_deviceData_is_not_found_fails)
     IoTHubMessage_Destroy(eventMessageHandle);
 }
 
-void setupIrrelevantMocksForProperties(CIoTHubTransportHttpMocks *mocks, IOTHUB_MESSAGE_HANDLE messageHandle) /*these are copy pasted from TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items))*/
+void setupIrrelevantMocksForProperties(CIoTHubTransportHttpMocks *mocks, IOTHUB_MESSAGE_HANDLE messageHandle, MAP_HANDLE properties) /*these are copy pasted from TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items))*/
 {
     (void)(*mocks);
     STRICT_EXPECTED_CALL((*mocks), DList_IsListEmpty(&waitingToSend));
@@ -11292,58 +10130,8 @@ void setupIrrelevantMocksForProperties(CIoTHubTransportHttpMocks *mocks, IOTHUB_
     STRICT_EXPECTED_CALL((*mocks), HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL((*mocks), STRING_construct("["));
-    STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetContentType(messageHandle));
-        STRICT_EXPECTED_CALL((*mocks), STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetByteArray(messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        if(messageHandle == TEST_IOTHUB_MESSAGE_HANDLE_11)
-        {
-            STRICT_EXPECTED_CALL((*mocks), Base64_Encode_Bytes(buffer11, buffer11_size));
-
-        }
-        else
-        {
-            STRICT_EXPECTED_CALL((*mocks), Base64_Encode_Bytes(buffer6, buffer6_size));
-        }
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
+    /*measuring the batch*/
+    setupBatchedItemQuery(*mocks, messageHandle, IOTHUBMESSAGE_BYTEARRAY, properties);
 
     /*building the list of messages to be notified if HTTP is fine*/
     STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
@@ -11360,22 +10148,9 @@ void setupIrrelevantMocksForProperties(CIoTHubTransportHttpMocks *mocks, IOTHUB_
             .IgnoreArgument(1);
     }
 
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_new());
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(*mocks);
+    setupBatchedItemQuery(*mocks, messageHandle, IOTHUBMESSAGE_BYTEARRAY, properties);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -11417,32 +10192,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_with_properties_succ
 
     setupDoWorkLoopOnceForOneDevice(mocks);
 
-    setupIrrelevantMocksForProperties(&mocks, message6.messageHandle);
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message6.messageHandle));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
+    setupIrrelevantMocksForProperties(&mocks, message6.messageHandle, TEST_MAP_1_PROPERTY);
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"properties\":"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "{"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"iothub-app-"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_VALUES1[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\":\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_KEYS1[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "}"))
-        .IgnoreArgument(1);
 
     ENABLE_BATCHING();
 
@@ -11472,32 +10223,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_with_1_properties_at
 
     setupDoWorkLoopOnceForOneDevice(mocks);
 
-    setupIrrelevantMocksForProperties(&mocks, message11.messageHandle);
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message11.messageHandle));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY_A_B, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG));
+    setupIrrelevantMocksForProperties(&mocks, message11.messageHandle, TEST_MAP_1_PROPERTY_A_B);
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"properties\":"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "{"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"iothub-app-"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_VALUES1_A_B[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\":\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_KEYS1_A_B[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "}"))
-        .IgnoreArgument(1);
 
     ENABLE_BATCHING();
 
@@ -11576,7 +10303,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items_fails_when_Map_GetIn
     IoTHubTransportHttp_Destroy(handle);
 }
 
-void setupIrrelevantMocksForProperties2(CIoTHubTransportHttpMocks *mocks, IOTHUB_MESSAGE_HANDLE h1, IOTHUB_MESSAGE_HANDLE h2) /*these are copy pasted from TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items))*/
+void setupIrrelevantMocksForProperties2(CIoTHubTransportHttpMocks *mocks, IOTHUB_MESSAGE_HANDLE h1, MAP_HANDLE p1, IOTHUB_MESSAGE_HANDLE h2, MAP_HANDLE p2) /*these are copy pasted from TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_items))*/
 {
     (void)(*mocks);
     STRICT_EXPECTED_CALL((*mocks), DList_IsListEmpty(&waitingToSend));
@@ -11584,109 +10311,22 @@ void setupIrrelevantMocksForProperties2(CIoTHubTransportHttpMocks *mocks, IOTHUB
     STRICT_EXPECTED_CALL((*mocks), HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL((*mocks), STRING_construct("["));
-    STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetContentType(h1));
-        STRICT_EXPECTED_CALL((*mocks), STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetByteArray(message6.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL((*mocks), Base64_Encode_Bytes(buffer6, buffer6_size));
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-    }
-
-    /*this is second batched payload*/
-    {
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetContentType(h2));
-        STRICT_EXPECTED_CALL((*mocks), STRING_construct("{\"body\":\""));
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), IoTHubMessage_GetByteArray(message7.messageHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-
-        STRICT_EXPECTED_CALL((*mocks), Base64_Encode_Bytes(buffer7, buffer7_size));
-        STRICT_EXPECTED_CALL((*mocks), STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "\"")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the second payload to the "big" payload*/
-        STRICT_EXPECTED_CALL((*mocks), STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
+    /*measuring the batch*/
+    setupBatchedItemQuery(*mocks, h1, IOTHUBMESSAGE_BYTEARRAY, p1);
     STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL((*mocks), DList_InsertTailList(IGNORED_PTR_ARG, &(message6.entry)))
         .IgnoreArgument(1);
+    setupBatchedItemQuery(*mocks, h2, IOTHUBMESSAGE_BYTEARRAY, p2);
     STRICT_EXPECTED_CALL((*mocks), DList_RemoveHeadList(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL((*mocks), DList_InsertTailList(IGNORED_PTR_ARG, &(message7.entry)))
         .IgnoreArgument(1);
 
-
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_new());
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL((*mocks), STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL((*mocks), BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(*mocks);
+    setupBatchedItemQuery(*mocks, h1, IOTHUBMESSAGE_BYTEARRAY, p1);
+    setupBatchedItemQuery(*mocks, h2, IOTHUBMESSAGE_BYTEARRAY, p2);
 
     /*executing HTTP goodies*/
     STRICT_EXPECTED_CALL((*mocks), STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
@@ -11704,95 +10344,31 @@ void setupIrrelevantMocksForProperties2(CIoTHubTransportHttpMocks *mocks, IOTHUB
         ))
         .IgnoreArgument(1)
         .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
-
-    /*once the event has been succesfull...*/
-
-    STRICT_EXPECTED_CALL((*mocks), IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
-        .IgnoreArgument(2);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_064: [ If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_with_properties_succeeds)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message6.entry));
-    DList_InsertTailList(&(waitingToSend), &(message7.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    setupIrrelevantMocksForProperties2(&mocks, message6.messageHandle, message7.messageHandle);
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message6.messageHandle));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
-
-    EXPECTED_CALL(mocks, STRING_new_with_memory(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"properties\":"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "{")) /*opening of the properties*/
-        .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"iothub-app-"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_VALUES1[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\":\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_KEYS1[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\""))
-        .IgnoreArgument(1);
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "}"))/*closing of the properties*/
-        .IgnoreArgument(1);
+    /*once the event has been succesfull...*/
 
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message7.messageHandle));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_2_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
+    STRICT_EXPECTED_CALL((*mocks), IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
+}
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"properties\":"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "{")) /*opening of the properties*/
-        .IgnoreArgument(1);
+//Tests_SRS_TRANSPORTMULTITHTTP_17_064: [ If IoTHubMessage does not have properties, then "properties":{...} shall be missing from the payload. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_with_properties_succeeds)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
+    DList_InsertTailList(&(waitingToSend), &(message7.entry));
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\"iothub-app-"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_VALUES2[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\":\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_KEYS2[0]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\""))
-        .IgnoreArgument(1);
+    mocks.ResetAllCalls();
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"iothub-app-"))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_VALUES2[1]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\":\""))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_KEYS2[1]))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "\""))
-        .IgnoreArgument(1);
+    setupDoWorkLoopOnceForOneDevice(mocks);
 
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "}"))/*closing of the properties*/
-        .IgnoreArgument(1);
+    setupIrrelevantMocksForProperties2(&mocks, message6.messageHandle, TEST_MAP_1_PROPERTY, message7.messageHandle, TEST_MAP_2_PROPERTY);
 
     ENABLE_BATCHING();
 
@@ -11837,124 +10413,71 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items)
     IoTHubTransportHttp_Destroy(handle);
 }
 
-#define THRESHOLD1 32 /*between THRESHOLD1 and THRESHOLD2 of STRING_concat fails there still is produced a payload, consisting of only REDKEY, REDVALUE*/
-#define THRESHOLD2 17
-#define THRESHOLD3 7 /*below 7, STRING_concat would fail not in producing properties*/
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_058: [ If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2"} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_THRESHOLD1_succeeds)
-{
-    for (size_t i = THRESHOLD1 + 1; i > THRESHOLD1; i--)
-    {
-        ///arrange
-        currentSTRING_concat_call = 0;
-        whenShallSTRING_concat_fail = 0;
-        BASEIMPLEMENTATION::DList_InitializeListHead(&waitingToSend);
-        CNiceCallComparer<CIoTHubTransportHttpMocks> mocks; /*a very e2e test... */
-        DList_InsertTailList(&(waitingToSend), &(message6.entry));
-        DList_InsertTailList(&(waitingToSend), &(message7.entry));
-        auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-        (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-        mocks.ResetAllCalls();
-
-        setupDoWorkLoopOnceForOneDevice(mocks);
-
-        whenShallSTRING_concat_fail = i;
-
-        ENABLE_BATCHING();
-
-        ///act
-        IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-        ///assert
-        ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), TEST_2_ITEM_STRING, sizeof(TEST_2_ITEM_STRING) - 1));
-        mocks.AssertActualAndExpectedCalls();
-
-        ///cleanup
-        IoTHubTransportHttp_Destroy(handle);
-        if (last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest != NULL)
-        {
-            BASEIMPLEMENTATION::BUFFER_delete(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest);
-            last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest = NULL;
-        }
-    }
-}
-
 //Tests_SRS_TRANSPORTMULTITHTTP_17_058: [ If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2"} ]
 TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_send_only_1_when_properties_for_second_fail)
 {
-    for (size_t i = THRESHOLD1; i > THRESHOLD2; i--)
-    {
-        ///arrange
-        currentSTRING_concat_call = 0;
-        whenShallSTRING_concat_fail = 0;
-        BASEIMPLEMENTATION::DList_InitializeListHead(&waitingToSend);
-        CNiceCallComparer<CIoTHubTransportHttpMocks> mocks; /*a very e2e test... */
-        DList_InsertTailList(&(waitingToSend), &(message6.entry));
-        DList_InsertTailList(&(waitingToSend), &(message7.entry));
-        auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-        (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-        mocks.ResetAllCalls();
+    ///arrange
+    CNiceCallComparer<CIoTHubTransportHttpMocks> mocks; /*a very e2e test... */
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
+    DList_InsertTailList(&(waitingToSend), &(message7.entry));
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
-        setupDoWorkLoopOnceForOneDevice(mocks);
+    mocks.ResetAllCalls();
 
-        whenShallSTRING_concat_fail = i;
+    setupDoWorkLoopOnceForOneDevice(mocks);
 
-        ENABLE_BATCHING();
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_2_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4)
+        .SetReturn(MAP_ERROR);
 
-        ///act
-        IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    ENABLE_BATCHING();
 
-        ///assert
-        ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), TEST_1_ITEM_STRING, sizeof(TEST_1_ITEM_STRING) - 1));
-        mocks.AssertActualAndExpectedCalls();
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
 
-        ///cleanup
-        IoTHubTransportHttp_Destroy(handle);
-        if (last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest != NULL)
-        {
-            BASEIMPLEMENTATION::BUFFER_delete(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest);
-            last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest = NULL;
-        }
-    }
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(TEST_1_ITEM_STRING) - 1, BASEIMPLEMENTATION::BUFFER_length(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), TEST_1_ITEM_STRING, sizeof(TEST_1_ITEM_STRING) - 1));
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_058: [ If IoTHubMessage has properties, then they shall be serialized at the same level as "body" using the following pattern: "properties":{"iothub-app-name1":"value1","iothub-app-name2":"value2"} ]
 TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_2_event_items_send_nothing)
 {
-    for (size_t i = THRESHOLD2; i > THRESHOLD3; i--)
-    {
-        ///arrange
-        currentSTRING_concat_call = 0;
-        whenShallSTRING_concat_fail = 0;
-        BASEIMPLEMENTATION::DList_InitializeListHead(&waitingToSend);
-        CNiceCallComparer<CIoTHubTransportHttpMocks> mocks; /*a very e2e test... */
-        DList_InsertTailList(&(waitingToSend), &(message6.entry));
-        DList_InsertTailList(&(waitingToSend), &(message7.entry));
-        auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-        mocks.ResetAllCalls();
+    ///arrange
+    CNiceCallComparer<CIoTHubTransportHttpMocks> mocks; /*a very e2e test... */
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
+    DList_InsertTailList(&(waitingToSend), &(message7.entry));
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
-        whenShallSTRING_concat_fail = i;
+    mocks.ResetAllCalls();
 
-        ENABLE_BATCHING();
+    setupDoWorkLoopOnceForOneDevice(mocks);
 
-        ///act
-        IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4)
+        .SetReturn(MAP_ERROR);
 
-        ///assert
-        ASSERT_IS_NULL(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest);
-        mocks.AssertActualAndExpectedCalls();
+    ENABLE_BATCHING();
 
-        ///cleanup
-        IoTHubTransportHttp_Destroy(handle);
-        if (last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest != NULL)
-        {
-            BASEIMPLEMENTATION::BUFFER_delete(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest);
-            last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest = NULL;
-        }
-    }
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
+
+    ///assert
+    ASSERT_IS_NULL(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest);
+    mocks.AssertActualAndExpectedCalls();
+
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_114: [ If handle parameter is NULL then IoTHubTransportHttp_SetOption shall return IOTHUB_CLIENT_INVALID_ARG. ]
@@ -13889,148 +12412,13 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
         IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
         NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
         NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
-        ))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200))
-        .SetReturn(HTTPAPIEX_ERROR);
-
-    EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), buffer6, buffer6_size));
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_buffer_fails_1)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message6.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3);
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
-        .IgnoreArgument(1);
-
-    /*no properties, so no more headers*/
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
-
-    /*this is making http headers*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("iothub-app-"));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_RED_KEY))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "iothub-app-" TEST_RED_KEY, TEST_RED_VALUE))
-        .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-    STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .SetReturn(1);
-
-    EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_buffer_fails_2)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message6.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3);
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
-        .IgnoreArgument(1);
-
-    /*no properties, so no more headers*/
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .IgnoreArgument(4);
-
-    /*this is making http headers*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("iothub-app-"));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_RED_KEY))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "iothub-app-" TEST_RED_KEY, TEST_RED_VALUE))
-        .IgnoreArgument(1);
-
-    whenShallBUFFER_new_fail = currentBUFFER_new_call + 1;
-    STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200))
+        .SetReturn(HTTPAPIEX_ERROR);
 
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
@@ -14041,6 +12429,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
 
     ///assert
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), buffer6, buffer6_size));
     mocks.AssertActualAndExpectedCalls();
 
     ///cleanup
@@ -14048,7 +12437,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_1)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_buffer_fails_1)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14057,7 +12446,6 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
     mocks.ResetAllCalls();
-
     setupDoWorkLoopOnceForOneDevice(mocks);
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
@@ -14091,8 +12479,17 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "iothub-app-" TEST_RED_KEY, TEST_RED_VALUE))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(mocks, BUFFER_new());
+    STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
         .IgnoreArgument(1)
-        .SetReturn(HTTP_HEADERS_ERROR);
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .SetReturn(1);
 
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
@@ -14110,7 +12507,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_2)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_buffer_fails_2)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14149,8 +12546,14 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
     STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_RED_KEY))
-        .IgnoreArgument(1)
-        .SetReturn(1111); /*unpredictable value which is an error*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "iothub-app-" TEST_RED_KEY, TEST_RED_VALUE))
+        .IgnoreArgument(1);
+
+    whenShallBUFFER_new_fail = currentBUFFER_new_call + 1;
+    STRICT_EXPECTED_CALL(mocks, BUFFER_new());
 
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
@@ -14168,7 +12571,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_3)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_1)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14203,8 +12606,16 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
         .IgnoreArgument(4);
 
     /*this is making http headers*/
-    whenShallSTRING_construct_fail = currentSTRING_construct_call + 1;
     STRICT_EXPECTED_CALL(mocks, STRING_construct("iothub-app-"));
+    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_RED_KEY))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "iothub-app-" TEST_RED_KEY, TEST_RED_VALUE))
+        .IgnoreArgument(1)
+        .SetReturn(HTTP_HEADERS_ERROR);
 
     EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
@@ -14222,7 +12633,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_map_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_2)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14254,85 +12665,18 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
     STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
         .IgnoreArgument(3)
-        .IgnoreArgument(4)
-        .SetReturn(MAP_ERROR);
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_fails_4)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message6.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3);
+        .IgnoreArgument(4);
 
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
+    /*this is making http headers*/
+    STRICT_EXPECTED_CALL(mocks, STRING_construct("iothub-app-"));
+    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
+    STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, TEST_RED_KEY))
         .IgnoreArgument(1)
-        .SetReturn(HTTP_HEADERS_ERROR);
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_fails_5)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message6.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3);
+        .SetReturn(1111); /*unpredictable value which is an error*/
 
-    whenShallHTTPHeaders_Clone_fail = currentHTTPHeaders_Clone_call + 1;
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
 
     DISABLE_BATCHING();
 
@@ -14347,7 +12691,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_IoTHubMessage_GetByteArray_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_headers_fail_3)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14363,177 +12707,32 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_
 
     STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
     STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument(2)
-        .IgnoreArgument(3)
-        .SetReturn(IOTHUB_MESSAGE_ERROR);
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_075: [ If the oldest message in waitingToSend causes the message to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_CLIENT_CONFIRMATION_ERROR. ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_overlimit_calls_SendComplete_with_BATCHSTATE_FAILED)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message9.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_9));
-    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_9, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
         .IgnoreArgument(3);
 
-    /*ooops - over 256K*/
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message9.entry)))
-        .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR))
-        .IgnoreArgument(2);
-
-    DISABLE_BATCHING();
-
-    ///act
-    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
-
-    ///assert
-    mocks.AssertActualAndExpectedCalls();
-
-    ///cleanup
-    IoTHubTransportHttp_Destroy(handle);
-}
-
-//Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_happy_path_succeeds)
-{
-    ///arrange
-    CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message10.entry));
-    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
-    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
-
-    mocks.ResetAllCalls();
-
-    setupDoWorkLoopOnceForOneDevice(mocks);
-
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
-
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
-
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"base64Encoded\":false")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
-
-    {
-        /*adding the first payload to the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        /*closing the "big" payload*/
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-    }
-
-    /*building the list of messages to be notified if HTTP is fine*/
-    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message10.entry)))
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    {
-        /*this is building the HTTP payload... from a STRING_HANDLE (as it comes as "big payload"), into an array of bytes*/
-        STRICT_EXPECTED_CALL(mocks, BUFFER_new());
-        STRICT_EXPECTED_CALL(mocks, BUFFER_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_length(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, BUFFER_build(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .IgnoreArgument(3);
-    }
-
-    /*executing HTTP goodies*/
-    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
         .IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
-        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
-        IGNORED_PTR_ARG,
-        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
-        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
-        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
-        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
-        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
-        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
-        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
-        ))
-        .IgnoreArgument(1)
+
+    /*no properties, so no more headers*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument(2)
-        .IgnoreArgument(5)
-        .IgnoreArgument(6)
-        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
+        .IgnoreArgument(3)
+        .IgnoreArgument(4);
 
-    /*once the event has been succesfull...*/
+    /*this is making http headers*/
+    whenShallSTRING_construct_fail = currentSTRING_construct_call + 1;
+    STRICT_EXPECTED_CALL(mocks, STRING_construct("iothub-app-"));
 
-    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
-        .IgnoreArgument(2);
+    EXPECTED_CALL(mocks, IoTHubMessage_GetMessageId(IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG));
 
-    ENABLE_BATCHING();
+    DISABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -14545,12 +12744,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_happy_path_
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_string_concat_fails_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_map_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message10.entry));
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -14560,44 +12759,28 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_string
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
 
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
-
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
+        .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"base64Encoded\":false")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4);
-        whenShallSTRING_concat_fail = currentSTRING_concat_call + 2;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, "},")) /* this extra "," is going to be harshly overwritten by a "]"*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
+    /*no properties, so no more headers*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_1_PROPERTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4)
+        .SetReturn(MAP_ERROR);
 
-    ENABLE_BATCHING();
+    DISABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -14609,12 +12792,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_string
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_Map_GetInternals_fails_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_fails_4)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message10.entry));
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -14624,42 +12807,21 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_Map_Ge
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
 
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Free(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
-
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"base64Encoded\":false")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(2)
-            .IgnoreArgument(3)
-            .IgnoreArgument(4)
-            .SetReturn(MAP_ERROR);
-        /*end of the first batched payload*/
-    }
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/octet-stream"))
+        .IgnoreArgument(1)
+        .SetReturn(HTTP_HEADERS_ERROR);
 
-    ENABLE_BATCHING();
+    DISABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -14671,12 +12833,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_Map_Ge
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING_concat_fails_it_fails_2)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_http_fails_5)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message10.entry));
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -14686,37 +12848,49 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
 
     STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
 
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    whenShallHTTPHeaders_Clone_fail = currentHTTPHeaders_Clone_call + 1;
+    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_Clone(IGNORED_PTR_ARG))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
+    DISABLE_BATCHING();
 
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    ///act
+    IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
 
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
+    ///assert
+    mocks.AssertActualAndExpectedCalls();
 
-        whenShallSTRING_concat_fail = currentSTRING_concat_call + 1;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat(IGNORED_PTR_ARG, ",\"base64Encoded\":false")) /*closing the value of the body*/
-            .IgnoreArgument(1);
-        /*end of the first batched payload*/
-    }
+    ///cleanup
+    IoTHubTransportHttp_Destroy(handle);
+}
 
-    ENABLE_BATCHING();
+//Tests_SRS_TRANSPORTMULTITHTTP_17_079: [ If any HTTP header operation fails, _DoWork shall advance to the next action. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_does_nothing_when_IoTHubMessage_GetByteArray_fails)
+{
+    ///arrange
+    CIoTHubTransportHttpMocks mocks;
+    DList_InsertTailList(&(waitingToSend), &(message6.entry));
+    auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
+    (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
+
+    mocks.ResetAllCalls();
+
+    setupDoWorkLoopOnceForOneDevice(mocks);
+
+    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
+
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_6));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_6, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .SetReturn(IOTHUB_MESSAGE_ERROR);
+
+    DISABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -14728,12 +12902,12 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
     IoTHubTransportHttp_Destroy(handle);
 }
 
-//Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING_concat_with_STRING_fails_it_fails)
+//Tests_SRS_TRANSPORTMULTITHTTP_17_075: [ If the oldest message in waitingToSend causes the message to exceed the message size limit then it shall be removed from waitingToSend, and IoTHubClient_LL_SendComplete shall be called. Parameter PDLIST_ENTRY completed shall point to a list containing only the oldest item, and parameter IOTHUB_BATCHSTATE result shall be set to IOTHUB_CLIENT_CONFIRMATION_ERROR. ]
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_1_property_unbatched_overlimit_calls_SendComplete_with_BATCHSTATE_FAILED)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
-    DList_InsertTailList(&(waitingToSend), &(message10.entry));
+    DList_InsertTailList(&(waitingToSend), &(message9.entry));
     auto handle = IoTHubTransportHttp_Create(&TEST_CONFIG);
     (void)IoTHubTransportHttp_Register(handle, &TEST_DEVICE_1, TEST_IOTHUB_CLIENT_LL_HANDLE, TEST_CONFIG.waitingToSend);
 
@@ -14741,36 +12915,25 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
 
     setupDoWorkLoopOnceForOneDevice(mocks);
 
-    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
-
-    STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
-        .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_IsListEmpty(&waitingToSend));
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE_9));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE_9, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3);
 
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    /*ooops - over 256K*/
 
-        whenShallSTRING_concat_with_STRING_fail = currentSTRING_concat_with_STRING_call + 1;
-        STRICT_EXPECTED_CALL(mocks, STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        /*end of the first batched payload*/
-    }
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message9.entry)))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_ERROR))
+        .IgnoreArgument(2);
 
-    ENABLE_BATCHING();
+    DISABLE_BATCHING();
 
     ///act
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
@@ -14782,8 +12945,10 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
     IoTHubTransportHttp_Destroy(handle);
 }
 
+#define TEST_1_ITEM_AS_STRING "[{\"body\":\"thisgoestoJ\\\\s\\/\\/on\\\"ToBeEn\\u000D\\u000A\\u0008coded\",\"base64Encoded\":false}]"
+
 //Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING_new_JSON_fails_it_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_happy_path_succeeds)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14800,24 +12965,43 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
+    /*measuring the batch*/
+    setupBatchedItemQuery(mocks, message10.messageHandle, IOTHUBMESSAGE_STRING, TEST_MAP_EMPTY);
+
+    /*building the list of messages to be notified if HTTP is fine*/
+    STRICT_EXPECTED_CALL(mocks, DList_RemoveHeadList(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, DList_InsertTailList(IGNORED_PTR_ARG, &(message10.entry)))
         .IgnoreArgument(1);
 
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
+    /*serializing the batch straight into the HTTP payload*/
+    setupBatchedPayloadBuffer(mocks);
+    setupBatchedItemQuery(mocks, message10.messageHandle, IOTHUBMESSAGE_STRING, TEST_MAP_EMPTY);
+
+    /*executing HTTP goodies*/
+    STRICT_EXPECTED_CALL(mocks, STRING_c_str(IGNORED_PTR_ARG)) /*because relativePath*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, HTTPAPIEX_SAS_ExecuteRequest2(
+        IGNORED_PTR_ARG,                                    /*sasObject handle                                             */
+        IGNORED_PTR_ARG,
+        HTTPAPI_REQUEST_POST,                                                           /*HTTPAPI_REQUEST_TYPE requestType,                  */
+        "/devices/" TEST_DEVICE_ID EVENT_ENDPOINT API_VERSION,                 /*const char* relativePath,                          */
+        IGNORED_PTR_ARG,                                                                /*HTTP_HEADERS_HANDLE requestHttpHeadersHandle,      */
+        IGNORED_PTR_ARG,                                                                /*BUFFER_HANDLE requestContent,                      */
+        IGNORED_PTR_ARG,                                                                /*unsigned int* statusCode,                          */
+        NULL,                                                                           /*HTTP_HEADERS_HANDLE responseHttpHeadersHandle,     */
+        NULL                                                                            /*BUFFER_HANDLE responseContent)                     */
+        ))
+        .IgnoreArgument(1)
+        .IgnoreArgument(2)
+        .IgnoreArgument(5)
+        .IgnoreArgument(6)
+        .CopyOutArgumentBuffer(7, &httpStatus200, sizeof(httpStatus200));
 
-        whenShallSTRING_new_JSON_fail = currentSTRING_new_JSON_call + 1;
-        STRICT_EXPECTED_CALL(mocks, STRING_new_JSON(string10));
+    /*once the event has been succesfull...*/
 
-        /*end of the first batched payload*/
-    }
+    STRICT_EXPECTED_CALL(mocks, IoTHubClient_LL_SendComplete(TEST_IOTHUB_CLIENT_LL_HANDLE, IGNORED_PTR_ARG, IOTHUB_CLIENT_CONFIRMATION_OK))
+        .IgnoreArgument(2);
 
     ENABLE_BATCHING();
 
@@ -14825,6 +13009,8 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
     IoTHubTransportHttp_DoWork(handle, TEST_IOTHUB_CLIENT_LL_HANDLE);
 
     ///assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(TEST_1_ITEM_AS_STRING) - 1, BASEIMPLEMENTATION::BUFFER_length(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BASEIMPLEMENTATION::BUFFER_u_char(last_BUFFER_HANDLE_to_HTTPAPIEX_ExecuteRequest), TEST_1_ITEM_AS_STRING, sizeof(TEST_1_ITEM_AS_STRING) - 1));
     mocks.AssertActualAndExpectedCalls();
 
     ///cleanup
@@ -14832,7 +13018,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_IoTHubMessage_GetString_it_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_Map_GetInternals_fails_it_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14849,22 +13035,15 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_IoTHub
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-        STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle))
-            .SetReturn((const char*)NULL);
-
-        /*end of the first batched payload*/
-    }
+    /*measuring the batch*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_Properties(message10.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, Map_GetInternals(TEST_MAP_EMPTY, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(2)
+        .IgnoreArgument(3)
+        .IgnoreArgument(4)
+        .SetReturn(MAP_ERROR);
 
     ENABLE_BATCHING();
 
@@ -14879,7 +13058,7 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_IoTHub
 }
 
 //Tests_SRS_TRANSPORTMULTITHTTP_17_057: [ If a messages to be send has type IOTHUBMESSAGE_STRING, then its serialization shall be {"body":"JSON encoding of the string", "base64Encoded":false} ]
-TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING_construct_it_fails)
+TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_IoTHubMessage_GetString_it_fails)
 {
     ///arrange
     CIoTHubTransportHttpMocks mocks;
@@ -14896,19 +13075,10 @@ TEST_FUNCTION(IoTHubTransportHttp_DoWork_with_1_event_item_as_string_when_STRING
     STRICT_EXPECTED_CALL(mocks, HTTPHeaders_ReplaceHeaderNameValuePair(IGNORED_PTR_ARG, "Content-Type", "application/vnd.microsoft.iothub.json"))
         .IgnoreArgument(1);
 
-    /*starting to prepare the "big" payload*/
-    STRICT_EXPECTED_CALL(mocks, STRING_construct("["));
-    STRICT_EXPECTED_CALL(mocks, STRING_delete(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
-
-    /*this is first batched payload*/
-    {
-        STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
-        whenShallSTRING_construct_fail = currentSTRING_construct_call + 2;
-        STRICT_EXPECTED_CALL(mocks, STRING_construct("{\"body\":"));
-
-        /*end of the first batched payload*/
-    }
+    /*measuring the batch*/
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetContentType(message10.messageHandle));
+    STRICT_EXPECTED_CALL(mocks, IoTHubMessage_GetString(message10.messageHandle))
+        .SetReturn((const char*)NULL);
 
     ENABLE_BATCHING();
 
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #endif
+#include <string.h>
 
 void* real_malloc(size_t size)
 {
@@ -100,6 +101,63 @@ int test_amqpvalue_get_string(AMQP_VALUE value, const char** string_value)
 }
 
 
+static size_t append_test_string(unsigned char* buffer, const char* value)
+{
+	size_t length = strlen(value);
+	buffer[0] = 0xa1; // str8-utf8
+	buffer[1] = (unsigned char)length;
+	(void)memcpy(buffer + 2, value, length);
+	return length + 2;
+}
+
+static size_t encode_test_application_properties(unsigned char* buffer, size_t number_of_properties)
+{
+	size_t size = 6;
+	size_t i;
+
+	for (i = 0; i < number_of_properties; i++)
+	{
+		size += append_test_string(buffer + size, TEST_MAP_KEYS[i]);
+		size += append_test_string(buffer + size, TEST_MAP_VALUES[i]);
+	}
+
+	buffer[0] = 0x00; // described
+	buffer[1] = 0x53; // smallulong
+	buffer[2] = 0x74; // application-properties
+	buffer[3] = 0xc1; // map8
+	buffer[4] = (unsigned char)(size - 5);
+	buffer[5] = (unsigned char)(2 * number_of_properties);
+	return size;
+}
+
+static size_t encode_test_data_section(unsigned char* buffer, const char* content)
+{
+	size_t length = strlen(content);
+	buffer[0] = 0x00; // described
+	buffer[1] = 0x53; // smallulong
+	buffer[2] = 0x75; // data
+	buffer[3] = 0xa0; // vbin8
+	buffer[4] = (unsigned char)length;
+	(void)memcpy(buffer + 5, content, length);
+	return length + 5;
+}
+
+static unsigned char TEST_encoded_application_properties[512];
+static size_t TEST_encoded_application_properties_length;
+
+int test_amqpvalue_get_encoded_size(AMQP_VALUE value, size_t* encoded_size)
+{
+	(void)value;
+	*encoded_size = TEST_encoded_application_properties_length;
+	return 0;
+}
+
+int test_amqpvalue_encode(AMQP_VALUE value, AMQP_ENCODER_OUTPUT encoder_output, void* context)
+{
+	(void)value;
+	return encoder_output(context, TEST_encoded_application_properties, TEST_encoded_application_properties_length);
+}
+
 // Helpers to set EXPECTED_CALLS
 void set_exp_calls_for_addPropertiesTouAMQPMessage(bool has_message_id, bool has_correlation_id, bool message_handle_has_properties)
 {
@@ -198,7 +256,22 @@ static void set_exp_calls_for_message_create_from_iothub_message(size_t number_o
 	set_exp_calls_for_addApplicationPropertiesTouAMQPMessage(number_of_app_properties);
 }
 
-static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(size_t number_of_properties, bool has_message_id, bool has_correlation_id, bool has_properties)
+static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(size_t number_of_app_properties, const char* message_id, const char* correlation_id)
+{
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(IOTHUBMESSAGE_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetString(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+		.CopyOutArgumentBuffer_keys(&TEST_MAP_KEYS, sizeof(char**))
+		.CopyOutArgumentBuffer_values(&TEST_MAP_VALUES, sizeof(char**))
+		.CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(size_t));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(message_id);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(correlation_id);
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG)).IgnoreArgument(1);
+}
+
+static void set_exp_calls_for_reading_uamqp_message_properties(bool has_message_id, bool has_correlation_id)
 {
 	static BINARY_DATA test_binary_data;
 	test_binary_data.bytes = (const unsigned char*)&TEST_STRING;
@@ -249,33 +322,35 @@ static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(size_t number
 
 	// readApplicationPropertiesFromuAMQPMessage
 	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_MAP_HANDLE);
+}
+
+static void set_exp_calls_for_decoding_application_properties(void)
+{
+	STRICT_EXPECTED_CALL(message_get_application_properties(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+		.IgnoreArgument(2)
+		.CopyOutArgumentBuffer_application_properties(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
+	STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(TEST_AMQP_VALUE, IGNORED_PTR_ARG)).IgnoreArgument(2);
+	STRICT_EXPECTED_CALL(malloc(TEST_encoded_application_properties_length + 1));
+	STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).IgnoreArgument(2).IgnoreArgument(3);
+}
+
+static void set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(size_t number_of_properties, bool has_message_id, bool has_correlation_id, bool has_properties)
+{
+	set_exp_calls_for_reading_uamqp_message_properties(has_message_id, has_correlation_id);
 
 	if (has_properties)
 	{
-		STRICT_EXPECTED_CALL(message_get_application_properties(TEST_MESSAGE_HANDLE, IGNORED_PTR_ARG))
-			.IgnoreArgument(2)
-			.CopyOutArgumentBuffer_application_properties(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
-		STRICT_EXPECTED_CALL(amqpvalue_get_inplace_described_value(TEST_AMQP_VALUE));
-		STRICT_EXPECTED_CALL(amqpvalue_get_map_pair_count(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-			.IgnoreArgument(2)
-			.CopyOutArgumentBuffer_pair_count((uint32_t *)&number_of_properties, sizeof(uint32_t));
-
 		size_t i;
+
+		TEST_encoded_application_properties_length = encode_test_application_properties(TEST_encoded_application_properties, number_of_properties);
+		set_exp_calls_for_decoding_application_properties();
+
 		for (i = 0; i < number_of_properties; i++)
 		{
-			STRICT_EXPECTED_CALL(amqpvalue_get_map_key_value_pair(TEST_AMQP_VALUE, (uint32_t)i, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-				.IgnoreArgument_key().IgnoreArgument_value()
-				.CopyOutArgumentBuffer_key(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE))
-				.CopyOutArgumentBuffer_value(&TEST_AMQP_VALUE2, sizeof(AMQP_VALUE));
-			STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-				.IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_KEYS[i], sizeof(char*));
-			STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
-				.IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_VALUES[i], sizeof(char*));
 			STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, TEST_MAP_KEYS[i], TEST_MAP_VALUES[i]));
-			STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
-			STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
 		}
 
+		EXPECTED_CALL(free(IGNORED_PTR_ARG));
 		STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
 	}
 	else
@@ -310,6 +385,14 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_UMOCK_ALIAS_TYPE(AMQP_VALUE, void*);
 	REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
 	REGISTER_UMOCK_ALIAS_TYPE(AMQP_TYPE, int);
+	REGISTER_UMOCK_ALIAS_TYPE(AMQP_ENCODER_OUTPUT, void*);
+
+	REGISTER_GLOBAL_MOCK_HOOK(malloc, real_malloc);
+	REGISTER_GLOBAL_MOCK_HOOK(free, real_free);
+	REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_get_encoded_size, test_amqpvalue_get_encoded_size);
+	REGISTER_GLOBAL_MOCK_HOOK(amqpvalue_encode, test_amqpvalue_encode);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_encoded_size, 1);
+	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_encode, 1);
 
 	REGISTER_GLOBAL_MOCK_HOOK(properties_get_message_id, test_properties_get_message_id);
 	REGISTER_GLOBAL_MOCK_HOOK(properties_get_correlation_id, test_properties_get_correlation_id);
@@ -348,15 +431,6 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 	REGISTER_GLOBAL_MOCK_RETURN(message_get_application_properties, 0);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_get_application_properties, 1);
 	
-	REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_map_pair_count, 0);
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_map_pair_count, 1);
-
-	REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_inplace_described_value, TEST_AMQP_VALUE);
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_inplace_described_value, NULL);
-
-	REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_map_key_value_pair, 0);
-	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_map_key_value_pair, 1);
-
 	REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_string, 0);
 	REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_string, 1);
 	
@@ -693,14 +767,9 @@ TEST_FUNCTION(message_create_from_iothub_message_STRING_return_errors_fails)
 // Tests_SRS_UAMQP_MESSAGING_09_026: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message properties (obtained with message_get_properties()) by calling properties_destroy().]
 // Tests_SRS_UAMQP_MESSAGING_09_027: [The IOTHUB_MESSAGE_HANDLE properties shall be retrieved using IoTHubMessage_Properties.]
 // Tests_SRS_UAMQP_MESSAGING_09_029: [The uAMQP message application properties shall be retrieved using message_get_application_properties.]
-// Tests_SRS_UAMQP_MESSAGING_09_032: [The actual uAMQP message application properties should be extracted from the result of message_get_application_properties using amqpvalue_get_inplace_described_value.]
-// Tests_SRS_UAMQP_MESSAGING_09_034: [The number of items in the uAMQP message application properties shall be obtained using amqpvalue_get_map_pair_count.]
-// Tests_SRS_UAMQP_MESSAGING_09_036: [IoTHubMessage_CreateFromuAMQPMessage() shall iterate through each uAMQP application property and add it to IOTHUB_MESSAGE_HANDLE properties.]
-// Tests_SRS_UAMQP_MESSAGING_09_037: [The uAMQP application property name and value shall be obtained using amqpvalue_get_map_key_value_pair.]
-// Tests_SRS_UAMQP_MESSAGING_09_039: [The uAMQP application property name shall be extracted as string using amqpvalue_get_string.]
-// Tests_SRS_UAMQP_MESSAGING_09_041: [The uAMQP application property value shall be extracted as string using amqpvalue_get_string.]
-// Tests_SRS_UAMQP_MESSAGING_09_043: [The application property name and value shall be added to IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate.]
-// Tests_SRS_UAMQP_MESSAGING_09_045: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property name and value (obtained with amqpvalue_get_string) by calling amqpvalue_destroy().]
+// Tests_SRS_UAMQP_MESSAGING_01_007: [The encoded size of the uAMQP message application properties shall be obtained using amqpvalue_get_encoded_size.]
+// Tests_SRS_UAMQP_MESSAGING_01_009: [The application properties shall be encoded with amqpvalue_encode into a single buffer, allocated with one spare byte so the property strings can be terminated in place.]
+// Tests_SRS_UAMQP_MESSAGING_01_011: [The encoded map shall be parsed in a single pass, adding each name and value directly to the IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate, without creating an AMQP_VALUE per property.]
 // Tests_SRS_UAMQP_MESSAGING_09_046: [IoTHubMessage_CreateFromuAMQPMessage() shall destroy the uAMQP message property (obtained with message_get_application_properties) by calling amqpvalue_destroy().]
 TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_success)
 {
@@ -770,12 +839,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_correlation_id_success)
 // Tests_SRS_UAMQP_MESSAGING_09_025: [If IoTHubMessage_SetCorrelationId fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_028: [If IoTHubMessage_Properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 // Tests_SRS_UAMQP_MESSAGING_09_030: [If message_get_application_properties fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_033: [If amqpvalue_get_inplace_described_value fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_035: [If amqpvalue_get_map_pair_count fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_038: [If amqpvalue_get_map_key_value_pair fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_040: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_042: [If amqpvalue_get_string fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
-// Tests_SRS_UAMQP_MESSAGING_09_044: [If Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
 TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_error_returns_fails)
 {
 	// arrange
@@ -813,4 +876,263 @@ TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_no_app_properties_success)
 	// cleanup
 }
 
+// Tests_SRS_UAMQP_MESSAGING_01_011: [The encoded map shall be parsed in a single pass, adding each name and value directly to the IOTHUB_MESSAGE_HANDLE properties using Map_AddOrUpdate, without creating an AMQP_VALUE per property.]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_multiple_app_properties_success)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	set_exp_calls_for_IoTHubMessage_CreateFromUamqpMessage(5, true, true, true);
+
+	// act
+	IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+	int result = IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, result, 0);
+	ASSERT_ARE_EQUAL(void_ptr, (void*)iothub_client_message, (void*)TEST_IOTHUB_MESSAGE_HANDLE);
+
+	// cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_012: [If the map is malformed, holds a non-string name or value, or Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_non_string_property_value_fails)
+{
+	// arrange
+	static const unsigned char int_property_value[] = { 0x00, 0x53, 0x74, 0xc1, 0x09, 0x02, 0xa1, 0x01, 'k', 0x71, 0x00, 0x00, 0x00, 0x01 };
+
+	umock_c_reset_all_calls();
+	set_exp_calls_for_reading_uamqp_message_properties(true, true);
+	(void)memcpy(TEST_encoded_application_properties, int_property_value, sizeof(int_property_value));
+	TEST_encoded_application_properties_length = sizeof(int_property_value);
+	set_exp_calls_for_decoding_application_properties();
+	EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(TEST_IOTHUB_MESSAGE_HANDLE));
+
+	// act
+	IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+	int result = IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, result, 0);
+	ASSERT_IS_NULL(iothub_client_message);
+
+	// cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_012: [If the map is malformed, holds a non-string name or value, or Map_AddOrUpdate fails, IoTHubMessage_CreateFromuAMQPMessage() shall fail and return immediately.]
+TEST_FUNCTION(IoTHubMessage_CreateFromUamqpMessage_Map_AddOrUpdate_fails)
+{
+	// arrange
+	umock_c_reset_all_calls();
+	set_exp_calls_for_reading_uamqp_message_properties(true, true);
+	TEST_encoded_application_properties_length = encode_test_application_properties(TEST_encoded_application_properties, 2);
+	set_exp_calls_for_decoding_application_properties();
+	STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, TEST_MAP_KEYS[0], TEST_MAP_VALUES[0])).SetReturn(MAP_ERROR);
+	EXPECTED_CALL(free(IGNORED_PTR_ARG));
+	STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_Destroy(TEST_IOTHUB_MESSAGE_HANDLE));
+
+	// act
+	IOTHUB_MESSAGE_HANDLE iothub_client_message = NULL;
+	int result = IoTHubMessage_CreateFromUamqpMessage(TEST_MESSAGE_HANDLE, &iothub_client_message);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, result, 0);
+	ASSERT_IS_NULL(iothub_client_message);
+
+	// cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_001: [The content of the IOTHUB_MESSAGE_HANDLE instance shall be obtained with IoTHubMessage_GetByteArray() or IoTHubMessage_GetString(), depending on its content type.]
+// Tests_SRS_UAMQP_MESSAGING_01_002: [The message properties shall be read directly from the internals of the map returned by IoTHubMessage_Properties(), using Map_GetInternals().]
+// Tests_SRS_UAMQP_MESSAGING_01_003: [The properties, application-properties and data sections shall be written directly in AMQP wire format, without creating any intermediate AMQP_VALUE; the properties and application-properties sections shall be omitted when empty.]
+// Tests_SRS_UAMQP_MESSAGING_01_004: [The encoded size shall be computed first, so the sections are written into a single buffer allocated for their exact size, which shall be returned in `body_binary_data` and released by the caller with free().]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_success)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+	unsigned char expected_bytes[512];
+	size_t expected_length;
+
+	expected_bytes[0] = 0x00; // described
+	expected_bytes[1] = 0x53; // smallulong
+	expected_bytes[2] = 0x73; // properties
+	expected_bytes[3] = 0xc0; // list8
+	expected_bytes[4] = (unsigned char)(strlen(TEST_STRING) + 3);
+	expected_bytes[5] = 1; // message-id only
+	expected_length = 6 + append_test_string(expected_bytes + 6, TEST_STRING);
+	expected_length += encode_test_application_properties(expected_bytes + expected_length, 2);
+	expected_length += encode_test_data_section(expected_bytes + expected_length, TEST_STRING);
+
+	umock_c_reset_all_calls();
+	set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(2, TEST_STRING, NULL);
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(size_t, expected_length, encoded_event.length);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, encoded_event.bytes, expected_length));
+
+	// cleanup
+	real_free((void*)encoded_event.bytes);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_003: [The properties, application-properties and data sections shall be written directly in AMQP wire format, without creating any intermediate AMQP_VALUE; the properties and application-properties sections shall be omitted when empty.]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_correlation_id_only_success)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+	unsigned char expected_bytes[512];
+	size_t expected_length;
+
+	expected_bytes[0] = 0x00; // described
+	expected_bytes[1] = 0x53; // smallulong
+	expected_bytes[2] = 0x73; // properties
+	expected_bytes[3] = 0xc0; // list8
+	expected_bytes[4] = (unsigned char)(strlen(TEST_STRING) + 8);
+	expected_bytes[5] = 6; // up to correlation-id
+	(void)memset(expected_bytes + 6, 0x40, 5); // message-id, user-id, to, subject and reply-to are null
+	expected_length = 11 + append_test_string(expected_bytes + 11, TEST_STRING);
+	expected_length += encode_test_data_section(expected_bytes + expected_length, TEST_STRING);
+
+	umock_c_reset_all_calls();
+	set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(0, NULL, TEST_STRING);
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(size_t, expected_length, encoded_event.length);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, encoded_event.bytes, expected_length));
+
+	// cleanup
+	real_free((void*)encoded_event.bytes);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_003: [The properties, application-properties and data sections shall be written directly in AMQP wire format, without creating any intermediate AMQP_VALUE; the properties and application-properties sections shall be omitted when empty.]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_no_properties_success)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+	unsigned char expected_bytes[512];
+	size_t expected_length;
+
+	expected_length = encode_test_data_section(expected_bytes, TEST_STRING);
+
+	umock_c_reset_all_calls();
+	set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(0, NULL, NULL);
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(size_t, expected_length, encoded_event.length);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, encoded_event.bytes, expected_length));
+
+	// cleanup
+	real_free((void*)encoded_event.bytes);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_001: [The content of the IOTHUB_MESSAGE_HANDLE instance shall be obtained with IoTHubMessage_GetByteArray() or IoTHubMessage_GetString(), depending on its content type.]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_large_bytearray_success)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+	unsigned char content[300];
+	const unsigned char* content_ptr = content;
+	size_t content_size = sizeof(content);
+	size_t number_of_app_properties = 0;
+	static const unsigned char expected_header[] = { 0x00, 0x53, 0x75, 0xb0, 0x00, 0x00, 0x01, 0x2c }; // data section as vbin32
+
+	(void)memset(content, 0x5A, sizeof(content));
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(IOTHUBMESSAGE_BYTEARRAY);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).IgnoreArgument(3)
+		.CopyOutArgumentBuffer_buffer(&content_ptr, sizeof(content_ptr))
+		.CopyOutArgumentBuffer_size(&content_size, sizeof(content_size))
+		.SetReturn(IOTHUB_MESSAGE_OK);
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4)
+		.CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(size_t));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(NULL);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(NULL);
+	STRICT_EXPECTED_CALL(malloc(sizeof(expected_header) + sizeof(content)));
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_EQUAL(int, 0, result);
+	ASSERT_ARE_EQUAL(size_t, sizeof(expected_header) + sizeof(content), encoded_event.length);
+	ASSERT_ARE_EQUAL(int, 0, memcmp(expected_header, encoded_event.bytes, sizeof(expected_header)));
+	ASSERT_ARE_EQUAL(int, 0, memcmp(content, encoded_event.bytes + sizeof(expected_header), sizeof(content)));
+
+	// cleanup
+	real_free((void*)encoded_event.bytes);
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_005: [If any failure occurs, message_create_uamqp_encoding_from_iothub_message() shall free everything it allocated and return a non-zero value.]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_malloc_fails)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(IOTHUBMESSAGE_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetString(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(TEST_IOTHUB_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(NULL);
+	STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG)).IgnoreArgument(1).SetReturn(NULL);
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+	// cleanup
+}
+
+// Tests_SRS_UAMQP_MESSAGING_01_005: [If any failure occurs, message_create_uamqp_encoding_from_iothub_message() shall free everything it allocated and return a non-zero value.]
+TEST_FUNCTION(message_create_uamqp_encoding_from_iothub_message_Map_GetInternals_fails)
+{
+	// arrange
+	BINARY_DATA encoded_event;
+
+	umock_c_reset_all_calls();
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(IOTHUBMESSAGE_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_GetString(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_STRING);
+	STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE));
+	STRICT_EXPECTED_CALL(Map_GetInternals(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+		.IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4).SetReturn(MAP_ERROR);
+
+	// act
+	int result = message_create_uamqp_encoding_from_iothub_message(TEST_IOTHUB_MESSAGE_HANDLE, &encoded_event);
+
+	// assert
+	ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+	ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+	// cleanup
+}
+
 END_TEST_SUITE(uamqp_messaging_ut)
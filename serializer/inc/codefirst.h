@@ -10,6 +10,7 @@
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/strings.h"
 #include "iotdevice.h"
+#include "jsonencoder.h"
 
 
 
@@ -112,9 +113,21 @@ typedef struct REFLECTION_DESIRED_PROPERTY_TAG
     const char* modelName;
 } REFLECTION_DESIRED_PROPERTY;
 
+/*a WITH_DATA property as SERIALIZE writes it without going through Device: jsonName is "\"name\":"*/
+typedef struct REFLECTION_JSON_PROPERTY_TAG
+{
+    const char* jsonName;
+    size_t jsonNameLength;
+    size_t offset;
+    JSON_ENCODER_TOJSON_FUNC ToJSON;
+} REFLECTION_JSON_PROPERTY;
+
+typedef const REFLECTION_JSON_PROPERTY*(*pfGetJSONProperties)(size_t* jsonPropertyCount);
+
 typedef struct REFLECTION_MODEL_TAG
 {
     const char* name;
+    pfGetJSONProperties getJSONProperties; /*the model's WITH_DATA properties, in declaration order*/
 } REFLECTION_MODEL;
 
 typedef struct REFLECTED_SOMETHING_TAG
@@ -182,6 +195,7 @@ extern CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t*
 extern CODEFIRST_RESULT CodeFirst_SendAsyncReported(unsigned char** destination, size_t* destinationSize, size_t numReportedProperties, ...);
 
 MOCKABLE_FUNCTION(, CODEFIRST_RESULT, CodeFirst_IngestDesiredProperties, void*, device, const char*, desiredProperties);
+MOCKABLE_FUNCTION(, CODEFIRST_RESULT, CodeFirst_IngestDesiredPropertiesInPlace, void*, device, char*, jsonPayload, bool, parseDesiredNode);
 
 MOCKABLE_FUNCTION(, AGENT_DATA_TYPE_TYPE, CodeFirst_GetPrimitiveType, const char*, typeName);
 
@@ -4,6 +4,7 @@
 #ifndef COMMAND_DECODER_H
 #define COMMAND_DECODER_H
 
+#include <stdbool.h>
 #include "multitree.h"
 #include "schema.h"
 #include "agenttypesystem.h"
@@ -43,6 +44,7 @@ MOCKABLE_FUNCTION(, METHODRETURN_HANDLE, CommandDecoder_ExecuteMethod, COMMAND_D
 MOCKABLE_FUNCTION(,void, CommandDecoder_Destroy, COMMAND_DECODER_HANDLE, commandDecoderHandle);
 
 MOCKABLE_FUNCTION(, EXECUTE_COMMAND_RESULT, CommandDecoder_IngestDesiredProperties, void*, startAddress, COMMAND_DECODER_HANDLE, handle, const char*, desiredProperties);
+MOCKABLE_FUNCTION(, EXECUTE_COMMAND_RESULT, CommandDecoder_IngestDesiredPropertiesInPlace, void*, startAddress, COMMAND_DECODER_HANDLE, handle, char*, jsonPayload, bool, parseDesiredNode);
 
 #ifdef __cplusplus
 }
@@ -50,6 +50,7 @@ MOCKABLE_FUNCTION(, EXECUTE_COMMAND_RESULT, Device_ExecuteCommand, DEVICE_HANDLE
 MOCKABLE_FUNCTION(, METHODRETURN_HANDLE, Device_ExecuteMethod, DEVICE_HANDLE, deviceHandle, const char*, methodName, const char*, methodPayload);
 
 MOCKABLE_FUNCTION(, DEVICE_RESULT, Device_IngestDesiredProperties, void*, startAddress, DEVICE_HANDLE, deviceHandle, const char*, desiredProperties);
+MOCKABLE_FUNCTION(, DEVICE_RESULT, Device_IngestDesiredPropertiesInPlace, void*, startAddress, DEVICE_HANDLE, deviceHandle, char*, jsonPayload, bool, parseDesiredNode);
 #ifdef __cplusplus
 }
 #endif
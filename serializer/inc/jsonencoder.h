@@ -9,9 +9,12 @@
 
 #ifdef __cplusplus
 #include "cstddef"
+#include "cstdint"
 extern "C" {
 #else
 #include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
 #endif
 
 #include "multitree.h"
@@ -22,7 +25,8 @@ JSON_ENCODER_INVALID_ARG,                    \
 JSON_ENCODER_ALREADY_EXISTS,                 \
 JSON_ENCODER_MULTITREE_ERROR,                \
 JSON_ENCODER_TOSTRING_FUNCTION_ERROR,        \
-JSON_ENCODER_ERROR                          
+JSON_ENCODER_ERROR,                          \
+JSON_ENCODER_VALUE_NOT_SUPPORTED
 
 DEFINE_ENUM(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
 
@@ -35,11 +39,32 @@ DEFINE_ENUM(JSON_ENCODER_TOSTRING_RESULT, JSON_ENCODER_TOSTRING_RESULT_VALUES);
 
 typedef JSON_ENCODER_TOSTRING_RESULT(*JSON_ENCODER_TOSTRING_FUNC)(STRING_HANDLE, const void* value);
 
+/*a JSON object written directly into a growable buffer, without building a MULTITREE first. buffer is not '\0' terminated*/
+typedef struct JSON_ENCODER_BUFFER_TAG
+{
+    unsigned char* buffer;
+    size_t size;
+    size_t capacity;
+    size_t memberCount;
+} JSON_ENCODER_BUFFER;
+
+typedef JSON_ENCODER_RESULT(*JSON_ENCODER_TOJSON_FUNC)(JSON_ENCODER_BUFFER* destination, const void* value);
+
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 MOCKABLE_FUNCTION(, JSON_ENCODER_TOSTRING_RESULT, JSONEncoder_CharPtr_ToString, STRING_HANDLE, destination, const void*, value);
 MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_EncodeTree, MULTITREE_HANDLE, treeHandle, STRING_HANDLE, destination, JSON_ENCODER_TOSTRING_FUNC, toStringFunc);
 
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_BeginObject, JSON_ENCODER_BUFFER*, destination);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteMemberName, JSON_ENCODER_BUFFER*, destination, const char*, jsonName, size_t, jsonNameLength);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteInt64, JSON_ENCODER_BUFFER*, destination, int64_t, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteBool, JSON_ENCODER_BUFFER*, destination, bool, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteDouble, JSON_ENCODER_BUFFER*, destination, double, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteFloat, JSON_ENCODER_BUFFER*, destination, float, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteString, JSON_ENCODER_BUFFER*, destination, const char*, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_WriteStringNoQuotes, JSON_ENCODER_BUFFER*, destination, const char*, value);
+MOCKABLE_FUNCTION(, JSON_ENCODER_RESULT, JSONEncoder_EndObject, JSON_ENCODER_BUFFER*, destination);
+
 #ifdef __cplusplus
 }
 #endif
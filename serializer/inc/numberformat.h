@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef NUMBERFORMAT_H
+#define NUMBERFORMAT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/*"-9223372036854775808" and '\0'*/
+#define NUMBER_FORMAT_INT64_BUFFER_SIZE 21
+
+/*the longest output is a sign, "0.", 5 zeroes and 17 significant digits, then '\0'*/
+#define NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE 26
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+MOCKABLE_FUNCTION(, size_t, NumberFormat_UInt64, char*, destination, uint64_t, value, size_t, minimumDigits);
+MOCKABLE_FUNCTION(, size_t, NumberFormat_Int64, char*, destination, int64_t, value);
+
+#ifndef NO_FLOATS
+MOCKABLE_FUNCTION(, size_t, NumberFormat_Double, char*, destination, double, value);
+MOCKABLE_FUNCTION(, size_t, NumberFormat_Float, char*, destination, float, value);
+#endif
+
+MOCKABLE_FUNCTION(, int, NumberFormat_ParseDoubleFastPath, const char*, source, double*, value);
+MOCKABLE_FUNCTION(, int, NumberFormat_ParseFloatFastPath, const char*, source, float*, value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*NUMBERFORMAT_H*/
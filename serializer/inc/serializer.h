@@ -139,6 +139,13 @@ extern "C"
     { \
         FOR_EACH_2_KEEP_2(GLOBAL_DEINITIALIZE_STRUCT_FIELD, name, destination, __VA_ARGS__); \
     } \
+    /*Codes_SRS_SERIALIZER_H_01_004: [ A WITH_DATA property whose type is a struct, a model or one of EDM_DATE_TIME_OFFSET, EDM_GUID and EDM_BINARY shall make SERIALIZE go through Device. ]*/ \
+    static JSON_ENCODER_RESULT C2(ToJSON_, name)(JSON_ENCODER_BUFFER* destination, const void* value) \
+    { \
+        (void)destination; \
+        (void)value; \
+        return JSON_ENCODER_VALUE_NOT_SUPPORTED; \
+    } \
 
 
 /**
@@ -170,6 +177,7 @@ extern "C"
 #define SERIALIZER_REGISTER_NAMESPACE(NAMESPACE) CodeFirst_RegisterSchema(#NAMESPACE, & ALL_REFLECTED(NAMESPACE))
 
 #define DECLARE_MODEL(name, ...)                                                             \
+    static const REFLECTION_JSON_PROPERTY* C2(GetJSONProperties_, name)(size_t* jsonPropertyCount); \
     REFLECTED_MODEL(name)                                                                    \
     FOR_EACH_1(CREATE_DESIRED_PROPERTY_CALLBACK, __VA_ARGS__)                                \
     typedef struct name { int :1; FOR_EACH_1(BUILD_MODEL_STRUCT, __VA_ARGS__) } name;        \
@@ -192,6 +200,20 @@ extern "C"
         (void)destination;                                                                   \
         FOR_EACH_1_KEEP_1(CREATE_MODEL_ELEMENT_GLOBAL_DEINITIALIZE, name, __VA_ARGS__)       \
     }                                                                                        \
+    /*Codes_SRS_SERIALIZER_H_01_005: [ DECLARE_MODEL shall generate a table of the model's WITH_DATA properties, in declaration order, holding for each the quoted name followed by ':', the offset in the model struct and the function that writes the value as JSON. ]*/ \
+    static const REFLECTION_JSON_PROPERTY* C2(GetJSONProperties_, name)(size_t* jsonPropertyCount) \
+    {                                                                                        \
+        static const REFLECTION_JSON_PROPERTY jsonProperties[] = { FOR_EACH_1_KEEP_1(CREATE_MODEL_ELEMENT_JSON_PROPERTY, name, __VA_ARGS__) { NULL, 0, 0, NULL } }; \
+        *jsonPropertyCount = sizeof(jsonProperties) / sizeof(jsonProperties[0]) - 1;       \
+        return jsonProperties;                                                               \
+    }                                                                                        \
+    /*Codes_SRS_SERIALIZER_H_01_004: [ A WITH_DATA property whose type is a struct, a model or one of EDM_DATE_TIME_OFFSET, EDM_GUID and EDM_BINARY shall make SERIALIZE go through Device. ]*/ \
+    static JSON_ENCODER_RESULT C2(ToJSON_, name)(JSON_ENCODER_BUFFER* destination, const void* value) \
+    {                                                                                        \
+        (void)destination;                                                                   \
+        (void)value;                                                                         \
+        return JSON_ENCODER_VALUE_NOT_SUPPORTED;                                             \
+    }                                                                                        \
 
     
 
@@ -444,7 +466,7 @@ Actions are discarded, since no marshalling will be done for those when sending
 #define REFLECTED_FIELD(XstructName, XfieldType, XfieldName) \
     static const REFLECTED_SOMETHING C2(REFLECTED_, C1(INC(__COUNTER__))) = { REFLECTION_FIELD_TYPE,                &C2(REFLECTED_, C1(DEC(DEC(__COUNTER__)))), { {0}, {0}, {0}, {0}, {TOSTRING(XfieldName), TOSTRING(XfieldType), TOSTRING(XstructName)}, {0}, {0}, {0} } };
 #define REFLECTED_MODEL(name) \
-    static const REFLECTED_SOMETHING C2(REFLECTED_, C1(INC(__COUNTER__))) = { REFLECTION_MODEL_TYPE,                &C2(REFLECTED_, C1(DEC(DEC(__COUNTER__)))), { {0}, {0}, {0}, {0}, {0}, {0}, {0}, {TOSTRING(name)} } };
+    static const REFLECTED_SOMETHING C2(REFLECTED_, C1(INC(__COUNTER__))) = { REFLECTION_MODEL_TYPE,                &C2(REFLECTED_, C1(DEC(DEC(__COUNTER__)))), { {0}, {0}, {0}, {0}, {0}, {0}, {0}, {TOSTRING(name), C2(GetJSONProperties_, name)} } };
 #define REFLECTED_PROPERTY(type, name, modelName) \
     static const REFLECTED_SOMETHING C2(REFLECTED_, C1(INC(__COUNTER__))) = { REFLECTION_PROPERTY_TYPE,             &C2(REFLECTED_, C1(DEC(DEC(__COUNTER__)))), { {0}, {0}, {0}, {0}, {0}, {TOSTRING(name), TOSTRING(type), Create_AGENT_DATA_TYPE_From_Ptr_##modelName##name, offsetof(modelName, name), sizeof(type), TOSTRING(modelName)}, {0}, {0} } };
 #define REFLECTED_REPORTED_PROPERTY(type, name, modelName) \
@@ -499,6 +521,18 @@ Actions are discarded, since no marshalling will be done for those when sending
 #define CREATE_ELEMENT_GLOBAL_DEINITIALIZATION(modelName, elem) EXPAND_ARGS(CREATE_SOMETHING_GLOBAL_DEINITIALIZATION(modelName, EXPAND_ARGS(EXPAND_##elem)))
 #define CREATE_MODEL_ELEMENT_GLOBAL_DEINITIALIZE(modelName, elem) EXPAND_ARGS(CREATE_ELEMENT_GLOBAL_DEINITIALIZATION(modelName, elem))
 
+#define CREATE_MODEL_ENTITY_JSON_PROPERTY(modelName, callType, ...) EXPAND_ARGS(CREATE_JSON_PROPERTY_##callType(modelName, __VA_ARGS__))
+#define CREATE_SOMETHING_JSON_PROPERTY(modelName, ...) EXPAND_ARGS(CREATE_MODEL_ENTITY_JSON_PROPERTY(modelName, __VA_ARGS__))
+#define CREATE_ELEMENT_JSON_PROPERTY(modelName, elem) EXPAND_ARGS(CREATE_SOMETHING_JSON_PROPERTY(modelName, EXPAND_ARGS(EXPAND_##elem)))
+#define CREATE_MODEL_ELEMENT_JSON_PROPERTY(modelName, elem) EXPAND_ARGS(CREATE_ELEMENT_JSON_PROPERTY(modelName, elem))
+
+/*only WITH_DATA is sent by SERIALIZE*/
+#define CREATE_JSON_PROPERTY_MODEL_PROPERTY(modelName, type, name) { "\"" TOSTRING(name) "\":", sizeof("\"" TOSTRING(name) "\":") - 1, offsetof(modelName, name), C2(ToJSON_, type) },
+#define CREATE_JSON_PROPERTY_MODEL_REPORTED_PROPERTY(modelName, type, name)
+#define CREATE_JSON_PROPERTY_MODEL_DESIRED_PROPERTY(modelName, type, name, ...)
+#define CREATE_JSON_PROPERTY_MODEL_ACTION(...)
+#define CREATE_JSON_PROPERTY_MODEL_METHOD(...)
+
 #define INSERT_FIELD_INTO_STRUCT(x, y) x y;
 
 
@@ -856,6 +890,11 @@ static void C2(GlobalDeinitialize_, double)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, double)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteDouble(destination, *(const double*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_021:[ Create_AGENT_DATA_TYPE_from_FLOAT]*/
 /*Codes_SRS_SERIALIZER_99_006:[ float]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, float)(AGENT_DATA_TYPE* dest, float source)
@@ -888,6 +927,11 @@ static void C2(GlobalDeinitialize_, float)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, float)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteFloat(destination, *(const float*)value);
+}
+
 
 /*Codes_SRS_SERIALIZER_99_020:[ Create_AGENT_DATA_TYPE_from_SINT32]*/
 /*Codes_SRS_SERIALIZER_99_005:[ int], */
@@ -921,6 +965,11 @@ static void C2(GlobalDeinitialize_, int)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, int)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const int*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_022:[ Create_AGENT_DATA_TYPE_from_SINT64]*/
 /*Codes_SRS_SERIALIZER_99_007:[ long]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, long)(AGENT_DATA_TYPE* dest, long source)
@@ -953,6 +1002,11 @@ static void C2(GlobalDeinitialize_, long)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, long)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const long*)value);
+}
+
 
 /*Codes_SRS_SERIALIZER_99_023:[ Create_AGENT_DATA_TYPE_from_SINT8]*/
 /*Codes_SRS_SERIALIZER_99_008:[ int8_t]*/
@@ -986,6 +1040,11 @@ static void C2(GlobalDeinitialize_, int8_t)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, int8_t)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const int8_t*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_024:[ Create_AGENT_DATA_TYPE_from_UINT8]*/
 /*Codes_SRS_SERIALIZER_99_009:[ uint8_t]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, uint8_t)(AGENT_DATA_TYPE* dest, uint8_t source)
@@ -1018,6 +1077,11 @@ static void C2(GlobalDeinitialize_, uint8_t)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, uint8_t)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const uint8_t*)value);
+}
+
 
 /*Codes_SRS_SERIALIZER_99_025:[ Create_AGENT_DATA_TYPE_from_SINT16]*/
 /*Codes_SRS_SERIALIZER_99_010:[ int16_t]*/
@@ -1051,6 +1115,11 @@ static void C2(GlobalDeinitialize_, int16_t)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, int16_t)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const int16_t*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_026:[ Create_AGENT_DATA_TYPE_from_SINT32]*/
 /*Codes_SRS_SERIALIZER_99_011:[ int32_t]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, int32_t)(AGENT_DATA_TYPE* dest, int32_t source)
@@ -1083,6 +1152,11 @@ static void C2(GlobalDeinitialize_, int32_t)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, int32_t)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const int32_t*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_027:[ Create_AGENT_DATA_TYPE_from_SINT64]*/
 /*Codes_SRS_SERIALIZER_99_012:[ int64_t]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, int64_t)(AGENT_DATA_TYPE* dest, int64_t source)
@@ -1115,6 +1189,11 @@ static void C2(GlobalDeinitialize_, int64_t)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, int64_t)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteInt64(destination, (int64_t)*(const int64_t*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_013:[ bool]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, bool)(AGENT_DATA_TYPE* dest, bool source)
 {
@@ -1146,6 +1225,11 @@ static void C2(GlobalDeinitialize_, bool)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, bool)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteBool(destination, *(const bool*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_014:[ ascii_char_ptr]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, ascii_char_ptr)(AGENT_DATA_TYPE* dest, ascii_char_ptr source)
 {
@@ -1194,6 +1278,11 @@ static void C2(GlobalDeinitialize_, ascii_char_ptr)(void* dest)
     }
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, ascii_char_ptr)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteString(destination, *(const ascii_char_ptr*)value);
+}
+
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, ascii_char_ptr_no_quotes)(AGENT_DATA_TYPE* dest, ascii_char_ptr_no_quotes source)
 {
     return Create_AGENT_DATA_TYPE_from_charz_no_quotes(dest, source);
@@ -1240,6 +1329,11 @@ static void C2(GlobalDeinitialize_, ascii_char_ptr_no_quotes)(void* dest)
     }
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, ascii_char_ptr_no_quotes)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    return JSONEncoder_WriteStringNoQuotes(destination, *(const ascii_char_ptr_no_quotes*)value);
+}
+
 /*Codes_SRS_SERIALIZER_99_051:[ EDM_DATE_TIME_OFFSET*/
 /*Codes_SRS_SERIALIZER_99_053:[Create_AGENT_DATA_TYPE_from_EDM_DATE_TIME_OFFSET]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, EDM_DATE_TIME_OFFSET)(AGENT_DATA_TYPE* dest, EDM_DATE_TIME_OFFSET source)
@@ -1272,6 +1366,14 @@ static void C2(GlobalDeinitialize_, EDM_DATE_TIME_OFFSET)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, EDM_DATE_TIME_OFFSET)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    /*Codes_SRS_SERIALIZER_H_01_004: [ A WITH_DATA property whose type is a struct, a model or one of EDM_DATE_TIME_OFFSET, EDM_GUID and EDM_BINARY shall make SERIALIZE go through Device. ]*/
+    (void)destination;
+    (void)value;
+    return JSON_ENCODER_VALUE_NOT_SUPPORTED;
+}
+
 /*Codes_SRS_SERIALIZER_99_072:[ EDM_GUID]*/
 /*Codes_SRS_SERIALIZER_99_073:[ Create_AGENT_DATA_TYPE_from_EDM_GUID]*/
 static AGENT_DATA_TYPES_RESULT C2(ToAGENT_DATA_TYPE_, EDM_GUID)(AGENT_DATA_TYPE* dest, EDM_GUID guid)
@@ -1304,6 +1406,14 @@ static void C2(GlobalDeinitialize_, EDM_GUID)(void* dest)
     (void)(dest);
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, EDM_GUID)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    /*Codes_SRS_SERIALIZER_H_01_004: [ A WITH_DATA property whose type is a struct, a model or one of EDM_DATE_TIME_OFFSET, EDM_GUID and EDM_BINARY shall make SERIALIZE go through Device. ]*/
+    (void)destination;
+    (void)value;
+    return JSON_ENCODER_VALUE_NOT_SUPPORTED;
+}
+
 
 /*Codes_SRS_SERIALIZER_99_074:[ EDM_BINARY]*/
 /*Codes_SRS_SERIALIZER_99_075:[ Create_AGENT_DATA_TYPE_from_EDM_BINARY]*/
@@ -1349,6 +1459,14 @@ static void C2(GlobalDeinitialize_, EDM_BINARY)(void* dest)
     }
 }
 
+static JSON_ENCODER_RESULT C2(ToJSON_, EDM_BINARY)(JSON_ENCODER_BUFFER* destination, const void* value)
+{
+    /*Codes_SRS_SERIALIZER_H_01_004: [ A WITH_DATA property whose type is a struct, a model or one of EDM_DATE_TIME_OFFSET, EDM_GUID and EDM_BINARY shall make SERIALIZE go through Device. ]*/
+    (void)destination;
+    (void)value;
+    return JSON_ENCODER_VALUE_NOT_SUPPORTED;
+}
+
 static void C2(destroyLocalParameter, EDM_BINARY)(EDM_BINARY* value)
 {
     if (value != NULL)
@@ -27,6 +27,7 @@
 
 #include "jsonencoder.h"
 #include "multitree.h"
+#include "numberformat.h"
 
 #include "azure_c_shared_utility/xlogging.h"
 
@@ -48,28 +49,31 @@
 
 #define GUID_STRING_LENGTH 38
 
-// This is an artificial upper limit on floating point string length
-// (e.g. the size of the string when printing %f). It is set to twice the
-// maximum decimal precision plus 2. 1 for the decimal point and 1 for a
-// sign (+/-)
-// Unfortunately it is quite possible to print a float larger than this.
-// An example of this would be printf("%.*f", MAX_FLOATING_POINT_STRING_LENGTH, 1.3);
-// But currently no explicit requests for this exist in the file nor are
-// any expected to reasonably occur when being used (numbers that hit
-// this limit would be experiencing significant precision loss in storage anyway.
-#define MAX_FLOATING_POINT_STRING_LENGTH (DECIMAL_DIG *2 + 2)
-
-// This maximum length is 11 for 32 bit integers (including the sign)
-// optionally increase to 21 if longs are 64 bit
-#define MAX_LONG_STRING_LENGTH ( 11 + (10 * (sizeof(long)/ 8)))
-
-// This is the maximum length for the largest 64 bit number (signed)
-#define MAX_ULONG_LONG_STRING_LENGTH 20
-
 DEFINE_ENUM_STRINGS(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_RESULT_VALUES);
 
 static int ValidateDate(int year, int month, int day);
 
+/*writes what printf writes for "%.*d", or for "%+.*d" when forceSign is true*/
+static size_t writePaddedInt(char* destination, int value, size_t minimumDigits, bool forceSign)
+{
+    size_t result = 0;
+    uint64_t magnitude;
+    if (value < 0)
+    {
+        destination[result++] = '-';
+        magnitude = 0 - (uint64_t)(int64_t)value;
+    }
+    else
+    {
+        if (forceSign)
+        {
+            destination[result++] = '+';
+        }
+        magnitude = (uint64_t)value;
+    }
+    return result + NumberFormat_UInt64(destination + result, magnitude, minimumDigits);
+}
+
 static int NoCloneFunction(void** destination, const void* source)
 {
     *destination = (void*)source;
@@ -1429,228 +1433,49 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             {
                 /*Codes_SRS_AGENT_TYPE_SYSTEM_99_019:[ EDM_DATETIMEOFFSET: dateTimeOffsetValue = year "-" month "-" day "T" hour ":" minute [ ":" second [ "." fractionalSeconds ] ] ( "Z" / sign hour ":" minute )]*/
                 /*from ABNF seems like these numbers HAVE to be padded with zeroes*/
+                /*the quotes, then at most 9 numbers each followed by a separator, then '\0'*/
+                char tempBuffer[2 + 9 * NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                const struct tm* dateTime = &value->value.edmDateTimeOffset.dateTime;
+                size_t pos = 0;
+
+                tempBuffer[pos++] = '\"';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_year + 1900, 4, false);
+                tempBuffer[pos++] = '-';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_mon + 1, 2, false);
+                tempBuffer[pos++] = '-';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_mday, 2, false);
+                tempBuffer[pos++] = 'T';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_hour, 2, false);
+                tempBuffer[pos++] = ':';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_min, 2, false);
+                tempBuffer[pos++] = ':';
+                pos += writePaddedInt(tempBuffer + pos, dateTime->tm_sec, 2, false);
+                if (value->value.edmDateTimeOffset.hasFractionalSecond)
+                {
+                    tempBuffer[pos++] = '.';
+                    pos += NumberFormat_UInt64(tempBuffer + pos, value->value.edmDateTimeOffset.fractionalSecond, 12);
+                }
                 if (value->value.edmDateTimeOffset.hasTimeZone)
                 {
-                    if (value->value.edmDateTimeOffset.hasFractionalSecond)
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // .
-                            MAX_ULONG_LONG_STRING_LENGTH + // %.12llu
-                            1 + MAX_LONG_STRING_LENGTH + // %+.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + //\"
-                            1;  // " (terminating NULL);
-
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d.%.12llu%+.2d:%.2d\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year+1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.fractionalSecond,
-                                value->value.edmDateTimeOffset.timeZoneHour,
-                                value->value.edmDateTimeOffset.timeZoneMinute) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
-
-                            // Clean up temp buffer if allocated
-                            free(tempBuffer);
-                        }
-                    }
-                    else
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + MAX_LONG_STRING_LENGTH + // %+.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // \"
-                            1; // " terminating NULL
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d%+.2d:%.2d\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.timeZoneHour,
-                                value->value.edmDateTimeOffset.timeZoneMinute) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
-
-                            // Clean up temp buffer if allocated
-                            free(tempBuffer);
-                        }
-                    }
+                    pos += writePaddedInt(tempBuffer + pos, value->value.edmDateTimeOffset.timeZoneHour, 2, true);
+                    tempBuffer[pos++] = ':';
+                    pos += writePaddedInt(tempBuffer + pos, value->value.edmDateTimeOffset.timeZoneMinute, 2, false);
                 }
                 else
                 {
-                    if (value->value.edmDateTimeOffset.hasFractionalSecond)
-                    {
-                        size_t tempBufferSize = 1 + //\"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // .
-                            MAX_ULONG_LONG_STRING_LENGTH + // %.12llu
-                            1 + // Z
-                            1 + // \"
-                            1; // " (terminating NULL)
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2d.%.12lluZ\"", /*+ in printf forces the sign to appear*/
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec,
-                                value->value.edmDateTimeOffset.fractionalSecond) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
-
-                            free(tempBuffer);
-                        }
-                    }
-                    else
-                    {
-                        size_t tempBufferSize = 1 + // \"
-                            MAX_LONG_STRING_LENGTH + // %.4d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // -
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // T
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // :
-                            MAX_LONG_STRING_LENGTH + // %.2d
-                            1 + // Z
-                            1 + // \"
-                            1; // " (terminating null);
-
-                        char* tempBuffer = (char*)malloc(tempBufferSize);
-
-                        if (tempBuffer == NULL)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            if (sprintf_s(tempBuffer, tempBufferSize, "\"%.4d-%.2d-%.2dT%.2d:%.2d:%.2dZ\"",
-                                value->value.edmDateTimeOffset.dateTime.tm_year + 1900,
-                                value->value.edmDateTimeOffset.dateTime.tm_mon+1,
-                                value->value.edmDateTimeOffset.dateTime.tm_mday,
-                                value->value.edmDateTimeOffset.dateTime.tm_hour,
-                                value->value.edmDateTimeOffset.dateTime.tm_min,
-                                value->value.edmDateTimeOffset.dateTime.tm_sec) < 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else if (STRING_concat(destination, tempBuffer) != 0)
-                            {
-                                result = AGENT_DATA_TYPES_ERROR;
-                                LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                            }
-                            else
-                            {
-                                result = AGENT_DATA_TYPES_OK;
-                            }
+                    tempBuffer[pos++] = 'Z';
+                }
+                tempBuffer[pos++] = '\"';
+                tempBuffer[pos] = '\0';
 
-                            free(tempBuffer);
-                        }
-                    }
+                if (STRING_concat(destination, tempBuffer) != 0)
+                {
+                    result = AGENT_DATA_TYPES_ERROR;
+                    LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
+                }
+                else
+                {
+                    result = AGENT_DATA_TYPES_OK;
                 }
                 break;
             }
@@ -1670,35 +1495,9 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             case (EDM_INT16_TYPE) :
             {
                 /*-32768 to +32767*/
-                char buffertemp2[7]; /*because 5 digits and sign and '\0'*/
-                uint16_t positiveValue;
-                size_t pos = 0;
-                uint16_t rank = (uint16_t)10000;
-                bool foundFirstDigit = false;
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt16.value);
 
-                if (value->value.edmInt16.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt16.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt16.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
-                
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
                     result = AGENT_DATA_TYPES_ERROR;
@@ -1713,35 +1512,9 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             case (EDM_INT32_TYPE) :
             {
                 /*-2147483648 to +2147483647*/
-                char buffertemp2[12]; /*because 10 digits and sign and '\0'*/
-                uint32_t positiveValue;
-                size_t pos = 0;
-                uint32_t rank = 1000000000UL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt32.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = - value->value.edmInt32.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt32.value;
-                }
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt32.value);
 
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
-                
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
                     result = AGENT_DATA_TYPES_ERROR;
@@ -1755,34 +1528,8 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
             }
             case (EDM_INT64_TYPE):
             {
-                char buffertemp2[21]; /*because 19 digits and sign and '\0'*/
-                uint64_t positiveValue;
-                size_t pos = 0;
-                uint64_t rank = 10000000000000000000ULL;
-                bool foundFirstDigit = false;
-
-                if (value->value.edmInt64.value < 0)
-                {
-                    buffertemp2[pos++] = '-';
-                    positiveValue = -value->value.edmInt64.value;
-                }
-                else
-                {
-                    positiveValue = value->value.edmInt64.value;
-                }
-
-                while (rank >= 10)
-                {
-                    if ((foundFirstDigit == true) || (positiveValue / rank) > 0)
-                    {
-                        buffertemp2[pos++] = '0' + (char)(positiveValue / rank);
-                        foundFirstDigit = true;
-                    }
-                    positiveValue %= rank;
-                    rank /= 10;
-                }
-                buffertemp2[pos++] = '0' + (char)(positiveValue);
-                buffertemp2[pos++] = '\0';
+                char buffertemp2[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+                (void)NumberFormat_Int64(buffertemp2, value->value.edmInt64.value);
 
                 if (STRING_concat(destination, buffertemp2) != 0)
                 {
@@ -1995,31 +1742,17 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 }
                 else
                 {
-                    size_t tempBufferSize = MAX_FLOATING_POINT_STRING_LENGTH;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    /*Codes_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
+                    char tempBuffer[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+                    (void)NumberFormat_Float(tempBuffer, value->value.edmSingle.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", FLT_DIG, (double)(value->value.edmSingle.value)) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
@@ -2031,7 +1764,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                 /*C90 doesn't declare a NaN or Inf in the standard, however, values might be NaN or Inf...*/
                 /*C99 ... does*/
                 /*C11 is same as C99*/
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
                 if(ISNAN(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, NaN_STRING) != 0)
@@ -2044,7 +1777,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
                 else if (ISNEGATIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, MINUSINF_STRING) != 0)
@@ -2057,7 +1790,7 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
                 else if (ISPOSITIVEINFINITY(value->value.edmDouble.value))
                 {
                     if (STRING_concat(destination, PLUSINF_STRING) != 0)
@@ -2070,34 +1803,19 @@ AGENT_DATA_TYPES_RESULT AgentDataTypes_ToString(STRING_HANDLE destination, const
                         result = AGENT_DATA_TYPES_OK;
                     }
                 }
-                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+                /*Codes_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
                 else
                 {
-                    size_t tempBufferSize = DECIMAL_DIG * 2;
-                    char* tempBuffer = (char*)malloc(tempBufferSize);
-                    if (tempBuffer == NULL)
+                    char tempBuffer[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+                    (void)NumberFormat_Double(tempBuffer, value->value.edmDouble.value);
+                    if (STRING_concat(destination, tempBuffer) != 0)
                     {
                         result = AGENT_DATA_TYPES_ERROR;
                         LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
                     }
                     else
                     {
-                        if (sprintf_s(tempBuffer, tempBufferSize, "%.*f", DBL_DIG, value->value.edmDouble.value) < 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else if (STRING_concat(destination, tempBuffer) != 0)
-                        {
-                            result = AGENT_DATA_TYPES_ERROR;
-                            LogError("(result = %s)", ENUM_TO_STRING(AGENT_DATA_TYPES_RESULT, result));
-                        }
-                        else
-                        {
-                            result = AGENT_DATA_TYPES_OK;
-                        }
-
-                        free(tempBuffer);
+                        result = AGENT_DATA_TYPES_OK;
                     }
                 }
                 break;
@@ -3083,11 +2801,15 @@ static int sscanfu(const char* src, unsigned int* dst)
 static int sscanff(const char*src, float* dst)
 {
     int result = 1;
-    char* next;
-    (*dst) = strtof(src, &next);
-    if ((src == next) || (((*dst) == HUGE_VALF) && (errno != 0)))
+    /*most values sent by devices are short decimals, they are converted without strtof*/
+    if (NumberFormat_ParseFloatFastPath(src, dst) != 0)
     {
-        result = EOF;
+        char* next;
+        (*dst) = strtof(src, &next);
+        if ((src == next) || (((*dst) == HUGE_VALF) && (errno != 0)))
+        {
+            result = EOF;
+        }
     }
     return result;
 }
@@ -3096,11 +2818,15 @@ static int sscanff(const char*src, float* dst)
 static int sscanflf(const char*src, double* dst)
 {
     int result = 1;
-    char* next;
-    (*dst) = strtod(src, &next);
-    if ((src == next) || (((*dst) == HUGE_VALL) && (errno != 0)))
+    /*most values sent by devices are short decimals, they are converted without strtod*/
+    if (NumberFormat_ParseDoubleFastPath(src, dst) != 0)
     {
-        result = EOF;
+        char* next;
+        (*dst) = strtod(src, &next);
+        if ((src == next) || (((*dst) == HUGE_VALL) && (errno != 0)))
+        {
+            result = EOF;
+        }
     }
     return result;
 }
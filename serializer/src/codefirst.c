@@ -26,8 +26,13 @@ typedef struct DEVICE_HEADER_DATA_TAG
     SCHEMA_MODEL_TYPE_HANDLE ModelHandle;
     size_t DataSize;
     unsigned char* data;
+    const REFLECTION_JSON_PROPERTY* JSONProperties;
+    size_t JSONPropertyCount;
 } DEVICE_HEADER_DATA;
 
+/*SERIALIZE calls with more values than this always go through Device*/
+#define MAX_JSON_PROPERTIES_PER_SEND 32
+
 #define COUNT_OF(A) (sizeof(A) / sizeof((A)[0]))
 
 /*design considerations for lazy init of CodeFirst:
@@ -507,10 +512,11 @@ static const REFLECTED_SOMETHING* FindChildModelInCodeFirstMetadata(const REFLEC
 
         for (childModelProperty = reflectedData; childModelProperty != NULL; childModelProperty = childModelProperty->next)
         {
+            /*the segment name is checked before the owning model name since it rejects most of the reflected properties after a character or two*/
             if ((childModelProperty->type == REFLECTION_PROPERTY_TYPE) &&
-                (strcmp(childModelProperty->what.property.modelName, result->what.model.name) == 0) &&
                 (strncmp(childModelProperty->what.property.name, relativePath, propertyNameLength) == 0) &&
-                (strlen(childModelProperty->what.property.name) == propertyNameLength))
+                (childModelProperty->what.property.name[propertyNameLength] == '\0') &&
+                (strcmp(childModelProperty->what.property.modelName, result->what.model.name) == 0))
             {
                 /* property found, now let's find the model */
                 /* Codes_SRS_CODEFIRST_99_140:[CodeFirst_InvokeAction shall pass to the action wrapper that it calls a pointer to the model where the action is defined.] */
@@ -954,6 +960,20 @@ void* CodeFirst_CreateDevice(SCHEMA_MODEL_TYPE_HANDLE model, const REFLECTED_DAT
                     }
                     else
                     {
+                        const char* modelName;
+                        const REFLECTED_SOMETHING* modelReflectedData;
+
+                        /*Codes_SRS_CODEFIRST_01_007: [ CodeFirst_CreateDevice shall look up the model in metadata by the name returned by Schema_GetModelName and, when the model has generated JSON encoders, keep its table of JSON properties. ]*/
+                        /*Codes_SRS_CODEFIRST_01_008: [ If the model name cannot be obtained or the model has no generated JSON encoders, CodeFirst_CreateDevice shall still succeed and the device shall always be serialized through Device. ]*/
+                        deviceHeader->JSONProperties = NULL;
+                        deviceHeader->JSONPropertyCount = 0;
+                        if (((modelName = Schema_GetModelName(model)) != NULL) &&
+                            ((modelReflectedData = FindModelInCodeFirstMetadata(metadata->reflectedData, modelName)) != NULL) &&
+                            (modelReflectedData->what.model.getJSONProperties != NULL))
+                        {
+                            deviceHeader->JSONProperties = modelReflectedData->what.model.getJSONProperties(&deviceHeader->JSONPropertyCount);
+                        }
+
                         g_Devices = newDevices;
                         g_Devices[g_DeviceCount] = deviceHeader;
                         g_DeviceCount++;
@@ -1187,6 +1207,141 @@ static CODEFIRST_RESULT SendAllDeviceReportedProperties(DEVICE_HEADER_DATA* devi
 }
 
 
+/*returns false when the values cannot all be written by the model's generated JSON encoders, in which case nothing has been produced and CodeFirst_SendAsync shall go through Device*/
+static bool SendAsyncJSONProperties(unsigned char** destination, size_t* destinationSize, size_t numProperties, va_list ap, CODEFIRST_RESULT* result)
+{
+    bool isEncoded = false;
+    const REFLECTION_JSON_PROPERTY* properties[MAX_JSON_PROPERTIES_PER_SEND];
+    size_t propertyCount = 0;
+    void* value = (void*)va_arg(ap, void*);
+    DEVICE_HEADER_DATA* deviceHeader = FindDevice(value);
+
+    if ((deviceHeader == NULL) ||
+        (deviceHeader->JSONPropertyCount == 0) ||
+        (deviceHeader->JSONPropertyCount > MAX_JSON_PROPERTIES_PER_SEND) ||
+        (numProperties > MAX_JSON_PROPERTIES_PER_SEND))
+    {
+        /*Device reports these*/
+    }
+    else if (value == deviceHeader->data)
+    {
+        if (numProperties == 1)
+        {
+            /*Codes_SRS_CODEFIRST_01_010: [ When the only value is the device block, all the WITH_DATA properties of the model shall be written, in the same order as Device would produce them. ]*/
+            /*Device walks the reflected data, which lists the properties of a model last declared first*/
+            for (propertyCount = 0; propertyCount < deviceHeader->JSONPropertyCount; propertyCount++)
+            {
+                properties[propertyCount] = &deviceHeader->JSONProperties[deviceHeader->JSONPropertyCount - 1 - propertyCount];
+            }
+        }
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < numProperties; i++)
+        {
+            size_t j;
+            size_t offset;
+
+            if (i > 0)
+            {
+                value = (void*)va_arg(ap, void*);
+            }
+
+            /*Codes_SRS_CODEFIRST_01_011: [ Otherwise each value shall be the address of a WITH_DATA property of the same device, and the properties shall be written in the order in which they were passed. ]*/
+            if (((unsigned char*)value <= deviceHeader->data) ||
+                ((unsigned char*)value >= deviceHeader->data + deviceHeader->DataSize))
+            {
+                break;
+            }
+
+            offset = (size_t)((unsigned char*)value - deviceHeader->data);
+            for (j = 0; j < deviceHeader->JSONPropertyCount; j++)
+            {
+                if (deviceHeader->JSONProperties[j].offset == offset)
+                {
+                    break;
+                }
+            }
+
+            if (j == deviceHeader->JSONPropertyCount)
+            {
+                break;
+            }
+            else
+            {
+                size_t k;
+                for (k = 0; k < propertyCount; k++)
+                {
+                    if (properties[k] == &deviceHeader->JSONProperties[j])
+                    {
+                        break;
+                    }
+                }
+
+                if (k < propertyCount)
+                {
+                    break;
+                }
+                else
+                {
+                    properties[propertyCount++] = &deviceHeader->JSONProperties[j];
+                }
+            }
+        }
+
+        if (i < numProperties)
+        {
+            propertyCount = 0;
+        }
+    }
+
+    if (propertyCount > 0)
+    {
+        JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+        JSON_ENCODER_RESULT encoderResult;
+        size_t i;
+
+        /*Codes_SRS_CODEFIRST_01_012: [ The values shall be written with JSONEncoder_BeginObject, then JSONEncoder_WriteMemberName and the generated ToJSON function of each property, then JSONEncoder_EndObject. ]*/
+        encoderResult = JSONEncoder_BeginObject(&buffer);
+        for (i = 0; (encoderResult == JSON_ENCODER_OK) && (i < propertyCount); i++)
+        {
+            if ((encoderResult = JSONEncoder_WriteMemberName(&buffer, properties[i]->jsonName, properties[i]->jsonNameLength)) == JSON_ENCODER_OK)
+            {
+                encoderResult = properties[i]->ToJSON(&buffer, deviceHeader->data + properties[i]->offset);
+            }
+        }
+
+        if (encoderResult == JSON_ENCODER_OK)
+        {
+            encoderResult = JSONEncoder_EndObject(&buffer);
+        }
+
+        if (encoderResult == JSON_ENCODER_OK)
+        {
+            /*Codes_SRS_CODEFIRST_01_014: [ On success the written JSON shall be returned in destination and destinationSize and CodeFirst_SendAsync shall return CODEFIRST_OK without calling any Device API. ]*/
+            *destination = buffer.buffer;
+            *destinationSize = buffer.size;
+            *result = CODEFIRST_OK;
+            isEncoded = true;
+        }
+        else
+        {
+            free(buffer.buffer);
+            if (encoderResult != JSON_ENCODER_VALUE_NOT_SUPPORTED)
+            {
+                /*Codes_SRS_CODEFIRST_01_015: [ If any other JSONEncoder call fails, CodeFirst_SendAsync shall return CODEFIRST_ERROR. ]*/
+                *result = CODEFIRST_ERROR;
+                LogError("unable to write the JSON (result = %s)", ENUM_TO_STRING(CODEFIRST_RESULT, *result));
+                isEncoded = true;
+            }
+            /*Codes_SRS_CODEFIRST_01_013: [ If a ToJSON function returns JSON_ENCODER_VALUE_NOT_SUPPORTED, CodeFirst_SendAsync shall discard what was written and go through Device. ]*/
+        }
+    }
+
+    return isEncoded;
+}
+
 /* Codes_SRS_CODEFIRST_99_088:[CodeFirst_SendAsync shall send to the Device module a set of properties, a destination and a destinationSize.]*/
 CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t* destinationSize, size_t numProperties, ...)
 {
@@ -1206,156 +1361,166 @@ CODEFIRST_RESULT CodeFirst_SendAsync(unsigned char** destination, size_t* destin
     }
     else
     {
+        bool isEncoded;
+
         /*Codes_SRS_CODEFIRST_02_040: [ CodeFirst_SendAsync shall call CodeFirst_Init, passing NULL for overrideSchemaNamespace. ]*/
         (void)CodeFirst_Init_impl(NULL, false); /*lazy init*/
-        
-        DEVICE_HEADER_DATA* deviceHeader = NULL;
-        size_t i;
-        TRANSACTION_HANDLE transaction = NULL;
-        result = CODEFIRST_OK;
 
-        /* Codes_SRS_CODEFIRST_99_105:[The properties are passed as pointers to the memory locations where the data exists in the device block allocated by CodeFirst_CreateDevice.] */
+        /*Codes_SRS_CODEFIRST_01_009: [ CodeFirst_SendAsync shall first try to write the values with the JSON encoders generated for the model of the device. ]*/
         va_start(ap, numProperties);
+        isEncoded = SendAsyncJSONProperties(destination, destinationSize, numProperties, ap, &result);
+        va_end(ap);
 
-        /* Codes_SRS_CODEFIRST_99_089:[The numProperties argument shall indicate how many properties are to be sent.] */
-        for (i = 0; i < numProperties; i++)
+        if (!isEncoded)
         {
-            void* value = (void*)va_arg(ap, void*);
+            DEVICE_HEADER_DATA* deviceHeader = NULL;
+            size_t i;
+            TRANSACTION_HANDLE transaction = NULL;
+            result = CODEFIRST_OK;
 
-            /* Codes_SRS_CODEFIRST_99_095:[For each value passed to it, CodeFirst_SendAsync shall look up to which device the value belongs.] */
-            DEVICE_HEADER_DATA* currentValueDeviceHeader = FindDevice(value);
-            if (currentValueDeviceHeader == NULL)
-            {
-                /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
-                result = CODEFIRST_INVALID_ARG;
-                LOG_CODEFIRST_ERROR;
-                break;
-            }
-            else if ((deviceHeader != NULL) &&
-                (currentValueDeviceHeader != deviceHeader))
-            {
-                /* Codes_SRS_CODEFIRST_99_096:[All values have to belong to the same device, otherwise CodeFirst_SendAsync shall return CODEFIRST_VALUES_FROM_DIFFERENT_DEVICES_ERROR.] */
-                result = CODEFIRST_VALUES_FROM_DIFFERENT_DEVICES_ERROR;
-                LOG_CODEFIRST_ERROR;
-                break;
-            }
-            /* Codes_SRS_CODEFIRST_99_090:[All the properties shall be sent together by using the transacted APIs of the device.] */
-            /* Codes_SRS_CODEFIRST_99_091:[CodeFirst_SendAsync shall start a transaction by calling Device_StartTransaction.] */
-            else if ((deviceHeader == NULL) &&
-                ((transaction = Device_StartTransaction(currentValueDeviceHeader->DeviceHandle)) == NULL))
-            {
-                /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
-                result = CODEFIRST_DEVICE_PUBLISH_FAILED;
-                LOG_CODEFIRST_ERROR;
-                break;
-            }
-            else
+            /* Codes_SRS_CODEFIRST_99_105:[The properties are passed as pointers to the memory locations where the data exists in the device block allocated by CodeFirst_CreateDevice.] */
+            va_start(ap, numProperties);
+
+            /* Codes_SRS_CODEFIRST_99_089:[The numProperties argument shall indicate how many properties are to be sent.] */
+            for (i = 0; i < numProperties; i++)
             {
-                deviceHeader = currentValueDeviceHeader;
+                void* value = (void*)va_arg(ap, void*);
 
-                if (value == ((unsigned char*)deviceHeader->data))
+                /* Codes_SRS_CODEFIRST_99_095:[For each value passed to it, CodeFirst_SendAsync shall look up to which device the value belongs.] */
+                DEVICE_HEADER_DATA* currentValueDeviceHeader = FindDevice(value);
+                if (currentValueDeviceHeader == NULL)
                 {
-                    /* we got a full device, send all its state data */
-                    result = SendAllDeviceProperties(deviceHeader, transaction);
-                    if (result != CODEFIRST_OK)
-                    {
-                        LOG_CODEFIRST_ERROR;
-                        break;
-                    }
+                    /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
+                    result = CODEFIRST_INVALID_ARG;
+                    LOG_CODEFIRST_ERROR;
+                    break;
+                }
+                else if ((deviceHeader != NULL) &&
+                    (currentValueDeviceHeader != deviceHeader))
+                {
+                    /* Codes_SRS_CODEFIRST_99_096:[All values have to belong to the same device, otherwise CodeFirst_SendAsync shall return CODEFIRST_VALUES_FROM_DIFFERENT_DEVICES_ERROR.] */
+                    result = CODEFIRST_VALUES_FROM_DIFFERENT_DEVICES_ERROR;
+                    LOG_CODEFIRST_ERROR;
+                    break;
+                }
+                /* Codes_SRS_CODEFIRST_99_090:[All the properties shall be sent together by using the transacted APIs of the device.] */
+                /* Codes_SRS_CODEFIRST_99_091:[CodeFirst_SendAsync shall start a transaction by calling Device_StartTransaction.] */
+                else if ((deviceHeader == NULL) &&
+                    ((transaction = Device_StartTransaction(currentValueDeviceHeader->DeviceHandle)) == NULL))
+                {
+                    /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
+                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                    LOG_CODEFIRST_ERROR;
+                    break;
                 }
                 else
                 {
-                    const REFLECTED_SOMETHING* propertyReflectedData;
-                    const char* modelName;
-                    STRING_HANDLE valuePath;
+                    deviceHeader = currentValueDeviceHeader;
 
-                    if ((valuePath = STRING_new()) == NULL)
+                    if (value == ((unsigned char*)deviceHeader->data))
                     {
-                        /* Codes_SRS_CODEFIRST_99_134:[If CodeFirst_Notify fails for any other reason it shall return CODEFIRST_ERROR.] */
-                        result = CODEFIRST_ERROR;
-                        LOG_CODEFIRST_ERROR;
-                        break;
+                        /* we got a full device, send all its state data */
+                        result = SendAllDeviceProperties(deviceHeader, transaction);
+                        if (result != CODEFIRST_OK)
+                        {
+                            LOG_CODEFIRST_ERROR;
+                            break;
+                        }
                     }
                     else
                     {
-                        if ((modelName = Schema_GetModelName(deviceHeader->ModelHandle)) == NULL)
+                        const REFLECTED_SOMETHING* propertyReflectedData;
+                        const char* modelName;
+                        STRING_HANDLE valuePath;
+
+                        if ((valuePath = STRING_new()) == NULL)
                         {
                             /* Codes_SRS_CODEFIRST_99_134:[If CodeFirst_Notify fails for any other reason it shall return CODEFIRST_ERROR.] */
                             result = CODEFIRST_ERROR;
                             LOG_CODEFIRST_ERROR;
-                            STRING_delete(valuePath);
-                            break;
-                        }
-                        else if ((propertyReflectedData = FindValue(deviceHeader, value, modelName, 0, valuePath)) == NULL)
-                        {
-                            /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
-                            result = CODEFIRST_INVALID_ARG;
-                            LOG_CODEFIRST_ERROR;
-                            STRING_delete(valuePath);
                             break;
                         }
                         else
                         {
-                            AGENT_DATA_TYPE agentDataType;
-
-                            /* Codes_SRS_CODEFIRST_99_097:[For each value marshalling to AGENT_DATA_TYPE shall be performed.] */
-                            /* Codes_SRS_CODEFIRST_99_098:[The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with the property.] */
-                            if (propertyReflectedData->what.property.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
+                            if ((modelName = Schema_GetModelName(deviceHeader->ModelHandle)) == NULL)
                             {
-                                /* Codes_SRS_CODEFIRST_99_099:[If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_SendAsync shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
-                                result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
+                                /* Codes_SRS_CODEFIRST_99_134:[If CodeFirst_Notify fails for any other reason it shall return CODEFIRST_ERROR.] */
+                                result = CODEFIRST_ERROR;
+                                LOG_CODEFIRST_ERROR;
+                                STRING_delete(valuePath);
+                                break;
+                            }
+                            else if ((propertyReflectedData = FindValue(deviceHeader, value, modelName, 0, valuePath)) == NULL)
+                            {
+                                /* Codes_SRS_CODEFIRST_99_104:[If a property cannot be associated with a device, CodeFirst_SendAsync shall return CODEFIRST_INVALID_ARG.] */
+                                result = CODEFIRST_INVALID_ARG;
                                 LOG_CODEFIRST_ERROR;
                                 STRING_delete(valuePath);
                                 break;
                             }
                             else
                             {
-                                /* Codes_SRS_CODEFIRST_99_092:[CodeFirst shall publish each value by using Device_PublishTransacted.] */
-                                /* Codes_SRS_CODEFIRST_99_136:[CodeFirst_SendAsync shall build the full path for each property and then pass it to Device_PublishTransacted.] */
-                                if (Device_PublishTransacted(transaction, STRING_c_str(valuePath), &agentDataType) != DEVICE_OK)
-                                {
-                                    Destroy_AGENT_DATA_TYPE(&agentDataType);
+                                AGENT_DATA_TYPE agentDataType;
 
-                                    /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
-                                    result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                                /* Codes_SRS_CODEFIRST_99_097:[For each value marshalling to AGENT_DATA_TYPE shall be performed.] */
+                                /* Codes_SRS_CODEFIRST_99_098:[The marshalling shall be done by calling the Create_AGENT_DATA_TYPE_from_Ptr function associated with the property.] */
+                                if (propertyReflectedData->what.property.Create_AGENT_DATA_TYPE_from_Ptr(value, &agentDataType) != AGENT_DATA_TYPES_OK)
+                                {
+                                    /* Codes_SRS_CODEFIRST_99_099:[If Create_AGENT_DATA_TYPE_from_Ptr fails, CodeFirst_SendAsync shall return CODEFIRST_AGENT_DATA_TYPE_ERROR.] */
+                                    result = CODEFIRST_AGENT_DATA_TYPE_ERROR;
                                     LOG_CODEFIRST_ERROR;
                                     STRING_delete(valuePath);
                                     break;
                                 }
                                 else
                                 {
-                                    STRING_delete(valuePath); /*anyway*/
-                                }
+                                    /* Codes_SRS_CODEFIRST_99_092:[CodeFirst shall publish each value by using Device_PublishTransacted.] */
+                                    /* Codes_SRS_CODEFIRST_99_136:[CodeFirst_SendAsync shall build the full path for each property and then pass it to Device_PublishTransacted.] */
+                                    if (Device_PublishTransacted(transaction, STRING_c_str(valuePath), &agentDataType) != DEVICE_OK)
+                                    {
+                                        Destroy_AGENT_DATA_TYPE(&agentDataType);
 
-                                Destroy_AGENT_DATA_TYPE(&agentDataType);
+                                        /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
+                                        result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                                        LOG_CODEFIRST_ERROR;
+                                        STRING_delete(valuePath);
+                                        break;
+                                    }
+                                    else
+                                    {
+                                        STRING_delete(valuePath); /*anyway*/
+                                    }
+
+                                    Destroy_AGENT_DATA_TYPE(&agentDataType);
+                                }
                             }
                         }
                     }
                 }
             }
-        }
 
-        if (i < numProperties)
-        {
-            if (transaction != NULL)
+            if (i < numProperties)
             {
-                (void)Device_CancelTransaction(transaction);
+                if (transaction != NULL)
+                {
+                    (void)Device_CancelTransaction(transaction);
+                }
+            }
+            /* Codes_SRS_CODEFIRST_99_093:[After all values have been published, Device_EndTransaction shall be called.] */
+            else if (Device_EndTransaction(transaction, destination, destinationSize) != DEVICE_OK)
+            {
+                /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
+                result = CODEFIRST_DEVICE_PUBLISH_FAILED;
+                LOG_CODEFIRST_ERROR;
+            }
+            else
+            {
+                /* Codes_SRS_CODEFIRST_99_117:[On success, CodeFirst_SendAsync shall return CODEFIRST_OK.] */
+                result = CODEFIRST_OK;
             }
-        }
-        /* Codes_SRS_CODEFIRST_99_093:[After all values have been published, Device_EndTransaction shall be called.] */
-        else if (Device_EndTransaction(transaction, destination, destinationSize) != DEVICE_OK)
-        {
-            /* Codes_SRS_CODEFIRST_99_094:[If any Device API fail, CodeFirst_SendAsync shall return CODEFIRST_DEVICE_PUBLISH_FAILED.] */
-            result = CODEFIRST_DEVICE_PUBLISH_FAILED;
-            LOG_CODEFIRST_ERROR;
-        }
-        else
-        {
-            /* Codes_SRS_CODEFIRST_99_117:[On success, CodeFirst_SendAsync shall return CODEFIRST_OK.] */
-            result = CODEFIRST_OK;
-        }
 
-        va_end(ap);
+            va_end(ap);
+        }
         
     }
 
@@ -1622,4 +1787,42 @@ CODEFIRST_RESULT CodeFirst_IngestDesiredProperties(void* device, const char* des
     return result;
 }
 
+CODEFIRST_RESULT CodeFirst_IngestDesiredPropertiesInPlace(void* device, char* jsonPayload, bool parseDesiredNode)
+{
+    CODEFIRST_RESULT result;
+    /*Codes_SRS_CODEFIRST_01_002: [ If argument device or jsonPayload is NULL then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    if (
+        (device == NULL) ||
+        (jsonPayload == NULL)
+        )
+    {
+        LogError("invalid argument void* device=%p, char* jsonPayload=%p", device, jsonPayload);
+        result = CODEFIRST_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_CODEFIRST_01_003: [ CodeFirst_IngestDesiredPropertiesInPlace shall locate the device associated with device. ]*/
+        DEVICE_HEADER_DATA* deviceHeader = FindDevice(device);
+        if (deviceHeader == NULL)
+        {
+            /*Codes_SRS_CODEFIRST_01_005: [ If there is any failure, then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_ERROR. ]*/
+            LogError("unable to find a device having this memory address %p", device);
+            result = CODEFIRST_ERROR;
+        }
+        /*Codes_SRS_CODEFIRST_01_004: [ CodeFirst_IngestDesiredPropertiesInPlace shall call Device_IngestDesiredPropertiesInPlace passing jsonPayload and parseDesiredNode. ]*/
+        else if (Device_IngestDesiredPropertiesInPlace(device, deviceHeader->DeviceHandle, jsonPayload, parseDesiredNode) != DEVICE_OK)
+        {
+            /*Codes_SRS_CODEFIRST_01_005: [ If there is any failure, then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_ERROR. ]*/
+            LogError("failure in Device_IngestDesiredPropertiesInPlace");
+            result = CODEFIRST_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_CODEFIRST_01_006: [ Otherwise, CodeFirst_IngestDesiredPropertiesInPlace shall return CODEFIRST_OK. ]*/
+            result = CODEFIRST_OK;
+        }
+    }
+    return result;
+}
+
 
@@ -831,89 +831,97 @@ static bool validateModel_vs_Multitree(void* startAddress, SCHEMA_MODEL_TYPE_HAN
                 else
                 {
                     const char *childName_str = STRING_c_str(childName);
-                    SCHEMA_MODEL_ELEMENT elementType = Schema_GetModelElementByName(modelHandle, childName_str);
-                    switch (elementType.elementType)
+                    if (childName_str[0] == '$')
                     {
-                        default:
-                        {
-                            LogError("INTERNAL ERROR: unexpected function return");
-                            i = nChildren;
-                            break;
-                        }
-                        case (SCHEMA_PROPERTY):
-                        {
-                            LogError("cannot ingest name (WITH_DATA instead of WITH_DESIRED_PROPERTY): %s", STRING_c_str);
-                            i = nChildren;
-                            break;
-                        }
-                        case (SCHEMA_REPORTED_PROPERTY):
-                        {
-                            LogError("cannot ingest name (WITH_REPORTED_PROPERTY instead of WITH_DESIRED_PROPERTY): %s", STRING_c_str);
-                            i = nChildren;
-                            break;
-                        }
-                        case (SCHEMA_DESIRED_PROPERTY):
+                        /*Codes_SRS_COMMAND_DECODER_01_017: [ Children whose name starts with '$' (such as "$version" and "$metadata") are service metadata and shall be skipped. ]*/
+                        nProcessedChildren++;
+                    }
+                    else
+                    {
+                        SCHEMA_MODEL_ELEMENT elementType = Schema_GetModelElementByName(modelHandle, childName_str);
+                        switch (elementType.elementType)
                         {
-                            /*Codes_SRS_COMMAND_DECODER_02_007: [ If the child name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the MULTITREE node. ]*/
-                            SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle = elementType.elementHandle.desiredPropertyHandle;
-                            
-                            const char* desiredPropertyType = Schema_GetModelDesiredPropertyType(desiredPropertyHandle);
-                            AGENT_DATA_TYPE output;
-                            if (DecodeValueFromNode(Schema_GetSchemaForModelType(modelHandle), &output, child, desiredPropertyType) != 0)
+                            default:
                             {
-                                LogError("failure in DecodeValueFromNode");
+                                LogError("INTERNAL ERROR: unexpected function return");
                                 i = nChildren;
+                                break;
                             }
-                            else
+                            case (SCHEMA_PROPERTY):
+                            {
+                                LogError("cannot ingest name (WITH_DATA instead of WITH_DESIRED_PROPERTY): %s", STRING_c_str);
+                                i = nChildren;
+                                break;
+                            }
+                            case (SCHEMA_REPORTED_PROPERTY):
+                            {
+                                LogError("cannot ingest name (WITH_REPORTED_PROPERTY instead of WITH_DESIRED_PROPERTY): %s", STRING_c_str);
+                                i = nChildren;
+                                break;
+                            }
+                            case (SCHEMA_DESIRED_PROPERTY):
                             {
-                                /*Codes_SRS_COMMAND_DECODER_02_008: [ The desired property shall be constructed in memory by calling pfDesiredPropertyFromAGENT_DATA_TYPE. ]*/
-                                pfDesiredPropertyFromAGENT_DATA_TYPE leFunction = Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(desiredPropertyHandle);
-                                if (leFunction(&output, (char*)startAddress + offset + Schema_GetModelDesiredProperty_offset(desiredPropertyHandle)) != 0)
+                                /*Codes_SRS_COMMAND_DECODER_02_007: [ If the child name corresponds to a desired property then an AGENT_DATA_TYPE shall be constructed from the MULTITREE node. ]*/
+                                SCHEMA_DESIRED_PROPERTY_HANDLE desiredPropertyHandle = elementType.elementHandle.desiredPropertyHandle;
+                            
+                                const char* desiredPropertyType = Schema_GetModelDesiredPropertyType(desiredPropertyHandle);
+                                AGENT_DATA_TYPE output;
+                                if (DecodeValueFromNode(Schema_GetSchemaForModelType(modelHandle), &output, child, desiredPropertyType) != 0)
                                 {
-                                    LogError("failure in a function that converts from AGENT_DATA_TYPE to C data");
+                                    LogError("failure in DecodeValueFromNode");
+                                    i = nChildren;
                                 }
                                 else
                                 {
-                                    /*Codes_SRS_COMMAND_DECODER_02_013: [ If the desired property has a non-NULL pfOnDesiredProperty then it shall be called. ]*/
-                                    pfOnDesiredProperty onDesiredProperty = Schema_GetModelDesiredProperty_pfOnDesiredProperty(desiredPropertyHandle);
-                                    if (onDesiredProperty != NULL)
+                                    /*Codes_SRS_COMMAND_DECODER_02_008: [ The desired property shall be constructed in memory by calling pfDesiredPropertyFromAGENT_DATA_TYPE. ]*/
+                                    pfDesiredPropertyFromAGENT_DATA_TYPE leFunction = Schema_GetModelDesiredProperty_pfDesiredPropertyFromAGENT_DATA_TYPE(desiredPropertyHandle);
+                                    if (leFunction(&output, (char*)startAddress + offset + Schema_GetModelDesiredProperty_offset(desiredPropertyHandle)) != 0)
                                     {
-                                        onDesiredProperty((char*)startAddress + offset);
+                                        LogError("failure in a function that converts from AGENT_DATA_TYPE to C data");
                                     }
-                                    nProcessedChildren++;
+                                    else
+                                    {
+                                        /*Codes_SRS_COMMAND_DECODER_02_013: [ If the desired property has a non-NULL pfOnDesiredProperty then it shall be called. ]*/
+                                        pfOnDesiredProperty onDesiredProperty = Schema_GetModelDesiredProperty_pfOnDesiredProperty(desiredPropertyHandle);
+                                        if (onDesiredProperty != NULL)
+                                        {
+                                            onDesiredProperty((char*)startAddress + offset);
+                                        }
+                                        nProcessedChildren++;
+                                    }
+                                    Destroy_AGENT_DATA_TYPE(&output);
                                 }
-                                Destroy_AGENT_DATA_TYPE(&output);
-                            }
                             
-                            break;
-                        }
-                        case(SCHEMA_MODEL_IN_MODEL):
-                        {
-                            SCHEMA_MODEL_TYPE_HANDLE modelModel = elementType.elementHandle.modelHandle;
-                            
-                            /*Codes_SRS_COMMAND_DECODER_02_009: [ If the child name corresponds to a model in model then the function shall call itself recursively. ]*/
-                            if (!validateModel_vs_Multitree(startAddress, modelModel, child, offset + Schema_GetModelModelByName_Offset(modelHandle, childName_str)))
-                            {
-                                LogError("failure in validateModel_vs_Multitree");
-                                i = nChildren;
+                                break;
                             }
-                            else
+                            case(SCHEMA_MODEL_IN_MODEL):
                             {
-                                /*if the model in model so happened to be a WITH_DESIRED_PROPERTY... (only those has non_NULL pfOnDesiredProperty) */
-                                /*Codes_SRS_COMMAND_DECODER_02_012: [ If the child model in model has a non-NULL pfOnDesiredProperty then pfOnDesiredProperty shall be called. ]*/
-                                pfOnDesiredProperty onDesiredProperty = Schema_GetModelModelByName_OnDesiredProperty(modelHandle, childName_str);
-                                if (onDesiredProperty != NULL)
+                                SCHEMA_MODEL_TYPE_HANDLE modelModel = elementType.elementHandle.modelHandle;
+                            
+                                /*Codes_SRS_COMMAND_DECODER_02_009: [ If the child name corresponds to a model in model then the function shall call itself recursively. ]*/
+                                if (!validateModel_vs_Multitree(startAddress, modelModel, child, offset + Schema_GetModelModelByName_Offset(modelHandle, childName_str)))
                                 {
-                                    onDesiredProperty((char*)startAddress + offset);
+                                    LogError("failure in validateModel_vs_Multitree");
+                                    i = nChildren;
                                 }
+                                else
+                                {
+                                    /*if the model in model so happened to be a WITH_DESIRED_PROPERTY... (only those has non_NULL pfOnDesiredProperty) */
+                                    /*Codes_SRS_COMMAND_DECODER_02_012: [ If the child model in model has a non-NULL pfOnDesiredProperty then pfOnDesiredProperty shall be called. ]*/
+                                    pfOnDesiredProperty onDesiredProperty = Schema_GetModelModelByName_OnDesiredProperty(modelHandle, childName_str);
+                                    if (onDesiredProperty != NULL)
+                                    {
+                                        onDesiredProperty((char*)startAddress + offset);
+                                    }
                                 
-                                nProcessedChildren++;
-                            }
+                                    nProcessedChildren++;
+                                }
                             
-                            break;
-                        }
+                                break;
+                            }
 
-                    } /*switch*/
+                        } /*switch*/
+                    }
                 }
                 STRING_delete(childName);
             }
@@ -940,6 +948,37 @@ static EXECUTE_COMMAND_RESULT DecodeDesiredProperties(void* startAddress, COMMAN
     return validateModel_vs_Multitree(startAddress, handle->ModelHandle, desiredPropertiesTree, 0 )?EXECUTE_COMMAND_SUCCESS:EXECUTE_COMMAND_FAILED;
 }
 
+/*decodes the JSON in jsonPayload in place - the MULTITREE values point into jsonPayload - and applies it to the device*/
+static EXECUTE_COMMAND_RESULT IngestDesiredPropertiesInPlace(void* startAddress, COMMAND_DECODER_HANDLE_DATA* handle, char* jsonPayload, bool parseDesiredNode)
+{
+    EXECUTE_COMMAND_RESULT result;
+    MULTITREE_HANDLE desiredPropertiesTree;
+    if (JSONDecoder_JSON_To_MultiTree(jsonPayload, &desiredPropertiesTree) != JSON_DECODER_OK)
+    {
+        LogError("Decoding JSON to a multi tree failed");
+        result = EXECUTE_COMMAND_ERROR;
+    }
+    else
+    {
+        MULTITREE_HANDLE desiredNode = desiredPropertiesTree;
+        /*Codes_SRS_COMMAND_DECODER_01_020: [ If parseDesiredNode is true then CommandDecoder_IngestDesiredPropertiesInPlace shall only ingest the "desired" child of the MULTITREE. ]*/
+        if (parseDesiredNode && (MultiTree_GetChildByName(desiredPropertiesTree, "desired", &desiredNode) != MULTITREE_OK))
+        {
+            /*Codes_SRS_COMMAND_DECODER_01_021: [ If parseDesiredNode is true and there is no "desired" child then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+            LogError("unable to find \"desired\" in the device twin");
+            result = EXECUTE_COMMAND_FAILED;
+        }
+        else
+        {
+            /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
+            result = DecodeDesiredProperties(startAddress, handle, desiredNode);
+        }
+
+        MultiTree_Destroy(desiredPropertiesTree);
+    }
+    return result;
+}
+
 EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredProperties(void* startAddress, COMMAND_DECODER_HANDLE handle, const char* desiredProperties)
 {
     EXECUTE_COMMAND_RESULT result;
@@ -967,23 +1006,30 @@ EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredProperties(void* startAddress
         else
         {
             /*Codes_SRS_COMMAND_DECODER_02_005: [ CommandDecoder_IngestDesiredProperties shall create a MULTITREE_HANDLE ouf of the clone of desiredProperties. ]*/
-            MULTITREE_HANDLE desiredPropertiesTree;
-            if (JSONDecoder_JSON_To_MultiTree(copy, &desiredPropertiesTree) != JSON_DECODER_OK)
-            {
-                LogError("Decoding JSON to a multi tree failed");
-                result = EXECUTE_COMMAND_ERROR;
-            }
-            else
-            {
-                COMMAND_DECODER_HANDLE_DATA* commandDecoderInstance = (COMMAND_DECODER_HANDLE_DATA*)handle;
-
-                /*Codes_SRS_COMMAND_DECODER_02_006: [ CommandDecoder_IngestDesiredProperties shall parse the MULTITREEE recursively. ]*/
-                result = DecodeDesiredProperties(startAddress, commandDecoderInstance, desiredPropertiesTree);
-
-                MultiTree_Destroy(desiredPropertiesTree);
-            }
+            result = IngestDesiredPropertiesInPlace(startAddress, (COMMAND_DECODER_HANDLE_DATA*)handle, copy, false);
             free(copy);
         }
     }
     return result;
 }
+
+EXECUTE_COMMAND_RESULT CommandDecoder_IngestDesiredPropertiesInPlace(void* startAddress, COMMAND_DECODER_HANDLE handle, char* jsonPayload, bool parseDesiredNode)
+{
+    EXECUTE_COMMAND_RESULT result;
+    /*Codes_SRS_COMMAND_DECODER_01_018: [ If startAddress, handle or jsonPayload is NULL then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    if (
+        (startAddress == NULL) ||
+        (handle == NULL) ||
+        (jsonPayload == NULL)
+        )
+    {
+        LogError("invalid argument void* startAddress=%p, COMMAND_DECODER_HANDLE handle=%p, char* jsonPayload=%p", startAddress, handle, jsonPayload);
+        result = EXECUTE_COMMAND_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_COMMAND_DECODER_01_019: [ CommandDecoder_IngestDesiredPropertiesInPlace shall create a MULTITREE_HANDLE out of jsonPayload without copying it. ]*/
+        result = IngestDesiredPropertiesInPlace(startAddress, (COMMAND_DECODER_HANDLE_DATA*)handle, jsonPayload, parseDesiredNode);
+    }
+    return result;
+}
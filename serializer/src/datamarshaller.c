@@ -121,7 +121,8 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarsha
         if (i == valueCount)
         {
             /* Codes_SRS_DATA_MARSHALLER_99_037:[DataMarshaller shall store as MultiTree the data to be encoded by the JSONEncoder module.] */
-            if ((treeHandle = MultiTree_Create(NoCloneFunction, NoFreeFunction)) == NULL)
+            /* Codes_SRS_DATA_MARSHALLER_01_005: [ The MultiTree shall be created with MultiTree_CreateWithArena. ]*/
+            if ((treeHandle = MultiTree_CreateWithArena(NoCloneFunction, NoFreeFunction)) == NULL)
             {
                 /* Codes_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
                 result = DATA_MARSHALLER_MULTITREE_ERROR;
@@ -209,7 +210,7 @@ DATA_MARSHALLER_RESULT DataMarshaller_SendData(DATA_MARSHALLER_HANDLE dataMarsha
                     }
                 } /* if (j==valueCount)*/
                 MultiTree_Destroy(treeHandle);
-            } /* MultiTree_Create */
+            } /* MultiTree_CreateWithArena */
         }
     }
 
@@ -5,6 +5,7 @@
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "datapublisher.h"
 #include "jsonencoder.h"
 #include "datamarshaller.h"
@@ -20,6 +21,9 @@ DEFINE_ENUM_STRINGS(DATA_PUBLISHER_RESULT, DATA_PUBLISHER_RESULT_VALUES)
     LogError("(result = %s)", ENUM_TO_STRING(DATA_PUBLISHER_RESULT, result))
 
 #define DEFAULT_MAX_BUFFER_SIZE 10240
+
+/*transactions with fewer values look for duplicate property paths linearly, transactions with more values use a hash index*/
+#define PATH_INDEX_THRESHOLD 8
 /* Codes_SRS_DATA_PUBLISHER_99_066:[ A single value shall be used by all instances of DataPublisher.] */
 /* Codes_SRS_DATA_PUBLISHER_99_067:[ Before any call to DataPublisher_SetMaxBufferSize, the default max buffer size shall be equal to 10KB.] */
 static size_t maxBufferSize_ = DEFAULT_MAX_BUFFER_SIZE;
@@ -35,8 +39,112 @@ typedef struct TRANSACTION_HANDLE_DATA_TAG
     DATA_PUBLISHER_HANDLE_DATA* DataPublisherInstance;
     size_t ValueCount;
     DATA_MARSHALLER_VALUE* Values;
+    size_t* PathIndex; /*open addressing table of (position in Values + 1), 0 is an empty slot. NULL when Values is searched linearly*/
+    size_t PathIndexSlots; /*always a power of 2*/
 } TRANSACTION_HANDLE_DATA;
 
+/*FNV-1a*/
+static uint32_t hashPropertyPath(const char* propertyPath)
+{
+    uint32_t result = 2166136261u;
+    while (*propertyPath != '\0')
+    {
+        result ^= (unsigned char)*propertyPath;
+        result *= 16777619u;
+        propertyPath++;
+    }
+    return result;
+}
+
+static void placeValueInPathIndex(size_t* pathIndex, size_t pathIndexSlots, const char* propertyPath, size_t position)
+{
+    size_t mask = pathIndexSlots - 1;
+    size_t slot = hashPropertyPath(propertyPath) & mask;
+    while (pathIndex[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    pathIndex[slot] = position + 1;
+}
+
+/*called after a value has been appended to transaction->Values. The index is an optimization only: when it cannot be
+allocated the transaction goes back to linear search and nothing fails*/
+static void indexLastValue(TRANSACTION_HANDLE_DATA* transaction)
+{
+    if (transaction->ValueCount >= PATH_INDEX_THRESHOLD)
+    {
+        if ((transaction->PathIndex != NULL) && (transaction->ValueCount * 2 <= transaction->PathIndexSlots))
+        {
+            placeValueInPathIndex(transaction->PathIndex, transaction->PathIndexSlots, transaction->Values[transaction->ValueCount - 1].PropertyPath, transaction->ValueCount - 1);
+        }
+        else
+        {
+            size_t newSlots = (transaction->PathIndexSlots == 0) ? PATH_INDEX_THRESHOLD * 4 : transaction->PathIndexSlots * 2;
+            size_t* newIndex;
+            /*after a failed allocation PathIndexSlots is 0 while the transaction can hold any number of values, and the
+            table needs a free slot for each of them*/
+            while (newSlots < transaction->ValueCount * 2)
+            {
+                newSlots *= 2;
+            }
+            newIndex = (size_t*)malloc(sizeof(size_t) * newSlots);
+            if (transaction->PathIndex != NULL)
+            {
+                free(transaction->PathIndex);
+            }
+            if (newIndex == NULL)
+            {
+                transaction->PathIndex = NULL;
+                transaction->PathIndexSlots = 0;
+            }
+            else
+            {
+                size_t i;
+                (void)memset(newIndex, 0, sizeof(size_t) * newSlots);
+                for (i = 0; i < transaction->ValueCount; i++)
+                {
+                    placeValueInPathIndex(newIndex, newSlots, transaction->Values[i].PropertyPath, i);
+                }
+                transaction->PathIndex = newIndex;
+                transaction->PathIndexSlots = newSlots;
+            }
+        }
+    }
+}
+
+static DATA_MARSHALLER_VALUE* findValueByPath(TRANSACTION_HANDLE_DATA* transaction, const char* propertyPath)
+{
+    DATA_MARSHALLER_VALUE* result = NULL;
+    if (transaction->PathIndex != NULL)
+    {
+        size_t mask = transaction->PathIndexSlots - 1;
+        size_t slot = hashPropertyPath(propertyPath) & mask;
+        while (transaction->PathIndex[slot] != 0)
+        {
+            DATA_MARSHALLER_VALUE* value = &transaction->Values[transaction->PathIndex[slot] - 1];
+            if (strcmp(value->PropertyPath, propertyPath) == 0)
+            {
+                result = value;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < transaction->ValueCount; i++)
+        {
+            if (strcmp(transaction->Values[i].PropertyPath, propertyPath) == 0)
+            {
+                result = &transaction->Values[i];
+                break;
+            }
+        }
+    }
+    return result;
+}
+
 typedef struct REPORTED_PROPERTIES_TRANSACTION_HANDLE_DATA_TAG
 {
     DATA_PUBLISHER_HANDLE_DATA* DataPublisherInstance;
@@ -114,6 +222,8 @@ TRANSACTION_HANDLE DataPublisher_StartTransaction(DATA_PUBLISHER_HANDLE dataPubl
         {
             transaction->ValueCount = 0;
             transaction->Values = NULL;
+            transaction->PathIndex = NULL;
+            transaction->PathIndexSlots = 0;
             transaction->DataPublisherInstance = (DATA_PUBLISHER_HANDLE_DATA*)dataPublisherHandle;
         }
     }
@@ -174,18 +284,10 @@ DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transac
         }
         else
         {
-            size_t i;
-            DATA_MARSHALLER_VALUE* propertySlot = NULL;
-
             /* Codes_SRS_DATA_PUBLISHER_99_019:[ If the same property is associated twice with a transaction, then the last value shall be kept associated with the transaction.] */
-            for (i = 0; i < transaction->ValueCount; i++)
-            {
-                if (strcmp(transaction->Values[i].PropertyPath, propertyPath) == 0)
-                {
-                    propertySlot = &transaction->Values[i];
-                    break;
-                }
-            }
+            /* Codes_SRS_DATA_PUBLISHER_01_002: [ Once a transaction holds 8 or more values, DataPublisher_PublishTransacted shall find an already associated property path without comparing it to every value of the transaction. ]*/
+            DATA_MARSHALLER_VALUE* propertySlot = findValueByPath(transaction, propertyPath);
+            bool isNewPath = false;
 
             if (propertySlot == NULL)
             {
@@ -197,6 +299,7 @@ DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transac
                     propertySlot->Value = NULL;
                     propertySlot->PropertyPath = NULL;
                     transaction->ValueCount++;
+                    isNewPath = true;
                 }
             }
 
@@ -226,6 +329,10 @@ DATA_PUBLISHER_RESULT DataPublisher_PublishTransacted(TRANSACTION_HANDLE transac
                 /* Codes_SRS_DATA_PUBLISHER_99_016:[ When DataPublisher_PublishTransacted is invoked, DataPublisher shall associate the data with the transaction identified by the transactionHandle argument and return DATA_PUBLISHER_OK. No data shall be dispatched at the time of the call.] */
                 propertySlot->PropertyPath = propertyPathCopy;
                 propertySlot->Value = propertyValue;
+                if (isNewPath)
+                {
+                    indexLastValue(transaction);
+                }
 
                 result = DATA_PUBLISHER_OK;
             }
@@ -307,6 +414,10 @@ DATA_PUBLISHER_RESULT DataPublisher_CancelTransaction(TRANSACTION_HANDLE transac
 
         /* Codes_SRS_DATA_PUBLISHER_99_015:[ DataPublisher_CancelTransaction shall dispose of any resources associated with the transaction.] */
         free(transaction->Values);
+        if (transaction->PathIndex != NULL)
+        {
+            free(transaction->PathIndex);
+        }
         free(transaction);
 
         /* Codes_SRS_DATA_PUBLISHER_99_013:[ A call to DataPublisher_CancelTransaction shall dispose of the transaction without dispatching
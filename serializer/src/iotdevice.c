@@ -448,3 +448,35 @@ DEVICE_RESULT Device_IngestDesiredProperties(void* startAddress, DEVICE_HANDLE d
     }
     return result;
 }
+
+DEVICE_RESULT Device_IngestDesiredPropertiesInPlace(void* startAddress, DEVICE_HANDLE deviceHandle, char* jsonPayload, bool parseDesiredNode)
+{
+    DEVICE_RESULT result;
+    /*Codes_SRS_DEVICE_01_056: [ If startAddress, deviceHandle or jsonPayload is NULL then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_INVALID_ARG. ]*/
+    if (
+        (deviceHandle == NULL) ||
+        (jsonPayload == NULL) ||
+        (startAddress == NULL)
+        )
+    {
+        LogError("invalid argument void* startAddress=%p, DEVICE_HANDLE deviceHandle=%p, char* jsonPayload=%p\n", startAddress, deviceHandle, jsonPayload);
+        result = DEVICE_INVALID_ARG;
+    }
+    else
+    {
+        /*Codes_SRS_DEVICE_01_057: [ Device_IngestDesiredPropertiesInPlace shall call CommandDecoder_IngestDesiredPropertiesInPlace passing jsonPayload and parseDesiredNode. ]*/
+        DEVICE_HANDLE_DATA* device = (DEVICE_HANDLE_DATA*)deviceHandle;
+        if (CommandDecoder_IngestDesiredPropertiesInPlace(startAddress, device->commandDecoderHandle, jsonPayload, parseDesiredNode) != EXECUTE_COMMAND_SUCCESS)
+        {
+            /*Codes_SRS_DEVICE_01_058: [ If CommandDecoder_IngestDesiredPropertiesInPlace fails then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_ERROR. ]*/
+            LogError("failure in CommandDecoder_IngestDesiredPropertiesInPlace");
+            result = DEVICE_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_DEVICE_01_059: [ Otherwise, Device_IngestDesiredPropertiesInPlace shall succeed and return DEVICE_OK. ]*/
+            result = DEVICE_OK;
+        }
+    }
+    return result;
+}
@@ -591,7 +591,8 @@ JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char* json, MULTITREE_HANDLE*
         /* Codes_SRS_JSON_DECODER_99_008:[ JSONDecoder_JSON_To_MultiTree shall create a multi tree based on the json string argument.] */
         /* Codes_SRS_JSON_DECODER_99_002:[ JSONDecoder_JSON_To_MultiTree shall use the MultiTree APIs to create the multi tree and add leafs to the multi tree.] */
         /* Codes_SRS_JSON_DECODER_99_009:[ On success, JSONDecoder_JSON_To_MultiTree shall return a handle to the multi tree it created in the multiTreeHandle argument and it shall return JSON_DECODER_OK.] */
-        *multiTreeHandle = MultiTree_Create(NOPCloneFunction, NoFreeFunction);
+        /* Codes_SRS_JSON_DECODER_01_001: [ JSONDecoder_JSON_To_MultiTree shall create the multi tree with MultiTree_CreateWithArena. ]*/
+        *multiTreeHandle = MultiTree_CreateWithArena(NOPCloneFunction, NoFreeFunction);
         if (*multiTreeHandle == NULL)
         {
             /* Codes_SRS_JSON_DECODER_99_038:[ If any MultiTree API fails, JSONDecoder_JSON_To_MultiTree shall return JSON_DECODER_MULTITREE_FAILED.] */
@@ -1,13 +1,29 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
 
+#include <string.h>
+#include <math.h>
 #include "jsonencoder.h"
+#include "agenttypesystem.h"
+#include "numberformat.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/strings.h"
 
+/*the JSON_ENCODER_BUFFER writers produce byte for byte what AgentDataTypes_ToString produces for the same value*/
+#define NaN_STRING "NaN"
+#define MINUSINF_STRING "-INF"
+#define PLUSINF_STRING "INF"
+
+/*most telemetry messages fit in the first allocation*/
+#define JSON_ENCODER_BUFFER_INITIAL_CAPACITY 128
+
+static const char hexDigits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
 #ifdef _MSC_VER
 #pragma warning(disable: 4701) /* potentially uninitialized local variable 'result' used */ /* the scanner cannot track variable "i" and link it to childCount*/
 #endif
@@ -216,3 +232,341 @@ JSON_ENCODER_TOSTRING_RESULT JSONEncoder_CharPtr_ToString(STRING_HANDLE destinat
 
     return result;
 }
+
+static int reserveBuffer(JSON_ENCODER_BUFFER* destination, size_t length)
+{
+    int result;
+    if (destination->capacity - destination->size >= length)
+    {
+        result = 0;
+    }
+    else if (length > SIZE_MAX / 2 - destination->size)
+    {
+        LogError("JSON object would exceed SIZE_MAX");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t newCapacity = (destination->capacity == 0) ? JSON_ENCODER_BUFFER_INITIAL_CAPACITY : destination->capacity;
+        unsigned char* newBuffer;
+        while (newCapacity - destination->size < length)
+        {
+            newCapacity *= 2;
+        }
+
+        if ((newBuffer = (unsigned char*)realloc(destination->buffer, newCapacity)) == NULL)
+        {
+            LogError("unable to grow the JSON buffer to %zu bytes", newCapacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            destination->buffer = newBuffer;
+            destination->capacity = newCapacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static JSON_ENCODER_RESULT appendToBuffer(JSON_ENCODER_BUFFER* destination, const char* source, size_t length)
+{
+    JSON_ENCODER_RESULT result;
+    if (reserveBuffer(destination, length) != 0)
+    {
+        result = JSON_ENCODER_ERROR;
+    }
+    else
+    {
+        (void)memcpy(destination->buffer + destination->size, source, length);
+        destination->size += length;
+        result = JSON_ENCODER_OK;
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_BeginObject(JSON_ENCODER_BUFFER* destination)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_001: [ If destination is NULL, JSONEncoder_BeginObject shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_002: [ JSONEncoder_BeginObject shall empty destination, keeping any memory it already owns, and then add "{" to it. ]*/
+        destination->size = 0;
+        destination->memberCount = 0;
+        /*Codes_SRS_JSON_ENCODER_01_003: [ If growing the buffer fails, JSONEncoder_BeginObject shall return JSON_ENCODER_ERROR. ]*/
+        result = appendToBuffer(destination, "{", 1);
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteMemberName(JSON_ENCODER_BUFFER* destination, const char* jsonName, size_t jsonNameLength)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_004: [ If destination or jsonName is NULL, JSONEncoder_WriteMemberName shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if ((destination == NULL) || (jsonName == NULL))
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    /*Codes_SRS_JSON_ENCODER_01_005: [ JSONEncoder_WriteMemberName shall add ", " to destination, unless this is the first member of the object. ]*/
+    else if ((destination->memberCount > 0) &&
+        (appendToBuffer(destination, ", ", 2) != JSON_ENCODER_OK))
+    {
+        /*Codes_SRS_JSON_ENCODER_01_007: [ If growing the buffer fails, JSONEncoder_WriteMemberName shall return JSON_ENCODER_ERROR. ]*/
+        result = JSON_ENCODER_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_006: [ JSONEncoder_WriteMemberName shall then add the first jsonNameLength characters of jsonName, which are expected to be the quoted name followed by ":". ]*/
+        /*Codes_SRS_JSON_ENCODER_01_007: [ If growing the buffer fails, JSONEncoder_WriteMemberName shall return JSON_ENCODER_ERROR. ]*/
+        result = appendToBuffer(destination, jsonName, jsonNameLength);
+        if (result == JSON_ENCODER_OK)
+        {
+            destination->memberCount++;
+        }
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteInt64(JSON_ENCODER_BUFFER* destination, int64_t value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_008: [ If destination is NULL, JSONEncoder_WriteInt64 shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_009: [ JSONEncoder_WriteInt64 shall add the decimal representation of value to destination, preceded by "-" when value is negative. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_010: [ If growing the buffer fails, JSONEncoder_WriteInt64 shall return JSON_ENCODER_ERROR. ]*/
+        char temp[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+        size_t length = NumberFormat_Int64(temp, value);
+        result = appendToBuffer(destination, temp, length);
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteBool(JSON_ENCODER_BUFFER* destination, bool value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_011: [ If destination is NULL, JSONEncoder_WriteBool shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_012: [ JSONEncoder_WriteBool shall add "true" or "false" to destination. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_013: [ If growing the buffer fails, JSONEncoder_WriteBool shall return JSON_ENCODER_ERROR. ]*/
+        result = value ? appendToBuffer(destination, "true", 4) : appendToBuffer(destination, "false", 5);
+    }
+    return result;
+}
+
+#ifndef NO_FLOATS
+static JSON_ENCODER_RESULT writeFloatingPoint(JSON_ENCODER_BUFFER* destination, double value, bool isSinglePrecision)
+{
+    JSON_ENCODER_RESULT result;
+    if (ISNAN(value))
+    {
+        result = appendToBuffer(destination, NaN_STRING, sizeof(NaN_STRING) - 1);
+    }
+    else if (ISNEGATIVEINFINITY(value))
+    {
+        result = appendToBuffer(destination, MINUSINF_STRING, sizeof(MINUSINF_STRING) - 1);
+    }
+    else if (ISPOSITIVEINFINITY(value))
+    {
+        result = appendToBuffer(destination, PLUSINF_STRING, sizeof(PLUSINF_STRING) - 1);
+    }
+    else
+    {
+        char temp[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+        size_t length = isSinglePrecision ? NumberFormat_Float(temp, (float)value) : NumberFormat_Double(temp, value);
+        result = appendToBuffer(destination, temp, length);
+    }
+    return result;
+}
+#endif
+
+JSON_ENCODER_RESULT JSONEncoder_WriteDouble(JSON_ENCODER_BUFFER* destination, double value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_014: [ If destination is NULL, JSONEncoder_WriteDouble shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+#ifndef NO_FLOATS
+        /*Codes_SRS_JSON_ENCODER_01_015: [ JSONEncoder_WriteDouble shall add value to destination as AgentDataTypes_ToString does for EDM_DOUBLE: NaN, -INF, INF or the shortest digits that read back as value. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_016: [ Values outside of 1e-6 <= |value| < 1e21 shall be written in exponent notation. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_017: [ If growing the buffer fails, JSONEncoder_WriteDouble shall return JSON_ENCODER_ERROR. ]*/
+        result = writeFloatingPoint(destination, value, false);
+#else
+        (void)value;
+        result = JSON_ENCODER_VALUE_NOT_SUPPORTED;
+#endif
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteFloat(JSON_ENCODER_BUFFER* destination, float value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_018: [ If destination is NULL, JSONEncoder_WriteFloat shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+#ifndef NO_FLOATS
+        /*Codes_SRS_JSON_ENCODER_01_019: [ JSONEncoder_WriteFloat shall add value to destination as AgentDataTypes_ToString does for EDM_SINGLE: NaN, -INF, INF or the shortest digits that read back as value when read as a float. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_020: [ Values outside of 1e-6 <= |value| < 1e21 shall be written in exponent notation. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_021: [ If growing the buffer fails, JSONEncoder_WriteFloat shall return JSON_ENCODER_ERROR. ]*/
+        result = writeFloatingPoint(destination, (double)value, true);
+#else
+        (void)value;
+        result = JSON_ENCODER_VALUE_NOT_SUPPORTED;
+#endif
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteString(JSON_ENCODER_BUFFER* destination, const char* value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_022: [ If destination is NULL, JSONEncoder_WriteString shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    /*Codes_SRS_JSON_ENCODER_01_023: [ If value is NULL, JSONEncoder_WriteString shall return JSON_ENCODER_VALUE_NOT_SUPPORTED. ]*/
+    else if (value == NULL)
+    {
+        result = JSON_ENCODER_VALUE_NOT_SUPPORTED;
+    }
+    else
+    {
+        const unsigned char* v = (const unsigned char*)value;
+        size_t length = 2;
+        size_t i;
+
+        for (i = 0; v[i] != '\0'; i++)
+        {
+            if (v[i] >= 128)
+            {
+                break;
+            }
+            else if (v[i] <= 0x1F)
+            {
+                length += 6;
+            }
+            else if ((v[i] == '"') || (v[i] == '\\') || (v[i] == '/'))
+            {
+                length += 2;
+            }
+            else
+            {
+                length++;
+            }
+        }
+
+        if (v[i] != '\0')
+        {
+            /*Codes_SRS_JSON_ENCODER_01_024: [ If value contains characters above 127, JSONEncoder_WriteString shall return JSON_ENCODER_VALUE_NOT_SUPPORTED. ]*/
+            result = JSON_ENCODER_VALUE_NOT_SUPPORTED;
+        }
+        else if (reserveBuffer(destination, length) != 0)
+        {
+            /*Codes_SRS_JSON_ENCODER_01_026: [ If growing the buffer fails, JSONEncoder_WriteString shall return JSON_ENCODER_ERROR. ]*/
+            result = JSON_ENCODER_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_JSON_ENCODER_01_025: [ JSONEncoder_WriteString shall add value between quotes to destination, writing control characters as \u00XX and '"', '\\' and '/' preceded by '\\'. ]*/
+            unsigned char* w = destination->buffer + destination->size;
+            *w++ = '"';
+            for (i = 0; v[i] != '\0'; i++)
+            {
+                if (v[i] <= 0x1F)
+                {
+                    *w++ = '\\';
+                    *w++ = 'u';
+                    *w++ = '0';
+                    *w++ = '0';
+                    *w++ = (unsigned char)hexDigits[(v[i] & 0xF0) >> 4];
+                    *w++ = (unsigned char)hexDigits[v[i] & 0x0F];
+                }
+                else if ((v[i] == '"') || (v[i] == '\\') || (v[i] == '/'))
+                {
+                    *w++ = '\\';
+                    *w++ = v[i];
+                }
+                else
+                {
+                    *w++ = v[i];
+                }
+            }
+            *w = '"';
+            destination->size += length;
+            result = JSON_ENCODER_OK;
+        }
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_WriteStringNoQuotes(JSON_ENCODER_BUFFER* destination, const char* value)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_027: [ If destination is NULL, JSONEncoder_WriteStringNoQuotes shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    /*Codes_SRS_JSON_ENCODER_01_028: [ If value is NULL, JSONEncoder_WriteStringNoQuotes shall return JSON_ENCODER_VALUE_NOT_SUPPORTED. ]*/
+    else if (value == NULL)
+    {
+        result = JSON_ENCODER_VALUE_NOT_SUPPORTED;
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_029: [ JSONEncoder_WriteStringNoQuotes shall add value to destination as it is. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_030: [ If growing the buffer fails, JSONEncoder_WriteStringNoQuotes shall return JSON_ENCODER_ERROR. ]*/
+        result = appendToBuffer(destination, value, strlen(value));
+    }
+    return result;
+}
+
+JSON_ENCODER_RESULT JSONEncoder_EndObject(JSON_ENCODER_BUFFER* destination)
+{
+    JSON_ENCODER_RESULT result;
+    /*Codes_SRS_JSON_ENCODER_01_031: [ If destination is NULL, JSONEncoder_EndObject shall return JSON_ENCODER_INVALID_ARG. ]*/
+    if (destination == NULL)
+    {
+        result = JSON_ENCODER_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(JSON_ENCODER_RESULT, result));
+    }
+    else
+    {
+        /*Codes_SRS_JSON_ENCODER_01_032: [ JSONEncoder_EndObject shall add "}" to destination. ]*/
+        /*Codes_SRS_JSON_ENCODER_01_033: [ If growing the buffer fails, JSONEncoder_EndObject shall return JSON_ENCODER_ERROR. ]*/
+        result = appendToBuffer(destination, "}", 1);
+    }
+    return result;
+}
@@ -6,13 +6,48 @@
 
 #include "multitree.h"
 #include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/optimize_size.h"
 
 /*assume a name cannot be longer than 100 characters*/
 #define INNER_NODE_NAME_SIZE 128
 
+/*nodes with fewer children are searched linearly (comparing hashes first), nodes with more children get a hash index*/
+#define CHILD_INDEX_THRESHOLD 8
+
+/*trees created by MultiTree_CreateWithArena take their nodes, names, children arrays and child indexes from a chain of
+blocks that is freed only when the root is destroyed. The first block holds a tree of about 20 nodes, every next block
+is twice the size of the previous one*/
+#define ARENA_FIRST_BLOCK_SIZE 2048
+#define ARENA_FIRST_CHILDREN_CAPACITY 4
+
+typedef union ARENA_ALIGNMENT_TAG
+{
+    void* pointer;
+    double number;
+    size_t size;
+} ARENA_ALIGNMENT;
+
+#define ARENA_ROUND_UP(size) ((((size) + sizeof(ARENA_ALIGNMENT) - 1) / sizeof(ARENA_ALIGNMENT)) * sizeof(ARENA_ALIGNMENT))
+
+typedef struct ARENA_BLOCK_TAG
+{
+    struct ARENA_BLOCK_TAG* previous;
+    size_t size;
+    size_t used;
+} ARENA_BLOCK;
+
+#define ARENA_BLOCK_DATA(block) ((unsigned char*)(block) + ARENA_ROUND_UP(sizeof(ARENA_BLOCK)))
+
+typedef struct MULTITREE_ARENA_TAG
+{
+    ARENA_BLOCK* newestBlock; /*the arena itself lives at the start of the oldest block*/
+    struct MULTITREE_HANDLE_DATA_TAG* root;
+} MULTITREE_ARENA;
+
 DEFINE_ENUM_STRINGS(MULTITREE_RESULT, MULTITREE_RESULT_VALUES);
 
 typedef struct MULTITREE_HANDLE_DATA_TAG
@@ -23,8 +58,185 @@ typedef struct MULTITREE_HANDLE_DATA_TAG
     MULTITREE_FREE_FUNCTION freeFunction;
     size_t nChildren;
     struct MULTITREE_HANDLE_DATA_TAG** children; /*an array of nChildren count of MULTITREE_HANDLE_DATA*   */
+    uint32_t nameHash;
+    size_t nameLength;
+    size_t* childIndex; /*open addressing table of (position in children + 1), 0 is an empty slot. NULL when the children are searched linearly*/
+    size_t childIndexSlots; /*always a power of 2*/
+    MULTITREE_ARENA* arena; /*NULL for trees created by MultiTree_Create*/
+    size_t childrenCapacity; /*only used by arena trees, the others grow children one by one*/
 }MULTITREE_HANDLE_DATA;
 
+static void* allocateInArena(MULTITREE_ARENA* arena, size_t size)
+{
+    void* result;
+    ARENA_BLOCK* block = arena->newestBlock;
+    size = ARENA_ROUND_UP(size);
+    if (block->size - block->used < size)
+    {
+        size_t newBlockSize = (block->size * 2 < size) ? size : block->size * 2;
+        block = (ARENA_BLOCK*)malloc(ARENA_ROUND_UP(sizeof(ARENA_BLOCK)) + newBlockSize);
+        if (block == NULL)
+        {
+            LogError("unable to allocate an arena block of %lu bytes", (unsigned long)newBlockSize);
+        }
+        else
+        {
+            block->previous = arena->newestBlock;
+            block->size = newBlockSize;
+            block->used = 0;
+            arena->newestBlock = block;
+        }
+    }
+
+    if (block == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = ARENA_BLOCK_DATA(block) + block->used;
+        block->used += size;
+    }
+    return result;
+}
+
+static void destroyArena(MULTITREE_ARENA* arena)
+{
+    ARENA_BLOCK* block = arena->newestBlock;
+    while (block != NULL)
+    {
+        ARENA_BLOCK* previous = block->previous;
+        free(block);
+        block = previous;
+    }
+}
+
+static void* allocateInTree(MULTITREE_ARENA* arena, size_t size)
+{
+    return (arena == NULL) ? malloc(size) : allocateInArena(arena, size);
+}
+
+/*memory taken from an arena is given back only when the whole arena is destroyed*/
+static void freeInTree(MULTITREE_ARENA* arena, void* ptr)
+{
+    if (arena == NULL)
+    {
+        free(ptr);
+    }
+}
+
+/*FNV-1a, the length is explicit so that segments of a path can be hashed in place*/
+static uint32_t hashName(const char* name, size_t nameLength)
+{
+    uint32_t result = 2166136261u;
+    size_t i;
+    for (i = 0; i < nameLength; i++)
+    {
+        result ^= (unsigned char)name[i];
+        result *= 16777619u;
+    }
+    return result;
+}
+
+static void placeChildInIndex(size_t* childIndex, size_t childIndexSlots, uint32_t hash, size_t position)
+{
+    size_t mask = childIndexSlots - 1;
+    size_t slot = hash & mask;
+    while (childIndex[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    childIndex[slot] = position + 1;
+}
+
+/*called after a child has been appended to node->children. The index is an optimization only: when it cannot be
+allocated the node goes back to linear search and nothing fails*/
+static void indexLastChild(MULTITREE_HANDLE_DATA* node)
+{
+    if (node->nChildren >= CHILD_INDEX_THRESHOLD)
+    {
+        if ((node->childIndex != NULL) && (node->nChildren * 2 <= node->childIndexSlots))
+        {
+            placeChildInIndex(node->childIndex, node->childIndexSlots, node->children[node->nChildren - 1]->nameHash, node->nChildren - 1);
+        }
+        else
+        {
+            size_t newSlots = (node->childIndexSlots == 0) ? CHILD_INDEX_THRESHOLD * 4 : node->childIndexSlots * 2;
+            size_t* newIndex;
+            /*after a failed allocation childIndexSlots is 0 while the node can have any number of children, and the
+            table needs a free slot for each of them*/
+            while (newSlots < node->nChildren * 2)
+            {
+                newSlots *= 2;
+            }
+            newIndex = (size_t*)allocateInTree(node->arena, sizeof(size_t) * newSlots);
+            if (node->childIndex != NULL)
+            {
+                freeInTree(node->arena, node->childIndex);
+            }
+            if (newIndex == NULL)
+            {
+                node->childIndex = NULL;
+                node->childIndexSlots = 0;
+            }
+            else
+            {
+                size_t i;
+                (void)memset(newIndex, 0, sizeof(size_t) * newSlots);
+                for (i = 0; i < node->nChildren; i++)
+                {
+                    placeChildInIndex(newIndex, newSlots, node->children[i]->nameHash, i);
+                }
+                node->childIndex = newIndex;
+                node->childIndexSlots = newSlots;
+            }
+        }
+    }
+}
+
+static int childHasName(const MULTITREE_HANDLE_DATA* child, uint32_t hash, const char* name, size_t nameLength)
+{
+    return
+        (child->nameHash == hash) &&
+        (child->nameLength == nameLength) &&
+        (memcmp(child->name, name, nameLength) == 0);
+}
+
+/*return NULL if a child with the name (which does not have to be '\0' terminated) doesn't exist*/
+static MULTITREE_HANDLE_DATA* findChild(const MULTITREE_HANDLE_DATA* node, const char* name, size_t nameLength)
+{
+    MULTITREE_HANDLE_DATA* result = NULL;
+    uint32_t hash = hashName(name, nameLength);
+    if (node->childIndex != NULL)
+    {
+        size_t mask = node->childIndexSlots - 1;
+        size_t slot = hash & mask;
+        while (node->childIndex[slot] != 0)
+        {
+            MULTITREE_HANDLE_DATA* child = node->children[node->childIndex[slot] - 1];
+            if (childHasName(child, hash, name, nameLength))
+            {
+                result = child;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < node->nChildren; i++)
+        {
+            if (childHasName(node->children[i], hash, name, nameLength))
+            {
+                result = node->children[i];
+                break;
+            }
+        }
+    }
+    return result;
+}
+
 
 MULTITREE_HANDLE MultiTree_Create(MULTITREE_CLONE_FUNCTION cloneFunction, MULTITREE_FREE_FUNCTION freeFunction)
 {
@@ -51,6 +263,12 @@ MULTITREE_HANDLE MultiTree_Create(MULTITREE_CLONE_FUNCTION cloneFunction, MULTIT
             result->freeFunction = freeFunction;
             result->nChildren = 0;
             result->children = NULL;
+            result->nameHash = 0;
+            result->nameLength = 0;
+            result->childIndex = NULL;
+            result->childIndexSlots = 0;
+            result->arena = NULL;
+            result->childrenCapacity = 0;
         }
         else
         {
@@ -61,20 +279,129 @@ MULTITREE_HANDLE MultiTree_Create(MULTITREE_CLONE_FUNCTION cloneFunction, MULTIT
     return (MULTITREE_HANDLE)result;
 }
 
+MULTITREE_HANDLE MultiTree_CreateWithArena(MULTITREE_CLONE_FUNCTION cloneFunction, MULTITREE_FREE_FUNCTION freeFunction)
+{
+    MULTITREE_HANDLE_DATA* result;
+
+    /* Codes_SRS_MULTITREE_01_004: [ If any of the arguments passed to MultiTree_CreateWithArena is NULL, the call shall return NULL. ]*/
+    if ((cloneFunction == NULL) ||
+        (freeFunction == NULL))
+    {
+        LogError("CloneFunction or FreeFunction is Null.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_MULTITREE_01_003: [ MultiTree_CreateWithArena shall create a new tree whose nodes, node names, children arrays and child indexes are all allocated from an arena owned by the root of the tree. ]*/
+        ARENA_BLOCK* firstBlock = (ARENA_BLOCK*)malloc(ARENA_ROUND_UP(sizeof(ARENA_BLOCK)) + ARENA_FIRST_BLOCK_SIZE);
+        if (firstBlock == NULL)
+        {
+            /* Codes_SRS_MULTITREE_01_005: [ MultiTree_CreateWithArena shall return NULL if the tree has not been successfully created. ]*/
+            LogError("MultiTree_CreateWithArena failed because malloc failed");
+            result = NULL;
+        }
+        else
+        {
+            MULTITREE_ARENA* arena = (MULTITREE_ARENA*)ARENA_BLOCK_DATA(firstBlock);
+            firstBlock->previous = NULL;
+            firstBlock->size = ARENA_FIRST_BLOCK_SIZE;
+            firstBlock->used = ARENA_ROUND_UP(sizeof(MULTITREE_ARENA));
+            arena->newestBlock = firstBlock;
+
+            /*the first block always has room for the root*/
+            result = (MULTITREE_HANDLE_DATA*)allocateInArena(arena, sizeof(MULTITREE_HANDLE_DATA));
+            result->name = NULL;
+            result->value = NULL;
+            result->cloneFunction = cloneFunction;
+            result->freeFunction = freeFunction;
+            result->nChildren = 0;
+            result->children = NULL;
+            result->nameHash = 0;
+            result->nameLength = 0;
+            result->childIndex = NULL;
+            result->childIndexSlots = 0;
+            result->arena = arena;
+            result->childrenCapacity = 0;
+            arena->root = result;
+        }
+    }
+
+    return (MULTITREE_HANDLE)result;
+}
+
 
 /*return NULL if a child with the name "name" doesn't exists*/
 /*returns a pointer to the existing child (if any)*/
 static MULTITREE_HANDLE_DATA* getChildByName(MULTITREE_HANDLE_DATA* node, const char* name)
 {
-    MULTITREE_HANDLE_DATA* result = NULL;
-    size_t i;
-    for (i = 0; i < node->nChildren; i++)
+    return findChild(node, name, strlen(name));
+}
+
+static int copyNodeName(MULTITREE_HANDLE_DATA* newNode, const char* name)
+{
+    int result;
+    if (newNode->arena == NULL)
+    {
+        result = mallocAndStrcpy_s(&(newNode->name), name);
+    }
+    else if ((newNode->name = (char*)allocateInArena(newNode->arena, newNode->nameLength + 1)) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(newNode->name, name, newNode->nameLength + 1);
+        result = 0;
+    }
+    return result;
+}
+
+/*trees created by MultiTree_Create grow the children array by one for every child, arena trees double a span that is
+left behind in the arena when it is outgrown*/
+static int appendChild(MULTITREE_HANDLE_DATA* node, MULTITREE_HANDLE_DATA* newNode)
+{
+    int result;
+    if (node->arena == NULL)
+    {
+        MULTITREE_HANDLE_DATA** newChildren = (MULTITREE_HANDLE_DATA**)realloc(node->children, (node->nChildren + 1)*sizeof(MULTITREE_HANDLE_DATA*));
+        if (newChildren == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            node->children = newChildren;
+            result = 0;
+        }
+    }
+    else if (node->nChildren == node->childrenCapacity)
     {
-        if (strcmp(node->children[i]->name, name) == 0)
+        size_t newCapacity = (node->childrenCapacity == 0) ? ARENA_FIRST_CHILDREN_CAPACITY : node->childrenCapacity * 2;
+        MULTITREE_HANDLE_DATA** newChildren = (MULTITREE_HANDLE_DATA**)allocateInArena(node->arena, newCapacity * sizeof(MULTITREE_HANDLE_DATA*));
+        if (newChildren == NULL)
         {
-            result = node->children[i];
-            break;
+            result = __FAILURE__;
         }
+        else
+        {
+            if (node->nChildren > 0)
+            {
+                (void)memcpy(newChildren, node->children, node->nChildren * sizeof(MULTITREE_HANDLE_DATA*));
+            }
+            node->children = newChildren;
+            node->childrenCapacity = newCapacity;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        node->children[node->nChildren] = newNode;
+        node->nChildren++;
     }
     return result;
 }
@@ -121,7 +448,8 @@ static CREATELEAF_RESULT createLeaf(MULTITREE_HANDLE_DATA* node, const char*name
     }
     else
     {
-        MULTITREE_HANDLE_DATA* newNode = (MULTITREE_HANDLE_DATA*)malloc(sizeof(MULTITREE_HANDLE_DATA));
+        /* Codes_SRS_MULTITREE_01_003: [ MultiTree_CreateWithArena shall create a new tree whose nodes, node names, children arrays and child indexes are all allocated from an arena owned by the root of the tree. ]*/
+        MULTITREE_HANDLE_DATA* newNode = (MULTITREE_HANDLE_DATA*)allocateInTree(node->arena, sizeof(MULTITREE_HANDLE_DATA));
         if (newNode == NULL)
         {
             result = CREATELEAF_ERROR;
@@ -131,10 +459,16 @@ static CREATELEAF_RESULT createLeaf(MULTITREE_HANDLE_DATA* node, const char*name
         {
             newNode->nChildren = 0;
             newNode->children = NULL;
-            if (mallocAndStrcpy_s(&(newNode->name), name) != 0)
+            newNode->nameLength = strlen(name);
+            newNode->nameHash = hashName(name, newNode->nameLength);
+            newNode->childIndex = NULL;
+            newNode->childIndexSlots = 0;
+            newNode->arena = node->arena;
+            newNode->childrenCapacity = 0;
+            if (copyNodeName(newNode, name) != 0)
             {
                 /*not nice*/
-                free(newNode);
+                freeInTree(node->arena, newNode);
                 newNode = NULL;
                 result = CREATELEAF_ERROR;
                 LogError("(result = %s)", CreateLeaf_ResultAsString[result]);
@@ -150,9 +484,9 @@ static CREATELEAF_RESULT createLeaf(MULTITREE_HANDLE_DATA* node, const char*name
                 }
                 else if (node->cloneFunction(&(newNode->value), value) != 0)
                 {
-                    free(newNode->name);
+                    freeInTree(node->arena, newNode->name);
                     newNode->name = NULL;
-                    free(newNode);
+                    freeInTree(node->arena, newNode);
                     newNode = NULL;
                     result = CREATELEAF_ERROR;
                     LogError("(result = %s)", CreateLeaf_ResultAsString[result]);
@@ -167,23 +501,21 @@ static CREATELEAF_RESULT createLeaf(MULTITREE_HANDLE_DATA* node, const char*name
             if (newNode!=NULL)
             {
                 /*allocate space in the father node*/
-                MULTITREE_HANDLE_DATA** newChildren = (MULTITREE_HANDLE_DATA**)realloc(node->children, (node->nChildren + 1)*sizeof(MULTITREE_HANDLE_DATA*));
-                if (newChildren == NULL)
+                if (appendChild(node, newNode) != 0)
                 {
                     /*no space for the new node*/
                     newNode->value = NULL;
-                    free(newNode->name);
+                    freeInTree(node->arena, newNode->name);
                     newNode->name = NULL;
-                    free(newNode);
+                    freeInTree(node->arena, newNode);
                     newNode = NULL;
                     result = CREATELEAF_ERROR;
                     LogError("(result = %s)", CreateLeaf_ResultAsString[result]);
                 }
                 else
                 {
-                    node->children = newChildren;
-                    node->children[node->nChildren] = newNode;
-                    node->nChildren++;
+                    /*Codes_SRS_MULTITREE_01_001: [ Nodes with 8 or more children shall index them by name, so that finding a child does not depend on the number of children. ]*/
+                    indexLastChild(node);
                     if (childNode != NULL)
                     {
                         *childNode = newNode;
@@ -500,17 +832,9 @@ MULTITREE_RESULT MultiTree_GetChildByName(MULTITREE_HANDLE treeHandle, const cha
     else
     {
         MULTITREE_HANDLE_DATA * node = (MULTITREE_HANDLE_DATA *)treeHandle;
-        size_t i;
-
-        for (i = 0; i < node->nChildren; i++)
-        {
-            if (strcmp(node->children[i]->name, childName) == 0)
-            {
-                break;
-            }
-        }
+        MULTITREE_HANDLE_DATA * child = findChild(node, childName, strlen(childName));
 
-        if (i == node->nChildren)
+        if (child == NULL)
         {
             /* Codes_SRS_MULTITREE_99_068:[ If the specified child is not found, MultiTree_GetChildByName shall return MULTITREE_CHILD_NOT_FOUND.] */
             result = MULTITREE_CHILD_NOT_FOUND;
@@ -519,7 +843,7 @@ MULTITREE_RESULT MultiTree_GetChildByName(MULTITREE_HANDLE treeHandle, const cha
         else
         {
             /* Codes_SRS_MULTITREE_99_067:[ The child node handle shall be returned in the childHandle argument.] */
-            *childHandle = node->children[i];
+            *childHandle = child;
 
             /* Codes_SRS_MULTITREE_99_064:[ On success, MultiTree_GetChildByName shall return MULTITREE_OK.] */
             result = MULTITREE_OK;
@@ -601,9 +925,35 @@ MULTITREE_RESULT MultiTree_SetValue(MULTITREE_HANDLE treeHandle, void* value)
     return result;
 }
 
+static void freeArenaTreeValues(MULTITREE_HANDLE_DATA* node)
+{
+    size_t i;
+    for (i = 0; i < node->nChildren; i++)
+    {
+        freeArenaTreeValues(node->children[i]);
+    }
+
+    if (node->value != NULL)
+    {
+        node->freeFunction(node->value);
+        node->value = NULL;
+    }
+}
+
 void MultiTree_Destroy(MULTITREE_HANDLE treeHandle)
 {
-    if (treeHandle != NULL)
+    if ((treeHandle != NULL) && (((MULTITREE_HANDLE_DATA*)treeHandle)->arena != NULL))
+    {
+        MULTITREE_HANDLE_DATA* node = (MULTITREE_HANDLE_DATA*)treeHandle;
+
+        /* Codes_SRS_MULTITREE_01_006: [ For a tree created by MultiTree_CreateWithArena, MultiTree_Destroy shall free the values of the nodes with freeFunction and, when treeHandle is the root of the tree, free the arena in one go. ]*/
+        freeArenaTreeValues(node);
+        if (node->arena->root == node)
+        {
+            destroyArena(node->arena);
+        }
+    }
+    else if (treeHandle != NULL)
     {
         MULTITREE_HANDLE_DATA* node = (MULTITREE_HANDLE_DATA*)treeHandle;
         size_t i;
@@ -618,6 +968,11 @@ void MultiTree_Destroy(MULTITREE_HANDLE treeHandle)
             free(node->children);
             node->children = NULL;
         }
+        if (node->childIndex != NULL)
+        {
+            free(node->childIndex);
+            node->childIndex = NULL;
+        }
 
         /*Codes_SRS_MULTITREE_99_047:[ This function frees any system resource used by the tree designated by parameter treeHandle]*/
         if (node->name != NULL)
@@ -684,7 +1039,7 @@ MULTITREE_RESULT MultiTree_GetLeafValue(MULTITREE_HANDLE treeHandle, const char*
             /* Codes_SRS_MULTITREE_99_058:[ The last child designates the child that will receive the value.] */
             while (*pos != '\0')
             {
-                size_t i;
+                MULTITREE_HANDLE_DATA* child;
                 size_t childCount = node->nChildren;
 
                 whereIsDelimiter = pos;
@@ -710,17 +1065,10 @@ MULTITREE_RESULT MultiTree_GetLeafValue(MULTITREE_HANDLE treeHandle, const char*
                 }
                 else
                 {
-                    for (i = 0; i < childCount; i++)
-                    {
-                        if (strncmp(node->children[i]->name, pos, whereIsDelimiter - pos) == 0)
-                        {
-                            /* Codes_SRS_MULTITREE_99_057:[ Subsequent names designate hierarchical children in the tree.] */
-                            node = node->children[i];
-                            break;
-                        }
-                    }
-
-                    if (i == childCount)
+                    /* Codes_SRS_MULTITREE_99_057:[ Subsequent names designate hierarchical children in the tree.] */
+                    /* Codes_SRS_MULTITREE_01_002: [ Each segment of leafPath shall be matched against the whole name of the child. ]*/
+                    child = findChild(node, pos, (size_t)(whereIsDelimiter - pos));
+                    if (child == NULL)
                     {
                         /* Codes_SRS_MULTITREE_99_071:[ When the child node is not found, MultiTree_GetLeafValue shall return MULTITREE_CHILD_NOT_FOUND.] */
                         result = MULTITREE_CHILD_NOT_FOUND;
@@ -729,6 +1077,7 @@ MULTITREE_RESULT MultiTree_GetLeafValue(MULTITREE_HANDLE treeHandle, const char*
                     }
                     else
                     {
+                        node = child;
                         if (*whereIsDelimiter == '/')
                         {
                             pos = whereIsDelimiter + 1;
@@ -0,0 +1,789 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/optimize_size.h"
+
+#include "numberformat.h"
+#include <string.h>
+#include <stdbool.h>
+#include <float.h>
+
+/*number formatting and parsing shared by AgentDataTypes_ToString, CreateAgentDataType_From_String and the
+JSON_ENCODER_BUFFER writers, so that every path produces the same text for the same value*/
+
+#define IS_DIGIT(c) (((c) >= '0') && ((c) <= '9'))
+
+/*two decimal digits at a time, "00" to "99"*/
+static const char digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t powersOf10[20] =
+{
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+static size_t countDecimalDigits(uint64_t value)
+{
+    size_t result = 1;
+    while ((result < 20) && (value >= powersOf10[result]))
+    {
+        result++;
+    }
+    return result;
+}
+
+size_t NumberFormat_UInt64(char* destination, uint64_t value, size_t minimumDigits)
+{
+    size_t result;
+    /*Codes_SRS_NUMBER_FORMAT_01_001: [ If destination is NULL, NumberFormat_UInt64 shall return 0. ]*/
+    if (destination == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t nDigits = countDecimalDigits(value);
+        size_t pos;
+        uint32_t value32;
+
+        /*Codes_SRS_NUMBER_FORMAT_01_002: [ NumberFormat_UInt64 shall write the decimal digits of value to destination, preceded by as many '0' as needed to have at least minimumDigits digits, then '\0'. ]*/
+        /*Codes_SRS_NUMBER_FORMAT_01_003: [ NumberFormat_UInt64 shall return the number of characters written, not counting the '\0'. ]*/
+        result = (nDigits < minimumDigits) ? minimumDigits : nDigits;
+        pos = result;
+        destination[pos] = '\0';
+
+        /*64 bit divisions are library calls on most 32 bit targets, they are only done until value fits in 32 bits*/
+        while (value > UINT32_MAX)
+        {
+            size_t pair = (size_t)(value % 100) * 2;
+            value /= 100;
+            destination[--pos] = digitPairs[pair + 1];
+            destination[--pos] = digitPairs[pair];
+        }
+
+        value32 = (uint32_t)value;
+        while (value32 >= 100)
+        {
+            size_t pair = (size_t)(value32 % 100) * 2;
+            value32 /= 100;
+            destination[--pos] = digitPairs[pair + 1];
+            destination[--pos] = digitPairs[pair];
+        }
+        if (value32 >= 10)
+        {
+            destination[--pos] = digitPairs[value32 * 2 + 1];
+            destination[--pos] = digitPairs[value32 * 2];
+        }
+        else
+        {
+            destination[--pos] = (char)('0' + value32);
+        }
+
+        while (pos > 0)
+        {
+            destination[--pos] = '0';
+        }
+    }
+    return result;
+}
+
+size_t NumberFormat_Int64(char* destination, int64_t value)
+{
+    size_t result;
+    /*Codes_SRS_NUMBER_FORMAT_01_004: [ If destination is NULL, NumberFormat_Int64 shall return 0. ]*/
+    if (destination == NULL)
+    {
+        result = 0;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_01_005: [ NumberFormat_Int64 shall write the decimal representation of value to destination, preceded by "-" when value is negative, then '\0'. ]*/
+    /*Codes_SRS_NUMBER_FORMAT_01_006: [ NumberFormat_Int64 shall return the number of characters written, not counting the '\0'. ]*/
+    else if (value < 0)
+    {
+        destination[0] = '-';
+        result = 1 + NumberFormat_UInt64(destination + 1, 0 - (uint64_t)value, 1);
+    }
+    else
+    {
+        result = NumberFormat_UInt64(destination, (uint64_t)value, 1);
+    }
+    return result;
+}
+
+#ifndef NO_FLOATS
+
+/*the shortest digits are found with Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+with Integers", PLDI 2010). The value and the boundaries of the interval of numbers that read back as the value are
+scaled by a cached power of 10 to 64 bit fixed point numbers, then digits are generated until they fall inside the
+interval. The digits always read back as the value and for almost all values there are no shorter such digits*/
+
+typedef struct DIY_FP_TAG
+{
+    uint64_t f;
+    int e;
+} DIY_FP;
+
+/*10^-348, 10^-340, ... 10^340 as f * 2^e, f normalized and rounded to nearest*/
+static const DIY_FP cachedPowers[] =
+{
+    { 0xFA8FD5A0081C0288ULL, -1220 },
+    { 0xBAAEE17FA23EBF76ULL, -1193 },
+    { 0x8B16FB203055AC76ULL, -1166 },
+    { 0xCF42894A5DCE35EAULL, -1140 },
+    { 0x9A6BB0AA55653B2DULL, -1113 },
+    { 0xE61ACF033D1A45DFULL, -1087 },
+    { 0xAB70FE17C79AC6CAULL, -1060 },
+    { 0xFF77B1FCBEBCDC4FULL, -1034 },
+    { 0xBE5691EF416BD60CULL, -1007 },
+    { 0x8DD01FAD907FFC3CULL, -980 },
+    { 0xD3515C2831559A83ULL, -954 },
+    { 0x9D71AC8FADA6C9B5ULL, -927 },
+    { 0xEA9C227723EE8BCBULL, -901 },
+    { 0xAECC49914078536DULL, -874 },
+    { 0x823C12795DB6CE57ULL, -847 },
+    { 0xC21094364DFB5637ULL, -821 },
+    { 0x9096EA6F3848984FULL, -794 },
+    { 0xD77485CB25823AC7ULL, -768 },
+    { 0xA086CFCD97BF97F4ULL, -741 },
+    { 0xEF340A98172AACE5ULL, -715 },
+    { 0xB23867FB2A35B28EULL, -688 },
+    { 0x84C8D4DFD2C63F3BULL, -661 },
+    { 0xC5DD44271AD3CDBAULL, -635 },
+    { 0x936B9FCEBB25C996ULL, -608 },
+    { 0xDBAC6C247D62A584ULL, -582 },
+    { 0xA3AB66580D5FDAF6ULL, -555 },
+    { 0xF3E2F893DEC3F126ULL, -529 },
+    { 0xB5B5ADA8AAFF80B8ULL, -502 },
+    { 0x87625F056C7C4A8BULL, -475 },
+    { 0xC9BCFF6034C13053ULL, -449 },
+    { 0x964E858C91BA2655ULL, -422 },
+    { 0xDFF9772470297EBDULL, -396 },
+    { 0xA6DFBD9FB8E5B88FULL, -369 },
+    { 0xF8A95FCF88747D94ULL, -343 },
+    { 0xB94470938FA89BCFULL, -316 },
+    { 0x8A08F0F8BF0F156BULL, -289 },
+    { 0xCDB02555653131B6ULL, -263 },
+    { 0x993FE2C6D07B7FACULL, -236 },
+    { 0xE45C10C42A2B3B06ULL, -210 },
+    { 0xAA242499697392D3ULL, -183 },
+    { 0xFD87B5F28300CA0EULL, -157 },
+    { 0xBCE5086492111AEBULL, -130 },
+    { 0x8CBCCC096F5088CCULL, -103 },
+    { 0xD1B71758E219652CULL, -77 },
+    { 0x9C40000000000000ULL, -50 },
+    { 0xE8D4A51000000000ULL, -24 },
+    { 0xAD78EBC5AC620000ULL, 3 },
+    { 0x813F3978F8940984ULL, 30 },
+    { 0xC097CE7BC90715B3ULL, 56 },
+    { 0x8F7E32CE7BEA5C70ULL, 83 },
+    { 0xD5D238A4ABE98068ULL, 109 },
+    { 0x9F4F2726179A2245ULL, 136 },
+    { 0xED63A231D4C4FB27ULL, 162 },
+    { 0xB0DE65388CC8ADA8ULL, 189 },
+    { 0x83C7088E1AAB65DBULL, 216 },
+    { 0xC45D1DF942711D9AULL, 242 },
+    { 0x924D692CA61BE758ULL, 269 },
+    { 0xDA01EE641A708DEAULL, 295 },
+    { 0xA26DA3999AEF774AULL, 322 },
+    { 0xF209787BB47D6B85ULL, 348 },
+    { 0xB454E4A179DD1877ULL, 375 },
+    { 0x865B86925B9BC5C2ULL, 402 },
+    { 0xC83553C5C8965D3DULL, 428 },
+    { 0x952AB45CFA97A0B3ULL, 455 },
+    { 0xDE469FBD99A05FE3ULL, 481 },
+    { 0xA59BC234DB398C25ULL, 508 },
+    { 0xF6C69A72A3989F5CULL, 534 },
+    { 0xB7DCBF5354E9BECEULL, 561 },
+    { 0x88FCF317F22241E2ULL, 588 },
+    { 0xCC20CE9BD35C78A5ULL, 614 },
+    { 0x98165AF37B2153DFULL, 641 },
+    { 0xE2A0B5DC971F303AULL, 667 },
+    { 0xA8D9D1535CE3B396ULL, 694 },
+    { 0xFB9B7CD9A4A7443CULL, 720 },
+    { 0xBB764C4CA7A44410ULL, 747 },
+    { 0x8BAB8EEFB6409C1AULL, 774 },
+    { 0xD01FEF10A657842CULL, 800 },
+    { 0x9B10A4E5E9913129ULL, 827 },
+    { 0xE7109BFBA19C0C9DULL, 853 },
+    { 0xAC2820D9623BF429ULL, 880 },
+    { 0x80444B5E7AA7CF85ULL, 907 },
+    { 0xBF21E44003ACDD2DULL, 933 },
+    { 0x8E679C2F5E44FF8FULL, 960 },
+    { 0xD433179D9C8CB841ULL, 986 },
+    { 0x9E19DB92B4E31BA9ULL, 1013 },
+    { 0xEB96BF6EBADF77D9ULL, 1039 },
+    { 0xAF87023B9BF0EE6BULL, 1066 }
+};
+
+/*like JavaScript's Number.prototype.toString, fixed notation is used for 1e-6 <= |value| < 1e21*/
+#define MIN_FIXED_NOTATION_POINT -5
+#define MAX_FIXED_NOTATION_POINT 21
+
+static DIY_FP multiply(DIY_FP x, DIY_FP y)
+{
+    /*the upper 64 bits of the 128 bit product, rounded*/
+    DIY_FP result;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & 0xFFFFFFFFULL;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & 0xFFFFFFFFULL;
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & 0xFFFFFFFFULL) + (bc & 0xFFFFFFFFULL) + (1ULL << 31);
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+/*x.f cannot be 0*/
+static DIY_FP normalize(DIY_FP x)
+{
+    int shift;
+    for (shift = 32; shift > 0; shift /= 2)
+    {
+        if ((x.f >> (64 - shift)) == 0)
+        {
+            x.f <<= shift;
+            x.e -= shift;
+        }
+    }
+    return x;
+}
+
+/*returns 10^-k, k chosen so that a normalized number with exponent e scaled by it has an exponent between -60 and -32,
+that is, its integer part fits in 32 bits*/
+static DIY_FP getCachedPower(int e, int* k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    size_t index;
+    if (dk - ik > 0.0)
+    {
+        ik++;
+    }
+    index = (size_t)((ik >> 3) + 1);
+    *k = -(-348 + (int)(index * 8));
+    return cachedPowers[index];
+}
+
+/*moves the last digit closer to the value while the digits stay inside the interval*/
+static void roundLastDigit(char* digits, size_t length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance)
+{
+    while ((rest < distance) &&
+        (delta - rest >= tenKappa) &&
+        ((rest + tenKappa < distance) || (distance - rest > rest + tenKappa - distance)))
+    {
+        digits[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+/*w is the scaled value, upper the scaled upper boundary and delta the width of the interval. Returns the number of
+digits and adds to *k the exponent of the last one*/
+static size_t generateDigits(DIY_FP w, DIY_FP upper, uint64_t delta, char* digits, int* k)
+{
+    size_t length = 0;
+    int shift = -upper.e;
+    uint64_t one = 1ULL << shift;
+    uint64_t distance = upper.f - w.f;
+    uint32_t integral = (uint32_t)(upper.f >> shift);
+    uint64_t fractional = upper.f & (one - 1);
+    int kappa = (int)countDecimalDigits(integral);
+    bool isDone = false;
+
+    while ((kappa > 0) && (!isDone))
+    {
+        uint32_t divisor = (uint32_t)powersOf10[kappa - 1];
+        uint32_t digit = integral / divisor;
+        uint64_t rest;
+        integral %= divisor;
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (char)('0' + digit);
+        }
+        kappa--;
+        rest = ((uint64_t)integral << shift) + fractional;
+        if (rest <= delta)
+        {
+            *k += kappa;
+            roundLastDigit(digits, length, delta, rest, powersOf10[kappa] << shift, distance);
+            isDone = true;
+        }
+    }
+
+    while (!isDone)
+    {
+        uint32_t digit;
+        fractional *= 10;
+        delta *= 10;
+        digit = (uint32_t)(fractional >> shift);
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (char)('0' + digit);
+        }
+        fractional &= one - 1;
+        kappa--;
+        if (fractional < delta)
+        {
+            *k += kappa;
+            roundLastDigit(digits, length, delta, fractional, one, (-kappa < 20) ? distance * powersOf10[-kappa] : 0);
+            isDone = true;
+        }
+    }
+
+    return length;
+}
+
+/*writes digits * 10^k*/
+static size_t writeDecimal(char* destination, bool isNegative, const char* digits, size_t length, int k)
+{
+    size_t pos = 0;
+    int point = (int)length + k; /*where the decimal point goes, counted from the first digit*/
+
+    if (isNegative)
+    {
+        destination[pos++] = '-';
+    }
+
+    if ((point >= (int)length) && (point <= MAX_FIXED_NOTATION_POINT))
+    {
+        /*12e3 is 12000.0, the ".0" keeps the value a floating point number for whoever reads it*/
+        (void)memcpy(destination + pos, digits, length);
+        pos += length;
+        (void)memset(destination + pos, '0', (size_t)point - length);
+        pos += (size_t)point - length;
+        destination[pos++] = '.';
+        destination[pos++] = '0';
+    }
+    else if ((point > 0) && (point < (int)length))
+    {
+        /*1234e-2 is 12.34*/
+        (void)memcpy(destination + pos, digits, (size_t)point);
+        pos += (size_t)point;
+        destination[pos++] = '.';
+        (void)memcpy(destination + pos, digits + point, length - (size_t)point);
+        pos += length - (size_t)point;
+    }
+    else if ((point <= 0) && (point >= MIN_FIXED_NOTATION_POINT))
+    {
+        /*12e-5 is 0.00012*/
+        destination[pos++] = '0';
+        destination[pos++] = '.';
+        (void)memset(destination + pos, '0', (size_t)(-point));
+        pos += (size_t)(-point);
+        (void)memcpy(destination + pos, digits, length);
+        pos += length;
+    }
+    else
+    {
+        /*12e30 is 1.2e31*/
+        int exponent = point - 1;
+        destination[pos++] = digits[0];
+        if (length > 1)
+        {
+            destination[pos++] = '.';
+            (void)memcpy(destination + pos, digits + 1, length - 1);
+            pos += length - 1;
+        }
+        destination[pos++] = 'e';
+        if (exponent < 0)
+        {
+            destination[pos++] = '-';
+            exponent = -exponent;
+        }
+        pos += NumberFormat_UInt64(destination + pos, (uint64_t)exponent, 1);
+    }
+
+    destination[pos] = '\0';
+    return pos;
+}
+
+/*the value is significand * 2^exponent, significand is not 0. lowerBoundaryIsCloser is true for powers of 2, where
+the next smaller number is closer than the next bigger one*/
+static size_t writeShortest(char* destination, bool isNegative, uint64_t significand, int exponent, bool lowerBoundaryIsCloser)
+{
+    DIY_FP w;
+    DIY_FP upper;
+    DIY_FP lower;
+    DIY_FP cachedPower;
+    char digits[20];
+    size_t length;
+    int k;
+
+    w.f = significand;
+    w.e = exponent;
+    w = normalize(w);
+
+    upper.f = (significand << 1) + 1;
+    upper.e = exponent - 1;
+    upper = normalize(upper);
+
+    if (lowerBoundaryIsCloser)
+    {
+        lower.f = (significand << 2) - 1;
+        lower.e = exponent - 2;
+    }
+    else
+    {
+        lower.f = (significand << 1) - 1;
+        lower.e = exponent - 1;
+    }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+
+    cachedPower = getCachedPower(upper.e, &k);
+    w = multiply(w, cachedPower);
+    upper = multiply(upper, cachedPower);
+    lower = multiply(lower, cachedPower);
+
+    /*the products are off by at most 1 in the last place, the interval is narrowed so that it stays inside the real one*/
+    upper.f--;
+    lower.f++;
+
+    length = generateDigits(w, upper, upper.f - lower.f, digits, &k);
+    return writeDecimal(destination, isNegative, digits, length, k);
+}
+
+size_t NumberFormat_Double(char* destination, double value)
+{
+    size_t result;
+    /*Codes_SRS_NUMBER_FORMAT_01_007: [ If destination is NULL, NumberFormat_Double shall return 0. ]*/
+    if (destination == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        uint64_t bits;
+        uint64_t significand;
+        int biasedExponent;
+        bool isNegative;
+
+        (void)memcpy(&bits, &value, sizeof(bits));
+        significand = bits & 0x000FFFFFFFFFFFFFULL;
+        biasedExponent = (int)((bits >> 52) & 0x7FF);
+        isNegative = ((bits >> 63) != 0);
+
+        if (biasedExponent == 0x7FF)
+        {
+            /*Codes_SRS_NUMBER_FORMAT_01_008: [ If value is NaN or an infinity, NumberFormat_Double shall write an empty string to destination and return 0. ]*/
+            destination[0] = '\0';
+            result = 0;
+        }
+        /*Codes_SRS_NUMBER_FORMAT_01_009: [ NumberFormat_Double shall write to destination, followed by '\0', the shortest decimal digits that read back as value. ]*/
+        /*Codes_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+        /*Codes_SRS_NUMBER_FORMAT_01_011: [ Otherwise the digits shall be written as one digit, the other digits after a decimal point (if there are other digits), "e" and the decimal exponent. ]*/
+        /*Codes_SRS_NUMBER_FORMAT_01_012: [ Negative values (including -0.0) shall be preceded by "-". ]*/
+        /*Codes_SRS_NUMBER_FORMAT_01_013: [ NumberFormat_Double shall return the number of characters written, not counting the '\0'. ]*/
+        else if ((biasedExponent == 0) && (significand == 0))
+        {
+            result = writeDecimal(destination, isNegative, "0", 1, 0);
+        }
+        else if (biasedExponent == 0)
+        {
+            /*subnormal*/
+            result = writeShortest(destination, isNegative, significand, 1 - 1075, false);
+        }
+        else
+        {
+            result = writeShortest(destination, isNegative, significand | (1ULL << 52), biasedExponent - 1075, (significand == 0) && (biasedExponent > 1));
+        }
+    }
+    return result;
+}
+
+size_t NumberFormat_Float(char* destination, float value)
+{
+    size_t result;
+    /*Codes_SRS_NUMBER_FORMAT_01_014: [ If destination is NULL, NumberFormat_Float shall return 0. ]*/
+    if (destination == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        uint32_t bits;
+        uint32_t significand;
+        int biasedExponent;
+        bool isNegative;
+
+        (void)memcpy(&bits, &value, sizeof(bits));
+        significand = bits & 0x007FFFFF;
+        biasedExponent = (int)((bits >> 23) & 0xFF);
+        isNegative = ((bits >> 31) != 0);
+
+        if (biasedExponent == 0xFF)
+        {
+            /*Codes_SRS_NUMBER_FORMAT_01_015: [ If value is NaN or an infinity, NumberFormat_Float shall write an empty string to destination and return 0. ]*/
+            destination[0] = '\0';
+            result = 0;
+        }
+        /*Codes_SRS_NUMBER_FORMAT_01_016: [ NumberFormat_Float shall write value as NumberFormat_Double does, using the shortest decimal digits that read back as value when read as a float. ]*/
+        else if ((biasedExponent == 0) && (significand == 0))
+        {
+            result = writeDecimal(destination, isNegative, "0", 1, 0);
+        }
+        else if (biasedExponent == 0)
+        {
+            result = writeShortest(destination, isNegative, significand, 1 - 150, false);
+        }
+        else
+        {
+            result = writeShortest(destination, isNegative, significand | (1UL << 23), biasedExponent - 150, (significand == 0) && (biasedExponent > 1));
+        }
+    }
+    return result;
+}
+#endif
+
+/*the fast paths need every double operation to be rounded once, which does not happen when intermediate results are
+kept with extended precision (x87)*/
+#if (defined(FLT_EVAL_METHOD) && ((FLT_EVAL_METHOD == 0) || (FLT_EVAL_METHOD == 1))) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64)
+#define DOUBLE_OPERATIONS_ROUND_ONCE true
+#else
+#define DOUBLE_OPERATIONS_ROUND_ONCE false
+#endif
+
+/*the powers of 10 that a double holds exactly*/
+static const double exactPowersOf10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*reads [sign] digits ["." digits] [("e" / "E") [sign] digits] into significand * 10^exponent10. Fails for anything
+else strtod reads (leading spaces, hexadecimal numbers, infinities, NaN), for more than 19 significant digits and for
+very large exponents. Whatever follows the number is not looked at, as strtod does not look at it either*/
+static int parseDecimal(const char* source, bool* isNegative, uint64_t* significand, int* exponent10)
+{
+    int result;
+    const char* pos = source;
+    uint64_t digits = 0;
+    size_t nDigits = 0;
+    size_t nSignificantDigits = 0;
+    int exponent = 0;
+    bool isOutOfRange = false;
+
+    *isNegative = false;
+    if (*pos == '-')
+    {
+        *isNegative = true;
+        pos++;
+    }
+    else if (*pos == '+')
+    {
+        pos++;
+    }
+
+    while (IS_DIGIT(*pos))
+    {
+        if ((nSignificantDigits > 0) || (*pos != '0'))
+        {
+            if (nSignificantDigits == 19)
+            {
+                isOutOfRange = true;
+            }
+            else
+            {
+                digits = digits * 10 + (uint64_t)(*pos - '0');
+                nSignificantDigits++;
+            }
+        }
+        nDigits++;
+        pos++;
+    }
+
+    /*"0x" starts a hexadecimal number for strtod*/
+    if ((nDigits == 1) && (digits == 0) && ((*pos == 'x') || (*pos == 'X')))
+    {
+        isOutOfRange = true;
+    }
+
+    if (*pos == '.')
+    {
+        pos++;
+        while (IS_DIGIT(*pos))
+        {
+            if ((nSignificantDigits > 0) || (*pos != '0'))
+            {
+                if (nSignificantDigits == 19)
+                {
+                    isOutOfRange = true;
+                }
+                else
+                {
+                    digits = digits * 10 + (uint64_t)(*pos - '0');
+                    nSignificantDigits++;
+                }
+            }
+            if (exponent > -1000)
+            {
+                exponent--;
+            }
+            else
+            {
+                isOutOfRange = true;
+            }
+            nDigits++;
+            pos++;
+        }
+    }
+
+    if ((*pos == 'e') || (*pos == 'E'))
+    {
+        const char* exponentPos = pos + 1;
+        bool isExponentNegative = false;
+        int explicitExponent = 0;
+        if (*exponentPos == '-')
+        {
+            isExponentNegative = true;
+            exponentPos++;
+        }
+        else if (*exponentPos == '+')
+        {
+            exponentPos++;
+        }
+
+        /*without digits the "e" is not part of the number*/
+        while (IS_DIGIT(*exponentPos))
+        {
+            if (explicitExponent < 1000)
+            {
+                explicitExponent = explicitExponent * 10 + (*exponentPos - '0');
+            }
+            else
+            {
+                isOutOfRange = true;
+            }
+            exponentPos++;
+        }
+        exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+    }
+
+    if ((nDigits == 0) || isOutOfRange)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *significand = digits;
+        *exponent10 = exponent;
+        result = 0;
+    }
+    return result;
+}
+
+int NumberFormat_ParseDoubleFastPath(const char* source, double* value)
+{
+    int result;
+    bool isNegative;
+    uint64_t significand;
+    int exponent10;
+
+    /*Codes_SRS_NUMBER_FORMAT_01_017: [ If source or value is NULL, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+    if ((source == NULL) || (value == NULL))
+    {
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_01_018: [ If source does not start with [sign] digits ["." digits] [("e" / "E") [sign] digits], NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+    /*Codes_SRS_NUMBER_FORMAT_01_019: [ If the number has more than 19 significant digits, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+    else if ((!DOUBLE_OPERATIONS_ROUND_ONCE) || (parseDecimal(source, &isNegative, &significand, &exponent10) != 0))
+    {
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_01_020: [ If the significant digits are more than 2^53 or the decimal exponent is not between -22 and 22, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+    else if ((significand > (1ULL << 53)) || (exponent10 < -22) || (exponent10 > 22))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*both operands are exact, so the one rounding of the multiplication or division gives what strtod gives*/
+        /*Codes_SRS_NUMBER_FORMAT_01_021: [ Otherwise NumberFormat_ParseDoubleFastPath shall store in value the double nearest to the number and return 0. ]*/
+        double d = (double)significand;
+        if (exponent10 < 0)
+        {
+            d /= exactPowersOf10[-exponent10];
+        }
+        else
+        {
+            d *= exactPowersOf10[exponent10];
+        }
+        *value = isNegative ? -d : d;
+        result = 0;
+    }
+    return result;
+}
+
+int NumberFormat_ParseFloatFastPath(const char* source, float* value)
+{
+    int result;
+    bool isNegative;
+    uint64_t significand;
+    int exponent10;
+
+    /*Codes_SRS_NUMBER_FORMAT_01_022: [ If source or value is NULL, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+    if ((source == NULL) || (value == NULL))
+    {
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_01_023: [ If source does not start with a number NumberFormat_ParseDoubleFastPath would read, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+    else if ((!DOUBLE_OPERATIONS_ROUND_ONCE) || (parseDecimal(source, &isNegative, &significand, &exponent10) != 0))
+    {
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_NUMBER_FORMAT_01_024: [ If the significant digits are more than 2^24 or the decimal exponent is not between -10 and 10, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+    else if ((significand > (1ULL << 24)) || (exponent10 < -10) || (exponent10 > 10))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*both operands are exact floats and a double has more than 2 * 24 + 2 bits, so rounding the double result to
+        float rounds as if the operation had been done in float*/
+        /*Codes_SRS_NUMBER_FORMAT_01_025: [ Otherwise NumberFormat_ParseFloatFastPath shall store in value the float nearest to the number and return 0. ]*/
+        double d = (double)significand;
+        if (exponent10 < 0)
+        {
+            d /= exactPowersOf10[-exponent10];
+        }
+        else
+        {
+            d *= exactPowersOf10[exponent10];
+        }
+        *value = (float)(isNegative ? -d : d);
+        result = 0;
+    }
+    return result;
+}
+
@@ -2,7 +2,9 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
 
 #include "schema.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
@@ -68,6 +70,25 @@ typedef struct MODEL_IN_MODEL_TAG
     SCHEMA_MODEL_TYPE_HANDLE modelHandle;
 } MODEL_IN_MODEL;
 
+typedef enum MODEL_NAME_KIND_TAG
+{
+    MODEL_NAME_PROPERTY,
+    MODEL_NAME_MODEL
+} MODEL_NAME_KIND;
+
+/*one slot of the open addressing table that indexes the names of the properties and of the models in model of a model.
+The name itself is not copied, position is the index of the element in Properties or in models*/
+typedef struct MODEL_NAME_INDEX_ENTRY_TAG
+{
+    uint32_t hash;
+    size_t nameLength;
+    size_t position;
+    MODEL_NAME_KIND kind;
+    bool used;
+} MODEL_NAME_INDEX_ENTRY;
+
+#define MODEL_NAME_INDEX_MIN_SLOTS 16
+
 typedef struct SCHEMA_MODEL_TYPE_HANDLE_DATA_TAG
 {
     VECTOR_HANDLE methods; /*holds SCHEMA_METHOD_HANDLE*/
@@ -81,6 +102,9 @@ typedef struct SCHEMA_MODEL_TYPE_HANDLE_DATA_TAG
     size_t ActionCount;
     VECTOR_HANDLE models;
     size_t DeviceCount;
+    MODEL_NAME_INDEX_ENTRY* nameIndex; /*indexes Properties and models by name, NULL until the first one is added*/
+    size_t nameIndexSlots; /*always a power of 2*/
+    size_t nameIndexCount;
 } SCHEMA_MODEL_TYPE_HANDLE_DATA;
 
 typedef struct SCHEMA_STRUCT_TYPE_HANDLE_DATA_TAG
@@ -102,6 +126,137 @@ typedef struct SCHEMA_HANDLE_DATA_TAG
 
 static VECTOR_HANDLE g_schemas = NULL;
 
+/*FNV-1a, the length is explicit so that segments of a path can be hashed in place*/
+static uint32_t hashModelName(const char* name, size_t nameLength)
+{
+    uint32_t result = 2166136261u;
+    size_t i;
+    for (i = 0; i < nameLength; i++)
+    {
+        result ^= (unsigned char)name[i];
+        result *= 16777619u;
+    }
+    return result;
+}
+
+static const char* getIndexedModelName(const SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, const MODEL_NAME_INDEX_ENTRY* entry)
+{
+    const char* result;
+    if (entry->kind == MODEL_NAME_PROPERTY)
+    {
+        result = ((SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[entry->position])->PropertyName;
+    }
+    else
+    {
+        result = ((MODEL_IN_MODEL*)VECTOR_element(modelType->models, entry->position))->propertyName;
+    }
+    return result;
+}
+
+/*returns the entry for the first element of the given kind that was added with that name, NULL if there is none*/
+static const MODEL_NAME_INDEX_ENTRY* findIndexedModelName(const SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, MODEL_NAME_KIND kind, const char* name, size_t nameLength)
+{
+    const MODEL_NAME_INDEX_ENTRY* result = NULL;
+    if (modelType->nameIndex != NULL)
+    {
+        uint32_t hash = hashModelName(name, nameLength);
+        size_t mask = modelType->nameIndexSlots - 1;
+        size_t slot = hash & mask;
+        while (modelType->nameIndex[slot].used)
+        {
+            const MODEL_NAME_INDEX_ENTRY* entry = &modelType->nameIndex[slot];
+            if ((entry->hash == hash) &&
+                (entry->kind == kind) &&
+                (entry->nameLength == nameLength) &&
+                (memcmp(getIndexedModelName(modelType, entry), name, nameLength) == 0))
+            {
+                result = entry;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    return result;
+}
+
+static void placeIndexedModelName(MODEL_NAME_INDEX_ENTRY* nameIndex, size_t nameIndexSlots, const MODEL_NAME_INDEX_ENTRY* entry)
+{
+    size_t mask = nameIndexSlots - 1;
+    size_t slot = entry->hash & mask;
+    while (nameIndex[slot].used)
+    {
+        slot = (slot + 1) & mask;
+    }
+    nameIndex[slot] = *entry;
+}
+
+/*makes room for one more name, so that adding the name itself cannot fail. The table is kept at most half full*/
+static int reserveIndexedModelName(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType)
+{
+    int result;
+    if ((modelType->nameIndexCount + 1) * 2 <= modelType->nameIndexSlots)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newSlots = (modelType->nameIndexSlots == 0) ? MODEL_NAME_INDEX_MIN_SLOTS : modelType->nameIndexSlots * 2;
+        MODEL_NAME_INDEX_ENTRY* newIndex = (MODEL_NAME_INDEX_ENTRY*)malloc(sizeof(MODEL_NAME_INDEX_ENTRY) * newSlots);
+        if (newIndex == NULL)
+        {
+            LogError("unable to grow the name index to %lu slots", (unsigned long)newSlots);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+            (void)memset(newIndex, 0, sizeof(MODEL_NAME_INDEX_ENTRY) * newSlots);
+            for (i = 0; i < modelType->nameIndexSlots; i++)
+            {
+                if (modelType->nameIndex[i].used)
+                {
+                    placeIndexedModelName(newIndex, newSlots, &modelType->nameIndex[i]);
+                }
+            }
+            free(modelType->nameIndex);
+            modelType->nameIndex = newIndex;
+            modelType->nameIndexSlots = newSlots;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/*the name has to be reserved first. When a name is already there for the same kind the first element keeps it, as a
+linear scan would*/
+static void addIndexedModelName(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, MODEL_NAME_KIND kind, const char* name, size_t position)
+{
+    size_t nameLength = strlen(name);
+    if (findIndexedModelName(modelType, kind, name, nameLength) == NULL)
+    {
+        MODEL_NAME_INDEX_ENTRY entry;
+        entry.hash = hashModelName(name, nameLength);
+        entry.nameLength = nameLength;
+        entry.position = position;
+        entry.kind = kind;
+        entry.used = true;
+        placeIndexedModelName(modelType->nameIndex, modelType->nameIndexSlots, &entry);
+        modelType->nameIndexCount++;
+    }
+}
+
+static SCHEMA_PROPERTY_HANDLE findModelProperty(const SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, const char* name, size_t nameLength)
+{
+    const MODEL_NAME_INDEX_ENTRY* entry = findIndexedModelName(modelType, MODEL_NAME_PROPERTY, name, nameLength);
+    return (entry == NULL) ? NULL : modelType->Properties[entry->position];
+}
+
+static MODEL_IN_MODEL* findModelInModel(const SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType, const char* name, size_t nameLength)
+{
+    const MODEL_NAME_INDEX_ENTRY* entry = findIndexedModelName(modelType, MODEL_NAME_MODEL, name, nameLength);
+    return (entry == NULL) ? NULL : (MODEL_IN_MODEL*)VECTOR_element(modelType->models, entry->position);
+}
+
 static void DestroyProperty(SCHEMA_PROPERTY_HANDLE propertyHandle)
 {
     SCHEMA_PROPERTY_HANDLE_DATA* propertyType = (SCHEMA_PROPERTY_HANDLE_DATA*)propertyHandle;
@@ -243,6 +398,10 @@ static void DestroyModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle)
     VECTOR_clear(modelType->models);
     VECTOR_destroy(modelType->models);
 
+    if (modelType->nameIndex != NULL)
+    {
+        free(modelType->nameIndex);
+    }
     free(modelType->Actions);
     free(modelType);
 }
@@ -261,21 +420,17 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
     }
     else
     {
-        size_t i;
-
         /* Codes_SRS_SCHEMA_99_015:[The property name shall be unique per model, if the same property name is added twice to a model, SCHEMA_DUPLICATE_ELEMENT shall be returned.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
+        if (findModelProperty(modelType, name, strlen(name)) != NULL)
         {
-            SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-            if (strcmp(property->PropertyName, name) == 0)
-            {
-                break;
-            }
+            result = SCHEMA_DUPLICATE_ELEMENT;
+            LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
-
-        if (i < modelType->PropertyCount)
+        /* Codes_SRS_SCHEMA_01_001: [ Schema_AddModelProperty shall index the name of the property in the model so that looking it up does not depend on the number of properties and models in model of the model. ]*/
+        else if (reserveIndexedModelName(modelType) != 0)
         {
-            result = SCHEMA_DUPLICATE_ELEMENT;
+            /* Codes_SRS_SCHEMA_99_014:[On any other error, Schema_AddModelProperty shall return SCHEMA_ERROR.] */
+            result = SCHEMA_ERROR;
             LogError("(result = %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
         }
         else
@@ -318,6 +473,7 @@ static SCHEMA_RESULT AddModelProperty(SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType,
                     else
                     {
                         modelType->Properties[modelType->PropertyCount] = (SCHEMA_PROPERTY_HANDLE)newProperty;
+                        addIndexedModelName(modelType, MODEL_NAME_PROPERTY, newProperty->PropertyName, modelType->PropertyCount);
                         modelType->PropertyCount++;
 
                         /* Codes_SRS_SCHEMA_99_012:[On success, Schema_AddModelProperty shall return SCHEMA_OK.] */
@@ -705,6 +861,9 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_CreateModelType(SCHEMA_HANDLE schemaHandle, cons
                                     modelType->Actions = NULL;
                                     modelType->SchemaHandle = schemaHandle;
                                     modelType->DeviceCount = 0;
+                                    modelType->nameIndex = NULL;
+                                    modelType->nameIndexSlots = 0;
+                                    modelType->nameIndexCount = 0;
 
                                     schema->ModelTypes[schema->ModelTypeCount] = modelType;
                                     schema->ModelTypeCount++;
@@ -1219,29 +1378,15 @@ SCHEMA_PROPERTY_HANDLE Schema_GetModelPropertyByName(SCHEMA_MODEL_TYPE_HANDLE mo
     }
     else
     {
-        size_t i;
         SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
         /* Codes_SRS_SCHEMA_99_036:[Schema_GetModelPropertyByName shall return a non-NULL SCHEMA_PROPERTY_HANDLE corresponding to the model type identified by modelTypeHandle and matching the propertyName argument value.] */
-        for (i = 0; i < modelType->PropertyCount; i++)
-        {
-            SCHEMA_PROPERTY_HANDLE_DATA* modelProperty = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-            if (strcmp(modelProperty->PropertyName, propertyName) == 0)
-            {
-                break;
-            }
-        }
-
-        if (i == modelType->PropertyCount)
+        result = findModelProperty(modelType, propertyName, strlen(propertyName));
+        if (result == NULL)
         {
             /* Codes_SRS_SCHEMA_99_038:[Schema_GetModelPropertyByName shall return NULL if unable to find a matching property or if any of the arguments are NULL.] */
-            result = NULL;
             LogError("(Error code:%s)", ENUM_TO_STRING(SCHEMA_RESULT, SCHEMA_ELEMENT_NOT_FOUND));
         }
-        else
-        {
-            result = (SCHEMA_PROPERTY_HANDLE)(modelType->Properties[i]);
-        }
     }
 
     return result;
@@ -2279,7 +2424,14 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         temp.modelHandle = modelType;
         temp.offset = offset;
         temp.onDesiredProperty = onDesiredProperty;
-        if (mallocAndStrcpy_s((char**)&(temp.propertyName), propertyName) != 0)
+        /*Codes_SRS_SCHEMA_01_002: [ Schema_AddModelModel shall index propertyName in the model identified by modelTypeHandle so that looking it up does not depend on the number of properties and models in model of the model. ]*/
+        if (reserveIndexedModelName(parentModel) != 0)
+        {
+            /*Codes_SRS_SCHEMA_99_174: [The function shall return SCHEMA_ERROR if any other error occurs.]*/
+            result = SCHEMA_ERROR;
+            LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
+        }
+        else if (mallocAndStrcpy_s((char**)&(temp.propertyName), propertyName) != 0)
         {
             result = SCHEMA_ERROR;
             LogError("(Error code: %s)", ENUM_TO_STRING(SCHEMA_RESULT, result));
@@ -2293,8 +2445,9 @@ SCHEMA_RESULT Schema_AddModelModel(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, con
         }
         else
         {
+            addIndexedModelName(parentModel, MODEL_NAME_MODEL, temp.propertyName, VECTOR_size(parentModel->models) - 1);
+
             /*Codes_SRS_SCHEMA_99_164: [If the function succeeds, then the return value shall be SCHEMA_OK.]*/
-            
             result = SCHEMA_OK;
         }
     }
@@ -2325,13 +2478,6 @@ SCHEMA_RESULT Schema_GetModelModelCount(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle
     return result;
 }
 
-static bool matchModelName(const void* element, const void* value)
-{
-    MODEL_IN_MODEL* decodedElement = (MODEL_IN_MODEL*)element;
-    const char* name = (const char*)value;
-    return (strcmp(decodedElement->propertyName, name) == 0);
-}
-
 SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* propertyName)
 {
     SCHEMA_MODEL_TYPE_HANDLE result;
@@ -2349,7 +2495,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_99_170: [Schema_GetModelModelByName shall return a handle to the model identified by the property with the name propertyName in the model identified by the handle modelTypeHandle.]*/
         /*Codes_SRS_SCHEMA_99_171: [If Schema_GetModelModelByName is unable to provide the handle it shall return NULL.]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = findModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2357,7 +2503,7 @@ SCHEMA_MODEL_TYPE_HANDLE Schema_GetModelModelByName(SCHEMA_MODEL_TYPE_HANDLE mod
         }
         else
         {
-            result = ((MODEL_IN_MODEL*)temp)->modelHandle;
+            result = temp->modelHandle;
         }
     }
     return result;
@@ -2381,7 +2527,7 @@ size_t Schema_GetModelModelByName_Offset(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandl
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
         /*Codes_SRS_SCHEMA_02_056: [ If propertyName is not a model then Schema_GetModelModelByName_Offset shall fail and return 0. ]*/
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = findModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2390,7 +2536,7 @@ size_t Schema_GetModelModelByName_Offset(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandl
         else
         {
             /*Codes_SRS_SCHEMA_02_055: [ Otherwise Schema_GetModelModelByName_Offset shall succeed and return the offset. ]*/
-            result = ((MODEL_IN_MODEL*)temp)->offset;
+            result = temp->offset;
         }
     }
     return result;
@@ -2412,7 +2558,7 @@ pfOnDesiredProperty Schema_GetModelModelByName_OnDesiredProperty(SCHEMA_MODEL_TY
     else
     {
         SCHEMA_MODEL_TYPE_HANDLE_DATA* model = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
-        void* temp = VECTOR_find_if(model->models, matchModelName, propertyName);
+        MODEL_IN_MODEL* temp = findModelInModel(model, propertyName, strlen(propertyName));
         if (temp == NULL)
         {
             LogError("specified propertyName not found (%s)", propertyName);
@@ -2421,7 +2567,7 @@ pfOnDesiredProperty Schema_GetModelModelByName_OnDesiredProperty(SCHEMA_MODEL_TY
         else
         {
             /*Codes_SRS_SCHEMA_02_089: [ Otherwise Schema_GetModelModelByName_OnDesiredProperty shall return the desired property callback. ]*/
-            result = ((MODEL_IN_MODEL*)temp)->onDesiredProperty;
+            result = temp->onDesiredProperty;
         }
     }
     return result;
@@ -2538,8 +2684,7 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             /* Codes_SRS_SCHEMA_99_179: [The propertyPath shall be assumed to be in the format model1/model2/.../propertyName.] */
@@ -2550,22 +2695,11 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
                 endPos = &propertyPath[strlen(propertyPath)];
             }
 
-            /* get the child-model */
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
-            {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, propertyPath, endPos - propertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - propertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
-
-            if (i < modelCount)
+            /*Codes_SRS_SCHEMA_01_003: [ Schema_ModelPropertyByPathExists, Schema_ModelReportedPropertyByPathExists and Schema_ModelDesiredPropertyByPathExists shall look up each segment of the path in the name index of the model, without scanning the models in model. ]*/
+            childModel = findModelInModel(modelType, propertyPath, (size_t)(endPos - propertyPath));
+            if (childModel != NULL)
             {
+                modelTypeHandle = childModel->modelHandle;
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2583,18 +2717,8 @@ bool Schema_ModelPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle,
             {
                 /* no model found, let's see if this is a property */
                 /* Codes_SRS_SCHEMA_99_178: [The argument propertyPath shall be used to find the leaf property.] */
-                for (i = 0; i < modelType->PropertyCount; i++)
-                {
-                    SCHEMA_PROPERTY_HANDLE_DATA* property = (SCHEMA_PROPERTY_HANDLE_DATA*)modelType->Properties[i];
-                    if ((strncmp(property->PropertyName, propertyPath, endPos - propertyPath) == 0) &&
-                        (strlen(property->PropertyName) == (size_t)(endPos - propertyPath)))
-                    {
-                        /* found property */
-                        /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
-                        result = true;
-                        break;
-                    }
-                }
+                /* Codes_SRS_SCHEMA_99_177: [Schema_ModelPropertyByPathExists shall return true if a leaf property exists in the model modelTypeHandle.] */
+                result = (findModelProperty(modelType, propertyPath, (size_t)(endPos - propertyPath)) != NULL);
 
                 break;
             }
@@ -2632,8 +2756,7 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(reportedPropertyPath, '/');
@@ -2643,21 +2766,11 @@ bool Schema_ModelReportedPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelType
                 endPos = &reportedPropertyPath[strlen(reportedPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
-            {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, reportedPropertyPath, endPos - reportedPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - reportedPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
-
-            if (i < modelCount)
+            /*Codes_SRS_SCHEMA_01_003: [ Schema_ModelPropertyByPathExists, Schema_ModelReportedPropertyByPathExists and Schema_ModelDesiredPropertyByPathExists shall look up each segment of the path in the name index of the model, without scanning the models in model. ]*/
+            childModel = findModelInModel(modelType, reportedPropertyPath, (size_t)(endPos - reportedPropertyPath));
+            if (childModel != NULL)
             {
+                modelTypeHandle = childModel->modelHandle;
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -2896,8 +3009,7 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
         do
         {
             const char* endPos;
-            size_t i;
-            size_t modelCount;
+            MODEL_IN_MODEL* childModel;
             SCHEMA_MODEL_TYPE_HANDLE_DATA* modelType = (SCHEMA_MODEL_TYPE_HANDLE_DATA*)modelTypeHandle;
 
             slashPos = strchr(desiredPropertyPath, '/');
@@ -2907,21 +3019,11 @@ bool Schema_ModelDesiredPropertyByPathExists(SCHEMA_MODEL_TYPE_HANDLE modelTypeH
                 endPos = &desiredPropertyPath[strlen(desiredPropertyPath)];
             }
 
-            modelCount = VECTOR_size(modelType->models);
-            for (i = 0; i < modelCount; i++)
-            {
-                MODEL_IN_MODEL* childModel = (MODEL_IN_MODEL*)VECTOR_element(modelType->models, i);
-                if ((strncmp(childModel->propertyName, desiredPropertyPath, endPos - desiredPropertyPath) == 0) &&
-                    (strlen(childModel->propertyName) == (size_t)(endPos - desiredPropertyPath)))
-                {
-                    /* found */
-                    modelTypeHandle = childModel->modelHandle;
-                    break;
-                }
-            }
-
-            if (i < modelCount)
+            /*Codes_SRS_SCHEMA_01_003: [ Schema_ModelPropertyByPathExists, Schema_ModelReportedPropertyByPathExists and Schema_ModelDesiredPropertyByPathExists shall look up each segment of the path in the name index of the model, without scanning the models in model. ]*/
+            childModel = findModelInModel(modelType, desiredPropertyPath, (size_t)(endPos - desiredPropertyPath));
+            if (childModel != NULL)
             {
+                modelTypeHandle = childModel->modelHandle;
                 /* model found, check if there is more in the path */
                 if (slashPos == NULL)
                 {
@@ -3021,12 +3123,6 @@ size_t Schema_GetModelDesiredProperty_offset(SCHEMA_DESIRED_PROPERTY_HANDLE desi
     return result;
 }
 
-static bool modelInModelExists(const void* element, const void* value)
-{
-    MODEL_IN_MODEL* modelInModel = (MODEL_IN_MODEL*)element;
-    return (strcmp(modelInModel->propertyName, value) == 0);
-}
-
 SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE modelTypeHandle, const char* elementName)
 {
     SCHEMA_MODEL_ELEMENT result;
@@ -3053,22 +3149,9 @@ SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE model
         }
         else
         {
-            size_t nProcessedProperties = 0;
-            SCHEMA_PROPERTY_HANDLE_DATA* property = NULL;
-            for (size_t i = 0; i < handleData->PropertyCount;i++)
-            {
-                property = (SCHEMA_PROPERTY_HANDLE_DATA*)(handleData->Properties[i]);
-                if (strcmp(property->PropertyName, elementName) == 0)
-                {
-                    i = handleData->PropertyCount; /*found it*/
-                }
-                else
-                {
-                    nProcessedProperties++;
-                }
-            }
-
-            if (nProcessedProperties < handleData->PropertyCount)
+            size_t elementNameLength = strlen(elementName);
+            SCHEMA_PROPERTY_HANDLE property = findModelProperty(handleData, elementName, elementNameLength);
+            if (property != NULL)
             {
                 /*Codes_SRS_SCHEMA_02_078: [ If elementName is a property then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_PROPERTY and SCHEMA_MODEL_ELEMENT.elementHandle.propertyHandle to the handle of the property. ]*/
                 result.elementType = SCHEMA_PROPERTY;
@@ -3110,7 +3193,7 @@ SCHEMA_MODEL_ELEMENT Schema_GetModelElementByName(SCHEMA_MODEL_TYPE_HANDLE model
                     }
                     else
                     {
-                        MODEL_IN_MODEL* modelInModel = VECTOR_find_if(handleData->models, modelInModelExists, elementName);
+                        MODEL_IN_MODEL* modelInModel = findModelInModel(handleData, elementName, elementNameLength);
                         if (modelInModel != NULL)
                         {
                             /*Codes_SRS_SCHEMA_02_082: [ If elementName is a model in model then Schema_GetModelElementByName shall succeed and set SCHEMA_MODEL_ELEMENT.elementType to SCHEMA_MODEL_IN_MODEL and SCHEMA_MODEL_ELEMENT.elementHandle.modelHandle to the handle of the model. ]*/
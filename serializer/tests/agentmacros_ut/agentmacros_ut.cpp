@@ -33,6 +33,16 @@ AGENT_DATA_TYPES_RESULT Create_AGENT_DATA_TYPE_from_EDM_GUID(AGENT_DATA_TYPE*, E
 AGENT_DATA_TYPES_RESULT Create_AGENT_DATA_TYPE_from_EDM_BINARY(AGENT_DATA_TYPE*, EDM_BINARY) { return AGENT_DATA_TYPES_ERROR; }
 AGENT_DATA_TYPES_RESULT Create_AGENT_DATA_TYPE_from_FLOAT(AGENT_DATA_TYPE*, float) { return AGENT_DATA_TYPES_ERROR; }
 
+JSON_ENCODER_RESULT JSONEncoder_BeginObject(JSON_ENCODER_BUFFER*) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteMemberName(JSON_ENCODER_BUFFER*, const char*, size_t) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteInt64(JSON_ENCODER_BUFFER*, int64_t) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteBool(JSON_ENCODER_BUFFER*, bool) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteDouble(JSON_ENCODER_BUFFER*, double) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteFloat(JSON_ENCODER_BUFFER*, float) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteString(JSON_ENCODER_BUFFER*, const char*) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_WriteStringNoQuotes(JSON_ENCODER_BUFFER*, const char*) { return JSON_ENCODER_ERROR; }
+JSON_ENCODER_RESULT JSONEncoder_EndObject(JSON_ENCODER_BUFFER*) { return JSON_ENCODER_ERROR; }
+
 TRANSACTION_HANDLE Device_StartTransaction(DEVICE_HANDLE) { return NULL; }
 DEVICE_RESULT Device_PublishTransacted(TRANSACTION_HANDLE, const char*, const AGENT_DATA_TYPE*) { return DEVICE_ERROR; }
 DEVICE_RESULT Device_EndTransaction(TRANSACTION_HANDLE) { return DEVICE_ERROR; }
@@ -0,0 +1,372 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*offline benchmark of AgentDataTypes_ToString for every EDM type the serializer sends, and of
+CreateAgentDataType_From_String for the floating point types. Each type cycles through VALUE_COUNT different values
+so that the digits (and the branches taken) change from one call to the next. The destination STRING_HANDLE is
+reused, so what is measured is formatting, not growing the string. The result is a single key=value line so that
+runs can be diffed and graphed*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/strings.h"
+#include "agenttypesystem.h"
+
+#define VALUE_COUNT 64
+
+typedef struct BENCHMARK_TYPE_TAG
+{
+    const char* name;
+    AGENT_DATA_TYPE values[VALUE_COUNT];
+} BENCHMARK_TYPE;
+
+static const char* const typeNames[] =
+{
+    "boolean", "byte", "sbyte", "int16", "int32", "int64", "date", "datetimeoffset", "decimal",
+#ifndef NO_FLOATS
+    "double", "single",
+#endif
+    "string", "guid", "binary", "null"
+};
+
+#define TYPE_COUNT (sizeof(typeNames) / sizeof(typeNames[0]))
+
+static uint64_t get_time_ns(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/*the values only have to differ from one another and be the same from one run to the next*/
+static uint64_t nextRandom(uint64_t* state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 11;
+}
+
+static AGENT_DATA_TYPES_RESULT createValue(const char* typeName, size_t index, uint64_t* state, AGENT_DATA_TYPE* value)
+{
+    AGENT_DATA_TYPES_RESULT result;
+    uint64_t r = nextRandom(state);
+
+    if (strcmp(typeName, "boolean") == 0)
+    {
+        result = Create_EDM_BOOLEAN_from_int(value, (int)(r & 1));
+    }
+    else if (strcmp(typeName, "byte") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_UINT8(value, (uint8_t)r);
+    }
+    else if (strcmp(typeName, "sbyte") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_SINT8(value, (int8_t)(uint8_t)r);
+    }
+    else if (strcmp(typeName, "int16") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_SINT16(value, (int16_t)(uint16_t)r);
+    }
+    else if (strcmp(typeName, "int32") == 0)
+    {
+        /*mostly small readings, like the ones devices send, and some full range values*/
+        result = Create_AGENT_DATA_TYPE_from_SINT32(value, (index % 4 == 0) ? (int32_t)(uint32_t)r : (int32_t)(r % 2000) - 1000);
+    }
+    else if (strcmp(typeName, "int64") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_SINT64(value, (index % 4 == 0) ? (int64_t)(r << 11) : (int64_t)(r % 200000) - 100000);
+    }
+    else if (strcmp(typeName, "date") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_date(value, (int16_t)(1970 + r % 100), (uint8_t)(1 + (r >> 8) % 12), (uint8_t)(1 + (r >> 16) % 28));
+    }
+    else if (strcmp(typeName, "datetimeoffset") == 0)
+    {
+        EDM_DATE_TIME_OFFSET dateTimeOffset;
+        (void)memset(&dateTimeOffset, 0, sizeof(dateTimeOffset));
+        dateTimeOffset.dateTime.tm_year = (int)(70 + r % 100);
+        dateTimeOffset.dateTime.tm_mon = (int)((r >> 8) % 12);
+        dateTimeOffset.dateTime.tm_mday = (int)(1 + (r >> 12) % 28);
+        dateTimeOffset.dateTime.tm_hour = (int)((r >> 17) % 24);
+        dateTimeOffset.dateTime.tm_min = (int)((r >> 22) % 60);
+        dateTimeOffset.dateTime.tm_sec = (int)((r >> 28) % 60);
+        dateTimeOffset.hasFractionalSecond = (uint8_t)(index % 2);
+        dateTimeOffset.fractionalSecond = (r >> 34) % 1000000;
+        dateTimeOffset.hasTimeZone = (uint8_t)(index % 3 == 0);
+        dateTimeOffset.timeZoneHour = (int8_t)((int)((r >> 40) % 23) - 11);
+        dateTimeOffset.timeZoneMinute = (uint8_t)(((r >> 45) % 4) * 15);
+        result = Create_AGENT_DATA_TYPE_from_EDM_DATE_TIME_OFFSET(value, dateTimeOffset);
+    }
+    else if (strcmp(typeName, "decimal") == 0)
+    {
+        char temp[32];
+        (void)sprintf(temp, "%d.%02d", (int)(r % 100000) - 50000, (int)((r >> 20) % 100));
+        result = Create_EDM_DECIMAL_from_charz(value, temp);
+    }
+#ifndef NO_FLOATS
+    else if (strcmp(typeName, "double") == 0)
+    {
+        /*sensor readings with a couple of decimals and values that need all 17 digits*/
+        result = Create_AGENT_DATA_TYPE_from_DOUBLE(value, (index % 2 == 0) ? (double)((int64_t)(r % 200000) - 100000) / 100.0 : (double)r / 7.0);
+    }
+    else if (strcmp(typeName, "single") == 0)
+    {
+        result = Create_AGENT_DATA_TYPE_from_FLOAT(value, (index % 2 == 0) ? (float)((int)(r % 20000) - 10000) / 10.0f : (float)(r & 0xFFFFFF) / 3.0f);
+    }
+#endif
+    else if (strcmp(typeName, "string") == 0)
+    {
+        char temp[32];
+        (void)sprintf(temp, "myDevice%lu", (unsigned long)(r % 1000));
+        result = Create_AGENT_DATA_TYPE_from_charz(value, temp);
+    }
+    else if (strcmp(typeName, "guid") == 0)
+    {
+        EDM_GUID guid;
+        size_t i;
+        for (i = 0; i < sizeof(guid.GUID); i++)
+        {
+            guid.GUID[i] = (uint8_t)nextRandom(state);
+        }
+        result = Create_AGENT_DATA_TYPE_from_EDM_GUID(value, guid);
+    }
+    else if (strcmp(typeName, "binary") == 0)
+    {
+        unsigned char data[16];
+        EDM_BINARY binary;
+        size_t i;
+        for (i = 0; i < sizeof(data); i++)
+        {
+            data[i] = (unsigned char)nextRandom(state);
+        }
+        binary.size = 1 + r % sizeof(data);
+        binary.data = data;
+        result = Create_AGENT_DATA_TYPE_from_EDM_BINARY(value, binary);
+    }
+    else
+    {
+        result = Create_NULL_AGENT_DATA_TYPE(value);
+    }
+    return result;
+}
+
+/*EDM_NULL values own nothing and Destroy_AGENT_DATA_TYPE reports them as invalid*/
+static void destroyValues(BENCHMARK_TYPE* type, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if (type->values[i].type != EDM_NULL_TYPE)
+        {
+            Destroy_AGENT_DATA_TYPE(&type->values[i]);
+        }
+    }
+}
+
+static int createValues(BENCHMARK_TYPE* types, size_t* createdTypes)
+{
+    int result = 0;
+    uint64_t state = 42;
+    size_t i;
+    for (i = 0; (result == 0) && (i < TYPE_COUNT); i++)
+    {
+        size_t j;
+        types[i].name = typeNames[i];
+        for (j = 0; j < VALUE_COUNT; j++)
+        {
+            if (createValue(types[i].name, j, &state, &types[i].values[j]) != AGENT_DATA_TYPES_OK)
+            {
+                (void)printf("unable to create a %s value\n", types[i].name);
+                destroyValues(&types[i], j);
+                result = 1;
+                break;
+            }
+        }
+        if (result == 0)
+        {
+            *createdTypes = i + 1;
+        }
+    }
+    return result;
+}
+
+/*returns the time per value or UINT64_MAX when AgentDataTypes_ToString fails*/
+static uint64_t timeToString(STRING_HANDLE destination, const BENCHMARK_TYPE* type, size_t count)
+{
+    uint64_t result;
+    uint64_t start = get_time_ns();
+    size_t i;
+    for (i = 0; i < count; i++)
+    {
+        if ((STRING_empty(destination) != 0) ||
+            (AgentDataTypes_ToString(destination, &type->values[i % VALUE_COUNT]) != AGENT_DATA_TYPES_OK))
+        {
+            break;
+        }
+    }
+
+    if (i < count)
+    {
+        (void)printf("AgentDataTypes_ToString failed for %s\n", type->name);
+        result = UINT64_MAX;
+    }
+    else
+    {
+        result = (count == 0) ? 0 : (get_time_ns() - start) / count;
+    }
+    return result;
+}
+
+#ifndef NO_FLOATS
+/*parses back the text AgentDataTypes_ToString produced, returns the time per value or UINT64_MAX on failure*/
+static uint64_t timeFromString(const BENCHMARK_TYPE* type, AGENT_DATA_TYPE_TYPE edmType, size_t count)
+{
+    uint64_t result;
+    char* texts[VALUE_COUNT];
+    size_t createdTexts = 0;
+    STRING_HANDLE temp = STRING_new();
+    if (temp == NULL)
+    {
+        result = UINT64_MAX;
+    }
+    else
+    {
+        for (createdTexts = 0; createdTexts < VALUE_COUNT; createdTexts++)
+        {
+            if ((STRING_empty(temp) != 0) ||
+                (AgentDataTypes_ToString(temp, &type->values[createdTexts]) != AGENT_DATA_TYPES_OK) ||
+                ((texts[createdTexts] = (char*)malloc(STRING_length(temp) + 1)) == NULL))
+            {
+                break;
+            }
+            (void)memcpy(texts[createdTexts], STRING_c_str(temp), STRING_length(temp) + 1);
+        }
+        STRING_delete(temp);
+
+        if (createdTexts < VALUE_COUNT)
+        {
+            result = UINT64_MAX;
+        }
+        else
+        {
+            uint64_t start = get_time_ns();
+            size_t i;
+            for (i = 0; i < count; i++)
+            {
+                AGENT_DATA_TYPE value;
+                if (CreateAgentDataType_From_String(texts[i % VALUE_COUNT], edmType, &value) != AGENT_DATA_TYPES_OK)
+                {
+                    break;
+                }
+                Destroy_AGENT_DATA_TYPE(&value);
+            }
+            result = (i < count) ? UINT64_MAX : ((count == 0) ? 0 : (get_time_ns() - start) / count);
+        }
+    }
+
+    if (result == UINT64_MAX)
+    {
+        (void)printf("CreateAgentDataType_From_String failed for %s\n", type->name);
+    }
+
+    while (createdTexts > 0)
+    {
+        createdTexts--;
+        free(texts[createdTexts]);
+    }
+    return result;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t count = 1000000;
+
+    if ((argc == 3) && (strcmp(argv[1], "--values") == 0))
+    {
+        count = (size_t)strtoul(argv[2], NULL, 10);
+    }
+
+    if ((argc != 1) && (argc != 3))
+    {
+        (void)printf("usage: %s [--values N]\n", argv[0]);
+        result = 1;
+    }
+    else
+    {
+        static BENCHMARK_TYPE types[TYPE_COUNT];
+        size_t createdTypes = 0;
+        STRING_HANDLE destination = STRING_new();
+        if (destination == NULL)
+        {
+            (void)printf("STRING_new failed\n");
+            result = 1;
+        }
+        else
+        {
+            if (createValues(types, &createdTypes) != 0)
+            {
+                result = 1;
+            }
+            else
+            {
+                uint64_t toStringTimes[TYPE_COUNT];
+                size_t i;
+
+                result = 0;
+                for (i = 0; (result == 0) && (i < TYPE_COUNT); i++)
+                {
+                    toStringTimes[i] = timeToString(destination, &types[i], count);
+                    result = (toStringTimes[i] == UINT64_MAX) ? 1 : 0;
+                }
+
+                if (result == 0)
+                {
+#ifndef NO_FLOATS
+                    uint64_t doubleParseTime = UINT64_MAX;
+                    uint64_t singleParseTime = UINT64_MAX;
+                    for (i = 0; i < TYPE_COUNT; i++)
+                    {
+                        if (strcmp(types[i].name, "double") == 0)
+                        {
+                            doubleParseTime = timeFromString(&types[i], EDM_DOUBLE_TYPE, count);
+                        }
+                        else if (strcmp(types[i].name, "single") == 0)
+                        {
+                            singleParseTime = timeFromString(&types[i], EDM_SINGLE_TYPE, count);
+                        }
+                    }
+                    if ((doubleParseTime == UINT64_MAX) || (singleParseTime == UINT64_MAX))
+                    {
+                        result = 1;
+                    }
+                    else
+#endif
+                    {
+                        (void)printf("values=%lu", (unsigned long)count);
+                        for (i = 0; i < TYPE_COUNT; i++)
+                        {
+                            (void)printf(" %s_tostring_ns=%lu", types[i].name, (unsigned long)toStringTimes[i]);
+                        }
+#ifndef NO_FLOATS
+                        (void)printf(" double_fromstring_ns=%lu single_fromstring_ns=%lu", (unsigned long)doubleParseTime, (unsigned long)singleParseTime);
+#endif
+                        (void)printf("\n");
+                    }
+                }
+            }
+
+            for (; createdTypes > 0; createdTypes--)
+            {
+                destroyValues(&types[createdTypes - 1], VALUE_COUNT);
+            }
+            STRING_delete(destination);
+        }
+    }
+
+    return result;
+}
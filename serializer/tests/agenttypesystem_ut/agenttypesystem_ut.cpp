@@ -4274,7 +4274,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             Destroy_AGENT_DATA_TYPE(&ag);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_SignallingNan_succeeds)
         {
             ///arrange
@@ -4287,7 +4287,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_SignallingNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4300,7 +4300,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_QuietNan_succeeds)
         {
             ///arrange
@@ -4313,7 +4313,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_QuietNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4326,7 +4326,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_minusInf_succeeds)
         {
             ///arrange
@@ -4339,7 +4339,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "-INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_minusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4353,7 +4353,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_plusInf_succeeds)
         {
             ///arrange
@@ -4366,7 +4366,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_plusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4379,7 +4379,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_succeeds_1)
         {
             ///arrange
@@ -4392,7 +4392,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(double, TEST_DOUBLE_1, atof(STRING_c_str(global_bufferTemp)));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall use DBL_DIG C #define*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_succeeds_2)
         {
             ///arrange
@@ -4405,6 +4405,60 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(double, TEST_DOUBLE_2, atof(STRING_c_str(global_bufferTemp)));
         }
 
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
+        TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_writes_the_shortest_digits)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&ag, 0.1);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "0.1", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
+
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
+        TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_an_integral_value_keeps_the_decimal_point)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&ag, -3.0);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "-3.0", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
+
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_022:[ EDM_DOUBLE: doubleValue = decimalValue [ "e" [SIGN] 1*DIGIT ] / nanInfinity ; IEEE 754 binary64 floating-point number (15-17 decimal digits). The representation shall be the shortest one that reads back as the same double.]*/
+        TEST_FUNCTION(AgentDataTypes_ToString_DOUBLE_with_a_large_value_writes_an_exponent)
+        {
+            ///arrange
+            AGENT_DATA_TYPE ag;
+            (void)Create_AGENT_DATA_TYPE_from_DOUBLE(&ag, 1.5e300);
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &ag);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "1.5e300", STRING_c_str(global_bufferTemp));
+
+            ///cleanup
+            Destroy_AGENT_DATA_TYPE(&ag);
+        }
+
         /*Tests_SRS_AGENT_TYPE_SYSTEM_99_047:[ Creates an AGENT_DATA_TYPE containing an EDM_SINGLE from float]*/
         TEST_FUNCTION(Create_AGENT_DATA_TYPE_from_FLOAT_succeeds_1)
         {
@@ -4501,7 +4555,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             Destroy_AGENT_DATA_TYPE(&ag);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_SignallingNan_succeeds)
         {
             ///arrange
@@ -4514,7 +4568,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_SignallingNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4528,7 +4582,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_QuietNan_succeeds)
         {
             ///arrange
@@ -4541,7 +4595,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "NaN", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_QuietNan_insuficient_buffer_fails)
         {
             ///arrange
@@ -4556,7 +4610,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_minusInf_succeeds)
         {
             ///arrange
@@ -4569,7 +4623,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "-INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_minusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4585,7 +4639,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_plusInf_succeeds)
         {
             ///arrange
@@ -4598,7 +4652,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(char_ptr, "INF", STRING_c_str(global_bufferTemp));
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_with_plusInf_insuficient_buffer_fails)
         {
             ///arrange
@@ -4612,7 +4666,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_ERROR, res);
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_succeeds_1)
         {
             ///arrange
@@ -4626,7 +4680,7 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
 
         }
 
-        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representatiuon shall use FLT_DIG.]*/
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
         TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_succeeds_2)
         {
             ///arrange
@@ -4639,6 +4693,19 @@ BEGIN_TEST_SUITE(AgentTypeSystem_ut)
             ASSERT_ARE_EQUAL(float, TEST_FLOAT_2, (float)atof(STRING_c_str(global_bufferTemp)));
 
         }
+
+        /*Tests_SRS_AGENT_TYPE_SYSTEM_99_027:[ EDM_SINGLE: singleValue = doubleValue ; IEEE 754 binary32 floating-point number (6-9 decimal digits). The representation shall be the shortest one that reads back as the same float.]*/
+        TEST_FUNCTION(AgentDataTypes_ToString_FLOAT_writes_the_shortest_digits)
+        {
+            ///arrange
+
+            ///act
+            auto res = AgentDataTypes_ToString(global_bufferTemp, &agSingle2);
+
+            ///assert
+            ASSERT_ARE_EQUAL(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_OK, res);
+            ASSERT_ARE_EQUAL(char_ptr, "42.589123", STRING_c_str(global_bufferTemp));
+        }
 #endif
 
         /*Tests_SRS_AGENT_TYPE_SYSTEM_99_043:[ Creates an AGENT_DATA_TYPE containing an EDM_INT16 from int16_t]*/
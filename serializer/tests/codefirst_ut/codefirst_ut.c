@@ -74,6 +74,7 @@ void my_gballoc_free(void * t)
 #include "agenttypesystem.h"
 #include "schema.h"
 #include "iotdevice.h"
+#include "jsonencoder.h"
 #include "azure_c_shared_utility/strings.h"
 #undef ENABLE_MOCKS
 
@@ -562,10 +563,22 @@ static DEVICE_RESULT my_Device_CancelTransaction(TRANSACTION_HANDLE transactionH
     return DEVICE_OK;
 }
 
+static JSON_ENCODER_RESULT my_JSONEncoder_BeginObject(JSON_ENCODER_BUFFER* destination)
+{
+    destination->buffer = (unsigned char*)my_gballoc_malloc(1);
+    destination->buffer[0] = '{';
+    destination->size = 1;
+    destination->capacity = 1;
+    destination->memberCount = 0;
+    return JSON_ENCODER_OK;
+}
+
 TEST_DEFINE_ENUM_TYPE(CODEFIRST_RESULT, CODEFIRST_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(CODEFIRST_RESULT, CODEFIRST_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(DEVICE_RESULT, DEVICE_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(DEVICE_RESULT, DEVICE_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
 
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
@@ -751,6 +764,14 @@ static SCHEMA_RESULT my_Schema_GetModelModelCount(SCHEMA_MODEL_TYPE_HANDLE model
     return SCHEMA_OK;
 }
 
+/*SimpleDevice_Model has generated JSON encoders, a device whose model cannot be found in the metadata is serialized through Device*/
+static SimpleDevice_Model* CreateSimpleDevice_Model_Without_JSON_Properties(void)
+{
+    STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE))
+        .SetReturn("NotInTheMetadata");
+    return (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+}
+
 #define TEST_SCHEMA_METADATA ((void*)(0x42))
 
 BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
@@ -784,6 +805,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         REGISTER_UMOCK_ALIAS_TYPE(pfOnDesiredProperty, void*);
         REGISTER_UMOCK_ALIAS_TYPE(pfDeviceMethodCallback, void*);
         REGISTER_UMOCK_ALIAS_TYPE(METHODRETURN_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(JSON_ENCODER_BUFFER*, void*);
         
         
         REGISTER_GLOBAL_MOCK_RETURN(Schema_GetModelName, TEST_MODEL_NAME);
@@ -802,7 +824,10 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         REGISTER_TYPE(AGENT_DATA_TYPES_RESULT, AGENT_DATA_TYPES_RESULT);
         REGISTER_TYPE(SCHEMA_RESULT, SCHEMA_RESULT);
         REGISTER_TYPE(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_RESULT);
+        REGISTER_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT);
         
+        REGISTER_GLOBAL_MOCK_HOOK(JSONEncoder_BeginObject, my_JSONEncoder_BeginObject);
+
         REGISTER_GLOBAL_MOCK_HOOK(Device_PublishTransacted, my_Device_PublishTransacted);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(Device_PublishTransacted, DEVICE_ERROR);
         REGISTER_GLOBAL_MOCK_HOOK(Destroy_AGENT_DATA_TYPE, my_Destroy_AGENT_DATA_TYPE);
@@ -1874,6 +1899,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         
         STRICT_EXPECTED_CALL(Schema_AddDeviceRef(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
 
         // act
         void* result = CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &DummyDataProvider_allReflected, 1, false);
@@ -1903,6 +1929,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
             .IgnoreArgument_callbackUserContext();
         STRICT_EXPECTED_CALL(Schema_AddDeviceRef(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
 
         // act
         void* result = CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &DummyDataProvider_allReflected, 1, false);
@@ -1933,6 +1960,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
             .IgnoreArgument_callbackUserContext();
         STRICT_EXPECTED_CALL(Schema_AddDeviceRef(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
 
         // act
         void* result = CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &DummyDataProvider_allReflected, 1, true);
@@ -2064,7 +2092,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
@@ -2117,7 +2145,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2175,7 +2203,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE))
@@ -2201,7 +2229,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2242,7 +2270,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2298,7 +2326,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2398,7 +2426,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2435,7 +2463,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2539,7 +2567,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2594,7 +2622,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2653,7 +2681,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2695,7 +2723,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2727,7 +2755,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2763,7 +2791,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2799,7 +2827,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -2834,6 +2862,228 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         CodeFirst_Deinit();
     }
 
+    /*Tests_SRS_CODEFIRST_01_007: [ CodeFirst_CreateDevice shall look up the model in metadata by the name returned by Schema_GetModelName and, when the model has generated JSON encoders, keep its table of JSON properties. ]*/
+    /*Tests_SRS_CODEFIRST_01_009: [ CodeFirst_SendAsync shall first try to write the values with the JSON encoders generated for the model of the device. ]*/
+    /*Tests_SRS_CODEFIRST_01_011: [ Otherwise each value shall be the address of a WITH_DATA property of the same device, and the properties shall be written in the order in which they were passed. ]*/
+    /*Tests_SRS_CODEFIRST_01_012: [ The values shall be written with JSONEncoder_BeginObject, then JSONEncoder_WriteMemberName and the generated ToJSON function of each property, then JSONEncoder_EndObject. ]*/
+    /*Tests_SRS_CODEFIRST_01_014: [ On success the written JSON shall be returned in destination and destinationSize and CodeFirst_SendAsync shall return CODEFIRST_OK without calling any Device API. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsync_with_generated_JSON_encoders_writes_the_properties_in_argument_order)
+    {
+        // arrange
+        (void)CodeFirst_Init(NULL);
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(JSONEncoder_BeginObject(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_int_Property\":", sizeof("\"this_is_int_Property\":") - 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteInt64(IGNORED_PTR_ARG, 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_double_Property\":", sizeof("\"this_is_double_Property\":") - 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteDouble(IGNORED_PTR_ARG, 42.0));
+        STRICT_EXPECTED_CALL(JSONEncoder_EndObject(IGNORED_PTR_ARG));
+        device->this_is_double_Property = 42.0;
+        device->this_is_int_Property = 1;
+
+        // act
+        CODEFIRST_RESULT result = CodeFirst_SendAsync(&destination, &destinationSize, 2, &device->this_is_int_Property, &device->this_is_double_Property);
+
+        // assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, destinationSize);
+        ASSERT_ARE_EQUAL(int, '{', destination[0]);
+
+        // cleanup
+        my_gballoc_free(destination);
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_010: [ When the only value is the device block, all the WITH_DATA properties of the model shall be written, in the same order as Device would produce them. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsync_with_generated_JSON_encoders_writes_the_entire_device_state)
+    {
+        // arrange
+        (void)CodeFirst_Init(NULL);
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(JSONEncoder_BeginObject(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_int_Property\":", sizeof("\"this_is_int_Property\":") - 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteInt64(IGNORED_PTR_ARG, 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_double_Property\":", sizeof("\"this_is_double_Property\":") - 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteDouble(IGNORED_PTR_ARG, 42.0));
+        STRICT_EXPECTED_CALL(JSONEncoder_EndObject(IGNORED_PTR_ARG));
+        device->this_is_double_Property = 42.0;
+        device->this_is_int_Property = 1;
+
+        // act
+        CODEFIRST_RESULT result = CodeFirst_SendAsync(&destination, &destinationSize, 1, device);
+
+        // assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        my_gballoc_free(destination);
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_013: [ If a ToJSON function returns JSON_ENCODER_VALUE_NOT_SUPPORTED, CodeFirst_SendAsync shall discard what was written and go through Device. ]*/
+    TEST_FUNCTION(When_a_ToJSON_function_does_not_support_the_value_CodeFirst_SendAsync_goes_through_Device)
+    {
+        // arrange
+        (void)CodeFirst_Init(NULL);
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(JSONEncoder_BeginObject(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_double_Property\":", sizeof("\"this_is_double_Property\":") - 1));
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteDouble(IGNORED_PTR_ARG, 42.0))
+            .SetReturn(JSON_ENCODER_VALUE_NOT_SUPPORTED);
+        STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_new());
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_s2();
+        EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_DOUBLE(IGNORED_PTR_ARG, 0.0));
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Device_PublishTransacted(IGNORED_PTR_ARG, "this_is_double_Property", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Device_EndTransaction(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+        device->this_is_double_Property = 42.0;
+
+        // act
+        CODEFIRST_RESULT result = CodeFirst_SendAsync(&destination, &destinationSize, 1, &device->this_is_double_Property);
+
+        // assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_011: [ Otherwise each value shall be the address of a WITH_DATA property of the same device, and the properties shall be written in the order in which they were passed. ]*/
+    TEST_FUNCTION(When_a_property_is_passed_twice_CodeFirst_SendAsync_goes_through_Device)
+    {
+        // arrange
+        (void)CodeFirst_Init(NULL);
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        unsigned char* destination;
+        size_t destinationSize;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_new());
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_s2();
+        EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, 0));
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Device_PublishTransacted(IGNORED_PTR_ARG, "this_is_int_Property", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(STRING_new());
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_handle()
+            .IgnoreArgument_s2();
+        EXPECTED_CALL(Create_AGENT_DATA_TYPE_from_SINT32(IGNORED_PTR_ARG, 0));
+        STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(Device_PublishTransacted(IGNORED_PTR_ARG, "this_is_int_Property", IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(3);
+        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+            .IgnoreArgument_handle();
+        EXPECTED_CALL(Destroy_AGENT_DATA_TYPE(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Device_EndTransaction(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_transactionHandle()
+            .IgnoreArgument(2)
+            .IgnoreArgument(3);
+        device->this_is_int_Property = 1;
+
+        // act
+        (void)CodeFirst_SendAsync(&destination, &destinationSize, 2, &device->this_is_int_Property, &device->this_is_int_Property);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        // cleanup
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_015: [ If any other JSONEncoder call fails, CodeFirst_SendAsync shall return CODEFIRST_ERROR. ]*/
+    TEST_FUNCTION(CodeFirst_SendAsync_with_generated_JSON_encoders_unhappy_paths)
+    {
+        // arrange
+        (void)CodeFirst_Init(NULL);
+        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        umock_c_reset_all_calls();
+
+        (void)umock_c_negative_tests_init();
+
+        STRICT_EXPECTED_CALL(JSONEncoder_BeginObject(IGNORED_PTR_ARG))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_int_Property\":", sizeof("\"this_is_int_Property\":") - 1))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteInt64(IGNORED_PTR_ARG, 1))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteMemberName(IGNORED_PTR_ARG, "\"this_is_double_Property\":", sizeof("\"this_is_double_Property\":") - 1))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(JSONEncoder_WriteDouble(IGNORED_PTR_ARG, 42.0))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        STRICT_EXPECTED_CALL(JSONEncoder_EndObject(IGNORED_PTR_ARG))
+            .SetFailReturn(JSON_ENCODER_ERROR);
+        device->this_is_double_Property = 42.0;
+        device->this_is_int_Property = 1;
+
+        umock_c_negative_tests_snapshot();
+
+        for (size_t i = 0; i < umock_c_negative_tests_call_count(); i++)
+        {
+            unsigned char* destination;
+            size_t destinationSize;
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
+            char temp_str[128];
+            sprintf(temp_str, "On failed call %zu", i);
+
+            // act
+            CODEFIRST_RESULT result = CodeFirst_SendAsync(&destination, &destinationSize, 2, &device->this_is_int_Property, &device->this_is_double_Property);
+
+            // assert
+            ASSERT_ARE_EQUAL_WITH_MSG(CODEFIRST_RESULT, CODEFIRST_ERROR, result, temp_str);
+        }
+
+        // cleanup
+        CodeFirst_DestroyDevice(device);
+        umock_c_negative_tests_deinit();
+        CodeFirst_Deinit();
+    }
+
     /* Tests_SRS_CODEFIRST_99_133:[CodeFirst_SendAsync shall allow sending of properties that are part of a child model.] */
     /* Tests_SRS_CODEFIRST_99_136:[CodeFirst_SendAsync shall build the full path for each property and then pass it to Device_PublishTransacted.] */
     TEST_FUNCTION(CodeFirst_SendAsync_Can_Send_A_Property_From_A_Child_Model)
@@ -2982,7 +3232,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     {
         // arrange
         (void)CodeFirst_Init(NULL);
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(Device_StartTransaction(TEST_DEVICE_HANDLE));
@@ -3991,6 +4241,112 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
         CodeFirst_Deinit();
     }
 
+    /*Tests_SRS_CODEFIRST_01_002: [ If argument device or jsonPayload is NULL then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_IngestDesiredPropertiesInPlace_with_NULL_device_fails)
+    {
+        ///arrange
+        char jsonPayload[] = "{\"a\":3}";
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_IngestDesiredPropertiesInPlace(NULL, jsonPayload, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+
+        ///clean
+    }
+
+    /*Tests_SRS_CODEFIRST_01_002: [ If argument device or jsonPayload is NULL then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_INVALID_ARG. ]*/
+    TEST_FUNCTION(CodeFirst_IngestDesiredPropertiesInPlace_with_NULL_jsonPayload_fails)
+    {
+        ///arrange
+        (void)CodeFirst_Init(NULL);
+        OuterType* device = (OuterType*)CodeFirst_CreateDevice(TEST_OUTERTYPE_MODEL_HANDLE, &ALL_REFLECTED(testModelInModelReflected), sizeof(OuterType), false);
+        umock_c_reset_all_calls();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_IngestDesiredPropertiesInPlace(device, NULL, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_INVALID_ARG, result);
+
+        ///clean
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_003: [ CodeFirst_IngestDesiredPropertiesInPlace shall locate the device associated with device. ]*/
+    /*Tests_SRS_CODEFIRST_01_004: [ CodeFirst_IngestDesiredPropertiesInPlace shall call Device_IngestDesiredPropertiesInPlace passing jsonPayload and parseDesiredNode. ]*/
+    /*Tests_SRS_CODEFIRST_01_006: [ Otherwise, CodeFirst_IngestDesiredPropertiesInPlace shall return CODEFIRST_OK. ]*/
+    TEST_FUNCTION(CodeFirst_IngestDesiredPropertiesInPlace_succeeds)
+    {
+        ///arrange
+        char jsonPayload[] = "{\"desired\":{\"a\":3}}";
+        (void)CodeFirst_Init(NULL);
+        OuterType* device = (OuterType*)CodeFirst_CreateDevice(TEST_OUTERTYPE_MODEL_HANDLE, &ALL_REFLECTED(testModelInModelReflected), sizeof(OuterType), false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Device_IngestDesiredPropertiesInPlace(device, IGNORED_PTR_ARG, jsonPayload, true))
+            .IgnoreArgument_deviceHandle();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_IngestDesiredPropertiesInPlace(device, jsonPayload, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_005: [ If there is any failure, then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_ERROR. ]*/
+    TEST_FUNCTION(CodeFirst_IngestDesiredPropertiesInPlace_with_unknown_device_fails)
+    {
+        ///arrange
+        char jsonPayload[] = "{\"a\":3}";
+        (void)CodeFirst_Init(NULL);
+        OuterType* device = (OuterType*)CodeFirst_CreateDevice(TEST_OUTERTYPE_MODEL_HANDLE, &ALL_REFLECTED(testModelInModelReflected), sizeof(OuterType), false);
+        umock_c_reset_all_calls();
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_IngestDesiredPropertiesInPlace(device - 1, jsonPayload, false); /*not a device known to FindDevice*/
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
+    /*Tests_SRS_CODEFIRST_01_005: [ If there is any failure, then CodeFirst_IngestDesiredPropertiesInPlace shall fail and return CODEFIRST_ERROR. ]*/
+    TEST_FUNCTION(CodeFirst_IngestDesiredPropertiesInPlace_when_Device_IngestDesiredPropertiesInPlace_fails_fails)
+    {
+        ///arrange
+        char jsonPayload[] = "{\"a\":3}";
+        (void)CodeFirst_Init(NULL);
+        OuterType* device = (OuterType*)CodeFirst_CreateDevice(TEST_OUTERTYPE_MODEL_HANDLE, &ALL_REFLECTED(testModelInModelReflected), sizeof(OuterType), false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Device_IngestDesiredPropertiesInPlace(device, IGNORED_PTR_ARG, jsonPayload, false))
+            .IgnoreArgument_deviceHandle()
+            .SetReturn(DEVICE_ERROR);
+
+        ///act
+        CODEFIRST_RESULT result = CodeFirst_IngestDesiredPropertiesInPlace(device, jsonPayload, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(CODEFIRST_RESULT, CODEFIRST_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        CodeFirst_DestroyDevice(device);
+        CodeFirst_Deinit();
+    }
+
     /* Tests_SRS_CODEFIRST_99_002:[ CodeFirst_RegisterSchema shall create the schema information and give it to the Schema module for one schema, identified by the metadata argument. On success, it shall return a handle to the model.] */
     TEST_FUNCTION(CodeFirst_CreateDevice_passes_onDesiredProperty_callbacks)
     {
@@ -4082,6 +4438,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
             .IgnoreArgument_callbackUserContext();
         STRICT_EXPECTED_CALL(Schema_AddDeviceRef(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Schema_GetModelName(TEST_MODEL_HANDLE));
 
         // act
         void* result = CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &DummyDataProvider_allReflected, 1, false);
@@ -4125,7 +4482,7 @@ BEGIN_TEST_SUITE(CodeFirst_ut_Dummy_Data_Provider)
     TEST_FUNCTION(CodeFirst_SendAsync_calls_CodeFirst_Init_with_NULL_overrideSchemaNamespace)
     {
         ///arrange = note - no CodeFirst_Init
-        SimpleDevice_Model* device = (SimpleDevice_Model*)CodeFirst_CreateDevice(TEST_MODEL_HANDLE, &ALL_REFLECTED(testReflectedData), sizeof(SimpleDevice_Model), false);
+        SimpleDevice_Model* device = CreateSimpleDevice_Model_Without_JSON_Properties();
         unsigned char* destination;
         size_t destinationSize;
         umock_c_reset_all_calls();
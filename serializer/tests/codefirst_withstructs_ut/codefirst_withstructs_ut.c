@@ -34,6 +34,7 @@ void my_gballoc_free(void * t)
 #include "agenttypesystem.h"
 #include "schema.h"
 #include "iotdevice.h"
+#include "jsonencoder.h"
 #undef ENABLE_MOCKS
 
 #include "testrunnerswitcher.h"
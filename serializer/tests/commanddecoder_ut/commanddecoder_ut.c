@@ -2991,15 +2991,8 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
         CommandDecoder_Destroy(commandDecoderHandle);
     }
 
-    void CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, const char* three, size_t one, MULTITREE_HANDLE childHandle, bool desiredPropertyHasCallback)
+    void ingest_1_simple_desired_property_inert_path(unsigned char* deviceMemoryArea, const char* three, size_t one, MULTITREE_HANDLE childHandle, bool desiredPropertyHasCallback)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
-            .IgnoreArgument_destination();
-
-        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument_json()
-            .IgnoreArgument_multiTreeHandle();
-
         STRICT_EXPECTED_CALL(MultiTree_GetChildCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*2*/
             .IgnoreArgument_treeHandle()
             .CopyOutArgumentBuffer_count(&one, sizeof(one));
@@ -3062,6 +3055,18 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
             .IgnoreArgument_agentData();
 
         STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE_CHILD_NAME));
+    }
+
+    void CommandDecoder_IngestDesiredProperties_with_1_simple_desired_property_succeeds_inert_path(unsigned char* deviceMemoryArea, const char* desiredPropertiesJSON, const char* three, size_t one, MULTITREE_HANDLE childHandle, bool desiredPropertyHasCallback)
+    {
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_multiTreeHandle();
+
+        ingest_1_simple_desired_property_inert_path(deviceMemoryArea, three, one, childHandle, desiredPropertyHasCallback);
 
         STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
             .IgnoreArgument_treeHandle();
@@ -3436,6 +3441,191 @@ BEGIN_TEST_SUITE(CommandDecoder_ut)
 
     }
     
+    /*Tests_SRS_COMMAND_DECODER_01_017: [ Children whose name starts with '$' (such as "$version" and "$metadata") are service metadata and shall be skipped. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredProperties_skips_dollar_names)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        const char* desiredPropertiesJSON = "{\"$version\":3}";
+        size_t one = 1;
+        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, desiredPropertiesJSON))
+            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_json()
+            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_GetChildCount(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle()
+            .CopyOutArgumentBuffer_count(&one, sizeof(one));
+        STRICT_EXPECTED_CALL(MultiTree_GetChild(IGNORED_PTR_ARG, 0, IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle()
+            .CopyOutArgumentBuffer_childHandle(&childHandle, sizeof(childHandle));
+        STRICT_EXPECTED_CALL(STRING_new())
+            .SetReturn(TEST_STRING_HANDLE_CHILD_NAME);
+        STRICT_EXPECTED_CALL(MultiTree_GetName(childHandle, TEST_STRING_HANDLE_CHILD_NAME));
+        STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_CHILD_NAME))
+            .SetReturn("$version");
+        STRICT_EXPECTED_CALL(STRING_delete(TEST_STRING_HANDLE_CHILD_NAME));
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(IGNORED_PTR_ARG))
+            .IgnoreArgument_treeHandle();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredProperties(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_018: [ If startAddress, handle or jsonPayload is NULL then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_with_NULL_startAddress_fails)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        char desiredPropertiesJSON[] = "{\"int_field\":3}";
+        umock_c_reset_all_calls();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(NULL, commandDecoderHandle, desiredPropertiesJSON, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_018: [ If startAddress, handle or jsonPayload is NULL then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_with_NULL_handle_fails)
+    {
+        ///arrange
+        char deviceMemoryArea[100];
+        char desiredPropertiesJSON[] = "{\"int_field\":3}";
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(deviceMemoryArea, NULL, desiredPropertiesJSON, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_018: [ If startAddress, handle or jsonPayload is NULL then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_ERROR. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_with_NULL_jsonPayload_fails)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        char deviceMemoryArea[100];
+        umock_c_reset_all_calls();
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(deviceMemoryArea, commandDecoderHandle, NULL, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_019: [ CommandDecoder_IngestDesiredPropertiesInPlace shall create a MULTITREE_HANDLE out of jsonPayload without copying it. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_with_1_simple_desired_property_happy_path)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        char desiredPropertiesJSON[] = "{\"int_field\":3}";
+        const char* three = "3";
+        size_t one = 1;
+        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
+
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(desiredPropertiesJSON, IGNORED_PTR_ARG))
+            .IgnoreArgument_multiTreeHandle();
+        ingest_1_simple_desired_property_inert_path(deviceMemoryArea, three, one, childHandle, false);
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_020: [ If parseDesiredNode is true then CommandDecoder_IngestDesiredPropertiesInPlace shall only ingest the "desired" child of the MULTITREE. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_with_parseDesiredNode_ingests_desired_happy_path)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        char desiredPropertiesJSON[] = "{\"desired\":{\"int_field\":3},\"reported\":{}}";
+        const char* three = "3";
+        size_t one = 1;
+        MULTITREE_HANDLE childHandle = (MULTITREE_HANDLE)0x11;
+        MULTITREE_HANDLE desiredHandle = (MULTITREE_HANDLE)0x12;
+
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(desiredPropertiesJSON, IGNORED_PTR_ARG))
+            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_GetChildByName(TEST_COMMANDS_ROOT_NODE, "desired", IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_childHandle(&desiredHandle, sizeof(desiredHandle));
+        ingest_1_simple_desired_property_inert_path(deviceMemoryArea, three, one, childHandle, false);
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_SUCCESS, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
+    /*Tests_SRS_COMMAND_DECODER_01_021: [ If parseDesiredNode is true and there is no "desired" child then CommandDecoder_IngestDesiredPropertiesInPlace shall fail and return EXECUTE_COMMAND_FAILED. ]*/
+    TEST_FUNCTION(CommandDecoder_IngestDesiredPropertiesInPlace_without_desired_fails)
+    {
+        ///arrange
+        COMMAND_DECODER_HANDLE commandDecoderHandle = CommandDecoder_Create(TEST_MODEL_HANDLE, ActionCallbackMock, TEST_CALLBACK_CONTEXT_VALUE, methodCallbackMock, TEST_CALLBACK_CONTEXT_VALUE);
+        umock_c_reset_all_calls();
+        unsigned char deviceMemoryArea[100];
+        char desiredPropertiesJSON[] = "{\"reported\":{}}";
+
+        STRICT_EXPECTED_CALL(JSONDecoder_JSON_To_MultiTree(desiredPropertiesJSON, IGNORED_PTR_ARG))
+            .IgnoreArgument_multiTreeHandle();
+        STRICT_EXPECTED_CALL(MultiTree_GetChildByName(TEST_COMMANDS_ROOT_NODE, "desired", IGNORED_PTR_ARG))
+            .IgnoreArgument_childHandle()
+            .SetReturn(MULTITREE_CHILD_NOT_FOUND);
+        STRICT_EXPECTED_CALL(MultiTree_Destroy(TEST_COMMANDS_ROOT_NODE));
+
+        ///act
+        EXECUTE_COMMAND_RESULT result = CommandDecoder_IngestDesiredPropertiesInPlace(deviceMemoryArea, commandDecoderHandle, desiredPropertiesJSON, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(EXECUTE_COMMAND_RESULT, EXECUTE_COMMAND_FAILED, result);
+
+        ///clean
+        CommandDecoder_Destroy(commandDecoderHandle);
+    }
+
     /*Tests_SRS_COMMAND_DECODER_02_014: [ If handle is NULL then CommandDecoder_ExecuteMethod shall fail and return NULL. ]*/
     TEST_FUNCTION(CommandDecoder_ExecuteMethod_with_NULL_handle_fails)
     {
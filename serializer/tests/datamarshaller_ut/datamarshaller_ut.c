@@ -111,7 +111,7 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(JSON_ENCODER_RESULT, JSON_ENCODER_RESULT_VALUES);
 
 #define DEFAULT_PROPERTY_NAME_2 "blahBlah"
 
-static MULTITREE_HANDLE my_MultiTree_Create(MULTITREE_CLONE_FUNCTION cloneFunction, MULTITREE_FREE_FUNCTION freeFunction)
+static MULTITREE_HANDLE my_MultiTree_CreateWithArena(MULTITREE_CLONE_FUNCTION cloneFunction, MULTITREE_FREE_FUNCTION freeFunction)
 {
     (void)cloneFunction;
     (void)freeFunction;
@@ -184,7 +184,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         REGISTER_UMOCK_ALIAS_TYPE(DATA_MARSHALLER_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(JSON_ENCODER_RESULT, int);
             
-        REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Create, my_MultiTree_Create);
+        REGISTER_GLOBAL_MOCK_HOOK(MultiTree_CreateWithArena, my_MultiTree_CreateWithArena);
         REGISTER_GLOBAL_MOCK_HOOK(MultiTree_Destroy, my_MultiTree_Destroy);
 
         REGISTER_GLOBAL_MOCK_HOOK(STRING_new, real_STRING_new);
@@ -533,7 +533,8 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
     }
 
     /* Tests_SRS_DATA_MARSHALLER_99_035:[DATA_MARSHALLER_MULTITREE_ERROR shall be returned in case any MultiTree API call fails.] */
-    TEST_FUNCTION(DataMarshaller_SendData_When_MultiTree_Create_Fails_Then_Fails)
+    /* Tests_SRS_DATA_MARSHALLER_01_005: [ The MultiTree shall be created with MultiTree_CreateWithArena. ]*/
+    TEST_FUNCTION(DataMarshaller_SendData_When_MultiTree_CreateWithArena_Fails_Then_Fails)
     {
         ///arrange
         DATA_MARSHALLER_HANDLE handle = DataMarshaller_Create(TEST_MODEL_HANDLE, true);
@@ -543,7 +544,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
 
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .SetReturn((MULTITREE_HANDLE)NULL);
 
         ///act
@@ -568,7 +569,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
 
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
 
-        STRICT_EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreArgument_cloneFunction()
             .IgnoreArgument_freeFunction();
 
@@ -607,7 +608,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         values[1].PropertyPath = DEFAULT_PROPERTY_NAME_2;
         values[1].Value = &floatValid2;
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -639,7 +640,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         size_t destinationSize;
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -680,7 +681,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
         char json_payload[] = "Test";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -731,7 +732,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &structTypeValue } };
         char json_payload[] = "Test";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -779,7 +780,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DATA_MARSHALLER_VALUE value[] = { { DEFAULT_PROPERTY_NAME, &floatValid }, { DEFAULT_PROPERTY_NAME_2, &floatValid } };
         char json_payload[] = "Test";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -827,7 +828,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
         char json_payload[] = "Test";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -874,7 +875,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
         char json_payload[] = "Test";
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
             .IgnoreArgument_treeHandle();
@@ -920,7 +921,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
             .IgnoreArgument_treeHandle()
@@ -950,7 +951,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &structTypeValue2Members };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, "x", structTypeValue2Members.value.edmComplexType.fields[0].value))
             .IgnoreArgument_treeHandle();
@@ -982,7 +983,7 @@ BEGIN_TEST_SUITE(DataMarshaller_ut)
         umock_c_reset_all_calls();
         DATA_MARSHALLER_VALUE value = { DEFAULT_PROPERTY_NAME, &floatValid };
 
-        EXPECTED_CALL(MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        EXPECTED_CALL(MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
         STRICT_EXPECTED_CALL(MultiTree_AddLeaf(IGNORED_PTR_ARG, DEFAULT_PROPERTY_NAME, &floatValid))
             .IgnoreArgument_treeHandle();
@@ -1400,6 +1400,108 @@ BEGIN_TEST_SUITE(IoTDevice_ut)
         Device_Destroy(h);
     }
 
+    /*Tests_SRS_DEVICE_01_056: [ If startAddress, deviceHandle or jsonPayload is NULL then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_INVALID_ARG. ]*/
+    TEST_FUNCTION(Device_IngestDesiredPropertiesInPlace_with_NULL_deviceHandle_fails)
+    {
+        ///arrange
+        char jsonPayload[] = "{}";
+
+        ///act
+        DEVICE_RESULT result = Device_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, NULL, jsonPayload, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DEVICE_RESULT, DEVICE_INVALID_ARG, result);
+
+        ///clean
+    }
+
+    /*Tests_SRS_DEVICE_01_056: [ If startAddress, deviceHandle or jsonPayload is NULL then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_INVALID_ARG. ]*/
+    TEST_FUNCTION(Device_IngestDesiredPropertiesInPlace_with_NULL_jsonPayload_fails)
+    {
+        ///arrange
+        DEVICE_HANDLE h;
+        Device_Create(irrelevantModel, DeviceActionCallback, TEST_CALLBACK_CONTEXT, deviceMethodCallback, TEST_CALLBACK_CONTEXT, false, &h);
+        umock_c_reset_all_calls();
+
+        ///act
+        DEVICE_RESULT result = Device_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, h, NULL, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DEVICE_RESULT, DEVICE_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Device_Destroy(h);
+    }
+
+    /*Tests_SRS_DEVICE_01_056: [ If startAddress, deviceHandle or jsonPayload is NULL then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_INVALID_ARG. ]*/
+    TEST_FUNCTION(Device_IngestDesiredPropertiesInPlace_with_NULL_startAddress_fails)
+    {
+        ///arrange
+        DEVICE_HANDLE h;
+        char jsonPayload[] = "{}";
+        Device_Create(irrelevantModel, DeviceActionCallback, TEST_CALLBACK_CONTEXT, deviceMethodCallback, TEST_CALLBACK_CONTEXT, false, &h);
+        umock_c_reset_all_calls();
+
+        ///act
+        DEVICE_RESULT result = Device_IngestDesiredPropertiesInPlace(NULL, h, jsonPayload, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DEVICE_RESULT, DEVICE_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Device_Destroy(h);
+    }
+
+    /*Tests_SRS_DEVICE_01_057: [ Device_IngestDesiredPropertiesInPlace shall call CommandDecoder_IngestDesiredPropertiesInPlace passing jsonPayload and parseDesiredNode. ]*/
+    /*Tests_SRS_DEVICE_01_059: [ Otherwise, Device_IngestDesiredPropertiesInPlace shall succeed and return DEVICE_OK. ]*/
+    TEST_FUNCTION(Device_IngestDesiredPropertiesInPlace_succeeds)
+    {
+        ///arrange
+        DEVICE_HANDLE h;
+        char jsonPayload[] = "{\"desired\":{}}";
+        Device_Create(irrelevantModel, DeviceActionCallback, TEST_CALLBACK_CONTEXT, deviceMethodCallback, TEST_CALLBACK_CONTEXT, false, &h);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(CommandDecoder_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, IGNORED_PTR_ARG, jsonPayload, true))
+            .IgnoreArgument_handle();
+
+        ///act
+        DEVICE_RESULT result = Device_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, h, jsonPayload, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DEVICE_RESULT, DEVICE_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Device_Destroy(h);
+    }
+
+    /*Tests_SRS_DEVICE_01_058: [ If CommandDecoder_IngestDesiredPropertiesInPlace fails then Device_IngestDesiredPropertiesInPlace shall fail and return DEVICE_ERROR. ]*/
+    TEST_FUNCTION(Device_IngestDesiredPropertiesInPlace_fails)
+    {
+        ///arrange
+        DEVICE_HANDLE h;
+        char jsonPayload[] = "{}";
+        Device_Create(irrelevantModel, DeviceActionCallback, TEST_CALLBACK_CONTEXT, deviceMethodCallback, TEST_CALLBACK_CONTEXT, false, &h);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(CommandDecoder_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, IGNORED_PTR_ARG, jsonPayload, false))
+            .IgnoreArgument_handle()
+            .SetReturn(EXECUTE_COMMAND_FAILED);
+
+        ///act
+        DEVICE_RESULT result = Device_IngestDesiredPropertiesInPlace(FAKE_DEVICE_START_ADDRESS, h, jsonPayload, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(DEVICE_RESULT, DEVICE_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        Device_Destroy(h);
+    }
+
     /*Tests_SRS_DEVICE_02_038: [ If deviceHandle is NULL then Device_ExecuteMethod shall fail and return NULL. ]*/
     TEST_FUNCTION(Device_ExecuteMethod_with_NULL_deviceHandle_fails)
     {
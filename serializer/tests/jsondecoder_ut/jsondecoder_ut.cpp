@@ -20,7 +20,7 @@ TYPED_MOCK_CLASS(CJSONDecoderMocks, CGlobalMock)
 {
 public:
     /* MultiTree mocks */
-    MOCK_STATIC_METHOD_2(, MULTITREE_HANDLE, MultiTree_Create, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction)
+    MOCK_STATIC_METHOD_2(, MULTITREE_HANDLE, MultiTree_CreateWithArena, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction)
     MOCK_METHOD_END(MULTITREE_HANDLE, TestMultiTreeHandle)
     MOCK_STATIC_METHOD_1(, void, MultiTree_Destroy, MULTITREE_HANDLE, treeHandle)
     MOCK_VOID_METHOD_END()
@@ -30,7 +30,7 @@ public:
     MOCK_METHOD_END(MULTITREE_RESULT, MULTITREE_OK)
 };
 
-DECLARE_GLOBAL_MOCK_METHOD_2(CJSONDecoderMocks, , MULTITREE_HANDLE, MultiTree_Create, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction);
+DECLARE_GLOBAL_MOCK_METHOD_2(CJSONDecoderMocks, , MULTITREE_HANDLE, MultiTree_CreateWithArena, MULTITREE_CLONE_FUNCTION, cloneFunction, MULTITREE_FREE_FUNCTION, freeFunction);
 DECLARE_GLOBAL_MOCK_METHOD_1(CJSONDecoderMocks, , void, MultiTree_Destroy, MULTITREE_HANDLE, treeHandle);
 DECLARE_GLOBAL_MOCK_METHOD_3(CJSONDecoderMocks, , MULTITREE_RESULT, MultiTree_AddChild, MULTITREE_HANDLE, treeHandle, const char*, childName, MULTITREE_HANDLE*, childHandle);
 DECLARE_GLOBAL_MOCK_METHOD_2(CJSONDecoderMocks, , MULTITREE_RESULT, MultiTree_SetValue, MULTITREE_HANDLE, treeHandle, void*, value);
@@ -101,7 +101,7 @@ TEST_FUNCTION(JSONDecoder_With_A_Space_As_json_argument_Fails)
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     char jsonString[] = " ";
@@ -136,7 +136,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Starts_With_An_Unexpected_Character_Fail
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     char jsonString[] = "a";
@@ -155,7 +155,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Left_Square_Bracket_De
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     char jsonString[] = "[";
@@ -174,7 +174,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Left_Curly_Brace_Decod
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = "{";
 
@@ -193,7 +193,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Right_Square_Bracket_D
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = "]";
     ///act
@@ -211,7 +211,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Right_Curly_Brace_Deco
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = "}";
     ///act
@@ -229,7 +229,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Colon_Decoding_Fails)
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = ":";
     ///act
@@ -247,7 +247,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_Only_A_Comma_Decoding_Fails)
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = ",";
     ///act
@@ -265,7 +265,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_An_Empty_Object_Decoding_Succeeds)
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     char jsonString[] = "{}";
     ///act
     JSON_DECODER_RESULT result = JSONDecoder_JSON_To_MultiTree(jsonString, &multiTree);
@@ -283,7 +283,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_An_Empty_Object_Followed_By_Another_O
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = "{}{";
     ///act
@@ -302,7 +302,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_2_Empty_Objects_At_Root_Decod
     CJSONDecoderMocks mocks;
     MULTITREE_HANDLE multiTree;
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
     char jsonString[] = "{}{}";
     ///act
@@ -325,7 +325,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_An_Object_With_One_Element_De
     char json[] = "{\"member1\":\"a\"}";
     void* memberValue = strstr(json, "\"a\"");
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "member1", IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, memberValue));
 
@@ -343,6 +343,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_An_Object_With_One_Element_De
 /* Tests_SRS_JSON_DECODER_99_024:[ A single comma separates a value from a following name.] */
 /* Tests_SRS_JSON_DECODER_99_028:[ A string begins and ends with quotation marks.] */
 /* Tests_SRS_JSON_DECODER_99_002:[ JSONDecoder_JSON_To_MultiTree shall use the MultiTree APIs to create the multi tree and add leafs to the multi tree.] */
+/* Tests_SRS_JSON_DECODER_01_001: [ JSONDecoder_JSON_To_MultiTree shall create the multi tree with MultiTree_CreateWithArena. ]*/
 /* Tests_SRS_JSON_DECODER_99_003:[ When a JSON element is decoded from the JSON object then a leaf shall be added to the MultiTree.] */
 /* Tests_SRS_JSON_DECODER_99_004:[ The leaf node name in the multi tree shall be the JSON element name.] */
 /* Tests_SRS_JSON_DECODER_99_005:[ The leaf node added in the multi tree shall have the value the string value of the JSON element as parsed from the JSON object.] */
@@ -357,7 +358,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Is_Made_Of_An_Object_With_2_Elements_Dec
     void* member1Value = strstr(json, "\"a\"");
     void* member2Value = strstr(json, "\"b\"");
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "member1", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, member1Value));
@@ -381,7 +382,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Member_Name_Quote_Decodin
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -400,7 +401,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_First_Char_Of_The_Member_
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"m";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -419,7 +420,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Ending_Quote_Of_The_Membe
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"m\"";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -438,7 +439,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Colon_Decoding_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"m\":";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -459,7 +460,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Begining_Value_Quote_Deco
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -480,7 +481,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_In_The_Middle_Of_A_String_Value_Dec
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"a";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
@@ -500,7 +501,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Ending_Quote_Of_A_Value_D
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"a\"";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -521,7 +522,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_A_Comma_Decoding_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"a\",";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -542,7 +543,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Starting_Quote_Of_The_Name_Is_Missing_Decodin
     MULTITREE_HANDLE multiTree;
     char json[] = "{member1\":\"a\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -561,7 +562,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Ending_Quote_Of_The_Name_Is_Missing_Decoding_
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1:\"a\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -580,7 +581,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Colon_Is_Missing_In_A_Name_Value_Pair_Decodin
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\"\"a\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -599,7 +600,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Starting_Quote_Of_A_String_Value_Is_Missing_D
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":a\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
@@ -619,7 +620,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Ending_Quote_Of_A_String_Value_Is_Missing_Dec
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":a\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
@@ -639,7 +640,7 @@ TEST_FUNCTION(JSONDecoder_When_The_Comma_Separator_Is_Missing_Decoding_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"a\"\"member2\":\"b\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -660,7 +661,7 @@ TEST_FUNCTION(JSONDecoder_When_The_AddChild_Fails_Decoding_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "{\"member1\":\"a\",\"member1\":\"b\"}";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MULTITREE_INVALID_ARG);
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
@@ -679,7 +680,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Empty_Array_Decoding_Succeed
     MULTITREE_HANDLE multiTree;
     char json[] = "[]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     ///act
     JSON_DECODER_RESULT result = JSONDecoder_JSON_To_MultiTree(json, &multiTree);
@@ -697,7 +698,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_Only_The_Opening_Array_Square_B
     MULTITREE_HANDLE multiTree;
     char json[] = "[";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -716,7 +717,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_Only_The_Closing_Array_Square_B
     MULTITREE_HANDLE multiTree;
     char json[] = "]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
 
     ///act
@@ -736,7 +737,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_One_String_Value_Decoding_Succe
     char json[] = "[\"a\"]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -760,7 +761,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_2_String_Values_D
     void* value1Ptr = &json[1];
     void* value2Ptr = &json[5];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -784,7 +785,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Begginning_Quote_Of_The_A
     MULTITREE_HANDLE multiTree;
     char json[] = "[\"";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -805,7 +806,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_In_The_Middle_Of_The_Array_First_St
     MULTITREE_HANDLE multiTree;
     char json[] = "[\"a";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -827,7 +828,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Ending_Quote_Of_The_Array
     char json[] = "[\"a\"";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -850,7 +851,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Ends_After_The_Comma_Of_The_Array_Decodi
     char json[] = "[\"a\",";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -874,7 +875,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_false_value_Dec
     char json[] = "[false]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -895,7 +896,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_true_value_Deco
     char json[] = "[true]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -916,7 +917,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_null_value_Deco
     char json[] = "[null]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -937,7 +938,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_false_But_Not_A
     MULTITREE_HANDLE multiTree;
     char json[] = "[fAlse]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -958,7 +959,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_true_But_Not_Al
     MULTITREE_HANDLE multiTree;
     char json[] = "[trUe]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -979,7 +980,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_null_But_Not_Al
     MULTITREE_HANDLE multiTree;
     char json[] = "[Null]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -1000,7 +1001,7 @@ TEST_FUNCTION(JSONDecoder_When_The_JSON_Contains_An_Array_With_A_Literal_Name_Th
     MULTITREE_HANDLE multiTree;
     char json[] = "[hagauaga]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -1023,7 +1024,7 @@ TEST_FUNCTION(JSONDecoder_Space_Before_Array_Begin_Is_Allowed_And_Decoding_Succe
     char json[] = " [true]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1046,7 +1047,7 @@ TEST_FUNCTION(JSONDecoder_CR_Before_Array_Begin_Is_Allowed_And_Decoding_Succeeds
     char json[] = "\r[true]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1069,7 +1070,7 @@ TEST_FUNCTION(JSONDecoder_NL_Before_Array_Begin_Is_Allowed_And_Decoding_Succeeds
     char json[] = "\n[true]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1092,7 +1093,7 @@ TEST_FUNCTION(JSONDecoder_Tab_Before_Array_Begin_Is_Allowed_And_Decoding_Succeed
     char json[] = "\t[true]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1114,7 +1115,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Array_Begin_Is_Allowed_And
     char json[] = " \t\r\n[true]";
     void* value1Ptr = &json[5];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1137,7 +1138,7 @@ TEST_FUNCTION(JSONDecoder_Space_After_Array_Begin_Is_Allowed_And_Decoding_Succee
     char json[] = "[ true]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1160,7 +1161,7 @@ TEST_FUNCTION(JSONDecoder_CR_After_Array_Begin_Is_Allowed_And_Decoding_Succeeds)
     char json[] = "[\rtrue]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1183,7 +1184,7 @@ TEST_FUNCTION(JSONDecoder_NL_After_Array_Begin_Is_Allowed_And_Decoding_Succeeds)
     char json[] = "[\ntrue]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1206,7 +1207,7 @@ TEST_FUNCTION(JSONDecoder_Tab_After_Array_Begin_Is_Allowed_And_Decoding_Succeeds
     char json[] = "[\ttrue]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1228,7 +1229,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Array_Begin_Is_Allowed_And_
     char json[] = "[ \t\r\ntrue]";
     void* value1Ptr = &json[5];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1250,7 +1251,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Array_End_Is_Allowed_And_D
     char json[] = "[true \t\r\n]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1272,7 +1273,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Array_End_Is_Allowed_And_De
     char json[] = "[true] \t\r\n";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1295,7 +1296,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Comma_In_Array_Is_Allowed_
     void* value1Ptr = &json[1];
     void* value2Ptr = &json[10];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1321,7 +1322,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Comma_In_Array_Is_Allowed_A
     void* value1Ptr = &json[1];
     void* value2Ptr = &json[10];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1346,7 +1347,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Object_Begin_Is_Allowed_An
     char json[] = " \t\r\n{\"a\":true}";
     void* value1Ptr = &json[9];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1368,7 +1369,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Object_Begin_Is_Allowed_And
     char json[] = "{ \t\r\n\"a\":true}";
     void* value1Ptr = &json[9];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1390,7 +1391,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Object_End_Is_Allowed_And_
     char json[] = "{\"a\":true \t\r\n}";
     void* value1Ptr = &json[5];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1412,7 +1413,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Object_End_Is_Allowed_And_D
     char json[] = "{\"a\":true} \t\r\n";
     void* value1Ptr = &json[5];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1434,7 +1435,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Colon_Is_Allowed_And_Decod
     char json[] = "{\"a\" \t\r\n:true}";
     void* value1Ptr = &json[9];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1456,7 +1457,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Colon_Is_Allowed_And_Decodi
     char json[] = "{\"a\": \t\r\ntrue}";
     void* value1Ptr = &json[9];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1479,7 +1480,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_Before_Comma_In_Object_Is_Allowed
     void* value1Ptr = &json[5];
     void* value2Ptr = &json[18];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1505,7 +1506,7 @@ TEST_FUNCTION(JSONDecoder_Multiple_Whitespaces_After_Comma_In_Object_Is_Allowed_
     void* value1Ptr = &json[5];
     void* value2Ptr = &json[18];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "a", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1528,7 +1529,7 @@ TEST_FUNCTION(JSONDecoder_Nested_Array_Are_Allowed_And_Decoding_Succeeds)
     MULTITREE_HANDLE multiTree;
     char json[] = "[[]]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1547,7 +1548,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Nested_Array_Are_Allowed_And_Decoding_Su
     MULTITREE_HANDLE multiTree;
     char json[] = "[ \t\r\n[]]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1566,7 +1567,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_In_Nested_Array_Are_Allowed_And_Decoding_Succee
     MULTITREE_HANDLE multiTree;
     char json[] = "[[ \t\r\n]]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1585,7 +1586,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Nested_Array_Are_Allowed_And_Decoding_Suc
     MULTITREE_HANDLE multiTree;
     char json[] = "[[ \t\r\n]]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1604,7 +1605,7 @@ TEST_FUNCTION(JSONDecoder_Object_In_Array_Is_Allowed_And_Decoding_Succeeds)
     MULTITREE_HANDLE multiTree;
     char json[] = "[{}]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1623,7 +1624,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Object_In_Array_Are_Allowed_And_Decoding
     MULTITREE_HANDLE multiTree;
     char json[] = "[ \t\r\n{}]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1642,7 +1643,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_In_Object_In_Array_Are_Allowed_And_Decoding_Suc
     MULTITREE_HANDLE multiTree;
     char json[] = "[{ \t\r\n}]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1661,7 +1662,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Object_In_Array_Are_Allowed_And_Decoding_
     MULTITREE_HANDLE multiTree;
     char json[] = "[{} \t\r\n]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
 
@@ -1681,7 +1682,7 @@ TEST_FUNCTION(JSONDecoder_Value_In_Object_In_Array_Are_Allowed_And_Decoding_Succ
     char json[] = "[{\"member1\":\"a\"}]";
     void* value1Ptr = &json[12];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1704,7 +1705,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Member_Name_In_Object_In_Array_Are_Allow
     char json[] = "[{ \r\n\t\"member1\":\"a\"}]";
     void* value1Ptr = &json[16];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1727,7 +1728,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Colon_In_Object_In_Array_Are_Allowed_And
     char json[] = "[{\"member1\" \r\n\t:\"a\"}]";
     void* value1Ptr = &json[16];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1750,7 +1751,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Colon_In_Object_In_Array_Are_Allowed_And_
     char json[] = "[{\"member1\": \r\n\t\"a\"}]";
     void* value1Ptr = &json[16];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1773,7 +1774,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Value_In_Object_In_Array_Are_Allowed_And_
     char json[] = "[{\"member1\":\"a\" \r\n\t}]";
     void* value1Ptr = &json[12];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1797,7 +1798,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Comma_In_Object_In_Array_Are_Allowed_And
     void* value1Ptr = &json[12];
     void* value2Ptr = &json[30];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1824,7 +1825,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Comma_In_Object_In_Array_Are_Allowed_And_
     void* value1Ptr = &json[12];
     void* value2Ptr = &json[30];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "member1", IGNORED_PTR_ARG))
@@ -1850,7 +1851,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Value_In_Array_In_Array_Are_Allowed_And_
     char json[] = "[[ \r\n\t\"a\"]]";
     void* value1Ptr = &json[6];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "0", IGNORED_PTR_ARG))
@@ -1873,7 +1874,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_After_Value_In_Array_In_Array_Are_Allowed_And_D
     char json[] = "[[\"a\" \r\n\t]]";
     void* value1Ptr = &json[2];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "0", IGNORED_PTR_ARG))
@@ -1897,7 +1898,7 @@ TEST_FUNCTION(JSONDecoder_Spaces_Before_Comma_In_Array_In_Array_Are_Allowed_And_
     void* value1Ptr = &json[2];
     void* value2Ptr = &json[10];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestChildHandle1, "0", IGNORED_PTR_ARG))
@@ -1923,7 +1924,7 @@ TEST_FUNCTION(JSONDecoder_Number_Without_Sign_Is_Decoded_Succesfully)
     char json[] = "[1]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1944,7 +1945,7 @@ TEST_FUNCTION(JSONDecoder_Number_Made_Out_Of_Several_Digits_Without_Sign_Is_Deco
     char json[] = "[4242]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1965,7 +1966,7 @@ TEST_FUNCTION(JSONDecoder_Number_With_Minus_Sign_Is_Decoded_Succesfully)
     char json[] = "[-4242]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -1985,7 +1986,7 @@ TEST_FUNCTION(JSONDecoder_Number_With_2_Minus_Sign_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[--4242]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2006,7 +2007,7 @@ TEST_FUNCTION(JSONDecoder_Minus_In_The_Middle_Of_Number_Fails)
     char json[] = "[42-42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2028,7 +2029,7 @@ TEST_FUNCTION(JSONDecoder_Fraction_Part_Without_Integer_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[.1]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2049,7 +2050,7 @@ TEST_FUNCTION(JSONDecoder_No_Fraction_Part_Digits_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[1.]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2071,7 +2072,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_Fraction_Part_Succeeds)
     char json[] = "[1.1]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2094,7 +2095,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_And_Following_Digits_Succeeds)
     char json[] = "[1e1]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2117,7 +2118,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_And_2_Digits_Succeeds)
     char json[] = "[1e42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2140,7 +2141,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_And_Minus_And_2_Digits_Succeeds)
     char json[] = "[1e-42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2163,7 +2164,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_And_Plux_And_2_Digits_Succeeds)
     char json[] = "[1e+42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2186,7 +2187,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_And_Following_Digits_Succeeds)
     char json[] = "[1E1]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2209,7 +2210,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_And_2_Digits_Succeeds)
     char json[] = "[1E42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2232,7 +2233,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_And_Minus_And_2_Digits_Succeeds)
     char json[] = "[1E-42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2255,7 +2256,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_And_Plux_And_2_Digits_Succeeds)
     char json[] = "[1E+42]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2277,7 +2278,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_With_No_Digits_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[1e]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2299,7 +2300,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_With_No_Digits_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[1E]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2321,7 +2322,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_e_Sign_And_With_No_Digits_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[1e-]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2343,7 +2344,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_E_Sign_And_With_No_Digits_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[1E-]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2363,7 +2364,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_A_Leading_Zero_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[01]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2383,7 +2384,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_2_Leading_Zero_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[001]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2404,7 +2405,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_The_Value_0_Succeeds)
     char json[] = "[0]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2425,7 +2426,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_The_Value_101_Succeeds)
     char json[] = "[101]";
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -2445,7 +2446,7 @@ TEST_FUNCTION(JSONDecoder_Integer_With_A_Hex_Number_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[FF]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_Destroy(TestMultiTreeHandle));
@@ -2465,7 +2466,7 @@ TEST_FUNCTION(JSONDecoder_Decoding_falseahbjkfsdhjkfhks_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[falseahbjkfsdhjkfhks]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, IGNORED_PTR_ARG));
@@ -2486,7 +2487,7 @@ TEST_FUNCTION(JSONDecoder_Decoding_falsetrue_Fails)
     MULTITREE_HANDLE multiTree;
     char json[] = "[falsetrue]";
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, IGNORED_PTR_ARG));
@@ -2506,7 +2507,7 @@ void TestSpecialCharacter_Success(char* json)
     MULTITREE_HANDLE multiTree;
     void* value1Ptr = &json[1];
 
-    EXPECTED_CALL(mocks, MultiTree_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(mocks, MultiTree_CreateWithArena(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(mocks, MultiTree_AddChild(TestMultiTreeHandle, "0", IGNORED_PTR_ARG))
         .CopyOutArgumentBuffer(3, &TestChildHandle1, sizeof(TestChildHandle1));
     STRICT_EXPECTED_CALL(mocks, MultiTree_SetValue(TestChildHandle1, value1Ptr));
@@ -10,6 +10,7 @@
 #include "micromock.h"
 #include "micromockcharstararenullterminatedstrings.h"
 #include <stdexcept>
+#include <string>
 #include "multitree.h"
 #include "azure_c_shared_utility/buffer_.h"
 
@@ -6444,4 +6445,243 @@ BEGIN_TEST_SUITE(JSONEncoder_ut)
             ASSERT_ARE_EQUAL(tchar_ptr, _T(""), mocks->CompareActualAndExpectedCalls().c_str());
         }
 
+        /*Tests_SRS_JSON_ENCODER_01_001: [ If destination is NULL, JSONEncoder_BeginObject shall return JSON_ENCODER_INVALID_ARG. ]*/
+        TEST_FUNCTION(JSONEncoder_BeginObject_with_NULL_destination_fails)
+        {
+            ///act
+            auto result = JSONEncoder_BeginObject(NULL);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_INVALID_ARG, result);
+            ASSERT_ARE_EQUAL(tchar_ptr, _T(""), mocks->CompareActualAndExpectedCalls().c_str());
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_002: [ JSONEncoder_BeginObject shall empty destination, keeping any memory it already owns, and then add "{" to it. ]*/
+        /*Tests_SRS_JSON_ENCODER_01_005: [ JSONEncoder_WriteMemberName shall add ", " to destination, unless this is the first member of the object. ]*/
+        /*Tests_SRS_JSON_ENCODER_01_006: [ JSONEncoder_WriteMemberName shall then add the first jsonNameLength characters of jsonName, which are expected to be the quoted name followed by ":". ]*/
+        /*Tests_SRS_JSON_ENCODER_01_009: [ JSONEncoder_WriteInt64 shall add the decimal representation of value to destination, preceded by "-" when value is negative. ]*/
+        /*Tests_SRS_JSON_ENCODER_01_012: [ JSONEncoder_WriteBool shall add "true" or "false" to destination. ]*/
+        /*Tests_SRS_JSON_ENCODER_01_032: [ JSONEncoder_EndObject shall add "}" to destination. ]*/
+        TEST_FUNCTION(JSONEncoder_writes_an_object_with_2_members)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_BeginObject(&buffer));
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteMemberName(&buffer, "\"a\":", 4));
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteInt64(&buffer, -12));
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteMemberName(&buffer, "\"b\":", 4));
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteBool(&buffer, true));
+            auto result = JSONEncoder_EndObject(&buffer);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "{\"a\":-12, \"b\":true}", std::string((const char*)buffer.buffer, buffer.size).c_str());
+            ASSERT_ARE_EQUAL(size_t, 2, buffer.memberCount);
+            ASSERT_ARE_EQUAL(tchar_ptr, _T(""), mocks->CompareActualAndExpectedCalls().c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_002: [ JSONEncoder_BeginObject shall empty destination, keeping any memory it already owns, and then add "{" to it. ]*/
+        TEST_FUNCTION(JSONEncoder_BeginObject_reuses_the_buffer)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+            (void)JSONEncoder_BeginObject(&buffer);
+            (void)JSONEncoder_WriteMemberName(&buffer, "\"a\":", 4);
+            (void)JSONEncoder_WriteBool(&buffer, false);
+            (void)JSONEncoder_EndObject(&buffer);
+            unsigned char* firstBuffer = buffer.buffer;
+
+            ///act
+            auto result = JSONEncoder_BeginObject(&buffer);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(void_ptr, firstBuffer, buffer.buffer);
+            ASSERT_ARE_EQUAL(size_t, 1, buffer.size);
+            ASSERT_ARE_EQUAL(size_t, 0, buffer.memberCount);
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_004: [ If destination or jsonName is NULL, JSONEncoder_WriteMemberName shall return JSON_ENCODER_INVALID_ARG. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteMemberName_with_NULL_jsonName_fails)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteMemberName(&buffer, NULL, 0);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_INVALID_ARG, result);
+            ASSERT_ARE_EQUAL(size_t, 0, buffer.size);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_009: [ JSONEncoder_WriteInt64 shall add the decimal representation of value to destination, preceded by "-" when value is negative. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteInt64_writes_INT64_MIN)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteInt64(&buffer, INT64_MIN);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "-9223372036854775808", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_015: [ JSONEncoder_WriteDouble shall add value to destination as AgentDataTypes_ToString does for EDM_DOUBLE: NaN, -INF, INF or the shortest digits that read back as value. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteDouble_writes_the_shortest_digits)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteDouble(&buffer, 42.5);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "42.5", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_016: [ Values outside of 1e-6 <= |value| < 1e21 shall be written in exponent notation. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteDouble_with_a_large_value_writes_an_exponent)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteDouble(&buffer, 1e300);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "1e300", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_019: [ JSONEncoder_WriteFloat shall add value to destination as AgentDataTypes_ToString does for EDM_SINGLE: NaN, -INF, INF or the shortest digits that read back as value when read as a float. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteFloat_writes_the_shortest_digits)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteFloat(&buffer, 0.1f);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "0.1", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_025: [ JSONEncoder_WriteString shall add value between quotes to destination, writing control characters as \u00XX and '"', '\\' and '/' preceded by '\\'. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteString_escapes_the_value)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteString(&buffer, "a\"b\\c/d\x01");
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "\"a\\\"b\\\\c\\/d\\u0001\"", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_023: [ If value is NULL, JSONEncoder_WriteString shall return JSON_ENCODER_VALUE_NOT_SUPPORTED. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteString_with_NULL_value_is_not_supported)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteString(&buffer, NULL);
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_VALUE_NOT_SUPPORTED, result);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_024: [ If value contains characters above 127, JSONEncoder_WriteString shall return JSON_ENCODER_VALUE_NOT_SUPPORTED. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteString_with_non_ASCII_characters_is_not_supported)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteString(&buffer, "caf\xC3\xA9");
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_VALUE_NOT_SUPPORTED, result);
+            ASSERT_ARE_EQUAL(size_t, 0, buffer.size);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_029: [ JSONEncoder_WriteStringNoQuotes shall add value to destination as it is. ]*/
+        TEST_FUNCTION(JSONEncoder_WriteStringNoQuotes_writes_the_value_as_it_is)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+
+            ///act
+            auto result = JSONEncoder_WriteStringNoQuotes(&buffer, "{\"x\":1}");
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, "{\"x\":1}", std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+        /*Tests_SRS_JSON_ENCODER_01_006: [ JSONEncoder_WriteMemberName shall then add the first jsonNameLength characters of jsonName, which are expected to be the quoted name followed by ":". ]*/
+        TEST_FUNCTION(JSONEncoder_grows_the_buffer_past_its_first_allocation)
+        {
+            ///arrange
+            JSON_ENCODER_BUFFER buffer = { NULL, 0, 0, 0 };
+            std::string expected = "{";
+            (void)JSONEncoder_BeginObject(&buffer);
+
+            ///act
+            for (int i = 0; i < 50; i++)
+            {
+                if (i > 0)
+                {
+                    expected += ", ";
+                }
+                expected += "\"abcdefgh\":";
+                expected += std::to_string(i);
+                ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteMemberName(&buffer, "\"abcdefgh\":", 11));
+                ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, JSONEncoder_WriteInt64(&buffer, i));
+            }
+            auto result = JSONEncoder_EndObject(&buffer);
+            expected += "}";
+
+            ///assert
+            ASSERT_ARE_EQUAL(JSON_ENCODER_RESULT, JSON_ENCODER_OK, result);
+            ASSERT_ARE_EQUAL(char_ptr, expected.c_str(), std::string((const char*)buffer.buffer, buffer.size).c_str());
+
+            ///cleanup
+            free(buffer.buffer);
+        }
+
+
 END_TEST_SUITE(JSONEncoder_ut)
@@ -57,6 +57,17 @@ static void StringFree(void* string)
     gballoc_free(string);
 }
 
+static int NoCloneFunction(void** destination, const void* source)
+{
+    *destination = (void*)source;
+    return 0;
+}
+
+static void NoFreeFunction(void* value)
+{
+    (void)value;
+}
+
 #if defined _MSC_VER
 #define snprintf _snprintf
 #endif
@@ -148,6 +159,7 @@ char bufferTemp2[BUFFER_TEMP_SIZE];
 
 static size_t currentmalloc_call;
 static size_t whenShallmalloc_fail;
+static size_t whenShallmalloc_of_size_fail; /*fails the first malloc of that size, 0 fails none*/
 
 /*different STRING constructors*/
 static size_t currentSTRING_new_call;
@@ -175,7 +187,12 @@ public:
     MOCK_STATIC_METHOD_1(, void*, gballoc_malloc, size_t, size)
         void* result2;
     currentmalloc_call++;
-    if (whenShallmalloc_fail>0)
+    if ((whenShallmalloc_of_size_fail > 0) && (size == whenShallmalloc_of_size_fail))
+    {
+        whenShallmalloc_of_size_fail = 0;
+        result2 = NULL;
+    }
+    else if (whenShallmalloc_fail>0)
     {
         if (currentmalloc_call == whenShallmalloc_fail)
         {
@@ -322,6 +339,7 @@ TEST_FUNCTION_INITIALIZE(init)
     global_bufferTemp = BASEIMPLEMENTATION::STRING_new();
     currentmalloc_call = 0;
     whenShallmalloc_fail = 0;
+    whenShallmalloc_of_size_fail = 0;
 
     currentSTRING_new_call = 0;
     whenShallSTRING_new_fail = 0;
@@ -426,6 +444,149 @@ TEST_FUNCTION(MultiTree_Create_if_malloc_fails_then_it_fails)
     MultiTree_Destroy(res);
 }
 
+/*Tests_SRS_MULTITREE_01_003: [ MultiTree_CreateWithArena shall create a new tree whose nodes, node names, children arrays and child indexes are all allocated from an arena owned by the root of the tree. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_succeeds)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(0))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    auto res = MultiTree_CreateWithArena(StringClone, StringFree);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(res);
+
+    ///cleanup
+    MultiTree_Destroy(res);
+}
+
+/*Tests_SRS_MULTITREE_01_004: [ If any of the arguments passed to MultiTree_CreateWithArena is NULL, the call shall return NULL. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_With_NULL_Clone_Function_Fails)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+
+    ///act
+    auto res = MultiTree_CreateWithArena(NULL, free);
+
+    ///assert
+    ASSERT_IS_NULL(res);
+}
+
+/*Tests_SRS_MULTITREE_01_004: [ If any of the arguments passed to MultiTree_CreateWithArena is NULL, the call shall return NULL. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_With_NULL_Free_Function_Fails)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+
+    ///act
+    auto res = MultiTree_CreateWithArena(StringClone, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(res);
+}
+
+/*Tests_SRS_MULTITREE_01_005: [ MultiTree_CreateWithArena shall return NULL if the tree has not been successfully created. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_if_malloc_fails_then_it_fails)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+
+    whenShallmalloc_fail = 1;
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(0))
+        .IgnoreArgument(1);
+    auto res = MultiTree_CreateWithArena(StringClone, StringFree);
+
+    ///assert
+
+    ASSERT_IS_NULL(res);
+
+    ///cleanup
+    MultiTree_Destroy(res);
+}
+
+/*Tests_SRS_MULTITREE_01_003: [ MultiTree_CreateWithArena shall create a new tree whose nodes, node names, children arrays and child indexes are all allocated from an arena owned by the root of the tree. ]*/
+/*Tests_SRS_MULTITREE_01_006: [ For a tree created by MultiTree_CreateWithArena, MultiTree_Destroy shall free the values of the nodes with freeFunction and, when treeHandle is the root of the tree, free the arena in one go. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_a_small_tree_takes_one_allocation)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    const char* leafValue;
+    MULTITREE_HANDLE childHandle;
+    MULTITREE_RESULT getResult;
+
+    STRICT_EXPECTED_CALL(mocks, gballoc_malloc(0))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    auto treeHandle = MultiTree_CreateWithArena(NoCloneFunction, NoFreeFunction);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD1PATH, CHILD1VALUE);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD2PATH, CHILD2VALUE);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD11PATH, CHILD11VALUE);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD12PATH, CHILD12VALUE);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD311PATH, CHILD311VALUE);
+    (void)MultiTree_AddLeaf(treeHandle, CHILD312PATH, CHILD312VALUE);
+    (void)MultiTree_AddChild(treeHandle, "child4", &childHandle);
+    (void)MultiTree_SetValue(childHandle, (void*)"v4");
+    getResult = MultiTree_GetLeafValue(treeHandle, CHILD312PATH, (const void**)&leafValue);
+
+    ///assert
+    ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, getResult);
+    ASSERT_ARE_EQUAL(char_ptr, CHILD312VALUE, leafValue);
+
+    ///cleanup
+    MultiTree_Destroy(treeHandle);
+}
+
+/*Tests_SRS_MULTITREE_01_003: [ MultiTree_CreateWithArena shall create a new tree whose nodes, node names, children arrays and child indexes are all allocated from an arena owned by the root of the tree. ]*/
+/*Tests_SRS_MULTITREE_01_006: [ For a tree created by MultiTree_CreateWithArena, MultiTree_Destroy shall free the values of the nodes with freeFunction and, when treeHandle is the root of the tree, free the arena in one go. ]*/
+TEST_FUNCTION(MultiTree_CreateWithArena_a_tree_that_outgrows_the_first_block_keeps_all_its_children)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    auto treeHandle = MultiTree_CreateWithArena(StringClone, StringFree);
+    char leafPath[32];
+    char expectedValue[32];
+    size_t i;
+
+    ///act
+    for (i = 0; i < 200; i++)
+    {
+        (void)sprintf(leafPath, "child%u/grandchild", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_AddLeaf(treeHandle, leafPath, expectedValue));
+    }
+
+    ///assert
+    ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_ALREADY_HAS_A_VALUE, MultiTree_AddLeaf(treeHandle, "child199/grandchild", "other"));
+    for (i = 0; i < 200; i++)
+    {
+        const char* leafValue;
+        MULTITREE_HANDLE childHandle;
+        STRING_HANDLE childName = BASEIMPLEMENTATION::STRING_new();
+        (void)sprintf(leafPath, "child%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetChild(treeHandle, i, &childHandle));
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetName(childHandle, childName));
+        ASSERT_ARE_EQUAL(char_ptr, leafPath, BASEIMPLEMENTATION::STRING_c_str(childName));
+        BASEIMPLEMENTATION::STRING_delete(childName);
+
+        (void)sprintf(leafPath, "/child%u/grandchild", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetLeafValue(treeHandle, leafPath, (const void**)&leafValue));
+        ASSERT_ARE_EQUAL(char_ptr, expectedValue, leafValue);
+    }
+
+    ///cleanup
+    MultiTree_Destroy(treeHandle);
+    mocks.ResetAllCalls();
+}
+
 /*Tests_SRS_MULTITREE_99_018:[ If the treeHandle parameter is NULL, MULTITREE_INVALID_ARG shall be returned.]*/
 TEST_FUNCTION(MultiTree_AddLeaf_with_NULL_handle_fails)
 {
@@ -2103,6 +2264,103 @@ TEST_FUNCTION(MultiTree_GetLeafValue_For_A_Child_With_Bad_Leaf_Path_On_First_Lev
     mocks.ResetAllCalls();
 }
 
+/* Tests_SRS_MULTITREE_01_001: [ Nodes with 8 or more children shall index them by name, so that finding a child does not depend on the number of children. ]*/
+/* Tests_SRS_MULTITREE_99_021:[ If the node already has a value assigned to it, MULTITREE_ALREADY_HAS_A_VALUE shall be returned and the existing value shall not be changed.] */
+TEST_FUNCTION(MultiTree_GetLeafValue_With_Many_Children_Finds_All_Of_Them)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    MULTITREE_HANDLE treeHandle = MultiTree_Create(StringClone, StringFree);
+    char leafPath[32];
+    char expectedValue[32];
+    size_t i;
+
+    for (i = 0; i < 50; i++)
+    {
+        (void)sprintf(leafPath, "child%u/grandchild", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_AddLeaf(treeHandle, leafPath, expectedValue));
+    }
+
+    ///act
+    MULTITREE_RESULT result = MultiTree_AddLeaf(treeHandle, "child33/grandchild", "other");
+
+    ///assert
+    ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_ALREADY_HAS_A_VALUE, result);
+    for (i = 0; i < 50; i++)
+    {
+        const char* leafValue;
+        MULTITREE_HANDLE childHandle;
+        (void)sprintf(leafPath, "/child%u/grandchild", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetLeafValue(treeHandle, leafPath, (const void**)&leafValue));
+        ASSERT_ARE_EQUAL(char_ptr, expectedValue, leafValue);
+        (void)sprintf(leafPath, "child%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetChildByName(treeHandle, leafPath, &childHandle));
+    }
+
+    MultiTree_Destroy(treeHandle);
+    mocks.ResetAllCalls();
+}
+
+/* Tests_SRS_MULTITREE_01_001: [ Nodes with 8 or more children shall index them by name, so that finding a child does not depend on the number of children. ]*/
+TEST_FUNCTION(MultiTree_AddLeaf_After_The_Child_Index_Failed_To_Grow_Past_32_Children_Indexes_Every_Child)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    MULTITREE_HANDLE treeHandle = MultiTree_Create(StringClone, StringFree);
+    char leafPath[32];
+    char expectedValue[32];
+    size_t i;
+
+    /*the index grows from 64 to 128 slots when the 33rd child is added, that allocation fails and the 34th child
+    rebuilds it*/
+    whenShallmalloc_of_size_fail = sizeof(size_t) * 128;
+
+    ///act
+    for (i = 0; i < 50; i++)
+    {
+        (void)sprintf(leafPath, "child%u", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_AddLeaf(treeHandle, leafPath, expectedValue));
+    }
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, whenShallmalloc_of_size_fail);
+    for (i = 0; i < 50; i++)
+    {
+        const char* leafValue;
+        (void)sprintf(leafPath, "/child%u", (unsigned int)i);
+        (void)sprintf(expectedValue, "value%u", (unsigned int)i);
+        ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_OK, MultiTree_GetLeafValue(treeHandle, leafPath, (const void**)&leafValue));
+        ASSERT_ARE_EQUAL(char_ptr, expectedValue, leafValue);
+    }
+
+    MultiTree_Destroy(treeHandle);
+    mocks.ResetAllCalls();
+}
+
+/* Tests_SRS_MULTITREE_01_002: [ Each segment of leafPath shall be matched against the whole name of the child. ]*/
+/* Tests_SRS_MULTITREE_99_071:[ When the child node is not found, MultiTree_GetLeafValue shall return MULTITREE_CHILD_NOT_FOUND.] */
+TEST_FUNCTION(MultiTree_GetLeafValue_With_A_Segment_That_Is_Only_A_Prefix_Of_The_Child_Name_Fails)
+{
+    ///arrange
+    CMultiTreeMocks mocks;
+    MULTITREE_HANDLE treeHandle = MultiTree_Create(StringClone, StringFree);
+    const char* leafValue;
+
+    (void)MultiTree_AddLeaf(treeHandle, "child12/child2", "hagauaga");
+
+    ///act
+    MULTITREE_RESULT result = MultiTree_GetLeafValue(treeHandle, "/child1/child2", (const void**)&leafValue);
+
+    ///assert
+    ASSERT_ARE_EQUAL(MULTITREE_RESULT, MULTITREE_CHILD_NOT_FOUND, result);
+
+    MultiTree_Destroy(treeHandle);
+    mocks.ResetAllCalls();
+}
+
 /* Tests_SRS_MULTITREE_99_069:[ If a child name is empty (such as in  '/child1//child12'), MULTITREE_EMPTY_CHILD_NAME shall be returned.] */
 TEST_FUNCTION(MultiTree_GetLeafValue_With_An_Empty_Child_Name_At_Level_1_Fails)
 {
@@ -0,0 +1,638 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#endif
+
+#include "numberformat.h"
+#include "testrunnerswitcher.h"
+
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+BEGIN_TEST_SUITE(numberformat_ut)
+
+TEST_SUITE_INITIALIZE(TestSuiteInitialize)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_001: [ If destination is NULL, NumberFormat_UInt64 shall return 0. ]*/
+TEST_FUNCTION(NumberFormat_UInt64_with_NULL_destination_returns_0)
+{
+    ///arrange
+
+    ///act
+    size_t result = NumberFormat_UInt64(NULL, 42, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_002: [ NumberFormat_UInt64 shall write the decimal digits of value to destination, preceded by as many '0' as needed to have at least minimumDigits digits, then '\0'. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_003: [ NumberFormat_UInt64 shall return the number of characters written, not counting the '\0'. ]*/
+TEST_FUNCTION(NumberFormat_UInt64_writes_UINT64_MAX)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_UInt64(destination, UINT64_MAX, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 20, result);
+    ASSERT_ARE_EQUAL(char_ptr, "18446744073709551615", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_002: [ NumberFormat_UInt64 shall write the decimal digits of value to destination, preceded by as many '0' as needed to have at least minimumDigits digits, then '\0'. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_003: [ NumberFormat_UInt64 shall return the number of characters written, not counting the '\0'. ]*/
+TEST_FUNCTION(NumberFormat_UInt64_pads_with_zeroes_to_minimumDigits)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_UInt64(destination, 42, 5);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 5, result);
+    ASSERT_ARE_EQUAL(char_ptr, "00042", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_002: [ NumberFormat_UInt64 shall write the decimal digits of value to destination, preceded by as many '0' as needed to have at least minimumDigits digits, then '\0'. ]*/
+TEST_FUNCTION(NumberFormat_UInt64_writes_0)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_UInt64(destination, 0, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 1, result);
+    ASSERT_ARE_EQUAL(char_ptr, "0", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_004: [ If destination is NULL, NumberFormat_Int64 shall return 0. ]*/
+TEST_FUNCTION(NumberFormat_Int64_with_NULL_destination_returns_0)
+{
+    ///arrange
+
+    ///act
+    size_t result = NumberFormat_Int64(NULL, -42);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_005: [ NumberFormat_Int64 shall write the decimal representation of value to destination, preceded by "-" when value is negative, then '\0'. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_006: [ NumberFormat_Int64 shall return the number of characters written, not counting the '\0'. ]*/
+TEST_FUNCTION(NumberFormat_Int64_writes_INT64_MIN)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Int64(destination, INT64_MIN);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 20, result);
+    ASSERT_ARE_EQUAL(char_ptr, "-9223372036854775808", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_005: [ NumberFormat_Int64 shall write the decimal representation of value to destination, preceded by "-" when value is negative, then '\0'. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_006: [ NumberFormat_Int64 shall return the number of characters written, not counting the '\0'. ]*/
+TEST_FUNCTION(NumberFormat_Int64_writes_a_positive_value)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_INT64_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Int64(destination, 1234567);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 7, result);
+    ASSERT_ARE_EQUAL(char_ptr, "1234567", destination);
+}
+
+#ifndef NO_FLOATS
+/*Tests_SRS_NUMBER_FORMAT_01_007: [ If destination is NULL, NumberFormat_Double shall return 0. ]*/
+TEST_FUNCTION(NumberFormat_Double_with_NULL_destination_returns_0)
+{
+    ///arrange
+
+    ///act
+    size_t result = NumberFormat_Double(NULL, 1.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_008: [ If value is NaN or an infinity, NumberFormat_Double shall write an empty string to destination and return 0. ]*/
+TEST_FUNCTION(NumberFormat_Double_with_NaN_writes_an_empty_string)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, NAN);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_008: [ If value is NaN or an infinity, NumberFormat_Double shall write an empty string to destination and return 0. ]*/
+TEST_FUNCTION(NumberFormat_Double_with_INFINITY_writes_an_empty_string)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, -INFINITY);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_009: [ NumberFormat_Double shall write to destination, followed by '\0', the shortest decimal digits that read back as value. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+/*Tests_SRS_NUMBER_FORMAT_01_013: [ NumberFormat_Double shall return the number of characters written, not counting the '\0'. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_the_shortest_digits)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 0.1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, result);
+    ASSERT_ARE_EQUAL(char_ptr, "0.1", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_009: [ NumberFormat_Double shall write to destination, followed by '\0', the shortest decimal digits that read back as value. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_17_digits_when_needed)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 1.7976931348623157e308);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 22, result);
+    ASSERT_ARE_EQUAL(char_ptr, "1.7976931348623157e308", destination);
+    ASSERT_ARE_EQUAL(double, 1.7976931348623157e308, strtod(destination, NULL));
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_an_integral_value_with_a_decimal_point)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 3.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, result);
+    ASSERT_ARE_EQUAL(char_ptr, "3.0", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_0)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 0.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, result);
+    ASSERT_ARE_EQUAL(char_ptr, "0.0", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_0_000001_in_fixed_notation)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 0.000001);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 8, result);
+    ASSERT_ARE_EQUAL(char_ptr, "0.000001", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_010: [ When 1e-6 <= |value| < 1e21 or value is 0, the digits shall be written in fixed notation, with at least one digit after the decimal point. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_a_value_just_below_1e21_in_fixed_notation)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 123456789012345680000.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 23, result);
+    ASSERT_ARE_EQUAL(char_ptr, "123456789012345680000.0", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_011: [ Otherwise the digits shall be written as one digit, the other digits after a decimal point (if there are other digits), "e" and the decimal exponent. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_1e21_in_exponent_notation)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 1e21);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 4, result);
+    ASSERT_ARE_EQUAL(char_ptr, "1e21", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_011: [ Otherwise the digits shall be written as one digit, the other digits after a decimal point (if there are other digits), "e" and the decimal exponent. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_1e_minus_7_in_exponent_notation)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 1e-7);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 4, result);
+    ASSERT_ARE_EQUAL(char_ptr, "1e-7", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_011: [ Otherwise the digits shall be written as one digit, the other digits after a decimal point (if there are other digits), "e" and the decimal exponent. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_the_smallest_denormal)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 5e-324);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 6, result);
+    ASSERT_ARE_EQUAL(char_ptr, "5e-324", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_011: [ Otherwise the digits shall be written as one digit, the other digits after a decimal point (if there are other digits), "e" and the decimal exponent. ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_several_digits_in_exponent_notation)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, 1.5e300);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 7, result);
+    ASSERT_ARE_EQUAL(char_ptr, "1.5e300", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_012: [ Negative values (including -0.0) shall be preceded by "-". ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_minus_0)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, -0.0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 4, result);
+    ASSERT_ARE_EQUAL(char_ptr, "-0.0", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_012: [ Negative values (including -0.0) shall be preceded by "-". ]*/
+TEST_FUNCTION(NumberFormat_Double_writes_a_negative_value)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Double(destination, -42.5);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 5, result);
+    ASSERT_ARE_EQUAL(char_ptr, "-42.5", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_014: [ If destination is NULL, NumberFormat_Float shall return 0. ]*/
+TEST_FUNCTION(NumberFormat_Float_with_NULL_destination_returns_0)
+{
+    ///arrange
+
+    ///act
+    size_t result = NumberFormat_Float(NULL, 1.0f);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_015: [ If value is NaN or an infinity, NumberFormat_Float shall write an empty string to destination and return 0. ]*/
+TEST_FUNCTION(NumberFormat_Float_with_INFINITY_writes_an_empty_string)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Float(destination, INFINITY);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_016: [ NumberFormat_Float shall write value as NumberFormat_Double does, using the shortest decimal digits that read back as value when read as a float. ]*/
+TEST_FUNCTION(NumberFormat_Float_writes_the_shortest_digits)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Float(destination, 0.1f);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 3, result);
+    ASSERT_ARE_EQUAL(char_ptr, "0.1", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_016: [ NumberFormat_Float shall write value as NumberFormat_Double does, using the shortest decimal digits that read back as value when read as a float. ]*/
+TEST_FUNCTION(NumberFormat_Float_writes_FLT_MAX)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Float(destination, 3.4028235e38f);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 12, result);
+    ASSERT_ARE_EQUAL(char_ptr, "3.4028235e38", destination);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_016: [ NumberFormat_Float shall write value as NumberFormat_Double does, using the shortest decimal digits that read back as value when read as a float. ]*/
+TEST_FUNCTION(NumberFormat_Float_writes_an_integral_value_with_a_decimal_point)
+{
+    ///arrange
+    char destination[NUMBER_FORMAT_FLOATING_POINT_BUFFER_SIZE];
+
+    ///act
+    size_t result = NumberFormat_Float(destination, 16777216.0f);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 10, result);
+    ASSERT_ARE_EQUAL(char_ptr, "16777216.0", destination);
+}
+#endif
+
+/*Tests_SRS_NUMBER_FORMAT_01_017: [ If source or value is NULL, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_NULL_source_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath(NULL, &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_017: [ If source or value is NULL, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_NULL_value_fails)
+{
+    ///arrange
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("1.5", NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_018: [ If source does not start with [sign] digits ["." digits] [("e" / "E") [sign] digits], NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_a_hexadecimal_number_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("0x10", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_018: [ If source does not start with [sign] digits ["." digits] [("e" / "E") [sign] digits], NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_leading_spaces_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("  1", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_018: [ If source does not start with [sign] digits ["." digits] [("e" / "E") [sign] digits], NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_inf_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("inf", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_019: [ If the number has more than 19 significant digits, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_20_significant_digits_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("12345678901234567890", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_020: [ If the significant digits are more than 2^53 or the decimal exponent is not between -22 and 22, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_more_than_2_pow_53_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("9007199254740993", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_020: [ If the significant digits are more than 2^53 or the decimal exponent is not between -22 and 22, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_exponent_23_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("1e23", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_020: [ If the significant digits are more than 2^53 or the decimal exponent is not between -22 and 22, NumberFormat_ParseDoubleFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_a_huge_exponent_fails)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("1e400", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_021: [ Otherwise NumberFormat_ParseDoubleFastPath shall store in value the double nearest to the number and return 0. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_succeeds)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("-0.25e-3", &value);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(double, strtod("-0.25e-3", NULL), value);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_021: [ Otherwise NumberFormat_ParseDoubleFastPath shall store in value the double nearest to the number and return 0. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_with_exponent_22_succeeds)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("1e22", &value);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(double, 1e22, value);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_021: [ Otherwise NumberFormat_ParseDoubleFastPath shall store in value the double nearest to the number and return 0. ]*/
+TEST_FUNCTION(NumberFormat_ParseDoubleFastPath_ignores_the_characters_after_the_number)
+{
+    ///arrange
+    double value;
+
+    ///act
+    int result = NumberFormat_ParseDoubleFastPath("1.5, 2", &value);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(double, 1.5, value);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_022: [ If source or value is NULL, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseFloatFastPath_with_NULL_source_fails)
+{
+    ///arrange
+    float value;
+
+    ///act
+    int result = NumberFormat_ParseFloatFastPath(NULL, &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_023: [ If source does not start with a number NumberFormat_ParseDoubleFastPath would read, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseFloatFastPath_with_a_sign_only_fails)
+{
+    ///arrange
+    float value;
+
+    ///act
+    int result = NumberFormat_ParseFloatFastPath("-", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_024: [ If the significant digits are more than 2^24 or the decimal exponent is not between -10 and 10, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseFloatFastPath_with_more_than_2_pow_24_fails)
+{
+    ///arrange
+    float value;
+
+    ///act
+    int result = NumberFormat_ParseFloatFastPath("16777217", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_024: [ If the significant digits are more than 2^24 or the decimal exponent is not between -10 and 10, NumberFormat_ParseFloatFastPath shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(NumberFormat_ParseFloatFastPath_with_exponent_11_fails)
+{
+    ///arrange
+    float value;
+
+    ///act
+    int result = NumberFormat_ParseFloatFastPath("1e11", &value);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_NUMBER_FORMAT_01_025: [ Otherwise NumberFormat_ParseFloatFastPath shall store in value the float nearest to the number and return 0. ]*/
+TEST_FUNCTION(NumberFormat_ParseFloatFastPath_succeeds)
+{
+    ///arrange
+    float value;
+
+    ///act
+    int result = NumberFormat_ParseFloatFastPath("3.14159", &value);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(float, strtof("3.14159", NULL), value);
+}
+
+END_TEST_SUITE(numberformat_ut)
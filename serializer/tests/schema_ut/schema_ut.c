@@ -784,6 +784,68 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /* Tests_SRS_SCHEMA_01_001: [ Schema_AddModelProperty shall index the name of the property in the model so that looking it up does not depend on the number of properties and models in model of the model. ]*/
+    /* Tests_SRS_SCHEMA_99_015:[The property name shall be unique per model, if the same property name is added twice to a model, SCHEMA_DUPLICATE_ELEMENT shall be returned.] */
+    TEST_FUNCTION(Schema_AddModelProperty_With_Many_Properties_Finds_All_Of_Them)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        char propertyName[32];
+        size_t i;
+
+        // act
+        for (i = 0; i < 100; i++)
+        {
+            (void)sprintf(propertyName, "Property%zu", i);
+            ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_AddModelProperty(modelType, propertyName, "int"));
+        }
+
+        // assert
+        for (i = 0; i < 100; i++)
+        {
+            SCHEMA_PROPERTY_HANDLE propertyHandle;
+            (void)sprintf(propertyName, "Property%zu", i);
+            propertyHandle = Schema_GetModelPropertyByName(modelType, propertyName);
+            ASSERT_IS_NOT_NULL(propertyHandle);
+            ASSERT_ARE_EQUAL(char_ptr, propertyName, Schema_GetPropertyName(propertyHandle));
+        }
+        ASSERT_IS_NULL(Schema_GetModelPropertyByName(modelType, "Property100"));
+        ASSERT_IS_NULL(Schema_GetModelPropertyByName(modelType, "Property"));
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_DUPLICATE_ELEMENT, Schema_AddModelProperty(modelType, "Property57", "int"));
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
+    /* Tests_SRS_SCHEMA_01_001: [ Schema_AddModelProperty shall index the name of the property in the model so that looking it up does not depend on the number of properties and models in model of the model. ]*/
+    /* Tests_SRS_SCHEMA_99_014:[On any other error, Schema_AddModelProperty shall return SCHEMA_ERROR.] */
+    TEST_FUNCTION(Schema_AddModelProperty_When_The_Name_Index_Cannot_Be_Allocated_Fails)
+    {
+        // arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE modelType = Schema_CreateModelType(schemaHandle, "Model");
+        size_t propertyCount = 444;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument_size()
+            .SetReturn(NULL);
+
+        // act
+        SCHEMA_RESULT result = Schema_AddModelProperty(modelType, "MyName", "SomeType");
+
+        // assert
+        ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Schema_GetModelPropertyCount(modelType, &propertyCount);
+        ASSERT_ARE_EQUAL(size_t, 0, propertyCount);
+        ASSERT_IS_NULL(Schema_GetModelPropertyByName(modelType, "MyName"));
+
+        // cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
     /* Schema_CreateModelAction */
 
     /* Tests_SRS_SCHEMA_99_104: [If any of the modelTypeHandle or actionName arguments is NULL, Schema_CreateModelAction shall return NULL.] */
@@ -3508,6 +3570,39 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /*Tests_SRS_SCHEMA_01_002: [ Schema_AddModelModel shall index propertyName in the model identified by modelTypeHandle so that looking it up does not depend on the number of properties and models in model of the model. ]*/
+    TEST_FUNCTION(Schema_AddModelModel_with_many_models_finds_all_of_them)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE model = Schema_CreateModelType(schemaHandle, "someModel");
+        SCHEMA_MODEL_TYPE_HANDLE minerModel = Schema_CreateModelType(schemaHandle, "someMinerModel");
+        char propertyName[32];
+        size_t i;
+        (void)Schema_AddModelProperty(model, "ManicMiner5", "int"); /*a property with the same name as a model in model is not a model*/
+
+        ///act
+        for (i = 0; i < 40; i++)
+        {
+            (void)sprintf(propertyName, "ManicMiner%zu", i);
+            ASSERT_ARE_EQUAL(SCHEMA_RESULT, SCHEMA_OK, Schema_AddModelModel(model, propertyName, minerModel, i, NULL));
+        }
+
+        ///assert
+        for (i = 0; i < 40; i++)
+        {
+            (void)sprintf(propertyName, "ManicMiner%zu", i);
+            ASSERT_IS_TRUE(Schema_GetModelModelByName(model, propertyName) == minerModel);
+            ASSERT_ARE_EQUAL(size_t, i, Schema_GetModelModelByName_Offset(model, propertyName));
+        }
+        ASSERT_IS_NULL(Schema_GetModelModelByName(model, "ManicMiner40"));
+        ASSERT_IS_NULL(Schema_GetModelModelByName(model, "ManicMiner"));
+        ASSERT_ARE_EQUAL(size_t, 5, Schema_GetModelModelByName_Offset(model, "ManicMiner5"));
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
     /* Schema_ModelPropertyByPathExists */
 
     /* Tests_SRS_SCHEMA_99_180: [If any of the arguments are NULL, Schema_ModelPropertyByPathExists shall return false.] */
@@ -3846,6 +3941,47 @@ BEGIN_TEST_SUITE(Schema_ut)
         Schema_Destroy(schemaHandle);
     }
 
+    /*Tests_SRS_SCHEMA_01_003: [ Schema_ModelPropertyByPathExists, Schema_ModelReportedPropertyByPathExists and Schema_ModelDesiredPropertyByPathExists shall look up each segment of the path in the name index of the model, without scanning the models in model. ]*/
+    TEST_FUNCTION(Schema_ModelPropertyByPathExists_with_many_models_and_properties_finds_the_leaf)
+    {
+        ///arrange
+        SCHEMA_HANDLE schemaHandle = Schema_Create(SCHEMA_NAMESPACE, TEST_SCHEMA_METADATA);
+        SCHEMA_MODEL_TYPE_HANDLE bigModel = Schema_CreateModelType(schemaHandle, "someBigModel");
+        SCHEMA_MODEL_TYPE_HANDLE mediumModel = Schema_CreateModelType(schemaHandle, "someMediumModel");
+        SCHEMA_MODEL_TYPE_HANDLE smallModel = Schema_CreateModelType(schemaHandle, "someSmallModel");
+        char name[32];
+        size_t i;
+        for (i = 0; i < 30; i++)
+        {
+            (void)sprintf(name, "theMediumModel%zu", i);
+            (void)Schema_AddModelModel(bigModel, name, mediumModel, 0, NULL);
+            (void)sprintf(name, "property%zu", i);
+            (void)Schema_AddModelProperty(bigModel, name, "type");
+            (void)Schema_AddModelProperty(mediumModel, name, "type");
+        }
+        (void)Schema_AddModelModel(mediumModel, "theSmallModel", smallModel, 0, NULL);
+        (void)Schema_AddModelProperty(smallModel, "leaf", "type");
+
+        ///act
+        bool result1 = Schema_ModelPropertyByPathExists(bigModel, "/theMediumModel17/theSmallModel/leaf");
+        bool result2 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel29/property29");
+        bool result3 = Schema_ModelPropertyByPathExists(bigModel, "property0");
+        bool result4 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel1/theSmallModel/lea");
+        bool result5 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel/property1");
+        bool result6 = Schema_ModelPropertyByPathExists(bigModel, "theMediumModel30/property1");
+
+        ///assert
+        ASSERT_IS_TRUE(result1);
+        ASSERT_IS_TRUE(result2);
+        ASSERT_IS_TRUE(result3);
+        ASSERT_IS_FALSE(result4);
+        ASSERT_IS_FALSE(result5);
+        ASSERT_IS_FALSE(result6);
+
+        ///cleanup
+        Schema_Destroy(schemaHandle);
+    }
+
     /* Test_SRS_SCHEMA_07_187: [Schema_AddDeviceRef shall return SCHEMA_INVALID_ARG if schemaHandle is NULL.] */
     TEST_FUNCTION(Schema_AddDeviceRef_NULL_SCHEMA_HANDLE_Fail)
     {
@@ -270,6 +270,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         REGISTER_GLOBAL_MOCK_RETURNS(Schema_GetModelByName, TEST_SCHEMA_MODEL_TYPE_HANDLE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_CreateDevice, TEST_DEVICE_HANDLE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_IngestDesiredProperties, CODEFIRST_OK, CODEFIRST_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_IngestDesiredPropertiesInPlace, CODEFIRST_OK, CODEFIRST_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(CodeFirst_ExecuteMethod, TEST_METHODRETURN_HANDLE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(IoTHubClient_SendReportedState, IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(IoTHubClient_LL_SendReportedState, IOTHUB_CLIENT_OK, IOTHUB_CLIENT_ERROR);
@@ -492,43 +493,24 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         umock_c_negative_tests_deinit();
     }
 
-    void serializer_ingest_DEVICE_TWIN_UPDATE_COMPLETE_inert_path(size_t payloadSize)
+    void serializer_ingest_inert_path(size_t payloadSize, bool parseDesiredNode)
     {
         STRICT_EXPECTED_CALL(gballoc_malloc(payloadSize + 1));
-        STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
-            .IgnoreArgument_string();
-        STRICT_EXPECTED_CALL(json_value_get_object(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(json_object_get_object(IGNORED_PTR_ARG, "desired"))
-            .IgnoreArgument_object();
-        STRICT_EXPECTED_CALL(json_object_remove(IGNORED_PTR_ARG, "$version"))
-            .IgnoreArgument_object();
-        STRICT_EXPECTED_CALL(json_object_get_value(IGNORED_PTR_ARG, "desired"))
-            .IgnoreArgument_object();
-        STRICT_EXPECTED_CALL(json_serialize_to_string(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(CodeFirst_IngestDesiredProperties(TEST_SERIALIZER_INGEST_CONTEXT, IGNORED_PTR_ARG))
-            .IgnoreArgument_desiredProperties();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
-        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(CodeFirst_IngestDesiredPropertiesInPlace(TEST_SERIALIZER_INGEST_CONTEXT, IGNORED_PTR_ARG, parseDesiredNode))
+            .IgnoreArgument_jsonPayload();
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
     }
 
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_001: [ serializer_ingest shall clone the payload into a null terminated string. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_002: [ serializer_ingest shall parse the null terminated string into parson data types. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_003: [ If update_state is DEVICE_TWIN_UPDATE_COMPLETE then serializer_ingest shall locate "desired" json name. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_004: [ If "desired" contains "$version" then serializer_ingest shall remove it. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_005: [ The "desired" value shall be outputed to a null terminated string and serializer_ingest shall call CodeFirst_IngestDesiredProperties. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_01_001: [ If update_state is DEVICE_TWIN_UPDATE_COMPLETE then serializer_ingest shall call CodeFirst_IngestDesiredPropertiesInPlace with the clone and parseDesiredNode set to true. ]*/
     TEST_FUNCTION(serializer_ingest_DEVICE_TWIN_UPDATE_COMPLETE_happy_path)
     {
         ///arrange
         unsigned char payload = (unsigned char)'p';
         size_t payloadSize = 1;
 
-        serializer_ingest_DEVICE_TWIN_UPDATE_COMPLETE_inert_path(payloadSize);
+        serializer_ingest_inert_path(payloadSize, true);
 
         ///act
         serializer_ingest(DEVICE_TWIN_UPDATE_COMPLETE, &payload, payloadSize, TEST_SERIALIZER_INGEST_CONTEXT);
@@ -548,7 +530,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
         umock_c_negative_tests_init();
 
-        serializer_ingest_DEVICE_TWIN_UPDATE_COMPLETE_inert_path(payloadSize);
+        serializer_ingest_inert_path(payloadSize, true);
 
         umock_c_negative_tests_snapshot();
 
@@ -558,9 +540,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
             umock_c_negative_tests_fail_call(i);
 
             if (
-                (i != 8) && /*gballoc_free*/
-                (i != 9) && /*json_value_free*/
-                (i != 10)  /*gballoc_free*/
+                (i != 2)  /*gballoc_free*/
                 )
             {
                 /// act
@@ -575,38 +555,15 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
         umock_c_negative_tests_deinit();
     }
 
-    void serializer_ingest_DEVICE_TWIN_UPDATE_PARTIAL_inert_path(size_t payloadSize)
-    {
-        STRICT_EXPECTED_CALL(gballoc_malloc(payloadSize + 1));
-        STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
-            .IgnoreArgument_string();
-        STRICT_EXPECTED_CALL(json_value_get_object(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(json_object_remove(IGNORED_PTR_ARG, "$version"))
-            .IgnoreArgument_object();
-        STRICT_EXPECTED_CALL(json_serialize_to_string(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(CodeFirst_IngestDesiredProperties(TEST_SERIALIZER_INGEST_CONTEXT, IGNORED_PTR_ARG))
-            .IgnoreArgument_desiredProperties();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
-        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
-    }
-
     /*Tests_SRS_SERIALIZERDEVICETWIN_02_001: [ serializer_ingest shall clone the payload into a null terminated string. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_002: [ serializer_ingest shall parse the null terminated string into parson data types. ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_006: [ If update_state is DEVICE_TWIN_UPDATE_PARTIAL then serializer_ingest shall remove "$version" (if it exists). ]*/
-    /*Tests_SRS_SERIALIZERDEVICETWIN_02_007: [ The JSON shall be outputed to a null terminated string and serializer_ingest shall call CodeFirst_IngestDesiredProperties. ]*/
+    /*Tests_SRS_SERIALIZERDEVICETWIN_01_002: [ If update_state is DEVICE_TWIN_UPDATE_PARTIAL then serializer_ingest shall call CodeFirst_IngestDesiredPropertiesInPlace with the clone and parseDesiredNode set to false. ]*/
     TEST_FUNCTION(serializer_ingest_DEVICE_TWIN_UPDATE_PARTIAL_happy_path)
     {
         ///arrange
         unsigned char payload = (unsigned char)'p';
         size_t payloadSize = 1;
 
-        serializer_ingest_DEVICE_TWIN_UPDATE_PARTIAL_inert_path(payloadSize);
+        serializer_ingest_inert_path(payloadSize, false);
 
         ///act
         serializer_ingest(DEVICE_TWIN_UPDATE_PARTIAL, &payload, payloadSize, TEST_SERIALIZER_INGEST_CONTEXT);
@@ -626,7 +583,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
 
         umock_c_negative_tests_init();
 
-        serializer_ingest_DEVICE_TWIN_UPDATE_PARTIAL_inert_path(payloadSize);
+        serializer_ingest_inert_path(payloadSize, false);
 
         umock_c_negative_tests_snapshot();
 
@@ -636,9 +593,7 @@ BEGIN_TEST_SUITE(serializer_dt_ut)
             umock_c_negative_tests_fail_call(i);
 
             if (
-                (i != 8) && /*gballoc_free*/
-                (i != 9) && /*json_value_free*/
-                (i != 10)  /*gballoc_free*/
+                (i != 2)  /*gballoc_free*/
                 )
             {
                 /// act
@@ -0,0 +1,296 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*offline serialization benchmark on the simplesample_mqtt model: SERIALIZE, which now writes flat models with the JSON
+encoders generated by DECLARE_MODEL, is timed against the Device path SERIALIZE used to take for every model (one
+AGENT_DATA_TYPE per value, a transaction, a MultiTree and JSONEncoder_EncodeTree). The Device path is driven through
+the Device API directly, so it does not pay for the device and property lookups of CodeFirst and what it reports is a
+lower bound. Both paths have to produce the same bytes. The result is a single key=value line so that runs can be
+diffed and graphed*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "serializer.h"
+#include "iotdevice.h"
+
+BEGIN_NAMESPACE(WeatherStation);
+
+DECLARE_MODEL(ContosoAnemometer,
+WITH_DATA(ascii_char_ptr, DeviceId),
+WITH_DATA(int, WindSpeed),
+WITH_ACTION(TurnFanOn),
+WITH_ACTION(TurnFanOff),
+WITH_ACTION(SetAirResistance, int, Position)
+);
+
+END_NAMESPACE(WeatherStation);
+
+EXECUTE_COMMAND_RESULT TurnFanOn(ContosoAnemometer* device)
+{
+    (void)device;
+    return EXECUTE_COMMAND_SUCCESS;
+}
+
+EXECUTE_COMMAND_RESULT TurnFanOff(ContosoAnemometer* device)
+{
+    (void)device;
+    return EXECUTE_COMMAND_SUCCESS;
+}
+
+EXECUTE_COMMAND_RESULT SetAirResistance(ContosoAnemometer* device, int Position)
+{
+    (void)device;
+    (void)Position;
+    return EXECUTE_COMMAND_SUCCESS;
+}
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+/*the executable is linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so every allocation made by the
+serializer and by the shared utility library is counted here*/
+static size_t allocationCount;
+
+extern void* __real_malloc(size_t size);
+extern void* __real_calloc(size_t count, size_t size);
+extern void* __real_realloc(void* ptr, size_t size);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    allocationCount++;
+    return __real_realloc(ptr, size);
+}
+
+static size_t get_allocation_count(void)
+{
+    return allocationCount;
+}
+#else
+static size_t get_allocation_count(void)
+{
+    return 0;
+}
+#endif
+
+static uint64_t get_time_ns(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static EXECUTE_COMMAND_RESULT unusedActionCallback(DEVICE_HANDLE deviceHandle, void* callbackUserContext, const char* relativeActionPath, const char* actionName, size_t argCount, const AGENT_DATA_TYPE* args)
+{
+    (void)deviceHandle;
+    (void)callbackUserContext;
+    (void)relativeActionPath;
+    (void)actionName;
+    (void)argCount;
+    (void)args;
+    return EXECUTE_COMMAND_ERROR;
+}
+
+static METHODRETURN_HANDLE unusedMethodCallback(DEVICE_HANDLE deviceHandle, void* callbackUserContext, const char* relativeMethodPath, const char* methodName, size_t argCount, const AGENT_DATA_TYPE* args)
+{
+    (void)deviceHandle;
+    (void)callbackUserContext;
+    (void)relativeMethodPath;
+    (void)methodName;
+    (void)argCount;
+    (void)args;
+    return NULL;
+}
+
+static int serialize_with_codefirst(ContosoAnemometer* myWeather, unsigned char** destination, size_t* destinationSize)
+{
+    return (SERIALIZE(destination, destinationSize, myWeather->DeviceId, myWeather->WindSpeed) == CODEFIRST_OK) ? 0 : 1;
+}
+
+/*what CodeFirst_SendAsync does for models without generated JSON encoders*/
+static int serialize_with_device(DEVICE_HANDLE deviceHandle, ContosoAnemometer* myWeather, unsigned char** destination, size_t* destinationSize)
+{
+    int result;
+    TRANSACTION_HANDLE transaction = Device_StartTransaction(deviceHandle);
+    if (transaction == NULL)
+    {
+        result = 1;
+    }
+    else
+    {
+        AGENT_DATA_TYPE deviceId;
+        AGENT_DATA_TYPE windSpeed;
+        if (Create_AGENT_DATA_TYPE_from_charz(&deviceId, myWeather->DeviceId) != AGENT_DATA_TYPES_OK)
+        {
+            (void)Device_CancelTransaction(transaction);
+            result = 1;
+        }
+        else
+        {
+            if (Create_AGENT_DATA_TYPE_from_SINT32(&windSpeed, myWeather->WindSpeed) != AGENT_DATA_TYPES_OK)
+            {
+                (void)Device_CancelTransaction(transaction);
+                result = 1;
+            }
+            else
+            {
+                if ((Device_PublishTransacted(transaction, "DeviceId", &deviceId) != DEVICE_OK) ||
+                    (Device_PublishTransacted(transaction, "WindSpeed", &windSpeed) != DEVICE_OK))
+                {
+                    (void)Device_CancelTransaction(transaction);
+                    result = 1;
+                }
+                else
+                {
+                    result = (Device_EndTransaction(transaction, destination, destinationSize) == DEVICE_OK) ? 0 : 1;
+                }
+                Destroy_AGENT_DATA_TYPE(&windSpeed);
+            }
+            Destroy_AGENT_DATA_TYPE(&deviceId);
+        }
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t messages = 100000;
+
+    if ((argc == 3) && (strcmp(argv[1], "--messages") == 0))
+    {
+        messages = (size_t)strtoul(argv[2], NULL, 10);
+    }
+
+    if ((argc != 1) && (argc != 3))
+    {
+        (void)printf("usage: %s [--messages N]\n", argv[0]);
+        result = 1;
+    }
+    else if (serializer_init(NULL) != SERIALIZER_OK)
+    {
+        (void)printf("serializer_init failed\n");
+        result = 1;
+    }
+    else
+    {
+        ContosoAnemometer* myWeather = CREATE_MODEL_INSTANCE(WeatherStation, ContosoAnemometer);
+        DEVICE_HANDLE deviceHandle = NULL;
+        if (myWeather == NULL)
+        {
+            (void)printf("CREATE_MODEL_INSTANCE failed\n");
+            result = 1;
+        }
+        else if (Device_Create(GET_MODEL_HANDLE(WeatherStation, ContosoAnemometer), unusedActionCallback, NULL, unusedMethodCallback, myWeather, false, &deviceHandle) != DEVICE_OK)
+        {
+            (void)printf("Device_Create failed\n");
+            result = 1;
+        }
+        else
+        {
+            unsigned char* codeFirstJSON = NULL;
+            size_t codeFirstJSONSize = 0;
+            unsigned char* deviceJSON = NULL;
+            size_t deviceJSONSize = 0;
+
+            myWeather->DeviceId = "myFirstDevice";
+            myWeather->WindSpeed = 12;
+
+            if ((serialize_with_codefirst(myWeather, &codeFirstJSON, &codeFirstJSONSize) != 0) ||
+                (serialize_with_device(deviceHandle, myWeather, &deviceJSON, &deviceJSONSize) != 0))
+            {
+                (void)printf("unable to serialize\n");
+                result = 1;
+            }
+            else if ((codeFirstJSONSize != deviceJSONSize) || (memcmp(codeFirstJSON, deviceJSON, codeFirstJSONSize) != 0))
+            {
+                (void)printf("SERIALIZE produced %.*s, Device produced %.*s\n", (int)codeFirstJSONSize, (const char*)codeFirstJSON, (int)deviceJSONSize, (const char*)deviceJSON);
+                result = 1;
+            }
+            else
+            {
+                uint64_t codeFirstTime;
+                size_t codeFirstAllocations;
+                uint64_t deviceTime;
+                size_t deviceAllocations;
+                uint64_t start;
+                size_t startAllocations;
+                size_t i;
+
+                result = 0;
+
+                start = get_time_ns();
+                startAllocations = get_allocation_count();
+                for (i = 0; (result == 0) && (i < messages); i++)
+                {
+                    unsigned char* destination;
+                    size_t destinationSize;
+                    myWeather->WindSpeed = (int)(i % 20);
+                    result = serialize_with_codefirst(myWeather, &destination, &destinationSize);
+                    if (result == 0)
+                    {
+                        free(destination);
+                    }
+                }
+                codeFirstTime = get_time_ns() - start;
+                codeFirstAllocations = get_allocation_count() - startAllocations;
+
+                start = get_time_ns();
+                startAllocations = get_allocation_count();
+                for (i = 0; (result == 0) && (i < messages); i++)
+                {
+                    unsigned char* destination;
+                    size_t destinationSize;
+                    myWeather->WindSpeed = (int)(i % 20);
+                    result = serialize_with_device(deviceHandle, myWeather, &destination, &destinationSize);
+                    if (result == 0)
+                    {
+                        free(destination);
+                    }
+                }
+                deviceTime = get_time_ns() - start;
+                deviceAllocations = get_allocation_count() - startAllocations;
+
+                if (result != 0)
+                {
+                    (void)printf("unable to serialize\n");
+                }
+                else if (messages != 0)
+                {
+                    (void)printf("model=ContosoAnemometer messages=%lu bytes=%lu serialize_ns_per_msg=%lu serialize_allocs_per_msg=%.1f device_ns_per_msg=%lu device_allocs_per_msg=%.1f\n",
+                        (unsigned long)messages, (unsigned long)codeFirstJSONSize,
+                        (unsigned long)(codeFirstTime / messages), (double)codeFirstAllocations / (double)messages,
+                        (unsigned long)(deviceTime / messages), (double)deviceAllocations / (double)messages);
+                }
+            }
+
+            free(codeFirstJSON);
+            free(deviceJSON);
+            Device_Destroy(deviceHandle);
+        }
+
+        if (myWeather != NULL)
+        {
+            DESTROY_MODEL_INSTANCE(myWeather);
+        }
+        serializer_deinit();
+    }
+
+    return result;
+}